@@ -29,10 +29,45 @@ int main() {
     core::Config cfg;
     cfg.load_from_file("server.conf");
 
+    // I/O 后端：需在创建 Service（及其 EventLoop 线程池）之前设置；io_uring 不可用时自动回退 epoll
+    net::set_default_io_backend(net::parse_io_backend(
+        cfg.get_string("io_backend", net::io_backend_name(net::default_io_backend())).c_str()));
+
     // 创建一个 Service（内部包含 TcpServer + ThreadPool）
     service::Service svc(static_cast<unsigned short>(cfg.listen_port()),
                          static_cast<std::size_t>(cfg.worker_threads()));
 
+    // 监听参数：backlog / SO_REUSEPORT 分片 / 批量 accept / 输出缓冲背压
+    net::TcpServerConfig listen_cfg;
+    listen_cfg.backlog = cfg.get_int("listen_backlog", listen_cfg.backlog);
+    listen_cfg.reuse_port = cfg.get_int("reuse_port", 0) != 0;
+    listen_cfg.accept_batch = cfg.get_int("accept_batch", listen_cfg.accept_batch);
+    net::BackpressureConfig& bp = listen_cfg.backpressure;
+    bp.high_watermark = static_cast<std::size_t>(
+        cfg.get_int("output_high_watermark", static_cast<int>(bp.high_watermark)));
+    bp.low_watermark = static_cast<std::size_t>(
+        cfg.get_int("output_low_watermark", static_cast<int>(bp.low_watermark)));
+    bp.max_output_bytes = static_cast<std::size_t>(
+        cfg.get_int("output_max_bytes", static_cast<int>(bp.max_output_bytes)));
+    bp.max_stall_ms = cfg.get_int("output_max_stall_ms", bp.max_stall_ms);
+
+    // TLS：配置了证书与私钥时所有连接在 I/O 线程内以非阻塞 TLS 收发，重连按会话票据 / 缓存恢复
+    const std::string tls_cert = cfg.get_string("tls_cert_file", "");
+    const std::string tls_key = cfg.get_string("tls_key_file", "");
+    if (!tls_cert.empty() && !tls_key.empty()) {
+        net::TlsSessionConfig sessions;
+        sessions.cache_size = static_cast<std::size_t>(
+            cfg.get_int("tls_session_cache_size", static_cast<int>(sessions.cache_size)));
+        sessions.timeout_sec = cfg.get_int("tls_session_timeout_sec", static_cast<int>(sessions.timeout_sec));
+        auto tls = std::make_shared<net::TlsContext>();
+        if (tls->init_server(tls_cert, tls_key, sessions)) {
+            listen_cfg.tls = tls;
+        } else {
+            CHWELL_LOG_ERROR("TLS disabled: failed to load " + tls_cert + " / " + tls_key);
+        }
+    }
+    svc.tcp_server().set_config(listen_cfg);
+
     // 注册 Echo 组件：下游可以按类似方式注册各种业务组件
     svc.add_component<EchoComponent>();
 
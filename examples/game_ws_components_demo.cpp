@@ -51,7 +51,7 @@ int main(int argc, char* argv[]) {
     net::WsServer ws_server(io_service, port);
 
     // 设置消息回调
-    ws_server.set_message_callback([&](const net::WsConnectionPtr& conn, const std::string& message) {
+    ws_server.set_message_callback([&](const net::WsConnectionPtr& conn, std::string_view message) {
         // 将 WebSocket 消息转换为协议消息
         // 假设消息格式：[cmd(2 bytes)][len(2 bytes)][body]
         if (message.size() < 4) {
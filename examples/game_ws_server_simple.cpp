@@ -13,7 +13,8 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <poll.h>
-#include <openssl/sha.h>
+
+#include "ws_blocking.h"
 
 using namespace std;
 
@@ -21,138 +22,11 @@ using namespace std;
 // WebSocket 协议实现
 // ============================================
 
-static const char* WS_MAGIC = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
-
-std::string base64_encode(const unsigned char* data, size_t len) {
-  static const char* b64 = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-  std::string out;
-  out.reserve((len + 2) / 3 * 4);
-
-  for (size_t i = 0; i < len; i += 3) {
-    unsigned char c0 = data[i];
-    unsigned char c1 = (i + 1 < len) ? data[i + 1] : 0;
-    unsigned char c2 = (i + 2 < len) ? data[i + 2] : 0;
-
-    out.push_back(b64[c0 >> 2]);
-    out.push_back(b64[((c0 & 0x03) << 4) | (c1 >> 4)]);
-    out.push_back(b64[((c1 & 0x0F) << 2) | (c2 >> 6)]);
-    out.push_back(b64[c2 & 0x3F]);
-  }
-
-  while (out.size() % 4) {
-    out.push_back('=');
-  }
-
-  return out;
-}
-
-std::string ws_accept_key(const std::string& key) {
-  std::string s = key + WS_MAGIC;
-  unsigned char hash[SHA_DIGEST_LENGTH];
-  SHA1(reinterpret_cast<const unsigned char*>(s.data()), s.size(), hash);
-  return base64_encode(hash, SHA_DIGEST_LENGTH);
-}
-
-bool do_ws_handshake(int client_fd, std::string& key_out) {
-  char buf[4096];
-  ssize_t n = recv(client_fd, buf, sizeof(buf) - 1, 0);
-  if (n <= 0) return false;
-  buf[n] = '\0';
-  std::string headers(buf);
-  key_out.clear();
-
-  size_t pos = 0;
-  for (;;) {
-    size_t end = headers.find("\r\n", pos);
-    if (end == std::string::npos) break;
-    std::string line = headers.substr(pos, end - pos);
-    pos = end + 2;
-    if (line.empty()) break;
-
-    if (line.find("Sec-WebSocket-Key:") == 0) {
-      size_t start = line.find(':') + 1;
-      while (start < line.size() && line[start] == ' ') start++;
-      key_out = line.substr(start);
-      while (!key_out.empty() && key_out.back() == '\r') key_out.pop_back();
-      break;
-    }
-  }
-
-  if (key_out.empty()) return false;
-
-  std::string accept = ws_accept_key(key_out);
-  std::string response =
-    "HTTP/1.1 101 Switching Protocols\r\n"
-    "Upgrade: websocket\r\n"
-    "Connection: Upgrade\r\n"
-    "Sec-WebSocket-Accept: " + accept + "\r\n\r\n";
-
-  ssize_t sent = send(client_fd, response.data(), response.size(), MSG_NOSIGNAL);
-  return sent == static_cast<ssize_t>(response.size());
-}
-
-// 从 WebSocket 帧读取 payload（文本）
-bool ws_read_text_frame(int fd, std::string& out) {
-  unsigned char hdr[2];
-  if (recv(fd, hdr, 2, MSG_WAITALL) != 2) return false;
-
-  unsigned char op = hdr[0] & 0x0f;
-  bool mask = (hdr[1] & 0x80) != 0;
-  uint64_t payload_len = hdr[1] & 0x7f;
-
-  if (payload_len == 126) {
-    unsigned char ext[2];
-    if (recv(fd, ext, 2, MSG_WAITALL) != 2) return false;
-    payload_len = (static_cast<uint64_t>(ext[0]) << 8) | ext[1];
-  } else if (payload_len == 127) {
-    unsigned char ext[8];
-    if (recv(fd, ext, 8, MSG_WAITALL) != 8) return false;
-    payload_len = 0;
-    for (int i = 0; i < 8; i++) payload_len = (payload_len << 8) | ext[i];
-  }
-
-  if (op == 8) return false; // close
-  if (payload_len > 4 * 1024 * 1024) return false; // 限制最大消息大小
-
-  unsigned char mask_key[4];
-  if (mask) {
-    if (recv(fd, mask_key, 4, MSG_WAITALL) != 4) return false;
-  }
-
-  out.resize(payload_len);
-  if (payload_len == 0) return true;
-
-  ssize_t got = recv(fd, out.data(), out.size(), MSG_WAITALL);
-  if (got != static_cast<ssize_t>(payload_len)) return false;
-
-  if (mask) {
-    for (size_t i = 0; i < out.size(); i++)
-      out[i] = out[i] ^ mask_key[i % 4];
-  }
-
-  return true;
-}
+// 握手、解帧（分片 / ping / close）与掩码由 chwell_core 的 ws_codec 完成，见 ws_blocking.h
 
 // 发送 WebSocket 文本帧
 bool ws_write_text_frame(int fd, const char* data, size_t len) {
-  std::vector<unsigned char> frame;
-  frame.push_back(0x81); // FIN + text
-
-  if (len < 126) {
-    frame.push_back(static_cast<unsigned char>(len));
-  } else if (len <= 65535) {
-    frame.push_back(126);
-    frame.push_back(static_cast<unsigned char>(len >> 8));
-    frame.push_back(static_cast<unsigned char>(len & 0xff));
-  } else {
-    frame.push_back(127);
-    for (int i = 7; i >= 0; i--)
-      frame.push_back(static_cast<unsigned char>((len >> (i * 8)) & 0xff));
-  }
-
-  frame.insert(frame.end(), data, data + len);
-  ssize_t sent = send(fd, frame.data(), frame.size(), MSG_NOSIGNAL);
-  return sent == static_cast<ssize_t>(frame.size());
+  return ws_blocking::write_frame(fd, ws_blocking::WsOpcode::kText, data, len);
 }
 
 // ============================================
@@ -220,17 +94,7 @@ private:
 
       std::cout << "New client connected: fd=" << client_fd << std::endl;
 
-      // WebSocket 握手
-      std::string key;
-      if (!do_ws_handshake(client_fd, key)) {
-        std::cerr << "WebSocket handshake failed" << std::endl;
-        close(client_fd);
-        continue;
-      }
-
-      std::cout << "WebSocket handshake successful" << std::endl;
-
-      // 创建客户端线程
+      // 创建客户端线程（握手在客户端线程内完成，不阻塞 accept）
       std::thread([this, client_fd]() {
         client_loop(client_fd);
       }).detach();
@@ -238,9 +102,17 @@ private:
   }
 
   void client_loop(int client_fd) {
+    ws_blocking::Peer peer(client_fd);
+    if (!peer.handshake()) {
+      std::cerr << "WebSocket handshake failed" << std::endl;
+      close(client_fd);
+      return;
+    }
+    std::cout << "WebSocket handshake successful" << std::endl;
+
     while (running_) {
       std::string payload;
-      if (!ws_read_text_frame(client_fd, payload)) {
+      if (!peer.read_message(&payload)) {
         std::cout << "Client disconnected: fd=" << client_fd << std::endl;
         on_disconnect(client_fd);
         close(client_fd);
@@ -264,7 +136,7 @@ private:
   void handleLogin(int client_fd, const std::string& payload) {
     // 简单解析 player_id（查找最后一个引号内的内容）
     size_t start = payload.find(": \"") + 3;
-    size_t end = payload.find("\", start);
+    size_t end = payload.find('"', start);
     if (start == std::string::npos || end == std::string::npos) {
       std::cerr << "Failed to parse playerId" << std::endl;
       return;
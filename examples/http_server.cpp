@@ -19,6 +19,20 @@ int main() {
 
     http::HttpServer server(io_service, 8080);
 
+    http::HttpServerConfig http_cfg;
+    http_cfg.keep_alive = cfg.get_int("http_keep_alive", 1) != 0;
+    http_cfg.max_requests_per_connection =
+        static_cast<std::size_t>(cfg.get_int("http_max_requests_per_connection", 0));
+    http_cfg.limits.max_body_size =
+        static_cast<std::size_t>(cfg.get_int("http_max_body_size", 1024 * 1024));
+    server.set_config(http_cfg);
+
+    // H5 客户端资源：/h5/ 下的请求走静态文件缓存（sendfile、gzip、ETag、Range）
+    http::StaticFileConfig static_cfg;
+    static_cfg.root = cfg.get_string("http_static_root", "../examples/h5_game");
+    static_cfg.url_prefix = "/h5/";
+    server.mount_static(static_cfg);
+
     server.set_handler([](const http::HttpRequest& req, http::HttpResponse& resp) {
         CHWELL_LOG_INFO("HTTP " + req.method + " " + req.path);
 
@@ -28,8 +28,7 @@ public:
     virtual void on_message(const net::TcpConnectionPtr& conn,
                             std::string_view data) override {
         auto& codec = codecs_[conn.get()];
-        std::vector<char> chunk(data.begin(), data.end());
-        std::vector<std::string> messages = codec.decode(chunk);
+        std::vector<std::string> messages = codec.decode(data);
 
         for (const auto& bin : messages) {
             std::string text(bin.begin(), bin.end());
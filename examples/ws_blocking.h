@@ -0,0 +1,124 @@
+#pragma once
+
+// 阻塞式 WebSocket 示例共用的收发辅助（每连接一个线程的简单服务端）。
+// 握手、解帧、掩码均由 chwell_core 的 ws_codec 完成，这里只负责阻塞 socket 读写。
+
+#include <cerrno>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "chwell/net/ws_codec.h"
+
+namespace ws_blocking {
+
+using chwell::net::WsOpcode;
+
+// 帧头原地构造后与载荷以一次 sendmsg 写出，载荷不拷贝
+inline bool write_all(int fd, iovec* iov, int cnt) {
+    while (cnt > 0) {
+        msghdr msg = {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = static_cast<std::size_t>(cnt);
+        ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        std::size_t left = static_cast<std::size_t>(n);
+        while (cnt > 0 && left >= iov->iov_len) {
+            left -= iov->iov_len;
+            ++iov;
+            --cnt;
+        }
+        if (cnt > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+            iov->iov_len -= left;
+        }
+    }
+    return true;
+}
+
+inline bool write_frame(int fd, WsOpcode opcode, const char* data, std::size_t len) {
+    char header[chwell::net::kWsMaxHeaderSize];
+    iovec iov[2];
+    iov[0].iov_base = header;
+    iov[0].iov_len = chwell::net::ws_encode_header(header, opcode, len);
+    iov[1].iov_base = const_cast<char*>(data);
+    iov[1].iov_len = len;
+    return write_all(fd, iov, len > 0 ? 2 : 1);
+}
+
+// 单个客户端连接的读端：握手 + 增量解帧，ping 自动回 pong，收到 close 回显后结束
+class Peer {
+public:
+    explicit Peer(int fd) : fd_(fd) {}
+
+    int fd() const { return fd_; }
+
+    // 读取升级请求并回复 101；失败时回复 400
+    bool handshake() {
+        std::string request;
+        char buf[4096];
+        for (;;) {
+            ssize_t n = recv(fd_, buf, sizeof(buf), 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            request.append(buf, static_cast<std::size_t>(n));
+            chwell::net::WsHandshakeRequest req;
+            long consumed = chwell::net::parse_ws_handshake(request, &req);
+            if (consumed == 0) continue;
+            std::string response = consumed < 0 ? chwell::net::ws_handshake_reject()
+                                                 : chwell::net::ws_handshake_response(req);
+            iovec iov;
+            iov.iov_base = &response[0];
+            iov.iov_len = response.size();
+            if (!write_all(fd_, &iov, 1) || consumed < 0) return false;
+            // 请求头之后已到达的帧数据留给 read_message
+            return feed(std::string_view(request).substr(static_cast<std::size_t>(consumed)));
+        }
+    }
+
+    // 读取一条完整的文本 / 二进制消息；连接关闭或协议错误时返回 false
+    bool read_message(std::string* out, WsOpcode* opcode = nullptr) {
+        char buf[16 * 1024];
+        while (messages_.empty()) {
+            if (closed_) return false;
+            ssize_t n = recv(fd_, buf, sizeof(buf), 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            if (!feed(std::string_view(buf, static_cast<std::size_t>(n)))) return false;
+        }
+        if (opcode) *opcode = messages_.front().first;
+        *out = std::move(messages_.front().second);
+        messages_.pop_front();
+        return true;
+    }
+
+private:
+    bool feed(std::string_view data) {
+        bool ok = decoder_.feed(data, [this](WsOpcode op, std::string_view payload) {
+            if (op == WsOpcode::kText || op == WsOpcode::kBinary) {
+                messages_.emplace_back(op, std::string(payload));
+            } else if (op == WsOpcode::kPing) {
+                write_frame(fd_, WsOpcode::kPong, payload.data(), payload.size());
+            } else if (op == WsOpcode::kClose && !closed_) {
+                closed_ = true;
+                write_frame(fd_, WsOpcode::kClose, payload.data(), payload.size() >= 2 ? 2 : 0);
+            }
+        });
+        if (!ok) {
+            std::string close = chwell::net::ws_close_payload(decoder_.close_code());
+            write_frame(fd_, WsOpcode::kClose, close.data(), close.size());
+        }
+        return ok;
+    }
+
+    int fd_;
+    bool closed_{false};
+    chwell::net::WsDecoder decoder_;
+    std::deque<std::pair<WsOpcode, std::string>> messages_;
+};
+
+} // namespace ws_blocking
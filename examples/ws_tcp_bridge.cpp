@@ -1,5 +1,5 @@
 // WebSocket <-> TCP 桥接：浏览器通过 WS 连接本服务，本服务将数据转发到游戏网关 TCP。
-// 需 OpenSSL（libssl）用于 WebSocket 握手的 SHA1。
+// WebSocket 握手与帧编解码使用 chwell_core 的 ws_codec（见 ws_blocking.h）。
 
 #include <cstdlib>
 #include <csignal>
@@ -17,14 +17,10 @@
 #include <arpa/inet.h>
 #include <poll.h>
 
-#include <openssl/sha.h>
-#include <openssl/evp.h>
-#include <openssl/bio.h>
-#include <openssl/buffer.h>
+#include "ws_blocking.h"
 
 namespace {
 
-static const char* WS_MAGIC = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
 static const int WS_PORT = 9080;
 // 网关地址：可通过环境变量 GATEWAY_HOST、GATEWAY_PORT 覆盖，便于前后端分离部署
 static std::string gateway_host() {
@@ -37,114 +33,6 @@ static int gateway_port() {
     return 9001;
 }
 
-std::string base64_encode(const unsigned char* data, size_t len) {
-    BIO* b64 = BIO_new(BIO_f_base64());
-    BIO* mem = BIO_new(BIO_s_mem());
-    BIO_set_flags(b64, BIO_FLAGS_BASE64_NO_NL);
-    BIO_push(b64, mem);
-    BIO_write(b64, data, static_cast<int>(len));
-    BIO_flush(b64);
-    BUF_MEM* ptr;
-    BIO_get_mem_ptr(b64, &ptr);
-    std::string out(ptr->data, ptr->length);
-    BIO_free_all(b64);
-    return out;
-}
-
-std::string ws_accept_key(const std::string& key) {
-    std::string s = key + WS_MAGIC;
-    unsigned char hash[SHA_DIGEST_LENGTH];
-    SHA1(reinterpret_cast<const unsigned char*>(s.data()), s.size(), hash);
-    return base64_encode(hash, SHA_DIGEST_LENGTH);
-}
-
-bool do_ws_handshake(int client_fd, std::string& key_out) {
-    char buf[4096];
-    ssize_t n = recv(client_fd, buf, sizeof(buf) - 1, 0);
-    if (n <= 0) return false;
-    buf[n] = '\0';
-    std::string headers(buf);
-    key_out.clear();
-    size_t pos = 0;
-    for (;;) {
-        size_t end = headers.find("\r\n", pos);
-        if (end == std::string::npos) break;
-        std::string line = headers.substr(pos, end - pos);
-        pos = end + 2;
-        if (line.empty()) break;
-        if (line.find("Sec-WebSocket-Key:") == 0) {
-            size_t start = line.find(':') + 1;
-            while (start < line.size() && line[start] == ' ') start++;
-            key_out = line.substr(start);
-            while (!key_out.empty() && key_out.back() == '\r') key_out.pop_back();
-            break;
-        }
-    }
-    if (key_out.empty()) return false;
-    std::string accept = ws_accept_key(key_out);
-    std::string response =
-        "HTTP/1.1 101 Switching Protocols\r\n"
-        "Upgrade: websocket\r\n"
-        "Connection: Upgrade\r\n"
-        "Sec-WebSocket-Accept: " + accept + "\r\n\r\n";
-    ssize_t sent = send(client_fd, response.data(), response.size(), MSG_NOSIGNAL);
-    return sent == static_cast<ssize_t>(response.size());
-}
-
-// 从 WebSocket 帧读取 payload（单帧，二进制）
-bool ws_read_frame(int fd, std::vector<char>& out) {
-    unsigned char hdr[2];
-    if (recv(fd, hdr, 2, MSG_WAITALL) != 2) return false;
-    unsigned char op = hdr[0] & 0x0f;
-    bool mask = (hdr[1] & 0x80) != 0;
-    uint64_t payload_len = hdr[1] & 0x7f;
-    if (payload_len == 126) {
-        unsigned char ext[2];
-        if (recv(fd, ext, 2, MSG_WAITALL) != 2) return false;
-        payload_len = (static_cast<uint64_t>(ext[0]) << 8) | ext[1];
-    } else if (payload_len == 127) {
-        unsigned char ext[8];
-        if (recv(fd, ext, 8, MSG_WAITALL) != 8) return false;
-        payload_len = 0;
-        for (int i = 0; i < 8; i++) payload_len = (payload_len << 8) | ext[i];
-    }
-    if (op == 8) return false; // close
-    if (payload_len > 4 * 1024 * 1024) return false;
-    unsigned char mask_key[4];
-    if (mask) {
-        if (recv(fd, mask_key, 4, MSG_WAITALL) != 4) return false;
-    }
-    out.resize(static_cast<size_t>(payload_len));
-    if (payload_len == 0) return true;
-    ssize_t got = recv(fd, out.data(), out.size(), MSG_WAITALL);
-    if (got != static_cast<ssize_t>(payload_len)) return false;
-    if (mask) {
-        for (size_t i = 0; i < out.size(); i++)
-            out[i] = out[i] ^ mask_key[i % 4];
-    }
-    return true;
-}
-
-// 发送 WebSocket 二进制帧
-bool ws_write_frame(int fd, const char* data, size_t len) {
-    std::vector<unsigned char> frame;
-    frame.push_back(0x82); // binary
-    if (len < 126) {
-        frame.push_back(static_cast<unsigned char>(len));
-    } else if (len <= 65535) {
-        frame.push_back(126);
-        frame.push_back(static_cast<unsigned char>(len >> 8));
-        frame.push_back(static_cast<unsigned char>(len & 0xff));
-    } else {
-        frame.push_back(127);
-        for (int i = 7; i >= 0; i--)
-            frame.push_back(static_cast<unsigned char>((len >> (i * 8)) & 0xff));
-    }
-    frame.insert(frame.end(), data, data + len);
-    ssize_t sent = send(fd, frame.data(), frame.size(), MSG_NOSIGNAL);
-    return sent == static_cast<ssize_t>(frame.size());
-}
-
 int connect_to_gateway() {
     std::string host = gateway_host();
     int port = gateway_port();
@@ -165,8 +53,8 @@ int connect_to_gateway() {
 }
 
 void bridge_loop(int client_fd) {
-    std::string key;
-    if (!do_ws_handshake(client_fd, key)) {
+    ws_blocking::Peer peer(client_fd);
+    if (!peer.handshake()) {
         close(client_fd);
         return;
     }
@@ -178,9 +66,9 @@ void bridge_loop(int client_fd) {
     }
     std::atomic<bool> done{false};
     auto ws_to_tcp = [&]() {
-        std::vector<char> buf;
+        std::string buf;
         while (!done) {
-            if (!ws_read_frame(client_fd, buf)) break;
+            if (!peer.read_message(&buf)) break;
             if (buf.empty()) continue;
             ssize_t n = send(gate_fd, buf.data(), buf.size(), MSG_NOSIGNAL);
             if (n != static_cast<ssize_t>(buf.size())) break;
@@ -194,7 +82,8 @@ void bridge_loop(int client_fd) {
         while (!done) {
             ssize_t n = recv(gate_fd, buf, sizeof(buf), 0);
             if (n <= 0) break;
-            if (!ws_write_frame(client_fd, buf, static_cast<size_t>(n))) break;
+            if (!ws_blocking::write_frame(client_fd, ws_blocking::WsOpcode::kBinary, buf,
+                                          static_cast<size_t>(n))) break;
         }
         done = true;
         shutdown(client_fd, SHUT_WR);
@@ -7,6 +7,10 @@
 #include <cstdint>
 #include <cmath>
 #include <algorithm>
+#include <memory>
+
+#include "chwell/net/poller.h"
+#include "chwell/net/kcp_server.h"
 
 namespace chwell {
 namespace benchmark {
@@ -124,10 +128,148 @@ namespace protocol_bench {
     void benchmark_message_serialize(size_t iterations, size_t body_size);
     void benchmark_message_deserialize(size_t iterations, size_t body_size);
     void benchmark_protocol_parser_parse(size_t iterations, size_t body_size);
+    // 零拷贝视图解析（Parser::feed_views），与 parser_parse 对比
+    void benchmark_protocol_parser_parse_views(size_t iterations, size_t body_size);
     void benchmark_protocol_router_dispatch(size_t iterations, size_t handlers_count);
+    // 视图处理器分发（register_view_handler），与 router_dispatch 对比
+    void benchmark_protocol_router_dispatch_view(size_t iterations, size_t handlers_count);
     void benchmark_message_create_destroy(size_t iterations, size_t body_size);
     void benchmark_message_copy_move(size_t iterations, size_t body_size);
 }
 
+// 服务端往返基准：真实 TcpServer / Service + 回环 TCP，用于对比 epoll 与 io_uring 后端
+namespace server_bench {
+    enum class ServerMode {
+        kEcho,     // TcpServer 原样回显
+        kProtocol  // Service + ProtocolRouterComponent 解析协议后回包
+    };
+
+    // 夹具：在指定后端上启动服务器并建立 num_clients 个长连接，析构时关闭
+    class RoundTripFixture {
+    public:
+        RoundTripFixture(net::IoBackend backend, ServerMode mode, unsigned short port,
+                         size_t num_loops, size_t num_clients);
+        ~RoundTripFixture();
+
+        // 实际生效的后端（io_uring 不可用时为 epoll）
+        net::IoBackend backend() const;
+        bool ready() const;
+
+        // 每个客户端依次发送 msg_size 字节（协议模式为消息体大小）并等待回包，
+        // 所有客户端并发在途，重复 round_trips 轮；返回是否全部收齐
+        bool run(size_t round_trips, size_t msg_size);
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+    void benchmark_echo_round_trip(RoundTripFixture& fixture, size_t round_trips, size_t msg_size);
+    void benchmark_protocol_round_trip(RoundTripFixture& fixture, size_t round_trips, size_t body_size);
+}
+
+// UDP 回环基准：对比逐包 sendto、sendmmsg 批量与 UDP_SEGMENT 分段卸载的发包速率
+namespace udp_bench {
+    enum class SendMode {
+        kSendTo,     // 每个数据报一次 sendto
+        kSendBatch,  // sendmmsg 批量
+        kSegments    // UDP_SEGMENT（GSO），内核拒绝时回退 sendmmsg
+    };
+
+    const char* send_mode_name(SendMode mode);
+
+    // 夹具：回环 UdpServer（可开启 GRO）+ 一个发送 socket，析构时关闭
+    class UdpLoopbackFixture {
+    public:
+        UdpLoopbackFixture(unsigned short port, bool enable_gro);
+        ~UdpLoopbackFixture();
+
+        bool ready() const;
+
+        // 以 mode 发送 count 个 segment_size 字节的数据报，按窗口等待服务端收取后返回送达数；
+        // 回环 socket 缓冲溢出的数据报计为丢失
+        size_t run(SendMode mode, size_t count, size_t segment_size);
+
+        // 服务端回调中看到的数据报总数（GRO 合并后已切回）
+        size_t received() const;
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+    void benchmark_udp_send(UdpLoopbackFixture& fixture, SendMode mode, size_t count, size_t segment_size);
+}
+
+// 输入延迟基准：客户端按固定间隔发出小消息（模拟玩家输入）并等待服务端回显，统计往返延迟分位数，
+// 用于对比 TCP 与 KCP 在丢包 / 延迟链路上的尾延迟
+namespace transport_bench {
+    struct LatencyStats {
+        size_t samples;  // 收到回显的输入数
+        double p50_ms;
+        double p99_ms;
+        double max_ms;
+    };
+
+    // 回环 TcpServer 回显（内核 TCP；链路劣化只能借助 tc netem 在网卡上注入）
+    LatencyStats measure_tcp_input_latency(unsigned short port, size_t inputs,
+                                           int send_interval_ms, size_t msg_size);
+
+    // 回环 KcpServer 回显，两端出站数据报都施加 impairment
+    LatencyStats measure_kcp_input_latency(const net::KcpConfig& config,
+                                           const net::LinkImpairment& impairment,
+                                           size_t inputs, int send_interval_ms, size_t msg_size);
+}
+
+// WebSocket 压缩基准：同一组房间状态快照发往多个接收者，对比各 permessage-deflate 模式的
+// 压缩 CPU 开销与线上字节数
+namespace ws_bench {
+    struct DeflateCost {
+        std::string mode;
+        size_t raw_bytes;        // 所有接收者的原文载荷总字节
+        size_t wire_bytes;       // 所有接收者的线上帧总字节（含帧头）
+        double cpu_us_per_tick;  // 每个 tick 编码 / 压缩全部接收者消息的 CPU 时间
+        double saved_ratio() const {
+            return raw_bytes ? 1.0 - static_cast<double>(wire_bytes) / static_cast<double>(raw_bytes) : 0.0;
+        }
+    };
+
+    // recipients 个接收者、ticks 个快照（每个快照 players 个玩家的 JSON 状态）；
+    // 模式依次为：不压缩、每连接压缩并保留窗口、共享上下文逐连接压缩、广播只压缩一次
+    std::vector<DeflateCost> measure_deflate_cost(size_t recipients, size_t ticks, size_t players,
+                                                  int level);
+}
+
+// 空闲连接内存基准：Service + ProtocolRouterComponent 上建立大量回环长连接，每个连接发一条心跳后保持空闲，
+// 统计服务端每连接的用户态堆内存与 RSS 增量（内核 socket 缓冲不计入），用于评估 C1M 低内存模式
+namespace conn_bench {
+    struct ConnectionFootprint {
+        size_t requested;            // 请求的连接数
+        size_t connections;          // 实际建立的连接数（同进程两端各占一个 fd，受 RLIMIT_NOFILE 限制）
+        double heap_bytes_per_conn;  // malloc 已分配字节增量 / 连接（glibc 之外为 0）
+        double rss_bytes_per_conn;   // 进程 RSS 增量 / 连接
+        double connect_seconds;      // 建立全部连接并完成首条消息分发的耗时
+    };
+
+    // 客户端超过单个源地址的临时端口数时依次绑定 127.0.0.2、127.0.0.3 ... 作为源地址
+    ConnectionFootprint measure_idle_connection_footprint(unsigned short port, size_t connections,
+                                                          bool low_memory, size_t num_loops);
+}
+
+// 网关转发基准：多个客户端经多路复用网关（单条链路）访问回显逻辑服，每轮所有客户端各发一条消息并等待回包，
+// 统计网关 loop 线程每条消息的 CPU 时间与链路写出次数，用于对比链路写合并开启 / 关闭
+namespace gateway_bench {
+    struct ForwardCost {
+        size_t batch_bytes;       // 链路写合并阈值（0 为逐帧写出）
+        size_t messages;          // 完成往返的消息数
+        double cpu_us_per_msg;    // 网关 loop 线程 CPU 时间 / 消息（含去程与回程）
+        double frames_per_write;  // 网关 → 逻辑服方向平均每次写出的帧数
+    };
+
+    ForwardCost measure_forward_cost(unsigned short backend_port, unsigned short front_port,
+                                     size_t clients, size_t rounds, size_t body_size,
+                                     size_t batch_bytes);
+}
+
 } // namespace benchmark
 } // namespace chwell
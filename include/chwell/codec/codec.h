@@ -2,8 +2,11 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <memory>
 
+#include "chwell/net/buffer.h"
+
 namespace chwell {
 namespace codec {
 
@@ -16,7 +19,11 @@ public:
     virtual std::vector<char> encode(const std::string& message) = 0;
 
     // 解码：从字节流中解析出消息对象（可能返回多个消息）
-    virtual std::vector<std::string> decode(const std::vector<char>& data) = 0;
+    // data 只需在调用期间有效，可直接传入 TcpConnection 消息回调的视图
+    virtual std::vector<std::string> decode(std::string_view data) = 0;
+    std::vector<std::string> decode(const std::vector<char>& data) {
+        return decode(std::string_view(data.data(), data.size()));
+    }
 
     // 重置解码器状态（例如连接断开时）
     virtual void reset() {}
@@ -25,40 +32,30 @@ public:
 // 长度头编解码器：| length (4 bytes, network byte order) | body (length bytes) |
 class LengthHeaderCodec : public Codec {
 public:
-    LengthHeaderCodec() : buffer_(), head_(0) {}
+    LengthHeaderCodec() {}
 
+    using Codec::decode;
     virtual std::vector<char> encode(const std::string& message) override;
-    virtual std::vector<std::string> decode(const std::vector<char>& data) override;
-    virtual void reset() override {
-        buffer_.clear();
-        head_ = 0;
-    }
+    virtual std::vector<std::string> decode(std::string_view data) override;
+    virtual void reset() override { buffer_.retrieve_all(); }
 
 private:
-    void compact_prefix();
-
-    std::vector<char> buffer_;
-    std::size_t head_;
+    net::Buffer buffer_;  // 只缓存跨调用的残帧
 };
 
 // JSON 编解码器：使用 4 字节长度前缀（网络字节序）成帧，与 LengthHeaderCodec 一致。
 // message 为 UTF-8 JSON 字符串，便于游戏逻辑中直接使用 JSON 文本。
 class JsonCodec : public Codec {
 public:
-    JsonCodec() : buffer_(), head_(0) {}
+    JsonCodec() {}
 
+    using Codec::decode;
     virtual std::vector<char> encode(const std::string& message) override;
-    virtual std::vector<std::string> decode(const std::vector<char>& data) override;
-    virtual void reset() override {
-        buffer_.clear();
-        head_ = 0;
-    }
+    virtual std::vector<std::string> decode(std::string_view data) override;
+    virtual void reset() override { buffer_.retrieve_all(); }
 
 private:
-    void compact_prefix();
-
-    std::vector<char> buffer_;
-    std::size_t head_;
+    net::Buffer buffer_;  // 只缓存跨调用的残帧
 };
 
 // Protobuf 编解码器：varint32 长度前缀流式格式
@@ -66,20 +63,15 @@ private:
 // message 为单条 protobuf 消息的二进制序列化结果（如 msg.SerializeAsString()）。
 class ProtobufCodec : public Codec {
 public:
-    ProtobufCodec() : buffer_(), head_(0) {}
+    ProtobufCodec() {}
 
+    using Codec::decode;
     virtual std::vector<char> encode(const std::string& message) override;
-    virtual std::vector<std::string> decode(const std::vector<char>& data) override;
-    virtual void reset() override {
-        buffer_.clear();
-        head_ = 0;
-    }
+    virtual std::vector<std::string> decode(std::string_view data) override;
+    virtual void reset() override { buffer_.retrieve_all(); }
 
 private:
-    void compact_prefix();
-
-    std::vector<char> buffer_;
-    std::size_t head_;
+    net::Buffer buffer_;  // 只缓存跨调用的残帧
 };
 
 } // namespace codec
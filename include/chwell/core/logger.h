@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <mutex>
 #include <iostream>
@@ -22,7 +23,11 @@ public:
     static Logger& instance();
 
     void set_level(LogLevel level);
-    LogLevel level() const { return current_level_; }
+    LogLevel level() const { return current_level_.load(std::memory_order_relaxed); }
+    // 日志宏先检查级别，被过滤的日志不构造 ostringstream
+    bool enabled(LogLevel level) const {
+        return static_cast<int>(level) >= static_cast<int>(this->level());
+    }
 
     // 是否启用终端颜色（默认自动检测 isatty）
     void set_use_color(bool use) { use_color_ = use; }
@@ -44,7 +49,7 @@ private:
     std::string color_reset() const;
     std::ostream& stream_for(LogLevel level);
 
-    LogLevel current_level_;
+    std::atomic<LogLevel> current_level_;
     bool use_color_;
     std::mutex mutex_;
 };
@@ -55,21 +60,25 @@ private:
 // 简短日志宏，避免写 Logger::instance().info(...)
 // 用法：CHWELL_LOG_INFO("hello"); 或 CHWELL_LOG_INFO("port=" << port << " ok");
 #define CHWELL_LOG_DEBUG(x) do { \
+    if (!::chwell::core::Logger::instance().enabled(::chwell::core::LogLevel::Debug)) break; \
     std::ostringstream _chwell_ss; \
     _chwell_ss << x; \
     ::chwell::core::Logger::instance().debug(_chwell_ss.str()); \
 } while (0)
 #define CHWELL_LOG_INFO(x) do { \
+    if (!::chwell::core::Logger::instance().enabled(::chwell::core::LogLevel::Info)) break; \
     std::ostringstream _chwell_ss; \
     _chwell_ss << x; \
     ::chwell::core::Logger::instance().info(_chwell_ss.str()); \
 } while (0)
 #define CHWELL_LOG_WARN(x) do { \
+    if (!::chwell::core::Logger::instance().enabled(::chwell::core::LogLevel::Warn)) break; \
     std::ostringstream _chwell_ss; \
     _chwell_ss << x; \
     ::chwell::core::Logger::instance().warn(_chwell_ss.str()); \
 } while (0)
 #define CHWELL_LOG_ERROR(x) do { \
+    if (!::chwell::core::Logger::instance().enabled(::chwell::core::LogLevel::Error)) break; \
     std::ostringstream _chwell_ss; \
     _chwell_ss << x; \
     ::chwell::core::Logger::instance().error(_chwell_ss.str()); \
@@ -3,6 +3,7 @@
 #include "chwell/service/component.h"
 #include "chwell/service/service.h"
 #include "chwell/net/tcp_connection.h"
+#include "chwell/protocol/message.h"
 #include "chwell/core/logger.h"
 #include <unordered_map>
 #include <unordered_set>
@@ -66,12 +67,15 @@ public:
     // 处理聊天请求
     void handle_chat(const net::TcpConnectionPtr& conn, const std::vector<char>& data);
 
-    // 广播聊天消息到房间
+    // 广播聊天消息到房间（只编码一次，按 I/O 线程分组写出）
     void broadcast_chat(const std::string& room_id, const std::string& from_player_id, const std::string& content);
 
     // 发送聊天消息
     void send_chat_message(const net::TcpConnectionPtr& conn, const std::string& from_player_id, const std::string& content);
 
+    // 编码 S2C_CHAT 消息
+    static protocol::Message make_chat_message(const std::string& from_player_id, const std::string& content);
+
 private:
     service::Service* service_ = nullptr;
 };
@@ -118,11 +122,13 @@ private:
 };
 
 // 心跳组件
+// 注册时为 Service 的 TCP 连接启用读空闲超时（HEARTBEAT_TIMEOUT 秒，已显式配置时保留原值）：
+// 客户端停止发送心跳与其他消息超过该时间即被关闭，并照常触发各组件的 on_disconnect
 class HeartbeatComponent : public service::Component {
 public:
     virtual std::string name() const override { return "HeartbeatComponent"; }
 
-    // 注册协议处理器
+    // 注册协议处理器，并启用读空闲超时（需在 Service::start() 之前添加本组件）
     virtual void on_register(service::Service& svc) override;
 
     // 处理心跳请求
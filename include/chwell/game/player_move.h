@@ -3,8 +3,10 @@
 #include "chwell/service/component.h"
 #include "chwell/service/service.h"
 #include "chwell/net/tcp_connection.h"
+#include "chwell/protocol/message.h"
 #include "chwell/core/logger.h"
 #include <string>
+#include <string_view>
 
 namespace chwell {
 namespace game {
@@ -38,14 +40,17 @@ public:
     virtual void on_register(service::Service& svc) override;
 
     // 处理玩家移动请求
-    void handle_player_move(const net::TcpConnectionPtr& conn, const std::vector<char>& data);
+    void handle_player_move(const net::TcpConnectionPtr& conn, std::string_view data);
 
-    // 广播玩家位置
+    // 广播玩家位置（只编码一次，按 I/O 线程分组写出）
     void broadcast_player_position(const std::string& room_id, const std::string& player_id, const PlayerPosition& pos);
 
     // 发送玩家位置
     void send_player_position(const net::TcpConnectionPtr& conn, const std::string& player_id, const PlayerPosition& pos);
 
+    // 编码 S2C_PLAYER_POS 消息
+    static protocol::Message make_position_message(const std::string& player_id, const PlayerPosition& pos);
+
     // 更新玩家位置
     void update_player_position(const std::string& player_id, const PlayerPosition& pos);
 
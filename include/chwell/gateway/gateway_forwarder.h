@@ -1,25 +1,41 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <unordered_map>
 #include <string>
 #include <string_view>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include "chwell/service/component.h"
 #include "chwell/protocol/message.h"
 #include "chwell/cluster/node_registry.h"
+#include "chwell/net/connector.h"
+#include "chwell/net/mux.h"
 
 namespace chwell {
 namespace net {
 class TcpConnection;
+class EventLoop;
 typedef std::shared_ptr<TcpConnection> TcpConnectionPtr;
 }  // namespace net
 
+namespace service {
+class ProtocolRouterComponent;
+}  // namespace service
+
 namespace gateway {
 
 // GatewayForwarderComponent：网关转发组件
-// 负责维护客户端与后端逻辑服的连接映射，将需要转发的消息发送到后端并回传响应
+// 负责维护客户端与后端逻辑服的连接映射，将需要转发的消息发送到后端并回传响应。
+// 后端连接在客户端所属的事件循环上非阻塞建立，建连期间该客户端的消息按序暂存，连上后依次发出；
+// 后端连续建连失败后被摘除并指数退避，摘除期间转发立即回复错误，不占用客户端的消息处理路径。
+// 默认每个客户端一条后端连接；set_multiplex_links 开启多路复用后，每个后端只保持固定数量的链路，
+// 客户端以会话 id 复用链路（帧格式见 net/mux.h），逻辑服的 fd 数与建连次数不再随玩家数增长。
+// 转发按客户端连接的帧格式（TcpConnection::frame_format）重新编码，后端回复原样发回客户端，
+// 因此后端端口（TcpServerConfig::frame_format / MuxServer::set_frame_format）须与客户端端口使用同一帧格式
 class GatewayForwarderComponent : public service::Component {
 public:
     // 静态单节点后端
@@ -35,6 +51,28 @@ public:
         return "GatewayForwarderComponent";
     }
 
+    // 建连超时（毫秒，默认 3000），由事件循环计时
+    void set_connect_timeout_ms(int ms) { connect_timeout_ms_ = ms; }
+    // 每个客户端建连期间最多暂存的消息数（默认 256），超出的消息直接回复错误
+    void set_max_pending_messages(std::size_t n) { max_pending_messages_ = n; }
+    // 后端连续建连失败后的摘除与退避策略
+    void set_ejection_policy(const net::EjectionPolicy& policy) { ejection_ = policy; }
+    // 多路复用模式：n > 0 时每个后端地址只建立 n 条链路，后端端口需由逻辑服以 Service::listen_mux 监听；
+    // 0（默认）为每个客户端一条后端连接。需在转发第一条消息之前设置
+    void set_multiplex_links(std::size_t n) { mux_links_ = n; }
+    std::size_t multiplex_links() const { return mux_links_; }
+    // 链路写合并阈值（默认 net::MuxBatcher::kDefaultBatchBytes）：各客户端转发的帧合并到所属链路的
+    // 同一批次，攒满该字节数或链路 loop 本轮事件处理完成时一次写出；0 为逐帧写出。需在转发第一条消息之前设置
+    void set_link_batch_bytes(std::size_t n) { link_batch_bytes_ = n; }
+    // 直通模式：cmds 中的消息照常经 forward 转发；但帧头到达时 body 还有不少于 set_passthrough_min_bytes 字节
+    // 未读的大帧，剩余 body 由 TcpConnection::splice_to 经管道从客户端 socket 直接搬到后端 socket，
+    // 不进入网关的用户态缓冲。需配合 TcpServerConfig::max_read_bytes 限制单次读取，否则 body 多半已被读进来。
+    // 仅每客户端一条后端连接的模式生效（多路复用链路的每帧都要加会话头，且大帧会阻塞同链路的其他会话）
+    void enable_passthrough(service::ProtocolRouterComponent& router,
+                            const std::vector<std::uint16_t>& cmds);
+    // 触发直通的最小剩余 body 字节数（默认 16 KiB），更小的帧读进来再转发更划算
+    void set_passthrough_min_bytes(std::size_t n) { passthrough_min_bytes_ = n; }
+
     virtual void on_register(service::Service& svc) override;
     virtual void on_disconnect(const net::TcpConnectionPtr& conn) override;
 
@@ -42,13 +80,87 @@ public:
     void forward(const net::TcpConnectionPtr& client_conn,
                  const protocol::Message& msg);
 
-    // 检查是否已建立后端连接
+    // 直通转发一帧：frame 为已读到的帧头与 body 前缀，remaining 为仍在客户端 socket 中的 body 字节数。
+    // 已有可用后端连接时把 frame 发往后端并开始 splice，返回 true；否则返回 false，由调用方按常规路径处理
+    bool forward_passthrough(const net::TcpConnectionPtr& client_conn, std::string_view frame,
+                             std::size_t remaining);
+
+    // 检查是否已建立后端连接（多路复用模式下为客户端会话所在的链路已可用）
     bool has_backend(const net::TcpConnectionPtr& client_conn) const;
 
+    // 当前打开的后端 socket 数（多路复用模式下为链路数）
+    std::size_t backend_socket_count() const;
+
+    // 当前各链路累计转发的帧数与写出次数
+    struct MuxLinkStats {
+        std::uint64_t frames{0};
+        std::uint64_t writes{0};
+    };
+    MuxLinkStats mux_link_stats() const;
+
+    // 后端当前是否因连续建连失败被摘除
+    bool backend_ejected(const std::string& host, unsigned short port) const;
+
 private:
-    net::TcpConnectionPtr connect_backend(const net::TcpConnectionPtr& client_conn);
-    net::TcpConnectionPtr do_connect(const net::TcpConnectionPtr& client_conn,
-                                     const std::string& host, unsigned short port);
+    // 建连中的后端：暂存建连完成前该客户端要转发的消息
+    struct PendingBackend {
+        net::ConnectorPtr connector;
+        std::vector<protocol::Message> queued;
+    };
+
+    // 多路复用链路：建连完成并补发暂存帧之后才设置 conn，之前到达的帧按序暂存
+    struct MuxLink {
+        struct Queued {
+            std::uint32_t session;
+            bool data;            // false 为会话结束帧
+            std::uint16_t cmd;    // 建连失败时据此回复错误
+            std::string frame;    // 已编码的整帧
+        };
+
+        std::string host;
+        unsigned short port{0};
+        std::string addr;
+        net::EventLoop* loop{nullptr};
+        net::TcpConnectionPtr conn;
+        net::MuxBatcherPtr batcher;  // 与 conn 同时设置
+        net::ConnectorPtr connector;
+        std::vector<Queued> queued;
+        std::unordered_map<std::uint32_t, net::TcpConnectionPtr> sessions;
+        net::MuxDecoder decoder;  // 仅链路所属 loop 线程使用
+    };
+    typedef std::shared_ptr<MuxLink> MuxLinkPtr;
+
+    struct MuxRoute {
+        std::uint32_t session;
+        MuxLinkPtr link;
+    };
+
+    // 按静态地址或 NodeRegistry 为客户端选择后端
+    bool resolve_backend(const net::TcpConnectionPtr& client_conn,
+                         std::string& host, unsigned short& port);
+    // 选择后端并发起非阻塞建连，msg 为第一条待转发的消息；后端被摘除或无法建连时返回 false
+    bool connect_backend(const net::TcpConnectionPtr& client_conn, const protocol::Message& msg);
+    net::BackendHealth& health_locked(const std::string& addr);
+    void record_connect_result_locked(const std::string& addr, int err);
+
+    void forward_mux(const net::TcpConnectionPtr& client_conn, const protocol::Message& msg);
+    void start_link_locked(const MuxLinkPtr& link, const net::TcpConnectionPtr& client_conn);
+    void on_link_connected(const MuxLinkPtr& link, net::TcpSocket socket, int err);
+    void on_link_message(const MuxLinkPtr& link, const net::TcpConnectionPtr& conn,
+                         std::string_view data);
+    void on_link_close(const MuxLinkPtr& link, const net::TcpConnectionPtr& conn);
+    std::vector<net::TcpConnectionPtr> link_clients(const MuxLinkPtr& link) const;
+    void on_backend_connected(const std::weak_ptr<net::TcpConnection>& weak_client,
+                              net::EventLoop* loop, const std::string& addr,
+                              net::TcpSocket socket, int err);
+    net::TcpConnectionPtr attach_backend(const net::TcpConnectionPtr& client_conn,
+                                         net::EventLoop* loop, net::TcpSocket socket);
+    void reply_unavailable(const net::TcpConnectionPtr& client_conn, std::uint16_t cmd);
+    // 按客户端连接的帧格式编码要转发的消息；编码不下（旧格式的 body 超过 64 KiB、超过 max_bytes）时
+    // 回复错误并计数，返回 false
+    bool encode_relay(const net::TcpConnectionPtr& client_conn, const protocol::Message& msg,
+                      std::vector<char>& out,
+                      std::size_t max_bytes = static_cast<std::size_t>(-1));
     void on_backend_message(const net::TcpConnectionPtr& backend_conn,
                             std::string_view data);
     void on_backend_close(const net::TcpConnectionPtr& backend_conn);
@@ -63,9 +175,22 @@ private:
     bool registry_loaded_{false};
     cluster::NodeRegistry registry_;
 
+    int connect_timeout_ms_{3000};
+    std::size_t max_pending_messages_{256};
+    net::EjectionPolicy ejection_;
+    std::size_t passthrough_min_bytes_{16 * 1024};
+
     mutable std::mutex mutex_;
     std::unordered_map<const net::TcpConnection*, net::TcpConnectionPtr> client_to_backend_;
     std::unordered_map<const net::TcpConnection*, net::TcpConnectionPtr> backend_to_client_;
+    std::unordered_map<const net::TcpConnection*, PendingBackend> pending_;
+    std::unordered_map<std::string, net::BackendHealth> health_;  // 按 "host:port"
+
+    std::size_t mux_links_{0};
+    std::size_t link_batch_bytes_{net::MuxBatcher::kDefaultBatchBytes};
+    std::uint32_t next_session_{0};
+    std::unordered_map<std::string, std::vector<MuxLinkPtr>> links_;  // 按 "host:port"
+    std::unordered_map<const net::TcpConnection*, MuxRoute> mux_routes_;
 };
 
 }  // namespace gateway
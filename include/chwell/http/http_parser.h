@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace chwell {
+namespace http {
+
+// 请求头字段视图，指向调用方传入的数据
+struct HttpHeaderView {
+    std::string_view name;
+    std::string_view value;
+};
+
+// 请求行与头部的零拷贝视图；视图在所指数据被修改或释放前有效
+struct HttpRequestView {
+    std::string_view method;
+    std::string_view path;      // 请求目标（含查询串）
+    std::string_view version;   // "HTTP/1.1" / "HTTP/1.0"
+    std::vector<HttpHeaderView> headers;
+    std::string_view body;      // 完整正文（由 HttpServer 在请求结束时填写）
+
+    bool keep_alive{true};      // 按版本与 Connection 头推断
+    bool chunked{false};        // Transfer-Encoding: chunked
+    bool expect_continue{false};
+    std::uint64_t content_length{0};
+
+    // 按名查找头部（大小写不敏感），不存在时返回空视图
+    std::string_view header(std::string_view name) const;
+
+    void clear();
+};
+
+// 解析完整的请求头（含结尾空行），成功返回 true；失败时 *status 为应答状态码（400 / 501）
+bool parse_http_head(std::string_view head, HttpRequestView* out, int* status);
+
+// 增量请求解析器（HTTP/1.1，支持 Content-Length 与 chunked 正文、流水线）
+// 调用方反复调用 next()，每次从 data 开头解析出一个事件并给出消费的字节数：
+//   kHead      请求头完整，head() 中的视图指向本次 data
+//   kBody      一段正文（chunked 已去除分块格式），*chunk 指向本次 data
+//   kComplete  当前请求结束，解析器回到等待下一个请求头的状态
+//   kNeedMore  数据不足（未消费的字节需与后续数据拼接后再传入）
+//   kError     协议错误，error_status() 给出应答状态码（400 / 413 / 431 / 501）
+// 等待请求头时记住已扫描过的位置，重复传入同一前缀加新数据时只扫描新增部分
+class HttpRequestParser {
+public:
+    enum class Event { kNeedMore, kHead, kBody, kComplete, kError };
+
+    struct Limits {
+        std::size_t max_header_bytes;  // 请求行 + 头部上限，超出回复 431
+        std::size_t max_body_size;     // 单个请求正文上限，超出回复 413
+        std::size_t max_headers;       // 头部字段数上限
+
+        Limits()
+            : max_header_bytes(8192),
+              max_body_size(1024 * 1024),
+              max_headers(64) {}
+    };
+
+    explicit HttpRequestParser(const Limits& limits = Limits()) : limits_(limits) {}
+
+    Event next(std::string_view data, std::size_t* consumed, std::string_view* chunk);
+
+    const HttpRequestView& head() const { return head_; }
+    HttpRequestView& head() { return head_; }
+    int error_status() const { return error_status_; }
+    // 正处于某个请求的正文阶段（已交付 kHead、尚未 kComplete）
+    bool in_body() const { return state_ != State::kHead && state_ != State::kError; }
+
+    // 丢弃当前状态，回到等待请求头
+    void reset();
+
+private:
+    enum class State { kHead, kBody, kChunkSize, kChunkData, kChunkCrlf, kTrailer, kError };
+
+    Event fail(int status);
+
+    Limits limits_;
+    State state_{State::kHead};
+    HttpRequestView head_;
+    std::size_t scanned_{0};        // 等待请求头时已扫描的字节数
+    std::uint64_t remaining_{0};    // 当前正文 / 分块剩余字节
+    std::uint64_t body_bytes_{0};   // 当前请求已交付的正文字节
+    int error_status_{0};
+};
+
+} // namespace http
+} // namespace chwell
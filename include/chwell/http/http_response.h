@@ -1,9 +1,13 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <map>
 #include <vector>
 
+#include "chwell/net/file_region.h"
+#include "chwell/net/shared_frame.h"
+
 namespace chwell {
 namespace http {
 
@@ -13,6 +17,13 @@ struct HttpResponse {
     std::map<std::string, std::string> headers;
     std::string body;
 
+    // 以下用于静态文件等预先生成的内容，HttpServer 发送时不拷贝正文：
+    // header_block 为预先序列化的头部行（每行以 "\r\n" 结尾），在 headers 之后原样写出；
+    // shared_body 非空时以引用方式发送该帧作为正文；file_body 非空时以 sendfile 发送该文件区间
+    std::string header_block;
+    net::SharedFrame shared_body;
+    net::FileRegion file_body;
+
     HttpResponse()
         : status_code(200), reason("OK") {}
 
@@ -20,8 +31,20 @@ struct HttpResponse {
         headers[key] = value;
     }
 
-    // 简单序列化为 HTTP 响应报文
+    // 正文长度（Content-Length）
+    std::uint64_t body_size() const {
+        if (!file_body.empty()) return file_body.length;
+        if (!shared_body.empty()) return shared_body.size();
+        return body.size();
+    }
+
+    // 简单序列化为 HTTP 响应报文（shared_body / file_body 一并读出拷贝）
     std::vector<char> to_bytes() const;
+
+    // 序列化追加到 *out（HttpServer 把同一次读到的流水线请求的响应合并写出）；
+    // include_body 为 false 时只写头部（HEAD 请求），Content-Length 仍为正文长度；
+    // 只写出 body，shared_body / file_body 由调用方随后发送
+    void append_to(std::string* out, bool include_body = true) const;
 };
 
 } // namespace http
@@ -2,38 +2,70 @@
 
 #include <functional>
 #include <memory>
-#include <thread>
-#include <atomic>
+#include <vector>
 
 #include "chwell/net/posix_io.h"
+#include "chwell/net/event_loop.h"
+#include "chwell/net/tcp_server.h"
+#include "chwell/http/http_parser.h"
 #include "chwell/http/http_request.h"
 #include "chwell/http/http_response.h"
+#include "chwell/http/static_files.h"
 
 namespace chwell {
 namespace http {
 
 typedef std::function<void(const HttpRequest&, HttpResponse&)> HttpHandler;
+// 零拷贝处理器：请求头与正文均为视图，仅在回调内有效
+typedef std::function<void(const HttpRequestView&, HttpResponse&)> HttpViewHandler;
 
-// 一个简单的 HTTP 服务器：支持单次请求-响应（短连接）
+struct HttpServerConfig {
+    HttpRequestParser::Limits limits;         // 请求头 / 正文上限
+    bool keep_alive;                          // 允许长连接；false 时每个响应后关闭
+    std::size_t max_requests_per_connection;  // 单连接处理的请求数上限，到达后关闭（0 不限制）
+    net::TcpServerConfig tcp;                 // 监听、背压与 TLS 参数
+
+    HttpServerConfig()
+        : keep_alive(true),
+          max_requests_per_connection(0) {}
+};
+
+// HTTP/1.1 服务器：运行在反应堆 TcpServer 上，连接由 I/O 事件循环驱动，不再每连接占一个线程
+// - 长连接与流水线：同一连接上的请求按序处理，同一次读到的多个请求的响应合并一次写出
+// - 增量解析：请求头未收齐时只扫描新到的字节；请求头以视图交付，正文支持 Content-Length 与 chunked
+// - 处理器在连接所属 I/O 线程同步执行，不应阻塞（耗时操作投递到业务线程池）
 class HttpServer {
 public:
+    // 内部创建单线程 I/O 循环，io_service 仅保留给调用方投递任务
     HttpServer(net::IoService& io_service, unsigned short port);
 
+    // 共享外部 I/O 线程池（如 Service::event_loops()），与游戏服务共用反应堆
+    HttpServer(net::EventLoopThreadPool& loops, unsigned short port);
+
+    // 需在 start() 之前设置
+    void set_config(const HttpServerConfig& config) { config_ = config; }
+    const HttpServerConfig& config() const { return config_; }
+
     void start();
     void stop();
 
     void set_handler(const HttpHandler& handler) { handler_ = handler; }
+    // 设置后优先于 set_handler，省去请求头与正文的拷贝（健康检查、指标抓取等高频接口）
+    void set_view_handler(const HttpViewHandler& handler) { view_handler_ = handler; }
+
+    // 把 config.root 挂到 config.url_prefix 下提供静态文件，先于处理器匹配；需在 start() 之前调用
+    StaticFileHandlerPtr mount_static(const StaticFileConfig& config);
+
+    std::size_t connection_count() { return tcp_server_->connection_count(); }
 
 private:
-    void accept_loop();
-
-    net::IoService& io_service_;
-    unsigned short port_;
-    net::TcpAcceptor acceptor_;
-    int wake_pipe_[2]{-1, -1};
-    std::thread accept_thread_;
-    std::atomic<bool> stopped_{false};
+    friend class HttpSession;
+
+    HttpServerConfig config_;
+    std::unique_ptr<net::TcpServer> tcp_server_;
     HttpHandler handler_;
+    HttpViewHandler view_handler_;
+    std::vector<StaticFileHandlerPtr> static_handlers_;
 };
 
 } // namespace http
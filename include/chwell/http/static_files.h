@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "chwell/http/http_parser.h"
+#include "chwell/http/http_response.h"
+#include "chwell/net/file_region.h"
+#include "chwell/net/shared_frame.h"
+
+namespace chwell {
+namespace http {
+
+struct StaticFileConfig {
+    std::string root;                 // 文件根目录
+    std::string url_prefix;           // 挂载的 URL 前缀（以 '/' 结尾）
+    std::string index_file;           // 目录请求对应的文件
+    std::size_t cache_max_bytes;      // 内存缓存上限（正文 + gzip 变体）
+    std::size_t cache_max_file_size;  // 不超过该大小的文件整体缓存在内存，更大的只缓存句柄并以 sendfile 发送
+    std::size_t cache_max_entries;    // 缓存条目上限（含只缓存句柄的大文件）
+    bool gzip;                        // 为可压缩类型的内存缓存文件预先生成 gzip 变体（需 CHWELL_USE_ZLIB）
+    std::size_t gzip_min_size;        // 小于该大小的文件不压缩
+    int gzip_level;                   // 每个文件只压缩一次，默认取较高压缩比
+    int max_age_sec;                  // Cache-Control: max-age（0 为 no-cache，每次回源校验 ETag）
+    int revalidate_ms;                // 缓存条目重新 stat 校验文件是否变化的间隔（0 每次校验）
+
+    StaticFileConfig()
+        : url_prefix("/"),
+          index_file("index.html"),
+          cache_max_bytes(64 * 1024 * 1024),
+          cache_max_file_size(256 * 1024),
+          cache_max_entries(4096),
+          gzip(true),
+          gzip_min_size(1024),
+          gzip_level(6),
+          max_age_sec(3600),
+          revalidate_ms(1000) {}
+};
+
+// 静态文件处理器（如 H5 客户端资源），可挂到 HttpServer::mount_static 或在自定义处理器中调用
+// - 热点小文件整体缓存在内存（LRU），连同预先序列化的响应头与 gzip 变体；命中时正文以共享帧引用发送，不拷贝
+// - 大文件只缓存打开的句柄与响应头，正文以 sendfile 由内核直接从页缓存写出
+// - ETag / If-None-Match、Last-Modified / If-Modified-Since 返回 304；单段 Range（含 If-Range）返回 206
+// - 同一文件的并发未命中只加载 / 压缩一次，其余请求等待结果（版本发布后 CDN 回源风暴不会重复压缩）
+// 可被多个 I/O 线程并发调用
+class StaticFileHandler {
+public:
+    explicit StaticFileHandler(const StaticFileConfig& config);
+    ~StaticFileHandler();
+
+    // 请求路径在 url_prefix 下时生成响应（含 304 / 404 / 405 / 416）并返回 true，否则返回 false
+    bool handle(const HttpRequestView& req, HttpResponse& resp);
+
+    const StaticFileConfig& config() const { return config_; }
+
+    struct Stats {
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::uint64_t not_modified;
+        std::size_t entries;
+        std::size_t cached_bytes;
+    };
+    Stats stats() const;
+
+    // 清空缓存（如资源目录整体替换后）
+    void clear();
+
+private:
+    struct Entry;
+    typedef std::shared_ptr<const Entry> EntryPtr;
+
+    struct Slot {
+        EntryPtr entry;
+        std::list<std::string>::iterator lru;
+    };
+
+    // 查找或加载 rel_path 对应的文件；文件不存在返回 nullptr，*is_dir 指示请求的是目录
+    EntryPtr lookup(const std::string& rel_path, bool* is_dir);
+    EntryPtr load(const std::string& rel_path, bool* is_dir) const;
+    bool still_valid(const Entry& entry) const;
+    void insert_locked(const std::string& key, const EntryPtr& entry);
+    void erase_locked(const std::string& key);
+    void fill_response(const Entry& entry, const HttpRequestView& req, HttpResponse& resp);
+
+    StaticFileConfig config_;
+
+    mutable std::mutex mutex_;
+    std::list<std::string> lru_;  // 队首最近使用
+    std::unordered_map<std::string, Slot> cache_;
+    std::unordered_map<std::string, std::shared_future<EntryPtr>> loading_;
+    std::size_t cached_bytes_{0};
+
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::atomic<std::uint64_t> not_modified_{0};
+};
+
+typedef std::shared_ptr<StaticFileHandler> StaticFileHandlerPtr;
+
+// 按扩展名推断 Content-Type（未知类型返回 application/octet-stream）
+const char* guess_content_type(const std::string& path);
+
+} // namespace http
+} // namespace chwell
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "chwell/metrics/prometheus_metrics.h"
+
+namespace chwell {
+namespace metrics {
+
+// 框架内部的事件计数器（按名注册到全局 registry，首次调用时创建）。
+// 返回的引用在进程内一直有效（PrometheusRegistry::reset 只清零计数器，不释放），可以缓存
+inline Counter& event_counter(const char* name, const char* help) {
+    return get_prometheus_registry().register_counter(name, help);
+}
+
+} // namespace metrics
+} // namespace chwell
+
+// 事件计数：每个调用点首次执行时解析一次计数器并缓存为函数内静态引用，之后只做一次原子累加，
+// 不再构造名字字符串、不再进入 registry 的锁。name / help 须为字符串常量；可选第三个参数为增量
+#define CHWELL_COUNT_EVENT(name, help, ...)                                                  \
+    do {                                                                                     \
+        static ::chwell::metrics::Counter& chwell_event_counter_ =                           \
+            ::chwell::metrics::event_counter(name, help);                                    \
+        chwell_event_counter_.inc(__VA_ARGS__);                                              \
+    } while (0)
@@ -28,6 +28,11 @@ public:
         return value_.load(std::memory_order_relaxed);
     }
 
+    // 清零（仅供 PrometheusRegistry::reset 使用）
+    void reset() {
+        value_.store(0.0, std::memory_order_relaxed);
+    }
+
     std::string to_prometheus(const std::string& name,
                                const std::string& help = "") const {
         std::ostringstream oss;
@@ -246,7 +251,8 @@ public:
 
     std::string to_prometheus() const;
 
-    // 清空所有注册的指标（主要用于测试）
+    // 重置所有指标（主要用于测试）：Counter / Gauge 清零但保留对象，框架内部缓存的引用
+    // （见 event_counter.h）继续有效；Histogram / Summary 直接移除
     void reset();
 
 private:
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace chwell {
+namespace net {
+
+// Buffer：连接读路径与各解析器共用的字节缓冲
+//
+// +-------------------+------------------+------------------+
+// | prependable bytes |  readable bytes  |  writable bytes  |
+// +-------------------+------------------+------------------+
+// 0        <=    reader_index   <=   writer_index    <=   size
+//
+// - 消费只移动 reader_index，不做前部 erase；读空后两个下标归位，常见的整帧场景零搬移
+// - 写空间不足时若总空闲足够，仅把未读的残帧挪到前部一次，否则扩容
+// - 头部预留 kCheapPrepend 字节，编码时可在 body 前直接写入长度头（prepend）
+// - read_fd 以 readv 同时读入剩余容量与栈上 64KB 临时区，一次系统调用读尽内核缓冲，
+//   缓冲本身按实际流量增长而不是按最大值预分配
+class Buffer {
+public:
+    static const std::size_t kCheapPrepend = 8;
+    static const std::size_t kInitialSize = 4096;
+
+    explicit Buffer(std::size_t initial_size = kInitialSize)
+        : buffer_(kCheapPrepend + initial_size),
+          reader_index_(kCheapPrepend),
+          writer_index_(kCheapPrepend) {}
+
+    std::size_t readable_bytes() const { return writer_index_ - reader_index_; }
+    std::size_t writable_bytes() const { return buffer_.size() - writer_index_; }
+    std::size_t prependable_bytes() const { return reader_index_; }
+    bool empty() const { return readable_bytes() == 0; }
+
+    // 可读数据起点；在下一次写入 / 扩容前有效
+    const char* peek() const { return buffer_.data() + reader_index_; }
+    std::string_view view() const { return std::string_view(peek(), readable_bytes()); }
+
+    // 消费 len 字节（len 超过可读数据时视为全部消费）
+    void retrieve(std::size_t len) {
+        if (len < readable_bytes()) {
+            reader_index_ += len;
+        } else {
+            retrieve_all();
+        }
+    }
+
+    void retrieve_all() {
+        reader_index_ = kCheapPrepend;
+        writer_index_ = kCheapPrepend;
+    }
+
+    std::string retrieve_as_string(std::size_t len) {
+        if (len > readable_bytes()) len = readable_bytes();
+        std::string result(peek(), len);
+        retrieve(len);
+        return result;
+    }
+
+    void append(const char* data, std::size_t len) {
+        ensure_writable(len);
+        if (len > 0) {
+            std::memcpy(begin_write(), data, len);
+        }
+        has_written(len);
+    }
+
+    void append(std::string_view data) { append(data.data(), data.size()); }
+
+    // 直接写入可写区域：ensure_writable → 写 begin_write() → has_written
+    char* begin_write() { return buffer_.data() + writer_index_; }
+    void has_written(std::size_t len) { writer_index_ += len; }
+
+    void ensure_writable(std::size_t len) {
+        if (writable_bytes() < len) {
+            make_space(len);
+        }
+    }
+
+    // 在可读数据前写入 len 字节（如长度头），需 len <= prependable_bytes()
+    void prepend(const void* data, std::size_t len) {
+        reader_index_ -= len;
+        std::memcpy(buffer_.data() + reader_index_, data, len);
+    }
+
+    // 容量（不含预留头部），用于统计与测试
+    std::size_t capacity() const { return buffer_.size() - kCheapPrepend; }
+
+    // 释放超出当前可读数据的多余容量（空闲连接回收内存）
+    void shrink(std::size_t reserve = 0);
+
+    // 从 fd 读取：可写区 + 栈上 64KB 临时区做 readv，返回读取字节数；
+    // 出错返回 -1 并写 *saved_errno。max_bytes > 0 时本次最多读取 max_bytes 字节
+    ssize_t read_fd(int fd, int* saved_errno, std::size_t max_bytes = 0);
+
+private:
+    void make_space(std::size_t len);
+
+    std::vector<char> buffer_;
+    std::size_t reader_index_;
+    std::size_t writer_index_;
+};
+
+} // namespace net
+} // namespace chwell
@@ -6,16 +6,13 @@
 #include <memory>
 #include <type_traits>
 
+#include "chwell/net/tcp_connection.h"
+#include "chwell/net/ws_connection.h"
+#include "chwell/net/kcp_server.h"
+
 namespace chwell {
 namespace net {
 
-// 前向声明
-class TcpConnection;
-class WsConnection;
-
-typedef std::shared_ptr<TcpConnection> TcpConnectionPtr;
-typedef std::shared_ptr<WsConnection> WsConnectionPtr;
-
 // 连接基类：提供所有连接类型的公共接口
 class IConnection {
 public:
@@ -83,7 +80,7 @@ public:
     }
 
     void send(std::string_view data) override {
-        conn_->send_binary(std::vector<char>(data.begin(), data.end()));
+        conn_->send_binary(data);
     }
 
     void send_text(const std::string& text) override {
@@ -102,6 +99,39 @@ private:
     WsConnectionPtr conn_;
 };
 
+// KcpConnection 适配器：可靠 UDP 会话，send_text 与二进制一样按消息发送
+class KcpConnectionAdapter : public IConnection {
+public:
+    explicit KcpConnectionAdapter(KcpConnectionPtr conn) : conn_(conn) {}
+
+    int native_handle() const override {
+        return conn_->native_handle();
+    }
+
+    void send(const std::vector<char>& data) override {
+        conn_->send(data);
+    }
+
+    void send(std::string_view data) override {
+        conn_->send(data);
+    }
+
+    void send_text(const std::string& text) override {
+        conn_->send(std::string_view(text.data(), text.size()));
+    }
+
+    void close() override {
+        conn_->close();
+    }
+
+    std::string type() const override {
+        return "kcp";
+    }
+
+private:
+    KcpConnectionPtr conn_;
+};
+
 // 通用连接指针类型
 typedef std::shared_ptr<IConnection> ConnectionPtr;
 
@@ -115,5 +145,10 @@ inline ConnectionPtr make_connection(WsConnectionPtr conn) {
     return std::make_shared<WsConnectionAdapter>(conn);
 }
 
+// 工厂函数：从 KcpConnection 创建 IConnection
+inline ConnectionPtr make_connection(KcpConnectionPtr conn) {
+    return std::make_shared<KcpConnectionAdapter>(conn);
+}
+
 } // namespace net
 } // namespace chwell
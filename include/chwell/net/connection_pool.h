@@ -1,16 +1,17 @@
 #pragma once
 
 #include <vector>
-#include <queue>
+#include <deque>
 #include <memory>
 #include <mutex>
-#include <condition_variable>
 #include <functional>
 #include <chrono>
 #include <atomic>
 #include <unordered_map>
-#include <thread>
+#include <utility>
 
+#include "chwell/net/connector.h"
+#include "chwell/net/event_loop.h"
 #include "chwell/net/posix_io.h"
 #include "chwell/net/tcp_connection.h"
 #include "chwell/core/logger.h"
@@ -22,16 +23,18 @@ namespace net {
 struct ConnectionPoolConfig {
     std::string host;
     unsigned short port;
-    int min_connections;        // 最小连接数
+    int min_connections;        // 最小连接数（后台预热并保持）
     int max_connections;        // 最大连接数
-    int connect_timeout_ms;     // 连接超时（毫秒）
+    int connect_timeout_ms;     // 连接超时（毫秒），由事件循环计时，不阻塞调用方
     int idle_timeout_ms;        // 空闲超时（毫秒）
     int max_lifetime_ms;        // 最大生命周期（毫秒），0表示无限
+    int health_check_interval_ms;  // 后台健康检查间隔（毫秒），0 表示关闭
+    EjectionPolicy ejection;    // 连续建连失败后的摘除与指数退避
     
     ConnectionPoolConfig()
         : port(0), min_connections(2), max_connections(10),
           connect_timeout_ms(5000), idle_timeout_ms(300000),
-          max_lifetime_ms(0) {}
+          max_lifetime_ms(0), health_check_interval_ms(5000) {}
 };
 
 // 池化的连接
@@ -54,73 +57,110 @@ struct PooledConnection {
 };
 
 // 连接池
+// - 建连全部在事件循环上以非阻塞 connect 完成（Connector），获取连接从不在调用线程等待网络
+// - init() 后台预热 min_connections 个连接，健康检查定时补齐、剔除对端已关闭或过期的空闲连接
+// - 连续建连失败达到阈值后摘除后端：摘除期间获取连接立即失败，按指数退避放行一次试探连接
+// 池化的连接为阻塞模式 TcpConnection，供调用方同步读写
 class ConnectionPool : public std::enable_shared_from_this<ConnectionPool> {
 public:
     using Ptr = std::shared_ptr<ConnectionPool>;
     using ConnectionCallback = std::function<void(const PooledConnection&)>;
     
-    // 创建连接池
+    // 创建连接池：建连与健康检查在所有连接池共用的后台 loop 线程上执行
     static Ptr create(IoService& io_service, const ConnectionPoolConfig& config) {
         return Ptr(new ConnectionPool(io_service, config));
     }
+
+    // 创建连接池：建连与健康检查在调用方提供的 loop 上执行（loop 需在连接池之前启动、之后退出）
+    static Ptr create(EventLoop* loop, const ConnectionPoolConfig& config) {
+        return Ptr(new ConnectionPool(loop, config));
+    }
     
     ~ConnectionPool();
     
-    // 初始化连接池（创建最小连接数）
+    // 初始化连接池：校验地址并在后台预热 min_connections 个连接，不等待建连完成
     bool init();
     
     // 关闭连接池
     void shutdown();
     
     // 获取连接（异步）
-    // callback: 获取成功或失败的回调
-    // timeout_ms: 等待超时，-1表示无限等待
+    // callback: 获取成功或失败的回调；有空闲连接或立即失败时在调用线程执行，
+    //           排队等待时在连接池的 loop 线程（建连完成 / 超时）或归还连接的线程执行
+    // timeout_ms: 等待超时，-1表示无限等待，0 表示没有空闲连接时立即失败（仍会在后台补充连接）
     void get_connection(ConnectionCallback callback, int timeout_ms = 5000);
     
-    // 获取连接（同步，阻塞）
-    // 返回空指针表示失败
+    // 获取连接（同步，阻塞至多 timeout_ms）
+    // 返回空指针表示失败；不可在连接池的 loop 线程调用
     PooledConnection get_connection_sync(int timeout_ms = 5000);
     
-    // 归还连接
+    // 归还连接；调用方发现连接出错时先把 conn.is_valid 置为 false，连接池即关闭并补充
     void return_connection(PooledConnection& conn);
     
     // 获取统计信息
     int total_connections() const;
     int idle_connections() const;
     int active_connections() const;
+    // 正在建立的连接数
+    int pending_connections() const;
+    // 后端是否可用（未因连续建连失败被摘除）
+    bool healthy() const;
     
     // 获取配置
     const ConnectionPoolConfig& config() const { return config_; }
     
 private:
     ConnectionPool(IoService& io_service, const ConnectionPoolConfig& config);
-    
-    // 创建新连接
-    bool create_connection(PooledConnection& conn);
-    
-    // 检查连接有效性
+    ConnectionPool(EventLoop* loop, const ConnectionPoolConfig& config);
+
+    struct Waiter {
+        ConnectionCallback callback;
+        int64_t deadline;  // -1 表示无限等待
+    };
+
+    // loop 上的定时器，由 loop 线程持有和销毁
+    struct LoopTimers {
+        LoopTimer health;
+        LoopTimer waiters;
+    };
+    
+    // 以下 *_locked 需持有 mutex_
+    // 按预热目标与等待者数量补充连接
+    void maybe_expand_locked();
+    void start_connect_locked();
+    // 建连完成（loop 线程）
+    void on_connected(TcpSocket socket, int err);
+    
+    // 检查连接有效性（生命周期、空闲超时、对端是否已关闭）
     bool validate_connection(PooledConnection& conn);
     
     // 清理过期连接
     void cleanup_expired();
     
-    // 检查并扩容
-    void maybe_expand();
-    
     // 尝试获取空闲连接
     bool try_get_idle(PooledConnection& conn);
+
+    // 把空闲连接交给排队的等待者，返回待执行的回调
+    void hand_to_waiters_locked(std::vector<std::pair<ConnectionCallback, PooledConnection>>& ready);
+
+    // 定时器（loop 线程）
+    void schedule_health_check();
+    void run_health_check();
+    void arm_waiter_timer();
+    void expire_waiters();
     
-    IoService& io_service_;
     ConnectionPoolConfig config_;
+    EventLoop* loop_;
+    std::shared_ptr<LoopTimers> timers_;
     
     mutable std::mutex mutex_;
-    std::condition_variable cv_;
     
     std::vector<std::unique_ptr<PooledConnection>> connections_;
-    std::queue<ConnectionCallback> waiting_callbacks_;
+    std::deque<Waiter> waiters_;
+    int pending_creates_{0};  // 正在创建的连接数
+    BackendHealth health_;
     
     std::atomic<bool> shutdown_;
-    std::atomic<int> pending_creates_;  // 正在创建的连接数
 };
 
 // 连接池管理器：管理多个目标地址的连接池
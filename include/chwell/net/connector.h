@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "chwell/net/loop_timer.h"
+#include "chwell/net/posix_io.h"
+
+namespace chwell {
+namespace net {
+
+class EventLoop;
+
+// Connector：在 EventLoop 上发起非阻塞 connect
+// - socket 以非阻塞模式 connect，EINPROGRESS 后注册可写事件，就绪时以 SO_ERROR 判定结果
+// - 超时由 loop 时间轮触发（精度为 loop 的 tick），不会阻塞任何线程等待内核 SYN 重传
+// - 回调在 loop 线程执行且恰好一次（不会在 start() / cancel() 内执行，调用方可持锁调用）：
+//   成功时 err 为 0、socket 为已连接的非阻塞 socket；失败时 err 为 errno（超时 ETIMEDOUT，取消 ECANCELED），socket 为空
+class Connector : public std::enable_shared_from_this<Connector> {
+public:
+    typedef std::function<void(TcpSocket socket, int err)> Callback;
+
+    // 可跨线程调用；timeout_ms <= 0 表示不设超时（仍受内核 SYN 超时限制）
+    static std::shared_ptr<Connector> start(EventLoop* loop, const std::string& host,
+                                            unsigned short port, int timeout_ms, Callback cb);
+
+    // 放弃连接（可跨线程调用）；尚未完成时回调以 ECANCELED 执行
+    void cancel();
+
+    EventLoop* loop() const { return loop_; }
+    const std::string& host() const { return host_; }
+    unsigned short port() const { return port_; }
+
+    Connector(const Connector&) = delete;
+    Connector& operator=(const Connector&) = delete;
+
+private:
+    Connector(EventLoop* loop, const std::string& host, unsigned short port,
+              int timeout_ms, Callback cb);
+
+    // 以下仅在 loop 线程调用
+    void connect_in_loop();
+    void handle_writable();
+    void finish(int err);
+
+    EventLoop* loop_;
+    std::string host_;
+    unsigned short port_;
+    int timeout_ms_;
+    Callback cb_;
+    TcpSocket socket_;
+    bool registered_{false};
+    bool done_{false};
+    LoopTimer timer_;
+    std::shared_ptr<Connector> self_;  // 未完成期间保持存活
+};
+
+typedef std::shared_ptr<Connector> ConnectorPtr;
+
+// 后端健康状态：连续失败 eject_after_failures 次后摘除，摘除时长从 backoff_initial_ms
+// 起按次翻倍直到 backoff_max_ms；摘除到期后放行一次试探，成功即恢复，失败则继续退避。
+// 非线程安全，由使用方加锁
+struct EjectionPolicy {
+    int eject_after_failures;
+    int backoff_initial_ms;
+    int backoff_max_ms;
+
+    EjectionPolicy()
+        : eject_after_failures(3), backoff_initial_ms(500), backoff_max_ms(30000) {}
+};
+
+class BackendHealth {
+public:
+    explicit BackendHealth(const EjectionPolicy& policy = EjectionPolicy()) : policy_(policy) {}
+
+    // 当前是否允许向该后端发起连接（未摘除，或摘除已到期可试探）
+    bool available(std::int64_t now_ms) const { return now_ms >= retry_at_ms_; }
+    bool ejected(std::int64_t now_ms) const { return !available(now_ms); }
+
+    // 发起连接前调用：未摘除时返回 true；摘除到期时放行一次试探并把下一次试探推迟一个退避周期，
+    // 试探结果出来之前的其他调用方仍视为摘除
+    bool allow(std::int64_t now_ms);
+
+    void on_success();
+    void on_failure(std::int64_t now_ms);
+
+    // 是否已达到摘除阈值（摘除到期后的试探期间仍为 true，直到一次成功）
+    bool tripped() const { return failures_ >= policy_.eject_after_failures; }
+    int consecutive_failures() const { return failures_; }
+    // 允许下一次试探的时间（未摘除时为 0）
+    std::int64_t retry_at_ms() const { return retry_at_ms_; }
+
+    const EjectionPolicy& policy() const { return policy_; }
+
+private:
+    EjectionPolicy policy_;
+    int failures_{0};
+    int backoff_ms_{0};
+    std::int64_t retry_at_ms_{0};
+};
+
+} // namespace net
+} // namespace chwell
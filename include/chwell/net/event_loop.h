@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <unordered_map>
+
+#include <sys/epoll.h>
+#include <sys/types.h>
+
+#include "chwell/net/buffer.h"
+#include "chwell/net/poller.h"
+#include "chwell/net/loop_timer.h"
+
+namespace chwell {
+namespace net {
+
+class TcpConnection;
+
+// EventLoop：单线程反应堆（one loop per thread），后端为 epoll 或 io_uring（见 poller.h）
+// - 每个 EventLoop 只在创建它的线程中运行 loop()，fd 的注册/修改/移除也只能在该线程调用
+// - 其他线程通过 run_in_loop / queue_in_loop 投递任务，由 eventfd 唤醒
+// - 连接的读写就绪由 loop 统一分发，一个线程即可承载大量连接
+// - 每个 loop 持有一个分层时间轮（精度 kTimerTickMs），poll 超时按最近的到期时间计算
+// - 开启发送合并（cork）的连接在 tick 边界由 loop 统一写出，见 set_cork_tick_ms
+class EventLoop {
+public:
+    typedef std::function<void()> Functor;
+    // 参数为 epoll 语义的事件位（EPOLLIN / EPOLLOUT / EPOLLERR ...）
+    typedef std::function<void(std::uint32_t events)> EventHandler;
+    // 完成式接收回调：n > 0 时 data 指向本次收到的数据（仅在回调返回前有效），
+    // n == 0 为对端关闭，n < 0 为 -errno
+    typedef std::function<void(const char* data, ssize_t n)> RecvHandler;
+
+    explicit EventLoop(IoBackend backend = default_io_backend());
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // 运行事件循环，直到 quit()；必须在创建该对象的线程调用
+    void loop();
+    // 请求退出（可跨线程调用）
+    void quit();
+
+    // 在 loop 线程执行：当前即 loop 线程则立即执行，否则入队并唤醒
+    void run_in_loop(Functor cb);
+    // 总是入队，在本轮事件处理完成后执行
+    void queue_in_loop(Functor cb);
+
+    bool is_in_loop_thread() const {
+        return thread_id_ == std::this_thread::get_id();
+    }
+
+    // loop() 是否正在运行（退出后投递的任务不会再被执行）
+    bool looping() const { return looping_; }
+
+    // fd 管理（仅 loop 线程调用）
+    void add_fd(int fd, std::uint32_t events, EventHandler handler);
+    void modify_fd(int fd, std::uint32_t events);
+    void remove_fd(int fd);
+
+    // 完成式接收（仅 io_uring 后端支持，调用前先检查 supports_recv()；仅 loop 线程调用）
+    // 由内核持续把数据收进共享缓冲环后回调，省去就绪通知 + read 的两次往返。
+    // pause_recv 之后，已完成但尚未分发的数据仍会交付一次
+    bool supports_recv() const { return poller_ && poller_->supports_recv(); }
+    bool add_recv(int fd, RecvHandler handler);
+    void pause_recv(int fd);
+    void resume_recv(int fd);
+    void remove_recv(int fd);
+
+    // 定时器（仅 loop 线程调用）：timers().schedule(&timer, now_ms(), delay_ms)，到期回调在 loop 线程执行
+    LoopTimerWheel& timers() { return timers_; }
+    // 本轮 poll 返回时的单调时钟毫秒数（可跨线程读取）；连接记录活跃时间时使用，省去每次取时钟
+    std::int64_t now_ms() const { return now_ms_.load(std::memory_order_relaxed); }
+
+    // 发送合并：开启 cork 的连接（TcpConnection::set_cork）发送时只入队并登记到所属 loop，
+    // loop 在 tick 边界对每个登记过的连接做一次 writev，一个 tick 内的多个小帧合并为少量 TCP 段。
+    // tick 边界按单调时钟对齐到 ms 的整数倍（各 loop、各连接一致）；0 表示每轮事件处理结束即写出。
+    // 可跨线程设置，下一次登记时生效
+    void set_cork_tick_ms(int ms) { cork_tick_ms_.store(ms > 0 ? ms : 0, std::memory_order_relaxed); }
+    int cork_tick_ms() const { return cork_tick_ms_.load(std::memory_order_relaxed); }
+    // 立即结束当前 tick：写出所有已登记连接的暂存数据（可跨线程调用，在 loop 线程执行）；
+    // 业务的一帧逻辑处理完时调用即可不等 tick 边界
+    void flush_corked();
+
+    // 低内存模式连接（TcpConnection::set_low_memory）的读缓冲池（仅 loop 线程调用）：
+    // 连接只在一次读事件期间借用，交付后归还；同一时刻只有正在读的连接占用缓冲，池通常只有一块
+    Buffer* acquire_read_buffer();
+    void release_read_buffer(Buffer* buffer);
+
+    // 实际使用的后端（首选 io_uring 但不可用时为 epoll）
+    IoBackend backend() const { return poller_ ? poller_->backend() : IoBackend::kEpoll; }
+
+    // 当前注册的 fd 数（不含内部唤醒 fd）
+    std::size_t fd_count() const { return handlers_.size(); }
+
+private:
+    friend class TcpConnection;
+
+    void wakeup();
+    void handle_wakeup();
+    void do_pending_functors();
+    void dispatch(const IoEvent& ev);
+    void update_now();
+    // 登记有暂存输出的 cork 连接（任意线程，由 TcpConnection 调用）
+    void add_corked(std::shared_ptr<TcpConnection> conn);
+    // 写出所有已登记连接（仅 loop 线程）
+    void flush_corked_now();
+    // 距下一个 cork tick 边界的毫秒数，没有登记的连接时返回 -1
+    int cork_timeout_ms() const;
+
+    std::unique_ptr<Poller> poller_;
+    int wakeup_fd_{-1};
+    const std::thread::id thread_id_;
+    std::atomic<bool> quit_{false};
+    std::atomic<bool> looping_{false};
+    std::atomic<bool> calling_pending_{false};
+
+    LoopTimerWheel timers_;
+    std::atomic<std::int64_t> now_ms_{0};
+
+    std::atomic<int> cork_tick_ms_{0};
+    // 待写出连接的截止时间（-1 表示没有登记的连接）；在 mutex_ 内写，loop 线程计算超时时无锁读取
+    std::atomic<std::int64_t> cork_deadline_{-1};
+    std::vector<std::shared_ptr<TcpConnection>> corked_;  // 受 mutex_ 保护
+
+    std::vector<std::unique_ptr<Buffer>> read_buffers_;   // 空闲的借用读缓冲
+
+    std::vector<IoEvent> active_events_;
+    std::unordered_map<int, EventHandler> handlers_;
+    std::unordered_map<int, RecvHandler> recv_handlers_;
+    // 本轮分发中被移除的 handler 延后析构，避免回调执行期间销毁自身
+    std::vector<EventHandler> retired_handlers_;
+    std::vector<RecvHandler> retired_recv_handlers_;
+
+    std::mutex mutex_;
+    std::vector<Functor> pending_functors_;
+};
+
+// EventLoopThreadPool：N 个 I/O 线程，每个线程运行一个 EventLoop
+// 新连接按轮询分配到各个 loop，之后该连接的所有 I/O 都在所属 loop 线程完成
+class EventLoopThreadPool {
+public:
+    explicit EventLoopThreadPool(std::size_t num_threads);
+    ~EventLoopThreadPool();
+
+    EventLoopThreadPool(const EventLoopThreadPool&) = delete;
+    EventLoopThreadPool& operator=(const EventLoopThreadPool&) = delete;
+
+    // 各 loop 使用的后端，需在 start() 之前设置；默认取 default_io_backend()
+    void set_backend(IoBackend backend) { backend_ = backend; }
+    IoBackend backend() const { return backend_; }
+
+    // 启动所有 I/O 线程，返回前每个 loop 均已创建完成
+    void start();
+    // 退出所有 loop 并等待线程结束；loop 对象保留到析构，迟到的投递不会悬空
+    void stop();
+
+    bool started() const { return started_; }
+    std::size_t size() const { return num_threads_; }
+
+    // 轮询选择下一个 loop（start() 之后调用）
+    EventLoop* next_loop();
+    EventLoop* get_loop(std::size_t index) const;
+
+private:
+    std::size_t num_threads_;
+    IoBackend backend_;
+    std::vector<std::unique_ptr<EventLoop>> loops_;
+    std::vector<std::thread> threads_;
+    std::atomic<std::size_t> next_{0};
+    std::atomic<bool> started_{false};
+};
+
+} // namespace net
+} // namespace chwell
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace chwell {
+namespace net {
+
+// 只读打开的文件，引用计数共享；最后一个引用释放时关闭 fd
+// 静态文件缓存与各连接输出缓冲中待 sendfile 的区间共用同一句柄，文件被替换后旧句柄仍指向旧内容
+class SharedFile {
+public:
+    ~SharedFile();
+    SharedFile(const SharedFile&) = delete;
+    SharedFile& operator=(const SharedFile&) = delete;
+
+    // 打开普通文件，失败（不存在 / 非普通文件 / 无权限）返回 nullptr，errno 保留
+    static std::shared_ptr<SharedFile> open(const std::string& path);
+
+    int fd() const { return fd_; }
+    std::uint64_t size() const { return size_; }
+    std::int64_t mtime_ns() const { return mtime_ns_; }
+
+private:
+    SharedFile(int fd, std::uint64_t size, std::int64_t mtime_ns)
+        : fd_(fd), size_(size), mtime_ns_(mtime_ns) {}
+
+    int fd_;
+    std::uint64_t size_;
+    std::int64_t mtime_ns_;
+};
+
+typedef std::shared_ptr<SharedFile> SharedFilePtr;
+
+// 文件中的一段字节，作为 TcpConnection::send_file 的数据源
+struct FileRegion {
+    SharedFilePtr file;
+    std::uint64_t offset{0};
+    std::uint64_t length{0};
+
+    FileRegion() {}
+    FileRegion(const SharedFilePtr& f, std::uint64_t off, std::uint64_t len)
+        : file(f), offset(off), length(len) {}
+
+    bool empty() const { return !file || length == 0; }
+};
+
+// 从 region 当前位置读出至多 max_bytes 追加到 *out（TLS / 阻塞连接无法 sendfile 时使用），返回读到的字节数
+std::size_t read_file_region(const FileRegion& region, std::size_t max_bytes, std::string* out);
+
+} // namespace net
+} // namespace chwell
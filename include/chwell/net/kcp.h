@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace chwell {
+namespace net {
+
+// KCP 会话参数
+struct KcpConfig {
+    bool nodelay;               // 无延迟模式：最小 RTO 30ms，超时 RTO 按 1.5 倍而非 2 倍退避
+    int interval_ms;            // 内部刷新间隔（重传检查、ACK 合并发送）
+    int fast_resend;            // 被跨越多少次 ACK 即快速重传（0 关闭）
+    bool no_congestion_window;  // 关闭拥塞窗口，只受收发窗口限制
+    std::uint32_t send_window;  // 发送窗口（分片数）
+    std::uint32_t recv_window;  // 接收窗口（分片数），也是单条消息的最大分片数上限
+    std::uint32_t mtu;          // 单个数据报上限（含 24 字节段头）
+    std::uint32_t dead_link;    // 同一分片重传达到该次数视为链路断开
+    int idle_timeout_ms;        // 超过该时长未收到对端数据即断开（0 不检查）
+    std::size_t max_sessions;           // 服务端会话总数上限，超出后未知会话的数据报直接丢弃（0 不限）
+    std::size_t max_sessions_per_addr;  // 同一对端 IP 的会话上限（同 NAT 后的玩家共用 IP，不宜过小；0 不限）
+
+    KcpConfig()
+        : nodelay(false),
+          interval_ms(40),
+          fast_resend(0),
+          no_congestion_window(false),
+          send_window(32),
+          recv_window(128),
+          mtu(1400),
+          dead_link(20),
+          idle_timeout_ms(30000),
+          max_sessions(10000),
+          max_sessions_per_addr(256) {}
+
+    // 帧同步 / 动作类游戏常用的低延迟组合：nodelay + 10ms 刷新 + 2 次 ACK 跨越快速重传 + 关闭拥塞控制
+    static KcpConfig fast() {
+        KcpConfig config;
+        config.nodelay = true;
+        config.interval_ms = 10;
+        config.fast_resend = 2;
+        config.no_congestion_window = true;
+        config.send_window = 128;
+        config.recv_window = 128;
+        return config;
+    }
+};
+
+// KcpSession：KCP 协议的 ARQ 状态机（线格式与 ikcp 兼容，客户端可直接使用 ikcp / kcp-go 等实现）
+// - 不做 I/O：send 把消息切片入队，input 处理对端数据报，update / flush 按时钟推进并
+//   经 OutputCallback 输出合并到 mtu 以内的数据报
+// - 每个分片单独确认（选择性 ACK），同时携带累计确认 una；被后续 ACK 跨越 fast_resend 次
+//   的分片不等 RTO 立即重传
+// - 非线程安全，由持有者加锁
+class KcpSession {
+public:
+    // 段头长度：conv(4) cmd(1) frg(1) wnd(2) ts(4) sn(4) una(4) len(4)，小端
+    static const std::size_t kHeaderSize = 24;
+
+    typedef std::function<void(std::string_view datagram)> OutputCallback;
+
+    KcpSession(std::uint32_t conv, const KcpConfig& config, OutputCallback output);
+
+    KcpSession(const KcpSession&) = delete;
+    KcpSession& operator=(const KcpSession&) = delete;
+
+    std::uint32_t conv() const { return conv_; }
+
+    // 消息入队，返回 0；消息为空返回 -1，分片数超过接收窗口返回 -2
+    int send(std::string_view data);
+
+    // 处理对端数据报，返回 0；长度不足 / conv 不符返回 -1，段长度越界返回 -2，未知命令返回 -3
+    int input(std::string_view datagram, std::uint32_t now_ms);
+
+    // 取出一条完整消息到 *out，没有完整消息时返回 false
+    bool recv(std::string* out);
+
+    // 下一条完整消息的长度，没有时返回 -1
+    int peek_size() const;
+
+    // 按 interval_ms 节拍推进：到刷新时刻才 flush
+    void update(std::uint32_t now_ms);
+
+    // 立即输出待发 ACK、窗口探测、新数据与到期 / 快速重传的分片
+    void flush(std::uint32_t now_ms);
+
+    // 已发送未确认 + 尚未发送的分片数
+    std::size_t pending_segments() const { return snd_buf_.size() + snd_queue_.size(); }
+
+    // 有分片重传达到 dead_link 次
+    bool dead() const { return dead_; }
+
+    std::uint32_t rto_ms() const { return rx_rto_; }
+    std::uint64_t retransmits() const { return retransmits_; }
+    std::uint64_t fast_retransmits() const { return fast_retransmits_; }
+
+    // 读取数据报中的 conv，长度不足时返回 0
+    static std::uint32_t read_conv(std::string_view datagram);
+
+private:
+    struct Segment {
+        std::uint32_t conv{0};
+        std::uint8_t cmd{0};
+        std::uint8_t frg{0};
+        std::uint16_t wnd{0};
+        std::uint32_t ts{0};
+        std::uint32_t sn{0};
+        std::uint32_t una{0};
+        std::uint32_t resendts{0};
+        std::uint32_t rto{0};
+        std::uint32_t fastack{0};
+        std::uint32_t xmit{0};
+        std::string data;
+    };
+
+    void update_rtt(std::int32_t rtt);
+    void shrink_buf();
+    void parse_ack(std::uint32_t sn);
+    void parse_una(std::uint32_t una);
+    void parse_fastack(std::uint32_t sn);
+    void parse_data(Segment&& seg);
+    std::uint16_t window_unused() const;
+
+    void emit(const Segment& seg, std::string_view payload);
+    void flush_output();
+
+    std::uint32_t conv_;
+    std::uint32_t mtu_;
+    std::uint32_t mss_;
+    std::uint32_t snd_una_{0};
+    std::uint32_t snd_nxt_{0};
+    std::uint32_t rcv_nxt_{0};
+    std::uint32_t ssthresh_;
+    std::int32_t rx_rttval_{0};
+    std::int32_t rx_srtt_{0};
+    std::uint32_t rx_rto_;
+    std::uint32_t rx_minrto_;
+    std::uint32_t snd_wnd_;
+    std::uint32_t rcv_wnd_;
+    std::uint32_t rmt_wnd_;
+    std::uint32_t cwnd_{1};
+    std::uint32_t incr_{0};
+    std::uint32_t probe_{0};
+    std::uint32_t current_{0};
+    std::uint32_t interval_;
+    std::uint32_t ts_flush_;
+    std::uint32_t ts_probe_{0};
+    std::uint32_t probe_wait_{0};
+    std::uint32_t dead_link_;
+    std::uint32_t fast_resend_;
+    bool nodelay_;
+    bool no_cwnd_;
+    bool updated_{false};
+    bool dead_{false};
+
+    std::deque<Segment> snd_queue_;
+    std::deque<Segment> snd_buf_;
+    std::deque<Segment> rcv_buf_;
+    std::deque<Segment> rcv_queue_;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> acklist_;  // (sn, ts)
+    std::string output_;  // 当前正在拼装的数据报
+
+    std::uint64_t retransmits_{0};
+    std::uint64_t fast_retransmits_{0};
+
+    OutputCallback output_cb_;
+};
+
+} // namespace net
+} // namespace chwell
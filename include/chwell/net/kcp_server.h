@@ -0,0 +1,190 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "chwell/net/kcp.h"
+#include "chwell/net/posix_io.h"
+#include "chwell/net/udp_server.h"
+
+namespace chwell {
+namespace net {
+
+class KcpConnection;
+class KcpServer;
+
+typedef std::shared_ptr<KcpConnection> KcpConnectionPtr;
+// data 指向连接内部的消息缓冲，仅在回调返回前有效（与 TcpConnection 的 MessageCallback 一致）
+typedef std::function<void(const KcpConnectionPtr&, std::string_view)> KcpMessageCallback;
+typedef std::function<void(const KcpConnectionPtr&)> KcpConnectionCallback;
+
+// 链路劣化注入（测试用）：对本端发出的数据报按概率丢弃、附加固定延迟与随机抖动，
+// 两端各自开启即得到双向有损链路；延迟的数据报在刷新节拍上释放（精度为 interval_ms）
+struct LinkImpairment {
+    double loss_rate;     // 丢弃概率 [0, 1)
+    int latency_ms;       // 固定单向延迟
+    int jitter_ms;        // 额外随机延迟 [0, jitter_ms]
+    unsigned int seed;    // 随机种子，便于复现
+
+    LinkImpairment() : loss_rate(0.0), latency_ms(0), jitter_ms(0), seed(1) {}
+};
+
+// KCP 会话连接：可靠、有序、面向消息，用法对齐 TcpConnection
+// - send() 可在任意线程调用；nodelay 模式下立即 flush，否则等下一个刷新节拍
+// - 消息 / 断开回调都在 KcpServer 的接收线程执行
+// - close() 之后不再收发，连接在下一个节拍从服务器移除并触发断开回调
+class KcpConnection : public std::enable_shared_from_this<KcpConnection> {
+public:
+    KcpConnection(KcpServer* server, std::uint32_t conv, const UdpEndpoint& remote,
+                  const KcpConfig& config);
+
+    void send(std::string_view data);
+    void send(const std::vector<char>& data) {
+        send(std::string_view(data.data(), data.size()));
+    }
+    void close();
+
+    std::uint32_t conv() const { return conv_; }
+    const UdpEndpoint& remote() const { return remote_; }
+    bool closed() const { return closed_; }
+    // 会话号作为句柄（KCP 会话不独占 fd）
+    int native_handle() const { return static_cast<int>(conv_); }
+
+    // 发送方向尚未被确认的分片数
+    std::size_t pending_segments() const;
+    std::uint64_t retransmits() const;
+    std::uint64_t fast_retransmits() const;
+
+private:
+    friend class KcpServer;
+
+    // 以下由 KcpServer 在接收线程调用
+    bool input(std::string_view datagram, std::uint32_t now_ms);
+    void deliver(const KcpMessageCallback& cb);
+    void flush(std::uint32_t now_ms);
+    void update(std::uint32_t now_ms);
+    bool expired(std::uint32_t now_ms) const;
+
+    KcpServer* server_;
+    const std::uint32_t conv_;
+    const UdpEndpoint remote_;
+    const bool nodelay_;
+    const int idle_timeout_ms_;
+    mutable std::mutex mutex_;
+    KcpSession session_;
+    std::string message_;          // 交付给回调的消息缓冲，按连接复用
+    std::uint32_t last_recv_ms_{0};
+    bool flush_pending_{false};
+    std::atomic<bool> closed_{false};
+};
+
+// KcpServer：在 UdpServer 之上按 (conv, 对端地址) 复用多个 KCP 会话
+// - 收包走 UdpServer 的批量回调：整批 input 后再统一 flush，同一批内的 ACK 合并发出
+// - 重传、ACK 刷新、空闲 / 死链检测由 UdpServer 的周期回调按 interval_ms 驱动
+// - 未知会话的首个合法数据报即建立会话（服务端）；connect() 主动建立会话（客户端），
+//   因此同一个 KcpServer 绑定端口 0 即可作为客户端使用
+// - 建立会话受 KcpConfig::max_sessions / max_sessions_per_addr 限制，防止伪造 conv 的数据报洪泛
+//   占满会话表（超出的数据报丢弃并计入 chwell_net_kcp_sessions_rejected_total）
+class KcpServer {
+public:
+    KcpServer(IoService& io_service, unsigned short port, const KcpConfig& config = KcpConfig());
+    ~KcpServer();
+
+    KcpServer(const KcpServer&) = delete;
+    KcpServer& operator=(const KcpServer&) = delete;
+
+    // 需在 start() 之前设置
+    void set_connection_callback(const KcpConnectionCallback& cb) { connection_cb_ = cb; }
+    void set_disconnect_callback(const KcpConnectionCallback& cb) { disconnect_cb_ = cb; }
+    void set_message_callback(const KcpMessageCallback& cb) { message_cb_ = cb; }
+    // 是否接受未知会话的数据报（纯客户端可关闭），默认开启
+    void set_accept_sessions(bool accept) { accept_sessions_ = accept; }
+    void set_impairment(const LinkImpairment& impairment);
+
+    void start();
+    void stop();
+
+    // 以 conv 向 remote 建立会话（不触发连接回调）
+    KcpConnectionPtr connect(const UdpEndpoint& remote, std::uint32_t conv);
+
+    const KcpConfig& config() const { return config_; }
+    unsigned short port() const { return udp_.port(); }
+    std::size_t connection_count() const;
+
+private:
+    friend class KcpConnection;
+
+    struct SessionKey {
+        std::uint32_t conv;
+        std::uint32_t addr;
+        std::uint16_t port;
+
+        bool operator==(const SessionKey& other) const {
+            return conv == other.conv && addr == other.addr && port == other.port;
+        }
+    };
+
+    struct SessionKeyHash {
+        std::size_t operator()(const SessionKey& key) const {
+            std::uint64_t v = (static_cast<std::uint64_t>(key.addr) << 16) ^ key.port;
+            return std::hash<std::uint64_t>()(v * 0x9e3779b97f4a7c15ULL ^ key.conv);
+        }
+    };
+
+    struct DelayedDatagram {
+        std::uint32_t due_ms;
+        std::string data;
+        UdpEndpoint remote;
+    };
+
+    static SessionKey make_key(std::uint32_t conv, const UdpEndpoint& remote);
+
+    // 以下需持有 mutex_：维护会话表与按对端 IP 的会话计数
+    bool admit_session_locked(const SessionKey& key) const;
+    void insert_session_locked(const SessionKey& key, const KcpConnectionPtr& conn);
+    void erase_session_locked(const SessionKey& key);
+
+    void handle_batch(const std::vector<UdpDatagram>& batch);
+    void handle_tick();
+    // 会话输出：经链路劣化（如有）后发出
+    void transmit(std::string_view datagram, const UdpEndpoint& remote);
+    void release_delayed(std::uint32_t now_ms);
+
+    KcpConfig config_;
+    UdpServer udp_;
+    bool accept_sessions_{true};
+
+    mutable std::mutex mutex_;
+    std::unordered_map<SessionKey, KcpConnectionPtr, SessionKeyHash> connections_;
+    std::unordered_map<std::uint32_t, std::size_t> sessions_per_addr_;
+
+    // 以下仅接收线程访问
+    std::vector<KcpConnectionPtr> touched_;
+    std::vector<KcpConnectionPtr> snapshot_;
+
+    std::mutex impairment_mutex_;
+    bool impaired_{false};
+    LinkImpairment impairment_;
+    std::mt19937 rng_;
+    std::deque<DelayedDatagram> delayed_;
+
+    KcpConnectionCallback connection_cb_;
+    KcpConnectionCallback disconnect_cb_;
+    KcpMessageCallback message_cb_;
+};
+
+// 当前单调时钟（毫秒，32 位回绕），供 KCP 会话计时
+std::uint32_t kcp_clock_ms();
+
+} // namespace net
+} // namespace chwell
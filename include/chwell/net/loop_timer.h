@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace chwell {
+namespace net {
+
+class LoopTimerWheel;
+
+// 时间轮定时器节点：由使用方持有（如嵌入 TcpConnection），侵入式挂在时间轮槽位链表上，
+// 插入 / 取消 / 重新调度都是 O(1) 且不分配内存。析构时自动从时间轮摘除
+class LoopTimer {
+public:
+    typedef std::function<void()> Callback;
+
+    LoopTimer() {}
+    explicit LoopTimer(Callback cb) : cb_(std::move(cb)) {}
+    ~LoopTimer();
+
+    LoopTimer(const LoopTimer&) = delete;
+    LoopTimer& operator=(const LoopTimer&) = delete;
+
+    void set_callback(Callback cb) { cb_ = std::move(cb); }
+    bool pending() const { return wheel_ != nullptr; }
+
+private:
+    friend class LoopTimerWheel;
+
+    void unlink();
+
+    Callback cb_;
+    LoopTimer* prev_{nullptr};
+    LoopTimer* next_{nullptr};
+    LoopTimerWheel* wheel_{nullptr};
+    std::uint64_t expire_{0};  // 到期 tick
+};
+
+// EventLoop 内置的分层时间轮（4 层：256 + 3 × 64 个槽，逐层级联），非线程安全，由所属 loop 线程独占。
+// 与 core::TimerWheel（独立线程 + 互斥锁 + 按 id 查找）不同，节点侵入式嵌入使用方，
+// 适合每连接一个、频繁重置的超时（空闲检测）
+// tick_ms 为精度：tick 为 100ms 时第 0 层覆盖 25.6 秒，总跨度约 77 天（更远的到期时间按最大值截断）
+class LoopTimerWheel {
+public:
+    explicit LoopTimerWheel(int tick_ms = 100);
+    ~LoopTimerWheel();
+
+    LoopTimerWheel(const LoopTimerWheel&) = delete;
+    LoopTimerWheel& operator=(const LoopTimerWheel&) = delete;
+
+    // 在 delay_ms 之后触发（已挂在时间轮上的定时器先摘除再插入）；now_ms 为调用方的当前时间
+    void schedule(LoopTimer* timer, std::int64_t now_ms, std::int64_t delay_ms);
+    void cancel(LoopTimer* timer);
+
+    // 推进到 now_ms，依次执行所有到期定时器的回调（回调内可重新调度 / 取消任意定时器）
+    void advance(std::int64_t now_ms);
+
+    // 距离下一次需要推进的毫秒数；没有定时器时返回 -1
+    int next_timeout_ms(std::int64_t now_ms) const;
+
+    std::size_t size() const { return count_; }
+    int tick_ms() const { return tick_ms_; }
+
+private:
+    static const int kRootBits = 8;
+    static const int kLevelBits = 6;
+    static const int kRootSize = 1 << kRootBits;
+    static const int kLevelSize = 1 << kLevelBits;
+    static const int kLevels = 3;  // 第 0 层之外的层数
+
+    // 槽位链表头（哨兵节点）
+    struct Slot {
+        LoopTimer head;
+        Slot() { head.prev_ = head.next_ = &head; }
+    };
+
+    std::uint64_t tick_of(std::int64_t now_ms) const;
+    void link(LoopTimer* timer);
+    // 把上层某个槽位中的定时器重新分配到下层
+    void cascade(int level, int index);
+    void run_tick();
+
+    const int tick_ms_;
+    std::int64_t origin_ms_{-1};   // 第一次调度时的时间，tick 从 0 开始计
+    std::uint64_t current_{0};     // 下一个待处理的 tick
+    std::size_t count_{0};
+    Slot root_[kRootSize];
+    Slot levels_[kLevels][kLevelSize];
+};
+
+} // namespace net
+} // namespace chwell
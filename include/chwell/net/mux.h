@@ -0,0 +1,232 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "chwell/net/buffer.h"
+#include "chwell/net/event_loop.h"
+#include "chwell/net/tcp_connection.h"
+#include "chwell/net/tcp_server.h"
+
+namespace chwell {
+namespace net {
+
+// 多路复用链路（网关 ↔ 逻辑服）：少量长连接承载全部玩家会话，逻辑服的 fd 数与建连次数不随玩家数增长
+// 帧格式：| session (4) | type (1) | len (4) | payload (len) |，多字节字段为网络字节序
+// - kData：payload 为该会话的一段完整数据（网关 → 逻辑服为一条协议帧，逻辑服 → 网关原样发给客户端）
+// - kClose：结束会话（无 payload）。网关在客户端断开时发送；逻辑服主动结束时发送，网关清理后回送一次作为确认，
+//   两端都据此释放会话上下文。收到未知会话的 kClose 直接忽略
+namespace mux {
+
+const std::uint8_t kData = 1;
+const std::uint8_t kClose = 2;
+const std::size_t kHeaderSize = 9;
+const std::uint32_t kMaxPayload = 16 * 1024 * 1024;
+// parse_frame 的返回值：帧类型未知或长度超限，链路应关闭
+const std::size_t kInvalidFrame = static_cast<std::size_t>(-1);
+
+struct Frame {
+    std::uint32_t session;
+    std::uint8_t type;
+    std::string_view payload;
+
+    Frame() : session(0), type(0) {}
+};
+
+void encode_header(char* out, std::uint32_t session, std::uint8_t type, std::uint32_t len);
+
+// 在 data 起始处识别一帧：成功写 frame 并返回整帧长度，数据不完整返回 0，非法帧返回 kInvalidFrame
+std::size_t parse_frame(std::string_view data, Frame& frame);
+
+// 在链路上发送一帧：帧头与 payload 聚合写出，payload 不拷贝到中间缓冲
+void send_frame(const TcpConnectionPtr& link, std::uint32_t session, std::uint8_t type,
+                std::string_view payload = std::string_view());
+
+} // namespace mux
+
+// 链路字节流的增量解帧：本次数据中的完整帧直接在输入上解析，只缓存跨调用的残帧（同 protocol::Parser）
+class MuxDecoder {
+public:
+    // 对每个完整帧调用 fn(const mux::Frame&)；payload 仅在 fn 执行期间有效。遇到非法帧返回 false
+    template <typename Fn>
+    bool feed(std::string_view data, Fn&& fn);
+
+    std::size_t buffered_bytes() const { return buffer_.readable_bytes(); }
+
+private:
+    // 补齐缓冲中残帧还需的字节数
+    std::size_t pending_bytes() const;
+
+    Buffer buffer_{0};
+};
+
+template <typename Fn>
+bool MuxDecoder::feed(std::string_view data, Fn&& fn) {
+    mux::Frame frame;
+
+    while (!buffer_.empty() && !data.empty()) {
+        std::size_t take = std::min(pending_bytes(), data.size());
+        buffer_.append(data.data(), take);
+        data.remove_prefix(take);
+        std::size_t frame_len = mux::parse_frame(buffer_.view(), frame);
+        if (frame_len == mux::kInvalidFrame) {
+            return false;
+        }
+        if (frame_len > 0) {
+            fn(static_cast<const mux::Frame&>(frame));
+            buffer_.retrieve(frame_len);
+        }
+    }
+
+    std::size_t frame_len = 0;
+    while ((frame_len = mux::parse_frame(data, frame)) > 0) {
+        if (frame_len == mux::kInvalidFrame) {
+            return false;
+        }
+        fn(static_cast<const mux::Frame&>(frame));
+        data.remove_prefix(frame_len);
+    }
+
+    if (!data.empty()) {
+        buffer_.append(data);
+    }
+    return true;
+}
+
+// 链路写合并：多个会话的帧追加到同一缓冲，攒满 max_batch_bytes 时立即写出，否则在链路所属 loop
+// 本轮事件处理完成后以一次 send 写出，同一轮里读到的各客户端消息合并为一次系统调用。
+// 可跨线程调用；写出在锁内完成，保证同一会话的帧按追加顺序上线。max_batch_bytes 为 0 时逐帧直接写出
+class MuxBatcher : public std::enable_shared_from_this<MuxBatcher> {
+public:
+    static const std::size_t kDefaultBatchBytes = 64 * 1024;
+
+    MuxBatcher(const TcpConnectionPtr& link, std::size_t max_batch_bytes = kDefaultBatchBytes);
+
+    MuxBatcher(const MuxBatcher&) = delete;
+    MuxBatcher& operator=(const MuxBatcher&) = delete;
+
+    void append(std::uint32_t session, std::uint8_t type,
+                std::string_view payload = std::string_view());
+    // 立即写出已合并的帧
+    void flush();
+
+    TcpConnectionPtr link() const { return link_.lock(); }
+
+    // 累计追加的帧数与写出次数（frames / writes 即平均每次写出合并的帧数）
+    std::uint64_t frames() const { return frames_.load(std::memory_order_relaxed); }
+    std::uint64_t writes() const { return writes_.load(std::memory_order_relaxed); }
+
+private:
+    void flush_locked(const TcpConnectionPtr& link);
+
+    std::weak_ptr<TcpConnection> link_;
+    EventLoop* loop_;
+    const std::size_t max_batch_bytes_;
+
+    std::mutex mutex_;
+    std::string batch_;       // 受 mutex_ 保护；写出后保留容量复用
+    bool scheduled_{false};   // 已投递本轮的写出任务
+    std::atomic<std::uint64_t> frames_{0};
+    std::atomic<std::uint64_t> writes_{0};
+};
+
+typedef std::shared_ptr<MuxBatcher> MuxBatcherPtr;
+
+// 逻辑服一侧的会话上下文：代表网关上的一个客户端，回复经所属链路带上会话 id 发回网关
+// （与同一链路上其他会话的回复合并写出，见 MuxBatcher）
+class MuxSession {
+public:
+    MuxSession(std::uint32_t id, const MuxBatcherPtr& batcher, std::uint8_t frame_format = 0)
+        : id_(id), frame_format_(frame_format), batcher_(batcher) {}
+
+    std::uint32_t id() const { return id_; }
+    // 会话数据所用的应用层帧格式（protocol::FrameFormat 的取值），由 MuxServer::set_frame_format 决定
+    std::uint8_t frame_format() const { return frame_format_; }
+
+    // 发送给该会话对应的客户端（可跨线程调用）
+    void send(std::string_view data);
+    void send(const std::vector<char>& data) { send(std::string_view(data.data(), data.size())); }
+
+    // 结束会话：通知网关，之后到达的该会话数据被丢弃
+    void close();
+    bool closed() const { return closed_.load(std::memory_order_acquire); }
+
+    // 所属链路（链路已断开时为空）
+    TcpConnectionPtr link() const {
+        MuxBatcherPtr batcher = batcher_.lock();
+        return batcher ? batcher->link() : TcpConnectionPtr();
+    }
+
+private:
+    friend class MuxServer;
+
+    const std::uint32_t id_;
+    const std::uint8_t frame_format_;
+    std::weak_ptr<MuxBatcher> batcher_;
+    std::atomic<bool> closed_{false};
+};
+
+typedef std::shared_ptr<MuxSession> MuxSessionPtr;
+
+// 逻辑服一侧：接受网关的多路复用链路，把帧按会话 id 分发到各自的 MuxSession
+// 会话在收到第一帧数据时创建；网关结束会话、逻辑服 close() 得到确认或链路断开时回调 close
+// 回调在链路所属 loop 线程执行，同一会话的消息按序到达
+class MuxServer {
+public:
+    typedef std::function<void(const MuxSessionPtr&, std::string_view)> MessageCallback;
+    typedef std::function<void(const MuxSessionPtr&)> SessionCallback;
+
+    MuxServer(EventLoopThreadPool& loops, unsigned short port);
+
+    MuxServer(const MuxServer&) = delete;
+    MuxServer& operator=(const MuxServer&) = delete;
+
+    // 回调需在 start() 之前设置
+    void set_message_callback(const MessageCallback& cb) { message_cb_ = cb; }
+    void set_close_callback(const SessionCallback& cb) { close_cb_ = cb; }
+    // 每条链路回程写合并的阈值（默认 MuxBatcher::kDefaultBatchBytes，0 为逐帧写出），需在 start() 之前设置
+    void set_batch_bytes(std::size_t n) { batch_bytes_ = n; }
+    // 会话数据的应用层帧格式（同 TcpServerConfig::frame_format，默认 0 为旧格式）：网关按客户端连接的格式
+    // 转发、回复原样发回客户端，须与网关前端端口一致。需在 start() 之前设置
+    void set_frame_format(std::uint8_t format) { frame_format_ = format; }
+
+    void start();
+    void stop();
+
+    std::size_t link_count() const;
+    std::size_t session_count() const;
+
+    TcpServer& tcp_server() { return server_; }
+
+private:
+    struct Link {
+        MuxBatcherPtr batcher;
+        MuxDecoder decoder;  // 仅链路所属 loop 线程使用
+        std::unordered_map<std::uint32_t, MuxSessionPtr> sessions;  // 受 mutex_ 保护
+    };
+
+    void on_link_message(const TcpConnectionPtr& conn, std::string_view data);
+    void on_link_close(const TcpConnectionPtr& conn);
+    void handle_frame(Link& link, const mux::Frame& frame);
+
+    TcpServer server_;
+    MessageCallback message_cb_;
+    SessionCallback close_cb_;
+    std::size_t batch_bytes_{MuxBatcher::kDefaultBatchBytes};
+    std::uint8_t frame_format_{0};
+
+    mutable std::mutex mutex_;
+    std::unordered_map<const TcpConnection*, std::shared_ptr<Link>> links_;
+};
+
+} // namespace net
+} // namespace chwell
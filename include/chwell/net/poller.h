@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace chwell {
+namespace net {
+
+// EventLoop 的 I/O 多路复用后端
+enum class IoBackend {
+    kEpoll,   // epoll 就绪通知（默认）
+    kIoUring  // io_uring：多路 poll + 多路 recv（provided buffer ring），内核不支持时回退 epoll
+};
+
+const char* io_backend_name(IoBackend backend);
+// 解析 "epoll" / "io_uring"（或 "uring"），无法识别时返回 fallback
+IoBackend parse_io_backend(const char* name, IoBackend fallback = IoBackend::kEpoll);
+
+// 新建 EventLoop 默认使用的后端：进程级设置，初始值取环境变量 CHWELL_IO_BACKEND
+IoBackend default_io_backend();
+void set_default_io_backend(IoBackend backend);
+
+// 运行时探测：编译时启用 CHWELL_USE_IO_URING 且内核支持所需特性
+bool io_uring_available();
+
+// Poller 产生的事件
+struct IoEvent {
+    enum Kind { kReady, kRecv };
+
+    Kind kind{kReady};
+    int fd{-1};
+    std::uint32_t events{0};      // kReady：EPOLLIN / EPOLLOUT / EPOLLERR ... 位
+    int result{0};                // kRecv：>0 字节数，0 对端关闭，<0 为 -errno
+    const char* data{nullptr};    // kRecv 且 result > 0 时指向后端持有的接收缓冲
+    int buffer_id{-1};            // data 所在缓冲编号，分发后需 release_buffer
+    std::uint32_t token{0};       // 注册标识，用于丢弃 fd 复用后的过期事件
+};
+
+// Poller：EventLoop 内部使用的后端接口，仅在 loop 线程调用
+// fd 就绪语义与 epoll 一致：events 含 EPOLLET 时为边沿触发，否则为水平触发
+class Poller {
+public:
+    virtual ~Poller() {}
+
+    virtual IoBackend backend() const = 0;
+    virtual bool valid() const = 0;
+
+    virtual bool add(int fd, std::uint32_t events) = 0;
+    virtual bool modify(int fd, std::uint32_t events) = 0;
+    virtual void remove(int fd) = 0;
+
+    // 等待事件并追加到 active，返回追加数量；出错返回 -1（errno 有效）
+    virtual int poll(int timeout_ms, std::vector<IoEvent>& active) = 0;
+
+    // 事件在分发时是否仍属于当前注册（本轮早先的回调可能已移除或复用该 fd）
+    virtual bool is_current(const IoEvent& ev) const { (void)ev; return true; }
+
+    // 完成式接收（仅 io_uring 支持）：数据以 kRecv 事件交付，不再需要 read 系统调用
+    virtual bool supports_recv() const { return false; }
+    virtual bool add_recv(int fd) { (void)fd; return false; }
+    virtual void pause_recv(int fd) { (void)fd; }
+    virtual void resume_recv(int fd) { (void)fd; }
+    virtual void remove_recv(int fd) { (void)fd; }
+    virtual void release_buffer(int buffer_id) { (void)buffer_id; }
+
+    // 按首选后端创建；io_uring 不可用时回退 epoll
+    static std::unique_ptr<Poller> create(IoBackend preferred);
+};
+
+std::unique_ptr<Poller> create_epoll_poller();
+// 编译未启用或内核不支持时返回 nullptr
+std::unique_ptr<Poller> create_io_uring_poller();
+
+} // namespace net
+} // namespace chwell
@@ -11,7 +11,9 @@
 #include <atomic>
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
@@ -103,6 +105,15 @@ public:
         return fd_ >= 0 ? ::write(fd_, buf, len) : -1;
     }
 
+    // 聚合写：一次系统调用写出多个缓冲区；MSG_NOSIGNAL 避免对端关闭时触发 SIGPIPE
+    ssize_t writev(const iovec* iov, int iovcnt) {
+        if (fd_ < 0) return -1;
+        msghdr msg{};
+        msg.msg_iov = const_cast<iovec*>(iov);
+        msg.msg_iovlen = static_cast<std::size_t>(iovcnt);
+        return ::sendmsg(fd_, &msg, MSG_NOSIGNAL);
+    }
+
 private:
     void close_fd() {
         if (fd_ >= 0) {
@@ -114,14 +125,27 @@ private:
     friend class TcpAcceptor;
 };
 
-// TCP Acceptor - 阻塞 accept，配合 poll 用于可中断的 accept
+// 关闭 Nagle：应用层已自行合并小包（如多路复用链路的写合并）时，避免内核再等待 ACK 攒包带来的延迟
+inline bool set_tcp_no_delay(int fd, bool on = true) {
+    int v = on ? 1 : 0;
+    return fd >= 0 && ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &v, sizeof(v)) == 0;
+}
+
+// TCP Acceptor - 非阻塞监听 socket，配合 poll / epoll 使用
+// backlog: listen 队列长度；reuse_port: 设置 SO_REUSEPORT，允许多个 acceptor 绑定同一端口，
+// 由内核按四元组哈希把新连接分散到各监听 socket
 class TcpAcceptor {
 public:
-    TcpAcceptor(unsigned short port);
+    explicit TcpAcceptor(unsigned short port, int backlog = 128, bool reuse_port = false);
     ~TcpAcceptor();
 
+    TcpAcceptor(const TcpAcceptor&) = delete;
+    TcpAcceptor& operator=(const TcpAcceptor&) = delete;
+
     int listen_fd() const { return listen_fd_; }
-    TcpSocket accept(ErrorCode& ec);
+
+    // accept4：flags 可为 SOCK_NONBLOCK | SOCK_CLOEXEC；无待接收连接时 ec 为 EAGAIN
+    TcpSocket accept(ErrorCode& ec, int flags = 0);
 
 private:
     int listen_fd_{-1};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace chwell {
+namespace net {
+
+// SharedFrame：不可变、引用计数的已编码帧
+// 广播时只编码一次；入队到多个连接的输出缓冲只增加引用计数，不拷贝字节。
+// 帧内容构造后不可修改，可在任意线程间共享
+class SharedFrame {
+public:
+    SharedFrame() {}
+    explicit SharedFrame(std::string bytes)
+        : bytes_(std::make_shared<const std::string>(std::move(bytes))) {}
+    SharedFrame(const char* data, std::size_t len)
+        : bytes_(std::make_shared<const std::string>(data, len)) {}
+
+    const char* data() const { return bytes_ ? bytes_->data() : nullptr; }
+    std::size_t size() const { return bytes_ ? bytes_->size() : 0; }
+    bool empty() const { return size() == 0; }
+    std::string_view view() const { return std::string_view(data(), size()); }
+
+    // 当前引用数（调试 / 测试用）
+    long use_count() const { return bytes_.use_count(); }
+
+private:
+    std::shared_ptr<const std::string> bytes_;
+};
+
+} // namespace net
+} // namespace chwell
@@ -1,48 +1,390 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 #include <string_view>
 #include <functional>
 #include <mutex>
 #include <atomic>
 
+#include "chwell/net/buffer.h"
+#include "chwell/net/file_region.h"
 #include "chwell/net/posix_io.h"
+#include "chwell/net/shared_frame.h"
+#include "chwell/net/loop_timer.h"
+#include "chwell/net/tls.h"
 
 namespace chwell {
 namespace net {
 
 class TcpConnection;
+class EventLoop;
 
 typedef std::shared_ptr<TcpConnection> TcpConnectionPtr;
 // 第二个参数指向 TcpConnection 内部读缓冲区的本次 read 区间；仅在回调返回前有效。
 typedef std::function<void(const TcpConnectionPtr&, std::string_view)> MessageCallback;
 typedef std::function<void(const TcpConnectionPtr&)> ConnectionCallback;
+// 第二个参数为触发时输出缓冲的字节数
+typedef std::function<void(const TcpConnectionPtr&, std::size_t)> WatermarkCallback;
 
+// 连接回调集合。服务端为所有连接构造一份并共享（TcpConnection::set_callbacks），
+// 每个连接只持有一个指针，而不是各自拷贝一组 std::function（闭包较大时每份拷贝还有一次堆分配）
+struct ConnectionCallbacks {
+    MessageCallback message;
+    ConnectionCallback close;
+    WatermarkCallback high_watermark;
+    WatermarkCallback low_watermark;
+};
+typedef std::shared_ptr<ConnectionCallbacks> ConnectionCallbacksPtr;
+
+// 慢消费者处理策略
+enum class SlowConsumerPolicy {
+    kDisconnect,  // 超出预算立即断开（丢弃未发送数据）
+    kDropNew      // 保留连接，丢弃超出预算的新帧
+};
+
+// 输出缓冲背压参数（仅反应堆模式生效）
+struct BackpressureConfig {
+    std::size_t high_watermark;    // 输出缓冲增长到该值时触发高水位回调（0 关闭水位回调）
+    std::size_t low_watermark;     // 高水位后回落到该值时触发低水位回调
+    std::size_t max_output_bytes;  // 输出缓冲字节预算，超出按 policy 处理（0 不限制）
+    int max_stall_ms;              // 持续高于高水位的时间预算，超出即断开（0 不限制）
+    SlowConsumerPolicy policy;
+
+    BackpressureConfig()
+        : high_watermark(1024 * 1024),
+          low_watermark(256 * 1024),
+          max_output_bytes(16 * 1024 * 1024),
+          max_stall_ms(30000),
+          policy(SlowConsumerPolicy::kDisconnect) {}
+};
+
+// 空闲超时（仅反应堆模式生效，0 表示不检测）；超时连接按正常关闭流程断开，
+// 与对端断开一样经 close 回调通知上层（TcpServer 的 disconnect 回调 / Component::on_disconnect）
+struct IdleTimeoutConfig {
+    int read_idle_ms;   // 超过该时间未收到任何数据（如客户端心跳停止）
+    int write_idle_ms;  // 超过该时间没有数据写入内核（含输出缓冲长期写不出的慢消费者）
+    int idle_ms;        // 读写均无活动
+
+    IdleTimeoutConfig()
+        : read_idle_ms(0),
+          write_idle_ms(0),
+          idle_ms(0) {}
+
+    bool enabled() const { return read_idle_ms > 0 || write_idle_ms > 0 || idle_ms > 0; }
+};
+
+// TCP 连接，支持两种驱动方式：
+// - 阻塞模式（TcpConnection(socket)）：start() 在调用线程内循环 read，直到连接关闭；
+//   用于 RpcClient / ConnectionPool 等客户端侧连接
+// - 反应堆模式（TcpConnection(loop, socket)）：socket 设为非阻塞并以边沿触发注册到 loop，
+//   读事件在 loop 线程分发，不再独占线程；所有回调都在所属 loop 线程执行。
+//   send() 可在任意线程调用且不会阻塞：内核缓冲写不下的部分进入连接的输出缓冲，
+//   可写时由 loop 线程以 writev 合并多帧一次写出。
+//   输出缓冲按 BackpressureConfig 触发高/低水位回调，并淘汰超出字节/时间预算的慢消费者；
+//   pause_reading() / resume_reading() 用于下游拥塞时暂停读取（如网关 → 后端）。
+//   loop 为 io_uring 后端时改用完成式接收（多路 recv），数据由内核直接收进共享缓冲环后回调
+// enable_tls() 后连接在读写路径上叠加非阻塞 TLS 过滤层：收到的密文在读线程解密后交给 message 回调，
+// send 系列先加密再按上述方式写出；握手期间的发送暂存，握手完成后按序发出
 class TcpConnection : public std::enable_shared_from_this<TcpConnection> {
 public:
     explicit TcpConnection(TcpSocket socket);
+    TcpConnection(EventLoop* loop, TcpSocket socket);
+    ~TcpConnection();
 
     void start();
     void send(const std::vector<char>& data);
     void send(std::string_view data);
+    // 发送共享帧：写不下的部分以引用方式入队，不拷贝帧内容
+    void send(const SharedFrame& frame);
+    // 聚合发送：head（如协议帧头）与 data 按序作为一个整体发送，能直接写出时合并为一次 writev，
+    // 调用方无需先把两段拼到同一缓冲
+    void send(std::string_view head, std::string_view data);
+    // 聚合发送 head 与共享帧：帧未写出的部分以引用方式入队（如缓存的静态文件正文）
+    void send(std::string_view head, const SharedFrame& frame);
+    // 发送 head 后接文件区间。反应堆模式以 sendfile 由内核直接从页缓存写出，不经用户态拷贝；
+    // 写不下的部分以文件区间入队，不占输出缓冲内存、不计入背压字节预算。
+    // TLS 与阻塞模式回退为分块 pread 后发送
+    void send_file(std::string_view head, const FileRegion& region);
+    // 反应堆模式下先尽力写出已缓冲的数据再关闭（TLS 连接先发出 close_notify）
     void close();
 
-    void set_message_callback(const MessageCallback& cb) { message_cb_ = cb; }
-    void set_close_callback(const ConnectionCallback& cb) { close_cb_ = cb; }
+    // 发送合并（仅反应堆模式生效）：开启后 send 系列与 broadcast 不再直接写内核，只入队并登记到所属 loop，
+    // 由 loop 在 tick 边界（EventLoop::set_cork_tick_ms）统一以一次 writev 写出。
+    // 状态同步 / 帧同步每个 tick 发给同一客户端的多个小帧由此合并为一个 TCP 段。关闭 cork 时立即写出暂存数据
+    void set_cork(bool on);
+    bool corked() const { return cork_; }
+    // 立即写出暂存的输出（可跨线程调用），用于不等 tick 边界的延迟敏感消息；
+    // 内核缓冲已满时由可写事件继续写出。未开启 cork 时 send 本就直接写出，调用无额外开销
+    void flush();
+
+    // 启用 TLS（需在 start() 之前调用）。ctx 为服务端上下文时等待对端 ClientHello；
+    // 为客户端上下文时 start() 即发起握手，peer 非空时按该对端标识复用缓存的会话
+    void enable_tls(const TlsContextPtr& ctx, const std::string& peer = std::string());
+    bool tls_enabled() const { return tls_ != nullptr; }
+    bool tls_established() const;
+    // TLS 握手是否复用了此前的会话
+    bool tls_resumed() const;
+
+    // 输出缓冲中尚未写入内核的字节数（不含待 sendfile 的文件区间）
+    std::size_t output_buffer_bytes() const {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        return output_bytes_;
+    }
+
+    void set_message_callback(const MessageCallback& cb) { own_callbacks().message = cb; }
+    void set_close_callback(const ConnectionCallback& cb) { own_callbacks().close = cb; }
+    // 使用共享的回调集合（需在 start() 之前设置，共享后不应再修改 cbs）；
+    // 之后再调用单项 set_*_callback 时先为本连接复制一份，不影响其他连接
+    void set_callbacks(const ConnectionCallbacksPtr& cbs);
+
+    // 低内存模式（仅反应堆模式生效，需在 start() 之前设置），用于大量空闲连接（C1M）的场景：
+    // 连接不持有读缓冲，每次读事件从所属 loop 的缓冲池借用、交付后归还，空闲连接的用户态读缓冲为 0。
+    // io_uring 完成式接收本就由共享缓冲环承接，不受影响
+    void set_low_memory(bool on);
+    bool low_memory() const { return low_memory_; }
+
+    // 连接使用的应用层帧格式（protocol::FrameFormat 的取值，0 为旧格式），由 TcpServerConfig::frame_format
+    // 设置；ProtocolRouterComponent 据此选择解析与编码方式。需在 start() 之前设置
+    void set_frame_format(std::uint8_t format) { frame_format_ = format; }
+    std::uint8_t frame_format() const { return frame_format_; }
+
+    // 协商出的帧压缩编解码器（protocol::FrameCompressor，由 ProtocolRouterComponent 在压缩协商后设置），
+    // 空表示不压缩。可在任意线程读取
+    void set_frame_codec(const std::shared_ptr<void>& codec) { std::atomic_store(&frame_codec_, codec); }
+    std::shared_ptr<void> frame_codec() const { return std::atomic_load(&frame_codec_); }
+
+    // 上层封装对象（如 WsConnection）的弱引用，供共享回调由连接找回所属对象
+    void set_context(const std::weak_ptr<void>& context) { context_ = context; }
+    const std::weak_ptr<void>& context() const { return context_; }
+
+    // 是否已关闭或正在关闭（close() 之后、或对端断开后）
+    bool is_closed() const { return closed_; }
+
+    // 背压配置与水位回调，需在 start() 之前设置；回调在所属 loop 线程执行
+    void set_backpressure(const BackpressureConfig& config) { backpressure_ = config; }
+    const BackpressureConfig& backpressure() const { return backpressure_; }
+    void set_high_watermark_callback(const WatermarkCallback& cb) { own_callbacks().high_watermark = cb; }
+    void set_low_watermark_callback(const WatermarkCallback& cb) { own_callbacks().low_watermark = cb; }
+
+    // 空闲超时，需在 start() 之前设置。截止时间由所属 loop 的时间轮管理：收发数据只记录时间戳
+    // （读在 loop 线程写普通变量，写出为一次 relaxed 原子写），定时器到期时才比较并按剩余时间重新挂上
+    void set_idle_timeout(const IdleTimeoutConfig& config) { idle_ = config; }
+    const IdleTimeoutConfig& idle_timeout() const { return idle_; }
+
+    // 暂停 / 恢复读事件（可跨线程调用）；暂停期间数据留在内核接收缓冲，由 TCP 窗口反压对端
+    void pause_reading();
+    void resume_reading();
+    bool is_reading() const { return reading_; }
+
+    // 单次读 socket 的字节上限（仅反应堆模式，0 为不限，需在 start() 之前设置）。
+    // 配合 splice_to：大帧的 body 多数仍留在内核接收缓冲，由 splice 直接搬运
+    void set_max_read_bytes(std::size_t n) { max_read_bytes_ = n; }
+    std::size_t max_read_bytes() const { return max_read_bytes_; }
+
+    // 零拷贝直通：把本 socket 中接下来的 bytes 字节经管道 splice 到 target 的 socket，不拷贝到用户态。
+    // 只能在本连接的消息回调中调用，且本次回调的输入已处理完；target 需与本连接属于同一 loop。
+    // 搬运期间本连接不回调消息；target 输出缓冲非空或内核缓冲已满时，管道中的数据改为读回后入队，保证顺序。
+    // 完成或中途断开时在 loop 线程调用 done(ok)，随后恢复常规读取。
+    // TLS、阻塞模式与 io_uring 完成式接收的连接不支持，返回 false（调用方照常读取后转发）
+    bool splice_to(const TcpConnectionPtr& target, std::size_t bytes,
+                   std::function<void(bool ok)> done);
+    bool splicing() const;
 
     int native_handle() const noexcept { return socket_.native_handle(); }
 
+    // 所属事件循环；阻塞模式下为 nullptr
+    EventLoop* loop() const noexcept { return loop_; }
+
 private:
+    friend void broadcast(const std::vector<TcpConnectionPtr>& group, const SharedFrame& frame);
+    friend class EventLoop;
+
+    enum class State { kIdle, kConnected, kDisconnected };
+
+    // 输出缓冲中的一项：内存帧，或待 sendfile 的文件区间
+    struct OutputChunk {
+        SharedFrame frame;
+        FileRegion file;
+
+        OutputChunk() {}
+        OutputChunk(const SharedFrame& f) : frame(f) {}
+        OutputChunk(const char* data, std::size_t len) : frame(data, len) {}
+        explicit OutputChunk(const FileRegion& region) : file(region) {}
+
+        bool is_file() const { return !file.empty(); }
+        std::size_t size() const {
+            return is_file() ? static_cast<std::size_t>(file.length) : frame.size();
+        }
+    };
+
+    // 输出队列：vector + 队首下标。空队列不占堆内存（std::deque 默认构造即分配约 576 字节，
+    // 大量空闲连接时可观），写空后下标归位、容量复用；出队的项立即释放帧引用
+    class OutputQueue {
+    public:
+        typedef std::vector<OutputChunk>::iterator iterator;
+
+        bool empty() const { return head_ == items_.size(); }
+        std::size_t size() const { return items_.size() - head_; }
+        OutputChunk& front() { return items_[head_]; }
+        iterator begin() { return items_.begin() + static_cast<std::ptrdiff_t>(head_); }
+        iterator end() { return items_.end(); }
+
+        void push_back(const OutputChunk& chunk) { items_.push_back(chunk); }
+        template <typename... Args>
+        void emplace_back(Args&&... args) { items_.emplace_back(std::forward<Args>(args)...); }
+
+        void pop_front() {
+            items_[head_] = OutputChunk();
+            if (++head_ == items_.size()) {
+                items_.clear();
+                head_ = 0;
+            } else if (head_ >= kCompactThreshold && head_ * 2 >= items_.size()) {
+                // 队列长期非空时前移剩余项，避免已出队的空槽无限累积
+                items_.erase(items_.begin(), items_.begin() + static_cast<std::ptrdiff_t>(head_));
+                head_ = 0;
+            }
+        }
+        void clear() {
+            items_.clear();
+            head_ = 0;
+        }
+        // 释放容量（低内存模式写空后调用）
+        void release() { std::vector<OutputChunk>().swap(items_); head_ = 0; }
+        std::size_t capacity() const { return items_.capacity(); }
+
+    private:
+        static const std::size_t kCompactThreshold = 64;
+
+        std::vector<OutputChunk> items_;
+        std::size_t head_{0};
+    };
+
+    // 单项设置回调前取得本连接独占的回调集合（与其他连接共享时先复制）
+    ConnectionCallbacks& own_callbacks();
+
     void run_read_loop();
+    // 把 input 中刚读到的数据交给 message 回调后清空
+    void deliver_input(Buffer& input);
+    // 读到的数据交给 message 回调（TLS 连接先解密）
+    void dispatch_input(std::string_view data);
+
+    // TLS 过滤层
+    void start_tls();
+    // 解密并交付，握手 / 票据等需回给对端的密文随即发出；返回 false 表示 TLS 出错
+    bool tls_input(std::string_view data);
+    void send_tls(std::string_view head, std::string_view data);
+    // 发出未加密的字节（密文）；需持有 tls_mutex_
+    void send_raw_locked(std::string_view data);
+    // 把 close_notify 放到输出末尾
+    void queue_tls_shutdown();
+
+    // 反应堆模式（仅 loop 线程调用）
+    void connect_established();
+    void handle_event(std::uint32_t events);
+    void handle_read();
+    void handle_recv(const char* data, ssize_t n);
+    void handle_write();
+    void handle_close();
+    // 推进直通搬运（loop 线程）：返回 true 表示已结束，可继续常规读取
+    bool continue_splice();
+    void finish_splice(bool ok);
+    // 空闲定时器到期：已超时则关闭，否则按最早的截止时间重新调度
+    void check_idle();
+    // 记录写出活动（任意线程，持 send_mutex_）
+    void touch_write();
+    void enable_writing();
+    std::uint32_t interest_events() const;
+    void update_interest();
+
+    // 反应堆模式发送：head 与 data 按序写出；frame 非空时 data 的剩余部分直接引用 frame，
+    // 否则拷贝剩余部分
+    void send_reactor(std::string_view head, std::string_view data, const SharedFrame* frame);
+
+    // 检查字节/时间预算，返回 false 表示本帧不应入队；需持有 send_mutex_
+    bool admit_output_locked(std::size_t incoming, bool& evict);
+    // 预算拒绝后的处理：淘汰连接或计入丢帧
+    void reject_output(std::size_t bytes, bool evict);
+    void evict_slow_consumer();
+    // 越过高水位后在 loop 线程挂上停滞定时器：对端零窗口时不再有可写事件，也可能不再有 send，
+    // 仅靠收发路径检查时间预算会让缓冲无限期滞留
+    void arm_stall_timer();
+    void check_stall();
+    // 入队后检查是否越过高水位，越过时返回 true 并给出当前字节数；需持有 send_mutex_
+    bool check_high_watermark_locked(std::size_t& bytes);
+    void fire_high_watermark(std::size_t bytes);
+
+    // broadcast 使用：只入队不写，返回是否需要由 loop 线程调用 flush_queued()
+    bool enqueue_frame(const SharedFrame& frame);
+    void flush_queued();
+    // 所属 loop 到达 cork tick 边界时调用
+    void flush_corked();
+    // 入队后判断 cork 连接是否需要登记到 loop；需持有 send_mutex_
+    bool need_cork_locked();
 
+    // 以 writev / sendfile 写出输出缓冲，返回 false 表示写出错；需持有 send_mutex_
+    bool flush_output_locked();
+    // 从 region 起以 sendfile 写出直到写完或内核缓冲满，*sent 为写出的字节数；返回 false 表示写出错
+    bool sendfile_locked(const FileRegion& region, std::uint64_t* sent);
+    // TLS / 阻塞模式的 send_file：分块读出后走普通发送路径
+    void send_file_copy(std::string_view head, const FileRegion& region);
+    void send_blocking(std::string_view data);
+    void send_blocking(std::string_view head, std::string_view data);
+    // 阻塞写出全部数据，返回 false 表示写出错；需持有 send_mutex_
+    bool write_all_locked(std::string_view data);
+
+    EventLoop* loop_{nullptr};
+    State state_{State::kIdle};
     TcpSocket socket_;
-    std::vector<char> read_buffer_;
-    MessageCallback message_cb_;
-    ConnectionCallback close_cb_;
+    Buffer input_buffer_;            // 低内存模式下不使用（改从 loop 的缓冲池借用）
+    bool low_memory_{false};
+    std::size_t max_read_bytes_{0};
+    std::uint8_t frame_format_{0};
+    std::shared_ptr<void> frame_codec_;
+    struct SpliceState;
+    std::unique_ptr<SpliceState> splice_;  // 首次直通时创建，管道在连接生命周期内复用
+    ConnectionCallbacksPtr callbacks_;
+    std::weak_ptr<void> context_;
     std::atomic<bool> closed_{false};
-    std::mutex send_mutex_;
+
+    // 保护 socket 写与输出缓冲（send 可能来自任意线程）
+    mutable std::mutex send_mutex_;
+    OutputQueue output_queue_;
+    std::size_t output_offset_{0};   // 队首帧已写出的字节数
+    std::size_t output_bytes_{0};    // 队列中内存帧的字节数
+    std::uint64_t output_file_bytes_{0};  // 队列中文件区间的字节数
+    bool write_interest_{false};     // 已请求关注 EPOLLOUT
+    std::atomic<bool> cork_{false};
+    bool cork_queued_{false};        // 已登记到 loop 的待写出列表，等待 tick 边界
+
+    BackpressureConfig backpressure_;
+    bool above_high_{false};         // 已越过高水位，等待回落到低水位
+    std::chrono::steady_clock::time_point high_since_;
+    LoopTimer stall_timer_;          // max_stall_ms 的到期检查，只在 loop 线程操作
+    std::atomic<bool> reading_{true};
+    bool recv_mode_{false};          // 由 loop 的完成式接收驱动读（io_uring 后端）
+
+    IdleTimeoutConfig idle_;
+    LoopTimer idle_timer_;           // 挂在所属 loop 的时间轮上，只在 loop 线程操作
+    std::int64_t last_read_ms_{0};   // 只在 loop 线程读写
+    std::atomic<std::int64_t> last_write_ms_{0};
+
+    // TLS：加密与密文入队在 tls_mutex_ 内完成，保证记录按加密顺序写出（锁顺序 tls_mutex_ → send_mutex_）
+    std::unique_ptr<TlsSession> tls_;
+    mutable std::mutex tls_mutex_;
+    std::string tls_plain_;          // 读线程解密缓冲
+    std::string tls_scratch_;        // 聚合发送时拼接 head 与 data（持 tls_mutex_）
+    std::string tls_out_;            // 待发出的密文（持 tls_mutex_）
 };
 
+// 向一组连接广播同一帧：帧只编码一次，各连接输出缓冲只持有引用；
+// 接收方按所属 I/O 线程分组，每个 loop 投递一次任务统一写出（调用线程即所属 loop 时立即写出）。
+// 与同一线程此前 / 此后对同一连接的 send() 保持顺序；阻塞模式连接在调用线程直接发送
+void broadcast(const std::vector<TcpConnectionPtr>& group, const SharedFrame& frame);
+
 } // namespace net
 } // namespace chwell
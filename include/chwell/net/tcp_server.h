@@ -5,36 +5,103 @@
 #include <set>
 #include <thread>
 #include <atomic>
+#include <vector>
 
 #include "chwell/net/posix_io.h"
+#include "chwell/net/event_loop.h"
 #include "chwell/net/tcp_connection.h"
 
 namespace chwell {
 namespace net {
 
+// TcpServer 监听参数
+struct TcpServerConfig {
+    int backlog;        // listen 队列长度（<=0 时使用 SOMAXCONN）
+    bool reuse_port;    // 每个 I/O 线程持有独立的 SO_REUSEPORT 监听 socket
+    int accept_batch;   // 每次可读事件最多连续 accept 的连接数
+    BackpressureConfig backpressure;  // 应用到每个新连接的输出缓冲背压参数
+    IdleTimeoutConfig idle;             // 应用到每个新连接的空闲超时，超时连接经 disconnect 回调通知
+    TlsContextPtr tls;  // 非空（服务端上下文）时每个新连接启用 TLS，回调收发的都是明文
+    // >0 时每个新连接开启发送合并，各 I/O loop 按该周期对齐的 tick 边界统一写出（如游戏逻辑帧间隔 33 / 50ms）；
+    // 0 关闭。共享同一线程池的服务使用同一 tick 周期（EventLoop::set_cork_tick_ms）
+    int cork_tick_ms;
+    // 低内存模式（大量空闲连接，如 C1M）：新连接不持有读缓冲，读事件期间从所属 loop 的缓冲池借用
+    // （TcpConnection::set_low_memory）。回调无论是否开启都由所有连接共享一份
+    bool low_memory;
+    // >0 时新连接单次读 socket 最多读这么多字节（TcpConnection::set_max_read_bytes），
+    // 用于网关直通：大帧的 body 留在内核，由 splice 直接搬到后端；0 为不限
+    std::size_t max_read_bytes;
+    // 该端口连接的应用层帧格式（protocol::FrameFormat 的取值）：0 为旧的 4 字节帧头，
+    // 1 为带版本、标志位与变长长度的扩展帧头（TcpConnection::set_frame_format）
+    std::uint8_t frame_format;
+
+    TcpServerConfig()
+        : backlog(128),
+          reuse_port(false),
+          accept_batch(64),
+          cork_tick_ms(0),
+          low_memory(false),
+          max_read_bytes(0),
+          frame_format(0) {}
+};
+
+// TcpServer：接收新连接并分配给 I/O 事件循环（非阻塞 + epoll 边沿触发）
+// - 默认模式：单个 accept 线程接收连接，按轮询分配给各 loop
+// - reuse_port 模式：每个 loop 各自监听同一端口（SO_REUSEPORT），由内核分散新连接，
+//   连接直接归属接收它的 loop，accept 能力随 I/O 线程数扩展
+// 连接的读事件、message/disconnect 回调均在所属 loop 线程执行，线程数与连接数解耦
 class TcpServer {
 public:
+    // 使用外部 I/O 线程池（如 Service 持有的 loops），多个服务可共享
+    TcpServer(EventLoopThreadPool& loops, unsigned short port);
+
+    // 兼容旧接口：内部创建单线程 I/O 循环，io_service 仅保留给调用方投递任务
     TcpServer(IoService& io_service, unsigned short port);
 
+    // 需在 start_accept() 之前设置
+    void set_config(const TcpServerConfig& config) { config_ = config; }
+    const TcpServerConfig& config() const { return config_; }
+
     void start_accept();
     void stop();
 
+    // 回调需在 start_accept() 之前设置：启动时构造一份回调集合，由所有连接共享
     void set_message_callback(const MessageCallback& cb) { message_cb_ = cb; }
     void set_connection_callback(const ConnectionCallback& cb) { connection_cb_ = cb; }
     void set_disconnect_callback(const ConnectionCallback& cb) { disconnect_cb_ = cb; }
 
+    std::size_t connection_count() {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        return connections_.size();
+    }
+
 private:
+    // reuse_port 模式下每个 loop 持有的监听 socket
+    struct AcceptShard {
+        EventLoop* loop;
+        std::unique_ptr<TcpAcceptor> acceptor;
+    };
+
+    bool start_sharded_accept();
+    void stop_sharded_accept();
     void accept_loop();
+    // 连续 accept 直到 EAGAIN 或达到 accept_batch；loop 为空时按轮询分配
+    void drain_accept(TcpAcceptor& acceptor, EventLoop* loop);
+    void handle_new_connection(EventLoop* loop, TcpSocket socket);
 
-    IoService& io_service_;
+    std::unique_ptr<EventLoopThreadPool> own_loops_;
+    EventLoopThreadPool& loops_;
     unsigned short port_;
-    TcpAcceptor acceptor_;
+    TcpServerConfig config_;
+    std::unique_ptr<TcpAcceptor> acceptor_;
+    std::vector<AcceptShard> shards_;
     int wake_pipe_[2]{-1, -1};
     std::mutex connections_mutex_;
     std::set<TcpConnectionPtr> connections_;
     std::thread accept_thread_;
     std::atomic<bool> stopped_{false};
     MessageCallback message_cb_;
+    ConnectionCallbacksPtr callbacks_;
     ConnectionCallback connection_cb_;
     ConnectionCallback disconnect_cb_;
 };
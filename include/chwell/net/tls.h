@@ -1,5 +1,12 @@
 #pragma once
 
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
 #include "chwell/net/posix_io.h"
 #include "chwell/core/logger.h"
 
@@ -8,28 +15,63 @@ namespace net {
 
 // 简单的 TLS 封装：基于 OpenSSL，对现有 TcpSocket 做包装。
 // 仅在定义 CHWELL_USE_OPENSSL 时提供真实实现，否则为空壳实现。
+// - TlsConnection：阻塞式，适合每连接一线程的客户端
+// - TlsSession：无 I/O 的内存 BIO 引擎，由反应堆 TcpConnection 作为过滤层驱动（TcpConnection::enable_tls）
+
+// 编译时是否带 OpenSSL
+bool tls_available();
+
+// 会话恢复参数：重连时跳过证书校验与密钥交换，登录高峰时显著降低握手 CPU
+struct TlsSessionConfig {
+    bool tickets;             // 会话票据：服务端无状态恢复（票据密钥随 TlsContext 生成，进程内有效）
+    std::size_t cache_size;   // 服务端会话缓存条目数（有状态恢复，0 关闭）；客户端按对端缓存最近一次会话
+    long timeout_sec;         // 会话有效期
+
+    TlsSessionConfig()
+        : tickets(true),
+          cache_size(20480),
+          timeout_sec(300) {}
+};
 
 class TlsContext {
 public:
     TlsContext();
     ~TlsContext();
 
+    TlsContext(const TlsContext&) = delete;
+    TlsContext& operator=(const TlsContext&) = delete;
+
     // 初始化为服务端上下文，加载证书和私钥
     bool init_server(const std::string& cert_file,
-                     const std::string& key_file);
+                     const std::string& key_file,
+                     const TlsSessionConfig& sessions = TlsSessionConfig());
 
     // 初始化为客户端上下文，可选 CA 证书（为空则使用系统默认）
-    bool init_client(const std::string& ca_file = std::string());
+    bool init_client(const std::string& ca_file = std::string(),
+                     const TlsSessionConfig& sessions = TlsSessionConfig());
 
     bool is_server() const { return is_server_; }
+    bool ready() const { return ctx_ != nullptr; }
 
 private:
     friend class TlsConnection;
+    friend class TlsSession;
+
+    void configure_sessions(const TlsSessionConfig& sessions);
+    // 客户端会话缓存（key 为对端标识，如 "host:port"）；值实际类型为 SSL_SESSION*，
+    // client_session 返回的会话已增加引用计数，由调用方释放
+    void* client_session(const std::string& peer);
+    void store_client_session(const std::string& peer, void* session);
 
     void* ctx_;      // 实际类型为 SSL_CTX*
     bool is_server_;
+    TlsSessionConfig sessions_;
+    std::mutex client_sessions_mutex_;
+    std::unordered_map<std::string, void*> client_sessions_;
 };
 
+typedef std::shared_ptr<TlsContext> TlsContextPtr;
+
 class TlsConnection {
 public:
     TlsConnection(TlsContext& ctx, TcpSocket&& socket);
@@ -53,6 +95,59 @@ private:
     bool established_;
 };
 
+// TlsSession：非阻塞 TLS 状态机（读写各一个内存 BIO，不接触 socket）
+// 调用方把收到的密文交给 feed()，把 feed() / encrypt() / shutdown() 产生的密文原样发给对端。
+// 内存 BIO 不会写满，OpenSSL 的 want-write 由调用方的输出缓冲吸收；want-read 即等待下一次 feed()。
+// 握手完成前 encrypt() 的明文暂存，握手完成后按序加密输出。
+// 非线程安全，由调用方串行使用
+class TlsSession {
+public:
+    // peer 非空时（客户端）：握手前取用该对端缓存的会话，收到新会话票据后更新缓存
+    TlsSession(const TlsContextPtr& ctx, const std::string& peer = std::string());
+    ~TlsSession();
+
+    TlsSession(const TlsSession&) = delete;
+    TlsSession& operator=(const TlsSession&) = delete;
+
+    // 客户端发起握手（ClientHello 追加到 *cipher_out）；服务端无需调用
+    bool start(std::string* cipher_out);
+
+    // 处理对端密文：解出的明文追加到 *plain，需要发给对端的密文（握手、票据、告警）追加到 *cipher_out；
+    // 返回 false 表示握手失败或数据损坏，连接应关闭（*cipher_out 中可能有告警需先发出）
+    bool feed(std::string_view cipher_in, std::string* plain, std::string* cipher_out);
+
+    // 加密明文，密文追加到 *cipher_out；返回 false 表示会话已失败或已关闭
+    bool encrypt(std::string_view plain, std::string* cipher_out);
+
+    // 生成 close_notify
+    void shutdown(std::string* cipher_out);
+
+    bool established() const { return established_; }
+    // 握手是否复用了此前的会话（票据或会话缓存）
+    bool resumed() const { return resumed_; }
+    // 对端已发送 close_notify
+    bool peer_closed() const { return peer_closed_; }
+
+private:
+    friend class TlsContext;
+
+    // 客户端收到新会话（TLS 1.3 在握手后由票据下发）时的回调，返回 true 表示接管 session
+    bool on_new_session(void* session);
+    bool drive_handshake(std::string* cipher_out);
+    bool flush_pending(std::string* cipher_out);
+    void drain(std::string* cipher_out);
+
+    TlsContextPtr ctx_;
+    std::string peer_;
+    void* ssl_;    // 实际类型为 SSL*
+    void* rbio_;   // 对端 → SSL，实际类型为 BIO*
+    void* wbio_;   // SSL → 对端
+    std::string pending_;   // 握手完成前待加密的明文
+    bool established_;
+    bool resumed_;
+    bool failed_;
+    bool peer_closed_;
+};
+
 } // namespace net
 } // namespace chwell
-
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+#include "chwell/net/posix_io.h"
+
+namespace chwell {
+namespace net {
+
+// UDP 分段卸载（Linux UDP_SEGMENT / UDP_GRO）
+//
+// - 发送：把同一目的地址的一段大缓冲按 segment_size 切分，一次 sendmsg 交给内核，
+//   由内核（或网卡）完成分段；每次最多 kMaxGsoSegments 段
+// - 接收：socket 开启 UDP_GRO 后，内核可把同一流的多个数据报合并交付，
+//   随附 cmsg 给出段大小，由调用方按段切回数据报（见 UdpServerConfig::enable_gro）
+// 内核不支持或拒绝 GSO 时（ENOPROTOOPT / EIO / EINVAL 等）进程内自动关闭 GSO，
+// 之后走 sendmmsg 逐段批量发送，行为对调用方透明
+
+const std::size_t kMaxGsoSegments = 64;
+// 单次 GSO 发送的最大负载（IPv4 UDP 数据报上限）
+const std::size_t kMaxGsoBytes = 65507;
+
+// 当前进程是否仍在使用 GSO 发送（探测失败或内核拒绝后为 false）
+bool udp_gso_enabled();
+// 关闭 / 恢复 GSO 发送（测试与基准用于对比回退路径）
+void set_udp_gso_enabled(bool enabled);
+
+// 把 payload 按 segment_size 切分发往 remote（最后一段可以更短），返回成功发出的段数。
+// fd 须为非阻塞 UDP socket；内核缓冲满时其余段丢弃
+std::size_t udp_send_segments(int fd, std::string_view payload, std::size_t segment_size,
+                              const UdpEndpoint& remote);
+
+// 在 socket 上开启 UDP_GRO，返回是否成功
+bool udp_enable_gro(int fd);
+
+} // namespace net
+} // namespace chwell
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <cstddef>
 #include <functional>
+#include <memory>
+#include <string_view>
 #include <vector>
-#include <thread>
 #include <atomic>
 
 #include "chwell/net/posix_io.h"
+#include "chwell/net/event_loop.h"
 
 namespace chwell {
 namespace net {
@@ -13,26 +16,102 @@ namespace net {
 typedef std::function<void(const std::vector<char>& data,
                            const UdpEndpoint& remote)> UdpMessageCallback;
 
-// 简单的 UDP 服务器封装：单端口收发，使用线程 + 阻塞 recvfrom
+// 批量收发的数据报：接收时 data 指向接收 slab，仅在批量回调期间有效；
+// 发送时 data 只需在 send_batch 调用期间有效
+struct UdpDatagram {
+    std::string_view data;
+    UdpEndpoint remote;
+};
+
+// 批量接收回调：在收到该批数据报的 loop 线程直接执行，不拷贝、不投递
+typedef std::function<void(const std::vector<UdpDatagram>& batch)> UdpBatchCallback;
+// 周期回调：在第一个接收线程执行，与该线程的批量回调串行
+typedef std::function<void()> UdpTickCallback;
+
+// UdpServer 参数
+struct UdpServerConfig {
+    int num_sockets;                  // >1 时打开 N 个 SO_REUSEPORT socket，各由独立 loop 线程接收
+    int recv_batch;                   // 每次 recvmmsg 最多接收的数据报数
+    std::size_t max_datagram_size;    // 接收 slab 中每个槽的大小，超长数据报被截断丢弃
+    bool pin_threads;                 // 把第 i 个接收线程绑定到 CPU i（按在线 CPU 数取模）
+    bool enable_gro;                  // 开启 UDP_GRO：合并交付的数据报按段切回后再回调（槽扩大到 64KB）
+
+    UdpServerConfig()
+        : num_sockets(1),
+          recv_batch(64),
+          max_datagram_size(4096),
+          pin_threads(false),
+          enable_gro(false) {}
+};
+
+// UDP 服务器封装：单端口收发
+// 接收由独立的 EventLoop 线程驱动（后端随 default_io_backend()，可用 set_backend 指定）：
+// - 可读时以 recvmmsg 一次收取一批数据报到预分配的 slab，直到 EAGAIN
+// - num_sockets > 1 时每个 loop 持有一个 SO_REUSEPORT socket，由内核按四元组分散流量，
+//   同一对端的数据报总落在同一线程
+// - 设置了批量回调时在接收线程直接交付视图；否则每批拷贝一次、投递一次到 io_service，
+//   逐条调用消息回调
 class UdpServer {
 public:
     UdpServer(IoService& io_service, unsigned short port);
+    UdpServer(IoService& io_service, unsigned short port, const UdpServerConfig& config);
+    ~UdpServer();
+
+    // 需在 start_receive() 之前调用
+    void set_backend(IoBackend backend) { loops_.set_backend(backend); }
+
+    const UdpServerConfig& config() const { return config_; }
+    // 实际绑定的端口（构造时 port 为 0 则为系统分配）
+    unsigned short port() const { return port_; }
+    std::size_t socket_count() const { return shards_.size(); }
 
     void start_receive();
     void stop();
 
     void send_to(const std::vector<char>& data, const UdpEndpoint& remote);
+    void send_to(std::string_view data, const UdpEndpoint& remote);
+
+    // 以 sendmmsg 批量发送，返回成功交给内核的数据报数（内核缓冲满时其余丢弃）。
+    // 在接收线程调用时使用该线程的 socket，否则使用第一个 socket
+    std::size_t send_batch(const std::vector<UdpDatagram>& datagrams);
+
+    // 把 payload 按 segment_size 切分为多个数据报发往同一 remote：
+    // 优先 UDP_SEGMENT 一次系统调用发出最多 64 段，内核拒绝时自动回退 sendmmsg（见 udp_offload.h）。
+    // 返回成功发出的段数
+    std::size_t send_segments(std::string_view payload, std::size_t segment_size,
+                              const UdpEndpoint& remote);
 
     void set_message_callback(const UdpMessageCallback& cb) { message_cb_ = cb; }
+    // 需在 start_receive() 之前设置；设置后不再调用消息回调
+    void set_batch_callback(const UdpBatchCallback& cb) { batch_cb_ = cb; }
+    // 需在 start_receive() 之前设置：以 timerfd 每 interval_ms 毫秒回调一次，
+    // 供上层协议（如 KCP 的重传 / 超时检查）在接收线程驱动定时逻辑
+    void set_tick_callback(int interval_ms, const UdpTickCallback& cb) {
+        tick_interval_ms_ = interval_ms;
+        tick_cb_ = cb;
+    }
 
 private:
-    void recv_loop();
+    struct Shard;
+
+    bool open_sockets(unsigned short port);
+    void close_sockets();
+    void handle_readable(Shard& shard);
+    void deliver(Shard& shard);
+    int send_fd() const;
+    void start_tick(Shard& shard);
 
     IoService& io_service_;
-    int fd_{-1};
-    std::vector<char> buffer_;
+    UdpServerConfig config_;
+    unsigned short port_{0};
+    std::vector<std::unique_ptr<Shard>> shards_;
     UdpMessageCallback message_cb_;
-    std::thread recv_thread_;
+    UdpBatchCallback batch_cb_;
+    UdpTickCallback tick_cb_;
+    int tick_interval_ms_{0};
+    int tick_fd_{-1};
+    EventLoopThreadPool loops_;
+    bool started_{false};
     std::atomic<bool> stopped_{false};
 };
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <functional>
 #include <memory>
@@ -26,6 +27,11 @@ public:
     // 发送数据（到指定地址）
     void send_to(const std::string& host, uint16_t port, const std::string& data);
 
+    // 把 payload 按 segment_size 切分为多个数据报发往同一地址，优先 UDP_SEGMENT 卸载，
+    // 内核不支持时回退 sendmmsg；返回成功发出的段数
+    std::size_t send_segments(const std::string& host, uint16_t port,
+                              std::string_view payload, std::size_t segment_size);
+
     // 关闭
     void close();
 
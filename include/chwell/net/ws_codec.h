@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace chwell {
+namespace net {
+
+// RFC 6455 WebSocket 编解码：握手、帧头、掩码、增量解帧（分片拼接与控制帧）
+
+enum class WsOpcode : std::uint8_t {
+    kContinuation = 0x0,
+    kText = 0x1,
+    kBinary = 0x2,
+    kClose = 0x8,
+    kPing = 0x9,
+    kPong = 0xA
+};
+
+// 常用关闭码
+namespace ws_close {
+    const std::uint16_t kNormal = 1000;
+    const std::uint16_t kGoingAway = 1001;
+    const std::uint16_t kProtocolError = 1002;
+    const std::uint16_t kUnsupportedData = 1003;
+    const std::uint16_t kNoStatus = 1005;
+    const std::uint16_t kInvalidPayload = 1007;
+    const std::uint16_t kMessageTooBig = 1009;
+}
+
+// 帧头最大长度：2 + 8（64 位长度）+ 4（掩码）
+const std::size_t kWsMaxHeaderSize = 14;
+
+// ---------------------------------------------------------------------------
+// 握手
+// ---------------------------------------------------------------------------
+
+struct WsHandshakeRequest {
+    std::string method;
+    std::string path;
+    std::string host;
+    std::string key;          // Sec-WebSocket-Key
+    std::string version;      // Sec-WebSocket-Version
+    std::string protocols;    // Sec-WebSocket-Protocol（原样保留）
+    std::string extensions;   // Sec-WebSocket-Extensions（原样保留）
+};
+
+// 解析 HTTP 升级请求：返回请求头总长度（含结尾空行）；数据不完整返回 0；
+// 不是合法的 WebSocket 升级请求或请求头超过 max_size 返回 -1
+long parse_ws_handshake(std::string_view data, WsHandshakeRequest* out,
+                        std::size_t max_size = 8192);
+
+// Sec-WebSocket-Accept = base64(SHA-1(key + GUID))
+std::string ws_accept_key(std::string_view key);
+
+// 101 Switching Protocols 响应；protocol 非空时回显选定的子协议，
+// extensions 非空时写入 Sec-WebSocket-Extensions（协商结果）
+std::string ws_handshake_response(const WsHandshakeRequest& request,
+                                  std::string_view protocol = std::string_view(),
+                                  std::string_view extensions = std::string_view());
+
+// 握手失败时回复的 400 响应
+std::string ws_handshake_reject();
+
+// 客户端升级请求（测试 / 桥接客户端使用）
+std::string ws_client_handshake(std::string_view host, std::string_view path, std::string_view key,
+                                std::string_view extensions = std::string_view());
+
+// ---------------------------------------------------------------------------
+// 帧
+// ---------------------------------------------------------------------------
+
+// 把 src 与掩码按位异或写入 dst（dst 可与 src 相同，即原地去掩码）。
+// offset 为 src[0] 在整个载荷中的位置，用于跨多次调用续接掩码相位。
+// x86-64 上按 AVX2（运行时检测）/ SSE2 每次处理 32 / 16 字节，其他平台按 8 字节字处理
+void ws_mask_copy(char* dst, const char* src, std::size_t len,
+                  const std::uint8_t mask[4], std::size_t offset = 0);
+
+// 在 out（至少 kWsMaxHeaderSize 字节）中原地写出帧头，返回头长度；
+// mask 非空时置掩码位并写入掩码（客户端帧），载荷本身不在此处理；
+// rsv1 标记压缩消息（permessage-deflate，仅消息首帧置位）
+std::size_t ws_encode_header(char* out, WsOpcode opcode, std::uint64_t payload_len,
+                             bool fin = true, const std::uint8_t* mask = nullptr,
+                             bool rsv1 = false);
+
+// 编码完整帧（帧头 + 载荷拷贝，mask 非空时同时加掩码），用于控制帧 / 测试
+std::string ws_encode_frame(WsOpcode opcode, std::string_view payload, bool fin = true,
+                            const std::uint8_t* mask = nullptr);
+
+// 关闭帧载荷：2 字节大端关闭码 + 原因
+std::string ws_close_payload(std::uint16_t code, std::string_view reason = std::string_view());
+
+// WsDecoder：增量解帧器
+// - 任意切分的字节流按序 feed；帧头不完整时只暂存头部字节，载荷边收边去掩码写入消息缓冲，
+//   每个字节只拷贝一次（去掩码与拷贝合并完成）
+// - 分片消息拼接后整条交付；控制帧（close / ping / pong）可插在分片之间，单独交付
+// - 回调中的 payload 指向解码器内部缓冲，仅在回调返回前有效
+// - 协议错误（未加掩码的客户端帧、未协商的保留位、非法分片、控制帧超长、消息超过上限）时 feed 返回 false，
+//   close_code() 给出应回复的关闭码；此后不再解码
+class WsDecoder {
+public:
+    // opcode 为 kText / kBinary（整条消息）或控制帧类型
+    typedef std::function<void(WsOpcode opcode, std::string_view payload)> FrameCallback;
+
+    static const std::size_t kDefaultMaxMessageSize = 4 * 1024 * 1024;
+
+    // require_mask：服务端解码客户端帧时为 true（RFC 6455 要求客户端帧必须加掩码）
+    explicit WsDecoder(bool require_mask = true,
+                       std::size_t max_message_size = kDefaultMaxMessageSize);
+
+    bool feed(std::string_view data, const FrameCallback& cb);
+
+    // 协商了 permessage-deflate 后允许消息首帧置 RSV1
+    void set_allow_compressed(bool allow) { allow_compressed_ = allow; }
+    // 当前交付的数据消息是否为压缩消息（RSV1），在回调内有效；解压由调用方完成
+    bool message_compressed() const { return message_compressed_; }
+
+    bool failed() const { return close_code_ != 0; }
+    std::uint16_t close_code() const { return close_code_; }
+
+    // 正在拼接的分片消息 / 当前帧已缓冲的字节数
+    std::size_t buffered_bytes() const { return message_.size() + control_.size(); }
+
+    // 释放消息缓冲的多余容量（空闲连接回收内存）
+    void shrink();
+
+private:
+    bool fail(std::uint16_t code);
+    // 头部完整后校验并进入载荷阶段
+    bool begin_frame();
+    // 当前帧载荷收齐后的处理
+    void finish_frame(const FrameCallback& cb);
+
+    bool require_mask_;
+    bool allow_compressed_{false};
+    std::size_t max_message_size_;
+    std::uint16_t close_code_{0};
+
+    // 当前帧
+    char header_[kWsMaxHeaderSize];
+    std::size_t header_len_{0};      // 已收到的头部字节
+    std::size_t header_need_{2};     // 当前已知的头部总长度
+    bool in_payload_{false};
+    bool fin_{false};
+    WsOpcode opcode_{WsOpcode::kContinuation};
+    bool masked_{false};
+    std::uint8_t mask_[4]{0, 0, 0, 0};
+    std::uint64_t payload_len_{0};
+    std::uint64_t payload_read_{0};
+
+    // 分片消息状态
+    bool in_message_{false};
+    WsOpcode message_opcode_{WsOpcode::kBinary};
+    bool message_compressed_{false};
+    std::string message_;   // 数据帧载荷（已去掩码，跨分片拼接）
+    std::string control_;   // 控制帧载荷
+};
+
+} // namespace net
+} // namespace chwell
@@ -1,12 +1,17 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <string_view>
 #include <vector>
 #include <functional>
-#include <mutex>
 #include <atomic>
+#include <mutex>
 
 #include "chwell/net/posix_io.h"
+#include "chwell/net/tcp_connection.h"
+#include "chwell/net/ws_codec.h"
+#include "chwell/net/ws_deflate.h"
 
 namespace chwell {
 namespace net {
@@ -14,34 +19,122 @@ namespace net {
 class WsConnection;
 
 typedef std::shared_ptr<WsConnection> WsConnectionPtr;
-typedef std::function<void(const WsConnectionPtr&, const std::string&)> WsMessageCallback;
+// 第二个参数为一条完整（分片已拼接、已去掩码）的消息，指向连接内部缓冲，仅在回调返回前有效；
+// 文本 / 二进制由 WsConnection::message_opcode() 区分
+typedef std::function<void(const WsConnectionPtr&, std::string_view)> WsMessageCallback;
 typedef std::function<void(const WsConnectionPtr&)> WsConnectionCallback;
+typedef std::function<void(const WsConnectionPtr&, std::size_t)> WsWatermarkCallback;
+
+// WebSocket 连接回调集合，由 WsServer 为所有连接构造一份并共享（见 ConnectionCallbacks）
+struct WsConnectionCallbacks {
+    WsConnectionCallback open;
+    WsMessageCallback message;
+    WsConnectionCallback close;
+    WsWatermarkCallback high_watermark;
+    WsWatermarkCallback low_watermark;
+};
+typedef std::shared_ptr<WsConnectionCallbacks> WsConnectionCallbacksPtr;
 
-// 非完整实现的 WebSocket 连接封装骨架
+// 服务端 WebSocket 连接（RFC 6455）
+// 底层为反应堆模式的 TcpConnection：读事件在所属 loop 线程分发，发送不阻塞，
+// 并沿用其输出缓冲背压（水位回调、读暂停、慢消费者淘汰）
+// - 先完成 HTTP 升级握手（回复 101 后触发 open 回调），之后按帧增量解码
+// - ping 自动回 pong；收到 close 回显关闭帧后关闭连接；协议错误回复对应关闭码后关闭
+// - 发送时帧头在栈上原地构造，与载荷以一次聚合写发出，不拷贝载荷
+// - 协商 permessage-deflate 后，不小于阈值的消息压缩发送（压缩无收益时仍发原文），
+//   收到的压缩消息解压后交付
 class WsConnection : public std::enable_shared_from_this<WsConnection> {
 public:
-    explicit WsConnection(TcpSocket socket);
+    explicit WsConnection(TcpConnectionPtr conn,
+                          std::size_t max_message_size = WsDecoder::kDefaultMaxMessageSize);
 
     void start();
-    void send_text(const std::string& text);
+    void send_text(std::string_view text);
+    void send_binary(std::string_view data);
     void send_binary(const std::vector<char>& data);
-    void close();
+    // 发送预编码消息（广播）：协商了压缩且窗口兼容时发压缩帧，否则发原文帧；只增加引用计数
+    void send_prepared(const WsPreparedMessage& message);
+    void ping(std::string_view payload = std::string_view());
+    // 发送关闭帧后关闭连接（已缓冲的数据先写出）
+    void close(std::uint16_t code = ws_close::kNormal, std::string_view reason = std::string_view());
+
+    // permessage-deflate 参数（start() 之前设置）；shared 非空且协商了 server_no_context_takeover
+    // 时使用共享压缩器，否则按需创建本连接的压缩器
+    void set_deflate(const WsDeflateConfig& config, WsSharedDeflaterPtr shared = WsSharedDeflaterPtr()) {
+        deflate_config_ = config;
+        shared_deflater_ = std::move(shared);
+    }
+
+    // 握手完成（回复 101 之后）回调
+    void set_open_callback(const WsConnectionCallback& cb) { own_callbacks().open = cb; }
+    void set_message_callback(const WsMessageCallback& cb) { own_callbacks().message = cb; }
+    void set_close_callback(const WsConnectionCallback& cb) { own_callbacks().close = cb; }
+    // 使用共享的回调集合（start() 之前设置，共享后不应再修改 cbs）
+    void set_callbacks(const WsConnectionCallbacksPtr& cbs);
+
+    // 背压（需在 start() 之前设置）
+    void set_backpressure(const BackpressureConfig& config) { conn_->set_backpressure(config); }
+    void set_high_watermark_callback(const WsWatermarkCallback& cb) { own_callbacks().high_watermark = cb; }
+    void set_low_watermark_callback(const WsWatermarkCallback& cb) { own_callbacks().low_watermark = cb; }
+    void pause_reading() { conn_->pause_reading(); }
+    void resume_reading() { conn_->resume_reading(); }
+    std::size_t output_buffer_bytes() const { return conn_->output_buffer_bytes(); }
 
-    void set_message_callback(const WsMessageCallback& cb) { message_cb_ = cb; }
-    void set_close_callback(const WsConnectionCallback& cb) { close_cb_ = cb; }
+    int native_handle() const { return conn_->native_handle(); }
+    const TcpConnectionPtr& tcp_connection() const { return conn_; }
 
-    int native_handle() const { return socket_.native_handle(); }
+    bool is_open() const { return state_ == State::kOpen; }
+    // 当前交付消息的类型（kText / kBinary），在消息回调内有效
+    WsOpcode message_opcode() const { return message_opcode_; }
+    // 握手请求（路径、子协议等），open 回调起有效
+    const WsHandshakeRequest& handshake() const { return request_; }
+    // 握手是否协商了 permessage-deflate，及协商参数
+    bool deflate_enabled() const { return deflate_; }
+    const WsDeflateParams& deflate_params() const { return deflate_params_; }
 
 private:
-    void run_read_loop();
+    enum class State { kHandshake, kOpen, kClosed };
 
-    TcpSocket socket_;
-    std::vector<char> read_buffer_;
-    WsMessageCallback message_cb_;
-    WsConnectionCallback close_cb_;
-    std::atomic<bool> closed_{false};
+    // 单项设置回调前取得本连接独占的回调集合（与其他连接共享时先复制）
+    WsConnectionCallbacks& own_callbacks();
+    // 底层 TcpConnection 的回调：所有 WsConnection 共用一份，经 TcpConnection::context 找回本对象
+    static const ConnectionCallbacksPtr& tcp_callbacks();
+
+    void handle_data(std::string_view data);
+    void handle_handshake(std::string_view data);
+    void handle_frame(WsOpcode opcode, std::string_view payload);
+    void send_frame(WsOpcode opcode, std::string_view payload);
+    // 压缩并发送数据消息，返回 false 表示未压缩（低于阈值 / 无收益 / 失败），由调用方发原文
+    bool send_compressed(WsOpcode opcode, std::string_view payload);
+    void deliver(WsOpcode opcode, std::string_view payload);
+    // 发送关闭帧并关闭底层连接（仅一次）
+    void shutdown(std::uint16_t code, std::string_view reason);
+
+    TcpConnectionPtr conn_;
+    std::atomic<State> state_{State::kHandshake};
+    std::string handshake_buffer_;
+    WsHandshakeRequest request_;
+    WsDecoder decoder_;
+    WsOpcode message_opcode_{WsOpcode::kText};
+
+    // permessage-deflate
+    WsDeflateConfig deflate_config_;
+    WsSharedDeflaterPtr shared_deflater_;
+    bool deflate_{false};
+    WsDeflateParams deflate_params_;
+    std::unique_ptr<WsInflater> inflater_;   // loop 线程使用
+    std::string inflated_;
+    // 压缩与发送需按同一顺序进行（保留滑动窗口时对端按收到顺序解压），send_mutex_ 串行化二者
     std::mutex send_mutex_;
+    std::unique_ptr<WsDeflater> deflater_;
+    std::string deflate_buffer_;
+
+    WsConnectionCallbacksPtr callbacks_;
+    std::atomic<bool> closed_{false};
 };
 
+// 向一组 WebSocket 连接广播同一条预编码消息（由 ws_prepare_message 只编码 / 压缩一次）
+void ws_broadcast(const std::vector<WsConnectionPtr>& group, const WsPreparedMessage& message);
+
 } // namespace net
 } // namespace chwell
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "chwell/net/shared_frame.h"
+#include "chwell/net/ws_codec.h"
+
+namespace chwell {
+namespace net {
+
+// WebSocket permessage-deflate（RFC 7692）
+// 需要 zlib（CHWELL_USE_ZLIB=ON 且找到 zlib）；未启用时握手不协商该扩展，行为与未压缩一致
+
+// 服务端压缩参数
+struct WsDeflateConfig {
+    bool enabled;                  // 是否接受客户端的 permessage-deflate 请求
+    int level;                     // zlib 压缩级别 1~9（游戏快照 / JSON 在 1~3 收益已接近 9）
+    std::size_t min_size;          // 小于该长度的消息不压缩（压缩头开销与 CPU 不划算）
+    int server_max_window_bits;    // 服务端压缩窗口 8~15；越小每连接内存越少、压缩率越低
+    int mem_level;                 // zlib memLevel 1~9，影响压缩上下文内存
+    // 压缩上下文共享：为 true 时协商 server_no_context_takeover，所有连接共用 WsServer 持有的
+    // 一个压缩器（每条消息独立压缩，不保留滑动窗口），每连接不再常驻约 256KB 的 deflate 状态；
+    // 为 false 时每连接独立压缩器并跨消息保留滑动窗口，压缩率更高
+    bool shared_context;
+    std::size_t max_inflated_size; // 解压后的单条消息上限（防压缩炸弹），超出以 1009 关闭
+
+    WsDeflateConfig()
+        : enabled(false),
+          level(3),
+          min_size(256),
+          server_max_window_bits(15),
+          mem_level(8),
+          shared_context(false),
+          max_inflated_size(WsDecoder::kDefaultMaxMessageSize) {}
+};
+
+// 协商结果（双方最终生效的参数）
+struct WsDeflateParams {
+    bool server_no_context_takeover{false};
+    bool client_no_context_takeover{false};
+    int server_max_window_bits{15};
+};
+
+// 编译时是否带 zlib
+bool ws_deflate_available();
+
+// 解析 Sec-WebSocket-Extensions，按顺序选择第一个可接受的 permessage-deflate 提议；
+// 接受时填写 *params 并返回 true。服务端共享上下文时强制 server_no_context_takeover
+bool negotiate_ws_deflate(std::string_view extensions, const WsDeflateConfig& config,
+                          WsDeflateParams* params);
+
+// 生成响应中的 Sec-WebSocket-Extensions 值
+std::string format_ws_deflate_response(const WsDeflateParams& params);
+
+// 生成客户端请求中的扩展提议（测试 / 桥接客户端使用）
+std::string format_ws_deflate_offer(bool client_no_context_takeover = false,
+                                    bool server_no_context_takeover = false);
+
+// WsDeflater：按消息压缩（raw deflate + Z_SYNC_FLUSH，去掉结尾 00 00 ff ff）
+// no_context_takeover 为 true 时每条消息后重置，消息之间互不引用
+// 非线程安全
+class WsDeflater {
+public:
+    WsDeflater(int level, int window_bits, int mem_level, bool no_context_takeover);
+    ~WsDeflater();
+
+    WsDeflater(const WsDeflater&) = delete;
+    WsDeflater& operator=(const WsDeflater&) = delete;
+
+    // 压缩 in 写入 *out（覆盖），失败返回 false
+    bool compress(std::string_view in, std::string* out);
+
+    // 丢弃滑动窗口：之后的消息不再引用此前发送的内容
+    void reset();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+    bool no_context_takeover_;
+};
+
+// WsInflater：按消息解压
+class WsInflater {
+public:
+    WsInflater(int window_bits, bool no_context_takeover);
+    ~WsInflater();
+
+    WsInflater(const WsInflater&) = delete;
+    WsInflater& operator=(const WsInflater&) = delete;
+
+    // 解压一条消息到 *out（覆盖），返回 0；数据损坏返回 -1，解压结果超过 max_size 返回 -2
+    int decompress(std::string_view in, std::string* out, std::size_t max_size);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+    bool no_context_takeover_;
+};
+
+// 多连接共用的压缩器（每条消息独立压缩），按锁串行使用
+class WsSharedDeflater {
+public:
+    explicit WsSharedDeflater(const WsDeflateConfig& config);
+
+    bool compress(std::string_view in, std::string* out) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return deflater_.compress(in, out);
+    }
+
+private:
+    std::mutex mutex_;
+    WsDeflater deflater_;
+};
+
+typedef std::shared_ptr<WsSharedDeflater> WsSharedDeflaterPtr;
+
+// 预编码消息：广播时只编码 / 压缩一次，各连接按协商结果选用其一，发送只增加引用计数
+// - plain：未压缩的完整帧
+// - deflated：RSV1 置位的压缩帧（消息独立压缩，不依赖任何连接的滑动窗口）；
+//   消息低于阈值、压缩无收益或 zlib 不可用时为空
+struct WsPreparedMessage {
+    SharedFrame plain;
+    SharedFrame deflated;
+    std::size_t payload_size{0};
+    int window_bits{15};  // deflated 使用的压缩窗口，连接协商的窗口更小时改发 plain
+};
+
+WsPreparedMessage ws_prepare_message(WsOpcode opcode, std::string_view payload,
+                                     const WsDeflateConfig& config);
+
+} // namespace net
+} // namespace chwell
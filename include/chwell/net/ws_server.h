@@ -6,27 +6,56 @@
 #include <atomic>
 
 #include "chwell/net/posix_io.h"
+#include "chwell/net/event_loop.h"
 #include "chwell/net/ws_connection.h"
 
 namespace chwell {
 namespace net {
 
+// WsServer：accept 线程接收连接，交给内部 I/O 事件循环驱动（与 TcpServer 一致），
+// 握手与帧编解码由 WsConnection 完成
 class WsServer {
 public:
-    WsServer(IoService& io_service, unsigned short port);
+    // io_service 仅保留给调用方投递任务；num_loops 为 I/O 线程数
+    WsServer(IoService& io_service, unsigned short port, std::size_t num_loops = 1);
 
     void start_accept();
     void stop();
 
+    // 回调需在 start_accept() 之前设置：启动时构造一份回调集合，由所有连接共享
     void set_message_callback(const WsMessageCallback& cb) { message_cb_ = cb; }
+    // 握手完成后回调（在连接所属 I/O 线程执行）
     void set_connection_callback(const WsConnectionCallback& cb) { connection_cb_ = cb; }
     void set_disconnect_callback(const WsConnectionCallback& cb) { disconnect_cb_ = cb; }
+    // 应用到每个新连接的输出缓冲背压参数（start_accept 之前设置）
+    void set_backpressure(const BackpressureConfig& config) { backpressure_ = config; }
+    // 应用到每个新连接的空闲超时（start_accept 之前设置）；ping / pong 也计为活动
+    void set_idle_timeout(const IdleTimeoutConfig& config) { idle_ = config; }
+    // 低内存模式：连接不持有读缓冲，读事件期间从所属 loop 的缓冲池借用（start_accept 之前设置）
+    void set_low_memory(bool on) { low_memory_ = on; }
+    // 单条消息（分片拼接后）上限，超出时以 1009 关闭连接（start_accept 之前设置）
+    void set_max_message_size(std::size_t bytes) { max_message_size_ = bytes; }
+    // permessage-deflate（start_accept 之前设置）；shared_context 时所有连接共用一个压缩器
+    void set_deflate(const WsDeflateConfig& config);
+    const WsDeflateConfig& deflate_config() const { return deflate_config_; }
+    // wss：每个连接在 WebSocket 之下叠加 TLS（服务端上下文，start_accept 之前设置）
+    void set_tls(const TlsContextPtr& ctx) { tls_ = ctx; }
+    // I/O 事件循环后端（start_accept 之前设置），默认取 default_io_backend()
+    void set_backend(IoBackend backend) { loops_.set_backend(backend); }
 
 private:
     void accept_loop();
 
     IoService& io_service_;
+    EventLoopThreadPool loops_;
     unsigned short port_;
+    BackpressureConfig backpressure_;
+    IdleTimeoutConfig idle_;
+    bool low_memory_{false};
+    std::size_t max_message_size_{WsDecoder::kDefaultMaxMessageSize};
+    WsDeflateConfig deflate_config_;
+    WsSharedDeflaterPtr shared_deflater_;
+    TlsContextPtr tls_;
     TcpAcceptor acceptor_;
     int wake_pipe_[2]{-1, -1};
     std::mutex connections_mutex_;
@@ -34,6 +63,7 @@ private:
     std::thread accept_thread_;
     std::atomic<bool> stopped_{false};
     WsMessageCallback message_cb_;
+    WsConnectionCallbacksPtr callbacks_;
     WsConnectionCallback connection_cb_;
     WsConnectionCallback disconnect_cb_;
 };
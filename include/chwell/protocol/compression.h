@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "chwell/protocol/message.h"
+
+namespace chwell {
+namespace protocol {
+
+// 帧层压缩（扩展帧格式的 kFlagCompressed）：zlib 格式的 deflate，每条消息独立成流、不跨消息保留窗口，
+// 同一份压缩结果可以发给任意多个连接（广播只压缩一次）。可选预置字典：zlib 在流头部写入字典 id（adler32），
+// 解压时按 id 校验。需要 zlib（CHWELL_USE_ZLIB=ON），未启用时协商总是拒绝，消息原样发送
+//
+// 协商（每连接一次，由客户端发起，仅扩展帧格式的连接）：
+//   C2S kCmdCompression：| algo (1) | dict_id (4, 大端) |  algo 为 kCompressionDeflate，dict_id 为客户端持有的字典，0 为没有
+//   S2C kCmdCompression：| algo (1) | dict_id (4, 大端) |  接受时回送 algo 与双方共用的字典 id（与服务端字典不同则为 0，
+//   不用字典）；拒绝时 algo 为 kCompressionNone。服务端在回复之后才会发出压缩帧，客户端收到接受回复后才可发送压缩帧
+const std::uint16_t kCmdCompression = 0xFFF0;
+const std::uint8_t kCompressionNone = 0;
+const std::uint8_t kCompressionDeflate = 1;
+
+// deflate 窗口为 32 KiB，更长的字典用不上
+const std::size_t kMaxDictionaryBytes = 32 * 1024;
+
+// 预置字典：压缩小而相似的载荷（快照、状态差异）时，让第一条消息也能引用常见片段
+class FrameDictionary {
+public:
+    FrameDictionary() : id_(0) {}
+    explicit FrameDictionary(std::string bytes);
+
+    // 从典型载荷训练字典：选出在多个样本中反复出现的片段（覆盖相同内容的片段只取一次），
+    // 按价值升序拼接（最常用的放在末尾，离待压缩数据最近，引用距离最短），总长不超过 max_bytes。
+    // 没有跨样本重复的内容时返回空字典
+    static FrameDictionary train(const std::vector<std::string>& samples,
+                                 std::size_t max_bytes = kMaxDictionaryBytes);
+
+    // 字典 id：内容的 adler32（与 zlib 流头部的 DICTID 一致），空字典为 0
+    std::uint32_t id() const { return id_; }
+    const std::string& bytes() const { return bytes_; }
+    bool empty() const { return bytes_.empty(); }
+
+private:
+    std::string bytes_;
+    std::uint32_t id_;
+};
+
+typedef std::shared_ptr<const FrameDictionary> FrameDictionaryPtr;
+
+// 帧层压缩参数
+struct CompressionConfig {
+    int level;                          // zlib 压缩级别 1~9
+    std::size_t min_size;               // 小于该长度的 body 不压缩
+    std::size_t max_decompressed_size;  // 解压后的单条消息上限（防压缩炸弹），超出视为非法
+    FrameDictionaryPtr dictionary;      // 服务端字典，可空；客户端持有同一字典（id 相同）时启用
+
+    CompressionConfig()
+        : level(3),
+          min_size(256),
+          max_decompressed_size(kMaxFrameBody) {}
+};
+
+// 编译时是否带 zlib
+bool frame_compression_available();
+
+// 一种压缩设置（参数 + 是否带字典）的编解码器，可跨线程使用：zlib 上下文按需创建并池化复用，
+// 并发压缩的线程各自取用一个。同一设置的所有连接共享一个实例
+class FrameCompressor {
+public:
+    // dictionary 为空时不使用字典（忽略 config.dictionary）
+    FrameCompressor(const CompressionConfig& config, const FrameDictionaryPtr& dictionary);
+    ~FrameCompressor();
+
+    FrameCompressor(const FrameCompressor&) = delete;
+    FrameCompressor& operator=(const FrameCompressor&) = delete;
+
+    std::uint32_t dictionary_id() const { return dictionary_ ? dictionary_->id() : 0; }
+
+    // 压缩 in 写入 *out（覆盖）；低于阈值、压缩后不更小或 zlib 不可用时返回 false
+    bool compress(std::string_view in, std::string* out);
+
+    // 解压一条消息到 *out（覆盖），返回 0；数据损坏或字典不符返回 -1，超过 max_decompressed_size 返回 -2
+    int decompress(std::string_view in, std::string* out);
+
+    // 把一条消息追加编码为扩展格式的帧：值得压缩时压缩并置 kFlagCompressed，否则原样编码
+    void encode(std::string& out, std::uint16_t cmd, std::string_view body,
+                std::size_t max_fragment = kMaxFrameBody);
+
+    // 累计压缩前 / 后的 body 字节数（只统计实际压缩的消息）
+    std::uint64_t raw_bytes() const { return raw_bytes_.load(std::memory_order_relaxed); }
+    std::uint64_t compressed_bytes() const { return compressed_bytes_.load(std::memory_order_relaxed); }
+
+private:
+    struct Impl;
+
+    CompressionConfig config_;
+    FrameDictionaryPtr dictionary_;
+    std::unique_ptr<Impl> impl_;
+    std::atomic<std::uint64_t> raw_bytes_{0};
+    std::atomic<std::uint64_t> compressed_bytes_{0};
+};
+
+typedef std::shared_ptr<FrameCompressor> FrameCompressorPtr;
+
+// 协商消息的 body：| algo (1) | dict_id (4, 大端) |
+std::string encode_compression_offer(std::uint8_t algo, std::uint32_t dict_id);
+bool decode_compression_offer(std::string_view body, std::uint8_t& algo, std::uint32_t& dict_id);
+
+} // namespace protocol
+} // namespace chwell
@@ -1,16 +1,38 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
 
 namespace chwell {
 namespace protocol {
 
-// 协议格式：| cmd (2 bytes) | len (2 bytes) | body (len bytes) |
+// 协议格式（FrameFormat::kLegacy，旧端口与旧客户端）：| cmd (2 bytes) | len (2 bytes) | body (len bytes) |
 // cmd: 命令号（uint16_t，网络字节序）
-// len: body 长度（uint16_t，网络字节序）
+// len: body 长度（uint16_t，网络字节序），body 不超过 65535 字节
 // body: 实际数据
+//
+// 扩展格式（FrameFormat::kExtended）：| ver (1) | flags (1) | cmd (2) | len (varint, 1~5) | body (len) |
+// ver: 固定为 kExtendedVersion，旧格式的流误连到扩展端口时在第一个字节就能识别出来
+// flags: kFlagMore 表示同一消息后面还有分片，接收方把连续的分片拼成一条消息（分片之间不能插入其他帧）；
+//        kFlagCompressed 表示 body 经过压缩（见 compression.h，分片消息的每一片都带该位）；其余位保留，必须为 0
+// len: body 长度，LEB128 无符号变长整数（低 7 位在前），单帧不超过 kMaxFrameBody
+// 同一连接只使用一种格式，由监听端口决定（TcpServerConfig::frame_format）
+enum class FrameFormat : std::uint8_t {
+    kLegacy = 0,
+    kExtended = 1,
+};
+
+const std::uint8_t kExtendedVersion = 0xE1;
+const std::uint8_t kFlagMore = 0x01;
+const std::uint8_t kFlagCompressed = 0x02;
+const std::uint8_t kKnownFlags = kFlagMore | kFlagCompressed;
+const std::size_t kLegacyHeaderSize = 4;
+const std::size_t kMaxExtendedHeaderSize = 9;
+const std::size_t kMaxLegacyBody = 0xFFFF;
+const std::size_t kMaxFrameBody = 16 * 1024 * 1024;
 
 struct Message {
     std::uint16_t cmd;
@@ -21,10 +43,44 @@ struct Message {
     Message(std::uint16_t c, const std::string& s) : cmd(c), body(s.begin(), s.end()) {}
 };
 
+// 消息视图：body 直接指向接收缓冲，不拷贝；仅在解析回调期间有效。
+// 需要跨回调保留时用 to_message() 拷贝出 Message
+struct MessageView {
+    std::uint16_t cmd;
+    std::string_view body;
+    // 消息级标志：Parser 交付扩展格式的消息时为 kFlagCompressed 或 0（kFlagMore 不会出现）；
+    // ProtocolRouterComponent 交给处理器的视图已解压，恒为 0
+    std::uint8_t flags;
+
+    MessageView() : cmd(0), flags(0) {}
+    MessageView(std::uint16_t c, std::string_view b, std::uint8_t f = 0) : cmd(c), body(b), flags(f) {}
+
+    Message to_message() const {
+        Message msg;
+        msg.cmd = cmd;
+        msg.body.assign(body.begin(), body.end());
+        return msg;
+    }
+};
+
+// 写入一帧的帧头，返回帧头长度（out 至少 kMaxExtendedHeaderSize 字节）。
+// 旧格式忽略 flags，body_len 需不超过 kMaxLegacyBody；扩展格式需不超过 kMaxFrameBody
+std::size_t encode_header(char* out, FrameFormat format, std::uint16_t cmd, std::uint8_t flags,
+                          std::size_t body_len);
+
 // 将 Message 序列化为字节流（用于发送）
-std::vector<char> serialize(const Message& msg);
+// 扩展格式下 body 超过 max_fragment 时拆成多个分片帧（0 或超过 kMaxFrameBody 时按 kMaxFrameBody 拆）；
+// 旧格式无法表示超过 65535 字节的 body，此时记录错误并返回空（不发出被截断的帧）
+std::vector<char> serialize(const Message& msg, FrameFormat format = FrameFormat::kLegacy,
+                            std::size_t max_fragment = kMaxFrameBody);
+
+// 同 serialize，追加编码到 out（如构造共享帧）；flags 为附加到每一帧的消息级标志（如 kFlagCompressed），
+// 仅扩展格式可用。旧格式 body 超长或带 flags 时返回 false 且不写入
+bool serialize_to(std::string& out, std::uint16_t cmd, std::string_view body,
+                  FrameFormat format = FrameFormat::kLegacy,
+                  std::size_t max_fragment = kMaxFrameBody, std::uint8_t flags = 0);
 
-// 从字节流反序列化 Message（用于接收）
+// 从字节流反序列化 Message（用于接收，旧格式；扩展格式经 Parser 解析）
 // 返回是否成功解析出一个完整的消息
 bool deserialize(const std::vector<char>& data, Message& msg);
 
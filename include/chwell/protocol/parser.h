@@ -1,18 +1,35 @@
 #pragma once
 
+#include <algorithm>
 #include <vector>
+#include <string>
 #include <string_view>
 #include <cstdint>
+#include "chwell/net/buffer.h"
 #include "chwell/protocol/message.h"
 
 namespace chwell {
 namespace protocol {
 
 // 协议解析器：处理粘包/拆包问题
-// 内部维护一个缓冲区，累积接收到的数据，直到能解析出完整的消息
+// 内部维护一个缓冲区，只缓存跨调用的残帧；本次数据中的完整帧直接从输入解析，不先拷入缓冲
+// 扩展格式（FrameFormat::kExtended）下带 kFlagMore 的分片先拼到内部的消息缓冲，收到最后一片时作为一条消息交付；
+// 遇到非法帧（版本 / 保留标志位不对、长度或拼接后的消息超限、分片中途换了 cmd 或压缩标志）后解析器进入失败状态，
+// 不再交付任何消息，调用方应关闭连接
 class Parser {
 public:
-    Parser() : buffer_(), head_(0) {}
+    // parse_frame 的返回值：非法帧
+    static const std::size_t kInvalidFrame = static_cast<std::size_t>(-1);
+
+    // initial_buffer 为残帧缓冲的初始容量（仅在出现拆包时使用，可为 0）
+    explicit Parser(std::size_t initial_buffer = net::Buffer::kInitialSize,
+                    FrameFormat format = FrameFormat::kLegacy)
+        : buffer_(initial_buffer), format_(format) {}
+
+    FrameFormat format() const { return format_; }
+
+    // 分片拼接后单条消息的上限（默认 kMaxFrameBody），超出视为非法
+    void set_max_message_bytes(std::size_t n) { max_message_bytes_ = n; }
 
     // 添加新接收到的数据，尝试解析出完整的消息
     // 返回解析出的消息列表（可能为空，也可能有多个）
@@ -21,18 +38,139 @@ public:
         return feed(std::string_view(data.data(), data.size()));
     }
 
+    // 直接从调用方持有的缓冲解析，完整帧从 input 中消费，残帧留在 input 中
+    std::vector<Message> feed(net::Buffer& input);
+
+    // 零拷贝解析：对每条完整消息调用 fn(const MessageView&)，不分配 Message，返回消息数。
+    // 视图指向 data 或内部缓冲，仅在 fn 执行期间有效；fn 中不得再调用本解析器
+    template <typename Fn>
+    std::size_t feed_views(std::string_view data, Fn&& fn);
+
+    // 在 data 起始处识别一帧（旧格式）：成功写 view 并返回整帧长度（含 4 字节头），数据不完整返回 0
+    static std::size_t parse_frame(std::string_view data, MessageView& view);
+    // 按 format 识别一帧，flags 为帧的标志位（旧格式恒为 0），view.flags 为其中的消息级标志：
+    // 成功返回整帧长度，数据不完整返回 0，非法帧返回 kInvalidFrame（只需帧头的前几个字节即可判定）
+    static std::size_t parse_frame(std::string_view data, FrameFormat format, MessageView& view,
+                                   std::uint8_t& flags);
+
+    // 缓冲中尚未补齐的残帧字节数
+    std::size_t buffered_bytes() const { return buffer_.readable_bytes(); }
+    // 缓冲中的残帧（帧头与已收到的 body 前缀）
+    std::string_view buffered() const { return buffer_.view(); }
+    // 没有残帧，也没有拼接到一半的分片消息
+    bool idle() const { return buffer_.empty() && !in_message_; }
+
+    // 是否遇到过非法帧
+    bool failed() const { return failed_; }
+
     // 清空缓冲区（例如连接断开时）
     void reset() {
-        buffer_.clear();
-        head_ = 0;
+        buffer_.retrieve_all();
+        clear_message();
+        failed_ = false;
     }
 
 private:
-    void compact_prefix();
+    // 补齐缓冲中残帧（先头部、再 body）还需的字节数
+    std::size_t pending_bytes() const;
+
+    // 交付一帧：普通帧直接调用 fn，分片先拼接，最后一片到达时交付整条消息；返回交付的消息数
+    template <typename Fn>
+    std::size_t deliver(const MessageView& frame, std::uint8_t flags, Fn& fn);
+    // 从 data 起始处解析并交付尽可能多的完整帧，返回消费的字节数；消息数累加到 count
+    template <typename Fn>
+    std::size_t parse_input(std::string_view data, Fn& fn, std::size_t& count);
 
-    std::vector<char> buffer_;
-    std::size_t head_;
+    void clear_message();
+
+    net::Buffer buffer_;
+    FrameFormat format_;
+    std::size_t max_message_bytes_{kMaxFrameBody};
+    bool failed_{false};
+    // 拼接中的分片消息
+    bool in_message_{false};
+    std::uint16_t message_cmd_{0};
+    std::uint8_t message_flags_{0};
+    std::string message_;
 };
 
+template <typename Fn>
+std::size_t Parser::deliver(const MessageView& frame, std::uint8_t flags, Fn& fn) {
+    const std::uint8_t message_flags = flags & kFlagCompressed;
+    if (!in_message_ && (flags & kFlagMore) == 0) {
+        fn(static_cast<const MessageView&>(MessageView(frame.cmd, frame.body, message_flags)));
+        return 1;
+    }
+    if ((in_message_ && (frame.cmd != message_cmd_ || message_flags != message_flags_)) ||
+        message_.size() + frame.body.size() > max_message_bytes_) {
+        failed_ = true;
+        return 0;
+    }
+    in_message_ = true;
+    message_cmd_ = frame.cmd;
+    message_flags_ = message_flags;
+    message_.append(frame.body.data(), frame.body.size());
+    if ((flags & kFlagMore) != 0) {
+        return 0;
+    }
+    fn(static_cast<const MessageView&>(MessageView(message_cmd_, message_, message_flags_)));
+    clear_message();
+    return 1;
+}
+
+template <typename Fn>
+std::size_t Parser::parse_input(std::string_view data, Fn& fn, std::size_t& count) {
+    std::size_t pos = 0;
+    MessageView view;
+    std::uint8_t flags = 0;
+    std::size_t frame_len = 0;
+    while (!failed_ && (frame_len = parse_frame(data.substr(pos), format_, view, flags)) > 0) {
+        if (frame_len == kInvalidFrame) {
+            failed_ = true;
+            break;
+        }
+        count += deliver(view, flags, fn);
+        pos += frame_len;
+    }
+    return pos;
+}
+
+template <typename Fn>
+std::size_t Parser::feed_views(std::string_view data, Fn&& fn) {
+    std::size_t count = 0;
+    if (failed_) {
+        return 0;
+    }
+    MessageView view;
+    std::uint8_t flags = 0;
+
+    // 先用新数据补齐上次遗留的残帧，只拷贝补齐所需的字节
+    while (!buffer_.empty() && !data.empty()) {
+        std::size_t take = std::min(pending_bytes(), data.size());
+        buffer_.append(data.data(), take);
+        data.remove_prefix(take);
+        std::size_t frame_len = parse_frame(buffer_.view(), format_, view, flags);
+        if (frame_len == kInvalidFrame) {
+            failed_ = true;
+            return count;
+        }
+        if (frame_len > 0) {
+            count += deliver(view, flags, fn);
+            buffer_.retrieve(frame_len);
+            if (failed_) {
+                return count;
+            }
+        }
+    }
+
+    // 其余完整帧直接在输入上解析
+    data.remove_prefix(parse_input(data, fn, count));
+
+    if (!data.empty() && !failed_) {
+        buffer_.append(data);
+    }
+    return count;
+}
+
 } // namespace protocol
 } // namespace chwell
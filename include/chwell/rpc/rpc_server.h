@@ -11,6 +11,7 @@
 #include "chwell/net/tcp_server.h"
 #include "chwell/service/component.h"
 #include "chwell/protocol/message.h"
+#include "chwell/protocol/parser.h"
 
 namespace chwell {
 namespace rpc {
@@ -51,7 +52,7 @@ private:
     
     std::mutex mutex_;
     std::unordered_map<std::uint16_t, RpcHandler> methods_;
-    std::unordered_map<const net::TcpConnection*, std::vector<char>> buffers_;
+    std::unordered_map<const net::TcpConnection*, protocol::Parser> parsers_;
     
     std::atomic<int> total_requests_{0};
     std::atomic<int> active_connections_{0};
@@ -5,6 +5,8 @@
 #include <vector>
 
 #include "chwell/net/tcp_connection.h"
+#include "chwell/net/kcp_server.h"
+#include "chwell/net/mux.h"
 
 namespace chwell {
 namespace service {
@@ -29,6 +31,18 @@ public:
 
     // 连接断开时的回调（可选实现）
     virtual void on_disconnect(const net::TcpConnectionPtr& /*conn*/) {}
+
+    // Service 开启 KCP 监听（listen_kcp）后，来自可靠 UDP 会话的消息 / 断开回调（可选实现）
+    // 在 KCP 接收线程执行，data 同样仅在回调返回前有效
+    virtual void on_kcp_message(const net::KcpConnectionPtr& /*conn*/,
+                                std::string_view /*data*/) {}
+    virtual void on_kcp_disconnect(const net::KcpConnectionPtr& /*conn*/) {}
+
+    // Service 开启多路复用监听（listen_mux）后，网关链路上各会话的消息 / 结束回调（可选实现）
+    // 在链路所属 I/O 线程执行；data 为网关转发的一段完整数据，仅在回调返回前有效
+    virtual void on_mux_message(const net::MuxSessionPtr& /*session*/,
+                                std::string_view /*data*/) {}
+    virtual void on_mux_disconnect(const net::MuxSessionPtr& /*session*/) {}
 };
 
 } // namespace service
@@ -1,13 +1,17 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string_view>
 #include <functional>
 #include <unordered_map>
 #include <vector>
 #include "chwell/service/component.h"
+#include "chwell/protocol/compression.h"
 #include "chwell/protocol/message.h"
 #include "chwell/protocol/parser.h"
+#include "chwell/net/shared_frame.h"
 
 namespace chwell {
 namespace net {
@@ -22,9 +26,17 @@ namespace service {
 //   1. 注册 ProtocolRouterComponent 到 Service
 //   2. 调用 register_handler(cmd, handler) 注册各个 cmd 的处理器
 //   3. 当收到消息时，会自动解析协议并按 cmd 路由
+// 分发在接收缓冲上原地进行：视图处理器（register_view_handler）不产生任何堆分配；
+// register_handler 注册的处理器需要拥有消息，按需为其拷贝出 Message
+// 帧格式按连接选择（TcpConnection::frame_format）：扩展格式的分片由解析器拼成整条消息后再分发，
+// 非法帧直接关闭连接；发送 / 广播按接收方的格式编码
+// 帧压缩（enable_compression）：扩展格式的连接可经 protocol::kCmdCompression 协商压缩，之后收到的压缩帧先解压再分发，
+// 发给它的消息超过阈值时压缩；未协商就发来压缩帧、或解压失败时关闭连接
 class ProtocolRouterComponent : public Component {
 public:
     typedef std::function<void(const net::TcpConnectionPtr&, const protocol::Message&)> MessageHandler;
+    // 视图处理器：msg.body 仅在回调期间有效，需要保留时调用 msg.to_message()
+    typedef std::function<void(const net::TcpConnectionPtr&, const protocol::MessageView&)> ViewHandler;
 
     ProtocolRouterComponent() {}
 
@@ -32,11 +44,33 @@ public:
         return "ProtocolRouterComponent";
     }
 
-    // 注册一个 cmd 的处理器
+    // 注册一个 cmd 的处理器（拥有消息副本）
     void register_handler(std::uint16_t cmd, MessageHandler handler) {
-        handlers_[cmd] = handler;
+        Route& route = handlers_[cmd];
+        route.owned = std::move(handler);
+        route.view = nullptr;
     }
 
+    // 注册一个 cmd 的零拷贝处理器（热路径使用）
+    void register_view_handler(std::uint16_t cmd, ViewHandler handler) {
+        Route& route = handlers_[cmd];
+        route.view = std::move(handler);
+        route.owned = nullptr;
+    }
+
+    // 直通处理器（仅旧格式连接）：cmd 的帧头已到达、body 尚未收全时调用。frame 为已收到的部分（4 字节帧头 + body 前缀），
+    // remaining 为仍未读到的 body 字节数。返回 true 表示处理器已接管这一帧（如 TcpConnection::splice_to），
+    // 路由器丢弃这段残帧；返回 false 则照常缓存，收全后交给该 cmd 的常规处理器
+    typedef std::function<bool(const net::TcpConnectionPtr&, std::uint16_t cmd,
+                               std::string_view frame, std::size_t remaining)> PassthroughHandler;
+    void register_passthrough(std::uint16_t cmd, PassthroughHandler handler) {
+        passthrough_[cmd] = std::move(handler);
+    }
+
+    // 启用帧压缩（需在服务启动前调用）：接受客户端的压缩协商，客户端持有与 config.dictionary 相同的字典时使用字典。
+    // 未调用时协商一律被拒绝。zlib 不可用时记录警告并保持关闭
+    void enable_compression(const protocol::CompressionConfig& config);
+
     // 组件接口：收到原始消息时，解析协议并路由
     virtual void on_message(const net::TcpConnectionPtr& conn,
                             std::string_view data) override;
@@ -44,13 +78,66 @@ public:
     // 组件接口：连接断开时清理解析器
     virtual void on_disconnect(const net::TcpConnectionPtr& conn) override;
 
-    // 发送协议消息的辅助函数
+    // 网关多路复用会话（Service::listen_mux）的处理器：每段会话数据由网关按完整协议帧转发，无需解析器；
+    // 帧格式取会话的 frame_format（MuxServer::set_frame_format）
+    typedef std::function<void(const net::MuxSessionPtr&, const protocol::MessageView&)> MuxHandler;
+    void register_mux_handler(std::uint16_t cmd, MuxHandler handler) {
+        mux_handlers_[cmd] = std::move(handler);
+    }
+
+    virtual void on_mux_message(const net::MuxSessionPtr& session,
+                                std::string_view data) override;
+
+    // 经多路复用链路回复会话对应的客户端，按会话的帧格式编码；编码不下的消息丢弃并计数
+    static void send_message(const net::MuxSessionPtr& session, const protocol::Message& msg);
+
+    // 发送协议消息的辅助函数；不等待 socket，写不下的部分进入连接输出缓冲后立即返回
     static void send_message(const net::TcpConnectionPtr& conn, const protocol::Message& msg);
 
+    // 将协议消息编码为共享帧（一次分配，可发送给任意多个同一帧格式、同一压缩设置的连接）；
+    // codec 非空时按扩展格式编码并在值得时压缩
+    static net::SharedFrame make_frame(const protocol::Message& msg,
+                                       protocol::FrameFormat format = protocol::FrameFormat::kLegacy,
+                                       const protocol::FrameCompressorPtr& codec = nullptr);
+
+    // 广播协议消息：每种帧格式 + 压缩设置只编码（压缩）一次，按 I/O 线程分组写出（见 net::broadcast）
+    static void broadcast_message(const std::vector<net::TcpConnectionPtr>& group,
+                                  const protocol::Message& msg);
+
+    // 连接所用的帧格式（TcpConnection::frame_format）
+    static protocol::FrameFormat frame_format(const net::TcpConnectionPtr& conn);
+    // 多路复用会话所用的帧格式（MuxSession::frame_format）
+    static protocol::FrameFormat frame_format(const net::MuxSessionPtr& session);
+
+    // 连接协商出的压缩编解码器，未协商压缩时为空
+    static protocol::FrameCompressorPtr frame_codec(const net::TcpConnectionPtr& conn);
+
 private:
-    // 为每个连接维护一个解析器（处理粘包/拆包）
-    std::unordered_map<const net::TcpConnection*, protocol::Parser> parsers_;
-    std::unordered_map<std::uint16_t, MessageHandler> handlers_;
+    struct Route {
+        ViewHandler view;
+        MessageHandler owned;
+    };
+
+    // 分发一条消息；压缩帧无法解压时关闭连接并返回 false，调用方不应再分发该连接的后续消息
+    bool dispatch(const net::TcpConnectionPtr& conn, const protocol::MessageView& msg);
+    void route(const net::TcpConnectionPtr& conn, const protocol::MessageView& msg);
+    void handle_compression_offer(const net::TcpConnectionPtr& conn, std::string_view body);
+    static void broadcast_group(const std::vector<net::TcpConnectionPtr>& group,
+                                const protocol::Message& msg, protocol::FrameFormat format,
+                                const protocol::FrameCompressorPtr& codec);
+    // 残帧属于直通 cmd 时交给直通处理器，返回是否已被接管
+    bool try_passthrough(const net::TcpConnectionPtr& conn, std::string_view partial);
+
+    // 只为留有残帧（拆包）的连接维护解析器，收到的都是完整帧时不创建；
+    // 多个 I/O 线程并发分发，映射本身受 parsers_mutex_ 保护（解析在锁外进行）
+    std::mutex parsers_mutex_;
+    std::unordered_map<const net::TcpConnection*, std::shared_ptr<protocol::Parser>> parsers_;
+    std::unordered_map<std::uint16_t, Route> handlers_;
+    std::unordered_map<std::uint16_t, MuxHandler> mux_handlers_;
+    std::unordered_map<std::uint16_t, PassthroughHandler> passthrough_;
+    // 所有协商了压缩的连接共享：不带字典 / 带字典各一个
+    protocol::FrameCompressorPtr compressor_;
+    protocol::FrameCompressorPtr dict_compressor_;
 };
 
 } // namespace service
@@ -8,17 +8,23 @@
 #include "chwell/core/thread_pool.h"
 #include "chwell/core/logger.h"
 #include "chwell/net/posix_io.h"
+#include "chwell/net/event_loop.h"
 #include "chwell/net/tcp_server.h"
+#include "chwell/net/kcp_server.h"
+#include "chwell/net/mux.h"
 #include "chwell/service/component.h"
 
 namespace chwell {
 namespace service {
 
 // Service：代表一个具体的游戏服务进程
+// worker_threads 决定 I/O 事件循环数（每个线程一个 loop，承载任意多连接；后端见 event_loops().set_backend），
+// 同时也是 io_service 任务线程数（供组件 post 的后台任务使用）
 class Service {
 public:
     Service(unsigned short listen_port, std::size_t worker_threads)
-        : server_(io_service_, listen_port),
+        : loops_(worker_threads),
+          server_(loops_, listen_port),
           thread_pool_(worker_threads),
           worker_threads_(worker_threads) {
         server_.set_connection_callback([](const net::TcpConnectionPtr& conn) {
@@ -72,8 +78,71 @@ public:
         return 0;
     }
 
+    // 再开一个 TCP 端口，连接与主端口共用 I/O 事件循环并分发给同一组组件；config 按端口单独生效，
+    // 如 frame_format 让新客户端走扩展帧格式，主端口保持旧格式。需在 start() 之前调用
+    net::TcpServer* listen_tcp(unsigned short port, const net::TcpServerConfig& config) {
+        std::unique_ptr<net::TcpServer> server(new net::TcpServer(loops_, port));
+        server->set_config(config);
+        server->set_disconnect_callback([this](const net::TcpConnectionPtr& conn) {
+            dispatch_disconnect(conn);
+        });
+        server->set_message_callback([this](const net::TcpConnectionPtr& conn,
+                                            std::string_view data) {
+            dispatch_message(conn, data);
+        });
+        extra_servers_.push_back(std::move(server));
+        return extra_servers_.back().get();
+    }
+
+    // 在 TCP 之外再开一个 KCP（可靠 UDP）端口，会话消息分发给各组件的 on_kcp_message；
+    // 需在 start() 之前调用
+    net::KcpServer* listen_kcp(unsigned short port,
+                               const net::KcpConfig& config = net::KcpConfig::fast()) {
+        kcp_server_.reset(new net::KcpServer(io_service_, port, config));
+        kcp_server_->set_message_callback([this](const net::KcpConnectionPtr& conn,
+                                                 std::string_view data) {
+            for (std::size_t i = 0; i < components_.size(); ++i) {
+                components_[i]->on_kcp_message(conn, data);
+            }
+        });
+        kcp_server_->set_disconnect_callback([this](const net::KcpConnectionPtr& conn) {
+            for (std::size_t i = 0; i < components_.size(); ++i) {
+                components_[i]->on_kcp_disconnect(conn);
+            }
+        });
+        return kcp_server_.get();
+    }
+
+    // 再开一个端口接受网关的多路复用链路（GatewayForwarderComponent::set_multiplex_links），
+    // 链路上的会话消息分发给各组件的 on_mux_message；与客户端共用 I/O 事件循环。需在 start() 之前调用
+    net::MuxServer* listen_mux(unsigned short port) {
+        mux_server_.reset(new net::MuxServer(loops_, port));
+        mux_server_->set_message_callback([this](const net::MuxSessionPtr& session,
+                                                 std::string_view data) {
+            for (std::size_t i = 0; i < components_.size(); ++i) {
+                components_[i]->on_mux_message(session, data);
+            }
+        });
+        mux_server_->set_close_callback([this](const net::MuxSessionPtr& session) {
+            for (std::size_t i = 0; i < components_.size(); ++i) {
+                components_[i]->on_mux_disconnect(session);
+            }
+        });
+        return mux_server_.get();
+    }
+
     void start() {
+        loops_.start();
         server_.start_accept();
+        for (std::size_t i = 0; i < extra_servers_.size(); ++i) {
+            extra_servers_[i]->start_accept();
+        }
+        if (mux_server_) {
+            mux_server_->start();
+        }
+        if (kcp_server_) {
+            kcp_server_->start();
+        }
 
         for (std::size_t i = 0; i < worker_threads_; ++i) {
             thread_pool_.post([this]() {
@@ -87,11 +156,26 @@ public:
     void stop() {
         CHWELL_LOG_INFO("Service stopping");
         server_.stop();
+        for (std::size_t i = 0; i < extra_servers_.size(); ++i) {
+            extra_servers_[i]->stop();
+        }
+        if (mux_server_) {
+            mux_server_->stop();
+        }
+        if (kcp_server_) {
+            kcp_server_->stop();
+        }
+        loops_.stop();
         io_service_.stop();
     }
 
     net::IoService& io_service() { return io_service_; }
+    net::EventLoopThreadPool& event_loops() { return loops_; }
     net::TcpServer& tcp_server() { return server_; }
+    // 未调用 listen_kcp 时为空
+    net::KcpServer* kcp_server() { return kcp_server_.get(); }
+    // 未调用 listen_mux 时为空
+    net::MuxServer* mux_server() { return mux_server_.get(); }
 
 private:
     void dispatch_message(const net::TcpConnectionPtr& conn,
@@ -108,10 +192,14 @@ private:
     }
 
     net::IoService io_service_;
+    net::EventLoopThreadPool loops_;
     net::TcpServer server_;
     core::ThreadPool thread_pool_;
     std::size_t worker_threads_;
     std::vector<std::unique_ptr<Component>> components_;
+    std::vector<std::unique_ptr<net::TcpServer>> extra_servers_;
+    std::unique_ptr<net::KcpServer> kcp_server_;
+    std::unique_ptr<net::MuxServer> mux_server_;
 };
 
 } // namespace service
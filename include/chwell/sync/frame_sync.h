@@ -8,6 +8,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cstdint>
 #include <queue>
@@ -201,10 +202,10 @@ public:
     virtual void on_register(service::Service& svc) override;
 
     // 处理帧输入
-    void handle_frame_input(const net::TcpConnectionPtr& conn, const std::vector<char>& data);
+    void handle_frame_input(const net::TcpConnectionPtr& conn, std::string_view data);
 
     // 处理帧同步请求
-    void handle_frame_sync_req(const net::TcpConnectionPtr& conn, const std::vector<char>& data);
+    void handle_frame_sync_req(const net::TcpConnectionPtr& conn, std::string_view data);
 
     // 创建房间
     void create_room(const std::string& room_id);
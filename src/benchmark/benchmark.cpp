@@ -4,11 +4,25 @@
 #include "chwell/protocol/parser.h"
 #include "chwell/service/protocol_router.h"
 #include "chwell/net/tcp_connection.h"
+#include "chwell/net/tcp_server.h"
+#include "chwell/net/udp_offload.h"
+#include "chwell/net/udp_server.h"
+#include "chwell/net/kcp_server.h"
+#include "chwell/net/ws_deflate.h"
+#include "chwell/net/mux.h"
+#include "chwell/gateway/gateway_forwarder.h"
+#include "chwell/service/service.h"
 #include "chwell/loadbalance/load_balancer.h"
 #include "chwell/loadbalance/consistent_hash.h"
 #include "chwell/discovery/service_discovery.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include <string_view>
 #include <random>
 #include <sstream>
@@ -16,6 +30,16 @@
 #include <iomanip>
 #include <fstream>
 #include <map>
+#include <thread>
+#include <future>
+#include <pthread.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <malloc.h>
+#include <poll.h>
+#include <sys/resource.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
@@ -409,6 +433,28 @@ void benchmark_protocol_parser_parse(size_t iterations, size_t body_size) {
     }
 }
 
+// 零拷贝视图解析基准：与 benchmark_protocol_parser_parse 相同输入，不构造 Message
+void benchmark_protocol_parser_parse_views(size_t iterations, size_t body_size) {
+    std::vector<char> buffer;
+
+    for (size_t i = 0; i < 10; ++i) {
+        protocol::Message msg(1000 + i, std::string(body_size, 'x'));
+        auto serialized = protocol::serialize(msg);
+        buffer.insert(buffer.end(), serialized.begin(), serialized.end());
+    }
+
+    for (size_t i = 0; i < iterations; ++i) {
+        protocol::Parser parser;
+        size_t bytes = 0;
+        size_t count = parser.feed_views(std::string_view(buffer.data(), buffer.size()),
+                                         [&bytes](const protocol::MessageView& msg) {
+            bytes += msg.body.size();
+        });
+        volatile size_t sink = count + bytes;
+        (void)sink;  // 防止被优化掉
+    }
+}
+
 // 协议路由器分发基准测试
 // iterations：每次函数调用中执行的分发次数（测量路由查找 + handler 调用延迟）
 // handlers_count：注册的 handler 数量（衡量哈希表规模对查找的影响）
@@ -433,6 +479,26 @@ void benchmark_protocol_router_dispatch(size_t iterations, size_t handlers_count
     }
 }
 
+// 视图处理器分发基准：参数同 benchmark_protocol_router_dispatch
+void benchmark_protocol_router_dispatch_view(size_t iterations, size_t handlers_count) {
+    service::ProtocolRouterComponent router;
+
+    for (size_t i = 0; i < handlers_count; ++i) {
+        router.register_view_handler(static_cast<std::uint16_t>(1000 + i),
+            [](const net::TcpConnectionPtr&, const protocol::MessageView&) {});
+    }
+
+    protocol::Message msg(static_cast<std::uint16_t>(1000), std::string(100, 'x'));
+    std::vector<char> raw = protocol::serialize(msg);
+
+    net::TcpConnectionPtr bench_conn;
+
+    for (size_t i = 0; i < iterations; ++i) {
+        router.on_message(bench_conn,
+                          std::string_view(raw.data(), raw.size()));
+    }
+}
+
 // 消息创建销毁基准测试
 void benchmark_message_create_destroy(size_t iterations, size_t body_size) {
     for (size_t i = 0; i < iterations; ++i) {
@@ -471,5 +537,821 @@ void benchmark_message_copy_move(size_t iterations, size_t body_size) {
 
 } // namespace protocol_bench
 
+namespace server_bench {
+
+namespace {
+
+const std::uint16_t kBenchCmd = 9001;
+const int kRoundTripTimeoutMs = 5000;
+
+int connect_loopback(unsigned short port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+bool write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool read_all(int fd, char* data, size_t len) {
+    while (len > 0) {
+        pollfd pfd{fd, POLLIN, 0};
+        if (::poll(&pfd, 1, kRoundTripTimeoutMs) <= 0) return false;
+        ssize_t n = ::read(fd, data, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+struct RoundTripFixture::Impl {
+    ServerMode mode{ServerMode::kEcho};
+    net::IoBackend backend{net::IoBackend::kEpoll};
+    std::unique_ptr<net::EventLoopThreadPool> loops;
+    std::unique_ptr<net::TcpServer> server;
+    std::unique_ptr<service::Service> service;
+    std::vector<int> clients;
+    std::vector<char> request;
+    std::vector<char> response;
+    size_t request_size{0};
+};
+
+RoundTripFixture::RoundTripFixture(net::IoBackend backend, ServerMode mode, unsigned short port,
+                                   size_t num_loops, size_t num_clients)
+    : impl_(new Impl()) {
+    impl_->mode = mode;
+    net::TcpServer* server = nullptr;
+    if (mode == ServerMode::kEcho) {
+        impl_->loops.reset(new net::EventLoopThreadPool(num_loops));
+        impl_->loops->set_backend(backend);
+        impl_->loops->start();
+        impl_->backend = impl_->loops->get_loop(0)->backend();
+        impl_->server.reset(new net::TcpServer(*impl_->loops, port));
+        impl_->server->set_message_callback(
+            [](const net::TcpConnectionPtr& conn, std::string_view data) { conn->send(data); });
+        impl_->server->start_accept();
+        server = impl_->server.get();
+    } else {
+        impl_->service.reset(new service::Service(port, num_loops));
+        impl_->service->event_loops().set_backend(backend);
+        service::ProtocolRouterComponent* router =
+            impl_->service->add_component<service::ProtocolRouterComponent>();
+        router->register_handler(kBenchCmd,
+            [](const net::TcpConnectionPtr& conn, const protocol::Message& msg) {
+                service::ProtocolRouterComponent::send_message(conn, msg);
+            });
+        impl_->service->start();
+        impl_->backend = impl_->service->event_loops().get_loop(0)->backend();
+        server = &impl_->service->tcp_server();
+    }
+
+    for (size_t i = 0; i < num_clients; ++i) {
+        int fd = connect_loopback(port);
+        if (fd < 0) {
+            CHWELL_LOG_ERROR("RoundTripFixture: connect to port " << port << " failed");
+            break;
+        }
+        impl_->clients.push_back(fd);
+    }
+    // 等待服务端完成全部连接的注册，避免首轮测量包含 accept
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (server->connection_count() < impl_->clients.size() &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+RoundTripFixture::~RoundTripFixture() {
+    for (int fd : impl_->clients) {
+        ::close(fd);
+    }
+    if (impl_->server) {
+        impl_->server->stop();
+    }
+    if (impl_->loops) {
+        impl_->loops->stop();
+    }
+    impl_->service.reset();
+}
+
+net::IoBackend RoundTripFixture::backend() const {
+    return impl_->backend;
+}
+
+bool RoundTripFixture::ready() const {
+    return !impl_->clients.empty();
+}
+
+bool RoundTripFixture::run(size_t round_trips, size_t msg_size) {
+    if (impl_->request_size != msg_size || impl_->request.empty()) {
+        if (impl_->mode == ServerMode::kEcho) {
+            impl_->request.assign(msg_size, 'x');
+        } else {
+            impl_->request = protocol::serialize(
+                protocol::Message(kBenchCmd, std::string(msg_size, 'x')));
+        }
+        impl_->response.resize(impl_->request.size());
+        impl_->request_size = msg_size;
+    }
+
+    const std::vector<char>& req = impl_->request;
+    for (size_t round = 0; round < round_trips; ++round) {
+        for (int fd : impl_->clients) {
+            if (!write_all(fd, req.data(), req.size())) return false;
+        }
+        for (int fd : impl_->clients) {
+            if (!read_all(fd, impl_->response.data(), impl_->response.size())) return false;
+        }
+    }
+    return true;
+}
+
+// 回显往返：测量 reactor 读 → 回调 → 写 的完整路径
+void benchmark_echo_round_trip(RoundTripFixture& fixture, size_t round_trips, size_t msg_size) {
+    if (!fixture.run(round_trips, msg_size)) {
+        CHWELL_LOG_ERROR("benchmark_echo_round_trip: round trip failed");
+    }
+}
+
+// 协议往返：在回显基础上增加 Parser 解析与 ProtocolRouter 分发
+void benchmark_protocol_round_trip(RoundTripFixture& fixture, size_t round_trips, size_t body_size) {
+    if (!fixture.run(round_trips, body_size)) {
+        CHWELL_LOG_ERROR("benchmark_protocol_round_trip: round trip failed");
+    }
+}
+
+} // namespace server_bench
+
+namespace udp_bench {
+
+namespace {
+
+// 发送窗口：在途数据报不超过该值，避免回环接收缓冲（默认约 200KB，约 90 个 1200B 数据报）溢出
+const size_t kSendWindow = 64;
+// 送达数在该时长内不再增长即视为其余数据报已丢失
+const int kIdleTimeoutMs = 2;
+
+} // anonymous namespace
+
+const char* send_mode_name(SendMode mode) {
+    switch (mode) {
+    case SendMode::kSendTo: return "sendto";
+    case SendMode::kSendBatch: return "sendmmsg";
+    case SendMode::kSegments: return "gso";
+    }
+    return "unknown";
+}
+
+struct UdpLoopbackFixture::Impl {
+    net::IoService io_service;
+    std::unique_ptr<net::UdpServer> server;
+    std::atomic<size_t> received{0};
+    int fd{-1};
+    net::UdpEndpoint dest;
+    std::vector<char> payload;
+    std::vector<net::UdpDatagram> batch;
+
+    // 等待送达数追上 target；送达数停止增长超过 kIdleTimeoutMs 时放弃（其余视为丢失）
+    void wait_received(size_t target) {
+        size_t last = received.load(std::memory_order_acquire);
+        auto idle_deadline = std::chrono::steady_clock::now() +
+                             std::chrono::milliseconds(kIdleTimeoutMs);
+        while (last < target) {
+            std::this_thread::yield();
+            size_t now = received.load(std::memory_order_acquire);
+            if (now != last) {
+                last = now;
+                idle_deadline = std::chrono::steady_clock::now() +
+                                std::chrono::milliseconds(kIdleTimeoutMs);
+            } else if (std::chrono::steady_clock::now() >= idle_deadline) {
+                return;
+            }
+        }
+    }
+};
+
+UdpLoopbackFixture::UdpLoopbackFixture(unsigned short port, bool enable_gro)
+    : impl_(new Impl()) {
+    net::UdpServerConfig config;
+    config.enable_gro = enable_gro;
+    config.max_datagram_size = 2048;
+    impl_->server.reset(new net::UdpServer(impl_->io_service, port, config));
+    Impl* impl = impl_.get();
+    impl_->server->set_batch_callback([impl](const std::vector<net::UdpDatagram>& batch) {
+        impl->received.fetch_add(batch.size(), std::memory_order_release);
+    });
+    impl_->server->start_receive();
+
+    impl_->fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    impl_->dest = net::UdpEndpoint("127.0.0.1", port);
+}
+
+UdpLoopbackFixture::~UdpLoopbackFixture() {
+    if (impl_->fd >= 0) {
+        ::close(impl_->fd);
+    }
+    impl_->server->stop();
+}
+
+bool UdpLoopbackFixture::ready() const {
+    return impl_->fd >= 0 && impl_->server->socket_count() > 0;
+}
+
+size_t UdpLoopbackFixture::received() const {
+    return impl_->received.load();
+}
+
+size_t UdpLoopbackFixture::run(SendMode mode, size_t count, size_t segment_size) {
+    Impl& impl = *impl_;
+    const size_t base = impl.received.load();
+    const size_t chunk = net::kMaxGsoSegments;
+    impl.payload.assign(chunk * segment_size, 'u');
+
+    size_t sent = 0;
+    while (sent < count) {
+        size_t n = std::min(chunk, count - sent);
+        // 发送前等待服务端追上，使在途数据报不超过窗口
+        if (sent + n > kSendWindow) {
+            impl.wait_received(base + sent + n - kSendWindow);
+        }
+        size_t accepted = 0;
+        switch (mode) {
+        case SendMode::kSendTo:
+            for (size_t i = 0; i < n; ++i) {
+                if (::sendto(impl.fd, impl.payload.data(), segment_size, 0,
+                             reinterpret_cast<const sockaddr*>(&impl.dest.addr_),
+                             sizeof(impl.dest.addr_)) > 0) {
+                    ++accepted;
+                }
+            }
+            break;
+        case SendMode::kSendBatch: {
+            // 复用 server 的 send_batch 实现（经由第一个 socket 发出，目的端口同为服务端）
+            impl.batch.resize(n);
+            for (size_t i = 0; i < n; ++i) {
+                impl.batch[i].data = std::string_view(impl.payload.data() + i * segment_size,
+                                                      segment_size);
+                impl.batch[i].remote = impl.dest;
+            }
+            accepted = impl.server->send_batch(impl.batch);
+            break;
+        }
+        case SendMode::kSegments:
+            accepted = net::udp_send_segments(
+                impl.fd, std::string_view(impl.payload.data(), n * segment_size),
+                segment_size, impl.dest);
+            break;
+        }
+        sent += accepted;
+        if (accepted < n) {
+            break; // 发送端缓冲已满，其余不再计入
+        }
+    }
+    impl.wait_received(base + sent);
+    return impl.received.load() - base;
+}
+
+void benchmark_udp_send(UdpLoopbackFixture& fixture, SendMode mode, size_t count, size_t segment_size) {
+    volatile size_t delivered = fixture.run(mode, count, segment_size);
+    (void)delivered;
+}
+
+} // namespace udp_bench
+
+namespace transport_bench {
+
+namespace {
+
+// 最后一个输入发出后等待回显的最长时间
+const int kDrainTimeoutMs = 5000;
+
+typedef std::chrono::steady_clock Clock;
+
+LatencyStats summarize(std::vector<double>& latencies) {
+    LatencyStats stats{latencies.size(), 0.0, 0.0, 0.0};
+    if (latencies.empty()) {
+        return stats;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double q) {
+        size_t rank = static_cast<size_t>(std::ceil(q * static_cast<double>(latencies.size())));
+        return latencies[std::min(latencies.size() - 1, rank > 0 ? rank - 1 : 0)];
+    };
+    stats.p50_ms = percentile(0.50);
+    stats.p99_ms = percentile(0.99);
+    stats.max_ms = latencies.back();
+    return stats;
+}
+
+// 输入消息：前 4 字节为序号，其余填充
+std::string make_input(uint32_t seq, size_t msg_size) {
+    std::string msg(std::max<size_t>(msg_size, sizeof(seq)), 'i');
+    std::memcpy(&msg[0], &seq, sizeof(seq));
+    return msg;
+}
+
+uint32_t input_seq(std::string_view msg) {
+    uint32_t seq = 0;
+    std::memcpy(&seq, msg.data(), std::min(msg.size(), sizeof(seq)));
+    return seq;
+}
+
+double elapsed_ms(Clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+}
+
+} // anonymous namespace
+
+LatencyStats measure_tcp_input_latency(unsigned short port, size_t inputs,
+                                       int send_interval_ms, size_t msg_size) {
+    net::EventLoopThreadPool loops(1);
+    loops.start();
+    net::TcpServer server(loops, port);
+    server.set_message_callback(
+        [](const net::TcpConnectionPtr& conn, std::string_view data) { conn->send(data); });
+    server.start_accept();
+
+    std::vector<double> latencies;
+    int fd = server_bench::connect_loopback(port);
+    if (fd >= 0) {
+        std::vector<Clock::time_point> sent_at(inputs);
+        std::thread sender([&]() {
+            for (size_t i = 0; i < inputs; ++i) {
+                std::string msg = make_input(static_cast<uint32_t>(i), msg_size);
+                sent_at[i] = Clock::now();
+                if (!server_bench::write_all(fd, msg.data(), msg.size())) break;
+                std::this_thread::sleep_for(std::chrono::milliseconds(send_interval_ms));
+            }
+        });
+        // 回显按字节流到达，逐条按定长切分
+        std::string reply(std::max<size_t>(msg_size, sizeof(uint32_t)), '\0');
+        for (size_t i = 0; i < inputs; ++i) {
+            if (!server_bench::read_all(fd, &reply[0], reply.size())) break;
+            uint32_t seq = input_seq(reply);
+            if (seq < inputs) {
+                latencies.push_back(elapsed_ms(sent_at[seq]));
+            }
+        }
+        sender.join();
+        ::close(fd);
+    }
+    server.stop();
+    loops.stop();
+    return summarize(latencies);
+}
+
+LatencyStats measure_kcp_input_latency(const net::KcpConfig& config,
+                                       const net::LinkImpairment& impairment,
+                                       size_t inputs, int send_interval_ms, size_t msg_size) {
+    net::IoService io;
+    net::KcpServer server(io, 0, config);
+    server.set_message_callback(
+        [](const net::KcpConnectionPtr& conn, std::string_view data) { conn->send(data); });
+    net::LinkImpairment server_impairment = impairment;
+    server_impairment.seed = impairment.seed + 1;
+    server.set_impairment(server_impairment);
+    server.start();
+
+    std::vector<Clock::time_point> sent_at(inputs);
+    std::mutex mutex;
+    std::vector<double> latencies;
+    net::KcpServer client(io, 0, config);
+    client.set_accept_sessions(false);
+    client.set_impairment(impairment);
+    client.set_message_callback([&](const net::KcpConnectionPtr&, std::string_view data) {
+        uint32_t seq = input_seq(data);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (seq < inputs) {
+            latencies.push_back(elapsed_ms(sent_at[seq]));
+        }
+    });
+    client.start();
+
+    net::KcpConnectionPtr conn = client.connect(net::UdpEndpoint("127.0.0.1", server.port()), 1);
+    for (size_t i = 0; i < inputs; ++i) {
+        std::string msg = make_input(static_cast<uint32_t>(i), msg_size);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            sent_at[i] = Clock::now();
+        }
+        conn->send(msg);
+        std::this_thread::sleep_for(std::chrono::milliseconds(send_interval_ms));
+    }
+    auto deadline = Clock::now() + std::chrono::milliseconds(kDrainTimeoutMs);
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (latencies.size() >= inputs) break;
+        }
+        if (Clock::now() >= deadline) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    client.stop();
+    server.stop();
+    std::lock_guard<std::mutex> lock(mutex);
+    return summarize(latencies);
+}
+
+} // namespace transport_bench
+
+namespace ws_bench {
+
+namespace {
+
+// 房间状态快照：字段名重复、数值逐 tick 小幅变化
+std::string room_snapshot(size_t tick, size_t players) {
+    std::string json = "{\"type\":\"room_state\",\"tick\":" + std::to_string(tick) + ",\"players\":[";
+    for (size_t i = 0; i < players; ++i) {
+        if (i) json += ",";
+        json += "{\"id\":\"player_" + std::to_string(i) +
+                "\",\"x\":" + std::to_string((tick * 3 + i * 37) % 1000) +
+                ",\"y\":" + std::to_string((tick * 5 + i * 11) % 1000) +
+                ",\"hp\":" + std::to_string(100 - (tick + i) % 30) +
+                ",\"state\":\"" + ((tick + i) % 3 ? "moving" : "idle") + "\"}";
+    }
+    return json + "]}";
+}
+
+double elapsed_us(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+std::vector<DeflateCost> measure_deflate_cost(size_t recipients, size_t ticks, size_t players,
+                                              int level) {
+    std::vector<std::string> snapshots;
+    for (size_t t = 0; t < ticks; ++t) {
+        snapshots.push_back(room_snapshot(t, players));
+    }
+    net::WsDeflateConfig config;
+    config.enabled = true;
+    config.level = level;
+    config.min_size = 0;
+
+    std::vector<DeflateCost> results;
+    std::string buffer;
+    char header[net::kWsMaxHeaderSize];
+
+    // 不压缩：每个接收者一帧
+    {
+        DeflateCost cost{"none", 0, 0, 0.0};
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string& snap : snapshots) {
+            for (size_t r = 0; r < recipients; ++r) {
+                cost.raw_bytes += snap.size();
+                cost.wire_bytes += net::ws_encode_header(header, net::WsOpcode::kText, snap.size()) + snap.size();
+            }
+        }
+        cost.cpu_us_per_tick = elapsed_us(start) / static_cast<double>(ticks);
+        results.push_back(cost);
+    }
+
+    // 每连接独立压缩器，跨消息保留滑动窗口
+    {
+        DeflateCost cost{"per-connection context", 0, 0, 0.0};
+        std::vector<std::unique_ptr<net::WsDeflater>> deflaters;
+        for (size_t r = 0; r < recipients; ++r) {
+            deflaters.emplace_back(new net::WsDeflater(level, 15, 8, false));
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string& snap : snapshots) {
+            for (size_t r = 0; r < recipients; ++r) {
+                deflaters[r]->compress(snap, &buffer);
+                cost.raw_bytes += snap.size();
+                cost.wire_bytes += net::ws_encode_header(header, net::WsOpcode::kText, buffer.size()) + buffer.size();
+            }
+        }
+        cost.cpu_us_per_tick = elapsed_us(start) / static_cast<double>(ticks);
+        results.push_back(cost);
+    }
+
+    // 共享上下文：一个压缩器，每条消息独立压缩，但仍逐接收者压缩
+    {
+        DeflateCost cost{"shared context", 0, 0, 0.0};
+        net::WsSharedDeflater shared(config);
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string& snap : snapshots) {
+            for (size_t r = 0; r < recipients; ++r) {
+                shared.compress(snap, &buffer);
+                cost.raw_bytes += snap.size();
+                cost.wire_bytes += net::ws_encode_header(header, net::WsOpcode::kText, buffer.size()) + buffer.size();
+            }
+        }
+        cost.cpu_us_per_tick = elapsed_us(start) / static_cast<double>(ticks);
+        results.push_back(cost);
+    }
+
+    // 广播只压缩一次（ws_prepare_message），各接收者共享同一压缩帧
+    {
+        DeflateCost cost{"prepared broadcast", 0, 0, 0.0};
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string& snap : snapshots) {
+            net::WsPreparedMessage prepared = net::ws_prepare_message(net::WsOpcode::kText, snap, config);
+            const net::SharedFrame& frame = prepared.deflated.empty() ? prepared.plain : prepared.deflated;
+            cost.raw_bytes += snap.size() * recipients;
+            cost.wire_bytes += frame.size() * recipients;
+        }
+        cost.cpu_us_per_tick = elapsed_us(start) / static_cast<double>(ticks);
+        results.push_back(cost);
+    }
+    return results;
+}
+
+} // namespace ws_bench
+
+namespace conn_bench {
+
+namespace {
+
+const std::uint16_t kHeartbeatCmd = 9002;
+// 同一 (源地址, 目的地址, 目的端口) 可用的临时端口有限，每个源地址只用这么多
+const size_t kConnectionsPerSourceAddr = 20000;
+// 同进程内服务端与客户端之外保留的 fd（日志、监听 socket、epoll、eventfd 等）
+const size_t kReservedFds = 256;
+
+size_t heap_in_use() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = ::mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+size_t resident_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0;
+    size_t resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+}
+
+// 把 fd 软上限提到硬上限，返回可建立的回环连接数上限
+size_t max_loopback_connections() {
+    struct rlimit lim;
+    if (::getrlimit(RLIMIT_NOFILE, &lim) != 0) {
+        return 0;
+    }
+    if (lim.rlim_cur < lim.rlim_max) {
+        lim.rlim_cur = lim.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &lim);
+        ::getrlimit(RLIMIT_NOFILE, &lim);
+    }
+    size_t fds = static_cast<size_t>(lim.rlim_cur);
+    return fds > kReservedFds ? (fds - kReservedFds) / 2 : 0;
+}
+
+int connect_from(unsigned short port, size_t index) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    size_t source = index / kConnectionsPerSourceAddr;
+    if (source > 0) {
+        sockaddr_in local{};
+        local.sin_family = AF_INET;
+        local.sin_addr.s_addr = htonl(INADDR_LOOPBACK + static_cast<std::uint32_t>(source + 1));
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+            ::close(fd);
+            return -1;
+        }
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+} // namespace
+
+ConnectionFootprint measure_idle_connection_footprint(unsigned short port, size_t connections,
+                                                      bool low_memory, size_t num_loops) {
+    ConnectionFootprint result{connections, 0, 0.0, 0.0, 0.0};
+    const size_t limit = max_loopback_connections();
+    if (connections > limit) {
+        connections = limit;
+    }
+
+    // 每个连接的接入 / 断开都会打 INFO 日志，测量期间只保留告警
+    core::Logger& logger = core::Logger::instance();
+    const core::LogLevel saved_level = logger.level();
+    logger.set_level(core::LogLevel::Warn);
+
+    std::atomic<size_t> heartbeats{0};
+    {
+        service::Service svc(port, num_loops);
+        net::TcpServerConfig config;
+        config.backlog = 4096;
+        config.low_memory = low_memory;
+        svc.tcp_server().set_config(config);
+        service::ProtocolRouterComponent* router = svc.add_component<service::ProtocolRouterComponent>();
+        router->register_view_handler(kHeartbeatCmd,
+            [&heartbeats](const net::TcpConnectionPtr&, const protocol::MessageView&) {
+                heartbeats.fetch_add(1, std::memory_order_relaxed);
+            });
+        svc.start();
+
+        const std::vector<char> heartbeat =
+            protocol::serialize(protocol::Message(kHeartbeatCmd, std::string(8, 'h')));
+        std::vector<int> clients;
+        clients.reserve(connections);
+
+#if defined(__GLIBC__)
+        ::malloc_trim(0);  // 归还此前测量释放的内存，RSS 基线不含可复用的空闲页
+#endif
+        const size_t heap_before = heap_in_use();
+        const size_t rss_before = resident_bytes();
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < connections; ++i) {
+            int fd = connect_from(port, i);
+            if (fd < 0) {
+                CHWELL_LOG_WARN("measure_idle_connection_footprint: connect #" << i
+                                << " failed: " << strerror(errno));
+                break;
+            }
+            clients.push_back(fd);
+            if (!server_bench::write_all(fd, heartbeat.data(), heartbeat.size())) {
+                break;
+            }
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while ((svc.tcp_server().connection_count() < clients.size() ||
+                heartbeats.load(std::memory_order_relaxed) < clients.size()) &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        result.connect_seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        result.connections = svc.tcp_server().connection_count();
+
+        if (result.connections > 0) {
+            const double n = static_cast<double>(result.connections);
+            result.heap_bytes_per_conn =
+                (static_cast<double>(heap_in_use()) - static_cast<double>(heap_before)) / n;
+            result.rss_bytes_per_conn =
+                (static_cast<double>(resident_bytes()) - static_cast<double>(rss_before)) / n;
+        }
+
+        for (int fd : clients) {
+            ::close(fd);
+        }
+        deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (svc.tcp_server().connection_count() > 0 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        svc.stop();
+    }
+    logger.set_level(saved_level);
+    return result;
+}
+
+} // namespace conn_bench
+
+namespace gateway_bench {
+
+namespace {
+
+const std::uint16_t kForwardCmd = 9003;
+
+double thread_cpu_us(clockid_t clock) {
+    timespec ts{};
+    ::clock_gettime(clock, &ts);
+    return static_cast<double>(ts.tv_sec) * 1e6 + static_cast<double>(ts.tv_nsec) / 1e3;
+}
+
+} // namespace
+
+ForwardCost measure_forward_cost(unsigned short backend_port, unsigned short front_port,
+                                 size_t clients, size_t rounds, size_t body_size,
+                                 size_t batch_bytes) {
+    ForwardCost result{batch_bytes, 0, 0.0, 0.0};
+
+    core::Logger& logger = core::Logger::instance();
+    const core::LogLevel saved_level = logger.level();
+    logger.set_level(core::LogLevel::Warn);
+
+    // 逻辑服：按会话原样回显
+    net::EventLoopThreadPool backend_loops(1);
+    backend_loops.start();
+    net::MuxServer backend(backend_loops, backend_port);
+    backend.set_batch_bytes(batch_bytes);
+    backend.set_message_callback([](const net::MuxSessionPtr& session, std::string_view data) {
+        session->send(data);
+    });
+    backend.start();
+
+    // 网关：前端连接与链路在同一个 loop 线程，CPU 时间只计这一线程
+    net::EventLoopThreadPool gateway_loops(1);
+    gateway_loops.start();
+    gateway::GatewayForwarderComponent forwarder("127.0.0.1", backend_port);
+    forwarder.set_multiplex_links(1);
+    forwarder.set_link_batch_bytes(batch_bytes);
+    std::unordered_map<const net::TcpConnection*, protocol::Parser> parsers;  // 仅网关 loop 线程访问
+    net::TcpServer front(gateway_loops, front_port);
+    front.set_message_callback([&](const net::TcpConnectionPtr& conn, std::string_view data) {
+        for (const protocol::Message& msg : parsers[conn.get()].feed(data)) {
+            forwarder.forward(conn, msg);
+        }
+    });
+    front.set_disconnect_callback([&](const net::TcpConnectionPtr& conn) {
+        parsers.erase(conn.get());
+        forwarder.on_disconnect(conn);
+    });
+    front.start_accept();
+
+    std::promise<clockid_t> clock_promise;
+    gateway_loops.get_loop(0)->run_in_loop([&clock_promise]() {
+        clockid_t clock;
+        ::pthread_getcpuclockid(::pthread_self(), &clock);
+        clock_promise.set_value(clock);
+    });
+    const clockid_t gateway_clock = clock_promise.get_future().get();
+
+    const std::vector<char> request =
+        protocol::serialize(protocol::Message(kForwardCmd, std::string(body_size, 'g')));
+    std::vector<char> response(request.size());
+    std::vector<int> fds;
+    for (size_t i = 0; i < clients; ++i) {
+        int fd = server_bench::connect_loopback(front_port);
+        if (fd < 0) break;
+        fds.push_back(fd);
+    }
+
+    auto run_round = [&]() {
+        for (int fd : fds) {
+            if (!server_bench::write_all(fd, request.data(), request.size())) return false;
+        }
+        for (int fd : fds) {
+            if (!server_bench::read_all(fd, response.data(), response.size())) return false;
+        }
+        return true;
+    };
+
+    // 预热：建立会话与链路
+    if (fds.size() == clients && run_round()) {
+        const gateway::GatewayForwarderComponent::MuxLinkStats before = forwarder.mux_link_stats();
+        const double cpu_before = thread_cpu_us(gateway_clock);
+        size_t done = 0;
+        while (done < rounds && run_round()) {
+            ++done;
+        }
+        const double cpu = thread_cpu_us(gateway_clock) - cpu_before;
+        const gateway::GatewayForwarderComponent::MuxLinkStats after = forwarder.mux_link_stats();
+
+        result.messages = done * clients;
+        if (result.messages > 0) {
+            result.cpu_us_per_msg = cpu / static_cast<double>(result.messages);
+        }
+        const std::uint64_t writes = after.writes - before.writes;
+        if (writes > 0) {
+            result.frames_per_write =
+                static_cast<double>(after.frames - before.frames) / static_cast<double>(writes);
+        }
+    }
+
+    for (int fd : fds) {
+        ::close(fd);
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (backend.session_count() > 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    front.stop();
+    backend.stop();
+    gateway_loops.stop();
+    backend_loops.stop();
+    logger.set_level(saved_level);
+    return result;
+}
+
+} // namespace gateway_bench
+
 } // namespace benchmark
 } // namespace chwell
@@ -6,17 +6,60 @@
 namespace chwell {
 namespace codec {
 
-void LengthHeaderCodec::compact_prefix() {
-    if (head_ == 0) {
-        return;
+namespace {
+
+// 帧切分函数：在 [data, data+size) 起始处识别一帧，
+// 成功时写 body 偏移与长度并返回 true，数据不完整返回 false
+typedef bool (*FrameSplitter)(const char* data, std::size_t size,
+                              std::size_t& body_offset, std::size_t& body_len);
+
+std::size_t split_frames(const char* data, std::size_t size, FrameSplitter split,
+                         std::vector<std::string>& messages) {
+    std::size_t pos = 0;
+    std::size_t body_offset = 0;
+    std::size_t body_len = 0;
+    while (pos < size && split(data + pos, size - pos, body_offset, body_len)) {
+        messages.emplace_back(data + pos + body_offset, body_len);
+        pos += body_offset + body_len;
     }
-    // 已消费前缀较大时前移，避免每帧 O(n) erase
-    if (head_ >= 4096 && head_ * 2 >= buffer_.size()) {
-        buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(head_));
-        head_ = 0;
+    return pos;
+}
+
+// 流式解码公共部分：无残帧时直接解析输入，只把末尾残帧拷入 buffer
+std::vector<std::string> decode_stream(net::Buffer& buffer, std::string_view data,
+                                       FrameSplitter split) {
+    std::vector<std::string> messages;
+    if (buffer.empty()) {
+        std::size_t consumed = split_frames(data.data(), data.size(), split, messages);
+        if (consumed < data.size()) {
+            buffer.append(data.data() + consumed, data.size() - consumed);
+        }
+        return messages;
     }
+    buffer.append(data);
+    buffer.retrieve(split_frames(buffer.peek(), buffer.readable_bytes(), split, messages));
+    return messages;
 }
 
+// | length (4 bytes, network byte order) | body |
+bool split_length_header(const char* data, std::size_t size,
+                         std::size_t& body_offset, std::size_t& body_len) {
+    if (size < 4) {
+        return false;
+    }
+    std::uint32_t len_net;
+    std::memcpy(&len_net, data, 4);
+    std::uint32_t len = core::net_to_host32(len_net);
+    if (size - 4 < len) {
+        return false;
+    }
+    body_offset = 4;
+    body_len = len;
+    return true;
+}
+
+} // anonymous namespace
+
 std::vector<char> LengthHeaderCodec::encode(const std::string& message) {
     std::uint32_t len = static_cast<std::uint32_t>(message.size());
     std::uint32_t len_net = core::host_to_net32(len);
@@ -29,41 +72,8 @@ std::vector<char> LengthHeaderCodec::encode(const std::string& message) {
     return result;
 }
 
-std::vector<std::string> LengthHeaderCodec::decode(const std::vector<char>& data) {
-    std::vector<std::string> messages;
-
-    buffer_.insert(buffer_.end(), data.begin(), data.end());
-
-    while (true) {
-        std::size_t avail = buffer_.size() - head_;
-        if (avail < 4) {
-            break;
-        }
-
-        std::uint32_t len_net;
-        std::memcpy(&len_net, buffer_.data() + head_, 4);
-        std::uint32_t body_len = core::net_to_host32(len_net);
-
-        if (avail < 4 + body_len) {
-            break;
-        }
-
-        messages.emplace_back(buffer_.data() + head_ + 4, body_len);
-        head_ += 4 + body_len;
-    }
-
-    compact_prefix();
-    return messages;
-}
-
-void JsonCodec::compact_prefix() {
-    if (head_ == 0) {
-        return;
-    }
-    if (head_ >= 4096 && head_ * 2 >= buffer_.size()) {
-        buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(head_));
-        head_ = 0;
-    }
+std::vector<std::string> LengthHeaderCodec::decode(std::string_view data) {
+    return decode_stream(buffer_, data, split_length_header);
 }
 
 std::vector<char> JsonCodec::encode(const std::string& message) {
@@ -78,31 +88,8 @@ std::vector<char> JsonCodec::encode(const std::string& message) {
     return result;
 }
 
-std::vector<std::string> JsonCodec::decode(const std::vector<char>& data) {
-    std::vector<std::string> messages;
-
-    buffer_.insert(buffer_.end(), data.begin(), data.end());
-
-    while (true) {
-        std::size_t avail = buffer_.size() - head_;
-        if (avail < 4) {
-            break;
-        }
-
-        std::uint32_t len_net;
-        std::memcpy(&len_net, buffer_.data() + head_, 4);
-        std::uint32_t body_len = core::net_to_host32(len_net);
-
-        if (avail < 4 + body_len) {
-            break;
-        }
-
-        messages.emplace_back(buffer_.data() + head_ + 4, body_len);
-        head_ += 4 + body_len;
-    }
-
-    compact_prefix();
-    return messages;
+std::vector<std::string> JsonCodec::decode(std::string_view data) {
+    return decode_stream(buffer_, data, split_length_header);
 }
 
 namespace {
@@ -115,14 +102,14 @@ inline void append_varint32(std::vector<char>& out, std::uint32_t value) {
     out.push_back(static_cast<char>(value & 0x7Fu));
 }
 
-// 从 buffer[pos...] 解析一个 varint32，成功则写 len 和新位置；失败返回 false
-inline bool parse_varint32(const std::vector<char>& buf,
+// 从 data[pos...] 解析一个 varint32，成功则写 len 和新位置；失败返回 false
+inline bool parse_varint32(const char* data, std::size_t size,
                            std::size_t& pos,
                            std::uint32_t& len) {
     std::uint32_t result = 0;
     int shift = 0;
-    while (pos < buf.size() && shift <= 28) {
-        unsigned char byte = static_cast<unsigned char>(buf[pos++]);
+    while (pos < size && shift <= 28) {
+        unsigned char byte = static_cast<unsigned char>(data[pos++]);
         result |= static_cast<std::uint32_t>(byte & 0x7Fu) << shift;
         if ((byte & 0x80u) == 0) {
             len = result;
@@ -133,6 +120,19 @@ inline bool parse_varint32(const std::vector<char>& buf,
     return false;
 }
 
+// [len(varint32)][body]
+bool split_varint32(const char* data, std::size_t size,
+                    std::size_t& body_offset, std::size_t& body_len) {
+    std::size_t pos = 0;
+    std::uint32_t len = 0;
+    if (!parse_varint32(data, size, pos, len) || size - pos < len) {
+        return false;
+    }
+    body_offset = pos;
+    body_len = len;
+    return true;
+}
+
 } // anonymous namespace
 
 std::vector<char> ProtobufCodec::encode(const std::string& message) {
@@ -145,39 +145,8 @@ std::vector<char> ProtobufCodec::encode(const std::string& message) {
     return out;
 }
 
-void ProtobufCodec::compact_prefix() {
-    if (head_ == 0) {
-        return;
-    }
-    if (head_ >= 4096 && head_ * 2 >= buffer_.size()) {
-        buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(head_));
-        head_ = 0;
-    }
-}
-
-std::vector<std::string> ProtobufCodec::decode(const std::vector<char>& data) {
-    std::vector<std::string> result;
-    buffer_.insert(buffer_.end(), data.begin(), data.end());
-
-    std::size_t pos = head_;
-    while (pos < buffer_.size()) {
-        std::size_t saved_pos = pos;
-        std::uint32_t len = 0;
-        if (!parse_varint32(buffer_, pos, len)) {
-            pos = saved_pos;
-            break;
-        }
-        if (buffer_.size() - pos < len) {
-            pos = saved_pos;
-            break;
-        }
-        result.emplace_back(buffer_.data() + pos, len);
-        pos += len;
-    }
-
-    head_ = pos;
-    compact_prefix();
-    return result;
+std::vector<std::string> ProtobufCodec::decode(std::string_view data) {
+    return decode_stream(buffer_, data, split_varint32);
 }
 
 } // namespace codec
@@ -28,7 +28,7 @@ void Logger::set_level(LogLevel level) {
 
 void Logger::log(LogLevel level, const std::string& msg) {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (static_cast<int>(level) < static_cast<int>(current_level_)) {
+    if (!enabled(level)) {
         return;
     }
 
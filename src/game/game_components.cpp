@@ -227,22 +227,24 @@ void ChatComponent::broadcast_chat(const std::string& room_id, const std::string
     // 获取房间内所有连接
     auto connections = room_comp->get_connections_in_room(room_id);
 
-    // 广播聊天消息
-    for (const auto& conn : connections) {
-        send_chat_message(conn, from_player_id, content);
-    }
+    // 广播聊天消息：编码一次，各连接共享同一帧
+    service::ProtocolRouterComponent::broadcast_message(connections,
+                                                        make_chat_message(from_player_id, content));
 
     CHWELL_LOG_INFO("Broadcast chat to room " + room_id + ": " + from_player_id + " -> " + content + " (" + std::to_string(connections.size()) + " players)");
 }
 
 void ChatComponent::send_chat_message(const net::TcpConnectionPtr& conn, const std::string& from_player_id, const std::string& content) {
+    service::ProtocolRouterComponent::send_message(conn, make_chat_message(from_player_id, content));
+}
+
+protocol::Message ChatComponent::make_chat_message(const std::string& from_player_id, const std::string& content) {
     // 编码: [from_player_id_len][from_player_id][content_len][content]
     std::string body;
     body += encode_string(from_player_id);
     body += encode_string(content);
 
-    protocol::Message msg(cmd::S2C_CHAT, std::vector<char>(body.begin(), body.end()));
-    service::ProtocolRouterComponent::send_message(conn, msg);
+    return protocol::Message(cmd::S2C_CHAT, body);
 }
 
 // ============================================
@@ -415,6 +417,13 @@ void HeartbeatComponent::on_register(service::Service& svc) {
             });
         CHWELL_LOG_INFO("HeartbeatComponent registered handler for C2S_HEARTBEAT");
     }
+
+    net::TcpServerConfig config = svc.tcp_server().config();
+    if (config.idle.read_idle_ms == 0) {
+        config.idle.read_idle_ms = HEARTBEAT_TIMEOUT * 1000;
+        svc.tcp_server().set_config(config);
+        CHWELL_LOG_INFO("HeartbeatComponent: closing connections idle for " << HEARTBEAT_TIMEOUT << "s");
+    }
 }
 
 void HeartbeatComponent::handle_heartbeat(const net::TcpConnectionPtr& conn, const std::vector<char>& data) {
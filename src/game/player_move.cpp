@@ -57,15 +57,15 @@ void PlayerMoveComponent::on_register(service::Service& svc) {
 
     auto* router = svc.get_component<service::ProtocolRouterComponent>();
     if (router) {
-        router->register_handler(move_cmd::C2S_PLAYER_MOVE,
-            [this](const net::TcpConnectionPtr& conn, const protocol::Message& msg) {
+        router->register_view_handler(move_cmd::C2S_PLAYER_MOVE,
+            [this](const net::TcpConnectionPtr& conn, const protocol::MessageView& msg) {
                 this->handle_player_move(conn, msg.body);
             });
         CHWELL_LOG_INFO("PlayerMoveComponent registered handler for C2S_PLAYER_MOVE");
     }
 }
 
-void PlayerMoveComponent::handle_player_move(const net::TcpConnectionPtr& conn, const std::vector<char>& data) {
+void PlayerMoveComponent::handle_player_move(const net::TcpConnectionPtr& conn, std::string_view data) {
     // 解析: [x(4 bytes)][y(4 bytes)][z(4 bytes)]
     const char* ptr = data.data();
     size_t size = data.size();
@@ -92,10 +92,8 @@ void PlayerMoveComponent::handle_player_move(const net::TcpConnectionPtr& conn,
         return;
     }
 
-    CHWELL_LOG_INFO("Player move: player_id=" + player_id +
-                    ", x=" + std::to_string(x) +
-                    ", y=" + std::to_string(y) +
-                    ", z=" + std::to_string(z));
+    CHWELL_LOG_DEBUG("Player move: player_id=" << player_id
+                     << ", x=" << x << ", y=" << y << ", z=" << z);
 
     // 更新玩家位置
     PlayerPosition pos(x, y, z);
@@ -124,10 +122,9 @@ void PlayerMoveComponent::broadcast_player_position(const std::string& room_id,
     // 获取房间内所有连接
     auto connections = room_comp->get_connections_in_room(room_id);
 
-    // 广播玩家位置
-    for (const auto& conn : connections) {
-        send_player_position(conn, player_id, pos);
-    }
+    // 广播玩家位置：编码一次，各连接共享同一帧
+    service::ProtocolRouterComponent::broadcast_message(connections,
+                                                        make_position_message(player_id, pos));
 
     CHWELL_LOG_INFO("Broadcast player position to room " + room_id + ": " + player_id + " -> (" +
                     std::to_string(pos.x) + ", " + std::to_string(pos.y) + ", " + std::to_string(pos.z) +
@@ -135,6 +132,10 @@ void PlayerMoveComponent::broadcast_player_position(const std::string& room_id,
 }
 
 void PlayerMoveComponent::send_player_position(const net::TcpConnectionPtr& conn, const std::string& player_id, const PlayerPosition& pos) {
+    service::ProtocolRouterComponent::send_message(conn, make_position_message(player_id, pos));
+}
+
+protocol::Message PlayerMoveComponent::make_position_message(const std::string& player_id, const PlayerPosition& pos) {
     // 编码: [player_id_len][player_id][x(4 bytes)][y(4 bytes)][z(4 bytes)]
     std::string body;
 
@@ -146,8 +147,7 @@ void PlayerMoveComponent::send_player_position(const net::TcpConnectionPtr& conn
     body += encode_float(pos.y);
     body += encode_float(pos.z);
 
-    protocol::Message msg(move_cmd::S2C_PLAYER_POS, std::vector<char>(body.begin(), body.end()));
-    service::ProtocolRouterComponent::send_message(conn, msg);
+    return protocol::Message(move_cmd::S2C_PLAYER_POS, body);
 }
 
 void PlayerMoveComponent::update_player_position(const std::string& player_id, const PlayerPosition& pos) {
@@ -1,22 +1,30 @@
 #include "chwell/gateway/gateway_forwarder.h"
 #include "chwell/core/logger.h"
+#include "chwell/metrics/event_counter.h"
 #include "chwell/service/service.h"
 #include "chwell/service/protocol_router.h"
 #include "chwell/protocol/message.h"
 #include "chwell/net/posix_io.h"
 #include "chwell/net/tcp_connection.h"
+#include "chwell/net/event_loop.h"
 
+#include <cerrno>
+#include <chrono>
 #include <cstring>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
-#include <unistd.h>
-#include <sstream>
 #include <cstdint>
 
 namespace chwell {
 namespace gateway {
 
+namespace {
+
+std::int64_t steady_now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // anonymous namespace
+
 GatewayForwarderComponent::GatewayForwarderComponent(
     const std::string& backend_host, unsigned short backend_port)
     : backend_host_(backend_host)
@@ -34,12 +42,45 @@ void GatewayForwarderComponent::on_register(service::Service& svc) {
 }
 
 void GatewayForwarderComponent::on_disconnect(const net::TcpConnectionPtr& conn) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = client_to_backend_.find(conn.get());
-    if (it != client_to_backend_.end()) {
-        net::TcpConnectionPtr backend = it->second;
-        backend_to_client_.erase(backend.get());
-        client_to_backend_.erase(it);
+    net::MuxBatcherPtr batcher;
+    std::uint32_t session = 0;
+    net::TcpConnectionPtr backend;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto route = mux_routes_.find(conn.get());
+        if (route != mux_routes_.end()) {
+            // 多路复用：通知后端结束会话，链路保持；链路未就绪时排在暂存帧之后
+            MuxLinkPtr link = route->second.link;
+            session = route->second.session;
+            mux_routes_.erase(route);
+            link->sessions.erase(session);
+            if (link->conn) {
+                batcher = link->batcher;
+            } else {
+                std::string frame(net::mux::kHeaderSize, '\0');
+                net::mux::encode_header(&frame[0], session, net::mux::kClose, 0);
+                link->queued.push_back(MuxLink::Queued{session, false, 0, std::move(frame)});
+            }
+        }
+
+        auto pending = pending_.find(conn.get());
+        if (pending != pending_.end()) {
+            // 建连尚未完成：放弃连接，回调找不到暂存项后关闭 socket
+            pending->second.connector->cancel();
+            pending_.erase(pending);
+        }
+        auto it = client_to_backend_.find(conn.get());
+        if (it != client_to_backend_.end()) {
+            backend = it->second;
+            backend_to_client_.erase(backend.get());
+            client_to_backend_.erase(it);
+        }
+    }
+    if (batcher) {
+        batcher->append(session, net::mux::kClose);
+    }
+    // 在锁外关闭：后端与客户端可能同属一个 loop，close 会就地回调 on_backend_close
+    if (backend) {
         backend->close();
         CHWELL_LOG_INFO("Gateway: closed backend connection for client disconnect");
     }
@@ -47,13 +88,37 @@ void GatewayForwarderComponent::on_disconnect(const net::TcpConnectionPtr& conn)
 
 bool GatewayForwarderComponent::has_backend(const net::TcpConnectionPtr& client_conn) const {
     std::lock_guard<std::mutex> lock(mutex_);
+    auto route = mux_routes_.find(client_conn.get());
+    if (route != mux_routes_.end()) {
+        return route->second.link->conn != nullptr;
+    }
     return client_to_backend_.find(client_conn.get()) != client_to_backend_.end();
 }
 
-net::TcpConnectionPtr GatewayForwarderComponent::connect_backend(
-    const net::TcpConnectionPtr& client_conn) {
-    std::string host = backend_host_;
-    unsigned short port = backend_port_;
+std::size_t GatewayForwarderComponent::backend_socket_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t n = client_to_backend_.size();
+    for (const auto& kv : links_) {
+        for (const MuxLinkPtr& link : kv.second) {
+            if (link->conn) {
+                ++n;
+            }
+        }
+    }
+    return n;
+}
+
+bool GatewayForwarderComponent::backend_ejected(const std::string& host,
+                                                unsigned short port) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = health_.find(host + ":" + std::to_string(port));
+    return it != health_.end() && it->second.tripped();
+}
+
+bool GatewayForwarderComponent::resolve_backend(const net::TcpConnectionPtr& client_conn,
+                                                std::string& host, unsigned short& port) {
+    host = backend_host_;
+    port = backend_port_;
 
     if (!backend_node_type_.empty()) {
         // Ensure registry is loaded (lazy init, not static globals)
@@ -79,43 +144,123 @@ net::TcpConnectionPtr GatewayForwarderComponent::connect_backend(
         }
     }
 
-    return do_connect(client_conn, host, port);
-}
-
-net::TcpConnectionPtr GatewayForwarderComponent::do_connect(
-    const net::TcpConnectionPtr& client_conn,
-    const std::string& host, unsigned short port) {
-
     if (host.empty() || port == 0) {
         CHWELL_LOG_ERROR("Gateway: invalid backend address " + host + ":"
                          + std::to_string(port));
-        return nullptr;
+        return false;
     }
+    return true;
+}
+
+net::BackendHealth& GatewayForwarderComponent::health_locked(const std::string& addr) {
+    auto health = health_.find(addr);
+    if (health == health_.end()) {
+        health = health_.emplace(addr, net::BackendHealth(ejection_)).first;
+    }
+    return health->second;
+}
 
-    int fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (fd < 0) {
-        CHWELL_LOG_ERROR("Gateway: socket failed");
-        return nullptr;
+bool GatewayForwarderComponent::connect_backend(const net::TcpConnectionPtr& client_conn,
+                                                const protocol::Message& msg) {
+    std::string host;
+    unsigned short port = 0;
+    if (!resolve_backend(client_conn, host, port)) {
+        return false;
     }
 
-    sockaddr_in addr{};
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
-    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) <= 0) {
-        CHWELL_LOG_ERROR("Gateway: invalid backend address " + host);
-        close(fd);
-        return nullptr;
+    // 建连放在客户端所属的 loop 上，回调与客户端读写在同一线程；阻塞模式的客户端取任一 I/O loop
+    net::EventLoop* loop = client_conn->loop();
+    if (!loop && service_) {
+        loop = service_->event_loops().next_loop();
+    }
+    if (!loop) {
+        CHWELL_LOG_ERROR("Gateway: no event loop available for backend connect");
+        return false;
     }
 
-    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
-        CHWELL_LOG_ERROR("Gateway: connect to backend " + host + ":"
-                         + std::to_string(port) + " failed: " + strerror(errno));
-        close(fd);
-        return nullptr;
+    const std::string addr = host + ":" + std::to_string(port);
+    std::weak_ptr<net::TcpConnection> weak_client = client_conn;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!health_locked(addr).allow(steady_now_ms())) {
+        return false;  // 后端已摘除，退避期内不再建连
     }
 
-    net::TcpSocket socket(fd);
-    net::TcpConnectionPtr backend = std::make_shared<net::TcpConnection>(std::move(socket));
+    PendingBackend& pending = pending_[client_conn.get()];
+    pending.queued.push_back(msg);
+    // 回调总是经 loop 队列执行，持锁发起是安全的
+    pending.connector = net::Connector::start(
+        loop, host, port, connect_timeout_ms_,
+        [this, weak_client, loop, addr](net::TcpSocket socket, int err) {
+            on_backend_connected(weak_client, loop, addr, std::move(socket), err);
+        });
+    return true;
+}
+
+void GatewayForwarderComponent::on_backend_connected(
+    const std::weak_ptr<net::TcpConnection>& weak_client, net::EventLoop* loop,
+    const std::string& addr, net::TcpSocket socket, int err) {
+    net::TcpConnectionPtr client_conn = weak_client.lock();
+    std::vector<protocol::Message> queued;
+    bool waiting = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (err != ECANCELED) {
+            record_connect_result_locked(addr, err);
+        }
+        if (client_conn) {
+            auto it = pending_.find(client_conn.get());
+            if (it != pending_.end()) {
+                queued.swap(it->second.queued);
+                pending_.erase(it);
+                waiting = true;
+            }
+        }
+    }
+
+    // 客户端已断开：socket 随之关闭
+    if (!waiting || client_conn->is_closed()) {
+        return;
+    }
+
+    if (err != 0) {
+        CHWELL_LOG_ERROR("Gateway: connect to backend " + addr + " failed: " + strerror(err));
+        for (const protocol::Message& msg : queued) {
+            reply_unavailable(client_conn, msg.cmd);
+        }
+        return;
+    }
+
+    net::TcpConnectionPtr backend = attach_backend(client_conn, loop, std::move(socket));
+    CHWELL_LOG_INFO("Gateway: connected to backend " + addr);
+    std::vector<char> data;
+    for (const protocol::Message& msg : queued) {
+        if (encode_relay(client_conn, msg, data)) {
+            backend->send(data);
+        }
+    }
+}
+
+void GatewayForwarderComponent::record_connect_result_locked(const std::string& addr, int err) {
+    net::BackendHealth& health = health_locked(addr);
+    if (err == 0) {
+        if (health.tripped()) {
+            CHWELL_LOG_INFO("Gateway: backend " + addr + " is reachable again");
+        }
+        health.on_success();
+        return;
+    }
+    health.on_failure(steady_now_ms());
+    if (health.consecutive_failures() == health.policy().eject_after_failures) {
+        CHWELL_LOG_WARN("Gateway: ejecting backend " + addr + " after "
+                        + std::to_string(health.consecutive_failures())
+                        + " consecutive connect failures");
+    }
+}
+
+net::TcpConnectionPtr GatewayForwarderComponent::attach_backend(
+    const net::TcpConnectionPtr& client_conn, net::EventLoop* loop, net::TcpSocket socket) {
+    // 后端连接与客户端连接共用 Service 的 I/O 事件循环，不再为每个后端连接占用一个线程
+    net::TcpConnectionPtr backend = std::make_shared<net::TcpConnection>(loop, std::move(socket));
 
     backend->set_message_callback([this](const net::TcpConnectionPtr& conn,
                                          std::string_view data) {
@@ -125,42 +270,146 @@ net::TcpConnectionPtr GatewayForwarderComponent::do_connect(
         on_backend_close(conn);
     });
 
+    // 双向背压：任一方向下游输出缓冲越过高水位时暂停读取上游，回落到低水位后恢复。
+    // 建连回调在客户端连接的 loop 线程执行，此处设置客户端回调与其读取在同一线程
+    std::weak_ptr<net::TcpConnection> weak_client = client_conn;
+    std::weak_ptr<net::TcpConnection> weak_backend = backend;
+    backend->set_high_watermark_callback([weak_client](const net::TcpConnectionPtr&, std::size_t) {
+        if (net::TcpConnectionPtr c = weak_client.lock()) c->pause_reading();
+    });
+    backend->set_low_watermark_callback([weak_client](const net::TcpConnectionPtr&, std::size_t) {
+        if (net::TcpConnectionPtr c = weak_client.lock()) c->resume_reading();
+    });
+    client_conn->set_high_watermark_callback([weak_backend](const net::TcpConnectionPtr&, std::size_t) {
+        if (net::TcpConnectionPtr b = weak_backend.lock()) b->pause_reading();
+    });
+    client_conn->set_low_watermark_callback([weak_backend](const net::TcpConnectionPtr&, std::size_t) {
+        if (net::TcpConnectionPtr b = weak_backend.lock()) b->resume_reading();
+    });
+
     {
         std::lock_guard<std::mutex> lock(mutex_);
         client_to_backend_[client_conn.get()] = backend;
         backend_to_client_[backend.get()] = client_conn;
     }
 
-    service_->io_service().post([backend]() { backend->start(); });
-
-    CHWELL_LOG_INFO("Gateway: connected to backend " + host + ":"
-                    + std::to_string(port));
+    backend->start();
     return backend;
 }
 
+void GatewayForwarderComponent::reply_unavailable(const net::TcpConnectionPtr& client_conn,
+                                                  std::uint16_t cmd) {
+    protocol::Message err_reply(cmd, "gateway: backend unavailable");
+    service::ProtocolRouterComponent::send_message(client_conn, err_reply);
+}
+
+bool GatewayForwarderComponent::encode_relay(const net::TcpConnectionPtr& client_conn,
+                                             const protocol::Message& msg,
+                                             std::vector<char>& out, std::size_t max_bytes) {
+    out = protocol::serialize(msg, service::ProtocolRouterComponent::frame_format(client_conn));
+    if (!out.empty() && out.size() <= max_bytes) {
+        return true;
+    }
+    CHWELL_COUNT_EVENT("chwell_gateway_oversized_messages_total",
+                       "Messages the gateway could not relay because the frame format cannot carry them");
+    CHWELL_LOG_WARN("Gateway: cannot relay cmd=0x" << std::hex << msg.cmd << std::dec << " with "
+                    << msg.body.size() << " byte body");
+    reply_unavailable(client_conn, msg.cmd);
+    return false;
+}
+
 void GatewayForwarderComponent::forward(const net::TcpConnectionPtr& client_conn,
                                         const protocol::Message& msg) {
+    if (mux_links_ > 0) {
+        forward_mux(client_conn, msg);
+        return;
+    }
+
     net::TcpConnectionPtr backend;
+    bool overflow = false;
     {
         std::lock_guard<std::mutex> lock(mutex_);
         auto it = client_to_backend_.find(client_conn.get());
         if (it != client_to_backend_.end()) {
             backend = it->second;
+        } else {
+            // 建连中：按序暂存，连上后依次发出
+            auto pending = pending_.find(client_conn.get());
+            if (pending != pending_.end()) {
+                if (pending->second.queued.size() < max_pending_messages_) {
+                    pending->second.queued.push_back(msg);
+                    return;
+                }
+                overflow = true;
+            }
         }
     }
 
     if (!backend) {
-        backend = connect_backend(client_conn);
-        if (!backend) {
+        if (overflow) {
+            CHWELL_LOG_WARN("Gateway: too many messages queued while connecting backend");
+            reply_unavailable(client_conn, msg.cmd);
+        } else if (!connect_backend(client_conn, msg)) {
             CHWELL_LOG_ERROR("Gateway: failed to connect backend");
-            protocol::Message err_reply(msg.cmd, "gateway: backend unavailable");
-            service::ProtocolRouterComponent::send_message(client_conn, err_reply);
-            return;
+            reply_unavailable(client_conn, msg.cmd);
+        }
+        return;
+    }
+
+    std::vector<char> data;
+    if (encode_relay(client_conn, msg, data)) {
+        backend->send(data);
+    }
+}
+
+void GatewayForwarderComponent::enable_passthrough(service::ProtocolRouterComponent& router,
+                                                   const std::vector<std::uint16_t>& cmds) {
+    for (std::uint16_t cmd : cmds) {
+        router.register_handler(cmd, [this](const net::TcpConnectionPtr& conn,
+                                            const protocol::Message& msg) {
+            forward(conn, msg);
+        });
+        router.register_passthrough(cmd, [this](const net::TcpConnectionPtr& conn, std::uint16_t,
+                                                std::string_view frame, std::size_t remaining) {
+            return forward_passthrough(conn, frame, remaining);
+        });
+    }
+}
+
+bool GatewayForwarderComponent::forward_passthrough(const net::TcpConnectionPtr& client_conn,
+                                                    std::string_view frame,
+                                                    std::size_t remaining) {
+    if (mux_links_ > 0 || remaining < passthrough_min_bytes_) {
+        return false;
+    }
+
+    net::TcpConnectionPtr backend;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = client_to_backend_.find(client_conn.get());
+        if (it == client_to_backend_.end()) {
+            return false;  // 未连接或建连中：读全后经 forward 暂存，保证顺序
         }
+        backend = it->second;
     }
 
-    std::vector<char> data = protocol::serialize(msg);
-    backend->send(data);
+    // 中途失败时后端已收到半帧，字节流无法再对齐，只能断开让客户端重连
+    std::weak_ptr<net::TcpConnection> weak_backend = backend;
+    bool started = client_conn->splice_to(backend, remaining, [weak_backend](bool ok) {
+        if (ok) {
+            return;
+        }
+        if (net::TcpConnectionPtr b = weak_backend.lock()) {
+            CHWELL_LOG_WARN("Gateway: passthrough interrupted, closing backend connection");
+            b->close();
+        }
+    });
+    if (!started) {
+        return false;
+    }
+    // splice 在本次回调返回后才开始搬运，帧头与前缀先入队
+    backend->send(frame);
+    return true;
 }
 
 void GatewayForwarderComponent::on_backend_message(
@@ -200,5 +449,307 @@ void GatewayForwarderComponent::on_backend_close(const net::TcpConnectionPtr& ba
     }
 }
 
+// ============================================
+// 多路复用链路
+// ============================================
+
+void GatewayForwarderComponent::forward_mux(const net::TcpConnectionPtr& client_conn,
+                                            const protocol::Message& msg) {
+    std::vector<char> payload;
+    if (!encode_relay(client_conn, msg, payload, net::mux::kMaxPayload)) {
+        return;
+    }
+
+    std::string host;
+    unsigned short port = 0;
+    bool routed = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        routed = mux_routes_.count(client_conn.get()) > 0;
+    }
+    // 新会话才需要选择后端；NodeRegistry 仅在此处使用，与其他转发线程互斥
+    if (!routed && !resolve_backend(client_conn, host, port)) {
+        reply_unavailable(client_conn, msg.cmd);
+        return;
+    }
+
+    net::MuxBatcherPtr batcher;
+    std::uint32_t session = 0;
+    bool rejected = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto route = mux_routes_.find(client_conn.get());
+        MuxLinkPtr link;
+        if (route != mux_routes_.end()) {
+            link = route->second.link;
+            session = route->second.session;
+        } else {
+            const std::string addr = host + ":" + std::to_string(port);
+            std::vector<MuxLinkPtr>& slots = links_[addr];
+            if (slots.empty()) {
+                for (std::size_t i = 0; i < mux_links_; ++i) {
+                    MuxLinkPtr slot = std::make_shared<MuxLink>();
+                    slot->host = host;
+                    slot->port = port;
+                    slot->addr = addr;
+                    slots.push_back(slot);
+                }
+            }
+            do {
+                session = ++next_session_;  // 0 保留
+            } while (session == 0);
+            link = slots[session % slots.size()];
+
+            if (!link->conn && !link->connector) {
+                // 链路未建立（首次使用或已断开）：摘除期间不建连
+                if (health_locked(addr).allow(steady_now_ms())) {
+                    start_link_locked(link, client_conn);
+                }
+            }
+            if (link->conn || link->connector) {
+                link->sessions[session] = client_conn;
+                mux_routes_[client_conn.get()] = MuxRoute{session, link};
+            } else {
+                rejected = true;
+            }
+        }
+
+        if (!rejected) {
+            if (link->conn) {
+                batcher = link->batcher;
+            } else if (link->queued.size() < max_pending_messages_ * link->sessions.size()) {
+                // 链路建连中：按序暂存，连上后依次发出
+                std::string frame(net::mux::kHeaderSize + payload.size(), '\0');
+                net::mux::encode_header(&frame[0], session, net::mux::kData,
+                                        static_cast<std::uint32_t>(payload.size()));
+                std::memcpy(&frame[net::mux::kHeaderSize], payload.data(), payload.size());
+                link->queued.push_back(MuxLink::Queued{session, true, msg.cmd, std::move(frame)});
+                return;
+            } else {
+                CHWELL_LOG_WARN("Gateway: too many messages queued while connecting mux link");
+                rejected = true;
+            }
+        }
+    }
+
+    if (rejected) {
+        reply_unavailable(client_conn, msg.cmd);
+        return;
+    }
+    // 与同一链路上其他客户端的消息合并写出
+    batcher->append(session, net::mux::kData, std::string_view(payload.data(), payload.size()));
+}
+
+void GatewayForwarderComponent::start_link_locked(const MuxLinkPtr& link,
+                                                  const net::TcpConnectionPtr& client_conn) {
+    // 链路由多个客户端共享，均匀分布到 Service 的 I/O loop；无 Service 时取首个客户端的 loop
+    link->loop = service_ ? service_->event_loops().next_loop() : client_conn->loop();
+    if (!link->loop) {
+        CHWELL_LOG_ERROR("Gateway: no event loop available for mux link");
+        return;
+    }
+    link->decoder = net::MuxDecoder();
+    link->connector = net::Connector::start(
+        link->loop, link->host, link->port, connect_timeout_ms_,
+        [this, link](net::TcpSocket socket, int err) {
+            on_link_connected(link, std::move(socket), err);
+        });
+}
+
+void GatewayForwarderComponent::on_link_connected(const MuxLinkPtr& link, net::TcpSocket socket,
+                                                  int err) {
+    if (err != 0) {
+        std::vector<MuxLink::Queued> queued;
+        std::unordered_map<std::uint32_t, net::TcpConnectionPtr> sessions;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            record_connect_result_locked(link->addr, err);
+            link->connector.reset();
+            queued.swap(link->queued);
+            sessions.swap(link->sessions);
+            for (const auto& kv : sessions) {
+                mux_routes_.erase(kv.second.get());
+            }
+        }
+        CHWELL_LOG_ERROR("Gateway: connect mux link to " + link->addr + " failed: " + strerror(err));
+        for (const MuxLink::Queued& q : queued) {
+            auto it = sessions.find(q.session);
+            if (q.data && it != sessions.end() && !it->second->is_closed()) {
+                reply_unavailable(it->second, q.cmd);
+            }
+        }
+        return;
+    }
+
+    if (link_batch_bytes_ > 0) {
+        net::set_tcp_no_delay(socket.native_handle());  // 去程已由 MuxBatcher 合并
+    }
+    net::TcpConnectionPtr conn = std::make_shared<net::TcpConnection>(link->loop, std::move(socket));
+    std::weak_ptr<MuxLink> weak_link = link;
+    conn->set_message_callback([this, weak_link](const net::TcpConnectionPtr& c,
+                                                 std::string_view data) {
+        if (MuxLinkPtr l = weak_link.lock()) on_link_message(l, c, data);
+    });
+    conn->set_close_callback([this, weak_link](const net::TcpConnectionPtr& c) {
+        if (MuxLinkPtr l = weak_link.lock()) on_link_close(l, c);
+    });
+    // 背压：链路输出越过高水位时暂停该链路上所有客户端的读取
+    conn->set_high_watermark_callback([this, weak_link](const net::TcpConnectionPtr&, std::size_t) {
+        if (MuxLinkPtr l = weak_link.lock()) {
+            for (const net::TcpConnectionPtr& c : link_clients(l)) c->pause_reading();
+        }
+    });
+    conn->set_low_watermark_callback([this, weak_link](const net::TcpConnectionPtr&, std::size_t) {
+        if (MuxLinkPtr l = weak_link.lock()) {
+            for (const net::TcpConnectionPtr& c : link_clients(l)) c->resume_reading();
+        }
+    });
+    conn->start();
+    CHWELL_LOG_INFO("Gateway: mux link connected to " + link->addr);
+
+    // 暂存帧发完之前 conn 不对外可见，期间新到的帧继续排队，保证同一会话按序
+    net::MuxBatcherPtr batcher = std::make_shared<net::MuxBatcher>(conn, link_batch_bytes_);
+    std::vector<MuxLink::Queued> batch;
+    std::string joined;
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (conn->is_closed()) {
+                link->connector.reset();  // 补发期间链路已断开，on_link_close 已清理会话
+                link->queued.clear();
+                return;
+            }
+            if (link->queued.empty()) {
+                record_connect_result_locked(link->addr, 0);
+                link->connector.reset();
+                link->conn = conn;
+                link->batcher = batcher;
+                break;
+            }
+            batch.clear();
+            batch.swap(link->queued);
+        }
+        joined.clear();
+        for (const MuxLink::Queued& q : batch) {
+            joined += q.frame;
+        }
+        conn->send(joined);
+    }
+}
+
+void GatewayForwarderComponent::on_link_message(const MuxLinkPtr& link,
+                                                const net::TcpConnectionPtr& conn,
+                                                std::string_view data) {
+    // 回程拆批：一次读到的帧按会话拆开，同一客户端的连续数据帧合并为一次 send。
+    // 单帧直接发送链路输入上的视图；解码器缓冲中重组的帧在下次 feed 前失效，先拷贝
+    net::TcpConnectionPtr run_client;
+    std::string_view run_view;
+    std::string run_merged;
+    auto flush_run = [&]() {
+        if (run_client) {
+            run_client->send(run_merged.empty() ? run_view : std::string_view(run_merged));
+            run_client.reset();
+            run_merged.clear();
+        }
+    };
+
+    bool ok = link->decoder.feed(data, [&](const net::mux::Frame& frame) {
+        net::TcpConnectionPtr client_conn;
+        net::MuxBatcherPtr batcher;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = link->sessions.find(frame.session);
+            if (it != link->sessions.end()) {
+                client_conn = it->second;
+                if (frame.type == net::mux::kClose) {
+                    mux_routes_.erase(client_conn.get());
+                    link->sessions.erase(it);
+                    batcher = link->batcher;
+                }
+            }
+        }
+        if (!client_conn) {
+            return;  // 会话已结束（客户端断开后仍在途的数据，或对本端结束帧的确认）
+        }
+        if (frame.type != net::mux::kData) {
+            // 后端结束会话：先送达此前的数据再回送确认，客户端下一条消息将建立新会话
+            flush_run();
+            if (batcher) {
+                batcher->append(frame.session, net::mux::kClose);
+            }
+            return;
+        }
+
+        const bool in_input = frame.payload.data() >= data.data()
+                           && frame.payload.data() < data.data() + data.size();
+        if (client_conn == run_client) {
+            if (run_merged.empty()) {
+                run_merged.assign(run_view.data(), run_view.size());
+            }
+            run_merged.append(frame.payload.data(), frame.payload.size());
+            return;
+        }
+        flush_run();
+        run_client = client_conn;
+        if (in_input) {
+            run_view = frame.payload;
+        } else {
+            run_merged.assign(frame.payload.data(), frame.payload.size());
+        }
+    });
+    flush_run();
+    if (!ok) {
+        CHWELL_LOG_ERROR("Gateway: invalid frame on mux link to " + link->addr + ", closing");
+        conn->close();
+    }
+}
+
+void GatewayForwarderComponent::on_link_close(const MuxLinkPtr& link,
+                                              const net::TcpConnectionPtr& conn) {
+    std::size_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (link->conn && link->conn != conn) {
+            return;  // 旧链路迟到的关闭
+        }
+        link->conn.reset();
+        link->batcher.reset();
+        for (const auto& kv : link->sessions) {
+            mux_routes_.erase(kv.second.get());
+        }
+        dropped = link->sessions.size();
+        link->sessions.clear();
+        link->queued.clear();
+    }
+    // 客户端保持连接，下一条消息在新链路上建立新会话
+    CHWELL_LOG_WARN("Gateway: mux link to " + link->addr + " closed, dropped "
+                    + std::to_string(dropped) + " sessions");
+}
+
+GatewayForwarderComponent::MuxLinkStats GatewayForwarderComponent::mux_link_stats() const {
+    MuxLinkStats stats;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& kv : links_) {
+        for (const MuxLinkPtr& link : kv.second) {
+            if (link->batcher) {
+                stats.frames += link->batcher->frames();
+                stats.writes += link->batcher->writes();
+            }
+        }
+    }
+    return stats;
+}
+
+std::vector<net::TcpConnectionPtr> GatewayForwarderComponent::link_clients(
+    const MuxLinkPtr& link) const {
+    std::vector<net::TcpConnectionPtr> clients;
+    std::lock_guard<std::mutex> lock(mutex_);
+    clients.reserve(link->sessions.size());
+    for (const auto& kv : link->sessions) {
+        clients.push_back(kv.second);
+    }
+    return clients;
+}
+
 }  // namespace gateway
 }  // namespace chwell
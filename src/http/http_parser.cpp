@@ -0,0 +1,349 @@
+#include "chwell/http/http_parser.h"
+
+#include <algorithm>
+
+namespace chwell {
+namespace http {
+
+namespace {
+
+// 单个分块大小行（含扩展）上限
+const std::size_t kMaxChunkLine = 1024;
+
+char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (lower(a[i]) != lower(b[i])) return false;
+    }
+    return true;
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+// RFC 7230 token 字符
+bool is_token_char(char c) {
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) return true;
+    switch (c) {
+    case '!': case '#': case '$': case '%': case '&': case '\'': case '*': case '+':
+    case '-': case '.': case '^': case '_': case '`': case '|': case '~':
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool is_token(std::string_view s) {
+    if (s.empty()) return false;
+    for (char c : s) {
+        if (!is_token_char(c)) return false;
+    }
+    return true;
+}
+
+// 逗号分隔的列表中是否含有 token（大小写不敏感）
+bool list_contains(std::string_view list, std::string_view token) {
+    while (!list.empty()) {
+        std::size_t comma = list.find(',');
+        if (iequals(trim(list.substr(0, comma)), token)) return true;
+        if (comma == std::string_view::npos) break;
+        list.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+// 列表最后一项是否为 token
+bool list_ends_with(std::string_view list, std::string_view token) {
+    std::size_t comma = list.rfind(',');
+    std::string_view last = comma == std::string_view::npos ? list : list.substr(comma + 1);
+    return iequals(trim(last), token);
+}
+
+bool parse_decimal(std::string_view s, std::uint64_t* out) {
+    if (s.empty() || s.size() > 19) return false;
+    std::uint64_t v = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') return false;
+        v = v * 10 + static_cast<std::uint64_t>(c - '0');
+    }
+    *out = v;
+    return true;
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c = lower(c);
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+} // anonymous namespace
+
+std::string_view HttpRequestView::header(std::string_view name) const {
+    for (const HttpHeaderView& h : headers) {
+        if (iequals(h.name, name)) {
+            return h.value;
+        }
+    }
+    return std::string_view();
+}
+
+void HttpRequestView::clear() {
+    method = path = version = body = std::string_view();
+    headers.clear();
+    keep_alive = true;
+    chunked = false;
+    expect_continue = false;
+    content_length = 0;
+}
+
+bool parse_http_head(std::string_view head, HttpRequestView* out, int* status) {
+    out->clear();
+    *status = 400;
+
+    // 请求行：method SP request-target SP HTTP-version
+    std::size_t eol = head.find("\r\n");
+    if (eol == std::string_view::npos) return false;
+    std::string_view line = head.substr(0, eol);
+    std::size_t sp1 = line.find(' ');
+    std::size_t sp2 = sp1 == std::string_view::npos ? sp1 : line.find(' ', sp1 + 1);
+    if (sp2 == std::string_view::npos) return false;
+    out->method = line.substr(0, sp1);
+    out->path = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    out->version = line.substr(sp2 + 1);
+    if (!is_token(out->method) || out->path.empty() ||
+        out->path.find(' ') != std::string_view::npos) {
+        return false;
+    }
+    if (out->version == "HTTP/1.1") {
+        out->keep_alive = true;
+    } else if (out->version == "HTTP/1.0") {
+        out->keep_alive = false;
+    } else {
+        *status = out->version.substr(0, 5) == "HTTP/" ? 505 : 400;
+        return false;
+    }
+
+    bool has_length = false;
+    std::string_view transfer_encoding;
+    std::size_t pos = eol + 2;
+    while (pos < head.size()) {
+        eol = head.find("\r\n", pos);
+        if (eol == std::string_view::npos) return false;
+        if (eol == pos) break;  // 空行：头部结束
+        line = head.substr(pos, eol - pos);
+        pos = eol + 2;
+
+        // 不接受旧式折行与字段名前后的空白（请求走私的常见手法）
+        std::size_t colon = line.find(':');
+        if (colon == std::string_view::npos) return false;
+        HttpHeaderView h{line.substr(0, colon), trim(line.substr(colon + 1))};
+        if (!is_token(h.name)) return false;
+        out->headers.push_back(h);
+
+        if (iequals(h.name, "Content-Length")) {
+            std::uint64_t len = 0;
+            if (!parse_decimal(h.value, &len)) return false;
+            if (has_length && len != out->content_length) return false;
+            has_length = true;
+            out->content_length = len;
+        } else if (iequals(h.name, "Transfer-Encoding")) {
+            transfer_encoding = h.value;
+        } else if (iequals(h.name, "Connection")) {
+            if (list_contains(h.value, "close")) {
+                out->keep_alive = false;
+            } else if (list_contains(h.value, "keep-alive")) {
+                out->keep_alive = true;
+            }
+        } else if (iequals(h.name, "Expect")) {
+            out->expect_continue = iequals(h.value, "100-continue");
+        }
+    }
+
+    if (!transfer_encoding.empty()) {
+        // 同时带 Content-Length 的请求有走私风险，直接拒绝
+        if (has_length) return false;
+        if (!list_ends_with(transfer_encoding, "chunked")) {
+            *status = 501;
+            return false;
+        }
+        out->chunked = true;
+    }
+    *status = 0;
+    return true;
+}
+
+void HttpRequestParser::reset() {
+    state_ = State::kHead;
+    head_.clear();
+    scanned_ = 0;
+    remaining_ = 0;
+    body_bytes_ = 0;
+    error_status_ = 0;
+}
+
+HttpRequestParser::Event HttpRequestParser::fail(int status) {
+    state_ = State::kError;
+    error_status_ = status;
+    return Event::kError;
+}
+
+HttpRequestParser::Event HttpRequestParser::next(std::string_view data, std::size_t* consumed,
+                                                 std::string_view* chunk) {
+    std::size_t off = 0;
+    for (;;) {
+        std::string_view rest = data.substr(off);
+        *consumed = off;
+        switch (state_) {
+        case State::kHead: {
+            // 请求之间多余的空行（RFC 7230 3.5）
+            if (scanned_ == 0) {
+                while (rest.size() >= 2 && rest[0] == '\r' && rest[1] == '\n') {
+                    rest.remove_prefix(2);
+                    off += 2;
+                }
+                *consumed = off;
+                // 空行只到了半个，等下一个字节再判断
+                if (rest.size() == 1 && rest[0] == '\r') {
+                    return Event::kNeedMore;
+                }
+            }
+            if (rest.empty()) {
+                return Event::kNeedMore;
+            }
+            // 只扫描上次之后新到的字节（回退 3 字节覆盖跨越两次数据的 "\r\n\r\n"）
+            std::size_t from = scanned_ >= 3 ? scanned_ - 3 : 0;
+            std::size_t end = rest.find("\r\n\r\n", from);
+            if (end == std::string_view::npos) {
+                scanned_ = rest.size();
+                if (rest.size() > limits_.max_header_bytes) {
+                    return fail(431);
+                }
+                return Event::kNeedMore;
+            }
+            const std::size_t head_len = end + 4;
+            if (head_len > limits_.max_header_bytes) {
+                return fail(431);
+            }
+            int status = 0;
+            if (!parse_http_head(rest.substr(0, head_len), &head_, &status)) {
+                return fail(status);
+            }
+            if (head_.headers.size() > limits_.max_headers) {
+                return fail(431);
+            }
+            if (!head_.chunked && head_.content_length > limits_.max_body_size) {
+                return fail(413);
+            }
+            scanned_ = 0;
+            body_bytes_ = 0;
+            remaining_ = head_.chunked ? 0 : head_.content_length;
+            state_ = head_.chunked ? State::kChunkSize : State::kBody;
+            *consumed = off + head_len;
+            return Event::kHead;
+        }
+
+        case State::kBody:
+            if (remaining_ == 0) {
+                state_ = State::kHead;
+                return Event::kComplete;
+            }
+            if (rest.empty()) {
+                return Event::kNeedMore;
+            }
+            {
+                std::size_t n = static_cast<std::size_t>(
+                    std::min<std::uint64_t>(remaining_, rest.size()));
+                *chunk = rest.substr(0, n);
+                remaining_ -= n;
+                *consumed = off + n;
+            }
+            return Event::kBody;
+
+        case State::kChunkSize: {
+            std::size_t eol = rest.find("\r\n");
+            if (eol == std::string_view::npos) {
+                return rest.size() > kMaxChunkLine ? fail(400) : Event::kNeedMore;
+            }
+            std::string_view line = rest.substr(0, eol);
+            std::uint64_t size = 0;
+            std::size_t digits = 0;
+            for (; digits < line.size(); ++digits) {
+                int v = hex_value(line[digits]);
+                if (v < 0) break;
+                if (digits >= 15) return fail(400);
+                size = size * 16 + static_cast<std::uint64_t>(v);
+            }
+            // 分块扩展（";name=value"）忽略
+            std::string_view ext = trim(line.substr(digits));
+            if (digits == 0 || (!ext.empty() && ext.front() != ';')) {
+                return fail(400);
+            }
+            if (body_bytes_ + size > limits_.max_body_size) {
+                return fail(413);
+            }
+            off += eol + 2;
+            remaining_ = size;
+            state_ = size == 0 ? State::kTrailer : State::kChunkData;
+            break;
+        }
+
+        case State::kChunkData:
+            if (remaining_ == 0) {
+                state_ = State::kChunkCrlf;
+                break;
+            }
+            if (rest.empty()) {
+                return Event::kNeedMore;
+            }
+            {
+                std::size_t n = static_cast<std::size_t>(
+                    std::min<std::uint64_t>(remaining_, rest.size()));
+                *chunk = rest.substr(0, n);
+                remaining_ -= n;
+                body_bytes_ += n;
+                *consumed = off + n;
+            }
+            return Event::kBody;
+
+        case State::kChunkCrlf:
+            if (rest.size() < 2) {
+                return Event::kNeedMore;
+            }
+            if (rest[0] != '\r' || rest[1] != '\n') {
+                return fail(400);
+            }
+            off += 2;
+            state_ = State::kChunkSize;
+            break;
+
+        case State::kTrailer: {
+            // 尾部字段忽略，空行结束请求
+            std::size_t eol = rest.find("\r\n");
+            if (eol == std::string_view::npos) {
+                return rest.size() > limits_.max_header_bytes ? fail(431) : Event::kNeedMore;
+            }
+            off += eol + 2;
+            if (eol == 0) {
+                *consumed = off;
+                state_ = State::kHead;
+                return Event::kComplete;
+            }
+            break;
+        }
+
+        case State::kError:
+            return Event::kError;
+        }
+    }
+}
+
+} // namespace http
+} // namespace chwell
@@ -5,7 +5,18 @@ namespace http {
 
 std::vector<char> HttpResponse::to_bytes() const {
     std::string data;
-    data.reserve(128 + body.size());
+    append_to(&data);
+    if (!shared_body.empty()) {
+        data.append(shared_body.data(), shared_body.size());
+    } else if (!file_body.empty()) {
+        net::read_file_region(file_body, static_cast<std::size_t>(file_body.length), &data);
+    }
+    return std::vector<char>(data.begin(), data.end());
+}
+
+void HttpResponse::append_to(std::string* out, bool include_body) const {
+    std::string& data = *out;
+    data.reserve(data.size() + 128 + body.size());
 
     data += "HTTP/1.1 ";
     data += std::to_string(status_code);
@@ -21,16 +32,20 @@ std::vector<char> HttpResponse::to_bytes() const {
         data += "\r\n";
     }
 
-    data += "Content-Length: ";
-    data += std::to_string(static_cast<unsigned long long>(body.size()));
-    data += "\r\n";
+    data += header_block;
 
-    data += "\r\n";
-    data += body;
+    // 1xx / 204 / 304 不带正文，也不写 Content-Length
+    if (status_code >= 200 && status_code != 204 && status_code != 304) {
+        data += "Content-Length: ";
+        data += std::to_string(static_cast<unsigned long long>(body_size()));
+        data += "\r\n";
+    }
 
-    return std::vector<char>(data.begin(), data.end());
+    data += "\r\n";
+    if (include_body) {
+        data += body;
+    }
 }
 
 } // namespace http
 } // namespace chwell
-
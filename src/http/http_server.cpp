@@ -1,200 +1,262 @@
 #include "chwell/http/http_server.h"
 #include "chwell/core/logger.h"
-#include <cstring>
-#include <poll.h>
-#include <unistd.h>
-#include <cerrno>
 
 namespace chwell {
 namespace http {
 
 namespace {
 
-// 连接会话，负责读取并解析一个 HTTP 请求，然后调用用户 handler，最后发送响应并关闭。
-class HttpSession {
-public:
-    HttpSession(net::TcpSocket socket, const HttpHandler& handler)
-        : socket_(std::move(socket)),
-          handler_(handler),
-          buffer_(8192) {
+// 读缓冲被大请求撑大后，超过该容量时在空闲时释放
+const std::size_t kMaxIdleBuffer = 64 * 1024;
+
+const char* reason_phrase(int status) {
+    switch (status) {
+    case 400: return "Bad Request";
+    case 413: return "Payload Too Large";
+    case 431: return "Request Header Fields Too Large";
+    case 501: return "Not Implemented";
+    case 505: return "HTTP Version Not Supported";
+    default: return "Error";
     }
+}
 
-    void run() {
-        std::string request_data;
-        request_data.reserve(8192);
-
-        while (socket_.is_open()) {
-            ssize_t n = socket_.read(buffer_.data(), buffer_.size());
-            if (n <= 0) break;
+bool response_closes(const HttpResponse& resp) {
+    auto it = resp.headers.find("Connection");
+    return it != resp.headers.end() && (it->second == "close" || it->second == "Close");
+}
 
-            request_data.append(buffer_.data(), static_cast<std::size_t>(n));
+HttpRequest to_request(const HttpRequestView& view) {
+    HttpRequest req;
+    req.method.assign(view.method.data(), view.method.size());
+    req.path.assign(view.path.data(), view.path.size());
+    req.version.assign(view.version.data(), view.version.size());
+    for (const HttpHeaderView& h : view.headers) {
+        req.headers[std::string(h.name)] = std::string(h.value);
+    }
+    req.body.assign(view.body.data(), view.body.size());
+    return req;
+}
 
-            std::size_t pos = request_data.find("\r\n\r\n");
-            if (pos == std::string::npos) continue;
+} // anonymous namespace
 
-            HttpRequest req;
-            if (!parse_request(request_data, req)) {
-                CHWELL_LOG_WARN("HttpSession parse request failed");
-                break;
-            }
+// 单个连接的解析与分发状态，由连接的 message 回调持有，只在所属 I/O 线程访问
+class HttpSession {
+public:
+    explicit HttpSession(const HttpServer& server)
+        : server_(server),
+          parser_(server.config_.limits) {}
 
-            HttpResponse resp;
-            if (handler_) {
-                handler_(req, resp);
-            } else {
-                resp.status_code = 404;
-                resp.reason = "Not Found";
-                resp.body = "No handler";
-                resp.set_header("Content-Type", "text/plain; charset=utf-8");
-            }
+    void on_data(const net::TcpConnectionPtr& conn, std::string_view data);
 
-            auto bytes = resp.to_bytes();
-            const char* ptr = bytes.data();
-            std::size_t len = bytes.size();
-            while (len > 0) {
-                ssize_t written = socket_.write(ptr, len);
-                if (written <= 0) break;
-                ptr += written;
-                len -= static_cast<std::size_t>(written);
-            }
-            break;  // 短连接，处理完一个请求后关闭
-        }
+private:
+    void dispatch(const net::TcpConnectionPtr& conn);
+    void reject(int status);
+    // 按挂载顺序匹配静态文件目录，命中返回 true
+    bool serve_static(const HttpRequestView& req, HttpResponse& resp);
+    // 请求正文跨越多次读时，把仍指向本次输入的请求头 / 正文视图转存到会话自己的缓冲
+    void detach_from_input();
+
+    const HttpServer& server_;
+    HttpRequestParser parser_;
+    std::string pending_;       // 未消费的不完整数据（半个请求头 / 分块大小行）
+    std::string_view head_raw_; // 当前请求头原文（指向本次输入或 head_copy_）
+    std::string head_copy_;
+    std::string_view body_view_;  // 正文在本次输入内连续时直接引用
+    std::string body_;
+    std::string out_;           // 本次输入产生的全部响应
+    std::size_t handled_{0};
+    bool closing_{false};
+};
 
-        net::ErrorCode ec;
-        socket_.shutdown(SHUT_RDWR, ec);
-        socket_.close(ec);
+void HttpSession::on_data(const net::TcpConnectionPtr& conn, std::string_view data) {
+    if (closing_) {
+        return;
+    }
+    std::string_view input = data;
+    if (!pending_.empty()) {
+        pending_.append(data.data(), data.size());
+        input = pending_;
     }
 
-private:
-    bool parse_request(const std::string& data, HttpRequest& req) {
-        std::size_t pos = data.find("\r\n");
-        if (pos == std::string::npos) return false;
-
-        std::string request_line = data.substr(0, pos);
-
-        std::size_t sp1 = request_line.find(' ');
-        if (sp1 == std::string::npos) return false;
-        std::size_t sp2 = request_line.find(' ', sp1 + 1);
-        if (sp2 == std::string::npos) return false;
-
-        req.method = request_line.substr(0, sp1);
-        req.path = request_line.substr(sp1 + 1, sp2 - sp1 - 1);
-        req.version = request_line.substr(sp2 + 1);
-
-        std::size_t header_start = pos + 2;
-        std::size_t header_end = data.find("\r\n\r\n");
-        if (header_end == std::string::npos) return false;
-
-        std::size_t line_start = header_start;
-        while (line_start < header_end) {
-            std::size_t line_end = data.find("\r\n", line_start);
-            if (line_end == std::string::npos || line_end > header_end) break;
-
-            std::string line = data.substr(line_start, line_end - line_start);
-            std::size_t colon = line.find(':');
-            if (colon != std::string::npos) {
-                std::string key = line.substr(0, colon);
-                std::string value = line.substr(colon + 1);
-                while (!value.empty() && (value[0] == ' ' || value[0] == '\t')) {
-                    value.erase(value.begin());
-                }
-                req.headers[key] = value;
-            }
-
-            line_start = line_end + 2;
+    std::size_t off = 0;
+    while (!closing_) {
+        std::size_t consumed = 0;
+        std::string_view chunk;
+        HttpRequestParser::Event ev = parser_.next(input.substr(off), &consumed, &chunk);
+        const std::size_t start = off;
+        off += consumed;
+        if (ev == HttpRequestParser::Event::kNeedMore) {
+            break;
         }
-
-        std::string content_length_str = req.header("Content-Length");
-        if (!content_length_str.empty()) {
-            int len = std::atoi(content_length_str.c_str());
-            std::size_t body_start = header_end + 4;
-            if (len > 0 && body_start + static_cast<std::size_t>(len) <= data.size()) {
-                req.body = data.substr(body_start, static_cast<std::size_t>(len));
+        switch (ev) {
+        case HttpRequestParser::Event::kHead:
+            head_raw_ = input.substr(start, consumed);
+            body_view_ = std::string_view();
+            body_.clear();
+            // 正文尚未到达时按客户端要求先回 100 Continue
+            if (parser_.head().expect_continue && parser_.in_body() && off == input.size() &&
+                (parser_.head().chunked || parser_.head().content_length > 0)) {
+                out_ += "HTTP/1.1 100 Continue\r\n\r\n";
+            }
+            break;
+        case HttpRequestParser::Event::kBody:
+            if (body_view_.empty() && body_.empty()) {
+                body_view_ = chunk;
+            } else {
+                if (!body_view_.empty()) {
+                    body_.assign(body_view_.data(), body_view_.size());
+                    body_view_ = std::string_view();
+                }
+                body_.append(chunk.data(), chunk.size());
             }
+            break;
+        case HttpRequestParser::Event::kComplete:
+            dispatch(conn);
+            break;
+        case HttpRequestParser::Event::kError:
+            reject(parser_.error_status());
+            break;
+        default:
+            break;
         }
-
-        return true;
     }
 
-    net::TcpSocket socket_;
-    HttpHandler handler_;
-    std::vector<char> buffer_;
-};
-
-} // anonymous namespace
-
-HttpServer::HttpServer(chwell::net::IoService& io_service, unsigned short port)
-    : io_service_(io_service), port_(port), acceptor_(port) {
-}
-
-void HttpServer::start() {
-    if (acceptor_.listen_fd() < 0) {
-        CHWELL_LOG_ERROR("HttpServer: failed to create acceptor");
-        return;
+    if (parser_.in_body() && !closing_) {
+        detach_from_input();
     }
-
-    if (pipe(wake_pipe_) != 0) {
-        CHWELL_LOG_ERROR("HttpServer: failed to create wake pipe");
-        return;
+    if (input.data() == pending_.data()) {
+        pending_.erase(0, off);
+    } else if (off < input.size()) {
+        pending_.assign(input.data() + off, input.size() - off);
+    }
+    if (pending_.empty() && pending_.capacity() > kMaxIdleBuffer) {
+        std::string().swap(pending_);
     }
 
-    CHWELL_LOG_INFO("HttpServer listening on 0.0.0.0:" << port_);
-    stopped_ = false;
-    accept_thread_ = std::thread([this]() { accept_loop(); });
+    if (!out_.empty()) {
+        conn->send(out_);
+        out_.clear();
+        if (out_.capacity() > kMaxIdleBuffer) {
+            std::string().swap(out_);
+        }
+    }
+    if (closing_) {
+        conn->close();
+    }
 }
 
-void HttpServer::stop() {
-    stopped_ = true;
-    if (wake_pipe_[1] >= 0) {
-        char c = 1;
-        ssize_t n = write(wake_pipe_[1], &c, 1);
-        (void)n;  // best-effort wake during shutdown
+void HttpSession::detach_from_input() {
+    if (head_raw_.data() != head_copy_.data()) {
+        head_copy_.assign(head_raw_.data(), head_raw_.size());
+        head_raw_ = head_copy_;
+        int status = 0;
+        parse_http_head(head_copy_, &parser_.head(), &status);
     }
-    if (accept_thread_.joinable()) {
-        accept_thread_.join();
+    if (!body_view_.empty()) {
+        body_.assign(body_view_.data(), body_view_.size());
+        body_view_ = std::string_view();
     }
-    if (wake_pipe_[0] >= 0) { close(wake_pipe_[0]); wake_pipe_[0] = -1; }
-    if (wake_pipe_[1] >= 0) { close(wake_pipe_[1]); wake_pipe_[1] = -1; }
 }
 
-void HttpServer::accept_loop() {
-    pollfd fds[2];
-    fds[0].fd = acceptor_.listen_fd();
-    fds[0].events = POLLIN;
-    fds[1].fd = wake_pipe_[0];
-    fds[1].events = POLLIN;
-
-    while (!stopped_) {
-        int ret = poll(fds, 2, 1000);
-        if (ret < 0) {
-            if (errno == EINTR) continue;
-            CHWELL_LOG_ERROR("HttpServer poll error: " + std::string(strerror(errno)));
-            break;
+void HttpSession::dispatch(const net::TcpConnectionPtr& conn) {
+    HttpRequestView& req = parser_.head();
+    req.body = body_view_.empty() ? std::string_view(body_) : body_view_;
+    ++handled_;
+
+    HttpResponse resp;
+    if (!serve_static(req, resp)) {
+        if (server_.view_handler_) {
+            server_.view_handler_(req, resp);
+        } else if (server_.handler_) {
+            server_.handler_(to_request(req), resp);
+        } else {
+            resp.status_code = 404;
+            resp.reason = "Not Found";
+            resp.body = "No handler";
+            resp.set_header("Content-Type", "text/plain; charset=utf-8");
         }
-        if (ret == 0) continue;
+    }
 
-        if (fds[1].revents & POLLIN) {
-            char buf[64];
-            ssize_t n = read(wake_pipe_[0], buf, sizeof(buf));
-            (void)n;  // drain wake pipe
-            break;
+    const HttpServerConfig& config = server_.config_;
+    const bool keep_alive = config.keep_alive && req.keep_alive && !response_closes(resp) &&
+                            (config.max_requests_per_connection == 0 ||
+                             handled_ < config.max_requests_per_connection);
+    if (!keep_alive) {
+        resp.set_header("Connection", "close");
+        closing_ = true;
+    } else if (req.version == "HTTP/1.0") {
+        resp.set_header("Connection", "keep-alive");
+    }
+    const bool with_body = req.method != "HEAD";
+    resp.append_to(&out_, with_body);
+    if (with_body && (!resp.shared_body.empty() || !resp.file_body.empty())) {
+        // 预先生成的正文：连同此前累积的响应一起发出，共享帧按引用入队，文件走 sendfile
+        if (!resp.file_body.empty()) {
+            conn->send_file(out_, resp.file_body);
+        } else {
+            conn->send(out_, resp.shared_body);
         }
+        out_.clear();
+    }
 
-        if (fds[0].revents & POLLIN) {
-            net::ErrorCode ec;
-            net::TcpSocket socket = acceptor_.accept(ec);
-            if (ec) {
-                CHWELL_LOG_ERROR("HttpServer accept failed: " + ec.message());
-                continue;
-            }
+    head_raw_ = std::string_view();
+    body_view_ = std::string_view();
+    body_.clear();
+    if (body_.capacity() > kMaxIdleBuffer) {
+        std::string().swap(body_);
+    }
+}
 
-            std::shared_ptr<HttpSession> session =
-                std::make_shared<HttpSession>(std::move(socket), handler_);
-            io_service_.post([session]() {
-                session->run();
-            });
+bool HttpSession::serve_static(const HttpRequestView& req, HttpResponse& resp) {
+    for (const StaticFileHandlerPtr& files : server_.static_handlers_) {
+        if (files->handle(req, resp)) {
+            return true;
         }
     }
+    return false;
+}
+
+void HttpSession::reject(int status) {
+    CHWELL_LOG_WARN("HttpServer rejecting request: " << status);
+    HttpResponse resp;
+    resp.status_code = status;
+    resp.reason = reason_phrase(status);
+    resp.set_header("Content-Type", "text/plain; charset=utf-8");
+    resp.set_header("Connection", "close");
+    resp.body = resp.reason;
+    resp.append_to(&out_);
+    closing_ = true;
+}
+
+HttpServer::HttpServer(net::IoService& io_service, unsigned short port)
+    : tcp_server_(new net::TcpServer(io_service, port)) {
+}
+
+HttpServer::HttpServer(net::EventLoopThreadPool& loops, unsigned short port)
+    : tcp_server_(new net::TcpServer(loops, port)) {
+}
+
+StaticFileHandlerPtr HttpServer::mount_static(const StaticFileConfig& config) {
+    StaticFileHandlerPtr files = std::make_shared<StaticFileHandler>(config);
+    static_handlers_.push_back(files);
+    CHWELL_LOG_INFO("HttpServer serving " << config.root << " at " << files->config().url_prefix);
+    return files;
+}
+
+void HttpServer::start() {
+    tcp_server_->set_config(config_.tcp);
+    // 每个连接一个会话，由连接的 message 回调持有，随连接释放
+    tcp_server_->set_connection_callback([this](const net::TcpConnectionPtr& conn) {
+        std::shared_ptr<HttpSession> session = std::make_shared<HttpSession>(*this);
+        conn->set_message_callback([session](const net::TcpConnectionPtr& c, std::string_view data) {
+            session->on_data(c, data);
+        });
+    });
+    tcp_server_->start_accept();
+}
+
+void HttpServer::stop() {
+    tcp_server_->stop();
 }
 
 } // namespace http
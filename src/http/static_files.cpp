@@ -0,0 +1,590 @@
+#include "chwell/http/static_files.h"
+#include "chwell/core/logger.h"
+#include "chwell/metrics/event_counter.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <sys/stat.h>
+
+#ifdef CHWELL_USE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace chwell {
+namespace http {
+
+namespace {
+
+std::int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+bool istarts_with(std::string_view s, std::string_view prefix) {
+    if (s.size() < prefix.size()) return false;
+    for (std::size_t i = 0; i < prefix.size(); ++i) {
+        if (lower(s[i]) != lower(prefix[i])) return false;
+    }
+    return true;
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+bool parse_u64(std::string_view s, std::uint64_t* out) {
+    if (s.empty() || s.size() > 19) return false;
+    std::uint64_t v = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') return false;
+        v = v * 10 + static_cast<std::uint64_t>(c - '0');
+    }
+    *out = v;
+    return true;
+}
+
+// Accept-Encoding 中是否接受 gzip（忽略 q=0）
+bool accepts_gzip(std::string_view value) {
+    while (!value.empty()) {
+        std::size_t comma = value.find(',');
+        std::string_view item = trim(value.substr(0, comma));
+        if (istarts_with(item, "gzip") &&
+            (item.size() == 4 || item[4] == ';' || item[4] == ' ')) {
+            std::size_t q = item.find("q=");
+            if (q == std::string_view::npos) return true;
+            std::string_view qv = trim(item.substr(q + 2));
+            // "0" / "0.0" / "0.000" 表示拒绝
+            return qv.find_first_not_of("0.") != std::string_view::npos;
+        }
+        if (comma == std::string_view::npos) break;
+        value.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+// If-None-Match 列表中是否有与 etag 匹配的项（弱比较，"*" 匹配任意）
+bool etag_matches(std::string_view list, std::string_view etag) {
+    while (!list.empty()) {
+        std::size_t comma = list.find(',');
+        std::string_view item = trim(list.substr(0, comma));
+        if (item.substr(0, 2) == "W/") item.remove_prefix(2);
+        if (item == "*" || item == etag) return true;
+        if (comma == std::string_view::npos) break;
+        list.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+// 解析单段 Range：1 有效，0 忽略（多段 / 格式不支持，按完整内容应答），-1 不可满足
+int parse_range(std::string_view value, std::uint64_t size,
+                std::uint64_t* first, std::uint64_t* last) {
+    value = trim(value);
+    if (!istarts_with(value, "bytes=")) return 0;
+    value.remove_prefix(6);
+    if (value.find(',') != std::string_view::npos) return 0;
+    std::size_t dash = value.find('-');
+    if (dash == std::string_view::npos) return 0;
+    std::string_view a = trim(value.substr(0, dash));
+    std::string_view b = trim(value.substr(dash + 1));
+    std::uint64_t start = 0;
+    std::uint64_t end = 0;
+    if (a.empty()) {
+        // 后缀形式：最后 n 字节
+        if (!parse_u64(b, &end)) return 0;
+        if (end == 0 || size == 0) return -1;
+        *first = end >= size ? 0 : size - end;
+        *last = size - 1;
+        return 1;
+    }
+    if (!parse_u64(a, &start)) return 0;
+    if (b.empty()) {
+        end = size == 0 ? 0 : size - 1;
+    } else if (!parse_u64(b, &end) || end < start) {
+        return 0;
+    }
+    if (start >= size) return -1;
+    *first = start;
+    *last = end >= size ? size - 1 : end;
+    return 1;
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c = lower(c);
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// 百分号解码并规范化相对路径：拒绝 ".."、隐藏文件与 NUL，失败返回 false
+bool sanitize_path(std::string_view raw, std::string* out) {
+    std::string decoded;
+    decoded.reserve(raw.size());
+    for (std::size_t i = 0; i < raw.size(); ++i) {
+        char c = raw[i];
+        if (c == '%') {
+            if (i + 2 >= raw.size()) return false;
+            int hi = hex_value(raw[i + 1]);
+            int lo = hex_value(raw[i + 2]);
+            if (hi < 0 || lo < 0) return false;
+            c = static_cast<char>(hi * 16 + lo);
+            i += 2;
+        }
+        if (c == '\0' || c == '\\') return false;
+        decoded += c;
+    }
+
+    out->clear();
+    std::size_t pos = 0;
+    while (pos <= decoded.size()) {
+        std::size_t slash = decoded.find('/', pos);
+        if (slash == std::string::npos) slash = decoded.size();
+        std::string_view seg(decoded.data() + pos, slash - pos);
+        if (!seg.empty() && seg != ".") {
+            if (seg.front() == '.') return false;  // ".." 与 .git 等隐藏文件
+            if (!out->empty()) *out += '/';
+            out->append(seg.data(), seg.size());
+        }
+        pos = slash + 1;
+    }
+    // 保留结尾的 '/'，用于映射到 index 文件
+    if (!decoded.empty() && decoded.back() == '/' && !out->empty()) {
+        *out += '/';
+    }
+    return true;
+}
+
+std::string http_date(std::int64_t mtime_ns) {
+    std::time_t t = static_cast<std::time_t>(mtime_ns / 1000000000LL);
+    std::tm tm;
+    gmtime_r(&t, &tm);
+    char buf[64];
+    std::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return buf;
+}
+
+bool is_compressible(const char* content_type) {
+    std::string_view t(content_type);
+    return t.substr(0, 5) == "text/" || t.find("javascript") != std::string_view::npos ||
+           t.find("json") != std::string_view::npos || t.find("xml") != std::string_view::npos ||
+           t == "application/wasm";
+}
+
+#ifdef CHWELL_USE_ZLIB
+bool gzip_compress(std::string_view in, int level, std::string* out) {
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    // windowBits + 16：输出 gzip 封装
+    if (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+    out->resize(deflateBound(&zs, static_cast<uLong>(in.size())) + 32);
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in = static_cast<uInt>(in.size());
+    zs.next_out = reinterpret_cast<Bytef*>(&(*out)[0]);
+    zs.avail_out = static_cast<uInt>(out->size());
+    int ret = deflate(&zs, Z_FINISH);
+    out->resize(out->size() - zs.avail_out);
+    deflateEnd(&zs);
+    return ret == Z_STREAM_END;
+}
+#else
+bool gzip_compress(std::string_view, int, std::string*) {
+    return false;
+}
+#endif
+
+void set_text(HttpResponse& resp, int status, const char* reason) {
+    resp.status_code = status;
+    resp.reason = reason;
+    resp.set_header("Content-Type", "text/plain; charset=utf-8");
+    resp.body = reason;
+}
+
+} // anonymous namespace
+
+struct StaticFileHandler::Entry {
+    std::string full_path;
+    net::SharedFilePtr file;         // 大文件：保留句柄，正文以 sendfile 发送
+    net::SharedFrame body;           // 小文件：整个正文
+    net::SharedFrame gzip_body;      // 小文件的 gzip 变体（未压缩或压缩无收益时为空）
+    std::uint64_t size{0};
+    std::int64_t mtime_ns{0};
+    std::string etag;
+    std::string last_modified;
+    std::string header_block;        // Content-Type / ETag / Last-Modified / Cache-Control / Accept-Ranges
+    std::string gzip_header_block;
+    mutable std::atomic<std::int64_t> checked_ms{0};
+
+    std::size_t cached_bytes() const { return body.size() + gzip_body.size(); }
+};
+
+const char* guess_content_type(const std::string& path) {
+    static const struct {
+        const char* ext;
+        const char* type;
+    } kTypes[] = {
+        {"html", "text/html; charset=utf-8"},
+        {"htm", "text/html; charset=utf-8"},
+        {"css", "text/css; charset=utf-8"},
+        {"js", "application/javascript; charset=utf-8"},
+        {"mjs", "application/javascript; charset=utf-8"},
+        {"json", "application/json; charset=utf-8"},
+        {"map", "application/json; charset=utf-8"},
+        {"txt", "text/plain; charset=utf-8"},
+        {"xml", "application/xml; charset=utf-8"},
+        {"svg", "image/svg+xml"},
+        {"png", "image/png"},
+        {"jpg", "image/jpeg"},
+        {"jpeg", "image/jpeg"},
+        {"gif", "image/gif"},
+        {"webp", "image/webp"},
+        {"ico", "image/x-icon"},
+        {"wasm", "application/wasm"},
+        {"woff", "font/woff"},
+        {"woff2", "font/woff2"},
+        {"ttf", "font/ttf"},
+        {"mp3", "audio/mpeg"},
+        {"ogg", "audio/ogg"},
+        {"wav", "audio/wav"},
+        {"mp4", "video/mp4"},
+        {"webm", "video/webm"},
+    };
+    std::size_t dot = path.rfind('.');
+    std::size_t slash = path.rfind('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return "application/octet-stream";
+    }
+    std::string ext = path.substr(dot + 1);
+    for (char& c : ext) c = lower(c);
+    for (const auto& t : kTypes) {
+        if (ext == t.ext) return t.type;
+    }
+    return "application/octet-stream";
+}
+
+StaticFileHandler::StaticFileHandler(const StaticFileConfig& config)
+    : config_(config) {
+    if (config_.url_prefix.empty() || config_.url_prefix.back() != '/') {
+        config_.url_prefix += '/';
+    }
+    while (config_.root.size() > 1 && config_.root.back() == '/') {
+        config_.root.pop_back();
+    }
+#ifndef CHWELL_USE_ZLIB
+    config_.gzip = false;
+#endif
+}
+
+StaticFileHandler::~StaticFileHandler() {}
+
+bool StaticFileHandler::handle(const HttpRequestView& req, HttpResponse& resp) {
+    std::string_view path = req.path;
+    std::string_view query;
+    std::size_t q = path.find_first_of("?#");
+    if (q != std::string_view::npos) {
+        query = path.substr(q);
+        path = path.substr(0, q);
+    }
+    const std::string& prefix = config_.url_prefix;
+    if (path.size() + 1 == prefix.size() && prefix.compare(0, path.size(), path) == 0) {
+        // "/h5" → "/h5/"
+        resp.status_code = 301;
+        resp.reason = "Moved Permanently";
+        resp.set_header("Location", prefix + std::string(query));
+        return true;
+    }
+    if (path.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+    if (req.method != "GET" && req.method != "HEAD") {
+        set_text(resp, 405, "Method Not Allowed");
+        resp.set_header("Allow", "GET, HEAD");
+        return true;
+    }
+
+    std::string rel;
+    if (!sanitize_path(path.substr(prefix.size()), &rel)) {
+        set_text(resp, 404, "Not Found");
+        return true;
+    }
+    if (rel.empty() || rel.back() == '/') {
+        rel += config_.index_file;
+    }
+
+    bool is_dir = false;
+    EntryPtr entry = lookup(rel, &is_dir);
+    if (!entry) {
+        if (is_dir) {
+            resp.status_code = 301;
+            resp.reason = "Moved Permanently";
+            resp.set_header("Location", std::string(path) + "/" + std::string(query));
+        } else {
+            set_text(resp, 404, "Not Found");
+        }
+        return true;
+    }
+    fill_response(*entry, req, resp);
+    return true;
+}
+
+void StaticFileHandler::fill_response(const Entry& entry, const HttpRequestView& req,
+                                      HttpResponse& resp) {
+    std::string_view range = req.header("Range");
+    const bool gzip = !entry.gzip_body.empty() && range.empty() &&
+                      accepts_gzip(req.header("Accept-Encoding"));
+
+    // 条件请求：If-None-Match 优先于 If-Modified-Since
+    std::string_view inm = req.header("If-None-Match");
+    std::string_view ims = req.header("If-Modified-Since");
+    const bool not_modified = !inm.empty() ? etag_matches(inm, entry.etag)
+                                           : (!ims.empty() && ims == entry.last_modified);
+    if (not_modified) {
+        resp.status_code = 304;
+        resp.reason = "Not Modified";
+        resp.header_block = gzip ? entry.gzip_header_block : entry.header_block;
+        ++not_modified_;
+        CHWELL_COUNT_EVENT("chwell_http_static_not_modified_total",
+                           "Static file requests answered with 304 Not Modified");
+        return;
+    }
+
+    if (!range.empty() && req.method == "GET") {
+        // If-Range 与当前版本不一致时忽略 Range，返回完整内容
+        std::string_view if_range = req.header("If-Range");
+        std::uint64_t first = 0;
+        std::uint64_t last = 0;
+        int r = (if_range.empty() || if_range == entry.etag || if_range == entry.last_modified)
+                    ? parse_range(range, entry.size, &first, &last)
+                    : 0;
+        if (r < 0) {
+            resp.status_code = 416;
+            resp.reason = "Range Not Satisfiable";
+            resp.header_block = "Content-Range: bytes */" + std::to_string(entry.size) + "\r\n";
+            return;
+        }
+        if (r > 0) {
+            const std::uint64_t len = last - first + 1;
+            resp.status_code = 206;
+            resp.reason = "Partial Content";
+            resp.header_block = entry.header_block + "Content-Range: bytes " +
+                                std::to_string(first) + "-" + std::to_string(last) + "/" +
+                                std::to_string(entry.size) + "\r\n";
+            if (entry.file) {
+                resp.file_body = net::FileRegion(entry.file, first, len);
+            } else {
+                resp.body.assign(entry.body.data() + first, static_cast<std::size_t>(len));
+            }
+            return;
+        }
+    }
+
+    resp.header_block = gzip ? entry.gzip_header_block : entry.header_block;
+    if (entry.file) {
+        resp.file_body = net::FileRegion(entry.file, 0, entry.size);
+    } else {
+        resp.shared_body = gzip ? entry.gzip_body : entry.body;
+    }
+}
+
+StaticFileHandler::EntryPtr StaticFileHandler::lookup(const std::string& rel_path, bool* is_dir) {
+    *is_dir = false;
+    EntryPtr entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = cache_.find(rel_path);
+        if (it != cache_.end()) {
+            entry = it->second.entry;
+            lru_.splice(lru_.begin(), lru_, it->second.lru);
+        }
+    }
+    if (entry) {
+        if (still_valid(*entry)) {
+            ++hits_;
+            CHWELL_COUNT_EVENT("chwell_http_static_cache_hits_total", "Static file cache hits");
+            return entry;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = cache_.find(rel_path);
+        if (it != cache_.end() && it->second.entry == entry) {
+            erase_locked(rel_path);
+        }
+    }
+
+    // 同一文件的并发未命中只由第一个请求加载，其余等待其结果
+    std::promise<EntryPtr> promise;
+    std::shared_future<EntryPtr> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = loading_.find(rel_path);
+        if (it != loading_.end()) {
+            pending = it->second;
+        } else {
+            loading_[rel_path] = promise.get_future().share();
+        }
+    }
+    if (pending.valid()) {
+        entry = pending.get();
+        if (!entry) {
+            // 不存在或是目录：重新打开一次以区分两种情况（失败的 open 代价很低）
+            entry = load(rel_path, is_dir);
+        }
+        return entry;
+    }
+
+    ++misses_;
+    CHWELL_COUNT_EVENT("chwell_http_static_cache_misses_total", "Static file cache misses");
+    entry = load(rel_path, is_dir);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        loading_.erase(rel_path);
+        if (entry) {
+            insert_locked(rel_path, entry);
+        }
+    }
+    promise.set_value(entry);
+    return entry;
+}
+
+StaticFileHandler::EntryPtr StaticFileHandler::load(const std::string& rel_path, bool* is_dir) const {
+    const std::string full = config_.root + "/" + rel_path;
+    net::SharedFilePtr file = net::SharedFile::open(full);
+    if (!file) {
+        *is_dir = errno == EISDIR;
+        return nullptr;
+    }
+
+    std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+    entry->full_path = full;
+    entry->size = file->size();
+    entry->mtime_ns = file->mtime_ns();
+    entry->checked_ms = now_ms();
+
+    char etag[64];
+    std::snprintf(etag, sizeof(etag), "\"%llx-%llx\"",
+                  static_cast<unsigned long long>(entry->size),
+                  static_cast<unsigned long long>(entry->mtime_ns));
+    entry->etag = etag;
+    entry->last_modified = http_date(entry->mtime_ns);
+
+    const char* content_type = guess_content_type(rel_path);
+    if (entry->size <= config_.cache_max_file_size) {
+        std::string data;
+        net::FileRegion region(file, 0, entry->size);
+        if (net::read_file_region(region, static_cast<std::size_t>(entry->size), &data) != entry->size) {
+            CHWELL_LOG_WARN("StaticFileHandler: short read on " << full);
+            return nullptr;
+        }
+        if (config_.gzip && data.size() >= config_.gzip_min_size && is_compressible(content_type)) {
+            std::string compressed;
+            if (gzip_compress(data, config_.gzip_level, &compressed) && compressed.size() < data.size()) {
+                entry->gzip_body = net::SharedFrame(std::move(compressed));
+            }
+        }
+        entry->body = net::SharedFrame(std::move(data));
+    } else {
+        entry->file = file;
+    }
+
+    // 预先序列化响应头：命中时只需拼接状态行与 Content-Length
+    auto make_block = [&](const std::string& tag, const char* extra) {
+        std::string block;
+        block += "Content-Type: ";
+        block += content_type;
+        block += "\r\nETag: ";
+        block += tag;
+        block += "\r\nLast-Modified: ";
+        block += entry->last_modified;
+        block += "\r\nCache-Control: ";
+        block += config_.max_age_sec > 0
+                     ? "public, max-age=" + std::to_string(config_.max_age_sec)
+                     : std::string("no-cache");
+        block += "\r\nAccept-Ranges: bytes\r\n";
+        if (!entry->gzip_body.empty()) {
+            block += "Vary: Accept-Encoding\r\n";
+        }
+        block += extra;
+        return block;
+    };
+    entry->header_block = make_block(entry->etag, "");
+    if (!entry->gzip_body.empty()) {
+        // gzip 变体是不同的表示，使用不同的强 ETag
+        std::string gz_tag = entry->etag;
+        gz_tag.insert(gz_tag.size() - 1, "-gz");
+        entry->gzip_header_block = make_block(gz_tag, "Content-Encoding: gzip\r\n");
+    }
+    return entry;
+}
+
+bool StaticFileHandler::still_valid(const Entry& entry) const {
+    const std::int64_t now = now_ms();
+    if (config_.revalidate_ms > 0 && now - entry.checked_ms.load() < config_.revalidate_ms) {
+        return true;
+    }
+    struct stat st;
+    if (::stat(entry.full_path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    std::int64_t mtime_ns = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000LL +
+                            st.st_mtim.tv_nsec;
+    if (static_cast<std::uint64_t>(st.st_size) != entry.size || mtime_ns != entry.mtime_ns) {
+        return false;
+    }
+    entry.checked_ms = now;
+    return true;
+}
+
+void StaticFileHandler::insert_locked(const std::string& key, const EntryPtr& entry) {
+    if (cache_.count(key)) {
+        erase_locked(key);
+    }
+    if (entry->cached_bytes() > config_.cache_max_bytes || config_.cache_max_entries == 0) {
+        return;
+    }
+    lru_.push_front(key);
+    cache_[key] = Slot{entry, lru_.begin()};
+    cached_bytes_ += entry->cached_bytes();
+    while (!lru_.empty() &&
+           (cached_bytes_ > config_.cache_max_bytes || cache_.size() > config_.cache_max_entries)) {
+        erase_locked(lru_.back());
+    }
+}
+
+void StaticFileHandler::erase_locked(const std::string& key) {
+    auto it = cache_.find(key);
+    if (it == cache_.end()) {
+        return;
+    }
+    cached_bytes_ -= it->second.entry->cached_bytes();
+    lru_.erase(it->second.lru);
+    cache_.erase(it);
+}
+
+StaticFileHandler::Stats StaticFileHandler::stats() const {
+    Stats s;
+    s.hits = hits_.load();
+    s.misses = misses_.load();
+    s.not_modified = not_modified_.load();
+    std::lock_guard<std::mutex> lock(mutex_);
+    s.entries = cache_.size();
+    s.cached_bytes = cached_bytes_;
+    return s;
+}
+
+void StaticFileHandler::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_.clear();
+    lru_.clear();
+    cached_bytes_ = 0;
+}
+
+} // namespace http
+} // namespace chwell
@@ -130,11 +130,20 @@ PrometheusRegistry& get_prometheus_registry() {
 void PrometheusRegistry::reset() {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    counters_.clear();
-    gauges_.clear();
+    for (auto& kv : counters_) {
+        kv.second->reset();
+    }
+    for (auto& kv : gauges_) {
+        kv.second->set(0.0);
+    }
+    for (const auto& kv : histograms_) {
+        metric_infos_.erase(kv.first);
+    }
+    for (const auto& kv : summaries_) {
+        metric_infos_.erase(kv.first);
+    }
     histograms_.clear();
     summaries_.clear();
-    metric_infos_.clear();
 }
 
 } // namespace metrics
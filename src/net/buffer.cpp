@@ -0,0 +1,76 @@
+#include "chwell/net/buffer.h"
+
+#include <cerrno>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace chwell {
+namespace net {
+
+const std::size_t Buffer::kCheapPrepend;
+const std::size_t Buffer::kInitialSize;
+
+namespace {
+
+// readv 的栈上临时区：空间不足时兜底，读入后再追加到 Buffer
+const std::size_t kExtraBufferSize = 65536;
+
+} // anonymous namespace
+
+void Buffer::make_space(std::size_t len) {
+    std::size_t readable = readable_bytes();
+    if (writable_bytes() + prependable_bytes() < len + kCheapPrepend) {
+        // 总空闲不足：直接扩容（vector 翻倍增长，摊还 O(1)）
+        buffer_.resize(writer_index_ + len);
+        return;
+    }
+    // 总空闲足够：只搬移未读的残余数据到预留头部之后
+    std::memmove(buffer_.data() + kCheapPrepend, buffer_.data() + reader_index_, readable);
+    reader_index_ = kCheapPrepend;
+    writer_index_ = reader_index_ + readable;
+}
+
+void Buffer::shrink(std::size_t reserve) {
+    std::vector<char> fresh(kCheapPrepend + readable_bytes() + reserve);
+    std::memcpy(fresh.data() + kCheapPrepend, peek(), readable_bytes());
+    writer_index_ = kCheapPrepend + readable_bytes();
+    reader_index_ = kCheapPrepend;
+    buffer_.swap(fresh);
+}
+
+ssize_t Buffer::read_fd(int fd, int* saved_errno, std::size_t max_bytes) {
+    if (max_bytes > 0) {
+        // 限量读取：预留 max_bytes 后直接读入 Buffer，不经临时区
+        ensure_writable(max_bytes);
+        const ssize_t n = ::read(fd, begin_write(), max_bytes);
+        if (n < 0) {
+            *saved_errno = errno;
+        } else {
+            writer_index_ += static_cast<std::size_t>(n);
+        }
+        return n;
+    }
+
+    char extra[kExtraBufferSize];
+    iovec vec[2];
+    const std::size_t writable = writable_bytes();
+    vec[0].iov_base = begin_write();
+    vec[0].iov_len = writable;
+    vec[1].iov_base = extra;
+    vec[1].iov_len = sizeof(extra);
+    // 可写空间已不小于临时区时只读入 Buffer 本身
+    const int iovcnt = (writable < sizeof(extra)) ? 2 : 1;
+    const ssize_t n = ::readv(fd, vec, iovcnt);
+    if (n < 0) {
+        *saved_errno = errno;
+    } else if (static_cast<std::size_t>(n) <= writable) {
+        writer_index_ += static_cast<std::size_t>(n);
+    } else {
+        writer_index_ = buffer_.size();
+        append(extra, static_cast<std::size_t>(n) - writable);
+    }
+    return n;
+}
+
+} // namespace net
+} // namespace chwell
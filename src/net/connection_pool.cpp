@@ -1,23 +1,52 @@
 #include "chwell/net/connection_pool.h"
-#include <cassert>
-#include <thread>
+#include <algorithm>
+#include <condition_variable>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
-#include <poll.h>
 #include <cerrno>
 #include <cstring>
 
 namespace chwell {
 namespace net {
 
-ConnectionPool::ConnectionPool(IoService& io_service, const ConnectionPoolConfig& config)
-    : io_service_(io_service)
-    , config_(config)
-    , shutdown_(false)
-    , pending_creates_(0) {
+namespace {
+
+// 未指定 loop 的连接池共用一个后台 loop 线程（建连与健康检查都很轻），进程退出前不停止，
+// 连接池可在任意线程（包括该 loop 线程）析构
+EventLoop* shared_pool_loop() {
+    static EventLoopThreadPool* loops = [] {
+        EventLoopThreadPool* p = new EventLoopThreadPool(1);
+        p->start();
+        return p;
+    }();
+    return loops->get_loop(0);
+}
+
+// 空闲连接的对端是否已关闭：非阻塞窥探一个字节，读到 EOF 或出错即视为失效
+bool peer_closed(int fd) {
+    char c;
+    ssize_t n = ::recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n == 0) {
+        return true;
+    }
+    return n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR;
+}
+
+} // anonymous namespace
+
+ConnectionPool::ConnectionPool(IoService& /*io_service*/, const ConnectionPoolConfig& config)
+    : ConnectionPool(shared_pool_loop(), config) {
+}
+
+ConnectionPool::ConnectionPool(EventLoop* loop, const ConnectionPoolConfig& config)
+    : config_(config)
+    , loop_(loop)
+    , timers_(std::make_shared<LoopTimers>())
+    , health_(config.ejection)
+    , shutdown_(false) {
 }
 
 ConnectionPool::~ConnectionPool() {
@@ -25,24 +54,38 @@ ConnectionPool::~ConnectionPool() {
 }
 
 bool ConnectionPool::init() {
-    if (shutdown_) {
+    if (shutdown_ || !loop_) {
         return false;
     }
 
-    // 预创建 min_connections 个连接（在锁外创建，避免阻塞锁）
-    for (int i = 0; i < config_.min_connections; ++i) {
-        auto pooled = std::make_unique<PooledConnection>();
-        if (create_connection(*pooled)) {
-            std::lock_guard<std::mutex> lock(mutex_);
-            connections_.push_back(std::move(pooled));
-        }
+    in_addr addr;
+    if (config_.host.empty() || config_.port == 0 ||
+        inet_pton(AF_INET, config_.host.c_str(), &addr) <= 0) {
+        CHWELL_LOG_ERROR("ConnectionPool: invalid host/port (host="
+                       << config_.host << " port=" << config_.port << ")");
+        return false;
     }
 
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::weak_ptr<ConnectionPool> weak = shared_from_this();
+    timers_->health.set_callback([weak]() {
+        if (Ptr self = weak.lock()) self->run_health_check();
+    });
+    timers_->waiters.set_callback([weak]() {
+        if (Ptr self = weak.lock()) self->expire_waiters();
+    });
+
+    // 预热在后台进行，init() 不等待建连
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        maybe_expand_locked();
+    }
+    loop_->run_in_loop([weak]() {
+        if (Ptr self = weak.lock()) self->schedule_health_check();
+    });
+
     CHWELL_LOG_INFO("ConnectionPool initialized for "
                   << config_.host << ":" << config_.port
-                  << " (" << connections_.size() << "/" << config_.min_connections
-                  << " pre-created)");
+                  << " (pre-warming " << config_.min_connections << " connections)");
     return true;
 }
 
@@ -50,125 +93,177 @@ void ConnectionPool::shutdown() {
     if (shutdown_.exchange(true)) {
         return;
     }
-    
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    for (auto& conn : connections_) {
-        if (conn && conn->connection) {
-            conn->connection->close();
+
+    std::vector<ConnectionCallback> failed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& conn : connections_) {
+            if (conn && conn->connection) {
+                conn->connection->close();
+            }
+        }
+        connections_.clear();
+        for (auto& w : waiters_) {
+            failed.push_back(std::move(w.callback));
         }
+        waiters_.clear();
     }
-    connections_.clear();
-    
-    while (!waiting_callbacks_.empty()) {
-        auto cb = waiting_callbacks_.front();
-        waiting_callbacks_.pop();
+
+    for (auto& cb : failed) {
         if (cb) {
             PooledConnection empty;
             cb(empty);
         }
     }
-    
-    cv_.notify_all();
-    
+
+    // 定时器只能在 loop 线程摘除；任务持有 timers_ 的引用，连接池先析构也不会悬空。
+    // 尚未完成的建连回调找不到连接池后直接关闭 socket
+    if (loop_) {
+        EventLoop* loop = loop_;
+        std::shared_ptr<LoopTimers> timers = timers_;
+        loop->run_in_loop([loop, timers]() {
+            loop->timers().cancel(&timers->health);
+            loop->timers().cancel(&timers->waiters);
+        });
+    }
+
     CHWELL_LOG_INFO("ConnectionPool shutdown: " << config_.host << ":" << config_.port);
 }
 
-bool ConnectionPool::create_connection(PooledConnection& conn) {
-    if (config_.host.empty() || config_.port == 0) {
-        CHWELL_LOG_ERROR("ConnectionPool: invalid host/port (host="
-                       << config_.host << " port=" << config_.port << ")");
-        return false;
+void ConnectionPool::maybe_expand_locked() {
+    if (shutdown_ || !loop_) {
+        return;
     }
 
-    struct sockaddr_in addr;
-    std::memset(&addr, 0, sizeof(addr));
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(config_.port);
-    if (inet_pton(AF_INET, config_.host.c_str(), &addr.sin_addr) <= 0) {
-        CHWELL_LOG_ERROR("ConnectionPool: invalid host address: " + config_.host);
-        return false;
+    // 目标：总数不低于 min_connections，且每个等待者都有一个正在建立的连接
+    int total = static_cast<int>(connections_.size()) + pending_creates_;
+    int want = std::max(config_.min_connections - total,
+                        static_cast<int>(waiters_.size()) - pending_creates_);
+    want = std::min(want, config_.max_connections - total);
+    if (want <= 0) {
+        return;
     }
 
-    // 创建非阻塞 socket，以便支持连接超时
-    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
-    if (fd < 0) {
-        CHWELL_LOG_ERROR("ConnectionPool: socket() failed: " + std::string(strerror(errno)));
-        return false;
+    if (health_.tripped()) {
+        // 摘除期间不建连；退避到期后只放行一个试探连接，成功后再补齐
+        if (pending_creates_ == 0 && health_.allow(PooledConnection::current_time_ms())) {
+            start_connect_locked();
+        }
+        return;
     }
-
-    int ret = ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
-    if (ret < 0 && errno != EINPROGRESS) {
-        CHWELL_LOG_ERROR("ConnectionPool: connect() failed: " + std::string(strerror(errno)));
-        ::close(fd);
-        return false;
+    for (int i = 0; i < want; ++i) {
+        start_connect_locked();
     }
+}
 
-    if (ret < 0) {
-        // EINPROGRESS：用 poll 等待连接完成
-        int timeout_ms = config_.connect_timeout_ms > 0 ? config_.connect_timeout_ms : 5000;
-        struct pollfd pfd;
-        pfd.fd = fd;
-        pfd.events = POLLOUT;
-        int r = poll(&pfd, 1, timeout_ms);
-        if (r <= 0) {
-            CHWELL_LOG_ERROR("ConnectionPool: connect timeout to "
-                           + config_.host + ":" + std::to_string(config_.port));
-            ::close(fd);
-            return false;
+void ConnectionPool::start_connect_locked() {
+    ++pending_creates_;
+    std::weak_ptr<ConnectionPool> weak = shared_from_this();
+    Connector::start(loop_, config_.host, config_.port, config_.connect_timeout_ms,
+                     [weak](TcpSocket socket, int err) {
+        if (Ptr self = weak.lock()) {
+            self->on_connected(std::move(socket), err);
         }
-        int err = 0;
-        socklen_t len = sizeof(err);
-        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
-            CHWELL_LOG_ERROR("ConnectionPool: connect error: " + std::string(strerror(err)));
-            ::close(fd);
-            return false;
+    });
+}
+
+void ConnectionPool::on_connected(TcpSocket socket, int err) {
+    std::vector<std::pair<ConnectionCallback, PooledConnection>> ready;
+    std::vector<ConnectionCallback> failed;
+    std::int64_t retry_delay = -1;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --pending_creates_;
+        if (shutdown_) {
+            return;
         }
-    }
 
-    // 切回阻塞模式（与 TcpSocket 阻塞 read/write 一致）
-    int flags = fcntl(fd, F_GETFL, 0);
-    fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+        std::int64_t now = PooledConnection::current_time_ms();
+        if (err != 0) {
+            health_.on_failure(now);
+            CHWELL_LOG_WARN("ConnectionPool: connect to " << config_.host << ":" << config_.port
+                          << " failed: " << strerror(err)
+                          << " (consecutive failures: " << health_.consecutive_failures() << ")");
+            if (health_.tripped()) {
+                // 后端被摘除：等待中的获取立即失败，不再各自等到超时
+                for (auto& w : waiters_) {
+                    failed.push_back(std::move(w.callback));
+                }
+                waiters_.clear();
+                retry_delay = std::max<std::int64_t>(0, health_.retry_at_ms() - now);
+            } else {
+                maybe_expand_locked();
+            }
+        } else {
+            if (health_.tripped()) {
+                CHWELL_LOG_INFO("ConnectionPool: backend " << config_.host << ":" << config_.port
+                              << " is reachable again");
+            }
+            health_.on_success();
+
+            // 池化连接以阻塞模式读写
+            int fd = socket.native_handle();
+            int flags = fcntl(fd, F_GETFL, 0);
+            fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+
+            std::unique_ptr<PooledConnection> pooled(new PooledConnection());
+            pooled->connection = std::make_shared<TcpConnection>(std::move(socket));
+            pooled->create_time = now;
+            pooled->last_used_time = now;
+            pooled->is_valid = true;
+            connections_.push_back(std::move(pooled));
 
-    conn.connection = std::make_shared<TcpConnection>(TcpSocket(fd));
-    conn.create_time = PooledConnection::current_time_ms();
-    conn.last_used_time = conn.create_time;
-    conn.in_use = false;
-    conn.is_valid = true;
+            hand_to_waiters_locked(ready);
+            maybe_expand_locked();
+        }
+    }
 
-    CHWELL_LOG_INFO("ConnectionPool: new connection to "
-                  + config_.host + ":" + std::to_string(config_.port));
-    return true;
+    if (retry_delay >= 0 && config_.min_connections > 0) {
+        // 退避到期时由健康检查发起试探（on_connected 总在 loop 线程执行）
+        loop_->timers().schedule(&timers_->health, loop_->now_ms(), retry_delay);
+    }
+    for (auto& cb : failed) {
+        if (cb) {
+            PooledConnection empty;
+            cb(empty);
+        }
+    }
+    for (auto& r : ready) {
+        if (r.first) {
+            r.first(r.second);
+        }
+    }
 }
 
 bool ConnectionPool::validate_connection(PooledConnection& conn) {
     if (!conn.connection || !conn.is_valid) {
         return false;
     }
-    
+
     int64_t now = PooledConnection::current_time_ms();
-    
+
     if (config_.max_lifetime_ms > 0) {
         if (now - conn.create_time > config_.max_lifetime_ms) {
             conn.is_valid = false;
             return false;
         }
     }
-    
+
     if (!conn.in_use) {
-        if (now - conn.last_used_time > config_.idle_timeout_ms) {
+        if (now - conn.last_used_time > config_.idle_timeout_ms ||
+            peer_closed(conn.connection->native_handle())) {
             conn.is_valid = false;
             return false;
         }
     }
-    
+
     return true;
 }
 
 void ConnectionPool::cleanup_expired() {
     auto it = connections_.begin();
     while (it != connections_.end()) {
-        if (!validate_connection(**it) && !(*it)->in_use) {
+        if (!(*it)->in_use && !validate_connection(**it)) {
             if ((*it)->connection) {
                 (*it)->connection->close();
             }
@@ -179,26 +274,6 @@ void ConnectionPool::cleanup_expired() {
     }
 }
 
-void ConnectionPool::maybe_expand() {
-    // 若当前空闲连接不足 min_connections，尝试补充（在持有 mutex_ 的情况下调用时需注意）
-    int total = static_cast<int>(connections_.size()) + pending_creates_.load();
-    if (total >= config_.min_connections || total >= config_.max_connections) {
-        return;
-    }
-    ++pending_creates_;
-    // 启动线程异步补充，避免在锁内阻塞
-    std::thread([this]() {
-        PooledConnection conn;
-        if (create_connection(conn)) {
-            std::lock_guard<std::mutex> lock(mutex_);
-            if (!shutdown_) {
-                connections_.push_back(std::make_unique<PooledConnection>(conn));
-            }
-        }
-        --pending_creates_;
-    }).detach();
-}
-
 bool ConnectionPool::try_get_idle(PooledConnection& conn) {
     for (auto& c : connections_) {
         if (!c->in_use && c->is_valid && validate_connection(*c)) {
@@ -211,8 +286,20 @@ bool ConnectionPool::try_get_idle(PooledConnection& conn) {
     return false;
 }
 
+void ConnectionPool::hand_to_waiters_locked(
+    std::vector<std::pair<ConnectionCallback, PooledConnection>>& ready) {
+    while (!waiters_.empty()) {
+        PooledConnection conn;
+        if (!try_get_idle(conn)) {
+            break;
+        }
+        ready.emplace_back(std::move(waiters_.front().callback), conn);
+        waiters_.pop_front();
+    }
+}
+
 void ConnectionPool::get_connection(ConnectionCallback callback, int timeout_ms) {
-    if (shutdown_) {
+    if (shutdown_ || !loop_) {
         PooledConnection empty;
         callback(empty);
         return;
@@ -230,44 +317,25 @@ void ConnectionPool::get_connection(ConnectionCallback callback, int timeout_ms)
             return;
         }
 
-        // 未超过最大连接数时，先记录 pending 然后锁外创建
-        int total = static_cast<int>(connections_.size()) + pending_creates_.load();
-        if (total < config_.max_connections) {
-            ++pending_creates_;
-        } else {
-            // 已达上限：排队等待（timeout_ms==0 则立即返回空）
-            if (timeout_ms != 0) {
-                waiting_callbacks_.push(callback);
-            } else {
-                lock.unlock();
-                PooledConnection empty;
-                callback(empty);
-            }
+        // 没有空闲连接：排队等待后台建连或其他调用方归还，调用线程从不等待网络
+        std::int64_t now = PooledConnection::current_time_ms();
+        if (timeout_ms == 0 || health_.ejected(now)) {
+            maybe_expand_locked();
+            lock.unlock();
+            PooledConnection empty;
+            callback(empty);
             return;
         }
+        waiters_.push_back(Waiter{std::move(callback), timeout_ms < 0 ? -1 : now + timeout_ms});
+        maybe_expand_locked();
     }
 
-    // 在锁外实际建立 TCP 连接，避免阻塞池锁
-    PooledConnection conn;
-    bool ok = create_connection(conn);
-    --pending_creates_;
-
-    if (!ok) {
-        PooledConnection empty;
-        callback(empty);
-        return;
-    }
-
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (!shutdown_) {
-            conn.in_use = true;
-            conn.last_used_time = PooledConnection::current_time_ms();
-            connections_.push_back(std::make_unique<PooledConnection>(conn));
-        }
+    if (timeout_ms > 0) {
+        std::weak_ptr<ConnectionPool> weak = shared_from_this();
+        loop_->run_in_loop([weak]() {
+            if (Ptr self = weak.lock()) self->arm_waiter_timer();
+        });
     }
-
-    callback(conn);
 }
 
 PooledConnection ConnectionPool::get_connection_sync(int timeout_ms) {
@@ -275,17 +343,17 @@ PooledConnection ConnectionPool::get_connection_sync(int timeout_ms) {
     std::mutex sync_mutex;
     std::condition_variable sync_cv;
     bool done = false;
-    
+
     get_connection([&](const PooledConnection& conn) {
         std::lock_guard<std::mutex> lock(sync_mutex);
         result = conn;
         done = true;
         sync_cv.notify_one();
     }, timeout_ms);
-    
+
     std::unique_lock<std::mutex> lock(sync_mutex);
     sync_cv.wait(lock, [&]() { return done; });
-    
+
     return result;
 }
 
@@ -293,36 +361,103 @@ void ConnectionPool::return_connection(PooledConnection& conn) {
     if (!conn.connection) {
         return;
     }
-    
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    for (auto& c : connections_) {
-        if (c->connection.get() == conn.connection.get()) {
-            c->in_use = false;
-            c->last_used_time = PooledConnection::current_time_ms();
-            
-            if (!c->is_valid) {
-                c->connection->close();
+
+    std::vector<std::pair<ConnectionCallback, PooledConnection>> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        for (auto it = connections_.begin(); it != connections_.end(); ++it) {
+            PooledConnection& c = **it;
+            if (c.connection.get() != conn.connection.get()) {
+                continue;
+            }
+            c.in_use = false;
+            c.last_used_time = PooledConnection::current_time_ms();
+            if (!conn.is_valid) {
+                c.is_valid = false;
+            }
+            if (!validate_connection(c)) {
+                c.connection->close();
+                connections_.erase(it);
+                maybe_expand_locked();
             }
             break;
         }
+
+        conn.connection.reset();
+        conn.is_valid = false;
+
+        hand_to_waiters_locked(ready);
+    }
+
+    for (auto& r : ready) {
+        if (r.first) {
+            r.first(r.second);
+        }
+    }
+}
+
+void ConnectionPool::schedule_health_check() {
+    if (shutdown_ || config_.health_check_interval_ms <= 0) {
+        return;
+    }
+    loop_->timers().schedule(&timers_->health, loop_->now_ms(), config_.health_check_interval_ms);
+}
+
+void ConnectionPool::run_health_check() {
+    if (shutdown_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cleanup_expired();
+        maybe_expand_locked();
+    }
+    schedule_health_check();
+}
+
+void ConnectionPool::arm_waiter_timer() {
+    if (shutdown_) {
+        return;
+    }
+    std::int64_t earliest = -1;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& w : waiters_) {
+            if (w.deadline >= 0 && (earliest < 0 || w.deadline < earliest)) {
+                earliest = w.deadline;
+            }
+        }
     }
-    
-    conn.connection.reset();
-    conn.is_valid = false;
-    
-    if (!waiting_callbacks_.empty()) {
-        PooledConnection idle_conn;
-        if (try_get_idle(idle_conn)) {
-            auto cb = waiting_callbacks_.front();
-            waiting_callbacks_.pop();
-            if (cb) {
-                cb(idle_conn);
+    if (earliest < 0) {
+        loop_->timers().cancel(&timers_->waiters);
+        return;
+    }
+    std::int64_t delay = std::max<std::int64_t>(0, earliest - PooledConnection::current_time_ms());
+    loop_->timers().schedule(&timers_->waiters, loop_->now_ms(), delay);
+}
+
+void ConnectionPool::expire_waiters() {
+    std::vector<ConnectionCallback> expired;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::int64_t now = PooledConnection::current_time_ms();
+        for (auto it = waiters_.begin(); it != waiters_.end();) {
+            if (it->deadline >= 0 && it->deadline <= now) {
+                expired.push_back(std::move(it->callback));
+                it = waiters_.erase(it);
+            } else {
+                ++it;
             }
         }
     }
-    
-    cv_.notify_one();
+    for (auto& cb : expired) {
+        if (cb) {
+            PooledConnection empty;
+            cb(empty);
+        }
+    }
+    arm_waiter_timer();
 }
 
 int ConnectionPool::total_connections() const {
@@ -352,5 +487,15 @@ int ConnectionPool::active_connections() const {
     return count;
 }
 
+int ConnectionPool::pending_connections() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_creates_;
+}
+
+bool ConnectionPool::healthy() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !health_.tripped();
+}
+
 } // namespace net
-} // namespace chwell
\ No newline at end of file
+} // namespace chwell
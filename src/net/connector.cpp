@@ -0,0 +1,144 @@
+#include "chwell/net/connector.h"
+#include "chwell/net/event_loop.h"
+#include "chwell/core/logger.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace chwell {
+namespace net {
+
+// ============================================
+// Connector
+// ============================================
+
+Connector::Connector(EventLoop* loop, const std::string& host, unsigned short port,
+                     int timeout_ms, Callback cb)
+    : loop_(loop), host_(host), port_(port), timeout_ms_(timeout_ms), cb_(std::move(cb)) {
+}
+
+std::shared_ptr<Connector> Connector::start(EventLoop* loop, const std::string& host,
+                                            unsigned short port, int timeout_ms, Callback cb) {
+    std::shared_ptr<Connector> c(new Connector(loop, host, port, timeout_ms, std::move(cb)));
+    c->self_ = c;
+    loop->queue_in_loop([c]() { c->connect_in_loop(); });
+    return c;
+}
+
+void Connector::cancel() {
+    std::shared_ptr<Connector> self = shared_from_this();
+    loop_->queue_in_loop([self]() { self->finish(ECANCELED); });
+}
+
+void Connector::connect_in_loop() {
+    if (done_) {
+        return;  // 已被取消
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port_);
+    if (host_.empty() || port_ == 0 || inet_pton(AF_INET, host_.c_str(), &addr.sin_addr) <= 0) {
+        finish(EINVAL);
+        return;
+    }
+
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        finish(errno);
+        return;
+    }
+    socket_ = TcpSocket(fd);
+
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0) {
+        finish(0);  // 本机回环可能立即完成
+        return;
+    }
+    if (errno != EINPROGRESS) {
+        finish(errno);
+        return;
+    }
+
+    // 连接完成（成功或失败）时 socket 变为可写；handler 在 finish 中移除，此前 self_ 保持对象存活
+    loop_->add_fd(fd, EPOLLOUT, [this](std::uint32_t) { handle_writable(); });
+    registered_ = true;
+    if (timeout_ms_ > 0) {
+        timer_.set_callback([this]() { finish(ETIMEDOUT); });
+        loop_->timers().schedule(&timer_, loop_->now_ms(), timeout_ms_);
+    }
+}
+
+void Connector::handle_writable() {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (::getsockopt(socket_.native_handle(), SOL_SOCKET, SO_ERROR, &err, &len) < 0) {
+        err = errno;
+    }
+    finish(err);
+}
+
+void Connector::finish(int err) {
+    if (done_) {
+        return;
+    }
+    done_ = true;
+    if (registered_) {
+        loop_->remove_fd(socket_.native_handle());
+        registered_ = false;
+    }
+    loop_->timers().cancel(&timer_);
+
+    TcpSocket socket;
+    if (err == 0) {
+        socket = std::move(socket_);
+    } else {
+        socket_ = TcpSocket();
+        CHWELL_LOG_DEBUG("Connector: connect to " << host_ << ":" << port_
+                         << " failed: " << strerror(err));
+    }
+
+    Callback cb = std::move(cb_);
+    cb_ = nullptr;
+    std::shared_ptr<Connector> self = std::move(self_);  // 回调返回前不析构
+    if (cb) {
+        cb(std::move(socket), err);
+    }
+}
+
+// ============================================
+// BackendHealth
+// ============================================
+
+bool BackendHealth::allow(std::int64_t now_ms) {
+    if (!tripped()) {
+        return true;
+    }
+    if (now_ms < retry_at_ms_) {
+        return false;
+    }
+    retry_at_ms_ = now_ms + backoff_ms_;
+    return true;
+}
+
+void BackendHealth::on_success() {
+    failures_ = 0;
+    backoff_ms_ = 0;
+    retry_at_ms_ = 0;
+}
+
+void BackendHealth::on_failure(std::int64_t now_ms) {
+    ++failures_;
+    if (failures_ < policy_.eject_after_failures) {
+        return;
+    }
+    backoff_ms_ = backoff_ms_ > 0 ? std::min(backoff_ms_ * 2, policy_.backoff_max_ms)
+                                  : policy_.backoff_initial_ms;
+    retry_at_ms_ = now_ms + backoff_ms_;
+}
+
+} // namespace net
+} // namespace chwell
@@ -0,0 +1,369 @@
+#include "chwell/net/event_loop.h"
+#include "chwell/net/tcp_connection.h"
+#include "chwell/core/logger.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <string>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+namespace chwell {
+namespace net {
+
+namespace {
+
+const int kInitEventListSize = 64;
+const int kPollTimeoutMs = 10000;
+// 时间轮精度：空闲检测等秒级超时足够，且有定时器时 loop 每秒至多被唤醒 10 次
+const int kTimerTickMs = 100;
+// 借用读缓冲归还时保留的最大容量
+const std::size_t kMaxPooledReadBuffer = 64 * 1024;
+
+std::int64_t steady_now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // anonymous namespace
+
+// ============================================
+// EventLoop
+// ============================================
+
+EventLoop::EventLoop(IoBackend backend)
+    : poller_(Poller::create(backend)),
+      thread_id_(std::this_thread::get_id()),
+      timers_(kTimerTickMs) {
+    update_now();
+    active_events_.reserve(kInitEventListSize);
+    if (!poller_->valid()) {
+        return;
+    }
+
+    wakeup_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeup_fd_ < 0) {
+        CHWELL_LOG_ERROR("EventLoop: eventfd failed: " + std::string(strerror(errno)));
+        return;
+    }
+
+    poller_->add(wakeup_fd_, EPOLLIN);
+}
+
+EventLoop::~EventLoop() {
+    if (wakeup_fd_ >= 0) {
+        ::close(wakeup_fd_);
+        wakeup_fd_ = -1;
+    }
+}
+
+void EventLoop::loop() {
+    if (!is_in_loop_thread()) {
+        CHWELL_LOG_ERROR("EventLoop::loop must run in the thread that created the loop");
+        return;
+    }
+    if (!poller_->valid() || wakeup_fd_ < 0) {
+        return;
+    }
+
+    CHWELL_LOG_DEBUG("EventLoop started, backend=" << io_backend_name(poller_->backend()));
+    looping_ = true;
+    while (!quit_) {
+        active_events_.clear();
+        int timeout = timers_.next_timeout_ms(now_ms());
+        if (timeout < 0 || timeout > kPollTimeoutMs) {
+            timeout = kPollTimeoutMs;
+        }
+        int cork = cork_timeout_ms();
+        if (cork >= 0 && cork < timeout) {
+            timeout = cork;
+        }
+        int n = poller_->poll(timeout, active_events_);
+        update_now();
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            CHWELL_LOG_ERROR("EventLoop poll error: " + std::string(strerror(errno)));
+            break;
+        }
+
+        for (const IoEvent& ev : active_events_) {
+            dispatch(ev);
+        }
+        timers_.advance(now_ms());
+        retired_handlers_.clear();
+        retired_recv_handlers_.clear();
+
+        do_pending_functors();
+
+        // 本轮事件与任务产生的暂存输出已全部入队：到达 tick 边界时统一写出
+        std::int64_t deadline = cork_deadline_.load(std::memory_order_relaxed);
+        if (deadline >= 0 && now_ms() >= deadline) {
+            flush_corked_now();
+        }
+    }
+    looping_ = false;
+    CHWELL_LOG_DEBUG("EventLoop stopped");
+}
+
+void EventLoop::update_now() {
+    now_ms_.store(steady_now_ms(), std::memory_order_relaxed);
+}
+
+void EventLoop::add_corked(std::shared_ptr<TcpConnection> conn) {
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (corked_.empty()) {
+            // 本 tick 第一个登记的连接确定截止时间；loop 可能正阻塞在较长的 poll 超时上，需唤醒重算
+            const int tick = cork_tick_ms();
+            const std::int64_t now = steady_now_ms();
+            cork_deadline_.store(tick > 0 ? (now / tick + 1) * tick : 0, std::memory_order_relaxed);
+            wake = !is_in_loop_thread();
+        }
+        corked_.push_back(std::move(conn));
+    }
+    if (wake) {
+        wakeup();
+    }
+}
+
+int EventLoop::cork_timeout_ms() const {
+    std::int64_t deadline = cork_deadline_.load(std::memory_order_relaxed);
+    if (deadline < 0) {
+        return -1;
+    }
+    std::int64_t now = now_ms();
+    return deadline > now ? static_cast<int>(deadline - now) : 0;
+}
+
+Buffer* EventLoop::acquire_read_buffer() {
+    if (read_buffers_.empty()) {
+        return new Buffer();
+    }
+    Buffer* buffer = read_buffers_.back().release();
+    read_buffers_.pop_back();
+    return buffer;
+}
+
+void EventLoop::release_read_buffer(Buffer* buffer) {
+    // 连接交付后已清空缓冲；被突发流量撑大的缓冲收缩后再放回
+    buffer->retrieve_all();
+    if (buffer->capacity() > kMaxPooledReadBuffer) {
+        buffer->shrink(Buffer::kInitialSize);
+    }
+    read_buffers_.emplace_back(buffer);
+}
+
+void EventLoop::flush_corked() {
+    run_in_loop([this]() { flush_corked_now(); });
+}
+
+void EventLoop::flush_corked_now() {
+    std::vector<std::shared_ptr<TcpConnection>> conns;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        conns.swap(corked_);
+        cork_deadline_.store(-1, std::memory_order_relaxed);
+    }
+    for (const auto& conn : conns) {
+        conn->flush_corked();
+    }
+}
+
+void EventLoop::dispatch(const IoEvent& ev) {
+    if (ev.kind == IoEvent::kRecv) {
+        // 本轮早先的回调可能已移除该 fd（或 fd 已被复用），过期数据直接丢弃
+        if (poller_->is_current(ev)) {
+            auto it = recv_handlers_.find(ev.fd);
+            if (it != recv_handlers_.end()) {
+                it->second(ev.data, ev.result);
+            }
+        }
+        if (ev.buffer_id >= 0) {
+            poller_->release_buffer(ev.buffer_id);
+        }
+        return;
+    }
+
+    if (ev.fd == wakeup_fd_) {
+        handle_wakeup();
+        return;
+    }
+    if (!poller_->is_current(ev)) {
+        return;
+    }
+    auto it = handlers_.find(ev.fd);
+    if (it != handlers_.end()) {
+        it->second(ev.events);
+    }
+}
+
+void EventLoop::quit() {
+    quit_ = true;
+    if (!is_in_loop_thread()) {
+        wakeup();
+    }
+}
+
+void EventLoop::run_in_loop(Functor cb) {
+    if (is_in_loop_thread()) {
+        cb();
+    } else {
+        queue_in_loop(std::move(cb));
+    }
+}
+
+void EventLoop::queue_in_loop(Functor cb) {
+    if (!cb) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_functors_.push_back(std::move(cb));
+    }
+    // 非 loop 线程投递，或 loop 正在执行 pending 任务（新任务需下一轮执行）时唤醒
+    if (!is_in_loop_thread() || calling_pending_) {
+        wakeup();
+    }
+}
+
+void EventLoop::add_fd(int fd, std::uint32_t events, EventHandler handler) {
+    if (!poller_->add(fd, events)) {
+        CHWELL_LOG_ERROR("EventLoop: add fd=" << fd << " failed: " << strerror(errno));
+        return;
+    }
+    handlers_[fd] = std::move(handler);
+}
+
+void EventLoop::modify_fd(int fd, std::uint32_t events) {
+    if (!poller_->modify(fd, events)) {
+        CHWELL_LOG_WARN("EventLoop: modify fd=" << fd << " failed: " << strerror(errno));
+    }
+}
+
+void EventLoop::remove_fd(int fd) {
+    auto it = handlers_.find(fd);
+    if (it == handlers_.end()) {
+        return;
+    }
+    poller_->remove(fd);
+    retired_handlers_.push_back(std::move(it->second));
+    handlers_.erase(it);
+}
+
+bool EventLoop::add_recv(int fd, RecvHandler handler) {
+    if (!poller_->add_recv(fd)) {
+        return false;
+    }
+    recv_handlers_[fd] = std::move(handler);
+    return true;
+}
+
+void EventLoop::pause_recv(int fd) {
+    poller_->pause_recv(fd);
+}
+
+void EventLoop::resume_recv(int fd) {
+    poller_->resume_recv(fd);
+}
+
+void EventLoop::remove_recv(int fd) {
+    auto it = recv_handlers_.find(fd);
+    if (it == recv_handlers_.end()) {
+        return;
+    }
+    poller_->remove_recv(fd);
+    retired_recv_handlers_.push_back(std::move(it->second));
+    recv_handlers_.erase(it);
+}
+
+void EventLoop::wakeup() {
+    std::uint64_t one = 1;
+    ssize_t n = ::write(wakeup_fd_, &one, sizeof(one));
+    (void)n;  // eventfd 计数溢出前不会失败；失败时 loop 最迟在超时后处理
+}
+
+void EventLoop::handle_wakeup() {
+    std::uint64_t value = 0;
+    ssize_t n = ::read(wakeup_fd_, &value, sizeof(value));
+    (void)n;  // drain eventfd
+}
+
+void EventLoop::do_pending_functors() {
+    std::vector<Functor> functors;
+    calling_pending_ = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        functors.swap(pending_functors_);
+    }
+    for (auto& f : functors) {
+        f();
+    }
+    calling_pending_ = false;
+}
+
+// ============================================
+// EventLoopThreadPool
+// ============================================
+
+EventLoopThreadPool::EventLoopThreadPool(std::size_t num_threads)
+    : num_threads_(num_threads == 0 ? 1 : num_threads),
+      backend_(default_io_backend()) {
+}
+
+EventLoopThreadPool::~EventLoopThreadPool() {
+    stop();
+}
+
+void EventLoopThreadPool::start() {
+    if (started_.exchange(true)) {
+        return;
+    }
+
+    for (std::size_t i = 0; i < num_threads_; ++i) {
+        std::promise<EventLoop*> ready;
+        std::future<EventLoop*> fut = ready.get_future();
+        IoBackend backend = backend_;
+        // promise 移入线程：fut.get() 返回时 set_value 可能尚未完全退出，不能引用本栈帧上的对象
+        threads_.emplace_back([ready = std::move(ready), backend]() mutable {
+            // loop 必须在所属线程内创建，以绑定线程 ID
+            EventLoop* loop = new EventLoop(backend);
+            ready.set_value(loop);
+            loop->loop();
+        });
+        loops_.emplace_back(fut.get());
+    }
+
+    CHWELL_LOG_INFO("EventLoopThreadPool started with " << num_threads_ << " loop(s), backend="
+                    << io_backend_name(loops_.front()->backend()));
+}
+
+void EventLoopThreadPool::stop() {
+    for (auto& loop : loops_) {
+        loop->quit();
+    }
+    for (auto& t : threads_) {
+        if (t.joinable()) {
+            t.join();
+        }
+    }
+    threads_.clear();
+}
+
+EventLoop* EventLoopThreadPool::next_loop() {
+    if (loops_.empty()) {
+        return nullptr;
+    }
+    std::size_t idx = next_.fetch_add(1, std::memory_order_relaxed) % loops_.size();
+    return loops_[idx].get();
+}
+
+EventLoop* EventLoopThreadPool::get_loop(std::size_t index) const {
+    if (index >= loops_.size()) {
+        return nullptr;
+    }
+    return loops_[index].get();
+}
+
+} // namespace net
+} // namespace chwell
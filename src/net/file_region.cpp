@@ -0,0 +1,64 @@
+#include "chwell/net/file_region.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace chwell {
+namespace net {
+
+SharedFile::~SharedFile() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+std::shared_ptr<SharedFile> SharedFile::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    int saved = 0;
+    if (::fstat(fd, &st) != 0) {
+        saved = errno;
+    } else if (!S_ISREG(st.st_mode)) {
+        saved = S_ISDIR(st.st_mode) ? EISDIR : EINVAL;
+    }
+    if (saved != 0) {
+        ::close(fd);
+        errno = saved;
+        return nullptr;
+    }
+    std::int64_t mtime_ns = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000LL +
+                            st.st_mtim.tv_nsec;
+    return std::shared_ptr<SharedFile>(
+        new SharedFile(fd, static_cast<std::uint64_t>(st.st_size), mtime_ns));
+}
+
+std::size_t read_file_region(const FileRegion& region, std::size_t max_bytes, std::string* out) {
+    if (region.empty()) {
+        return 0;
+    }
+    std::size_t want = region.length < max_bytes ? static_cast<std::size_t>(region.length) : max_bytes;
+    std::size_t base = out->size();
+    out->resize(base + want);
+    std::size_t got = 0;
+    while (got < want) {
+        ssize_t n = ::pread(region.file->fd(), &(*out)[base + got], want - got,
+                            static_cast<off_t>(region.offset + got));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;  // 出错或文件被截断
+        }
+        got += static_cast<std::size_t>(n);
+    }
+    out->resize(base + got);
+    return got;
+}
+
+} // namespace net
+} // namespace chwell
@@ -0,0 +1,572 @@
+#include "chwell/net/poller.h"
+#include "chwell/core/logger.h"
+
+#ifdef CHWELL_USE_IO_URING
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace chwell {
+namespace net {
+
+namespace {
+
+const unsigned kSqEntries = 1024;
+const unsigned kCqEntries = 8192;
+// 接收缓冲环：每个 loop 256 x 4KB，数据交付给回调后立即归还
+const unsigned kRecvBufferCount = 256;
+const unsigned kRecvBufferSize = 4096;
+const std::uint16_t kRecvBufferGroup = 0;
+
+// user_data 布局：[kind:8][token:24][fd:32]
+enum OpKind : std::uint64_t {
+    kOpPoll = 1,
+    kOpRecv = 2,
+    kOpCancel = 3
+};
+
+inline std::uint64_t make_user_data(OpKind kind, std::uint32_t token, int fd) {
+    return (static_cast<std::uint64_t>(kind) << 56) |
+           (static_cast<std::uint64_t>(token & 0xFFFFFFu) << 32) |
+           static_cast<std::uint32_t>(fd);
+}
+
+inline OpKind user_data_kind(std::uint64_t ud) { return static_cast<OpKind>(ud >> 56); }
+inline std::uint32_t user_data_token(std::uint64_t ud) { return static_cast<std::uint32_t>((ud >> 32) & 0xFFFFFFu); }
+inline int user_data_fd(std::uint64_t ud) { return static_cast<int>(static_cast<std::uint32_t>(ud)); }
+
+int sys_io_uring_setup(unsigned entries, io_uring_params* p) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, p));
+}
+
+int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                       unsigned flags, void* arg, std::size_t argsz) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                                      flags, arg, argsz));
+}
+
+int sys_io_uring_register(int fd, unsigned opcode, void* arg, unsigned nr_args) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+// io_uring 后端（直接使用系统调用，不依赖 liburing）
+// - fd 就绪：EPOLLET 注册使用多路 poll（IORING_POLL_ADD_MULTI），水平触发注册使用单次 poll 并在完成后重新提交
+// - 接收：多路 recv + provided buffer ring，一次提交持续产出数据完成事件
+// - 每轮 loop 只调用一次 io_uring_enter，同时完成提交与等待
+class IoUringPoller : public Poller {
+public:
+    IoUringPoller() {}
+    ~IoUringPoller() override;
+
+    bool init();
+
+    IoBackend backend() const override { return IoBackend::kIoUring; }
+    bool valid() const override { return ring_fd_ >= 0; }
+
+    bool add(int fd, std::uint32_t events) override;
+    bool modify(int fd, std::uint32_t events) override;
+    void remove(int fd) override;
+    int poll(int timeout_ms, std::vector<IoEvent>& active) override;
+    bool is_current(const IoEvent& ev) const override;
+
+    bool supports_recv() const override { return recv_supported_; }
+    bool add_recv(int fd) override;
+    void pause_recv(int fd) override;
+    void resume_recv(int fd) override;
+    void remove_recv(int fd) override;
+    void release_buffer(int buffer_id) override;
+
+private:
+    // 一次注册；armed 表示内核中有进行中的请求，wanted 表示期望保持 armed
+    struct Registration {
+        std::uint32_t token{0};
+        std::uint32_t events{0};
+        bool armed{false};
+        bool wanted{true};
+        bool canceling{false};
+    };
+
+    bool setup_buffer_ring();
+    io_uring_sqe* get_sqe();
+    void publish_sq();
+    void flush_submissions();
+
+    void arm_poll(int fd, Registration& reg);
+    void arm_recv(int fd, Registration& reg);
+    void cancel(Registration& reg, OpKind kind, int fd);
+
+    void handle_poll_cqe(std::uint64_t ud, int res, std::uint32_t flags,
+                         std::vector<IoEvent>& active, int& count);
+    void handle_recv_cqe(std::uint64_t ud, int res, std::uint32_t flags,
+                         std::vector<IoEvent>& active, int& count);
+    void recycle_buffer(unsigned bid);
+
+    std::uint32_t next_token() {
+        next_token_ = (next_token_ + 1) & 0xFFFFFFu;
+        if (next_token_ == 0) next_token_ = 1;
+        return next_token_;
+    }
+
+    int ring_fd_{-1};
+    void* ring_ptr_{nullptr};
+    std::size_t ring_size_{0};
+    io_uring_sqe* sqes_{nullptr};
+    std::size_t sqes_size_{0};
+
+    unsigned* sq_head_{nullptr};
+    unsigned* sq_tail_{nullptr};
+    unsigned* sq_array_{nullptr};
+    unsigned sq_mask_{0};
+    unsigned sq_entries_{0};
+    unsigned sq_local_tail_{0};
+    unsigned pending_submit_{0};
+
+    unsigned* cq_head_{nullptr};
+    unsigned* cq_tail_{nullptr};
+    unsigned cq_mask_{0};
+    io_uring_cqe* cqes_{nullptr};
+
+    bool recv_supported_{false};
+    io_uring_buf_ring* buf_ring_{nullptr};
+    std::size_t buf_ring_size_{0};
+    std::vector<char> buffers_;
+    std::uint16_t buf_tail_{0};
+
+    std::uint32_t next_token_{0};
+    std::unordered_map<int, Registration> polls_;
+    std::unordered_map<int, Registration> recvs_;
+};
+
+IoUringPoller::~IoUringPoller() {
+    if (ring_fd_ >= 0) {
+        if (buf_ring_) {
+            io_uring_buf_reg reg{};
+            reg.bgid = kRecvBufferGroup;
+            sys_io_uring_register(ring_fd_, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+        }
+        ::close(ring_fd_);
+    }
+    if (buf_ring_) {
+        ::munmap(buf_ring_, buf_ring_size_);
+    }
+    if (sqes_) {
+        ::munmap(sqes_, sqes_size_);
+    }
+    if (ring_ptr_) {
+        ::munmap(ring_ptr_, ring_size_);
+    }
+}
+
+bool IoUringPoller::init() {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP;
+    params.cq_entries = kCqEntries;
+
+    int fd = sys_io_uring_setup(kSqEntries, &params);
+    if (fd < 0) {
+        CHWELL_LOG_DEBUG("io_uring_setup failed: " << strerror(errno));
+        return false;
+    }
+    ring_fd_ = fd;
+
+    // 依赖单次 mmap 与 io_uring_enter 超时参数（5.11+）
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) ||
+        !(params.features & IORING_FEAT_EXT_ARG)) {
+        CHWELL_LOG_DEBUG("io_uring lacks SINGLE_MMAP/EXT_ARG features");
+        return false;
+    }
+
+    std::size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    std::size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    ring_size_ = sq_size > cq_size ? sq_size : cq_size;
+    ring_ptr_ = ::mmap(nullptr, ring_size_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (ring_ptr_ == MAP_FAILED) {
+        ring_ptr_ = nullptr;
+        return false;
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    char* base = static_cast<char*>(ring_ptr_);
+    sq_head_ = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+    sq_array_ = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+    sq_mask_ = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+    sq_local_tail_ = *sq_tail_;
+
+    cq_head_ = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+
+    // 多路 recv 需要 6.0+（以 LINKED_FILE 特性位判断）与 provided buffer ring；否则仅用 poll
+    if ((params.features & IORING_FEAT_LINKED_FILE) && setup_buffer_ring()) {
+        recv_supported_ = true;
+    }
+
+    CHWELL_LOG_DEBUG("io_uring poller ready, sq=" << params.sq_entries << " cq=" << params.cq_entries
+                     << " multishot_recv=" << (recv_supported_ ? "on" : "off"));
+    return true;
+}
+
+bool IoUringPoller::setup_buffer_ring() {
+    buf_ring_size_ = kRecvBufferCount * sizeof(io_uring_buf);
+    void* mem = ::mmap(nullptr, buf_ring_size_, PROT_READ | PROT_WRITE,
+                       MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (mem == MAP_FAILED) {
+        return false;
+    }
+
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<std::uint64_t>(mem);
+    reg.ring_entries = kRecvBufferCount;
+    reg.bgid = kRecvBufferGroup;
+    if (sys_io_uring_register(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        CHWELL_LOG_DEBUG("io_uring PBUF_RING registration failed: " << strerror(errno));
+        ::munmap(mem, buf_ring_size_);
+        return false;
+    }
+
+    buf_ring_ = static_cast<io_uring_buf_ring*>(mem);
+    buffers_.resize(static_cast<std::size_t>(kRecvBufferCount) * kRecvBufferSize);
+    buf_tail_ = 0;
+    for (unsigned bid = 0; bid < kRecvBufferCount; ++bid) {
+        recycle_buffer(bid);
+    }
+    return true;
+}
+
+void IoUringPoller::recycle_buffer(unsigned bid) {
+    // 只写 addr/len/bid：bufs[0].resv 与环的 tail 重叠。
+    // 按 io_uring_buf 数组直接寻址：C++ 下头文件的 __DECLARE_FLEX_ARRAY 会让 bufs 偏移 8 字节
+    io_uring_buf* buf = reinterpret_cast<io_uring_buf*>(buf_ring_) + (buf_tail_ & (kRecvBufferCount - 1));
+    buf->addr = reinterpret_cast<std::uint64_t>(buffers_.data() +
+                                                static_cast<std::size_t>(bid) * kRecvBufferSize);
+    buf->len = kRecvBufferSize;
+    buf->bid = static_cast<std::uint16_t>(bid);
+    ++buf_tail_;
+    __atomic_store_n(&buf_ring_->tail, buf_tail_, __ATOMIC_RELEASE);
+}
+
+void IoUringPoller::release_buffer(int buffer_id) {
+    if (buf_ring_ && buffer_id >= 0 && static_cast<unsigned>(buffer_id) < kRecvBufferCount) {
+        recycle_buffer(static_cast<unsigned>(buffer_id));
+    }
+}
+
+io_uring_sqe* IoUringPoller::get_sqe() {
+    unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (sq_local_tail_ - head >= sq_entries_) {
+        // 提交队列已满：先提交一批，不等待完成
+        flush_submissions();
+        head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        if (sq_local_tail_ - head >= sq_entries_) {
+            CHWELL_LOG_ERROR("io_uring submission queue full");
+            return nullptr;
+        }
+    }
+    unsigned idx = sq_local_tail_ & sq_mask_;
+    io_uring_sqe* sqe = &sqes_[idx];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sq_array_[idx] = idx;
+    ++sq_local_tail_;
+    ++pending_submit_;
+    return sqe;
+}
+
+void IoUringPoller::publish_sq() {
+    __atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+}
+
+void IoUringPoller::flush_submissions() {
+    publish_sq();
+    while (pending_submit_ > 0) {
+        int ret = sys_io_uring_enter(ring_fd_, pending_submit_, 0, 0, nullptr, 0);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            CHWELL_LOG_WARN("io_uring_enter submit failed: " << strerror(errno));
+            return;
+        }
+        pending_submit_ -= static_cast<unsigned>(ret) < pending_submit_
+                               ? static_cast<unsigned>(ret) : pending_submit_;
+        if (ret == 0) return;
+    }
+}
+
+void IoUringPoller::arm_poll(int fd, Registration& reg) {
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = reg.events & ~static_cast<std::uint32_t>(EPOLLET | EPOLLONESHOT | EPOLLEXCLUSIVE);
+    // 边沿触发：多路 poll 每次唤醒产生一个完成事件；水平触发：单次 poll，完成后重新提交
+    sqe->len = (reg.events & EPOLLET) ? IORING_POLL_ADD_MULTI : 0;
+    sqe->user_data = make_user_data(kOpPoll, reg.token, fd);
+    reg.armed = true;
+}
+
+void IoUringPoller::arm_recv(int fd, Registration& reg) {
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kRecvBufferGroup;
+    sqe->user_data = make_user_data(kOpRecv, reg.token, fd);
+    reg.armed = true;
+}
+
+void IoUringPoller::cancel(Registration& reg, OpKind kind, int fd) {
+    if (!reg.armed || reg.canceling) return;
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) return;
+    sqe->opcode = (kind == kOpPoll) ? IORING_OP_POLL_REMOVE : IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = make_user_data(kind, reg.token, fd);
+    sqe->user_data = make_user_data(kOpCancel, 0, fd);
+    reg.canceling = true;
+}
+
+bool IoUringPoller::add(int fd, std::uint32_t events) {
+    if (polls_.count(fd)) {
+        errno = EEXIST;
+        return false;
+    }
+    Registration& reg = polls_[fd];
+    reg.token = next_token();
+    reg.events = events;
+    arm_poll(fd, reg);
+    return true;
+}
+
+bool IoUringPoller::modify(int fd, std::uint32_t events) {
+    auto it = polls_.find(fd);
+    if (it == polls_.end()) {
+        errno = ENOENT;
+        return false;
+    }
+    Registration& reg = it->second;
+    if (reg.events == events) {
+        return true;
+    }
+    reg.events = events;
+    // 撤销旧请求，收到其终止完成事件后按新事件集重新提交；新请求提交时会检查当前就绪状态
+    if (reg.armed) {
+        cancel(reg, kOpPoll, fd);
+    } else {
+        arm_poll(fd, reg);
+    }
+    return true;
+}
+
+void IoUringPoller::remove(int fd) {
+    auto it = polls_.find(fd);
+    if (it == polls_.end()) return;
+    cancel(it->second, kOpPoll, fd);
+    polls_.erase(it);
+}
+
+bool IoUringPoller::add_recv(int fd) {
+    if (!recv_supported_ || recvs_.count(fd)) {
+        return false;
+    }
+    Registration& reg = recvs_[fd];
+    reg.token = next_token();
+    arm_recv(fd, reg);
+    return true;
+}
+
+void IoUringPoller::pause_recv(int fd) {
+    auto it = recvs_.find(fd);
+    if (it == recvs_.end()) return;
+    it->second.wanted = false;
+    cancel(it->second, kOpRecv, fd);
+}
+
+void IoUringPoller::resume_recv(int fd) {
+    auto it = recvs_.find(fd);
+    if (it == recvs_.end()) return;
+    Registration& reg = it->second;
+    reg.wanted = true;
+    if (!reg.armed) {
+        arm_recv(fd, reg);
+    }
+    // 仍在撤销中：终止完成事件到达后自动重新提交
+}
+
+void IoUringPoller::remove_recv(int fd) {
+    auto it = recvs_.find(fd);
+    if (it == recvs_.end()) return;
+    cancel(it->second, kOpRecv, fd);
+    recvs_.erase(it);
+}
+
+bool IoUringPoller::is_current(const IoEvent& ev) const {
+    const std::unordered_map<int, Registration>& regs =
+        (ev.kind == IoEvent::kRecv) ? recvs_ : polls_;
+    auto it = regs.find(ev.fd);
+    return it != regs.end() && it->second.token == ev.token;
+}
+
+int IoUringPoller::poll(int timeout_ms, std::vector<IoEvent>& active) {
+    publish_sq();
+
+    unsigned ready = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE) - *cq_head_;
+    __kernel_timespec ts;
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000LL;
+    io_uring_getevents_arg arg;
+    std::memset(&arg, 0, sizeof(arg));
+    arg.sigmask = 0;
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = reinterpret_cast<std::uint64_t>(&ts);
+
+    // 一次系统调用完成本轮所有 SQE 的提交与等待
+    int ret = sys_io_uring_enter(ring_fd_, pending_submit_, ready > 0 ? 0 : 1,
+                                 IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                                 &arg, sizeof(arg));
+    if (ret >= 0) {
+        unsigned submitted = static_cast<unsigned>(ret);
+        pending_submit_ -= submitted < pending_submit_ ? submitted : pending_submit_;
+    } else if (errno != ETIME && errno != EINTR && errno != EBUSY && errno != EAGAIN) {
+        return -1;
+    }
+
+    int count = 0;
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+        std::uint64_t ud = cqe.user_data;
+        int res = cqe.res;
+        std::uint32_t flags = cqe.flags;
+        ++head;
+
+        switch (user_data_kind(ud)) {
+        case kOpPoll:
+            handle_poll_cqe(ud, res, flags, active, count);
+            break;
+        case kOpRecv:
+            handle_recv_cqe(ud, res, flags, active, count);
+            break;
+        default:
+            break;  // 撤销请求自身的完成事件
+        }
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    return count;
+}
+
+void IoUringPoller::handle_poll_cqe(std::uint64_t ud, int res, std::uint32_t flags,
+                                    std::vector<IoEvent>& active, int& count) {
+    int fd = user_data_fd(ud);
+    auto it = polls_.find(fd);
+    if (it == polls_.end() || it->second.token != user_data_token(ud)) {
+        return;  // 已移除或 fd 已被复用
+    }
+    Registration& reg = it->second;
+
+    if (res != -ECANCELED) {
+        IoEvent ev;
+        ev.kind = IoEvent::kReady;
+        ev.fd = fd;
+        ev.events = res >= 0 ? static_cast<std::uint32_t>(res) : static_cast<std::uint32_t>(EPOLLERR);
+        ev.token = reg.token;
+        active.push_back(ev);
+        ++count;
+    }
+
+    if (!(flags & IORING_CQE_F_MORE)) {
+        reg.armed = false;
+        reg.canceling = false;
+        // 请求已终止（单次 poll 完成、被撤销或溢出）：按当前事件集重新提交
+        if (reg.wanted && (res >= 0 || res == -ECANCELED)) {
+            arm_poll(fd, reg);
+        }
+    }
+}
+
+void IoUringPoller::handle_recv_cqe(std::uint64_t ud, int res, std::uint32_t flags,
+                                    std::vector<IoEvent>& active, int& count) {
+    int fd = user_data_fd(ud);
+    int bid = (flags & IORING_CQE_F_BUFFER) ? static_cast<int>(flags >> IORING_CQE_BUFFER_SHIFT) : -1;
+
+    auto it = recvs_.find(fd);
+    if (it == recvs_.end() || it->second.token != user_data_token(ud)) {
+        if (bid >= 0) recycle_buffer(static_cast<unsigned>(bid));
+        return;
+    }
+    Registration& reg = it->second;
+
+    if (res != -ENOBUFS && res != -ECANCELED) {
+        IoEvent ev;
+        ev.kind = IoEvent::kRecv;
+        ev.fd = fd;
+        ev.result = res;
+        ev.token = reg.token;
+        if (res > 0 && bid >= 0) {
+            ev.data = buffers_.data() + static_cast<std::size_t>(bid) * kRecvBufferSize;
+            ev.buffer_id = bid;
+        }
+        active.push_back(ev);
+        ++count;
+    } else if (bid >= 0) {
+        recycle_buffer(static_cast<unsigned>(bid));
+    }
+
+    if (!(flags & IORING_CQE_F_MORE)) {
+        reg.armed = false;
+        reg.canceling = false;
+        // 缓冲耗尽 / 被撤销 / 内核提前结束：仍需接收时重新提交（本轮分发后缓冲已归还）
+        if (reg.wanted && (res > 0 || res == -ENOBUFS || res == -ECANCELED)) {
+            arm_recv(fd, reg);
+        }
+    }
+}
+
+} // anonymous namespace
+
+std::unique_ptr<Poller> create_io_uring_poller() {
+    std::unique_ptr<IoUringPoller> poller(new IoUringPoller());
+    if (!poller->init()) {
+        return nullptr;
+    }
+    return std::unique_ptr<Poller>(poller.release());
+}
+
+} // namespace net
+} // namespace chwell
+
+#else  // !CHWELL_USE_IO_URING
+
+namespace chwell {
+namespace net {
+
+std::unique_ptr<Poller> create_io_uring_poller() {
+    return nullptr;
+}
+
+} // namespace net
+} // namespace chwell
+
+#endif // CHWELL_USE_IO_URING
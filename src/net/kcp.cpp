@@ -0,0 +1,493 @@
+#include "chwell/net/kcp.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace chwell {
+namespace net {
+
+const std::size_t KcpSession::kHeaderSize;
+
+namespace {
+
+const std::uint8_t kCmdPush = 81;  // 数据
+const std::uint8_t kCmdAck = 82;   // 确认
+const std::uint8_t kCmdWask = 83;  // 窗口探测（询问）
+const std::uint8_t kCmdWins = 84;  // 窗口通告（回应）
+
+const std::uint32_t kAskSend = 1;  // 需要发送 WASK
+const std::uint32_t kAskTell = 2;  // 需要发送 WINS
+
+const std::uint32_t kRtoNoDelay = 30;
+const std::uint32_t kRtoMin = 100;
+const std::uint32_t kRtoDefault = 200;
+const std::uint32_t kRtoMax = 60000;
+const std::uint32_t kThreshInit = 2;
+const std::uint32_t kThreshMin = 2;
+const std::uint32_t kProbeInit = 7000;
+const std::uint32_t kProbeLimit = 120000;
+// 分片号占一个字节
+const std::uint32_t kMaxFragments = 255;
+
+// 带回绕的先后比较
+inline std::int32_t diff(std::uint32_t later, std::uint32_t earlier) {
+    return static_cast<std::int32_t>(later - earlier);
+}
+
+inline void put16(std::string& out, std::uint16_t v) {
+    char b[2] = {static_cast<char>(v & 0xff), static_cast<char>(v >> 8)};
+    out.append(b, 2);
+}
+
+inline void put32(std::string& out, std::uint32_t v) {
+    char b[4] = {static_cast<char>(v & 0xff), static_cast<char>((v >> 8) & 0xff),
+                 static_cast<char>((v >> 16) & 0xff), static_cast<char>(v >> 24)};
+    out.append(b, 4);
+}
+
+inline std::uint16_t get16(const unsigned char* p) {
+    return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+}
+
+inline std::uint32_t get32(const unsigned char* p) {
+    return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) |
+           (static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+} // anonymous namespace
+
+KcpSession::KcpSession(std::uint32_t conv, const KcpConfig& config, OutputCallback output)
+    : conv_(conv),
+      mtu_(std::max<std::uint32_t>(config.mtu, kHeaderSize + 1)),
+      mss_(mtu_ - kHeaderSize),
+      ssthresh_(kThreshInit),
+      rx_rto_(kRtoDefault),
+      rx_minrto_(config.nodelay ? kRtoNoDelay : kRtoMin),
+      snd_wnd_(std::max<std::uint32_t>(1, config.send_window)),
+      rcv_wnd_(std::max<std::uint32_t>(1, config.recv_window)),
+      rmt_wnd_(std::max<std::uint32_t>(1, config.recv_window)),
+      interval_(static_cast<std::uint32_t>(std::max(1, std::min(config.interval_ms, 5000)))),
+      ts_flush_(0),
+      dead_link_(std::max<std::uint32_t>(1, config.dead_link)),
+      fast_resend_(config.fast_resend > 0 ? static_cast<std::uint32_t>(config.fast_resend) : 0),
+      nodelay_(config.nodelay),
+      no_cwnd_(config.no_congestion_window),
+      output_cb_(std::move(output)) {
+    incr_ = mss_;
+    output_.reserve(mtu_);
+}
+
+std::uint32_t KcpSession::read_conv(std::string_view datagram) {
+    if (datagram.size() < kHeaderSize) {
+        return 0;
+    }
+    return get32(reinterpret_cast<const unsigned char*>(datagram.data()));
+}
+
+int KcpSession::send(std::string_view data) {
+    if (data.empty()) {
+        return -1;
+    }
+    std::size_t count = (data.size() + mss_ - 1) / mss_;
+    if (count > std::min(rcv_wnd_, kMaxFragments)) {
+        return -2;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::size_t len = std::min<std::size_t>(mss_, data.size());
+        Segment seg;
+        seg.data.assign(data.data(), len);
+        seg.frg = static_cast<std::uint8_t>(count - i - 1);
+        snd_queue_.push_back(std::move(seg));
+        data.remove_prefix(len);
+    }
+    return 0;
+}
+
+int KcpSession::peek_size() const {
+    if (rcv_queue_.empty()) {
+        return -1;
+    }
+    const Segment& front = rcv_queue_.front();
+    if (front.frg == 0) {
+        return static_cast<int>(front.data.size());
+    }
+    if (rcv_queue_.size() < static_cast<std::size_t>(front.frg) + 1) {
+        return -1;
+    }
+    std::size_t total = 0;
+    for (const Segment& seg : rcv_queue_) {
+        total += seg.data.size();
+        if (seg.frg == 0) break;
+    }
+    return static_cast<int>(total);
+}
+
+bool KcpSession::recv(std::string* out) {
+    const int size = peek_size();
+    if (size < 0) {
+        return false;
+    }
+    const bool recover = rcv_queue_.size() >= rcv_wnd_;
+
+    out->clear();
+    out->reserve(static_cast<std::size_t>(size));
+    while (!rcv_queue_.empty()) {
+        const std::uint8_t frg = rcv_queue_.front().frg;
+        out->append(rcv_queue_.front().data);
+        rcv_queue_.pop_front();
+        if (frg == 0) break;
+    }
+
+    // 接收缓冲中已连续的分片移入接收队列
+    while (!rcv_buf_.empty() && rcv_buf_.front().sn == rcv_nxt_ &&
+           rcv_queue_.size() < rcv_wnd_) {
+        rcv_queue_.push_back(std::move(rcv_buf_.front()));
+        rcv_buf_.pop_front();
+        ++rcv_nxt_;
+    }
+
+    // 接收窗口从满恢复：主动通告对端
+    if (recover && rcv_queue_.size() < rcv_wnd_) {
+        probe_ |= kAskTell;
+    }
+    return true;
+}
+
+void KcpSession::update_rtt(std::int32_t rtt) {
+    if (rx_srtt_ == 0) {
+        rx_srtt_ = rtt;
+        rx_rttval_ = rtt / 2;
+    } else {
+        std::int32_t delta = rtt - rx_srtt_;
+        if (delta < 0) delta = -delta;
+        rx_rttval_ = (3 * rx_rttval_ + delta) / 4;
+        rx_srtt_ = (7 * rx_srtt_ + rtt) / 8;
+        if (rx_srtt_ < 1) rx_srtt_ = 1;
+    }
+    const std::uint32_t rto = static_cast<std::uint32_t>(rx_srtt_) +
+        std::max<std::uint32_t>(interval_, 4 * static_cast<std::uint32_t>(rx_rttval_));
+    rx_rto_ = std::min(std::max(rx_minrto_, rto), kRtoMax);
+}
+
+void KcpSession::shrink_buf() {
+    snd_una_ = snd_buf_.empty() ? snd_nxt_ : snd_buf_.front().sn;
+}
+
+void KcpSession::parse_ack(std::uint32_t sn) {
+    if (diff(sn, snd_una_) < 0 || diff(sn, snd_nxt_) >= 0) {
+        return;
+    }
+    for (auto it = snd_buf_.begin(); it != snd_buf_.end(); ++it) {
+        if (it->sn == sn) {
+            snd_buf_.erase(it);
+            break;
+        }
+        if (diff(sn, it->sn) < 0) {
+            break;
+        }
+    }
+}
+
+void KcpSession::parse_una(std::uint32_t una) {
+    while (!snd_buf_.empty() && diff(una, snd_buf_.front().sn) > 0) {
+        snd_buf_.pop_front();
+    }
+}
+
+void KcpSession::parse_fastack(std::uint32_t sn) {
+    if (diff(sn, snd_una_) < 0 || diff(sn, snd_nxt_) >= 0) {
+        return;
+    }
+    // 比 sn 更早却仍未确认的分片记一次“被跨越”
+    for (Segment& seg : snd_buf_) {
+        if (diff(sn, seg.sn) < 0) break;
+        if (sn != seg.sn) ++seg.fastack;
+    }
+}
+
+void KcpSession::parse_data(Segment&& seg) {
+    const std::uint32_t sn = seg.sn;
+    if (diff(sn, rcv_nxt_ + rcv_wnd_) >= 0 || diff(sn, rcv_nxt_) < 0) {
+        return;
+    }
+    // 接收缓冲按 sn 有序，新分片通常在尾部，从后向前找插入点
+    auto it = rcv_buf_.end();
+    while (it != rcv_buf_.begin()) {
+        auto prev = it - 1;
+        if (prev->sn == sn) {
+            return;  // 重复分片
+        }
+        if (diff(sn, prev->sn) > 0) {
+            break;
+        }
+        it = prev;
+    }
+    rcv_buf_.insert(it, std::move(seg));
+
+    while (!rcv_buf_.empty() && rcv_buf_.front().sn == rcv_nxt_ &&
+           rcv_queue_.size() < rcv_wnd_) {
+        rcv_queue_.push_back(std::move(rcv_buf_.front()));
+        rcv_buf_.pop_front();
+        ++rcv_nxt_;
+    }
+}
+
+int KcpSession::input(std::string_view datagram, std::uint32_t now_ms) {
+    current_ = now_ms;
+    if (datagram.size() < kHeaderSize) {
+        return -1;
+    }
+    const std::uint32_t prev_una = snd_una_;
+    bool has_ack = false;
+    std::uint32_t max_ack = 0;
+
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(datagram.data());
+    std::size_t size = datagram.size();
+    while (size >= kHeaderSize) {
+        Segment seg;
+        seg.conv = get32(p);
+        if (seg.conv != conv_) {
+            return -1;
+        }
+        seg.cmd = p[4];
+        seg.frg = p[5];
+        seg.wnd = get16(p + 6);
+        seg.ts = get32(p + 8);
+        seg.sn = get32(p + 12);
+        seg.una = get32(p + 16);
+        const std::uint32_t len = get32(p + 20);
+        p += kHeaderSize;
+        size -= kHeaderSize;
+        if (size < len) {
+            return -2;
+        }
+        if (seg.cmd != kCmdPush && seg.cmd != kCmdAck &&
+            seg.cmd != kCmdWask && seg.cmd != kCmdWins) {
+            return -3;
+        }
+
+        rmt_wnd_ = seg.wnd;
+        parse_una(seg.una);
+        shrink_buf();
+
+        if (seg.cmd == kCmdAck) {
+            if (diff(current_, seg.ts) >= 0) {
+                update_rtt(diff(current_, seg.ts));
+            }
+            parse_ack(seg.sn);
+            shrink_buf();
+            if (!has_ack || diff(seg.sn, max_ack) > 0) {
+                has_ack = true;
+                max_ack = seg.sn;
+            }
+        } else if (seg.cmd == kCmdPush) {
+            if (diff(seg.sn, rcv_nxt_ + rcv_wnd_) < 0) {
+                acklist_.emplace_back(seg.sn, seg.ts);
+                if (diff(seg.sn, rcv_nxt_) >= 0) {
+                    seg.data.assign(reinterpret_cast<const char*>(p), len);
+                    parse_data(std::move(seg));
+                }
+            }
+        } else if (seg.cmd == kCmdWask) {
+            probe_ |= kAskTell;
+        }
+
+        p += len;
+        size -= len;
+    }
+
+    if (has_ack) {
+        parse_fastack(max_ack);
+    }
+
+    // 确认推进时按慢启动 / 拥塞避免增长拥塞窗口
+    if (diff(snd_una_, prev_una) > 0 && cwnd_ < rmt_wnd_) {
+        if (cwnd_ < ssthresh_) {
+            ++cwnd_;
+            incr_ += mss_;
+        } else {
+            if (incr_ < mss_) incr_ = mss_;
+            incr_ += (mss_ * mss_) / incr_ + (mss_ / 16);
+            if ((cwnd_ + 1) * mss_ <= incr_) {
+                cwnd_ = (incr_ + mss_ - 1) / mss_;
+            }
+        }
+        if (cwnd_ > rmt_wnd_) {
+            cwnd_ = rmt_wnd_;
+            incr_ = rmt_wnd_ * mss_;
+        }
+    }
+    return 0;
+}
+
+std::uint16_t KcpSession::window_unused() const {
+    if (rcv_queue_.size() < rcv_wnd_) {
+        return static_cast<std::uint16_t>(
+            std::min<std::size_t>(rcv_wnd_ - rcv_queue_.size(), 0xffff));
+    }
+    return 0;
+}
+
+void KcpSession::emit(const Segment& seg, std::string_view payload) {
+    if (output_.size() + kHeaderSize + payload.size() > mtu_) {
+        flush_output();
+    }
+    put32(output_, conv_);
+    output_.push_back(static_cast<char>(seg.cmd));
+    output_.push_back(static_cast<char>(seg.frg));
+    put16(output_, seg.wnd);
+    put32(output_, seg.ts);
+    put32(output_, seg.sn);
+    put32(output_, seg.una);
+    put32(output_, static_cast<std::uint32_t>(payload.size()));
+    output_.append(payload.data(), payload.size());
+}
+
+void KcpSession::flush_output() {
+    if (!output_.empty()) {
+        output_cb_(output_);
+        output_.clear();
+    }
+}
+
+void KcpSession::flush(std::uint32_t now_ms) {
+    current_ = now_ms;
+    if (!updated_) {
+        updated_ = true;
+        ts_flush_ = current_;
+    }
+
+    Segment ctrl;
+    ctrl.wnd = window_unused();
+    ctrl.una = rcv_nxt_;
+
+    // 逐分片 ACK（选择性确认），多条合并进同一数据报
+    ctrl.cmd = kCmdAck;
+    for (const auto& ack : acklist_) {
+        ctrl.sn = ack.first;
+        ctrl.ts = ack.second;
+        emit(ctrl, std::string_view());
+    }
+    acklist_.clear();
+    ctrl.sn = 0;
+    ctrl.ts = 0;
+
+    // 对端窗口为 0 时按指数退避探测
+    if (rmt_wnd_ == 0) {
+        if (probe_wait_ == 0) {
+            probe_wait_ = kProbeInit;
+            ts_probe_ = current_ + probe_wait_;
+        } else if (diff(current_, ts_probe_) >= 0) {
+            if (probe_wait_ < kProbeInit) probe_wait_ = kProbeInit;
+            probe_wait_ = std::min(probe_wait_ + probe_wait_ / 2, kProbeLimit);
+            ts_probe_ = current_ + probe_wait_;
+            probe_ |= kAskSend;
+        }
+    } else {
+        ts_probe_ = 0;
+        probe_wait_ = 0;
+    }
+    if (probe_ & kAskSend) {
+        ctrl.cmd = kCmdWask;
+        emit(ctrl, std::string_view());
+    }
+    if (probe_ & kAskTell) {
+        ctrl.cmd = kCmdWins;
+        emit(ctrl, std::string_view());
+    }
+    probe_ = 0;
+
+    // 窗口允许的新分片从发送队列移入发送缓冲
+    std::uint32_t cwnd = std::min(snd_wnd_, rmt_wnd_);
+    if (!no_cwnd_) cwnd = std::min(cwnd_, cwnd);
+    while (!snd_queue_.empty() && diff(snd_nxt_, snd_una_ + cwnd) < 0) {
+        Segment seg = std::move(snd_queue_.front());
+        snd_queue_.pop_front();
+        seg.conv = conv_;
+        seg.cmd = kCmdPush;
+        seg.ts = current_;
+        seg.sn = snd_nxt_++;
+        seg.una = rcv_nxt_;
+        seg.resendts = current_;
+        seg.rto = rx_rto_;
+        snd_buf_.push_back(std::move(seg));
+    }
+
+    const std::uint32_t resent = fast_resend_ > 0 ? fast_resend_ : 0xffffffffu;
+    const std::uint32_t rtomin = nodelay_ ? 0 : (rx_rto_ >> 3);
+    bool lost = false;
+    bool change = false;
+
+    for (Segment& seg : snd_buf_) {
+        bool need_send = false;
+        if (seg.xmit == 0) {
+            need_send = true;
+            seg.rto = rx_rto_;
+            seg.resendts = current_ + seg.rto + rtomin;
+        } else if (diff(current_, seg.resendts) >= 0) {
+            // 超时重传：nodelay 下 RTO 只增加一半
+            need_send = true;
+            seg.rto += nodelay_ ? seg.rto / 2 : std::max(seg.rto, rx_rto_);
+            seg.resendts = current_ + seg.rto;
+            lost = true;
+            ++retransmits_;
+        } else if (seg.fastack >= resent) {
+            need_send = true;
+            seg.fastack = 0;
+            seg.resendts = current_ + seg.rto;
+            change = true;
+            ++fast_retransmits_;
+        }
+        if (need_send) {
+            ++seg.xmit;
+            seg.ts = current_;
+            seg.wnd = ctrl.wnd;
+            seg.una = rcv_nxt_;
+            emit(seg, seg.data);
+            if (seg.xmit >= dead_link_) {
+                dead_ = true;
+            }
+        }
+    }
+    flush_output();
+
+    // 快速重传：拥塞窗口减半；超时：退回慢启动
+    if (change) {
+        const std::uint32_t inflight = snd_nxt_ - snd_una_;
+        ssthresh_ = std::max(inflight / 2, kThreshMin);
+        cwnd_ = ssthresh_ + resent;
+        incr_ = cwnd_ * mss_;
+    }
+    if (lost) {
+        ssthresh_ = std::max(cwnd / 2, kThreshMin);
+        cwnd_ = 1;
+        incr_ = mss_;
+    }
+    if (cwnd_ < 1) {
+        cwnd_ = 1;
+        incr_ = mss_;
+    }
+}
+
+void KcpSession::update(std::uint32_t now_ms) {
+    current_ = now_ms;
+    if (!updated_) {
+        updated_ = true;
+        ts_flush_ = current_;
+    }
+    std::int32_t slap = diff(current_, ts_flush_);
+    if (slap >= 10000 || slap < -10000) {
+        ts_flush_ = current_;
+        slap = 0;
+    }
+    if (slap >= 0) {
+        ts_flush_ += interval_;
+        if (diff(current_, ts_flush_) >= 0) {
+            ts_flush_ = current_ + interval_;
+        }
+        flush(current_);
+    }
+}
+
+} // namespace net
+} // namespace chwell
@@ -0,0 +1,357 @@
+#include "chwell/net/kcp_server.h"
+#include "chwell/core/logger.h"
+#include "chwell/metrics/event_counter.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace chwell {
+namespace net {
+
+std::uint32_t kcp_clock_ms() {
+    return static_cast<std::uint32_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// ---------------------------------------------------------------------------
+// KcpConnection
+// ---------------------------------------------------------------------------
+
+KcpConnection::KcpConnection(KcpServer* server, std::uint32_t conv, const UdpEndpoint& remote,
+                             const KcpConfig& config)
+    : server_(server),
+      conv_(conv),
+      remote_(remote),
+      nodelay_(config.nodelay),
+      idle_timeout_ms_(config.idle_timeout_ms),
+      session_(conv, config, [this](std::string_view datagram) {
+          server_->transmit(datagram, remote_);
+      }),
+      last_recv_ms_(kcp_clock_ms()) {}
+
+void KcpConnection::send(std::string_view data) {
+    if (closed_) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    int rc = session_.send(data);
+    if (rc < 0) {
+        CHWELL_LOG_WARN("KcpConnection conv=" << conv_ << " send rejected ("
+                        << data.size() << " bytes, rc=" << rc << ")");
+        return;
+    }
+    if (nodelay_) {
+        session_.flush(kcp_clock_ms());
+    }
+}
+
+void KcpConnection::close() {
+    closed_ = true;
+}
+
+std::size_t KcpConnection::pending_segments() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return session_.pending_segments();
+}
+
+std::uint64_t KcpConnection::retransmits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return session_.retransmits();
+}
+
+std::uint64_t KcpConnection::fast_retransmits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return session_.fast_retransmits();
+}
+
+bool KcpConnection::input(std::string_view datagram, std::uint32_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (session_.input(datagram, now_ms) < 0) {
+        return false;
+    }
+    last_recv_ms_ = now_ms;
+    return true;
+}
+
+void KcpConnection::deliver(const KcpMessageCallback& cb) {
+    KcpConnectionPtr self = shared_from_this();
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!session_.recv(&message_)) {
+                return;
+            }
+        }
+        // 回调期间不持锁，回调内可直接 send
+        if (cb && !closed_) {
+            cb(self, message_);
+        }
+    }
+}
+
+void KcpConnection::flush(std::uint32_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    session_.flush(now_ms);
+}
+
+void KcpConnection::update(std::uint32_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    session_.update(now_ms);
+}
+
+bool KcpConnection::expired(std::uint32_t now_ms) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (session_.dead()) {
+        return true;
+    }
+    return idle_timeout_ms_ > 0 &&
+           static_cast<std::int32_t>(now_ms - last_recv_ms_) > idle_timeout_ms_;
+}
+
+// ---------------------------------------------------------------------------
+// KcpServer
+// ---------------------------------------------------------------------------
+
+KcpServer::KcpServer(IoService& io_service, unsigned short port, const KcpConfig& config)
+    : config_(config),
+      udp_(io_service, port, [&config]() {
+          UdpServerConfig udp_config;
+          udp_config.max_datagram_size = std::max<std::size_t>(config.mtu, KcpSession::kHeaderSize);
+          return udp_config;
+      }()) {
+    config_.interval_ms = std::max(1, config_.interval_ms);
+    udp_.set_batch_callback([this](const std::vector<UdpDatagram>& batch) {
+        handle_batch(batch);
+    });
+    udp_.set_tick_callback(config_.interval_ms, [this]() {
+        handle_tick();
+    });
+}
+
+KcpServer::~KcpServer() {
+    stop();
+}
+
+void KcpServer::set_impairment(const LinkImpairment& impairment) {
+    std::lock_guard<std::mutex> lock(impairment_mutex_);
+    impairment_ = impairment;
+    impaired_ = impairment.loss_rate > 0.0 || impairment.latency_ms > 0 ||
+                impairment.jitter_ms > 0;
+    rng_.seed(impairment.seed);
+}
+
+void KcpServer::start() {
+    udp_.start_receive();
+}
+
+void KcpServer::stop() {
+    udp_.stop();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : connections_) {
+        entry.second->closed_ = true;
+    }
+    connections_.clear();
+    sessions_per_addr_.clear();
+}
+
+std::size_t KcpServer::connection_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return connections_.size();
+}
+
+KcpServer::SessionKey KcpServer::make_key(std::uint32_t conv, const UdpEndpoint& remote) {
+    SessionKey key;
+    key.conv = conv;
+    key.addr = remote.addr_.sin_addr.s_addr;
+    key.port = remote.addr_.sin_port;
+    return key;
+}
+
+bool KcpServer::admit_session_locked(const SessionKey& key) const {
+    if (config_.max_sessions > 0 && connections_.size() >= config_.max_sessions) {
+        return false;
+    }
+    if (config_.max_sessions_per_addr > 0) {
+        auto it = sessions_per_addr_.find(key.addr);
+        if (it != sessions_per_addr_.end() && it->second >= config_.max_sessions_per_addr) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void KcpServer::insert_session_locked(const SessionKey& key, const KcpConnectionPtr& conn) {
+    if (connections_.insert_or_assign(key, conn).second) {
+        ++sessions_per_addr_[key.addr];
+    }
+}
+
+void KcpServer::erase_session_locked(const SessionKey& key) {
+    if (connections_.erase(key) == 0) {
+        return;
+    }
+    auto it = sessions_per_addr_.find(key.addr);
+    if (it != sessions_per_addr_.end() && --it->second == 0) {
+        sessions_per_addr_.erase(it);
+    }
+}
+
+KcpConnectionPtr KcpServer::connect(const UdpEndpoint& remote, std::uint32_t conv) {
+    auto conn = std::make_shared<KcpConnection>(this, conv, remote, config_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    insert_session_locked(make_key(conv, remote), conn);
+    return conn;
+}
+
+void KcpServer::handle_batch(const std::vector<UdpDatagram>& batch) {
+    const std::uint32_t now = kcp_clock_ms();
+    for (const UdpDatagram& dgram : batch) {
+        const std::uint32_t conv = KcpSession::read_conv(dgram.data);
+        if (conv == 0) {
+            continue;
+        }
+        const SessionKey key = make_key(conv, dgram.remote);
+        KcpConnectionPtr conn;
+        bool accepted = false;
+        bool rejected = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = connections_.find(key);
+            if (it != connections_.end()) {
+                conn = it->second;
+            } else if (accept_sessions_) {
+                if (admit_session_locked(key)) {
+                    conn = std::make_shared<KcpConnection>(this, conv, dgram.remote, config_);
+                    insert_session_locked(key, conn);
+                    accepted = true;
+                } else {
+                    rejected = true;
+                }
+            }
+        }
+        if (rejected) {
+            CHWELL_COUNT_EVENT("chwell_net_kcp_sessions_rejected_total",
+                               "KCP datagrams for new sessions dropped over the session limits");
+            continue;
+        }
+        if (!conn || conn->closed()) {
+            continue;
+        }
+        if (!conn->input(dgram.data, now)) {
+            CHWELL_COUNT_EVENT("chwell_net_kcp_bad_datagrams_total",
+                               "Datagrams rejected by KCP session input");
+            if (accepted) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                erase_session_locked(key);
+            }
+            continue;
+        }
+        if (accepted) {
+            CHWELL_COUNT_EVENT("chwell_net_kcp_sessions_accepted_total", "KCP sessions accepted");
+            if (connection_cb_) {
+                connection_cb_(conn);
+            }
+        }
+        conn->deliver(message_cb_);
+        if (config_.nodelay && !conn->flush_pending_) {
+            conn->flush_pending_ = true;
+            touched_.push_back(conn);
+        }
+    }
+
+    // nodelay：本批的 ACK 立即发出，不等刷新节拍
+    for (const KcpConnectionPtr& conn : touched_) {
+        conn->flush_pending_ = false;
+        if (!conn->closed()) {
+            conn->flush(now);
+        }
+    }
+    touched_.clear();
+}
+
+void KcpServer::handle_tick() {
+    const std::uint32_t now = kcp_clock_ms();
+    release_delayed(now);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        snapshot_.clear();
+        snapshot_.reserve(connections_.size());
+        for (auto& entry : connections_) {
+            snapshot_.push_back(entry.second);
+        }
+    }
+
+    for (const KcpConnectionPtr& conn : snapshot_) {
+        bool reap = conn->closed();
+        if (!reap && conn->expired(now)) {
+            CHWELL_COUNT_EVENT("chwell_net_kcp_sessions_expired_total",
+                               "KCP sessions dropped for dead link or idle timeout");
+            CHWELL_LOG_INFO("KcpServer session conv=" << conn->conv()
+                            << " expired");
+            reap = true;
+        }
+        if (!reap) {
+            conn->update(now);
+            continue;
+        }
+        conn->closed_ = true;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            erase_session_locked(make_key(conn->conv(), conn->remote()));
+        }
+        if (disconnect_cb_) {
+            disconnect_cb_(conn);
+        }
+    }
+    snapshot_.clear();
+}
+
+void KcpServer::transmit(std::string_view datagram, const UdpEndpoint& remote) {
+    {
+        std::lock_guard<std::mutex> lock(impairment_mutex_);
+        if (impaired_) {
+            if (impairment_.loss_rate > 0.0 &&
+                std::uniform_real_distribution<double>(0.0, 1.0)(rng_) < impairment_.loss_rate) {
+                return;
+            }
+            int delay = impairment_.latency_ms;
+            if (impairment_.jitter_ms > 0) {
+                delay += std::uniform_int_distribution<int>(0, impairment_.jitter_ms)(rng_);
+            }
+            if (delay > 0) {
+                DelayedDatagram delayed;
+                delayed.due_ms = kcp_clock_ms() + static_cast<std::uint32_t>(delay);
+                delayed.data.assign(datagram.data(), datagram.size());
+                delayed.remote = remote;
+                delayed_.push_back(std::move(delayed));
+                return;
+            }
+        }
+    }
+    udp_.send_to(datagram, remote);
+}
+
+void KcpServer::release_delayed(std::uint32_t now_ms) {
+    std::vector<DelayedDatagram> due;
+    {
+        std::lock_guard<std::mutex> lock(impairment_mutex_);
+        if (delayed_.empty()) {
+            return;
+        }
+        // 抖动会打乱到期顺序，逐个检查（测试用，规模很小）
+        for (auto it = delayed_.begin(); it != delayed_.end();) {
+            if (static_cast<std::int32_t>(now_ms - it->due_ms) >= 0) {
+                due.push_back(std::move(*it));
+                it = delayed_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (const DelayedDatagram& dgram : due) {
+        udp_.send_to(dgram.data, dgram.remote);
+    }
+}
+
+} // namespace net
+} // namespace chwell
@@ -0,0 +1,196 @@
+#include "chwell/net/loop_timer.h"
+
+namespace chwell {
+namespace net {
+
+// ============================================
+// LoopTimer
+// ============================================
+
+LoopTimer::~LoopTimer() {
+    if (wheel_) {
+        wheel_->cancel(this);
+    }
+}
+
+void LoopTimer::unlink() {
+    prev_->next_ = next_;
+    next_->prev_ = prev_;
+    prev_ = next_ = nullptr;
+}
+
+// ============================================
+// LoopTimerWheel
+// ============================================
+
+LoopTimerWheel::LoopTimerWheel(int tick_ms)
+    : tick_ms_(tick_ms > 0 ? tick_ms : 1) {}
+
+LoopTimerWheel::~LoopTimerWheel() {
+    // 仍挂着的定时器与时间轮脱钩，之后析构不再回访本对象
+    auto detach = [](Slot& slot) {
+        while (slot.head.next_ != &slot.head) {
+            LoopTimer* t = slot.head.next_;
+            t->unlink();
+            t->wheel_ = nullptr;
+        }
+    };
+    for (Slot& slot : root_) {
+        detach(slot);
+    }
+    for (auto& level : levels_) {
+        for (Slot& slot : level) {
+            detach(slot);
+        }
+    }
+}
+
+std::uint64_t LoopTimerWheel::tick_of(std::int64_t now_ms) const {
+    return now_ms > origin_ms_ ? static_cast<std::uint64_t>((now_ms - origin_ms_) / tick_ms_) : 0;
+}
+
+void LoopTimerWheel::schedule(LoopTimer* timer, std::int64_t now_ms, std::int64_t delay_ms) {
+    if (timer->wheel_) {
+        timer->wheel_->cancel(timer);
+    }
+    if (origin_ms_ < 0) {
+        origin_ms_ = now_ms;
+        current_ = 0;
+    } else if (count_ == 0 && tick_of(now_ms) > current_) {
+        current_ = tick_of(now_ms);  // 空闲期间未推进：直接对齐，免得之后逐 tick 追赶
+    }
+    if (delay_ms < 0) {
+        delay_ms = 0;
+    }
+    // 向上取整到 tick，保证不早于 delay_ms 触发
+    std::int64_t offset = now_ms + delay_ms - origin_ms_;
+    std::uint64_t expire = offset > 0
+        ? static_cast<std::uint64_t>((offset + tick_ms_ - 1) / tick_ms_)
+        : 0;
+    timer->expire_ = expire < current_ ? current_ : expire;
+    timer->wheel_ = this;
+    link(timer);
+    ++count_;
+}
+
+void LoopTimerWheel::cancel(LoopTimer* timer) {
+    if (timer->wheel_ != this) {
+        return;
+    }
+    timer->unlink();
+    timer->wheel_ = nullptr;
+    --count_;
+}
+
+void LoopTimerWheel::link(LoopTimer* timer) {
+    std::uint64_t expire = timer->expire_;
+    std::uint64_t idx = expire - current_;
+    Slot* slot;
+    if (idx < static_cast<std::uint64_t>(kRootSize)) {
+        slot = &root_[expire & (kRootSize - 1)];
+    } else if (idx < (1ull << (kRootBits + kLevelBits))) {
+        slot = &levels_[0][(expire >> kRootBits) & (kLevelSize - 1)];
+    } else if (idx < (1ull << (kRootBits + 2 * kLevelBits))) {
+        slot = &levels_[1][(expire >> (kRootBits + kLevelBits)) & (kLevelSize - 1)];
+    } else {
+        const std::uint64_t max_idx = (1ull << (kRootBits + 3 * kLevelBits)) - 1;
+        if (idx > max_idx) {
+            expire = current_ + max_idx;
+            timer->expire_ = expire;
+        }
+        slot = &levels_[2][(expire >> (kRootBits + 2 * kLevelBits)) & (kLevelSize - 1)];
+    }
+    // 挂到槽位尾部，同一 tick 内按调度顺序触发
+    LoopTimer* head = &slot->head;
+    timer->prev_ = head->prev_;
+    timer->next_ = head;
+    head->prev_->next_ = timer;
+    head->prev_ = timer;
+}
+
+void LoopTimerWheel::cascade(int level, int index) {
+    Slot& slot = levels_[level][index];
+    LoopTimer* head = &slot.head;
+    LoopTimer* t = head->next_;
+    head->prev_ = head->next_ = head;
+    while (t != head) {
+        LoopTimer* next = t->next_;
+        link(t);
+        t = next;
+    }
+}
+
+void LoopTimerWheel::run_tick() {
+    const int index = static_cast<int>(current_ & (kRootSize - 1));
+    if (index == 0) {
+        // 第 0 层转完一圈：依次把上层对应槽位的定时器下放
+        for (int level = 0; level < kLevels; ++level) {
+            int up = static_cast<int>((current_ >> (kRootBits + level * kLevelBits)) & (kLevelSize - 1));
+            cascade(level, up);
+            if (up != 0) {
+                break;
+            }
+        }
+    }
+
+    // 先把到期槽位整体摘到本地链表，回调中新调度的定时器不会在本 tick 重复触发
+    Slot expired;
+    Slot& slot = root_[index];
+    if (slot.head.next_ != &slot.head) {
+        expired.head.next_ = slot.head.next_;
+        expired.head.prev_ = slot.head.prev_;
+        expired.head.next_->prev_ = &expired.head;
+        expired.head.prev_->next_ = &expired.head;
+        slot.head.prev_ = slot.head.next_ = &slot.head;
+    }
+    ++current_;
+
+    while (expired.head.next_ != &expired.head) {
+        LoopTimer* t = expired.head.next_;
+        t->unlink();
+        t->wheel_ = nullptr;
+        --count_;
+        // 回调可能释放持有定时器的对象，先复制一份
+        LoopTimer::Callback cb = t->cb_;
+        if (cb) {
+            cb();
+        }
+    }
+}
+
+void LoopTimerWheel::advance(std::int64_t now_ms) {
+    if (origin_ms_ < 0) {
+        return;
+    }
+    const std::uint64_t target = tick_of(now_ms);
+    while (current_ <= target) {
+        if (count_ == 0) {
+            // 没有定时器时直接跳到目标 tick
+            current_ = target + 1;
+            break;
+        }
+        run_tick();
+    }
+}
+
+int LoopTimerWheel::next_timeout_ms(std::int64_t now_ms) const {
+    if (count_ == 0) {
+        return -1;
+    }
+    // 在第 0 层找最近的非空槽位；遇到一圈边界（含当前 tick）时需要唤醒做级联
+    std::uint64_t t = current_;
+    for (int i = 0; i < kRootSize; ++i, ++t) {
+        if ((t & (kRootSize - 1)) == 0) {
+            break;
+        }
+        const Slot& slot = root_[t & (kRootSize - 1)];
+        if (slot.head.next_ != &slot.head) {
+            break;
+        }
+    }
+    std::int64_t due = origin_ms_ + static_cast<std::int64_t>(t) * tick_ms_;
+    return due > now_ms ? static_cast<int>(due - now_ms) : 0;
+}
+
+} // namespace net
+} // namespace chwell
@@ -0,0 +1,288 @@
+#include "chwell/net/mux.h"
+#include "chwell/core/endian.h"
+#include "chwell/core/logger.h"
+
+#include <cstring>
+
+namespace chwell {
+namespace net {
+
+namespace mux {
+
+void encode_header(char* out, std::uint32_t session, std::uint8_t type, std::uint32_t len) {
+    std::uint32_t s = core::host_to_net32(session);
+    std::uint32_t l = core::host_to_net32(len);
+    std::memcpy(out, &s, 4);
+    out[4] = static_cast<char>(type);
+    std::memcpy(out + 5, &l, 4);
+}
+
+std::size_t parse_frame(std::string_view data, Frame& frame) {
+    if (data.size() < kHeaderSize) {
+        return 0;
+    }
+    std::uint32_t s = 0;
+    std::uint32_t l = 0;
+    std::memcpy(&s, data.data(), 4);
+    std::memcpy(&l, data.data() + 5, 4);
+    std::uint8_t type = static_cast<std::uint8_t>(data[4]);
+    std::uint32_t len = core::net_to_host32(l);
+    if ((type != kData && type != kClose) || len > kMaxPayload) {
+        return kInvalidFrame;
+    }
+    if (data.size() - kHeaderSize < len) {
+        return 0;
+    }
+    frame.session = core::net_to_host32(s);
+    frame.type = type;
+    frame.payload = data.substr(kHeaderSize, len);
+    return kHeaderSize + len;
+}
+
+void send_frame(const TcpConnectionPtr& link, std::uint32_t session, std::uint8_t type,
+                std::string_view payload) {
+    char head[kHeaderSize];
+    encode_header(head, session, type, static_cast<std::uint32_t>(payload.size()));
+    link->send(std::string_view(head, kHeaderSize), payload);
+}
+
+} // namespace mux
+
+// ============================================
+// MuxDecoder
+// ============================================
+
+std::size_t MuxDecoder::pending_bytes() const {
+    std::size_t have = buffer_.readable_bytes();
+    if (have < mux::kHeaderSize) {
+        return mux::kHeaderSize - have;
+    }
+    std::uint32_t l = 0;
+    std::memcpy(&l, buffer_.peek() + 5, 4);
+    // 长度非法时只补齐帧头，由 parse_frame 报告
+    std::uint32_t len = core::net_to_host32(l);
+    if (len > mux::kMaxPayload) {
+        return 1;
+    }
+    return mux::kHeaderSize + len - have;
+}
+
+// ============================================
+// MuxBatcher
+// ============================================
+
+MuxBatcher::MuxBatcher(const TcpConnectionPtr& link, std::size_t max_batch_bytes)
+    : link_(link), loop_(link->loop()), max_batch_bytes_(max_batch_bytes) {
+}
+
+void MuxBatcher::append(std::uint32_t session, std::uint8_t type, std::string_view payload) {
+    TcpConnectionPtr link = link_.lock();
+    if (!link) {
+        return;
+    }
+    frames_.fetch_add(1, std::memory_order_relaxed);
+    // 不合并，或阻塞模式下没有 loop 可以投递写出任务
+    if (max_batch_bytes_ == 0 || !loop_) {
+        writes_.fetch_add(1, std::memory_order_relaxed);
+        mux::send_frame(link, session, type, payload);
+        return;
+    }
+
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const std::size_t offset = batch_.size();
+        batch_.resize(offset + mux::kHeaderSize + payload.size());
+        mux::encode_header(&batch_[offset], session, type, static_cast<std::uint32_t>(payload.size()));
+        if (!payload.empty()) {
+            std::memcpy(&batch_[offset + mux::kHeaderSize], payload.data(), payload.size());
+        }
+        if (batch_.size() >= max_batch_bytes_) {
+            flush_locked(link);
+        } else if (!scheduled_) {
+            scheduled_ = true;
+            schedule = true;
+        }
+    }
+    if (schedule) {
+        std::weak_ptr<MuxBatcher> weak_self = shared_from_this();
+        loop_->queue_in_loop([weak_self]() {
+            if (MuxBatcherPtr self = weak_self.lock()) {
+                self->flush();
+            }
+        });
+    }
+}
+
+void MuxBatcher::flush() {
+    TcpConnectionPtr link = link_.lock();
+    std::lock_guard<std::mutex> lock(mutex_);
+    scheduled_ = false;
+    if (link) {
+        flush_locked(link);
+    } else {
+        batch_.clear();
+    }
+}
+
+void MuxBatcher::flush_locked(const TcpConnectionPtr& link) {
+    if (batch_.empty()) {
+        return;
+    }
+    writes_.fetch_add(1, std::memory_order_relaxed);
+    link->send(std::string_view(batch_));
+    // 超大批次不长期占用内存
+    if (batch_.capacity() > max_batch_bytes_ * 2) {
+        std::string().swap(batch_);
+    } else {
+        batch_.clear();
+    }
+}
+
+// ============================================
+// MuxSession
+// ============================================
+
+void MuxSession::send(std::string_view data) {
+    if (closed()) {
+        return;
+    }
+    if (MuxBatcherPtr batcher = batcher_.lock()) {
+        batcher->append(id_, mux::kData, data);
+    }
+}
+
+void MuxSession::close() {
+    if (closed_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    if (MuxBatcherPtr batcher = batcher_.lock()) {
+        batcher->append(id_, mux::kClose);
+    }
+}
+
+// ============================================
+// MuxServer
+// ============================================
+
+MuxServer::MuxServer(EventLoopThreadPool& loops, unsigned short port)
+    : server_(loops, port) {
+    server_.set_connection_callback([this](const TcpConnectionPtr& conn) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (batch_bytes_ > 0) {
+            set_tcp_no_delay(conn->native_handle());  // 回程已由 MuxBatcher 合并
+        }
+        std::shared_ptr<Link> link = std::make_shared<Link>();
+        link->batcher = std::make_shared<MuxBatcher>(conn, batch_bytes_);
+        links_[conn.get()] = link;
+        CHWELL_LOG_INFO("MuxServer: gateway link connected, links: " << links_.size());
+    });
+    server_.set_disconnect_callback([this](const TcpConnectionPtr& conn) {
+        on_link_close(conn);
+    });
+    server_.set_message_callback([this](const TcpConnectionPtr& conn, std::string_view data) {
+        on_link_message(conn, data);
+    });
+}
+
+void MuxServer::start() {
+    server_.start_accept();
+}
+
+void MuxServer::stop() {
+    server_.stop();
+}
+
+std::size_t MuxServer::link_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return links_.size();
+}
+
+std::size_t MuxServer::session_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t n = 0;
+    for (const auto& kv : links_) {
+        n += kv.second->sessions.size();
+    }
+    return n;
+}
+
+void MuxServer::on_link_message(const TcpConnectionPtr& conn, std::string_view data) {
+    std::shared_ptr<Link> link;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = links_.find(conn.get());
+        if (it == links_.end()) {
+            return;
+        }
+        link = it->second;
+    }
+    bool ok = link->decoder.feed(data, [&](const mux::Frame& frame) {
+        handle_frame(*link, frame);
+    });
+    if (!ok) {
+        CHWELL_LOG_ERROR("MuxServer: invalid frame from gateway link, closing");
+        conn->close();
+    }
+}
+
+void MuxServer::handle_frame(Link& link, const mux::Frame& frame) {
+    MuxSessionPtr session;
+    if (frame.type == mux::kData) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            MuxSessionPtr& slot = link.sessions[frame.session];
+            if (!slot) {
+                slot = std::make_shared<MuxSession>(frame.session, link.batcher, frame_format_);
+            }
+            session = slot;
+        }
+        // 本端已 close() 的会话在确认到达前仍可能收到数据，丢弃
+        if (!session->closed() && message_cb_) {
+            message_cb_(session, frame.payload);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = link.sessions.find(frame.session);
+        if (it == link.sessions.end()) {
+            return;
+        }
+        session = it->second;
+        link.sessions.erase(it);
+    }
+    session->closed_.store(true, std::memory_order_release);
+    if (close_cb_) {
+        close_cb_(session);
+    }
+}
+
+void MuxServer::on_link_close(const TcpConnectionPtr& conn) {
+    std::shared_ptr<Link> link;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = links_.find(conn.get());
+        if (it == links_.end()) {
+            return;
+        }
+        link = it->second;
+        links_.erase(it);
+    }
+    std::unordered_map<std::uint32_t, MuxSessionPtr> sessions;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sessions.swap(link->sessions);
+    }
+    CHWELL_LOG_INFO("MuxServer: gateway link closed, dropping " << sessions.size() << " sessions");
+    for (auto& kv : sessions) {
+        kv.second->closed_.store(true, std::memory_order_release);
+        if (close_cb_) {
+            close_cb_(kv.second);
+        }
+    }
+}
+
+} // namespace net
+} // namespace chwell
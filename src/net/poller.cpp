@@ -0,0 +1,141 @@
+#include "chwell/net/poller.h"
+#include "chwell/core/logger.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+namespace chwell {
+namespace net {
+
+namespace {
+
+const int kInitEventListSize = 64;
+
+IoBackend initial_default_backend() {
+    return parse_io_backend(std::getenv("CHWELL_IO_BACKEND"), IoBackend::kEpoll);
+}
+
+std::atomic<IoBackend>& default_backend_slot() {
+    static std::atomic<IoBackend> backend(initial_default_backend());
+    return backend;
+}
+
+// epoll 后端：就绪事件直接转换为 IoEvent
+class EpollPoller : public Poller {
+public:
+    EpollPoller() : events_(kInitEventListSize) {
+        epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) {
+            CHWELL_LOG_ERROR("EventLoop: epoll_create1 failed: " + std::string(strerror(errno)));
+        }
+    }
+
+    ~EpollPoller() override {
+        if (epoll_fd_ >= 0) {
+            ::close(epoll_fd_);
+        }
+    }
+
+    IoBackend backend() const override { return IoBackend::kEpoll; }
+    bool valid() const override { return epoll_fd_ >= 0; }
+
+    bool add(int fd, std::uint32_t events) override {
+        return ctl(EPOLL_CTL_ADD, fd, events);
+    }
+
+    bool modify(int fd, std::uint32_t events) override {
+        return ctl(EPOLL_CTL_MOD, fd, events);
+    }
+
+    void remove(int fd) override {
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+
+    int poll(int timeout_ms, std::vector<IoEvent>& active) override {
+        int n = ::epoll_wait(epoll_fd_, events_.data(),
+                             static_cast<int>(events_.size()), timeout_ms);
+        if (n < 0) {
+            return -1;
+        }
+        for (int i = 0; i < n; ++i) {
+            IoEvent ev;
+            ev.kind = IoEvent::kReady;
+            ev.fd = events_[i].data.fd;
+            ev.events = events_[i].events;
+            active.push_back(ev);
+        }
+        // 本轮就绪数占满数组时扩容，减少下一轮的 epoll_wait 次数
+        if (static_cast<std::size_t>(n) == events_.size()) {
+            events_.resize(events_.size() * 2);
+        }
+        return n;
+    }
+
+private:
+    bool ctl(int op, int fd, std::uint32_t events) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = fd;
+        return ::epoll_ctl(epoll_fd_, op, fd, &ev) == 0;
+    }
+
+    int epoll_fd_{-1};
+    std::vector<epoll_event> events_;
+};
+
+} // anonymous namespace
+
+const char* io_backend_name(IoBackend backend) {
+    return backend == IoBackend::kIoUring ? "io_uring" : "epoll";
+}
+
+IoBackend parse_io_backend(const char* name, IoBackend fallback) {
+    if (!name || !*name) {
+        return fallback;
+    }
+    std::string value(name);
+    if (value == "io_uring" || value == "uring") {
+        return IoBackend::kIoUring;
+    }
+    if (value == "epoll") {
+        return IoBackend::kEpoll;
+    }
+    CHWELL_LOG_WARN("Unknown io backend '" << value << "', using " << io_backend_name(fallback));
+    return fallback;
+}
+
+IoBackend default_io_backend() {
+    return default_backend_slot().load();
+}
+
+void set_default_io_backend(IoBackend backend) {
+    default_backend_slot().store(backend);
+}
+
+bool io_uring_available() {
+    static const bool available = create_io_uring_poller() != nullptr;
+    return available;
+}
+
+std::unique_ptr<Poller> create_epoll_poller() {
+    return std::unique_ptr<Poller>(new EpollPoller());
+}
+
+std::unique_ptr<Poller> Poller::create(IoBackend preferred) {
+    if (preferred == IoBackend::kIoUring) {
+        std::unique_ptr<Poller> poller = create_io_uring_poller();
+        if (poller) {
+            return poller;
+        }
+        CHWELL_LOG_WARN("io_uring backend unavailable, falling back to epoll");
+    }
+    return create_epoll_poller();
+}
+
+} // namespace net
+} // namespace chwell
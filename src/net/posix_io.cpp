@@ -5,12 +5,18 @@ namespace chwell {
 namespace net {
 
 // TcpAcceptor
-TcpAcceptor::TcpAcceptor(unsigned short port) {
-    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+TcpAcceptor::TcpAcceptor(unsigned short port, int backlog, bool reuse_port) {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (listen_fd_ < 0) return;
 
     int opt = 1;
     setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (reuse_port &&
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return;
+    }
 
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
@@ -23,7 +29,7 @@ TcpAcceptor::TcpAcceptor(unsigned short port) {
         return;
     }
 
-    if (listen(listen_fd_, 128) < 0) {
+    if (listen(listen_fd_, backlog > 0 ? backlog : SOMAXCONN) < 0) {
         close(listen_fd_);
         listen_fd_ = -1;
     }
@@ -36,11 +42,11 @@ TcpAcceptor::~TcpAcceptor() {
     }
 }
 
-TcpSocket TcpAcceptor::accept(ErrorCode& ec) {
+TcpSocket TcpAcceptor::accept(ErrorCode& ec, int flags) {
     ec = ErrorCode(0);
     sockaddr_in client_addr{};
     socklen_t len = sizeof(client_addr);
-    int fd = ::accept(listen_fd_, reinterpret_cast<sockaddr*>(&client_addr), &len);
+    int fd = ::accept4(listen_fd_, reinterpret_cast<sockaddr*>(&client_addr), &len, flags);
     if (fd < 0) {
         ec = ErrorCode(errno);
         return TcpSocket();
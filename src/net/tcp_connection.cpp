@@ -1,17 +1,102 @@
 #include "chwell/net/tcp_connection.h"
+#include "chwell/net/event_loop.h"
 #include "chwell/core/logger.h"
+#include "chwell/metrics/event_counter.h"
+#include <algorithm>
 #include <cerrno>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <unordered_map>
 
 namespace chwell {
 namespace net {
 
+namespace {
+
+// 阻塞模式下 socket 被设为非阻塞时，等待可写的上限
+const int kSendWaitMs = 5000;
+// 单次 writev 合并的最大帧数
+const int kMaxWriteIov = 64;
+// 读缓冲被突发流量撑大后，超过该容量时在读空时收缩回初始大小
+const std::size_t kMaxIdleReadBuffer = 64 * 1024;
+// 单次 sendfile 的上限，避免一个大文件长时间占住发送锁
+const std::size_t kMaxSendfileChunk = 1024 * 1024;
+// TLS / 阻塞连接发送文件时每次读出的块大小
+const std::size_t kFileCopyChunk = 64 * 1024;
+// 直通每次搬进管道的上限（默认管道容量），管道写出后才搬下一块
+const std::size_t kSpliceChunk = 64 * 1024;
+
+// 未设置任何回调的连接共用的空回调集合
+const ConnectionCallbacksPtr& empty_callbacks() {
+    static const ConnectionCallbacksPtr empty = std::make_shared<ConnectionCallbacks>();
+    return empty;
+}
+
+} // anonymous namespace
+
 TcpConnection::TcpConnection(TcpSocket socket)
-    : socket_(std::move(socket)), read_buffer_(4096) {
+    : socket_(std::move(socket)),
+      callbacks_(empty_callbacks()) {
     CHWELL_LOG_DEBUG("TcpConnection created");
 }
 
+TcpConnection::TcpConnection(EventLoop* loop, TcpSocket socket)
+    : loop_(loop), socket_(std::move(socket)),
+      callbacks_(empty_callbacks()) {
+    if (socket_.is_open()) {
+        int flags = fcntl(socket_.native_handle(), F_GETFL, 0);
+        fcntl(socket_.native_handle(), F_SETFL, flags | O_NONBLOCK);
+    }
+    CHWELL_LOG_DEBUG("TcpConnection created (reactor)");
+}
+
+// 直通搬运状态：管道两端与本次搬运的进度，只在 loop 线程访问
+struct TcpConnection::SpliceState {
+    int pipe_fds[2] = {-1, -1};
+    bool active = false;
+    bool failed = false;           // target 中途断开：剩余 body 照常从 socket 取出后丢弃
+    TcpConnectionPtr target;
+    std::size_t remaining = 0;     // 仍在本 socket 中待搬运的字节
+    std::size_t in_pipe = 0;       // 已进入管道、尚未写给 target 的字节
+    std::size_t spliced = 0;       // 经 splice 直接写给 target 的字节
+    std::size_t copied = 0;        // 因 target 有排队输出而经用户态入队的字节
+    std::function<void(bool)> done;
+
+    ~SpliceState() {
+        for (int fd : pipe_fds) {
+            if (fd >= 0) ::close(fd);
+        }
+    }
+};
+
+TcpConnection::~TcpConnection() = default;
+
+ConnectionCallbacks& TcpConnection::own_callbacks() {
+    if (callbacks_.use_count() != 1) {
+        callbacks_ = std::make_shared<ConnectionCallbacks>(*callbacks_);
+    }
+    return *callbacks_;
+}
+
+void TcpConnection::set_callbacks(const ConnectionCallbacksPtr& cbs) {
+    callbacks_ = cbs ? cbs : empty_callbacks();
+}
+
+void TcpConnection::set_low_memory(bool on) {
+    low_memory_ = on && loop_ != nullptr;
+    if (low_memory_) {
+        input_buffer_.shrink(0);
+    }
+}
+
 void TcpConnection::start() {
+    if (loop_) {
+        TcpConnectionPtr self = shared_from_this();
+        loop_->run_in_loop([self]() { self->connect_established(); });
+        return;
+    }
     CHWELL_LOG_DEBUG("TcpConnection read loop starting");
+    start_tls();
     run_read_loop();
 }
 
@@ -28,32 +113,633 @@ void TcpConnection::run_read_loop() {
                 return;
             }
             conn.closed_ = true;
-            if (conn.close_cb_) {
-                conn.close_cb_(conn.shared_from_this());
+            if (conn.callbacks_->close) {
+                conn.callbacks_->close(conn.shared_from_this());
             }
         }
     } guard(*this);
 
     while (!closed_ && socket_.is_open()) {
-        ssize_t n = socket_.read(read_buffer_.data(), read_buffer_.size());
+        int saved_errno = 0;
+        ssize_t n = input_buffer_.read_fd(socket_.native_handle(), &saved_errno);
         if (n <= 0) {
-            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
-                CHWELL_LOG_WARN("Connection read error: " + std::string(strerror(errno)));
+            if (n < 0 && saved_errno != EAGAIN && saved_errno != EWOULDBLOCK) {
+                CHWELL_LOG_WARN("Connection read error: " + std::string(strerror(saved_errno)));
             }
             break;
         }
 
-        if (message_cb_) {
-            message_cb_(shared_from_this(),
-                        std::string_view(read_buffer_.data(),
-                                         static_cast<std::size_t>(n)));
-        }
+        deliver_input(input_buffer_);
     }
 
     guard.active = false;
     closed_ = true;
-    if (close_cb_) {
-        close_cb_(shared_from_this());
+    if (callbacks_->close) {
+        callbacks_->close(shared_from_this());
+    }
+}
+
+void TcpConnection::connect_established() {
+    if (state_ != State::kIdle) {
+        return;
+    }
+    if (closed_ || !socket_.is_open()) {
+        handle_close();
+        return;
+    }
+
+    std::weak_ptr<TcpConnection> weak = shared_from_this();
+    recv_mode_ = loop_->supports_recv();
+    std::uint32_t events = 0;
+    {
+        // 注册前 send() / broadcast 已缓冲的数据（如连接回调中的欢迎消息）需要关注可写
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        if (!output_queue_.empty()) {
+            write_interest_ = true;
+        }
+        events = interest_events();
+    }
+    loop_->add_fd(socket_.native_handle(), events,
+                  [weak](std::uint32_t revents) {
+                      if (TcpConnectionPtr self = weak.lock()) {
+                          self->handle_event(revents);
+                      }
+                  });
+    if (recv_mode_) {
+        // 完成式接收：读由 recv 完成事件驱动，fd 就绪通知只用于可写与错误
+        recv_mode_ = loop_->add_recv(socket_.native_handle(),
+                                     [weak](const char* data, ssize_t n) {
+                                         if (TcpConnectionPtr self = weak.lock()) {
+                                             self->handle_recv(data, n);
+                                         }
+                                     });
+        if (!recv_mode_) {
+            std::lock_guard<std::mutex> lock(send_mutex_);
+            loop_->modify_fd(socket_.native_handle(), interest_events());
+        } else if (!reading_) {
+            loop_->pause_recv(socket_.native_handle());
+        }
+    }
+    state_ = State::kConnected;
+    CHWELL_LOG_DEBUG("TcpConnection registered to event loop, fd=" << socket_.native_handle());
+    if (idle_.enabled()) {
+        const std::int64_t now = loop_->now_ms();
+        last_read_ms_ = now;
+        last_write_ms_.store(now, std::memory_order_relaxed);
+        idle_timer_.set_callback([weak]() {
+            if (TcpConnectionPtr self = weak.lock()) {
+                self->check_idle();
+            }
+        });
+        int first = 0;
+        for (int t : {idle_.read_idle_ms, idle_.write_idle_ms, idle_.idle_ms}) {
+            if (t > 0 && (first == 0 || t < first)) first = t;
+        }
+        loop_->timers().schedule(&idle_timer_, now, first);
+    }
+    start_tls();
+}
+
+void TcpConnection::check_idle() {
+    if (state_ != State::kConnected) {
+        return;
+    }
+    const std::int64_t now = loop_->now_ms();
+    const std::int64_t last_write = last_write_ms_.load(std::memory_order_relaxed);
+    std::int64_t next_deadline = 0;
+    const char* expired = nullptr;
+    auto check = [&](int timeout_ms, std::int64_t last, const char* what) {
+        if (timeout_ms <= 0 || expired) {
+            return;
+        }
+        const std::int64_t deadline = last + timeout_ms;
+        if (now >= deadline) {
+            expired = what;
+        } else if (next_deadline == 0 || deadline < next_deadline) {
+            next_deadline = deadline;
+        }
+    };
+    check(idle_.read_idle_ms, last_read_ms_, "read");
+    check(idle_.write_idle_ms, last_write, "write");
+    check(idle_.idle_ms, std::max(last_read_ms_, last_write), "read/write");
+
+    if (expired) {
+        CHWELL_COUNT_EVENT("chwell_net_idle_timeouts_total", "Connections closed for exceeding an idle timeout");
+        CHWELL_LOG_INFO("Closing idle connection fd=" << socket_.native_handle()
+                        << ", no " << expired << " activity");
+        close();
+        return;
+    }
+    // 期间有活动：按剩余时间重新挂上，收发路径本身从不触碰时间轮
+    loop_->timers().schedule(&idle_timer_, now, next_deadline - now);
+}
+
+void TcpConnection::touch_write() {
+    if (loop_) {
+        last_write_ms_.store(loop_->now_ms(), std::memory_order_relaxed);
+    }
+}
+
+void TcpConnection::handle_event(std::uint32_t events) {
+    // 完成式接收模式下对端关闭由 recv 完成事件报告（先交付剩余数据）
+    if ((events & EPOLLHUP) && !(events & EPOLLIN) && !recv_mode_) {
+        handle_close();
+        return;
+    }
+    if (events & EPOLLERR) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(socket_.native_handle(), SOL_SOCKET, SO_ERROR, &err, &len);
+        CHWELL_LOG_WARN("Connection socket error: " + std::string(strerror(err)));
+        handle_close();
+        return;
+    }
+    if (events & (EPOLLIN | EPOLLPRI | EPOLLRDHUP)) {
+        handle_read();
+    }
+    if ((events & EPOLLOUT) && state_ == State::kConnected) {
+        handle_write();
+    }
+}
+
+std::uint32_t TcpConnection::interest_events() const {
+    std::uint32_t events = EPOLLET;
+    if (reading_ && !recv_mode_) {
+        events |= EPOLLIN | EPOLLRDHUP;
+    }
+    if (write_interest_) {
+        events |= EPOLLOUT;
+    }
+    return events;
+}
+
+void TcpConnection::update_interest() {
+    if (state_ != State::kConnected) {
+        return;
+    }
+    if (recv_mode_) {
+        if (reading_) {
+            loop_->resume_recv(socket_.native_handle());
+        } else {
+            loop_->pause_recv(socket_.native_handle());
+        }
+        return;
+    }
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    loop_->modify_fd(socket_.native_handle(), interest_events());
+}
+
+void TcpConnection::pause_reading() {
+    if (!loop_ || !reading_.exchange(false)) {
+        return;
+    }
+    CHWELL_COUNT_EVENT("chwell_net_read_paused_total",
+                       "Connections paused reading due to downstream backpressure");
+    TcpConnectionPtr self = shared_from_this();
+    loop_->run_in_loop([self]() { self->update_interest(); });
+}
+
+void TcpConnection::resume_reading() {
+    if (!loop_ || reading_.exchange(true)) {
+        return;
+    }
+    TcpConnectionPtr self = shared_from_this();
+    loop_->run_in_loop([self]() { self->update_interest(); });
+}
+
+void TcpConnection::handle_read() {
+    // 低内存模式：本次读事件期间从 loop 的缓冲池借用读缓冲，返回前归还
+    struct BorrowGuard {
+        EventLoop* loop;
+        Buffer* buffer;
+        ~BorrowGuard() {
+            if (buffer) {
+                loop->release_read_buffer(buffer);
+            }
+        }
+    } borrowed{loop_, low_memory_ ? loop_->acquire_read_buffer() : nullptr};
+    Buffer& input = borrowed.buffer ? *borrowed.buffer : input_buffer_;
+
+    // 直通搬运中：常规读取让位，直到本次搬运结束
+    if (splicing() && !continue_splice()) {
+        return;
+    }
+
+    // 边沿触发：必须读到 EAGAIN 为止，否则剩余数据不会再次通知；
+    // 暂停读取时提前退出，resume_reading() 重新注册 EPOLLIN 后内核会再次通知
+    while (state_ == State::kConnected && reading_) {
+        int saved_errno = 0;
+        ssize_t n = input.read_fd(socket_.native_handle(), &saved_errno, max_read_bytes_);
+        if (n > 0) {
+            last_read_ms_ = loop_->now_ms();
+            deliver_input(input);
+            // 消息回调中发起了直通：后续 body 不再读入用户态
+            if (splicing() && !continue_splice()) {
+                return;
+            }
+            continue;
+        }
+        if (n == 0) {
+            handle_close();
+            return;
+        }
+        if (saved_errno == EINTR) {
+            continue;
+        }
+        if (saved_errno == EAGAIN || saved_errno == EWOULDBLOCK) {
+            return;
+        }
+        CHWELL_LOG_WARN("Connection read error: " + std::string(strerror(saved_errno)));
+        handle_close();
+        return;
+    }
+}
+
+void TcpConnection::deliver_input(Buffer& input) {
+    // 数据只从内核拷贝一次到读缓冲，回调直接看到缓冲内的视图；
+    // 回调返回后视图失效，需要跨回调保留残帧的解析器自行缓存未消费部分
+    dispatch_input(input.view());
+    input.retrieve_all();
+    if (input.capacity() > kMaxIdleReadBuffer) {
+        input.shrink(Buffer::kInitialSize);
+    }
+}
+
+void TcpConnection::handle_recv(const char* data, ssize_t n) {
+    if (state_ != State::kConnected) {
+        return;
+    }
+    if (n > 0) {
+        last_read_ms_ = loop_->now_ms();
+        dispatch_input(std::string_view(data, static_cast<std::size_t>(n)));
+        return;
+    }
+    if (n < 0) {
+        CHWELL_LOG_WARN("Connection read error: " + std::string(strerror(static_cast<int>(-n))));
+    }
+    handle_close();
+}
+
+void TcpConnection::dispatch_input(std::string_view data) {
+    if (!tls_) {
+        if (callbacks_->message) {
+            callbacks_->message(shared_from_this(), data);
+        }
+        return;
+    }
+    if (closed_) {
+        return;
+    }
+    if (!tls_input(data)) {
+        CHWELL_LOG_WARN("TLS error, closing connection fd=" << socket_.native_handle());
+        close();
+    }
+}
+
+void TcpConnection::enable_tls(const TlsContextPtr& ctx, const std::string& peer) {
+    tls_.reset(new TlsSession(ctx, peer));
+}
+
+bool TcpConnection::tls_established() const {
+    std::lock_guard<std::mutex> lock(tls_mutex_);
+    return tls_ && tls_->established();
+}
+
+bool TcpConnection::tls_resumed() const {
+    std::lock_guard<std::mutex> lock(tls_mutex_);
+    return tls_ && tls_->resumed();
+}
+
+void TcpConnection::start_tls() {
+    if (!tls_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(tls_mutex_);
+    tls_out_.clear();
+    if (!tls_->start(&tls_out_)) {
+        CHWELL_LOG_WARN("TLS handshake could not start, fd=" << socket_.native_handle());
+    }
+    send_raw_locked(tls_out_);
+    if (cork_ && !tls_out_.empty()) {
+        flush();
+    }
+}
+
+bool TcpConnection::tls_input(std::string_view data) {
+    bool ok;
+    tls_plain_.clear();
+    {
+        std::lock_guard<std::mutex> lock(tls_mutex_);
+        tls_out_.clear();
+        ok = tls_->feed(data, &tls_plain_, &tls_out_);
+        send_raw_locked(tls_out_);
+        if (cork_ && !tls_out_.empty()) {
+            flush();  // 握手 / 票据记录不等 tick 边界
+        }
+    }
+    // 回调内可直接 send（不持有 tls_mutex_）
+    if (!tls_plain_.empty() && callbacks_->message) {
+        callbacks_->message(shared_from_this(), tls_plain_);
+    }
+    if (tls_plain_.capacity() > kMaxIdleReadBuffer) {
+        std::string().swap(tls_plain_);
+    }
+    return ok;
+}
+
+void TcpConnection::send_tls(std::string_view head, std::string_view data) {
+    std::lock_guard<std::mutex> lock(tls_mutex_);
+    tls_out_.clear();
+    bool ok;
+    if (head.empty()) {
+        ok = tls_->encrypt(data, &tls_out_);
+    } else {
+        // 拼成一条记录加密，避免帧头单独占一个 TLS 记录
+        tls_scratch_.assign(head.data(), head.size());
+        tls_scratch_.append(data.data(), data.size());
+        ok = tls_->encrypt(tls_scratch_, &tls_out_);
+    }
+    if (!ok) {
+        CHWELL_LOG_WARN("TLS send failed: session closed or failed");
+        return;
+    }
+    send_raw_locked(tls_out_);
+}
+
+void TcpConnection::send_raw_locked(std::string_view data) {
+    if (data.empty()) {
+        return;
+    }
+    if (loop_) {
+        send_reactor(std::string_view(), data, nullptr);
+    } else {
+        send_blocking(data);
+    }
+}
+
+void TcpConnection::queue_tls_shutdown() {
+    std::lock_guard<std::mutex> tls_lock(tls_mutex_);
+    tls_out_.clear();
+    tls_->shutdown(&tls_out_);
+    if (tls_out_.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    if (!socket_.is_open()) {
+        return;
+    }
+    if (loop_) {
+        output_queue_.emplace_back(tls_out_.data(), tls_out_.size());
+        output_bytes_ += tls_out_.size();
+    } else {
+        write_all_locked(tls_out_);
+    }
+}
+
+void TcpConnection::handle_write() {
+    bool ok = true;
+    bool evict = false;
+    bool fire_low = false;
+    std::size_t bytes = 0;
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        ok = flush_output_locked();
+        if (ok && output_queue_.empty() && write_interest_) {
+            // 缓冲已清空：取消 EPOLLOUT，避免可写事件反复唤醒
+            write_interest_ = false;
+            loop_->modify_fd(socket_.native_handle(), interest_events());
+        }
+        if (above_high_) {
+            if (output_bytes_ <= backpressure_.low_watermark) {
+                above_high_ = false;
+                fire_low = true;
+                bytes = output_bytes_;
+            } else if (backpressure_.max_stall_ms > 0 &&
+                       std::chrono::steady_clock::now() - high_since_ >
+                           std::chrono::milliseconds(backpressure_.max_stall_ms)) {
+                evict = true;
+            }
+        }
+    }
+    if (!ok) {
+        handle_close();
+        return;
+    }
+    if (evict) {
+        evict_slow_consumer();
+        return;
+    }
+    if (fire_low) {
+        CHWELL_COUNT_EVENT("chwell_net_low_watermark_total",
+                           "Connections whose output buffer drained below the low watermark");
+        if (callbacks_->low_watermark) {
+            callbacks_->low_watermark(shared_from_this(), bytes);
+        }
+    }
+}
+
+bool TcpConnection::admit_output_locked(std::size_t incoming, bool& evict) {
+    evict = false;
+    if (output_queue_.empty()) {
+        return true;  // 缓冲为空时总是先尝试直接写入内核
+    }
+    if (above_high_ && backpressure_.max_stall_ms > 0 &&
+        std::chrono::steady_clock::now() - high_since_ >
+            std::chrono::milliseconds(backpressure_.max_stall_ms)) {
+        evict = true;
+        return false;
+    }
+    if (backpressure_.max_output_bytes > 0 &&
+        output_bytes_ + incoming > backpressure_.max_output_bytes) {
+        if (backpressure_.policy == SlowConsumerPolicy::kDisconnect) {
+            evict = true;
+        }
+        return false;
+    }
+    return true;
+}
+
+void TcpConnection::evict_slow_consumer() {
+    if (closed_.exchange(true)) {
+        return;
+    }
+    CHWELL_COUNT_EVENT("chwell_net_slow_consumer_evicted_total",
+                       "Slow consumers disconnected for exceeding the output budget");
+    CHWELL_LOG_WARN("Evicting slow consumer fd=" << socket_.native_handle()
+                    << ", buffered=" << output_buffer_bytes() << " bytes");
+    TcpConnectionPtr self = shared_from_this();
+    loop_->run_in_loop([self]() { self->handle_close(); });
+}
+
+void TcpConnection::arm_stall_timer() {
+    if (backpressure_.max_stall_ms <= 0 || state_ != State::kConnected || stall_timer_.pending()) {
+        return;
+    }
+    std::weak_ptr<TcpConnection> weak = shared_from_this();
+    stall_timer_.set_callback([weak]() {
+        if (TcpConnectionPtr self = weak.lock()) {
+            self->check_stall();
+        }
+    });
+    loop_->timers().schedule(&stall_timer_, loop_->now_ms(), backpressure_.max_stall_ms);
+}
+
+void TcpConnection::check_stall() {
+    if (state_ != State::kConnected) {
+        return;
+    }
+    std::int64_t remaining_ms = 0;
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        if (!above_high_) {
+            return;  // 已回落到低水位，下次越过高水位时重新挂上
+        }
+        // 期间可能回落后再次越过高水位：按最近一次越过的时间计算
+        remaining_ms = backpressure_.max_stall_ms -
+                       std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::steady_clock::now() - high_since_).count();
+    }
+    if (remaining_ms > 0) {
+        loop_->timers().schedule(&stall_timer_, loop_->now_ms(), remaining_ms);
+        return;
+    }
+    evict_slow_consumer();
+}
+
+void TcpConnection::enable_writing() {
+    if (state_ != State::kConnected) {
+        return;  // 尚未注册时由 connect_established 统一处理
+    }
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    if (write_interest_ && !output_queue_.empty()) {
+        loop_->modify_fd(socket_.native_handle(), interest_events());
+    }
+}
+
+bool TcpConnection::flush_output_locked() {
+    while (!output_queue_.empty()) {
+        if (output_queue_.front().is_file()) {
+            const FileRegion& file = output_queue_.front().file;
+            FileRegion rest(file.file, file.offset + output_offset_, file.length - output_offset_);
+            std::uint64_t sent = 0;
+            bool ok = sendfile_locked(rest, &sent);
+            output_file_bytes_ -= sent;
+            output_offset_ += static_cast<std::size_t>(sent);
+            if (!ok) {
+                return false;
+            }
+            if (sent < rest.length) {
+                return true;  // 内核发送缓冲已满，等待下一次可写
+            }
+            output_queue_.pop_front();
+            output_offset_ = 0;
+            continue;
+        }
+
+        // 合并连续的内存帧，遇到文件区间为止
+        iovec iov[kMaxWriteIov];
+        int cnt = 0;
+        std::size_t requested = 0;
+        for (auto it = output_queue_.begin();
+             it != output_queue_.end() && cnt < kMaxWriteIov && !it->is_file(); ++it, ++cnt) {
+            std::size_t skip = (cnt == 0) ? output_offset_ : 0;
+            iov[cnt].iov_base = const_cast<char*>(it->frame.data() + skip);
+            iov[cnt].iov_len = it->frame.size() - skip;
+            requested += iov[cnt].iov_len;
+        }
+
+        ssize_t n = socket_.writev(iov, cnt);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+            CHWELL_LOG_WARN("Connection write error: " + std::string(strerror(errno)));
+            return false;
+        }
+
+        std::size_t written = static_cast<std::size_t>(n);
+        output_bytes_ -= written;
+        touch_write();
+        while (written > 0) {
+            std::size_t remain = output_queue_.front().size() - output_offset_;
+            if (written >= remain) {
+                written -= remain;
+                output_queue_.pop_front();
+                output_offset_ = 0;
+            } else {
+                output_offset_ += written;
+                written = 0;
+            }
+        }
+        if (static_cast<std::size_t>(n) < requested) {
+            return true;  // 内核发送缓冲已满，等待下一次可写
+        }
+    }
+    if (low_memory_ && output_queue_.capacity() > 0) {
+        output_queue_.release();  // 写空后不为空闲连接保留队列容量
+    }
+    return true;
+}
+
+bool TcpConnection::sendfile_locked(const FileRegion& region, std::uint64_t* sent) {
+    *sent = 0;
+    while (*sent < region.length) {
+        off_t offset = static_cast<off_t>(region.offset + *sent);
+        std::size_t want = static_cast<std::size_t>(
+            std::min<std::uint64_t>(region.length - *sent, kMaxSendfileChunk));
+        ssize_t n = ::sendfile(socket_.native_handle(), region.file->fd(), &offset, want);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+            CHWELL_LOG_WARN("Connection sendfile error: " + std::string(strerror(errno)));
+            return false;
+        }
+        if (n == 0) {
+            // 文件在发送过程中被截断：已声明的长度无法兑现，只能断开
+            CHWELL_LOG_WARN("Connection sendfile: file truncated, "
+                            << (region.length - *sent) << " bytes missing");
+            return false;
+        }
+        *sent += static_cast<std::uint64_t>(n);
+        touch_write();
+    }
+    return true;
+}
+
+void TcpConnection::handle_close() {
+    if (state_ == State::kDisconnected) {
+        return;
+    }
+    if (state_ == State::kConnected) {
+        if (recv_mode_) {
+            loop_->remove_recv(socket_.native_handle());
+        }
+        loop_->remove_fd(socket_.native_handle());
+    }
+    state_ = State::kDisconnected;
+    closed_ = true;
+    if (loop_) {
+        loop_->timers().cancel(&idle_timer_);
+        loop_->timers().cancel(&stall_timer_);
+    }
+    if (splicing()) {
+        finish_splice(false);
+    }
+
+    {
+        // 与跨线程 send 互斥，避免向已关闭（可能被复用）的 fd 写入
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        ErrorCode ec;
+        socket_.close(ec);
+        output_queue_.clear();
+        output_offset_ = 0;
+        output_bytes_ = 0;
+        output_file_bytes_ = 0;
+        write_interest_ = false;
+        above_high_ = false;
+    }
+
+    if (callbacks_->close) {
+        callbacks_->close(shared_from_this());
     }
 }
 
@@ -62,33 +748,605 @@ void TcpConnection::send(const std::vector<char>& data) {
 }
 
 void TcpConnection::send(std::string_view data) {
+    if (tls_) {
+        send_tls(std::string_view(), data);
+        return;
+    }
+    if (!loop_) {
+        send_blocking(data);
+        return;
+    }
+    send_reactor(std::string_view(), data, nullptr);
+}
+
+void TcpConnection::send(const SharedFrame& frame) {
+    if (tls_) {
+        // 密文按连接各不相同，无法共享帧
+        send_tls(std::string_view(), frame.view());
+        return;
+    }
+    if (!loop_) {
+        send_blocking(frame.view());
+        return;
+    }
+    send_reactor(std::string_view(), frame.view(), &frame);
+}
+
+void TcpConnection::send(std::string_view head, std::string_view data) {
+    if (tls_) {
+        send_tls(head, data);
+        return;
+    }
+    if (!loop_) {
+        send_blocking(head, data);
+        return;
+    }
+    send_reactor(head, data, nullptr);
+}
+
+void TcpConnection::send_reactor(std::string_view head, std::string_view data,
+                                 const SharedFrame* frame) {
+    const std::size_t total = head.size() + data.size();
+    if (total == 0) {
+        return;
+    }
+
+    bool need_enable = false;
+    bool need_cork = false;
+    bool fire_high = false;
+    std::size_t bytes = 0;
+    {
+        std::unique_lock<std::mutex> lock(send_mutex_);
+        if (closed_ || !socket_.is_open()) {
+            CHWELL_LOG_WARN("Send failed: connection closed");
+            return;
+        }
+        bool evict = false;
+        if (!admit_output_locked(total, evict)) {
+            lock.unlock();
+            reject_output(total, evict);
+            return;
+        }
+
+        // 缓冲为空时直接尝试写入内核，保证发送顺序的同时省去一次入队；
+        // head 非空时与 data 以同一次 writev 写出。cork 连接一律入队，等 tick 边界统一写出
+        std::size_t written = 0;
+        if (output_queue_.empty() && !cork_) {
+            iovec iov[2];
+            int cnt = 0;
+            if (!head.empty()) {
+                iov[cnt].iov_base = const_cast<char*>(head.data());
+                iov[cnt].iov_len = head.size();
+                ++cnt;
+            }
+            if (!data.empty()) {
+                iov[cnt].iov_base = const_cast<char*>(data.data());
+                iov[cnt].iov_len = data.size();
+                ++cnt;
+            }
+            ssize_t n;
+            do {
+                n = socket_.writev(iov, cnt);
+            } while (n < 0 && errno == EINTR);
+            if (n >= 0) {
+                written = static_cast<std::size_t>(n);
+                touch_write();
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                // 连接已出错：由 loop 线程的读/错误事件完成关闭
+                CHWELL_LOG_WARN("Send failed: " + std::string(strerror(errno)));
+                return;
+            }
+        }
+
+        if (written < total) {
+            const std::size_t queued = total - written;
+            // head 未写完时剩余部分单独入队，data 从头入队
+            if (written < head.size()) {
+                output_queue_.emplace_back(head.data() + written, head.size() - written);
+                written = 0;
+            } else {
+                written -= head.size();
+            }
+            if (data.empty()) {
+                // 只有 head
+            } else if (frame) {
+                // 共享帧整体入队，已写出的前缀记在 output_offset_（此时队列为空或 written 为 0）
+                output_queue_.push_back(*frame);
+                if (output_queue_.size() == 1) {
+                    output_offset_ = written;
+                }
+            } else {
+                output_queue_.emplace_back(data.data() + written, data.size() - written);
+            }
+            output_bytes_ += queued;
+            if (cork_) {
+                need_cork = need_cork_locked();
+            } else if (!write_interest_) {
+                write_interest_ = true;
+                need_enable = true;
+            }
+            fire_high = check_high_watermark_locked(bytes);
+        }
+    }
+
+    if (need_cork) {
+        loop_->add_corked(shared_from_this());
+    }
+    if (need_enable) {
+        TcpConnectionPtr self = shared_from_this();
+        loop_->run_in_loop([self]() { self->enable_writing(); });
+    }
+    if (fire_high) {
+        fire_high_watermark(bytes);
+    }
+}
+
+void TcpConnection::send(std::string_view head, const SharedFrame& frame) {
+    if (tls_) {
+        send_tls(head, frame.view());
+        return;
+    }
+    if (!loop_) {
+        send_blocking(head, frame.view());
+        return;
+    }
+    send_reactor(head, frame.view(), &frame);
+}
+
+void TcpConnection::send_file(std::string_view head, const FileRegion& region) {
+    if (region.empty()) {
+        send(head);
+        return;
+    }
+    if (tls_ || !loop_) {
+        send_file_copy(head, region);
+        return;
+    }
+
+    bool need_enable = false;
+    bool need_cork = false;
+    bool fire_high = false;
+    std::size_t bytes = 0;
+    {
+        std::unique_lock<std::mutex> lock(send_mutex_);
+        if (closed_ || !socket_.is_open()) {
+            CHWELL_LOG_WARN("Send failed: connection closed");
+            return;
+        }
+        // 文件区间不占内存，只有 head 参与字节预算
+        bool evict = false;
+        if (!admit_output_locked(head.size(), evict)) {
+            lock.unlock();
+            reject_output(head.size() + static_cast<std::size_t>(region.length), evict);
+            return;
+        }
+
+        // 缓冲为空时先写 head，写完后直接 sendfile；写不下的部分按序入队
+        std::size_t head_written = 0;
+        std::uint64_t file_sent = 0;
+        if (output_queue_.empty() && !cork_) {
+            while (head_written < head.size()) {
+                ssize_t n = socket_.write(head.data() + head_written, head.size() - head_written);
+                if (n < 0 && errno == EINTR) continue;
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                if (n < 0) {
+                    CHWELL_LOG_WARN("Send failed: " + std::string(strerror(errno)));
+                    return;
+                }
+                head_written += static_cast<std::size_t>(n);
+                touch_write();
+            }
+            if (head_written == head.size() && !sendfile_locked(region, &file_sent)) {
+                return;  // 连接已出错：由 loop 线程的读/错误事件完成关闭
+            }
+        }
+
+        if (head_written < head.size()) {
+            output_queue_.emplace_back(head.data() + head_written, head.size() - head_written);
+            output_bytes_ += head.size() - head_written;
+        }
+        if (file_sent < region.length) {
+            output_queue_.emplace_back(FileRegion(region.file, region.offset + file_sent,
+                                                  region.length - file_sent));
+            output_file_bytes_ += region.length - file_sent;
+            if (cork_) {
+                need_cork = need_cork_locked();
+            } else if (!write_interest_) {
+                write_interest_ = true;
+                need_enable = true;
+            }
+            fire_high = check_high_watermark_locked(bytes);
+        }
+    }
+
+    if (need_cork) {
+        loop_->add_corked(shared_from_this());
+    }
+    if (need_enable) {
+        TcpConnectionPtr self = shared_from_this();
+        loop_->run_in_loop([self]() { self->enable_writing(); });
+    }
+    if (fire_high) {
+        fire_high_watermark(bytes);
+    }
+}
+
+void TcpConnection::send_file_copy(std::string_view head, const FileRegion& region) {
+    std::string chunk;
+    FileRegion rest = region;
+    bool first = true;
+    while (!rest.empty()) {
+        chunk.clear();
+        std::size_t n = read_file_region(rest, kFileCopyChunk, &chunk);
+        if (n == 0) {
+            CHWELL_LOG_WARN("send_file: read failed, " << rest.length << " bytes missing, closing");
+            close();
+            return;
+        }
+        if (first) {
+            send(head, chunk);
+            first = false;
+        } else {
+            send(chunk);
+        }
+        rest.offset += n;
+        rest.length -= n;
+    }
+}
+
+void TcpConnection::reject_output(std::size_t bytes, bool evict) {
+    if (evict) {
+        evict_slow_consumer();
+        return;
+    }
+    CHWELL_COUNT_EVENT("chwell_net_slow_consumer_dropped_frames_total",
+                       "Frames dropped for slow consumers over the output budget");
+    CHWELL_COUNT_EVENT("chwell_net_slow_consumer_dropped_bytes_total",
+                       "Bytes dropped for slow consumers over the output budget",
+                       static_cast<double>(bytes));
+}
+
+bool TcpConnection::check_high_watermark_locked(std::size_t& bytes) {
+    if (backpressure_.high_watermark == 0 || above_high_ ||
+        output_bytes_ < backpressure_.high_watermark) {
+        return false;
+    }
+    above_high_ = true;
+    high_since_ = std::chrono::steady_clock::now();
+    bytes = output_bytes_;
+    return true;
+}
+
+void TcpConnection::fire_high_watermark(std::size_t bytes) {
+    CHWELL_COUNT_EVENT("chwell_net_high_watermark_total",
+                       "Connections whose output buffer reached the high watermark");
+    // 总是入队：避免在调用方（可能持有业务锁）的栈上执行回调
+    TcpConnectionPtr self = shared_from_this();
+    loop_->queue_in_loop([self, bytes]() {
+        self->arm_stall_timer();
+        if (self->callbacks_->high_watermark) {
+            self->callbacks_->high_watermark(self, bytes);
+        }
+    });
+}
+
+bool TcpConnection::enqueue_frame(const SharedFrame& frame) {
+    bool schedule = false;
+    bool need_cork = false;
+    bool fire_high = false;
+    std::size_t bytes = 0;
+    {
+        std::unique_lock<std::mutex> lock(send_mutex_);
+        if (closed_ || !socket_.is_open()) {
+            return false;
+        }
+        bool evict = false;
+        if (!admit_output_locked(frame.size(), evict)) {
+            lock.unlock();
+            reject_output(frame.size(), evict);
+            return false;
+        }
+        // 队列原本为空且未关注可写：需要 loop 线程写出；否则已有写出路径负责。
+        // cork 连接改为登记到 loop，随 tick 边界与其他暂存帧一起写出
+        schedule = !cork_ && output_queue_.empty() && !write_interest_;
+        output_queue_.push_back(frame);
+        output_bytes_ += frame.size();
+        if (cork_) {
+            need_cork = need_cork_locked();
+        }
+        fire_high = check_high_watermark_locked(bytes);
+    }
+    if (need_cork) {
+        loop_->add_corked(shared_from_this());
+    }
+    if (fire_high) {
+        fire_high_watermark(bytes);
+    }
+    return schedule;
+}
+
+void TcpConnection::flush_queued() {
+    if (state_ != State::kConnected) {
+        return;  // 尚未注册时由 connect_established 按 interest 统一处理
+    }
+    bool ok = true;
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        ok = flush_output_locked();
+        if (ok && !output_queue_.empty() && !write_interest_) {
+            write_interest_ = true;
+            loop_->modify_fd(socket_.native_handle(), interest_events());
+        }
+    }
+    if (!ok) {
+        handle_close();
+    }
+}
+
+bool TcpConnection::splice_to(const TcpConnectionPtr& target, std::size_t bytes,
+                              std::function<void(bool ok)> done) {
+    if (!loop_ || tls_ || recv_mode_ || bytes == 0 || !target || target.get() == this ||
+        target->loop_ != loop_ || target->tls_ || state_ != State::kConnected ||
+        !loop_->is_in_loop_thread() || splicing()) {
+        return false;
+    }
+    if (!splice_) {
+        std::unique_ptr<SpliceState> sp(new SpliceState());
+        if (::pipe2(sp->pipe_fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+            CHWELL_LOG_WARN("splice_to: pipe2 failed: " << strerror(errno));
+            return false;
+        }
+        splice_ = std::move(sp);
+    }
+    SpliceState& sp = *splice_;
+    sp.active = true;
+    sp.failed = false;
+    sp.target = target;
+    sp.remaining = bytes;
+    sp.in_pipe = 0;
+    sp.spliced = 0;
+    sp.copied = 0;
+    sp.done = std::move(done);
+    return true;
+}
+
+bool TcpConnection::splicing() const {
+    return splice_ && splice_->active;
+}
+
+bool TcpConnection::continue_splice() {
+    SpliceState& sp = *splice_;
+    while (state_ == State::kConnected) {
+        if (sp.in_pipe > 0) {
+            ssize_t n = -1;
+            int err = EAGAIN;
+            if (sp.target) {
+                TcpConnection& target = *sp.target;
+                std::lock_guard<std::mutex> lock(target.send_mutex_);
+                if (target.closed_ || !target.socket_.is_open()) {
+                    err = EPIPE;
+                } else if (target.output_queue_.empty() && !target.write_interest_) {
+                    // 持 target 的发送锁写其 socket，期间其他发送只能排在之后
+                    n = ::splice(sp.pipe_fds[0], nullptr, target.socket_.native_handle(), nullptr,
+                                 sp.in_pipe, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                    err = n < 0 ? errno : EAGAIN;
+                }
+            }
+            if (n > 0) {
+                sp.in_pipe -= static_cast<std::size_t>(n);
+                sp.spliced += static_cast<std::size_t>(n);
+                continue;
+            }
+            if (err == EINTR) {
+                continue;
+            }
+            if (err != EAGAIN && sp.target) {
+                CHWELL_LOG_WARN("splice_to: target write failed: " << strerror(err));
+                sp.target.reset();
+                sp.failed = true;
+            }
+            // target 有排队输出、内核缓冲已满或已断开：读回用户态，经 send 入队（断开时丢弃），
+            // 排队与背压交给 target 的输出缓冲
+            char buf[kSpliceChunk];
+            ssize_t r = ::read(sp.pipe_fds[0], buf, std::min(sp.in_pipe, sizeof(buf)));
+            if (r <= 0) {
+                if (r < 0 && errno == EINTR) continue;
+                CHWELL_LOG_WARN("splice_to: pipe read failed");
+                finish_splice(false);
+                handle_close();
+                return true;
+            }
+            sp.in_pipe -= static_cast<std::size_t>(r);
+            if (sp.target) {
+                sp.copied += static_cast<std::size_t>(r);
+                sp.target->send(std::string_view(buf, static_cast<std::size_t>(r)));
+            }
+            continue;
+        }
+
+        if (sp.remaining == 0) {
+            finish_splice(!sp.failed);
+            return true;
+        }
+        if (!reading_) {
+            return false;  // 背压暂停读取：恢复后由读事件继续
+        }
+        ssize_t n = ::splice(socket_.native_handle(), nullptr, sp.pipe_fds[1], nullptr,
+                             std::min(sp.remaining, kSpliceChunk), SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n > 0) {
+            last_read_ms_ = loop_->now_ms();
+            sp.remaining -= static_cast<std::size_t>(n);
+            sp.in_pipe += static_cast<std::size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return false;
+        }
+        // 对端在帧中途关闭或读出错
+        if (n < 0) {
+            CHWELL_LOG_WARN("splice_to: read failed: " << strerror(errno));
+        }
+        finish_splice(false);
+        handle_close();
+        return true;
+    }
+    return true;
+}
+
+void TcpConnection::finish_splice(bool ok) {
+    SpliceState& sp = *splice_;
+    sp.active = false;
+    sp.target.reset();
+    // 异常结束时管道可能有残留，丢弃以便下次复用
+    char buf[4096];
+    while (sp.in_pipe > 0) {
+        ssize_t r = ::read(sp.pipe_fds[0], buf, std::min(sp.in_pipe, sizeof(buf)));
+        if (r <= 0) break;
+        sp.in_pipe -= static_cast<std::size_t>(r);
+    }
+    sp.in_pipe = 0;
+    CHWELL_COUNT_EVENT("chwell_net_spliced_bytes_total", "Bytes moved between sockets by splice",
+                       static_cast<double>(sp.spliced));
+    if (sp.copied > 0) {
+        CHWELL_COUNT_EVENT("chwell_net_splice_copied_bytes_total",
+                           "Passthrough bytes copied through user space behind queued output",
+                           static_cast<double>(sp.copied));
+    }
+    std::function<void(bool)> done = std::move(sp.done);
+    sp.done = nullptr;
+    if (done) {
+        done(ok);
+    }
+}
+
+bool TcpConnection::need_cork_locked() {
+    // 已关注可写时由可写事件写出；已登记时等本 tick 边界一起写出
+    if (write_interest_ || cork_queued_) {
+        return false;
+    }
+    cork_queued_ = true;
+    return true;
+}
+
+void TcpConnection::flush_corked() {
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        cork_queued_ = false;
+    }
+    flush_queued();
+}
+
+void TcpConnection::set_cork(bool on) {
+    if (cork_.exchange(on) && !on) {
+        flush();
+    }
+}
+
+void TcpConnection::flush() {
+    if (!loop_) {
+        return;  // 阻塞模式的 send 已同步写出
+    }
+    bool need_enable = false;
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        // 已关注可写说明内核缓冲已满，由可写事件继续写出
+        if (closed_ || !socket_.is_open() || output_queue_.empty() || write_interest_) {
+            return;
+        }
+        if (!flush_output_locked()) {
+            return;  // 连接已出错：由 loop 线程的读/错误事件完成关闭
+        }
+        if (!output_queue_.empty()) {
+            write_interest_ = true;
+            need_enable = true;
+        }
+    }
+    if (need_enable) {
+        TcpConnectionPtr self = shared_from_this();
+        loop_->run_in_loop([self]() { self->enable_writing(); });
+    }
+}
+
+void TcpConnection::send_blocking(std::string_view data) {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    if (closed_ || !socket_.is_open()) {
+        CHWELL_LOG_WARN("Send failed: connection closed");
+        return;
+    }
+    write_all_locked(data);
+}
+
+void TcpConnection::send_blocking(std::string_view head, std::string_view data) {
+    // 同一把锁内连续写出，保证与其他线程的 send 不交错
     std::lock_guard<std::mutex> lock(send_mutex_);
     if (closed_ || !socket_.is_open()) {
         CHWELL_LOG_WARN("Send failed: connection closed");
         return;
     }
+    if (write_all_locked(head)) {
+        write_all_locked(data);
+    }
+}
+
+bool TcpConnection::write_all_locked(std::string_view data) {
     CHWELL_LOG_DEBUG("Sending " << data.size() << " bytes");
     const char* ptr = data.data();
     std::size_t len = data.size();
     while (len > 0) {
         ssize_t n = socket_.write(ptr, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // 调用方把 socket 设为非阻塞时：内核发送缓冲满则等待可写
+            pollfd pfd;
+            pfd.fd = socket_.native_handle();
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+            if (poll(&pfd, 1, kSendWaitMs) <= 0) {
+                CHWELL_LOG_ERROR("Send failed: socket not writable");
+                return false;
+            }
+            continue;
+        }
         if (n <= 0) {
             CHWELL_LOG_ERROR("Send failed: " + std::string(strerror(errno)));
-            return;
+            return false;
         }
         ptr += n;
         len -= static_cast<std::size_t>(n);
     }
     CHWELL_LOG_DEBUG("Send completed");
+    return true;
 }
 
 void TcpConnection::close() {
-    if (closed_) {
+    if (closed_.exchange(true)) {
         CHWELL_LOG_DEBUG("Connection already closed");
         return;
     }
     CHWELL_LOG_INFO("Closing connection");
-    closed_ = true;
+
+    if (tls_) {
+        queue_tls_shutdown();
+    }
+    if (loop_) {
+        // 反应堆模式：在 loop 线程尽力写出剩余输出，再注销 fd 并回调 close；
+        // 不等待慢速对端，未写出的数据随连接一起丢弃
+        TcpConnectionPtr self = shared_from_this();
+        loop_->run_in_loop([self]() {
+            if (self->state_ == State::kConnected) {
+                std::lock_guard<std::mutex> lock(self->send_mutex_);
+                self->flush_output_locked();
+            }
+            self->handle_close();
+        });
+        return;
+    }
+
     ErrorCode ec;
     socket_.shutdown(SHUT_RDWR, ec);
     if (ec) {
@@ -100,5 +1358,34 @@ void TcpConnection::close() {
     }
 }
 
+void broadcast(const std::vector<TcpConnectionPtr>& group, const SharedFrame& frame) {
+    if (frame.empty()) {
+        return;
+    }
+    // 先在调用线程按序入队（保持与前后 send 的顺序），再按 loop 分组统一写出
+    std::unordered_map<EventLoop*, std::vector<TcpConnectionPtr>> by_loop;
+    for (const TcpConnectionPtr& conn : group) {
+        if (!conn) {
+            continue;
+        }
+        if (!conn->loop_ || conn->tls_) {
+            conn->send(frame);
+            continue;
+        }
+        if (conn->enqueue_frame(frame)) {
+            by_loop[conn->loop_].push_back(conn);
+        }
+    }
+    for (auto& entry : by_loop) {
+        EventLoop* loop = entry.first;
+        std::vector<TcpConnectionPtr> conns = std::move(entry.second);
+        loop->run_in_loop([conns]() {
+            for (const TcpConnectionPtr& conn : conns) {
+                conn->flush_queued();
+            }
+        });
+    }
+}
+
 } // namespace net
 } // namespace chwell
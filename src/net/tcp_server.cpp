@@ -1,18 +1,70 @@
 #include "chwell/net/tcp_server.h"
 #include "chwell/core/logger.h"
 #include <cerrno>
+#include <chrono>
 #include <cstring>
+#include <future>
 #include <unistd.h>
 
 namespace chwell {
 namespace net {
 
-TcpServer::TcpServer(IoService& io_service, unsigned short port)
-    : io_service_(io_service), port_(port), acceptor_(port) {
+namespace {
+
+const int kAcceptFlags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+
+} // anonymous namespace
+
+TcpServer::TcpServer(EventLoopThreadPool& loops, unsigned short port)
+    : loops_(loops), port_(port) {
+}
+
+TcpServer::TcpServer(IoService& /*io_service*/, unsigned short port)
+    : own_loops_(new EventLoopThreadPool(1)),
+      loops_(*own_loops_),
+      port_(port) {
 }
 
 void TcpServer::start_accept() {
-    if (acceptor_.listen_fd() < 0) {
+    if (!loops_.started()) {
+        loops_.start();
+    }
+    stopped_ = false;
+    // 所有连接共享同一组回调
+    callbacks_ = std::make_shared<ConnectionCallbacks>();
+    callbacks_->message = message_cb_;
+    callbacks_->close = [this](const TcpConnectionPtr& c) {
+        std::size_t remaining = 0;
+        {
+            std::lock_guard<std::mutex> lock(connections_mutex_);
+            connections_.erase(c);
+            remaining = connections_.size();
+        }
+        CHWELL_LOG_INFO("Connection closed, remaining: " << remaining);
+        if (disconnect_cb_) {
+            disconnect_cb_(c);
+        }
+    };
+    if (config_.cork_tick_ms > 0) {
+        for (std::size_t i = 0; i < loops_.size(); ++i) {
+            loops_.get_loop(i)->set_cork_tick_ms(config_.cork_tick_ms);
+        }
+    }
+
+    if (config_.reuse_port) {
+        if (!start_sharded_accept()) {
+            CHWELL_LOG_ERROR("TcpServer: failed to create SO_REUSEPORT acceptors on port " << port_);
+            return;
+        }
+        CHWELL_LOG_INFO("TcpServer listening on 0.0.0.0:" << port_ << " with "
+                        << shards_.size() << " SO_REUSEPORT acceptor(s), backlog="
+                        << config_.backlog);
+        return;
+    }
+
+    // 监听 socket 延迟到此处创建：构造期绑定端口会阻止后续以 SO_REUSEPORT 方式监听
+    acceptor_.reset(new TcpAcceptor(port_, config_.backlog));
+    if (acceptor_->listen_fd() < 0) {
         CHWELL_LOG_ERROR("TcpServer: failed to create acceptor");
         return;
     }
@@ -22,11 +74,61 @@ void TcpServer::start_accept() {
         return;
     }
 
-    CHWELL_LOG_INFO("TcpServer listening on 0.0.0.0:" << port_);
-    stopped_ = false;
+    CHWELL_LOG_INFO("TcpServer listening on 0.0.0.0:" << port_ << ", backlog=" << config_.backlog);
     accept_thread_ = std::thread([this]() { accept_loop(); });
 }
 
+bool TcpServer::start_sharded_accept() {
+    for (std::size_t i = 0; i < loops_.size(); ++i) {
+        EventLoop* loop = loops_.get_loop(i);
+        std::unique_ptr<TcpAcceptor> acceptor(new TcpAcceptor(port_, config_.backlog, true));
+        if (acceptor->listen_fd() < 0) {
+            stop_sharded_accept();
+            return false;
+        }
+        shards_.push_back(AcceptShard{loop, std::move(acceptor)});
+    }
+
+    // 水平触发：单次事件未取尽的连接会在下一轮继续通知，避免某个 loop 被 accept 长期占用
+    for (auto& shard : shards_) {
+        TcpAcceptor* acceptor = shard.acceptor.get();
+        EventLoop* loop = shard.loop;
+        loop->run_in_loop([this, acceptor, loop]() {
+            loop->add_fd(acceptor->listen_fd(), EPOLLIN,
+                         [this, acceptor, loop](std::uint32_t) {
+                             drain_accept(*acceptor, loop);
+                         });
+        });
+    }
+    return true;
+}
+
+void TcpServer::stop_sharded_accept() {
+    for (auto& shard : shards_) {
+        EventLoop* loop = shard.loop;
+        int fd = shard.acceptor->listen_fd();
+
+        // 在所属 loop 线程注销监听 fd；loop 已退出时直接注销
+        bool removed = false;
+        if (loop->looping()) {
+            auto done = std::make_shared<std::promise<void>>();
+            std::future<void> fut = done->get_future();
+            loop->run_in_loop([loop, fd, done]() {
+                loop->remove_fd(fd);
+                done->set_value();
+            });
+            while (fut.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready) {
+                if (!loop->looping()) break;
+            }
+            removed = fut.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+        if (!removed) {
+            loop->remove_fd(fd);
+        }
+    }
+    shards_.clear();
+}
+
 void TcpServer::stop() {
     if (stopped_) {
         CHWELL_LOG_WARN("TcpServer already stopped");
@@ -36,6 +138,8 @@ void TcpServer::stop() {
     CHWELL_LOG_INFO("TcpServer stopping on port " << port_);
     stopped_ = true;
 
+    stop_sharded_accept();
+
     if (wake_pipe_[1] >= 0) {
         char c = 1;
         ssize_t n = write(wake_pipe_[1], &c, 1);
@@ -48,6 +152,11 @@ void TcpServer::stop() {
     }
     if (wake_pipe_[0] >= 0) { close(wake_pipe_[0]); wake_pipe_[0] = -1; }
     if (wake_pipe_[1] >= 0) { close(wake_pipe_[1]); wake_pipe_[1] = -1; }
+    acceptor_.reset();
+
+    if (own_loops_) {
+        own_loops_->stop();
+    }
 
     {
         std::lock_guard<std::mutex> lock(connections_mutex_);
@@ -57,7 +166,7 @@ void TcpServer::stop() {
 
 void TcpServer::accept_loop() {
     pollfd fds[2];
-    fds[0].fd = acceptor_.listen_fd();
+    fds[0].fd = acceptor_->listen_fd();
     fds[0].events = POLLIN;
     fds[1].fd = wake_pipe_[0];
     fds[1].events = POLLIN;
@@ -79,46 +188,62 @@ void TcpServer::accept_loop() {
         }
 
         if (fds[0].revents & POLLIN) {
-            ErrorCode ec;
-            TcpSocket socket = acceptor_.accept(ec);
-            if (ec) {
-                CHWELL_LOG_ERROR("Accept failed: " + ec.message());
+            drain_accept(*acceptor_, nullptr);
+        }
+    }
+}
+
+void TcpServer::drain_accept(TcpAcceptor& acceptor, EventLoop* loop) {
+    int batch = config_.accept_batch > 0 ? config_.accept_batch : 1;
+    for (int i = 0; i < batch && !stopped_; ++i) {
+        ErrorCode ec;
+        TcpSocket socket = acceptor.accept(ec, kAcceptFlags);
+        if (ec) {
+            if (ec.value_ == EAGAIN || ec.value_ == EWOULDBLOCK) {
+                return;
+            }
+            if (ec.value_ == EINTR || ec.value_ == ECONNABORTED) {
                 continue;
             }
+            // EMFILE / ENFILE 等：本轮放弃，等待下次可读事件重试
+            CHWELL_LOG_ERROR("Accept failed: " + ec.message());
+            return;
+        }
+        handle_new_connection(loop ? loop : loops_.next_loop(), std::move(socket));
+    }
+}
 
-            auto conn = std::make_shared<TcpConnection>(std::move(socket));
-            conn->set_message_callback(message_cb_);
-            conn->set_close_callback([this](const TcpConnectionPtr& c) {
-                std::size_t remaining = 0;
-                {
-                    std::lock_guard<std::mutex> lock(connections_mutex_);
-                    connections_.erase(c);
-                    remaining = connections_.size();
-                }
-                CHWELL_LOG_INFO("Connection closed, remaining: " << remaining);
-                if (disconnect_cb_) {
-                    disconnect_cb_(c);
-                }
-            });
-
-            std::size_t total = 0;
-            {
-                std::lock_guard<std::mutex> lock(connections_mutex_);
-                connections_.insert(conn);
-                total = connections_.size();
-            }
-            CHWELL_LOG_INFO("New connection accepted, total: " << total);
+void TcpServer::handle_new_connection(EventLoop* loop, TcpSocket socket) {
+    auto conn = std::make_shared<TcpConnection>(loop, std::move(socket));
+    conn->set_backpressure(config_.backpressure);
+    conn->set_idle_timeout(config_.idle);
+    if (config_.cork_tick_ms > 0) {
+        conn->set_cork(true);
+    }
+    if (config_.tls) {
+        conn->enable_tls(config_.tls);
+    }
+    if (config_.low_memory) {
+        conn->set_low_memory(true);
+    }
+    conn->set_max_read_bytes(config_.max_read_bytes);
+    conn->set_frame_format(config_.frame_format);
+    conn->set_callbacks(callbacks_);
 
-            if (connection_cb_) {
-                connection_cb_(conn);
-            }
+    std::size_t total = 0;
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        connections_.insert(conn);
+        total = connections_.size();
+    }
+    CHWELL_LOG_INFO("New connection accepted, total: " << total);
 
-            io_service_.post([conn, this]() {
-                CHWELL_LOG_DEBUG("Starting connection read loop");
-                conn->start();
-            });
-        }
+    if (connection_cb_) {
+        connection_cb_(conn);
     }
+
+    // 注册到所属 loop，之后读事件由该 loop 线程分发
+    conn->start();
 }
 
 } // namespace net
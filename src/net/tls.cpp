@@ -1,4 +1,10 @@
 #include "chwell/net/tls.h"
+#include "chwell/metrics/event_counter.h"
+#include "chwell/metrics/prometheus_metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
 
 #ifdef CHWELL_USE_OPENSSL
 
@@ -10,6 +16,25 @@ namespace net {
 
 namespace {
 
+// 服务端会话缓存的 ID 上下文：会话只在同一上下文内恢复
+const unsigned char kSessionIdContext[] = "chwell";
+
+// 握手完成计数与恢复命中率（进程内累计）
+void record_handshake(bool resumed) {
+    static std::atomic<std::uint64_t> total{0};
+    static std::atomic<std::uint64_t> hits{0};
+    const std::uint64_t t = ++total;
+    const std::uint64_t h = resumed ? ++hits : hits.load();
+    CHWELL_COUNT_EVENT("chwell_net_tls_handshakes_total", "Completed TLS handshakes");
+    if (resumed) {
+        CHWELL_COUNT_EVENT("chwell_net_tls_resumed_handshakes_total",
+                           "TLS handshakes that resumed a session (ticket or session cache)");
+    }
+    static metrics::Gauge& hit_ratio = metrics::get_prometheus_registry().register_gauge(
+        "chwell_net_tls_resumption_hit_ratio", "Share of TLS handshakes that resumed a session");
+    hit_ratio.set(static_cast<double>(h) / static_cast<double>(t));
+}
+
 inline void log_ssl_error(const std::string& prefix) {
     unsigned long err = ERR_get_error();
     if (err != 0) {
@@ -23,6 +48,10 @@ inline void log_ssl_error(const std::string& prefix) {
 
 } // anonymous namespace
 
+bool tls_available() {
+    return true;
+}
+
 TlsContext::TlsContext()
     : ctx_(nullptr), is_server_(false) {
     SSL_library_init();
@@ -31,6 +60,10 @@ TlsContext::TlsContext()
 }
 
 TlsContext::~TlsContext() {
+    for (auto& entry : client_sessions_) {
+        SSL_SESSION_free(static_cast<SSL_SESSION*>(entry.second));
+    }
+    client_sessions_.clear();
     if (ctx_) {
         SSL_CTX* real = static_cast<SSL_CTX*>(ctx_);
         SSL_CTX_free(real);
@@ -39,7 +72,8 @@ TlsContext::~TlsContext() {
 }
 
 bool TlsContext::init_server(const std::string& cert_file,
-                             const std::string& key_file) {
+                             const std::string& key_file,
+                             const TlsSessionConfig& sessions) {
     is_server_ = true;
     SSL_CTX* c = SSL_CTX_new(TLS_server_method());
     if (!c) {
@@ -62,10 +96,11 @@ bool TlsContext::init_server(const std::string& cert_file,
         return false;
     }
     ctx_ = c;
+    configure_sessions(sessions);
     return true;
 }
 
-bool TlsContext::init_client(const std::string& ca_file) {
+bool TlsContext::init_client(const std::string& ca_file, const TlsSessionConfig& sessions) {
     is_server_ = false;
     SSL_CTX* c = SSL_CTX_new(TLS_client_method());
     if (!c) {
@@ -81,9 +116,64 @@ bool TlsContext::init_client(const std::string& ca_file) {
         SSL_CTX_set_verify(c, SSL_VERIFY_PEER, nullptr);
     }
     ctx_ = c;
+    configure_sessions(sessions);
     return true;
 }
 
+void TlsContext::configure_sessions(const TlsSessionConfig& sessions) {
+    sessions_ = sessions;
+    SSL_CTX* c = static_cast<SSL_CTX*>(ctx_);
+    // 空闲连接不常驻读写缓冲（每连接约 34KB），大量长连接时显著省内存
+    SSL_CTX_set_mode(c, SSL_MODE_RELEASE_BUFFERS);
+    SSL_CTX_set_timeout(c, sessions.timeout_sec);
+    if (!sessions.tickets) {
+        SSL_CTX_set_options(c, SSL_OP_NO_TICKET);
+    }
+    if (is_server_) {
+        SSL_CTX_set_session_id_context(c, kSessionIdContext, sizeof(kSessionIdContext) - 1);
+        if (sessions.cache_size > 0) {
+            SSL_CTX_set_session_cache_mode(c, SSL_SESS_CACHE_SERVER);
+            SSL_CTX_sess_set_cache_size(c, static_cast<long>(sessions.cache_size));
+        } else {
+            SSL_CTX_set_session_cache_mode(c, SSL_SESS_CACHE_OFF);
+        }
+        // 每次握手只下发一张票据（TLS 1.3 默认两张）
+        SSL_CTX_set_num_tickets(c, 1);
+        return;
+    }
+    // 客户端：新会话（含 TLS 1.3 握手后下发的票据）经回调存入按对端索引的缓存
+    SSL_CTX_set_session_cache_mode(c, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(c, [](SSL* ssl, SSL_SESSION* session) -> int {
+        TlsSession* owner = static_cast<TlsSession*>(SSL_get_app_data(ssl));
+        return owner && owner->on_new_session(session) ? 1 : 0;
+    });
+}
+
+void* TlsContext::client_session(const std::string& peer) {
+    std::lock_guard<std::mutex> lock(client_sessions_mutex_);
+    auto it = client_sessions_.find(peer);
+    if (it == client_sessions_.end()) {
+        return nullptr;
+    }
+    SSL_SESSION* session = static_cast<SSL_SESSION*>(it->second);
+    if (!SSL_SESSION_is_resumable(session)) {
+        SSL_SESSION_free(session);
+        client_sessions_.erase(it);
+        return nullptr;
+    }
+    SSL_SESSION_up_ref(session);
+    return session;
+}
+
+void TlsContext::store_client_session(const std::string& peer, void* session) {
+    std::lock_guard<std::mutex> lock(client_sessions_mutex_);
+    void*& slot = client_sessions_[peer];
+    if (slot) {
+        SSL_SESSION_free(static_cast<SSL_SESSION*>(slot));
+    }
+    slot = session;
+}
+
 TlsConnection::TlsConnection(TlsContext& ctx, TcpSocket&& socket)
     : ctx_(ctx),
       socket_(std::move(socket)),
@@ -158,6 +248,216 @@ void TlsConnection::close() {
     established_ = false;
 }
 
+TlsSession::TlsSession(const TlsContextPtr& ctx, const std::string& peer)
+    : ctx_(ctx),
+      peer_(peer),
+      ssl_(nullptr),
+      rbio_(nullptr),
+      wbio_(nullptr),
+      established_(false),
+      resumed_(false),
+      failed_(true),
+      peer_closed_(false) {
+    if (!ctx_ || !ctx_->ready()) {
+        CHWELL_LOG_ERROR("TLS: session created with an uninitialized context");
+        return;
+    }
+    SSL* s = SSL_new(static_cast<SSL_CTX*>(ctx_->ctx_));
+    BIO* rbio = BIO_new(BIO_s_mem());
+    BIO* wbio = BIO_new(BIO_s_mem());
+    if (!s || !rbio || !wbio) {
+        log_ssl_error("TLS: SSL_new / BIO_new failed");
+        if (rbio) BIO_free(rbio);
+        if (wbio) BIO_free(wbio);
+        if (s) SSL_free(s);
+        return;
+    }
+    // 读 BIO 读空时返回 want-read 而不是 EOF
+    BIO_set_mem_eof_return(rbio, -1);
+    BIO_set_mem_eof_return(wbio, -1);
+    SSL_set_bio(s, rbio, wbio);
+    SSL_set_app_data(s, this);
+    if (ctx_->is_server()) {
+        SSL_set_accept_state(s);
+    } else {
+        SSL_set_connect_state(s);
+        if (!peer_.empty()) {
+            if (SSL_SESSION* cached = static_cast<SSL_SESSION*>(ctx_->client_session(peer_))) {
+                SSL_set_session(s, cached);
+                SSL_SESSION_free(cached);
+            }
+        }
+    }
+    ssl_ = s;
+    rbio_ = rbio;
+    wbio_ = wbio;
+    failed_ = false;
+}
+
+TlsSession::~TlsSession() {
+    if (ssl_) {
+        SSL* s = static_cast<SSL*>(ssl_);
+        // 未收发 close_notify 就释放时 OpenSSL 会作废会话；移动端断网重连是常态，
+        // 只要会话未出错就视为正常关闭，保留会话供恢复
+        if (established_ && !failed_) {
+            SSL_set_shutdown(s, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+        }
+        SSL_free(s);  // 同时释放两个 BIO
+    }
+}
+
+bool TlsSession::on_new_session(void* session) {
+    if (peer_.empty()) {
+        return false;
+    }
+    ctx_->store_client_session(peer_, session);
+    return true;
+}
+
+bool TlsSession::start(std::string* cipher_out) {
+    if (failed_) {
+        return false;
+    }
+    if (ctx_->is_server() || established_) {
+        return true;
+    }
+    bool ok = drive_handshake(cipher_out);
+    drain(cipher_out);
+    return ok;
+}
+
+bool TlsSession::drive_handshake(std::string* cipher_out) {
+    SSL* s = static_cast<SSL*>(ssl_);
+    int ret = SSL_do_handshake(s);
+    if (ret == 1) {
+        established_ = true;
+        resumed_ = SSL_session_reused(s) == 1;
+        record_handshake(resumed_);
+        return flush_pending(cipher_out);
+    }
+    int err = SSL_get_error(s, ret);
+    if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+        return true;
+    }
+    failed_ = true;
+    CHWELL_COUNT_EVENT("chwell_net_tls_handshake_failures_total", "Failed TLS handshakes");
+    log_ssl_error("TLS: handshake failed");
+    ERR_clear_error();
+    return false;
+}
+
+bool TlsSession::flush_pending(std::string* cipher_out) {
+    if (pending_.empty()) {
+        return true;
+    }
+    std::string pending;
+    pending.swap(pending_);
+    return encrypt(pending, cipher_out);
+}
+
+void TlsSession::drain(std::string* cipher_out) {
+    BIO* wbio = static_cast<BIO*>(wbio_);
+    std::size_t pending;
+    while ((pending = BIO_ctrl_pending(wbio)) > 0) {
+        const std::size_t old = cipher_out->size();
+        cipher_out->resize(old + pending);
+        int n = BIO_read(wbio, &(*cipher_out)[old], static_cast<int>(pending));
+        cipher_out->resize(old + (n > 0 ? static_cast<std::size_t>(n) : 0));
+        if (n <= 0) {
+            break;
+        }
+    }
+}
+
+bool TlsSession::feed(std::string_view cipher_in, std::string* plain, std::string* cipher_out) {
+    if (failed_) {
+        return false;
+    }
+    SSL* s = static_cast<SSL*>(ssl_);
+    BIO* rbio = static_cast<BIO*>(rbio_);
+    while (!cipher_in.empty()) {
+        const int chunk = static_cast<int>(std::min<std::size_t>(cipher_in.size(), INT_MAX));
+        int n = BIO_write(rbio, cipher_in.data(), chunk);
+        if (n <= 0) {
+            failed_ = true;
+            log_ssl_error("TLS: BIO_write failed");
+            return false;
+        }
+        cipher_in.remove_prefix(static_cast<std::size_t>(n));
+    }
+
+    if (!established_) {
+        if (!drive_handshake(cipher_out)) {
+            drain(cipher_out);  // 握手告警
+            return false;
+        }
+        if (!established_) {
+            drain(cipher_out);
+            return true;
+        }
+    }
+
+    // 读出全部已到达的记录；SSL_read 同时处理握手后消息（如会话票据）
+    const std::size_t kReadChunk = 16 * 1024;
+    for (;;) {
+        const std::size_t old = plain->size();
+        plain->resize(old + kReadChunk);
+        int n = SSL_read(s, &(*plain)[old], static_cast<int>(kReadChunk));
+        plain->resize(old + (n > 0 ? static_cast<std::size_t>(n) : 0));
+        if (n > 0) {
+            continue;
+        }
+        int err = SSL_get_error(s, n);
+        if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+            break;
+        }
+        if (err == SSL_ERROR_ZERO_RETURN) {
+            peer_closed_ = true;
+            break;
+        }
+        failed_ = true;
+        log_ssl_error("TLS: read error");
+        ERR_clear_error();
+        drain(cipher_out);
+        return false;
+    }
+    drain(cipher_out);
+    return true;
+}
+
+bool TlsSession::encrypt(std::string_view plain, std::string* cipher_out) {
+    if (failed_) {
+        return false;
+    }
+    if (!established_) {
+        pending_.append(plain.data(), plain.size());
+        return true;
+    }
+    SSL* s = static_cast<SSL*>(ssl_);
+    while (!plain.empty()) {
+        const int chunk = static_cast<int>(std::min<std::size_t>(plain.size(), INT_MAX));
+        int n = SSL_write(s, plain.data(), chunk);
+        if (n <= 0) {
+            failed_ = true;
+            log_ssl_error("TLS: write error");
+            ERR_clear_error();
+            return false;
+        }
+        plain.remove_prefix(static_cast<std::size_t>(n));
+    }
+    drain(cipher_out);
+    return true;
+}
+
+void TlsSession::shutdown(std::string* cipher_out) {
+    if (failed_ || !established_) {
+        return;
+    }
+    SSL_shutdown(static_cast<SSL*>(ssl_));
+    ERR_clear_error();
+    drain(cipher_out);
+}
+
 } // namespace net
 } // namespace chwell
 
@@ -166,15 +466,19 @@ void TlsConnection::close() {
 namespace chwell {
 namespace net {
 
+bool tls_available() {
+    return false;
+}
+
 TlsContext::TlsContext() : ctx_(nullptr), is_server_(false) {}
 TlsContext::~TlsContext() {}
 
-bool TlsContext::init_server(const std::string&, const std::string&) {
+bool TlsContext::init_server(const std::string&, const std::string&, const TlsSessionConfig&) {
     CHWELL_LOG_ERROR("TLS not available: rebuild with CHWELL_USE_OPENSSL=ON");
     return false;
 }
 
-bool TlsContext::init_client(const std::string&) {
+bool TlsContext::init_client(const std::string&, const TlsSessionConfig&) {
     CHWELL_LOG_ERROR("TLS not available: rebuild with CHWELL_USE_OPENSSL=ON");
     return false;
 }
@@ -211,6 +515,35 @@ void TlsConnection::close() {
     established_ = false;
 }
 
+TlsSession::TlsSession(const TlsContextPtr& ctx, const std::string& peer)
+    : ctx_(ctx),
+      peer_(peer),
+      ssl_(nullptr),
+      rbio_(nullptr),
+      wbio_(nullptr),
+      established_(false),
+      resumed_(false),
+      failed_(true),
+      peer_closed_(false) {
+    CHWELL_LOG_ERROR("TLS not available: rebuild with CHWELL_USE_OPENSSL=ON");
+}
+
+TlsSession::~TlsSession() {}
+
+bool TlsSession::start(std::string*) {
+    return false;
+}
+
+bool TlsSession::feed(std::string_view, std::string*, std::string*) {
+    return false;
+}
+
+bool TlsSession::encrypt(std::string_view, std::string*) {
+    return false;
+}
+
+void TlsSession::shutdown(std::string*) {}
+
 } // namespace net
 } // namespace chwell
 
@@ -0,0 +1,163 @@
+#include "chwell/net/udp_offload.h"
+#include "chwell/core/logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <netinet/udp.h>
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+
+namespace chwell {
+namespace net {
+
+namespace {
+
+std::atomic<bool>& gso_slot() {
+    static std::atomic<bool> enabled(true);
+    return enabled;
+}
+
+// 内核对 GSO 请求的“不支持”类错误：关闭 GSO 并回退
+bool is_gso_rejection(int err) {
+    return err == ENOPROTOOPT || err == EOPNOTSUPP || err == EIO || err == EINVAL;
+}
+
+// 单次 GSO sendmsg：payload 不超过 kMaxGsoSegments 段；返回 sendmsg 结果，失败时写 *err
+ssize_t send_gso(int fd, std::string_view payload, std::size_t segment_size,
+                 const UdpEndpoint& remote, int* err) {
+    iovec iov;
+    iov.iov_base = const_cast<char*>(payload.data());
+    iov.iov_len = payload.size();
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(std::uint16_t))] = {};
+    msghdr msg{};
+    msg.msg_name = const_cast<sockaddr_in*>(&remote.addr_);
+    msg.msg_namelen = sizeof(remote.addr_);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_UDP;
+    cm->cmsg_type = UDP_SEGMENT;
+    cm->cmsg_len = CMSG_LEN(sizeof(std::uint16_t));
+    std::uint16_t gso_size = static_cast<std::uint16_t>(segment_size);
+    std::memcpy(CMSG_DATA(cm), &gso_size, sizeof(gso_size));
+
+    ssize_t n;
+    do {
+        n = ::sendmsg(fd, &msg, MSG_DONTWAIT);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        *err = errno;
+    }
+    return n;
+}
+
+// 回退路径：逐段 sendmmsg，返回发出的段数
+std::size_t send_mmsg_segments(int fd, std::string_view payload, std::size_t segment_size,
+                               const UdpEndpoint& remote) {
+    const std::size_t kBatch = 64;
+    mmsghdr headers[kBatch];
+    iovec iovecs[kBatch];
+    std::size_t sent = 0;
+    std::size_t offset = 0;
+    while (offset < payload.size()) {
+        std::size_t count = 0;
+        for (std::size_t pos = offset; pos < payload.size() && count < kBatch;
+             pos += segment_size, ++count) {
+            iovecs[count].iov_base = const_cast<char*>(payload.data() + pos);
+            iovecs[count].iov_len = std::min(segment_size, payload.size() - pos);
+            headers[count] = mmsghdr{};
+            headers[count].msg_hdr.msg_name = const_cast<sockaddr_in*>(&remote.addr_);
+            headers[count].msg_hdr.msg_namelen = sizeof(remote.addr_);
+            headers[count].msg_hdr.msg_iov = &iovecs[count];
+            headers[count].msg_hdr.msg_iovlen = 1;
+        }
+        int n = ::sendmmsg(fd, headers, static_cast<unsigned int>(count), MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                CHWELL_LOG_WARN("UDP sendmmsg failed: " + std::string(strerror(errno)));
+            }
+            break;
+        }
+        sent += static_cast<std::size_t>(n);
+        offset += static_cast<std::size_t>(n) * segment_size;
+    }
+    return sent;
+}
+
+} // anonymous namespace
+
+bool udp_gso_enabled() {
+    return gso_slot().load(std::memory_order_relaxed);
+}
+
+void set_udp_gso_enabled(bool enabled) {
+    gso_slot().store(enabled, std::memory_order_relaxed);
+}
+
+std::size_t udp_send_segments(int fd, std::string_view payload, std::size_t segment_size,
+                              const UdpEndpoint& remote) {
+    if (fd < 0 || payload.empty() || segment_size == 0) {
+        return 0;
+    }
+    if (segment_size >= payload.size() || segment_size > 0xFFFF) {
+        // 只有一段（或段长超出 GSO 可表示范围）时直接逐段发送
+        return send_mmsg_segments(fd, payload, segment_size, remote);
+    }
+
+    // 每次 GSO 发送的段数：受段数上限与单个 UDP 数据报上限约束
+    const std::size_t per_send = std::max<std::size_t>(
+        1, std::min(kMaxGsoSegments, kMaxGsoBytes / segment_size));
+    const std::size_t chunk_bytes = per_send * segment_size;
+
+    std::size_t sent = 0;
+    std::size_t offset = 0;
+    while (offset < payload.size() && udp_gso_enabled()) {
+        std::string_view chunk = payload.substr(offset, chunk_bytes);
+        if (chunk.size() <= segment_size) {
+            break; // 末尾只剩一段：交给回退路径普通发送
+        }
+        int err = 0;
+        ssize_t n = send_gso(fd, chunk, segment_size, remote, &err);
+        if (n < 0) {
+            if (is_gso_rejection(err)) {
+                CHWELL_LOG_WARN("UDP GSO rejected by kernel (" << strerror(err)
+                                << "), falling back to sendmmsg");
+                set_udp_gso_enabled(false);
+                break;
+            }
+            if (err != EAGAIN && err != EWOULDBLOCK) {
+                CHWELL_LOG_WARN("UDP GSO send failed: " << strerror(err));
+            }
+            return sent;
+        }
+        sent += (chunk.size() + segment_size - 1) / segment_size;
+        offset += chunk.size();
+    }
+    if (offset < payload.size()) {
+        sent += send_mmsg_segments(fd, payload.substr(offset), segment_size, remote);
+    }
+    return sent;
+}
+
+bool udp_enable_gro(int fd) {
+    int on = 1;
+    if (::setsockopt(fd, SOL_UDP, UDP_GRO, &on, sizeof(on)) < 0) {
+        CHWELL_LOG_WARN("UDP_GRO unavailable: " << strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+} // namespace net
+} // namespace chwell
@@ -1,76 +1,367 @@
 #include "chwell/net/udp_server.h"
+#include "chwell/net/udp_offload.h"
 #include "chwell/core/logger.h"
+#include "chwell/metrics/event_counter.h"
+#include <algorithm>
 #include <cstring>
+#include <future>
+#include <utility>
+#include <netinet/udp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/timerfd.h>
 
 namespace chwell {
 namespace net {
 
+namespace {
+
+// 单轮可读事件最多执行的 recvmmsg 次数（水平触发，剩余数据下一轮继续）
+const int kMaxBatchesPerRound = 4;
+// 单次 sendmmsg 的最大数据报数
+const std::size_t kMaxSendBatch = 64;
+// GRO 合并后的单次交付最大长度
+const std::size_t kGroSlotSize = 65536;
+// 每个接收槽的 cmsg 空间（UDP_GRO 段大小为 int）
+const std::size_t kGroControlSize = CMSG_SPACE(sizeof(int));
+
+int clamp_sockets(int n) {
+    return n < 1 ? 1 : n;
+}
+
+void pin_current_thread(std::size_t index) {
+    long cpus = ::sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus <= 0) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(static_cast<int>(index % static_cast<std::size_t>(cpus)), &set);
+    int rc = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        CHWELL_LOG_WARN("UdpServer: pin receive thread failed: " << strerror(rc));
+    }
+}
+
+} // anonymous namespace
+
+// 每个 socket 的接收状态：slab 与 mmsghdr 数组一次分配，收包路径不再分配内存
+struct UdpServer::Shard {
+    int fd{-1};
+    EventLoop* loop{nullptr};
+    std::vector<char> slab;
+    std::vector<mmsghdr> headers;
+    std::vector<iovec> iovecs;
+    std::vector<sockaddr_in> addrs;
+    std::vector<char> control;       // 开启 GRO 时每槽的 cmsg 空间
+    std::vector<UdpDatagram> batch;
+    bool gro{false};
+
+    void prepare(std::size_t batch_size, std::size_t slot_size) {
+        slab.resize(batch_size * slot_size);
+        headers.assign(batch_size, mmsghdr{});
+        iovecs.resize(batch_size);
+        addrs.resize(batch_size);
+        if (gro) {
+            control.assign(batch_size * kGroControlSize, 0);
+        }
+        batch.reserve(batch_size);
+        for (std::size_t i = 0; i < batch_size; ++i) {
+            iovecs[i].iov_base = slab.data() + i * slot_size;
+            iovecs[i].iov_len = slot_size;
+            headers[i].msg_hdr.msg_iov = &iovecs[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+            headers[i].msg_hdr.msg_name = &addrs[i];
+        }
+    }
+
+    // 每次 recvmmsg 前重置内核会改写的字段
+    void reset_headers() {
+        for (std::size_t i = 0; i < headers.size(); ++i) {
+            msghdr& hdr = headers[i].msg_hdr;
+            hdr.msg_namelen = sizeof(sockaddr_in);
+            hdr.msg_flags = 0;
+            if (gro) {
+                hdr.msg_control = control.data() + i * kGroControlSize;
+                hdr.msg_controllen = kGroControlSize;
+            }
+        }
+    }
+};
+
+namespace {
+
+// 读取 UDP_GRO cmsg 给出的段大小；未合并时返回 0
+std::size_t gro_segment_size(msghdr& hdr) {
+    for (cmsghdr* cm = CMSG_FIRSTHDR(&hdr); cm != nullptr; cm = CMSG_NXTHDR(&hdr, cm)) {
+        if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO) {
+            int gso_size = 0;
+            std::memcpy(&gso_size, CMSG_DATA(cm), sizeof(gso_size));
+            return gso_size > 0 ? static_cast<std::size_t>(gso_size) : 0;
+        }
+    }
+    return 0;
+}
+
+} // anonymous namespace
+
 UdpServer::UdpServer(IoService& io_service, unsigned short port)
-    : io_service_(io_service), buffer_(65536) {
-    fd_ = socket(AF_INET, SOCK_DGRAM, 0);
-    if (fd_ < 0) return;
+    : UdpServer(io_service, port, UdpServerConfig()) {}
+
+UdpServer::UdpServer(IoService& io_service, unsigned short port, const UdpServerConfig& config)
+    : io_service_(io_service),
+      config_(config),
+      loops_(static_cast<std::size_t>(clamp_sockets(config.num_sockets))) {
+    config_.num_sockets = clamp_sockets(config_.num_sockets);
+    config_.recv_batch = std::max(1, config_.recv_batch);
+    config_.max_datagram_size = std::max<std::size_t>(1, config_.max_datagram_size);
+    if (open_sockets(port)) {
+        CHWELL_LOG_INFO("UdpServer bound to 0.0.0.0:" << port_
+                        << " sockets=" << shards_.size());
+    }
+}
+
+UdpServer::~UdpServer() {
+    stop();
+}
 
-    sockaddr_in addr{};
-    addr.sin_family = AF_INET;
-    addr.sin_addr.s_addr = INADDR_ANY;
-    addr.sin_port = htons(port);
+bool UdpServer::open_sockets(unsigned short port) {
+    const bool reuse_port = config_.num_sockets > 1;
+    port_ = port;
+    for (int i = 0; i < config_.num_sockets; ++i) {
+        int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            CHWELL_LOG_ERROR("UdpServer socket failed: " << strerror(errno));
+            close_sockets();
+            return false;
+        }
+        if (reuse_port) {
+            int on = 1;
+            if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0) {
+                CHWELL_LOG_ERROR("UdpServer SO_REUSEPORT failed: " << strerror(errno));
+                close(fd);
+                close_sockets();
+                return false;
+            }
+        }
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = INADDR_ANY;
+        addr.sin_port = htons(port_);
+        if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            CHWELL_LOG_ERROR("UdpServer bind failed");
+            close(fd);
+            close_sockets();
+            return false;
+        }
+        if (port_ == 0) {
+            // 端口由系统分配时，后续 socket 绑定到同一端口
+            socklen_t len = sizeof(addr);
+            getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+            port_ = ntohs(addr.sin_port);
+        }
+
+        std::unique_ptr<Shard> shard(new Shard());
+        shard->fd = fd;
+        std::size_t slot_size = config_.max_datagram_size;
+        if (config_.enable_gro && udp_enable_gro(fd)) {
+            shard->gro = true;
+            slot_size = std::max(slot_size, kGroSlotSize);
+        }
+        shard->prepare(static_cast<std::size_t>(config_.recv_batch), slot_size);
+        shards_.push_back(std::move(shard));
+    }
+    return true;
+}
 
-    if (bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
-        CHWELL_LOG_ERROR("UdpServer bind failed");
-        close(fd_);
-        fd_ = -1;
-    } else {
-        CHWELL_LOG_INFO("UdpServer bound to 0.0.0.0:" << port);
+void UdpServer::close_sockets() {
+    for (auto& shard : shards_) {
+        if (shard->fd >= 0) {
+            close(shard->fd);
+            shard->fd = -1;
+        }
     }
+    shards_.clear();
 }
 
 void UdpServer::start_receive() {
-    if (fd_ < 0) return;
+    if (shards_.empty() || started_) return;
+    started_ = true;
     stopped_ = false;
-    recv_thread_ = std::thread([this]() { recv_loop(); });
+    loops_.start();
+    for (std::size_t i = 0; i < shards_.size(); ++i) {
+        Shard* shard = shards_[i].get();
+        shard->loop = loops_.get_loop(i);
+        const bool pin = config_.pin_threads;
+        shard->loop->run_in_loop([this, shard, pin, i]() {
+            if (pin) {
+                pin_current_thread(i);
+            }
+            shard->loop->add_fd(shard->fd, EPOLLIN, [this, shard](std::uint32_t) {
+                handle_readable(*shard);
+            });
+            if (i == 0) {
+                start_tick(*shard);
+            }
+        });
+    }
+}
+
+void UdpServer::start_tick(Shard& shard) {
+    if (!tick_cb_ || tick_interval_ms_ <= 0) {
+        return;
+    }
+    tick_fd_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tick_fd_ < 0) {
+        CHWELL_LOG_ERROR("UdpServer timerfd_create failed: " << strerror(errno));
+        return;
+    }
+    itimerspec spec{};
+    spec.it_interval.tv_sec = tick_interval_ms_ / 1000;
+    spec.it_interval.tv_nsec = static_cast<long>(tick_interval_ms_ % 1000) * 1000000L;
+    spec.it_value = spec.it_interval;
+    ::timerfd_settime(tick_fd_, 0, &spec, nullptr);
+    const int fd = tick_fd_;
+    shard.loop->add_fd(fd, EPOLLIN, [this, fd](std::uint32_t) {
+        std::uint64_t expirations = 0;
+        // 错过的多次到期合并为一次回调
+        if (::read(fd, &expirations, sizeof(expirations)) > 0 && !stopped_) {
+            tick_cb_();
+        }
+    });
 }
 
 void UdpServer::stop() {
-    stopped_ = true;
-    if (fd_ >= 0) {
-        shutdown(fd_, SHUT_RDWR);
+    if (stopped_.exchange(true)) {
+        return;
     }
-    if (recv_thread_.joinable()) {
-        recv_thread_.join();
+    if (started_) {
+        for (auto& shard : shards_) {
+            EventLoop* loop = shard->loop;
+            if (!loop || !loop->looping()) {
+                continue;
+            }
+            // 与 loop 线程共享所有权：wait() 返回时 set_value 可能尚未完全退出
+            auto done = std::make_shared<std::promise<void>>();
+            std::future<void> fut = done->get_future();
+            int fd = shard->fd;
+            const bool first = (shard == shards_.front());
+            loop->run_in_loop([this, loop, fd, first, done]() {
+                loop->remove_fd(fd);
+                if (first && tick_fd_ >= 0) {
+                    loop->remove_fd(tick_fd_);
+                }
+                done->set_value();
+            });
+            fut.wait();
+        }
+        loops_.stop();
     }
-    if (fd_ >= 0) {
-        close(fd_);
-        fd_ = -1;
+    if (tick_fd_ >= 0) {
+        close(tick_fd_);
+        tick_fd_ = -1;
     }
+    close_sockets();
 }
 
-void UdpServer::recv_loop() {
-    sockaddr_in remote_addr{};
-    socklen_t addr_len = sizeof(remote_addr);
+void UdpServer::handle_readable(Shard& shard) {
+    const unsigned int batch_size = static_cast<unsigned int>(shard.headers.size());
+    for (int round = 0; round < kMaxBatchesPerRound && !stopped_; ++round) {
+        shard.reset_headers();
+        int n = recvmmsg(shard.fd, shard.headers.data(), batch_size, MSG_DONTWAIT, nullptr);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                CHWELL_LOG_WARN("UDP recv failed: " + std::string(strerror(errno)));
+            }
+            return;
+        }
 
-    while (!stopped_ && fd_ >= 0) {
-        ssize_t n = recvfrom(fd_, buffer_.data(), buffer_.size(), 0,
-                            reinterpret_cast<sockaddr*>(&remote_addr), &addr_len);
-        if (n <= 0) {
-            if (errno == EINTR || errno == EAGAIN) continue;
-            break;
+        shard.batch.clear();
+        std::size_t truncated = 0;
+        for (int i = 0; i < n; ++i) {
+            mmsghdr& hdr = shard.headers[static_cast<std::size_t>(i)];
+            if (hdr.msg_hdr.msg_flags & MSG_TRUNC) {
+                ++truncated;
+                continue;
+            }
+            std::string_view data(static_cast<const char*>(hdr.msg_hdr.msg_iov->iov_base),
+                                  hdr.msg_len);
+            UdpDatagram dgram;
+            dgram.remote.addr_ = shard.addrs[static_cast<std::size_t>(i)];
+            std::size_t segment = shard.gro ? gro_segment_size(hdr.msg_hdr) : 0;
+            if (segment == 0) {
+                segment = data.size();
+            }
+            // GRO 合并的数据报按段切回（末段可能更短）
+            do {
+                dgram.data = data.substr(0, segment);
+                shard.batch.push_back(dgram);
+                data.remove_prefix(dgram.data.size());
+            } while (!data.empty());
+        }
+        if (truncated > 0) {
+            CHWELL_LOG_WARN("UdpServer dropped " << truncated
+                            << " datagram(s) larger than max_datagram_size="
+                            << config_.max_datagram_size);
+            CHWELL_COUNT_EVENT("chwell_net_udp_truncated_total",
+                               "UDP datagrams dropped for exceeding max_datagram_size",
+                               static_cast<double>(truncated));
+        }
+        if (!shard.batch.empty()) {
+            deliver(shard);
+        }
+        if (static_cast<unsigned int>(n) < batch_size) {
+            return; // 已读空
+        }
+    }
+}
+
+void UdpServer::deliver(Shard& shard) {
+    if (batch_cb_) {
+        batch_cb_(shard.batch);
+        return;
+    }
+    if (!message_cb_) {
+        return;
+    }
+    // 兼容消息回调：整批拷贝后只投递一次
+    std::vector<std::pair<std::vector<char>, UdpEndpoint>> packets;
+    packets.reserve(shard.batch.size());
+    for (const UdpDatagram& dgram : shard.batch) {
+        packets.emplace_back(std::vector<char>(dgram.data.begin(), dgram.data.end()),
+                             dgram.remote);
+    }
+    io_service_.post([this, packets = std::move(packets)]() {
+        for (const auto& packet : packets) {
+            message_cb_(packet.first, packet.second);
         }
+    });
+}
 
-        UdpEndpoint remote;
-        remote.addr_ = remote_addr;
+std::size_t UdpServer::send_segments(std::string_view payload, std::size_t segment_size,
+                                     const UdpEndpoint& remote) {
+    return udp_send_segments(send_fd(), payload, segment_size, remote);
+}
 
-        std::vector<char> data(buffer_.begin(), buffer_.begin() + n);
-        if (message_cb_) {
-            io_service_.post([this, data, remote]() {
-                message_cb_(data, remote);
-            });
+int UdpServer::send_fd() const {
+    for (const auto& shard : shards_) {
+        if (shard->loop && shard->loop->is_in_loop_thread()) {
+            return shard->fd;
         }
     }
+    return shards_.empty() ? -1 : shards_.front()->fd;
 }
 
 void UdpServer::send_to(const std::vector<char>& data, const UdpEndpoint& remote) {
-    if (fd_ < 0 || data.empty()) return;
-    ssize_t n = ::sendto(fd_, data.data(), data.size(), 0,
+    send_to(std::string_view(data.data(), data.size()), remote);
+}
+
+void UdpServer::send_to(std::string_view data, const UdpEndpoint& remote) {
+    int fd = send_fd();
+    if (fd < 0 || data.empty()) return;
+    ssize_t n = ::sendto(fd, data.data(), data.size(), 0,
                          reinterpret_cast<const sockaddr*>(&remote.addr_),
                          sizeof(remote.addr_));
     if (n < 0) {
@@ -78,5 +369,42 @@ void UdpServer::send_to(const std::vector<char>& data, const UdpEndpoint& remote
     }
 }
 
+std::size_t UdpServer::send_batch(const std::vector<UdpDatagram>& datagrams) {
+    int fd = send_fd();
+    if (fd < 0) return 0;
+
+    mmsghdr headers[kMaxSendBatch];
+    iovec iovecs[kMaxSendBatch];
+    std::size_t sent = 0;
+    while (sent < datagrams.size()) {
+        std::size_t chunk = std::min(kMaxSendBatch, datagrams.size() - sent);
+        for (std::size_t i = 0; i < chunk; ++i) {
+            const UdpDatagram& dgram = datagrams[sent + i];
+            iovecs[i].iov_base = const_cast<char*>(dgram.data.data());
+            iovecs[i].iov_len = dgram.data.size();
+            headers[i] = mmsghdr{};
+            headers[i].msg_hdr.msg_name = const_cast<sockaddr_in*>(&dgram.remote.addr_);
+            headers[i].msg_hdr.msg_namelen = sizeof(dgram.remote.addr_);
+            headers[i].msg_hdr.msg_iov = &iovecs[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+        int n = ::sendmmsg(fd, headers, static_cast<unsigned int>(chunk), MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                CHWELL_LOG_WARN("UDP sendmmsg failed: " + std::string(strerror(errno)));
+            }
+            break;
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+    if (sent < datagrams.size()) {
+        CHWELL_COUNT_EVENT("chwell_net_udp_send_dropped_total",
+                           "UDP datagrams not accepted by the kernel in send_batch",
+                           static_cast<double>(datagrams.size() - sent));
+    }
+    return sent;
+}
+
 } // namespace net
 } // namespace chwell
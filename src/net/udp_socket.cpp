@@ -1,4 +1,5 @@
 #include "chwell/net/udp_socket.h"
+#include "chwell/net/udp_offload.h"
 #include "chwell/core/logger.h"
 
 #include <sys/socket.h>
@@ -44,6 +45,18 @@ void UdpSocket::send_to(const std::string& host, uint16_t port, const std::strin
     }
 }
 
+std::size_t UdpSocket::send_segments(const std::string& host, uint16_t port,
+                                     std::string_view payload, std::size_t segment_size) {
+    UdpEndpoint remote;
+    remote.addr_.sin_family = AF_INET;
+    remote.addr_.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &remote.addr_.sin_addr) <= 0) {
+        CHWELL_LOG_ERROR("Invalid host address: " + host);
+        return 0;
+    }
+    return udp_send_segments(fd_, payload, segment_size, remote);
+}
+
 void UdpSocket::close() {
     if (fd_ >= 0) {
         ::close(fd_);
@@ -0,0 +1,572 @@
+#include "chwell/net/ws_codec.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define CHWELL_WS_X86 1
+#endif
+
+namespace chwell {
+namespace net {
+
+const std::size_t WsDecoder::kDefaultMaxMessageSize;
+
+namespace {
+
+const char* const kWsGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+// 控制帧载荷上限（RFC 6455 5.5）
+const std::uint64_t kMaxControlPayload = 125;
+
+// ---------------------------------------------------------------------------
+// SHA-1（仅用于握手，避免核心库依赖 OpenSSL）
+// ---------------------------------------------------------------------------
+
+inline std::uint32_t rotl(std::uint32_t v, int n) {
+    return (v << n) | (v >> (32 - n));
+}
+
+void sha1(std::string_view input, unsigned char digest[20]) {
+    std::uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+    std::string msg(input);
+    const std::uint64_t bit_len = static_cast<std::uint64_t>(input.size()) * 8;
+    msg.push_back(static_cast<char>(0x80));
+    while (msg.size() % 64 != 56) {
+        msg.push_back('\0');
+    }
+    for (int i = 7; i >= 0; --i) {
+        msg.push_back(static_cast<char>((bit_len >> (i * 8)) & 0xff));
+    }
+
+    for (std::size_t chunk = 0; chunk < msg.size(); chunk += 64) {
+        std::uint32_t w[80];
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(msg.data() + chunk);
+        for (int i = 0; i < 16; ++i) {
+            w[i] = (static_cast<std::uint32_t>(p[i * 4]) << 24) |
+                   (static_cast<std::uint32_t>(p[i * 4 + 1]) << 16) |
+                   (static_cast<std::uint32_t>(p[i * 4 + 2]) << 8) |
+                   static_cast<std::uint32_t>(p[i * 4 + 3]);
+        }
+        for (int i = 16; i < 80; ++i) {
+            w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+        std::uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; ++i) {
+            std::uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            std::uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotl(b, 30);
+            b = a;
+            a = temp;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+
+    for (int i = 0; i < 5; ++i) {
+        digest[i * 4] = static_cast<unsigned char>(h[i] >> 24);
+        digest[i * 4 + 1] = static_cast<unsigned char>(h[i] >> 16);
+        digest[i * 4 + 2] = static_cast<unsigned char>(h[i] >> 8);
+        digest[i * 4 + 3] = static_cast<unsigned char>(h[i]);
+    }
+}
+
+std::string base64_encode(const unsigned char* data, std::size_t len) {
+    static const char* kTable = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((len + 2) / 3 * 4);
+    for (std::size_t i = 0; i < len; i += 3) {
+        const unsigned int c0 = data[i];
+        const unsigned int c1 = (i + 1 < len) ? data[i + 1] : 0;
+        const unsigned int c2 = (i + 2 < len) ? data[i + 2] : 0;
+        out.push_back(kTable[c0 >> 2]);
+        out.push_back(kTable[((c0 & 0x03) << 4) | (c1 >> 4)]);
+        out.push_back(i + 1 < len ? kTable[((c1 & 0x0F) << 2) | (c2 >> 6)] : '=');
+        out.push_back(i + 2 < len ? kTable[c2 & 0x3F] : '=');
+    }
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// 握手请求头解析
+// ---------------------------------------------------------------------------
+
+bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) !=
+            std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 逗号分隔的头部值中是否含有 token（不区分大小写），如 "keep-alive, Upgrade"
+bool has_token(std::string_view value, std::string_view token) {
+    while (!value.empty()) {
+        std::size_t comma = value.find(',');
+        std::string_view item = value.substr(0, comma);
+        while (!item.empty() && item.front() == ' ') item.remove_prefix(1);
+        while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) item.remove_suffix(1);
+        if (iequals(item, token)) return true;
+        if (comma == std::string_view::npos) break;
+        value.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+    return s;
+}
+
+// ---------------------------------------------------------------------------
+// 掩码
+// ---------------------------------------------------------------------------
+
+// 把 4 字节掩码按相位旋转后复制为 8 字节
+inline std::uint64_t mask_word(const std::uint8_t mask[4], std::size_t offset) {
+    std::uint8_t rotated[8];
+    for (int i = 0; i < 8; ++i) {
+        rotated[i] = mask[(offset + static_cast<std::size_t>(i)) & 3];
+    }
+    std::uint64_t word;
+    std::memcpy(&word, rotated, sizeof(word));
+    return word;
+}
+
+// 8 字节一组的通用实现，也用于 SIMD 路径的尾部
+void mask_copy_scalar(char* dst, const char* src, std::size_t len, std::uint64_t word) {
+    std::size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        std::uint64_t v;
+        std::memcpy(&v, src + i, sizeof(v));
+        v ^= word;
+        std::memcpy(dst + i, &v, sizeof(v));
+    }
+    const unsigned char* w = reinterpret_cast<const unsigned char*>(&word);
+    for (std::size_t j = 0; i < len; ++i, ++j) {
+        dst[i] = static_cast<char>(src[i] ^ w[j]);
+    }
+}
+
+#ifdef CHWELL_WS_X86
+
+// 32 / 16 均为 4 的倍数，每个块起始相位不变，整条载荷共用同一个掩码向量
+void mask_copy_sse2(char* dst, const char* src, std::size_t len, std::uint64_t word) {
+    const __m128i m = _mm_set1_epi64x(static_cast<long long>(word));
+    std::size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(v, m));
+    }
+    mask_copy_scalar(dst + i, src + i, len - i, word);
+}
+
+__attribute__((target("avx2")))
+void mask_copy_avx2(char* dst, const char* src, std::size_t len, std::uint64_t word) {
+    const __m256i m = _mm256_set1_epi64x(static_cast<long long>(word));
+    std::size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_xor_si256(v, m));
+    }
+    mask_copy_sse2(dst + i, src + i, len - i, word);
+}
+
+bool cpu_has_avx2() {
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+}
+
+#endif // CHWELL_WS_X86
+
+inline std::uint16_t read_be16(const char* p) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<std::uint16_t>((u[0] << 8) | u[1]);
+}
+
+inline std::uint64_t read_be64(const char* p) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    std::uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) {
+        v = (v << 8) | u[i];
+    }
+    return v;
+}
+
+inline bool is_control(WsOpcode op) {
+    return (static_cast<std::uint8_t>(op) & 0x8) != 0;
+}
+
+} // anonymous namespace
+
+long parse_ws_handshake(std::string_view data, WsHandshakeRequest* out, std::size_t max_size) {
+    const std::size_t end = data.find("\r\n\r\n");
+    if (end == std::string_view::npos) {
+        return data.size() > max_size ? -1 : 0;
+    }
+    const std::size_t total = end + 4;
+    if (total > max_size) {
+        return -1;
+    }
+
+    std::string_view head = data.substr(0, end + 2);
+    std::size_t line_end = head.find("\r\n");
+    std::string_view request_line = head.substr(0, line_end);
+    head.remove_prefix(line_end + 2);
+
+    // 请求行：GET <path> HTTP/1.1
+    std::size_t sp1 = request_line.find(' ');
+    std::size_t sp2 = request_line.rfind(' ');
+    if (sp1 == std::string_view::npos || sp2 == sp1) {
+        return -1;
+    }
+    WsHandshakeRequest req;
+    req.method.assign(request_line.substr(0, sp1));
+    req.path.assign(request_line.substr(sp1 + 1, sp2 - sp1 - 1));
+    if (req.method != "GET" || request_line.substr(sp2 + 1) != "HTTP/1.1") {
+        return -1;
+    }
+
+    bool upgrade = false;
+    bool connection_upgrade = false;
+    while (!head.empty()) {
+        line_end = head.find("\r\n");
+        std::string_view line = head.substr(0, line_end);
+        head.remove_prefix(line_end + 2);
+        std::size_t colon = line.find(':');
+        if (colon == std::string_view::npos) {
+            continue;
+        }
+        std::string_view name = trim(line.substr(0, colon));
+        std::string_view value = trim(line.substr(colon + 1));
+        if (iequals(name, "Host")) {
+            req.host.assign(value);
+        } else if (iequals(name, "Upgrade")) {
+            upgrade = has_token(value, "websocket");
+        } else if (iequals(name, "Connection")) {
+            connection_upgrade = has_token(value, "upgrade");
+        } else if (iequals(name, "Sec-WebSocket-Key")) {
+            req.key.assign(value);
+        } else if (iequals(name, "Sec-WebSocket-Version")) {
+            req.version.assign(value);
+        } else if (iequals(name, "Sec-WebSocket-Protocol")) {
+            req.protocols.assign(value);
+        } else if (iequals(name, "Sec-WebSocket-Extensions")) {
+            req.extensions.assign(value);
+        }
+    }
+
+    if (!upgrade || !connection_upgrade || req.key.empty() || req.version != "13") {
+        return -1;
+    }
+    *out = std::move(req);
+    return static_cast<long>(total);
+}
+
+std::string ws_accept_key(std::string_view key) {
+    std::string input(key);
+    input += kWsGuid;
+    unsigned char digest[20];
+    sha1(input, digest);
+    return base64_encode(digest, sizeof(digest));
+}
+
+std::string ws_handshake_response(const WsHandshakeRequest& request, std::string_view protocol,
+                                  std::string_view extensions) {
+    std::string response =
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Accept: ";
+    response += ws_accept_key(request.key);
+    response += "\r\n";
+    if (!protocol.empty()) {
+        response += "Sec-WebSocket-Protocol: ";
+        response.append(protocol.data(), protocol.size());
+        response += "\r\n";
+    }
+    if (!extensions.empty()) {
+        response += "Sec-WebSocket-Extensions: ";
+        response.append(extensions.data(), extensions.size());
+        response += "\r\n";
+    }
+    response += "\r\n";
+    return response;
+}
+
+std::string ws_handshake_reject() {
+    return "HTTP/1.1 400 Bad Request\r\n"
+           "Connection: close\r\n"
+           "Content-Length: 0\r\n\r\n";
+}
+
+std::string ws_client_handshake(std::string_view host, std::string_view path, std::string_view key,
+                                std::string_view extensions) {
+    std::string request = "GET ";
+    request.append(path.data(), path.size());
+    request += " HTTP/1.1\r\nHost: ";
+    request.append(host.data(), host.size());
+    request += "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: ";
+    request.append(key.data(), key.size());
+    request += "\r\nSec-WebSocket-Version: 13\r\n";
+    if (!extensions.empty()) {
+        request += "Sec-WebSocket-Extensions: ";
+        request.append(extensions.data(), extensions.size());
+        request += "\r\n";
+    }
+    request += "\r\n";
+    return request;
+}
+
+void ws_mask_copy(char* dst, const char* src, std::size_t len,
+                  const std::uint8_t mask[4], std::size_t offset) {
+    const std::uint64_t word = mask_word(mask, offset);
+#ifdef CHWELL_WS_X86
+    if (len >= 32 && cpu_has_avx2()) {
+        mask_copy_avx2(dst, src, len, word);
+        return;
+    }
+    mask_copy_sse2(dst, src, len, word);
+#else
+    mask_copy_scalar(dst, src, len, word);
+#endif
+}
+
+std::size_t ws_encode_header(char* out, WsOpcode opcode, std::uint64_t payload_len,
+                             bool fin, const std::uint8_t* mask, bool rsv1) {
+    unsigned char* p = reinterpret_cast<unsigned char*>(out);
+    p[0] = static_cast<unsigned char>((fin ? 0x80 : 0x00) | (rsv1 ? 0x40 : 0x00) |
+                                      static_cast<std::uint8_t>(opcode));
+    const unsigned char mask_bit = mask ? 0x80 : 0x00;
+    std::size_t n = 2;
+    if (payload_len < 126) {
+        p[1] = static_cast<unsigned char>(mask_bit | payload_len);
+    } else if (payload_len <= 0xFFFF) {
+        p[1] = static_cast<unsigned char>(mask_bit | 126);
+        p[2] = static_cast<unsigned char>(payload_len >> 8);
+        p[3] = static_cast<unsigned char>(payload_len & 0xff);
+        n = 4;
+    } else {
+        p[1] = static_cast<unsigned char>(mask_bit | 127);
+        for (int i = 0; i < 8; ++i) {
+            p[2 + i] = static_cast<unsigned char>((payload_len >> ((7 - i) * 8)) & 0xff);
+        }
+        n = 10;
+    }
+    if (mask) {
+        std::memcpy(p + n, mask, 4);
+        n += 4;
+    }
+    return n;
+}
+
+std::string ws_encode_frame(WsOpcode opcode, std::string_view payload, bool fin,
+                            const std::uint8_t* mask) {
+    char header[kWsMaxHeaderSize];
+    const std::size_t header_len = ws_encode_header(header, opcode, payload.size(), fin, mask);
+    std::string frame(header_len + payload.size(), '\0');
+    std::memcpy(&frame[0], header, header_len);
+    if (mask) {
+        ws_mask_copy(&frame[header_len], payload.data(), payload.size(), mask);
+    } else if (!payload.empty()) {
+        std::memcpy(&frame[header_len], payload.data(), payload.size());
+    }
+    return frame;
+}
+
+std::string ws_close_payload(std::uint16_t code, std::string_view reason) {
+    std::string payload;
+    payload.push_back(static_cast<char>(code >> 8));
+    payload.push_back(static_cast<char>(code & 0xff));
+    // 控制帧载荷上限 125 字节
+    payload.append(reason.data(), std::min<std::size_t>(reason.size(), kMaxControlPayload - 2));
+    return payload;
+}
+
+// ---------------------------------------------------------------------------
+// WsDecoder
+// ---------------------------------------------------------------------------
+
+WsDecoder::WsDecoder(bool require_mask, std::size_t max_message_size)
+    : require_mask_(require_mask),
+      max_message_size_(max_message_size) {}
+
+bool WsDecoder::fail(std::uint16_t code) {
+    close_code_ = code;
+    return false;
+}
+
+void WsDecoder::shrink() {
+    if (!in_message_) {
+        std::string().swap(message_);
+    }
+    std::string().swap(control_);
+}
+
+bool WsDecoder::begin_frame() {
+    const unsigned char b0 = static_cast<unsigned char>(header_[0]);
+    fin_ = (b0 & 0x80) != 0;
+    const bool rsv1 = (b0 & 0x40) != 0;
+    if ((b0 & 0x30) || (rsv1 && !allow_compressed_)) {
+        return fail(ws_close::kProtocolError);  // 未协商扩展时保留位必须为 0
+    }
+    opcode_ = static_cast<WsOpcode>(b0 & 0x0f);
+    // RSV1 只能出现在数据消息的首帧（RFC 7692 6.1）
+    if (rsv1 && (is_control(opcode_) || opcode_ == WsOpcode::kContinuation)) {
+        return fail(ws_close::kProtocolError);
+    }
+    switch (opcode_) {
+    case WsOpcode::kContinuation:
+    case WsOpcode::kText:
+    case WsOpcode::kBinary:
+    case WsOpcode::kClose:
+    case WsOpcode::kPing:
+    case WsOpcode::kPong:
+        break;
+    default:
+        return fail(ws_close::kProtocolError);
+    }
+
+    if (is_control(opcode_)) {
+        if (!fin_ || payload_len_ > kMaxControlPayload) {
+            return fail(ws_close::kProtocolError);
+        }
+        control_.clear();
+    } else if (opcode_ == WsOpcode::kContinuation) {
+        if (!in_message_) {
+            return fail(ws_close::kProtocolError);
+        }
+    } else {
+        if (in_message_) {
+            return fail(ws_close::kProtocolError);  // 上一条分片消息尚未结束
+        }
+        in_message_ = true;
+        message_opcode_ = opcode_;
+        message_compressed_ = rsv1;
+        message_.clear();
+    }
+
+    if (!is_control(opcode_) && message_.size() + payload_len_ > max_message_size_) {
+        return fail(ws_close::kMessageTooBig);
+    }
+    if (!is_control(opcode_)) {
+        message_.reserve(message_.size() + static_cast<std::size_t>(payload_len_));
+    }
+    payload_read_ = 0;
+    in_payload_ = true;
+    return true;
+}
+
+void WsDecoder::finish_frame(const FrameCallback& cb) {
+    in_payload_ = false;
+    header_len_ = 0;
+    header_need_ = 2;
+    if (is_control(opcode_)) {
+        cb(opcode_, control_);
+        return;
+    }
+    if (fin_) {
+        in_message_ = false;
+        cb(message_opcode_, message_);
+        message_.clear();
+    }
+}
+
+bool WsDecoder::feed(std::string_view data, const FrameCallback& cb) {
+    if (failed()) {
+        return false;
+    }
+    while (!data.empty() || (in_payload_ && payload_read_ == payload_len_)) {
+        if (!in_payload_) {
+            // 帧头：先收 2 字节，得知扩展长度与掩码后再收齐
+            std::size_t take = std::min(header_need_ - header_len_, data.size());
+            std::memcpy(header_ + header_len_, data.data(), take);
+            header_len_ += take;
+            data.remove_prefix(take);
+            if (header_len_ < header_need_) {
+                return true;
+            }
+            if (header_need_ == 2) {
+                const unsigned char b1 = static_cast<unsigned char>(header_[1]);
+                masked_ = (b1 & 0x80) != 0;
+                if (require_mask_ && !masked_) {
+                    return fail(ws_close::kProtocolError);
+                }
+                const unsigned char len7 = b1 & 0x7f;
+                header_need_ = 2 + (len7 == 126 ? 2 : (len7 == 127 ? 8 : 0)) + (masked_ ? 4 : 0);
+                if (header_need_ > 2) {
+                    continue;
+                }
+            }
+            const unsigned char len7 = static_cast<unsigned char>(header_[1]) & 0x7f;
+            std::size_t pos = 2;
+            if (len7 == 126) {
+                payload_len_ = read_be16(header_ + 2);
+                pos = 4;
+            } else if (len7 == 127) {
+                payload_len_ = read_be64(header_ + 2);
+                pos = 10;
+                if (payload_len_ >> 63) {
+                    return fail(ws_close::kProtocolError);
+                }
+            } else {
+                payload_len_ = len7;
+            }
+            if (masked_) {
+                std::memcpy(mask_, header_ + pos, 4);
+            }
+            if (!begin_frame()) {
+                return false;
+            }
+            continue;
+        }
+
+        // 载荷：去掩码与拷贝一次完成，写入消息 / 控制帧缓冲
+        const std::size_t take = static_cast<std::size_t>(
+            std::min<std::uint64_t>(payload_len_ - payload_read_, data.size()));
+        if (take > 0) {
+            std::string& dst = is_control(opcode_) ? control_ : message_;
+            const std::size_t old_size = dst.size();
+            dst.resize(old_size + take);
+            if (masked_) {
+                ws_mask_copy(&dst[old_size], data.data(), take, mask_,
+                             static_cast<std::size_t>(payload_read_));
+            } else {
+                std::memcpy(&dst[old_size], data.data(), take);
+            }
+            payload_read_ += take;
+            data.remove_prefix(take);
+        }
+        if (payload_read_ == payload_len_) {
+            finish_frame(cb);
+        }
+    }
+    return true;
+}
+
+} // namespace net
+} // namespace chwell
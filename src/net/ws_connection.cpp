@@ -1,77 +1,284 @@
 #include "chwell/net/ws_connection.h"
 #include "chwell/core/logger.h"
-#include <cerrno>
+#include "chwell/metrics/event_counter.h"
+
+#include <algorithm>
 
 namespace chwell {
 namespace net {
 
-WsConnection::WsConnection(TcpSocket socket)
-    : socket_(std::move(socket)), read_buffer_(4096) {
+namespace {
+
+const WsConnectionCallbacksPtr& empty_ws_callbacks() {
+    static const WsConnectionCallbacksPtr empty = std::make_shared<WsConnectionCallbacks>();
+    return empty;
 }
 
-void WsConnection::start() {
-    run_read_loop();
+} // anonymous namespace
+
+WsConnection::WsConnection(TcpConnectionPtr conn, std::size_t max_message_size)
+    : conn_(std::move(conn)),
+      decoder_(true, max_message_size),
+      callbacks_(empty_ws_callbacks()) {
 }
 
-void WsConnection::run_read_loop() {
-    while (!closed_ && socket_.is_open()) {
-        ssize_t n = socket_.read(read_buffer_.data(), read_buffer_.size());
-        if (n <= 0) {
-            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
-                CHWELL_LOG_WARN("WsConnection read error: " + std::string(strerror(errno)));
+WsConnectionCallbacks& WsConnection::own_callbacks() {
+    if (callbacks_.use_count() != 1) {
+        callbacks_ = std::make_shared<WsConnectionCallbacks>(*callbacks_);
+    }
+    return *callbacks_;
+}
+
+void WsConnection::set_callbacks(const WsConnectionCallbacksPtr& cbs) {
+    callbacks_ = cbs ? cbs : empty_ws_callbacks();
+}
+
+const ConnectionCallbacksPtr& WsConnection::tcp_callbacks() {
+    static const ConnectionCallbacksPtr callbacks = []() {
+        auto owner = [](const TcpConnectionPtr& c) {
+            return std::static_pointer_cast<WsConnection>(c->context().lock());
+        };
+        auto cbs = std::make_shared<ConnectionCallbacks>();
+        cbs->message = [owner](const TcpConnectionPtr& c, std::string_view data) {
+            if (WsConnectionPtr self = owner(c)) {
+                self->handle_data(data);
+            }
+        };
+        cbs->close = [owner](const TcpConnectionPtr& c) {
+            if (WsConnectionPtr self = owner(c)) {
+                self->closed_ = true;
+                self->state_ = State::kClosed;
+                if (self->callbacks_->close) {
+                    self->callbacks_->close(self);
+                }
+            }
+        };
+        cbs->high_watermark = [owner](const TcpConnectionPtr& c, std::size_t bytes) {
+            WsConnectionPtr self = owner(c);
+            if (self && self->callbacks_->high_watermark) {
+                self->callbacks_->high_watermark(self, bytes);
+            }
+        };
+        cbs->low_watermark = [owner](const TcpConnectionPtr& c, std::size_t bytes) {
+            WsConnectionPtr self = owner(c);
+            if (self && self->callbacks_->low_watermark) {
+                self->callbacks_->low_watermark(self, bytes);
             }
-            break;
+        };
+        return cbs;
+    }();
+    return callbacks;
+}
+
+void WsConnection::start() {
+    // 底层连接只持有弱引用，WsConnection 的生命周期由 WsServer 管理
+    conn_->set_context(std::weak_ptr<void>(shared_from_this()));
+    conn_->set_callbacks(tcp_callbacks());
+    conn_->start();
+}
+
+void WsConnection::handle_data(std::string_view data) {
+    if (state_ == State::kHandshake) {
+        handle_handshake(data);
+        return;
+    }
+    if (state_ != State::kOpen) {
+        return;
+    }
+    if (!decoder_.feed(data, [this](WsOpcode opcode, std::string_view payload) {
+            handle_frame(opcode, payload);
+        })) {
+        CHWELL_LOG_WARN("WebSocket protocol error, closing with code " << decoder_.close_code());
+        shutdown(decoder_.close_code(), std::string_view());
+    }
+}
+
+void WsConnection::handle_handshake(std::string_view data) {
+    // 请求头通常一次读完，此时不经 handshake_buffer_ 中转
+    std::string_view request = data;
+    if (!handshake_buffer_.empty()) {
+        handshake_buffer_.append(data.data(), data.size());
+        request = handshake_buffer_;
+    }
+    long consumed = parse_ws_handshake(request, &request_);
+    if (consumed == 0) {
+        if (handshake_buffer_.empty()) {
+            handshake_buffer_.assign(data.data(), data.size());
         }
+        return;
+    }
+    if (consumed < 0) {
+        CHWELL_LOG_WARN("WebSocket handshake rejected, fd: " << conn_->native_handle());
+        state_ = State::kClosed;
+        closed_ = true;
+        conn_->send(ws_handshake_reject());
+        conn_->close();
+        return;
+    }
+
+    std::string extensions;
+    if (negotiate_ws_deflate(request_.extensions, deflate_config_, &deflate_params_)) {
+        deflate_ = true;
+        decoder_.set_allow_compressed(true);
+        extensions = format_ws_deflate_response(deflate_params_);
+    }
+    conn_->send(ws_handshake_response(request_, std::string_view(), extensions));
+    state_ = State::kOpen;
+    // 请求头之后紧跟的帧数据（客户端未等 101 就发送）
+    std::string rest(request.substr(static_cast<std::size_t>(consumed)));
+    std::string().swap(handshake_buffer_);
+    if (callbacks_->open) {
+        callbacks_->open(shared_from_this());
+    }
+    if (!rest.empty()) {
+        handle_data(rest);
+    }
+}
 
-        std::string text(read_buffer_.begin(), read_buffer_.begin() + n);
-        if (message_cb_) {
-            message_cb_(shared_from_this(), text);
+void WsConnection::handle_frame(WsOpcode opcode, std::string_view payload) {
+    switch (opcode) {
+    case WsOpcode::kText:
+    case WsOpcode::kBinary:
+        deliver(opcode, payload);
+        break;
+    case WsOpcode::kPing:
+        send_frame(WsOpcode::kPong, payload);
+        break;
+    case WsOpcode::kPong:
+        break;
+    case WsOpcode::kClose: {
+        // 回显对端的关闭码（无关闭码时按 1000 回复）
+        std::uint16_t code = ws_close::kNormal;
+        if (payload.size() >= 2) {
+            code = static_cast<std::uint16_t>(
+                (static_cast<unsigned char>(payload[0]) << 8) | static_cast<unsigned char>(payload[1]));
+        } else if (payload.size() == 1) {
+            code = ws_close::kProtocolError;
         }
+        shutdown(code, std::string_view());
+        break;
     }
+    default:
+        break;
+    }
+}
 
-    closed_ = true;
-    if (close_cb_) {
-        close_cb_(shared_from_this());
+void WsConnection::deliver(WsOpcode opcode, std::string_view payload) {
+    if (state_ != State::kOpen) {
+        return;
+    }
+    if (decoder_.message_compressed()) {
+        if (!inflater_) {
+            inflater_.reset(new WsInflater(15, deflate_params_.client_no_context_takeover));
+        }
+        int ret = inflater_->decompress(payload, &inflated_, deflate_config_.max_inflated_size);
+        if (ret != 0) {
+            CHWELL_LOG_WARN("WebSocket inflate failed (" << ret << "), fd: " << conn_->native_handle());
+            shutdown(ret == -2 ? ws_close::kMessageTooBig : ws_close::kInvalidPayload, std::string_view());
+            return;
+        }
+        payload = inflated_;
+    }
+    if (callbacks_->message) {
+        message_opcode_ = opcode;
+        callbacks_->message(shared_from_this(), payload);
     }
 }
 
-void WsConnection::send_text(const std::string& text) {
+bool WsConnection::send_compressed(WsOpcode opcode, std::string_view payload) {
     std::lock_guard<std::mutex> lock(send_mutex_);
-    if (closed_ || !socket_.is_open()) return;
-    const char* ptr = text.data();
-    std::size_t len = text.size();
-    while (len > 0) {
-        ssize_t n = socket_.write(ptr, len);
-        if (n <= 0) {
-            CHWELL_LOG_WARN("WsConnection send failed: " + std::string(strerror(errno)));
-            return;
+    // 共享压缩器只在对端同意不保留滑动窗口、且其窗口不大于协商上限时可用
+    const bool use_shared = shared_deflater_ && deflate_params_.server_no_context_takeover &&
+                            deflate_config_.server_max_window_bits <= deflate_params_.server_max_window_bits;
+    bool ok;
+    if (use_shared) {
+        ok = shared_deflater_->compress(payload, &deflate_buffer_);
+    } else {
+        if (!deflater_) {
+            int bits = std::min(deflate_config_.server_max_window_bits, deflate_params_.server_max_window_bits);
+            deflater_.reset(new WsDeflater(deflate_config_.level, bits, deflate_config_.mem_level,
+                                           deflate_params_.server_no_context_takeover));
         }
-        ptr += n;
-        len -= static_cast<std::size_t>(n);
+        ok = deflater_->compress(payload, &deflate_buffer_);
     }
+    if (!ok || deflate_buffer_.size() >= payload.size()) {
+        // 对端窗口只包含压缩消息：原文发送的内容不能再被后续压缩消息引用
+        if (deflater_ && !use_shared) {
+            deflater_->reset();
+        }
+        return false;
+    }
+    char header[kWsMaxHeaderSize];
+    const std::size_t header_len = ws_encode_header(header, opcode, deflate_buffer_.size(), true, nullptr, true);
+    conn_->send(std::string_view(header, header_len), deflate_buffer_);
+    CHWELL_COUNT_EVENT("chwell_net_ws_deflate_input_bytes_total",
+                       "WebSocket payload bytes before permessage-deflate", static_cast<double>(payload.size()));
+    CHWELL_COUNT_EVENT("chwell_net_ws_deflate_output_bytes_total",
+                       "WebSocket payload bytes after permessage-deflate", static_cast<double>(deflate_buffer_.size()));
+    return true;
+}
+
+void WsConnection::send_frame(WsOpcode opcode, std::string_view payload) {
+    if (deflate_ && (opcode == WsOpcode::kText || opcode == WsOpcode::kBinary) &&
+        payload.size() >= deflate_config_.min_size && send_compressed(opcode, payload)) {
+        return;
+    }
+    char header[kWsMaxHeaderSize];
+    const std::size_t header_len = ws_encode_header(header, opcode, payload.size());
+    conn_->send(std::string_view(header, header_len), payload);
+}
+
+void WsConnection::send_text(std::string_view text) {
+    if (closed_ || state_ != State::kOpen) return;
+    send_frame(WsOpcode::kText, text);
+}
+
+void WsConnection::send_binary(std::string_view data) {
+    if (closed_ || state_ != State::kOpen) return;
+    send_frame(WsOpcode::kBinary, data);
 }
 
 void WsConnection::send_binary(const std::vector<char>& data) {
-    std::lock_guard<std::mutex> lock(send_mutex_);
-    if (closed_ || !socket_.is_open()) return;
-    const char* ptr = data.data();
-    std::size_t len = data.size();
-    while (len > 0) {
-        ssize_t n = socket_.write(ptr, len);
-        if (n <= 0) {
-            CHWELL_LOG_WARN("WsConnection send_binary failed: " + std::string(strerror(errno)));
-            return;
+    send_binary(std::string_view(data.data(), data.size()));
+}
+
+void WsConnection::send_prepared(const WsPreparedMessage& message) {
+    if (closed_ || state_ != State::kOpen) return;
+    if (deflate_ && !message.deflated.empty() &&
+        message.window_bits <= deflate_params_.server_max_window_bits) {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        // 对端窗口中插入了本连接压缩器不知道的内容，之后的消息不能再引用此前的窗口
+        if (deflater_) {
+            deflater_->reset();
         }
-        ptr += n;
-        len -= static_cast<std::size_t>(n);
+        conn_->send(message.deflated);
+        return;
+    }
+    conn_->send(message.plain);
+}
+
+void WsConnection::ping(std::string_view payload) {
+    if (closed_ || state_ != State::kOpen) return;
+    send_frame(WsOpcode::kPing, payload.substr(0, 125));
+}
+
+void WsConnection::shutdown(std::uint16_t code, std::string_view reason) {
+    if (closed_.exchange(true)) return;
+    if (state_ == State::kOpen) {
+        send_frame(WsOpcode::kClose, ws_close_payload(code, reason));
     }
+    state_ = State::kClosed;
+    conn_->close();
 }
 
-void WsConnection::close() {
-    closed_ = true;
-    ErrorCode ec;
-    socket_.shutdown(SHUT_RDWR, ec);
-    socket_.close(ec);
+void WsConnection::close(std::uint16_t code, std::string_view reason) {
+    shutdown(code, reason);
+}
+
+void ws_broadcast(const std::vector<WsConnectionPtr>& group, const WsPreparedMessage& message) {
+    for (const WsConnectionPtr& conn : group) {
+        conn->send_prepared(message);
+    }
 }
 
 } // namespace net
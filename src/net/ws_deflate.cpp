@@ -0,0 +1,353 @@
+#include "chwell/net/ws_deflate.h"
+#include "chwell/core/logger.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#ifdef CHWELL_USE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace chwell {
+namespace net {
+
+namespace {
+
+// 每条压缩消息结尾由 Z_SYNC_FLUSH 产生、按 RFC 7692 去掉 / 补回的空存储块
+const char kDeflateTail[4] = {'\x00', '\x00', '\xff', '\xff'};
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+// 解析窗口位数参数值（可带引号），合法范围 8~15；无值返回 0，非法返回 -1
+int parse_window_bits(std::string_view value) {
+    value = trim(value);
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+        value = value.substr(1, value.size() - 2);
+    }
+    if (value.empty()) return 0;
+    int bits = 0;
+    for (char c : value) {
+        if (c < '0' || c > '9') return -1;
+        bits = bits * 10 + (c - '0');
+        if (bits > 15) return -1;
+    }
+    return bits >= 8 ? bits : -1;
+}
+
+// 解析单个 permessage-deflate 提议（"permessage-deflate; k=v; ..."）
+bool accept_offer(std::string_view offer, const WsDeflateConfig& config, WsDeflateParams* out) {
+    std::size_t semi = offer.find(';');
+    if (trim(offer.substr(0, semi)) != "permessage-deflate") {
+        return false;
+    }
+    WsDeflateParams params;
+    params.server_max_window_bits = config.server_max_window_bits;
+    bool seen_server_nct = false, seen_client_nct = false;
+    bool seen_server_bits = false, seen_client_bits = false;
+    while (semi != std::string_view::npos) {
+        offer.remove_prefix(semi + 1);
+        semi = offer.find(';');
+        std::string_view param = trim(offer.substr(0, semi));
+        std::size_t eq = param.find('=');
+        std::string_view name = trim(param.substr(0, eq));
+        std::string_view value = eq == std::string_view::npos ? std::string_view() : param.substr(eq + 1);
+
+        // 参数重复、取值非法或未知参数时拒绝该提议（RFC 7692 5.1）
+        if (name == "server_no_context_takeover") {
+            if (seen_server_nct || eq != std::string_view::npos) return false;
+            seen_server_nct = true;
+            params.server_no_context_takeover = true;
+        } else if (name == "client_no_context_takeover") {
+            if (seen_client_nct || eq != std::string_view::npos) return false;
+            seen_client_nct = true;
+            params.client_no_context_takeover = true;
+        } else if (name == "server_max_window_bits") {
+            int bits = parse_window_bits(value);
+            // zlib 的 raw deflate 不支持 8 位窗口
+            if (seen_server_bits || bits <= 8) return false;
+            seen_server_bits = true;
+            if (bits < params.server_max_window_bits) {
+                params.server_max_window_bits = bits;
+            }
+        } else if (name == "client_max_window_bits") {
+            // 仅表示客户端支持限制窗口；解压端总以 15 位窗口解压，兼容任意更小窗口
+            if (seen_client_bits || parse_window_bits(value) < 0) return false;
+            seen_client_bits = true;
+        } else {
+            return false;
+        }
+    }
+    if (config.shared_context) {
+        params.server_no_context_takeover = true;
+    }
+    // 未在提议中出现的 server_max_window_bits 不出现在响应里，只在本端以 15 以内的窗口压缩
+    params.server_max_window_bits = seen_server_bits ? params.server_max_window_bits : 15;
+    *out = params;
+    return true;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+// 协商
+// ---------------------------------------------------------------------------
+
+bool ws_deflate_available() {
+#ifdef CHWELL_USE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool negotiate_ws_deflate(std::string_view extensions, const WsDeflateConfig& config,
+                          WsDeflateParams* params) {
+    if (!config.enabled || !ws_deflate_available()) {
+        return false;
+    }
+    // 逗号分隔的多个提议按客户端偏好排序；参数值不含逗号
+    while (!extensions.empty()) {
+        std::size_t comma = extensions.find(',');
+        if (accept_offer(extensions.substr(0, comma), config, params)) {
+            return true;
+        }
+        if (comma == std::string_view::npos) break;
+        extensions.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+std::string format_ws_deflate_response(const WsDeflateParams& params) {
+    std::string value = "permessage-deflate";
+    if (params.server_no_context_takeover) {
+        value += "; server_no_context_takeover";
+    }
+    if (params.client_no_context_takeover) {
+        value += "; client_no_context_takeover";
+    }
+    if (params.server_max_window_bits < 15) {
+        value += "; server_max_window_bits=" + std::to_string(params.server_max_window_bits);
+    }
+    return value;
+}
+
+std::string format_ws_deflate_offer(bool client_no_context_takeover, bool server_no_context_takeover) {
+    std::string value = "permessage-deflate; client_max_window_bits";
+    if (client_no_context_takeover) {
+        value += "; client_no_context_takeover";
+    }
+    if (server_no_context_takeover) {
+        value += "; server_no_context_takeover";
+    }
+    return value;
+}
+
+// ---------------------------------------------------------------------------
+// WsDeflater / WsInflater
+// ---------------------------------------------------------------------------
+
+#ifdef CHWELL_USE_ZLIB
+
+struct WsDeflater::Impl {
+    z_stream zs;
+    bool ok{false};
+};
+
+WsDeflater::WsDeflater(int level, int window_bits, int mem_level, bool no_context_takeover)
+    : impl_(new Impl()),
+      no_context_takeover_(no_context_takeover) {
+    std::memset(&impl_->zs, 0, sizeof(impl_->zs));
+    impl_->ok = deflateInit2(&impl_->zs, level, Z_DEFLATED, -window_bits, mem_level,
+                             Z_DEFAULT_STRATEGY) == Z_OK;
+    if (!impl_->ok) {
+        CHWELL_LOG_ERROR("WsDeflater: deflateInit2 failed, window_bits=" << window_bits);
+    }
+}
+
+WsDeflater::~WsDeflater() {
+    if (impl_->ok) {
+        deflateEnd(&impl_->zs);
+    }
+}
+
+bool WsDeflater::compress(std::string_view in, std::string* out) {
+    if (!impl_->ok) {
+        return false;
+    }
+    z_stream& zs = impl_->zs;
+    out->resize(deflateBound(&zs, static_cast<uLong>(in.size())) + 16);
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in = static_cast<uInt>(in.size());
+    std::size_t produced = 0;
+    for (;;) {
+        zs.next_out = reinterpret_cast<Bytef*>(&(*out)[produced]);
+        zs.avail_out = static_cast<uInt>(out->size() - produced);
+        int ret = deflate(&zs, Z_SYNC_FLUSH);
+        produced = out->size() - zs.avail_out;
+        if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            deflateReset(&zs);
+            return false;
+        }
+        if (zs.avail_out != 0) {
+            break;  // 已全部输出
+        }
+        out->resize(out->size() * 2);
+    }
+    out->resize(produced);
+    if (out->size() >= 4 && std::memcmp(out->data() + out->size() - 4, kDeflateTail, 4) == 0) {
+        out->resize(out->size() - 4);
+    }
+    if (no_context_takeover_) {
+        deflateReset(&zs);
+    }
+    return true;
+}
+
+void WsDeflater::reset() {
+    if (impl_->ok) {
+        deflateReset(&impl_->zs);
+    }
+}
+
+struct WsInflater::Impl {
+    z_stream zs;
+    bool ok{false};
+};
+
+WsInflater::WsInflater(int window_bits, bool no_context_takeover)
+    : impl_(new Impl()),
+      no_context_takeover_(no_context_takeover) {
+    std::memset(&impl_->zs, 0, sizeof(impl_->zs));
+    impl_->ok = inflateInit2(&impl_->zs, -window_bits) == Z_OK;
+}
+
+WsInflater::~WsInflater() {
+    if (impl_->ok) {
+        inflateEnd(&impl_->zs);
+    }
+}
+
+int WsInflater::decompress(std::string_view in, std::string* out, std::size_t max_size) {
+    if (!impl_->ok) {
+        return -1;
+    }
+    z_stream& zs = impl_->zs;
+    out->clear();
+    char chunk[16 * 1024];
+    // 先解压消息本体，再补回结尾的空存储块
+    std::string_view parts[2] = {in, std::string_view(kDeflateTail, 4)};
+    for (std::string_view part : parts) {
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(part.data()));
+        zs.avail_in = static_cast<uInt>(part.size());
+        do {
+            zs.next_out = reinterpret_cast<Bytef*>(chunk);
+            zs.avail_out = sizeof(chunk);
+            int ret = inflate(&zs, Z_SYNC_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+                inflateReset(&zs);
+                return -1;
+            }
+            std::size_t n = sizeof(chunk) - zs.avail_out;
+            if (out->size() + n > max_size) {
+                inflateReset(&zs);
+                return -2;
+            }
+            out->append(chunk, n);
+            if (ret == Z_STREAM_END) {
+                // 对端以 BFINAL 结束了压缩流：其后的数据属于新流
+                inflateReset(&zs);
+            }
+            if (ret == Z_BUF_ERROR && n == 0) {
+                break;
+            }
+        } while (zs.avail_in > 0 || zs.avail_out == 0);
+    }
+    if (no_context_takeover_) {
+        inflateReset(&zs);
+    }
+    return 0;
+}
+
+#else  // !CHWELL_USE_ZLIB
+
+struct WsDeflater::Impl {};
+
+WsDeflater::WsDeflater(int, int, int, bool no_context_takeover)
+    : impl_(new Impl()),
+      no_context_takeover_(no_context_takeover) {}
+
+WsDeflater::~WsDeflater() {}
+
+bool WsDeflater::compress(std::string_view, std::string*) {
+    return false;
+}
+
+void WsDeflater::reset() {}
+
+struct WsInflater::Impl {};
+
+WsInflater::WsInflater(int, bool no_context_takeover)
+    : impl_(new Impl()),
+      no_context_takeover_(no_context_takeover) {}
+
+WsInflater::~WsInflater() {}
+
+int WsInflater::decompress(std::string_view, std::string*, std::size_t) {
+    return -1;
+}
+
+#endif // CHWELL_USE_ZLIB
+
+WsSharedDeflater::WsSharedDeflater(const WsDeflateConfig& config)
+    : deflater_(config.level, config.server_max_window_bits, config.mem_level, true) {}
+
+// ---------------------------------------------------------------------------
+// 预编码消息
+// ---------------------------------------------------------------------------
+
+WsPreparedMessage ws_prepare_message(WsOpcode opcode, std::string_view payload,
+                                     const WsDeflateConfig& config) {
+    WsPreparedMessage prepared;
+    prepared.payload_size = payload.size();
+    prepared.window_bits = config.server_max_window_bits;
+    prepared.plain = SharedFrame(ws_encode_frame(opcode, payload));
+    if (!config.enabled || !ws_deflate_available() || payload.size() < config.min_size) {
+        return prepared;
+    }
+
+    // 每个线程一个独立压缩器（消息间不保留窗口），参数变化时重建
+    struct Cache {
+        int level{-1};
+        int window_bits{-1};
+        int mem_level{-1};
+        std::unique_ptr<WsDeflater> deflater;
+        std::string buffer;
+    };
+    thread_local Cache cache;
+    if (!cache.deflater || cache.level != config.level ||
+        cache.window_bits != config.server_max_window_bits || cache.mem_level != config.mem_level) {
+        cache.deflater.reset(new WsDeflater(config.level, config.server_max_window_bits,
+                                            config.mem_level, true));
+        cache.level = config.level;
+        cache.window_bits = config.server_max_window_bits;
+        cache.mem_level = config.mem_level;
+    }
+    if (cache.deflater->compress(payload, &cache.buffer) && cache.buffer.size() < payload.size()) {
+        char header[kWsMaxHeaderSize];
+        std::size_t header_len = ws_encode_header(header, opcode, cache.buffer.size(), true, nullptr, true);
+        std::string frame;
+        frame.reserve(header_len + cache.buffer.size());
+        frame.append(header, header_len);
+        frame.append(cache.buffer);
+        prepared.deflated = SharedFrame(std::move(frame));
+    }
+    return prepared;
+}
+
+} // namespace net
+} // namespace chwell
@@ -6,8 +6,19 @@
 namespace chwell {
 namespace net {
 
-WsServer::WsServer(IoService& io_service, unsigned short port)
-    : io_service_(io_service), port_(port), acceptor_(port) {
+WsServer::WsServer(IoService& io_service, unsigned short port, std::size_t num_loops)
+    : io_service_(io_service), loops_(num_loops), port_(port), acceptor_(port) {
+}
+
+void WsServer::set_deflate(const WsDeflateConfig& config) {
+    deflate_config_ = config;
+    shared_deflater_.reset();
+    if (config.enabled && config.shared_context) {
+        shared_deflater_ = std::make_shared<WsSharedDeflater>(config);
+    }
+    if (config.enabled && !ws_deflate_available()) {
+        CHWELL_LOG_WARN("WsServer: permessage-deflate requested but built without zlib (CHWELL_USE_ZLIB)");
+    }
 }
 
 void WsServer::start_accept() {
@@ -21,6 +32,24 @@ void WsServer::start_accept() {
         return;
     }
 
+    if (!loops_.started()) {
+        loops_.start();
+    }
+
+    // 所有连接共享同一组回调；连接回调在握手完成后触发，此时已可发送消息
+    callbacks_ = std::make_shared<WsConnectionCallbacks>();
+    callbacks_->open = connection_cb_;
+    callbacks_->message = message_cb_;
+    callbacks_->close = [this](const WsConnectionPtr& c) {
+        {
+            std::lock_guard<std::mutex> lock(connections_mutex_);
+            connections_.erase(c);
+        }
+        if (disconnect_cb_) {
+            disconnect_cb_(c);
+        }
+    };
+
     CHWELL_LOG_INFO("WsServer listening on 0.0.0.0:" << port_);
     stopped_ = false;
     accept_thread_ = std::thread([this]() { accept_loop(); });
@@ -38,6 +67,7 @@ void WsServer::stop() {
     }
     if (wake_pipe_[0] >= 0) { close(wake_pipe_[0]); wake_pipe_[0] = -1; }
     if (wake_pipe_[1] >= 0) { close(wake_pipe_[1]); wake_pipe_[1] = -1; }
+    loops_.stop();
 }
 
 void WsServer::accept_loop() {
@@ -65,36 +95,31 @@ void WsServer::accept_loop() {
 
         if (fds[0].revents & POLLIN) {
             ErrorCode ec;
-            TcpSocket socket = acceptor_.accept(ec);
+            TcpSocket socket = acceptor_.accept(ec, SOCK_NONBLOCK | SOCK_CLOEXEC);
             if (ec) {
-                CHWELL_LOG_ERROR("WsServer accept failed: " + ec.message());
+                if (ec.value_ != EAGAIN && ec.value_ != EWOULDBLOCK) {
+                    CHWELL_LOG_ERROR("WsServer accept failed: " + ec.message());
+                }
                 continue;
             }
 
-            auto conn = std::make_shared<WsConnection>(std::move(socket));
-            conn->set_message_callback(message_cb_);
-            conn->set_close_callback([this](const WsConnectionPtr& c) {
-                {
-                    std::lock_guard<std::mutex> lock(connections_mutex_);
-                    connections_.erase(c);
-                }
-                if (disconnect_cb_) {
-                    disconnect_cb_(c);
-                }
-            });
+            auto tcp = std::make_shared<TcpConnection>(loops_.next_loop(), std::move(socket));
+            tcp->set_backpressure(backpressure_);
+            tcp->set_idle_timeout(idle_);
+            tcp->set_low_memory(low_memory_);
+            if (tls_) {
+                tcp->enable_tls(tls_);
+            }
+            auto conn = std::make_shared<WsConnection>(tcp, max_message_size_);
+            conn->set_deflate(deflate_config_, shared_deflater_);
+            conn->set_callbacks(callbacks_);
 
             {
                 std::lock_guard<std::mutex> lock(connections_mutex_);
                 connections_.insert(conn);
             }
 
-            if (connection_cb_) {
-                connection_cb_(conn);
-            }
-
-            io_service_.post([conn]() {
-                conn->start();
-            });
+            conn->start();
         }
     }
 }
@@ -0,0 +1,381 @@
+#include "chwell/protocol/compression.h"
+#include "chwell/core/logger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+
+#ifdef CHWELL_USE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace chwell {
+namespace protocol {
+
+namespace {
+
+// 字典训练：以 8 字节片段（k-mer）统计跨样本的出现次数，候选片段长 64 字节、步长 32
+const std::size_t kKmer = 8;
+const std::size_t kSegment = 64;
+const std::size_t kSegmentStep = kSegment / 2;
+
+std::uint32_t adler32_of(std::string_view data) {
+    const std::uint32_t kMod = 65521;
+    std::uint32_t a = 1, b = 0;
+    for (char c : data) {
+        a = (a + static_cast<std::uint8_t>(c)) % kMod;
+        b = (b + a) % kMod;
+    }
+    return (b << 16) | a;
+}
+
+std::uint64_t kmer_at(const char* p) {
+    std::uint64_t v;
+    std::memcpy(&v, p, kKmer);
+    return v;
+}
+
+struct KmerStat {
+    std::uint32_t samples{0};      // 出现过该片段的样本数；被选中的片段覆盖后清零
+    std::size_t last_sample{static_cast<std::size_t>(-1)};
+};
+
+typedef std::unordered_map<std::uint64_t, KmerStat> KmerTable;
+
+// 片段价值：所含的不同 k-mer 中，跨至少两个样本出现的那些的样本数之和
+std::uint64_t segment_score(std::string_view segment, const KmerTable& table,
+                            std::vector<std::uint64_t>& scratch) {
+    scratch.clear();
+    for (std::size_t i = 0; i + kKmer <= segment.size(); ++i) {
+        scratch.push_back(kmer_at(segment.data() + i));
+    }
+    std::sort(scratch.begin(), scratch.end());
+    scratch.erase(std::unique(scratch.begin(), scratch.end()), scratch.end());
+    std::uint64_t score = 0;
+    for (std::uint64_t kmer : scratch) {
+        auto it = table.find(kmer);
+        if (it != table.end() && it->second.samples >= 2) {
+            score += it->second.samples;
+        }
+    }
+    return score;
+}
+
+struct Candidate {
+    std::uint64_t score;
+    std::size_t sample;
+    std::size_t pos;
+    std::size_t len;
+
+    bool operator<(const Candidate& other) const { return score < other.score; }
+};
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+// FrameDictionary
+// ---------------------------------------------------------------------------
+
+FrameDictionary::FrameDictionary(std::string bytes)
+    : bytes_(std::move(bytes)),
+      id_(bytes_.empty() ? 0 : adler32_of(bytes_)) {
+    if (bytes_.size() > kMaxDictionaryBytes) {
+        // deflate 只能引用窗口内的内容，保留末尾（最有价值）的部分
+        bytes_.erase(0, bytes_.size() - kMaxDictionaryBytes);
+        id_ = adler32_of(bytes_);
+    }
+}
+
+FrameDictionary FrameDictionary::train(const std::vector<std::string>& samples, std::size_t max_bytes) {
+    max_bytes = std::min(max_bytes, kMaxDictionaryBytes);
+    KmerTable table;
+    for (std::size_t s = 0; s < samples.size(); ++s) {
+        const std::string& sample = samples[s];
+        for (std::size_t i = 0; i + kKmer <= sample.size(); ++i) {
+            KmerStat& stat = table[kmer_at(sample.data() + i)];
+            if (stat.last_sample != s) {
+                stat.last_sample = s;
+                ++stat.samples;
+            }
+        }
+    }
+
+    std::vector<std::uint64_t> scratch;
+    std::priority_queue<Candidate> heap;
+    for (std::size_t s = 0; s < samples.size(); ++s) {
+        const std::string& sample = samples[s];
+        if (sample.size() < kKmer) {
+            continue;
+        }
+        for (std::size_t pos = 0;; pos += kSegmentStep) {
+            std::size_t len = std::min(kSegment, sample.size() - pos);
+            std::uint64_t score = segment_score(std::string_view(sample).substr(pos, len), table, scratch);
+            if (score > 0) {
+                heap.push(Candidate{score, s, pos, len});
+            }
+            if (pos + len >= sample.size()) {
+                break;
+            }
+        }
+    }
+
+    // 贪心选取：每次取当前价值最高的片段，其 k-mer 随即视为已覆盖（价值清零），
+    // 其余片段的价值只会下降，弹出时重新计算，不再是最高的放回堆中（惰性更新）
+    std::vector<std::string_view> chosen;
+    std::size_t total = 0;
+    while (!heap.empty() && total < max_bytes) {
+        Candidate top = heap.top();
+        heap.pop();
+        std::string_view segment = std::string_view(samples[top.sample]).substr(top.pos, top.len);
+        std::uint64_t score = segment_score(segment, table, scratch);
+        if (score == 0) {
+            continue;
+        }
+        if (!heap.empty() && score < heap.top().score) {
+            top.score = score;
+            heap.push(top);
+            continue;
+        }
+        if (total + segment.size() > max_bytes) {
+            continue;
+        }
+        for (std::uint64_t kmer : scratch) {
+            table[kmer].samples = 0;
+        }
+        chosen.push_back(segment);
+        total += segment.size();
+    }
+
+    // 最先选中（价值最高）的片段放在末尾
+    std::string bytes;
+    bytes.reserve(total);
+    for (auto it = chosen.rbegin(); it != chosen.rend(); ++it) {
+        bytes.append(it->data(), it->size());
+    }
+    return FrameDictionary(std::move(bytes));
+}
+
+// ---------------------------------------------------------------------------
+// 协商消息
+// ---------------------------------------------------------------------------
+
+std::string encode_compression_offer(std::uint8_t algo, std::uint32_t dict_id) {
+    std::string body(5, '\0');
+    body[0] = static_cast<char>(algo);
+    body[1] = static_cast<char>(dict_id >> 24);
+    body[2] = static_cast<char>(dict_id >> 16);
+    body[3] = static_cast<char>(dict_id >> 8);
+    body[4] = static_cast<char>(dict_id);
+    return body;
+}
+
+bool decode_compression_offer(std::string_view body, std::uint8_t& algo, std::uint32_t& dict_id) {
+    if (body.size() != 5) {
+        return false;
+    }
+    algo = static_cast<std::uint8_t>(body[0]);
+    dict_id = 0;
+    for (std::size_t i = 1; i < 5; ++i) {
+        dict_id = (dict_id << 8) | static_cast<std::uint8_t>(body[i]);
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// FrameCompressor
+// ---------------------------------------------------------------------------
+
+bool frame_compression_available() {
+#ifdef CHWELL_USE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef CHWELL_USE_ZLIB
+
+namespace {
+
+struct ZStream {
+    z_stream zs;
+    bool deflater;
+
+    explicit ZStream(bool is_deflater) : deflater(is_deflater) { std::memset(&zs, 0, sizeof(zs)); }
+    ~ZStream() {
+        if (deflater) {
+            deflateEnd(&zs);
+        } else {
+            inflateEnd(&zs);
+        }
+    }
+};
+
+} // anonymous namespace
+
+struct FrameCompressor::Impl {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ZStream>> deflaters;
+    std::vector<std::unique_ptr<ZStream>> inflaters;
+};
+
+FrameCompressor::FrameCompressor(const CompressionConfig& config, const FrameDictionaryPtr& dictionary)
+    : config_(config),
+      dictionary_(dictionary && !dictionary->empty() ? dictionary : FrameDictionaryPtr()),
+      impl_(new Impl()) {
+    config_.dictionary = dictionary_;
+}
+
+FrameCompressor::~FrameCompressor() {}
+
+bool FrameCompressor::compress(std::string_view in, std::string* out) {
+    if (in.size() < config_.min_size) {
+        return false;
+    }
+    std::unique_ptr<ZStream> stream;
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        if (!impl_->deflaters.empty()) {
+            stream = std::move(impl_->deflaters.back());
+            impl_->deflaters.pop_back();
+        }
+    }
+    if (!stream) {
+        stream.reset(new ZStream(true));
+        if (deflateInit(&stream->zs, config_.level) != Z_OK) {
+            CHWELL_LOG_ERROR("FrameCompressor: deflateInit failed, level=" << config_.level);
+            return false;
+        }
+    }
+
+    // 每条消息独立成流：重置后重新装入字典
+    z_stream& zs = stream->zs;
+    bool ok = deflateReset(&zs) == Z_OK;
+    if (ok && dictionary_) {
+        ok = deflateSetDictionary(&zs, reinterpret_cast<const Bytef*>(dictionary_->bytes().data()),
+                                  static_cast<uInt>(dictionary_->bytes().size())) == Z_OK;
+    }
+    if (ok) {
+        // deflateBound 已计入字典 id 所占的流头部
+        out->resize(deflateBound(&zs, static_cast<uLong>(in.size())));
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+        zs.avail_in = static_cast<uInt>(in.size());
+        zs.next_out = reinterpret_cast<Bytef*>(&(*out)[0]);
+        zs.avail_out = static_cast<uInt>(out->size());
+        ok = deflate(&zs, Z_FINISH) == Z_STREAM_END;
+        out->resize(out->size() - zs.avail_out);
+    }
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->deflaters.push_back(std::move(stream));
+    }
+    if (!ok || out->size() >= in.size()) {
+        return false;
+    }
+    raw_bytes_.fetch_add(in.size(), std::memory_order_relaxed);
+    compressed_bytes_.fetch_add(out->size(), std::memory_order_relaxed);
+    return true;
+}
+
+int FrameCompressor::decompress(std::string_view in, std::string* out) {
+    std::unique_ptr<ZStream> stream;
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        if (!impl_->inflaters.empty()) {
+            stream = std::move(impl_->inflaters.back());
+            impl_->inflaters.pop_back();
+        }
+    }
+    if (!stream) {
+        stream.reset(new ZStream(false));
+        if (inflateInit(&stream->zs) != Z_OK) {
+            return -1;
+        }
+    } else {
+        inflateReset(&stream->zs);
+    }
+
+    z_stream& zs = stream->zs;
+    out->clear();
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in = static_cast<uInt>(in.size());
+    char chunk[16 * 1024];
+    int result = 0;
+    for (;;) {
+        zs.next_out = reinterpret_cast<Bytef*>(chunk);
+        zs.avail_out = sizeof(chunk);
+        int ret = inflate(&zs, Z_NO_FLUSH);
+        if (ret == Z_NEED_DICT) {
+            // 流要求的字典与本端不符（或本端没有字典）
+            if (!dictionary_ || zs.adler != dictionary_->id() ||
+                inflateSetDictionary(&zs, reinterpret_cast<const Bytef*>(dictionary_->bytes().data()),
+                                     static_cast<uInt>(dictionary_->bytes().size())) != Z_OK) {
+                result = -1;
+                break;
+            }
+            continue;
+        }
+        if (ret != Z_OK && ret != Z_STREAM_END) {
+            result = -1;  // 数据损坏，或流未结束输入就用完了
+            break;
+        }
+        std::size_t n = sizeof(chunk) - zs.avail_out;
+        if (out->size() + n > config_.max_decompressed_size) {
+            result = -2;
+            break;
+        }
+        out->append(chunk, n);
+        if (ret == Z_STREAM_END) {
+            // 一条消息只有一个流，流后不应再有数据
+            result = zs.avail_in == 0 ? 0 : -1;
+            break;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->inflaters.push_back(std::move(stream));
+    }
+    return result;
+}
+
+#else  // !CHWELL_USE_ZLIB
+
+struct FrameCompressor::Impl {};
+
+FrameCompressor::FrameCompressor(const CompressionConfig& config, const FrameDictionaryPtr& dictionary)
+    : config_(config),
+      dictionary_(dictionary && !dictionary->empty() ? dictionary : FrameDictionaryPtr()),
+      impl_(new Impl()) {
+    config_.dictionary = dictionary_;
+}
+
+FrameCompressor::~FrameCompressor() {}
+
+bool FrameCompressor::compress(std::string_view, std::string*) {
+    return false;
+}
+
+int FrameCompressor::decompress(std::string_view, std::string*) {
+    return -1;
+}
+
+#endif // CHWELL_USE_ZLIB
+
+void FrameCompressor::encode(std::string& out, std::uint16_t cmd, std::string_view body,
+                             std::size_t max_fragment) {
+    thread_local std::string compressed;
+    if (compress(body, &compressed)) {
+        serialize_to(out, cmd, compressed, FrameFormat::kExtended, max_fragment, kFlagCompressed);
+    } else {
+        serialize_to(out, cmd, body, FrameFormat::kExtended, max_fragment);
+    }
+    // 大消息压缩后不长期占用线程缓冲
+    if (compressed.capacity() > 64 * 1024) {
+        std::string().swap(compressed);
+    }
+}
+
+} // namespace protocol
+} // namespace chwell
@@ -1,30 +1,105 @@
 #include "chwell/protocol/message.h"
 #include "chwell/core/endian.h"
+#include "chwell/core/logger.h"
+#include <algorithm>
 #include <cstring>
 
 namespace chwell {
 namespace protocol {
 
-std::vector<char> serialize(const Message& msg) {
-    std::vector<char> result;
-    result.reserve(4 + msg.body.size());
+namespace {
+
+// 帧头与分片数：旧格式总是单帧，扩展格式按 max_fragment 拆分（空 body 也占一帧）
+std::size_t fragment_size(FrameFormat format, std::size_t max_fragment) {
+    if (format == FrameFormat::kLegacy) {
+        return kMaxLegacyBody;
+    }
+    return (max_fragment == 0 || max_fragment > kMaxFrameBody) ? kMaxFrameBody : max_fragment;
+}
+
+std::size_t encoded_size(FrameFormat format, std::size_t body_len, std::size_t max_fragment) {
+    if (format == FrameFormat::kLegacy) {
+        return kLegacyHeaderSize + body_len;
+    }
+    std::size_t piece = fragment_size(format, max_fragment);
+    std::size_t frames = body_len == 0 ? 1 : (body_len + piece - 1) / piece;
+    return frames * kMaxExtendedHeaderSize + body_len;
+}
+
+// 按帧编码到 out 末尾（out 为 std::string 或 std::vector<char>），返回是否成功
+template <typename Out>
+bool encode_frames(Out& out, std::uint16_t cmd, std::string_view body, FrameFormat format,
+                   std::size_t max_fragment, std::uint8_t message_flags) {
+    if (format == FrameFormat::kLegacy && body.size() > kMaxLegacyBody) {
+        CHWELL_LOG_ERROR("protocol: body of cmd=" << cmd << " is " << body.size()
+                         << " bytes, exceeds the legacy frame limit; use FrameFormat::kExtended");
+        return false;
+    }
+    if (format == FrameFormat::kLegacy && message_flags != 0) {
+        CHWELL_LOG_ERROR("protocol: legacy frames carry no flags, cmd=" << cmd);
+        return false;
+    }
+    message_flags &= static_cast<std::uint8_t>(~kFlagMore);
 
-    // cmd (2 bytes, network byte order)
-    std::uint16_t cmd_net = core::host_to_net16(msg.cmd);
-    result.insert(result.end(), reinterpret_cast<const char*>(&cmd_net),
-                  reinterpret_cast<const char*>(&cmd_net) + 2);
+    const std::size_t piece = fragment_size(format, max_fragment);
+    const std::size_t start = out.size();
+    out.resize(start + encoded_size(format, body.size(), max_fragment));
+    char* p = &out[start];
+    do {
+        std::size_t n = std::min(piece, body.size());
+        std::uint8_t flags = message_flags | (n < body.size() ? kFlagMore : 0);
+        p += encode_header(p, format, cmd, flags, n);
+        if (n > 0) {
+            std::memcpy(p, body.data(), n);
+            p += n;
+        }
+        body.remove_prefix(n);
+    } while (!body.empty());
+    // 扩展格式按最长帧头预留，收回多余部分
+    out.resize(static_cast<std::size_t>(p - &out[0]));
+    return true;
+}
 
-    // len (2 bytes, network byte order)
-    std::uint16_t len_net = core::host_to_net16(static_cast<std::uint16_t>(msg.body.size()));
-    result.insert(result.end(), reinterpret_cast<const char*>(&len_net),
-                  reinterpret_cast<const char*>(&len_net) + 2);
+} // anonymous namespace
 
-    // body
-    result.insert(result.end(), msg.body.begin(), msg.body.end());
+std::size_t encode_header(char* out, FrameFormat format, std::uint16_t cmd, std::uint8_t flags,
+                          std::size_t body_len) {
+    std::uint16_t cmd_net = core::host_to_net16(cmd);
+    if (format == FrameFormat::kLegacy) {
+        // cmd (2 bytes) + len (2 bytes)，网络字节序
+        std::uint16_t len_net = core::host_to_net16(static_cast<std::uint16_t>(body_len));
+        std::memcpy(out, &cmd_net, 2);
+        std::memcpy(out + 2, &len_net, 2);
+        return kLegacyHeaderSize;
+    }
+
+    out[0] = static_cast<char>(kExtendedVersion);
+    out[1] = static_cast<char>(flags);
+    std::memcpy(out + 2, &cmd_net, 2);
+    std::size_t n = 4;
+    std::uint32_t len = static_cast<std::uint32_t>(body_len);
+    while (len >= 0x80) {
+        out[n++] = static_cast<char>((len & 0x7F) | 0x80);
+        len >>= 7;
+    }
+    out[n++] = static_cast<char>(len);
+    return n;
+}
 
+std::vector<char> serialize(const Message& msg, FrameFormat format, std::size_t max_fragment) {
+    std::vector<char> result;
+    if (!encode_frames(result, msg.cmd, std::string_view(msg.body.data(), msg.body.size()),
+                       format, max_fragment, 0)) {
+        result.clear();
+    }
     return result;
 }
 
+bool serialize_to(std::string& out, std::uint16_t cmd, std::string_view body, FrameFormat format,
+                  std::size_t max_fragment, std::uint8_t flags) {
+    return encode_frames(out, cmd, body, format, max_fragment, flags);
+}
+
 bool deserialize(const std::vector<char>& data, Message& msg) {
     if (data.size() < 4) {
         return false; // 至少需要 4 字节（cmd + len）
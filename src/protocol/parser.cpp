@@ -5,50 +5,147 @@
 namespace chwell {
 namespace protocol {
 
-void Parser::compact_prefix() {
-    if (head_ == 0) {
-        return;
+namespace {
+
+const std::size_t kHeaderSize = kLegacyHeaderSize;
+// 扩展帧头最短 5 字节：ver + flags + cmd + 1 字节长度
+const std::size_t kMinExtendedHeaderSize = 5;
+const std::size_t kMaxVarintBytes = kMaxExtendedHeaderSize - 4;
+
+std::uint16_t read_u16(const char* p) {
+    std::uint16_t v;
+    std::memcpy(&v, p, 2);
+    return core::net_to_host16(v);
+}
+
+// 解析扩展帧头中的变长长度（从 data[4] 开始）：成功返回帧头长度，数据不完整返回 0，
+// 超过 5 字节或超过 kMaxFrameBody 返回 Parser::kInvalidFrame
+std::size_t read_extended_length(std::string_view data, std::size_t& len) {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < kMaxVarintBytes; ++i) {
+        if (data.size() <= 4 + i) {
+            return 0;
+        }
+        std::uint8_t byte = static_cast<std::uint8_t>(data[4 + i]);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << (7 * i);
+        if ((byte & 0x80) == 0) {
+            if (value > kMaxFrameBody) {
+                return Parser::kInvalidFrame;
+            }
+            len = static_cast<std::size_t>(value);
+            return 5 + i;
+        }
     }
-    if (head_ >= 4096 && head_ * 2 >= buffer_.size()) {
-        buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(head_));
-        head_ = 0;
+    return Parser::kInvalidFrame;
+}
+
+} // anonymous namespace
+
+const std::size_t Parser::kInvalidFrame;
+
+std::size_t Parser::parse_frame(std::string_view data, MessageView& view) {
+    if (data.size() < kHeaderSize) {
+        return 0; // 至少需要 4 字节
+    }
+    std::uint16_t body_len = read_u16(data.data() + 2);
+    // 检查是否有完整的消息（4 字节头部 + body）
+    if (data.size() - kHeaderSize < body_len) {
+        return 0; // 数据不完整，等待更多数据
     }
+    view.cmd = read_u16(data.data());
+    view.body = data.substr(kHeaderSize, body_len);
+    view.flags = 0;
+    return kHeaderSize + body_len;
 }
 
-std::vector<Message> Parser::feed(std::string_view data) {
-    std::vector<Message> messages;
+std::size_t Parser::parse_frame(std::string_view data, FrameFormat format, MessageView& view,
+                                std::uint8_t& flags) {
+    if (format == FrameFormat::kLegacy) {
+        flags = 0;
+        return parse_frame(data, view);
+    }
 
-    // 将新数据追加到缓冲区
-    buffer_.insert(buffer_.end(), data.begin(), data.end());
+    // 版本与保留位在帧头的前两个字节，不必等整个帧头到齐
+    if (!data.empty() && static_cast<std::uint8_t>(data[0]) != kExtendedVersion) {
+        return kInvalidFrame;
+    }
+    if (data.size() >= 2 && (static_cast<std::uint8_t>(data[1]) & ~kKnownFlags) != 0) {
+        return kInvalidFrame;
+    }
+    if (data.size() < kMinExtendedHeaderSize) {
+        return 0;
+    }
+    std::size_t body_len = 0;
+    std::size_t header_len = read_extended_length(data, body_len);
+    if (header_len == 0 || header_len == kInvalidFrame) {
+        return header_len;
+    }
+    if (data.size() - header_len < body_len) {
+        return 0;
+    }
+    flags = static_cast<std::uint8_t>(data[1]);
+    view.cmd = read_u16(data.data() + 2);
+    view.body = data.substr(header_len, body_len);
+    view.flags = flags & kFlagCompressed;
+    return header_len + body_len;
+}
 
-    // 循环解析，直到无法解析出完整消息
-    while (true) {
-        std::size_t avail = buffer_.size() - head_;
-        if (avail < 4) {
-            break; // 至少需要 4 字节
+std::size_t Parser::pending_bytes() const {
+    std::size_t have = buffer_.readable_bytes();
+    if (format_ == FrameFormat::kLegacy) {
+        if (have < kHeaderSize) {
+            return kHeaderSize - have;
         }
+        return kHeaderSize + read_u16(buffer_.peek() + 2) - have;
+    }
 
-        // 读取 len
-        std::uint16_t len_net;
-        std::memcpy(&len_net, buffer_.data() + head_ + 2, 2);
-        std::uint16_t body_len = core::net_to_host16(len_net);
+    if (have < kMinExtendedHeaderSize) {
+        return kMinExtendedHeaderSize - have;
+    }
+    std::size_t body_len = 0;
+    std::size_t header_len = read_extended_length(buffer_.view(), body_len);
+    // 长度字节未到齐时逐字节补齐；非法长度交给 parse_frame 报告
+    if (header_len == 0 || header_len == kInvalidFrame) {
+        return 1;
+    }
+    return header_len + body_len - have;
+}
 
-        // 检查是否有完整的消息（4 字节头部 + body）
-        if (avail < 4 + body_len) {
-            break; // 数据不完整，等待更多数据
-        }
+void Parser::clear_message() {
+    in_message_ = false;
+    message_cmd_ = 0;
+    message_flags_ = 0;
+    // 超大消息拼接完后不长期占用内存
+    if (message_.capacity() > net::Buffer::kInitialSize * 16) {
+        std::string().swap(message_);
+    } else {
+        message_.clear();
+    }
+}
 
-        Message msg;
-        std::uint16_t cmd_net;
-        std::memcpy(&cmd_net, buffer_.data() + head_, 2);
-        msg.cmd = core::net_to_host16(cmd_net);
-        msg.body.assign(buffer_.data() + head_ + 4, buffer_.data() + head_ + 4 + body_len);
-        messages.push_back(std::move(msg));
+std::vector<Message> Parser::feed(std::string_view data) {
+    if (!buffer_.empty()) {
+        // 有上次遗留的残帧：拼接后统一解析
+        buffer_.append(data);
+        return feed(buffer_);
+    }
 
-        head_ += 4 + body_len;
+    // 常见路径：直接解析输入，只把末尾残帧拷入缓冲
+    std::vector<Message> messages;
+    auto collect = [&messages](const MessageView& view) { messages.push_back(view.to_message()); };
+    std::size_t count = 0;
+    std::size_t consumed = parse_input(data, collect, count);
+    if (consumed < data.size() && !failed_) {
+        buffer_.append(data.data() + consumed, data.size() - consumed);
     }
+    return messages;
+}
 
-    compact_prefix();
+std::vector<Message> Parser::feed(net::Buffer& input) {
+    std::vector<Message> messages;
+    auto collect = [&messages](const MessageView& view) { messages.push_back(view.to_message()); };
+    std::size_t count = 0;
+    input.retrieve(parse_input(input.view(), collect, count));
     return messages;
 }
 
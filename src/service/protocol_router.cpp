@@ -1,7 +1,13 @@
 #include "chwell/service/protocol_router.h"
 #include "chwell/core/logger.h"
+#include "chwell/core/endian.h"
+#include "chwell/metrics/event_counter.h"
+#include "chwell/net/mux.h"
+#include "chwell/net/tcp_connection.h"
 #include "chwell/protocol/message.h"
 
+#include <cstring>
+
 namespace chwell {
 namespace service {
 
@@ -9,43 +15,348 @@ void ProtocolRouterComponent::on_message(const net::TcpConnectionPtr& conn,
                                          std::string_view data) {
     CHWELL_LOG_DEBUG("ProtocolRouter received " << data.size() << " bytes");
 
-    // 获取或创建该连接的解析器
-    auto& parser = parsers_[conn.get()];
+    const protocol::FrameFormat format = frame_format(conn);
+    std::shared_ptr<protocol::Parser> parser;
+    {
+        std::lock_guard<std::mutex> lock(parsers_mutex_);
+        auto it = parsers_.find(conn.get());
+        if (it != parsers_.end()) {
+            parser = it->second;
+        }
+    }
 
-    // 解析消息
-    std::vector<protocol::Message> messages = parser.feed(data);
-    CHWELL_LOG_DEBUG("Parsed " << messages.size() << " message(s)");
+    std::size_t count = 0;
+    if (!parser) {
+        // 没有残帧：完整帧直接在接收数据上解析，只有剩下不完整的帧（或分片消息）时才为连接创建解析器
+        protocol::MessageView view;
+        std::uint8_t flags = 0;
+        std::size_t frame_len = 0;
+        while ((frame_len = protocol::Parser::parse_frame(data, format, view, flags)) > 0 &&
+               frame_len != protocol::Parser::kInvalidFrame && (flags & protocol::kFlagMore) == 0) {
+            if (!dispatch(conn, view)) {
+                return;
+            }
+            data.remove_prefix(frame_len);
+            ++count;
+        }
+        if (frame_len == protocol::Parser::kInvalidFrame) {
+            CHWELL_LOG_WARN("ProtocolRouter: invalid frame, closing connection");
+            conn->close();
+            return;
+        }
+        // 处理器中已关闭连接时 on_disconnect 已执行过，不能再为它留下条目
+        if (data.empty() || conn->is_closed()) {
+            CHWELL_LOG_DEBUG("Parsed " << count << " message(s)");
+            return;
+        }
+        if (format == protocol::FrameFormat::kLegacy && try_passthrough(conn, data)) {
+            return;
+        }
+        parser = std::make_shared<protocol::Parser>(
+            conn->low_memory() ? data.size() : net::Buffer::kInitialSize, format);
+        std::lock_guard<std::mutex> lock(parsers_mutex_);
+        parsers_[conn.get()] = parser;
+    }
 
-    // 对每个解析出的消息进行路由
-    for (const auto& msg : messages) {
-        CHWELL_LOG_DEBUG("Routing message cmd=0x" << std::hex << msg.cmd << std::dec);
+    // 以 shared_ptr 持有：处理器中关闭连接触发 on_disconnect 时解析器仍存活到本轮分发结束
+    bool rejected = false;
+    count += parser->feed_views(data, [this, &conn, &rejected](const protocol::MessageView& msg) {
+        if (!rejected && !dispatch(conn, msg)) {
+            rejected = true;
+        }
+    });
+    CHWELL_LOG_DEBUG("Parsed " << count << " message(s)");
+    if (rejected) {
+        return;
+    }
 
-        auto it = handlers_.find(msg.cmd);
-        if (it != handlers_.end()) {
-            // 找到对应的处理器，调用它
-            CHWELL_LOG_DEBUG("Calling handler for cmd=0x" << std::hex << msg.cmd << std::dec);
-            it->second(conn, msg);
-        } else {
-            // 没有注册的处理器，记录警告
-            CHWELL_LOG_WARN("No handler registered for cmd: 0x" << std::hex << msg.cmd << std::dec
-                          << " (" << msg.cmd << ")");
+    if (parser->failed()) {
+        CHWELL_LOG_WARN("ProtocolRouter: invalid frame, closing connection");
+        conn->close();
+        return;
+    }
+
+    if (format == protocol::FrameFormat::kLegacy && parser->buffered_bytes() > 0 &&
+        !conn->is_closed() && try_passthrough(conn, parser->buffered())) {
+        parser->reset();
+    }
+
+    // 低内存模式：残帧补齐后即释放解析器，空闲连接不保留解析缓冲
+    if (conn->low_memory() && parser->idle()) {
+        std::lock_guard<std::mutex> lock(parsers_mutex_);
+        auto it = parsers_.find(conn.get());
+        if (it != parsers_.end() && it->second == parser) {
+            parsers_.erase(it);
         }
     }
 }
 
+bool ProtocolRouterComponent::try_passthrough(const net::TcpConnectionPtr& conn,
+                                              std::string_view partial) {
+    // 帧头：cmd (2) + body 长度 (2)，网络字节序
+    if (passthrough_.empty() || partial.size() < 4) {
+        return false;
+    }
+    std::uint16_t cmd_net = 0;
+    std::uint16_t len_net = 0;
+    std::memcpy(&cmd_net, partial.data(), 2);
+    std::memcpy(&len_net, partial.data() + 2, 2);
+    auto it = passthrough_.find(core::net_to_host16(cmd_net));
+    if (it == passthrough_.end()) {
+        return false;
+    }
+    const std::size_t frame_len = 4 + static_cast<std::size_t>(core::net_to_host16(len_net));
+    if (partial.size() >= frame_len) {
+        return false;
+    }
+    return it->second(conn, it->first, partial, frame_len - partial.size());
+}
+
+bool ProtocolRouterComponent::dispatch(const net::TcpConnectionPtr& conn,
+                                       const protocol::MessageView& msg) {
+    if (msg.cmd == protocol::kCmdCompression) {
+        handle_compression_offer(conn, msg.body);
+        return true;
+    }
+    if ((msg.flags & protocol::kFlagCompressed) == 0) {
+        route(conn, msg);
+        return true;
+    }
+
+    protocol::FrameCompressorPtr codec = frame_codec(conn);
+    std::string body;
+    int ret = codec ? codec->decompress(msg.body, &body) : -1;
+    if (ret != 0) {
+        CHWELL_LOG_WARN("ProtocolRouter: " << (codec ? "undecodable" : "unnegotiated")
+                      << " compressed frame cmd=0x" << std::hex << msg.cmd << std::dec
+                      << " (ret=" << ret << "), closing connection");
+        conn->close();
+        return false;
+    }
+    route(conn, protocol::MessageView(msg.cmd, body));
+    return true;
+}
+
+void ProtocolRouterComponent::handle_compression_offer(const net::TcpConnectionPtr& conn,
+                                                       std::string_view body) {
+    std::uint8_t algo = protocol::kCompressionNone;
+    std::uint32_t dict_id = 0;
+    const protocol::FrameFormat format = frame_format(conn);
+    protocol::FrameCompressorPtr codec;
+    if (!protocol::decode_compression_offer(body, algo, dict_id)) {
+        CHWELL_LOG_WARN("ProtocolRouter: malformed compression offer (" << body.size() << " bytes)");
+    } else if (algo == protocol::kCompressionDeflate && compressor_ &&
+               format == protocol::FrameFormat::kExtended) {
+        codec = dict_compressor_ && dict_id == dict_compressor_->dictionary_id() ? dict_compressor_
+                                                                                : compressor_;
+    }
+
+    // 先以未压缩帧回复，再装上编解码器：之后发出的压缩帧一定排在回复之后
+    std::string reply;
+    protocol::serialize_to(reply, protocol::kCmdCompression,
+                           protocol::encode_compression_offer(
+                               codec ? protocol::kCompressionDeflate : protocol::kCompressionNone,
+                               codec ? codec->dictionary_id() : 0),
+                           format);
+    conn->send(reply);
+    conn->set_frame_codec(codec);
+    CHWELL_LOG_DEBUG("Compression " << (codec ? "enabled" : "declined") << " for connection, dict_id="
+                  << (codec ? codec->dictionary_id() : 0));
+}
+
+void ProtocolRouterComponent::route(const net::TcpConnectionPtr& conn,
+                                    const protocol::MessageView& msg) {
+    CHWELL_LOG_DEBUG("Routing message cmd=0x" << std::hex << msg.cmd << std::dec);
+
+    auto it = handlers_.find(msg.cmd);
+    if (it == handlers_.end()) {
+        // 没有注册的处理器，记录警告
+        CHWELL_LOG_WARN("No handler registered for cmd: 0x" << std::hex << msg.cmd << std::dec
+                      << " (" << msg.cmd << ")");
+        return;
+    }
+
+    // 找到对应的处理器，调用它
+    CHWELL_LOG_DEBUG("Calling handler for cmd=0x" << std::hex << msg.cmd << std::dec);
+    const Route& route = it->second;
+    if (route.view) {
+        route.view(conn, msg);
+    } else if (route.owned) {
+        route.owned(conn, msg.to_message());
+    }
+}
+
 void ProtocolRouterComponent::on_disconnect(const net::TcpConnectionPtr& conn) {
     CHWELL_LOG_DEBUG("ProtocolRouter cleanup for disconnected connection");
     // 清理该连接的解析器
+    std::lock_guard<std::mutex> lock(parsers_mutex_);
     parsers_.erase(conn.get());
 }
 
+void ProtocolRouterComponent::on_mux_message(const net::MuxSessionPtr& session,
+                                             std::string_view data) {
+    const protocol::FrameFormat format = frame_format(session);
+    protocol::MessageView view;
+    std::uint8_t flags = 0;
+    std::size_t frame_len = 0;
+    while ((frame_len = protocol::Parser::parse_frame(data, format, view, flags)) > 0) {
+        if (frame_len == protocol::Parser::kInvalidFrame) {
+            CHWELL_LOG_WARN("Mux session " << session->id() << ": invalid frame, dropped "
+                          << data.size() << " bytes");
+            return;
+        }
+        // 网关按整条消息转发，不分片也不压缩
+        if ((flags & (protocol::kFlagMore | protocol::kFlagCompressed)) != 0) {
+            CHWELL_LOG_WARN("Mux session " << session->id() << ": unexpected frame flags 0x"
+                          << std::hex << static_cast<int>(flags) << std::dec << ", dropped");
+        } else {
+            auto it = mux_handlers_.find(view.cmd);
+            if (it != mux_handlers_.end()) {
+                it->second(session, view);
+            } else {
+                CHWELL_LOG_WARN("No mux handler registered for cmd: 0x" << std::hex << view.cmd
+                              << std::dec << " (" << view.cmd << ")");
+            }
+        }
+        data.remove_prefix(frame_len);
+    }
+    if (!data.empty()) {
+        CHWELL_LOG_WARN("Mux session " << session->id() << ": dropped " << data.size()
+                      << " bytes of incomplete frame");
+    }
+}
+
+void ProtocolRouterComponent::send_message(const net::MuxSessionPtr& session,
+                                           const protocol::Message& msg) {
+    std::vector<char> data = protocol::serialize(msg, frame_format(session));
+    // 旧格式放不下的 body 编码为空；超过链路帧上限的会被网关当作非法帧并断开整条链路
+    if (data.empty() || data.size() > net::mux::kMaxPayload) {
+        CHWELL_COUNT_EVENT("chwell_mux_oversized_replies_total",
+                           "Mux session replies dropped for exceeding the session frame format limit");
+        CHWELL_LOG_WARN("Mux session " << session->id() << ": dropped reply cmd=0x" << std::hex
+                      << msg.cmd << std::dec << " with " << msg.body.size() << " byte body");
+        return;
+    }
+    session->send(data);
+}
+
+void ProtocolRouterComponent::enable_compression(const protocol::CompressionConfig& config) {
+    if (!protocol::frame_compression_available()) {
+        CHWELL_LOG_WARN("ProtocolRouter: frame compression requested but zlib is not available");
+        return;
+    }
+    compressor_ = std::make_shared<protocol::FrameCompressor>(config, nullptr);
+    if (config.dictionary && !config.dictionary->empty()) {
+        dict_compressor_ = std::make_shared<protocol::FrameCompressor>(config, config.dictionary);
+    } else {
+        dict_compressor_.reset();
+    }
+}
+
 void ProtocolRouterComponent::send_message(const net::TcpConnectionPtr& conn,
                                            const protocol::Message& msg) {
-    std::vector<char> data = protocol::serialize(msg);
+    protocol::FrameCompressorPtr codec = frame_codec(conn);
+    if (codec) {
+        std::string data;
+        codec->encode(data, msg.cmd, std::string_view(msg.body.data(), msg.body.size()));
+        conn->send(data);
+        return;
+    }
+    std::vector<char> data = protocol::serialize(msg, frame_format(conn));
     CHWELL_LOG_DEBUG("Sending message cmd=0x" << std::hex << msg.cmd << std::dec
                   << " size=" << data.size() << " bytes");
     conn->send(data);
 }
 
+net::SharedFrame ProtocolRouterComponent::make_frame(const protocol::Message& msg,
+                                                     protocol::FrameFormat format,
+                                                     const protocol::FrameCompressorPtr& codec) {
+    std::string bytes;
+    std::string_view body(msg.body.data(), msg.body.size());
+    if (codec) {
+        codec->encode(bytes, msg.cmd, body);
+    } else {
+        protocol::serialize_to(bytes, msg.cmd, body, format);
+    }
+    return net::SharedFrame(std::move(bytes));
+}
+
+protocol::FrameFormat ProtocolRouterComponent::frame_format(const net::TcpConnectionPtr& conn) {
+    // 完整帧的分发路径不要求连接对象（基准中以空指针作键）
+    return conn && conn->frame_format() == static_cast<std::uint8_t>(protocol::FrameFormat::kExtended)
+               ? protocol::FrameFormat::kExtended
+               : protocol::FrameFormat::kLegacy;
+}
+
+protocol::FrameFormat ProtocolRouterComponent::frame_format(const net::MuxSessionPtr& session) {
+    return session->frame_format() == static_cast<std::uint8_t>(protocol::FrameFormat::kExtended)
+               ? protocol::FrameFormat::kExtended
+               : protocol::FrameFormat::kLegacy;
+}
+
+protocol::FrameCompressorPtr ProtocolRouterComponent::frame_codec(const net::TcpConnectionPtr& conn) {
+    return conn ? std::static_pointer_cast<protocol::FrameCompressor>(conn->frame_codec())
+                : protocol::FrameCompressorPtr();
+}
+
+void ProtocolRouterComponent::broadcast_message(const std::vector<net::TcpConnectionPtr>& group,
+                                                const protocol::Message& msg) {
+    // 每种帧格式 + 压缩设置只编码一次（压缩结果与连接无关，同一设置的连接共享一份）；
+    // 整组设置相同（常见情况）时不再拆分
+    if (group.empty()) {
+        return;
+    }
+    const protocol::FrameFormat first_format = frame_format(group.front());
+    const protocol::FrameCompressorPtr first_codec = frame_codec(group.front());
+    bool uniform = true;
+    for (const net::TcpConnectionPtr& conn : group) {
+        if (frame_format(conn) != first_format || frame_codec(conn) != first_codec) {
+            uniform = false;
+            break;
+        }
+    }
+    if (uniform) {
+        broadcast_group(group, msg, first_format, first_codec);
+        return;
+    }
+
+    struct Bucket {
+        protocol::FrameFormat format;
+        protocol::FrameCompressorPtr codec;
+        std::vector<net::TcpConnectionPtr> conns;
+    };
+    std::vector<Bucket> buckets;
+    for (const net::TcpConnectionPtr& conn : group) {
+        protocol::FrameFormat format = frame_format(conn);
+        protocol::FrameCompressorPtr codec = frame_codec(conn);
+        Bucket* bucket = nullptr;
+        for (Bucket& b : buckets) {
+            if (b.format == format && b.codec == codec) {
+                bucket = &b;
+                break;
+            }
+        }
+        if (!bucket) {
+            buckets.push_back(Bucket{format, std::move(codec), {}});
+            bucket = &buckets.back();
+        }
+        bucket->conns.push_back(conn);
+    }
+    for (const Bucket& bucket : buckets) {
+        broadcast_group(bucket.conns, msg, bucket.format, bucket.codec);
+    }
+}
+
+void ProtocolRouterComponent::broadcast_group(const std::vector<net::TcpConnectionPtr>& group,
+                                              const protocol::Message& msg,
+                                              protocol::FrameFormat format,
+                                              const protocol::FrameCompressorPtr& codec) {
+    net::SharedFrame frame = make_frame(msg, format, codec);
+    CHWELL_LOG_DEBUG("Broadcasting message cmd=0x" << std::hex << msg.cmd << std::dec
+                  << " size=" << frame.size() << " bytes to " << group.size() << " connection(s)"
+                  << (codec ? " (compressed)" : ""));
+    net::broadcast(group, frame);
+}
+
 } // namespace service
 } // namespace chwell
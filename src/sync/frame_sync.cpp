@@ -81,13 +81,13 @@ static std::string encode_bytes(const std::vector<uint8_t>& data) {
 void FrameSyncComponent::on_register(service::Service& svc) {
     auto* router = svc.get_component<service::ProtocolRouterComponent>();
     if (router) {
-        router->register_handler(frame_cmd::C2S_FRAME_INPUT,
-            [this](const net::TcpConnectionPtr& conn, const protocol::Message& msg) {
+        router->register_view_handler(frame_cmd::C2S_FRAME_INPUT,
+            [this](const net::TcpConnectionPtr& conn, const protocol::MessageView& msg) {
                 this->handle_frame_input(conn, msg.body);
             });
 
-        router->register_handler(frame_cmd::C2S_FRAME_SYNC_REQ,
-            [this](const net::TcpConnectionPtr& conn, const protocol::Message& msg) {
+        router->register_view_handler(frame_cmd::C2S_FRAME_SYNC_REQ,
+            [this](const net::TcpConnectionPtr& conn, const protocol::MessageView& msg) {
                 this->handle_frame_sync_req(conn, msg.body);
             });
 
@@ -97,7 +97,7 @@ void FrameSyncComponent::on_register(service::Service& svc) {
     }
 }
 
-void FrameSyncComponent::handle_frame_input(const net::TcpConnectionPtr& conn, const std::vector<char>& data) {
+void FrameSyncComponent::handle_frame_input(const net::TcpConnectionPtr& conn, std::string_view data) {
     // 解析: [player_id(4)][frame_id(4)][input_data_len(2)][input_data]
     const char* ptr = data.data();
     size_t size = data.size();
@@ -122,9 +122,9 @@ void FrameSyncComponent::handle_frame_input(const net::TcpConnectionPtr& conn, c
         return;
     }
 
-    CHWELL_LOG_INFO("Frame input: player_id=" + std::to_string(player_id) +
-                    ", frame_id=" + std::to_string(frame_id) +
-                    ", data_size=" + std::to_string(input_data.size()));
+    CHWELL_LOG_DEBUG("Frame input: player_id=" << player_id
+                     << ", frame_id=" << frame_id
+                     << ", data_size=" << input_data.size());
 
     // 提交输入到房间
     FrameInput input;
@@ -155,7 +155,7 @@ void FrameSyncComponent::handle_frame_input(const net::TcpConnectionPtr& conn, c
     }
 }
 
-void FrameSyncComponent::handle_frame_sync_req(const net::TcpConnectionPtr& conn, const std::vector<char>& data) {
+void FrameSyncComponent::handle_frame_sync_req(const net::TcpConnectionPtr& conn, std::string_view data) {
     // 解析: [room_id_len(2)][room_id]
     const char* ptr = data.data();
     size_t size = data.size();
@@ -308,9 +308,8 @@ void FrameSyncComponent::broadcast_frame_state(const std::string& room_id, const
 
     protocol::Message msg(frame_cmd::S2C_FRAME_STATE, std::vector<char>(body.begin(), body.end()));
 
-    for (const auto& conn : player_conns) {
-        service::ProtocolRouterComponent::send_message(conn, msg);
-    }
+    // 整个房间共用一份编码（协商了压缩的连接共用一份压缩结果）
+    service::ProtocolRouterComponent::broadcast_message(player_conns, msg);
 
     CHWELL_LOG_INFO("Broadcasted frame state to room " + room_id + ", frame_id=" + std::to_string(state.frame_id));
 }
@@ -1,10 +1,15 @@
 #include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <iostream>
 #include <thread>
 #include <vector>
 #include <chrono>
 #include <random>
 
 #include "chwell/benchmark/benchmark.h"
+#include "chwell/net/mux.h"
+#include "chwell/net/ws_deflate.h"
 #include "chwell/protocol/message.h"
 #include "chwell/service/protocol_router.h"
 
@@ -244,6 +249,18 @@ TEST(BenchmarkTest, ProtocolParserParse) {
         protocol_bench::benchmark_protocol_parser_parse(100, 1024);
     });
 
+    suite.add_benchmark("parser_views_10msg_100bytes",
+                        "Zero-copy view parse of 10 messages of 100 bytes each",
+                        []() {
+        protocol_bench::benchmark_protocol_parser_parse_views(1000, 100);
+    });
+
+    suite.add_benchmark("parser_views_10msg_1kbytes",
+                        "Zero-copy view parse of 10 messages of 1K bytes each",
+                        []() {
+        protocol_bench::benchmark_protocol_parser_parse_views(100, 1024);
+    });
+
     BenchmarkConfig config;
     config.warmup_iterations = 50;
     config.measurement_iterations = 1000;
@@ -251,7 +268,7 @@ TEST(BenchmarkTest, ProtocolParserParse) {
     auto results = suite.run(config);
     suite.print_results();
 
-    EXPECT_EQ(2u, results.size());
+    EXPECT_EQ(4u, results.size());
 }
 
 TEST(BenchmarkTest, ProtocolRouterDispatch) {
@@ -275,6 +292,12 @@ TEST(BenchmarkTest, ProtocolRouterDispatch) {
         protocol_bench::benchmark_protocol_router_dispatch(10, 1000);
     });
 
+    suite.add_benchmark("router_dispatch_view_10handlers",
+                        "Dispatch to 10 view handlers (no Message copy)",
+                        []() {
+        protocol_bench::benchmark_protocol_router_dispatch_view(100, 10);
+    });
+
     BenchmarkConfig config;
     config.warmup_iterations = 50;
     config.measurement_iterations = 1000;
@@ -282,7 +305,7 @@ TEST(BenchmarkTest, ProtocolRouterDispatch) {
     auto results = suite.run(config);
     suite.print_results();
 
-    EXPECT_EQ(3u, results.size());
+    EXPECT_EQ(4u, results.size());
 }
 
 TEST(BenchmarkTest, MessageCreateDestroy) {
@@ -372,3 +395,190 @@ TEST(BenchmarkTest, ProtocolFullSuite) {
 
     EXPECT_EQ(5u, results.size());
 }
+
+// epoll 与 io_uring 后端的回显 / 协议往返对比（io_uring 不可用时两组均为 epoll）
+TEST(BenchmarkTest, ServerRoundTripBackends) {
+    const net::IoBackend backends[] = {net::IoBackend::kEpoll, net::IoBackend::kIoUring};
+    unsigned short port = 19940;
+
+    BenchmarkSuite suite("Server Round Trip");
+    std::vector<std::unique_ptr<server_bench::RoundTripFixture>> fixtures;
+    for (net::IoBackend backend : backends) {
+        std::string tag = net::io_backend_name(backend);
+
+        fixtures.emplace_back(new server_bench::RoundTripFixture(
+            backend, server_bench::ServerMode::kEcho, port++, 2, 16));
+        server_bench::RoundTripFixture* echo = fixtures.back().get();
+        ASSERT_TRUE(echo->ready());
+        ASSERT_TRUE(echo->run(1, 64));
+        suite.add_benchmark("echo_16x64B_" + tag, "16 clients x 64B echo round trip", [echo]() {
+            server_bench::benchmark_echo_round_trip(*echo, 10, 64);
+        });
+
+        fixtures.emplace_back(new server_bench::RoundTripFixture(
+            backend, server_bench::ServerMode::kProtocol, port++, 2, 16));
+        server_bench::RoundTripFixture* proto = fixtures.back().get();
+        ASSERT_TRUE(proto->ready());
+        ASSERT_TRUE(proto->run(1, 128));
+        suite.add_benchmark("protocol_16x128B_" + tag, "16 clients x 128B protocol round trip", [proto]() {
+            server_bench::benchmark_protocol_round_trip(*proto, 10, 128);
+        });
+    }
+
+    BenchmarkConfig config;
+    config.warmup_iterations = 10;
+    config.measurement_iterations = 100;
+
+    auto results = suite.run(config);
+    suite.print_results();
+
+    EXPECT_EQ(4u, results.size());
+}
+
+TEST(BenchmarkTest, UdpLoopbackSendModes) {
+    const size_t kDatagrams = 1024;
+    const size_t kSegment = 1200;
+    const udp_bench::SendMode modes[] = {
+        udp_bench::SendMode::kSendTo,
+        udp_bench::SendMode::kSendBatch,
+        udp_bench::SendMode::kSegments,
+    };
+
+    BenchmarkSuite suite("UDP Loopback Send");
+    std::vector<std::unique_ptr<udp_bench::UdpLoopbackFixture>> fixtures;
+    unsigned short port = 19944;
+    for (bool gro : {false, true}) {
+        fixtures.emplace_back(new udp_bench::UdpLoopbackFixture(port++, gro));
+        udp_bench::UdpLoopbackFixture* fixture = fixtures.back().get();
+        ASSERT_TRUE(fixture->ready());
+        for (udp_bench::SendMode mode : modes) {
+            // 每种模式都有数据报送达（GSO 不可用时回退路径同样送达）
+            size_t delivered = fixture->run(mode, kDatagrams, kSegment);
+            std::cout << udp_bench::send_mode_name(mode) << (gro ? " +gro" : "")
+                      << ": delivered " << delivered << "/" << kDatagrams << std::endl;
+            EXPECT_GT(delivered, 0u);
+            std::string name = std::string(udp_bench::send_mode_name(mode)) +
+                               (gro ? "_gro" : "") + "_1024x1200B";
+            suite.add_benchmark(name, "1024 x 1200B datagrams over loopback", [fixture, mode]() {
+                udp_bench::benchmark_udp_send(*fixture, mode, kDatagrams, kSegment);
+            });
+        }
+    }
+
+    BenchmarkConfig config;
+    config.warmup_iterations = 5;
+    config.measurement_iterations = 50;
+
+    auto results = suite.run(config);
+    suite.print_results();
+
+    EXPECT_EQ(6u, results.size());
+}
+
+TEST(BenchmarkTest, InputLatencyTcpVsKcp) {
+    const size_t kInputs = 200;
+    const int kIntervalMs = 5;
+    const size_t kMsgSize = 32;
+
+    net::LinkImpairment lossy;
+    lossy.loss_rate = 0.1;
+    lossy.latency_ms = 20;
+    lossy.jitter_ms = 5;
+
+    net::KcpConfig fast = net::KcpConfig::fast();
+    fast.interval_ms = 5;
+
+    struct Row {
+        const char* name;
+        transport_bench::LatencyStats stats;
+    };
+    std::vector<Row> rows;
+    rows.push_back({"tcp loopback",
+                    transport_bench::measure_tcp_input_latency(19946, kInputs, kIntervalMs, kMsgSize)});
+    rows.push_back({"kcp fast loopback",
+                    transport_bench::measure_kcp_input_latency(fast, net::LinkImpairment(),
+                                                               kInputs, kIntervalMs, kMsgSize)});
+    rows.push_back({"kcp fast 10% loss +20ms",
+                    transport_bench::measure_kcp_input_latency(fast, lossy,
+                                                               kInputs, kIntervalMs, kMsgSize)});
+
+    for (const Row& row : rows) {
+        std::cout << row.name << ": samples=" << row.stats.samples
+                  << " p50=" << row.stats.p50_ms << "ms p99=" << row.stats.p99_ms
+                  << "ms max=" << row.stats.max_ms << "ms" << std::endl;
+        // 可靠传输：劣化链路上同样全部送达
+        EXPECT_EQ(kInputs, row.stats.samples);
+    }
+}
+
+TEST(BenchmarkTest, WsDeflateCpuVersusBytes) {
+    if (!net::ws_deflate_available()) {
+        GTEST_SKIP() << "built without zlib";
+    }
+    const size_t kRecipients = 50;
+    const size_t kTicks = 100;
+    const size_t kPlayers = 20;
+
+    for (int level : {1, 6}) {
+        std::vector<ws_bench::DeflateCost> costs =
+            ws_bench::measure_deflate_cost(kRecipients, kTicks, kPlayers, level);
+        ASSERT_EQ(4u, costs.size());
+        for (const ws_bench::DeflateCost& cost : costs) {
+            std::cout << "level " << level << " " << cost.mode << ": raw=" << cost.raw_bytes
+                      << " wire=" << cost.wire_bytes << " saved=" << cost.saved_ratio() * 100.0
+                      << "% cpu=" << cost.cpu_us_per_tick << "us/tick" << std::endl;
+        }
+        // 任一压缩模式都应显著减少字节；广播只压缩一次的 CPU 远低于逐连接压缩
+        EXPECT_GT(costs[1].saved_ratio(), 0.5);
+        EXPECT_GT(costs[3].saved_ratio(), 0.5);
+        EXPECT_LT(costs[3].cpu_us_per_tick * 5, costs[2].cpu_us_per_tick);
+    }
+}
+
+// C1M 低内存模式：对比普通模式与低内存模式下每个空闲连接的服务端内存。
+// 默认请求 10 万连接（同进程两端各占一个 fd，实际数量受 RLIMIT_NOFILE 限制），
+// 可用环境变量 CHWELL_BENCH_CONNECTIONS 调整
+TEST(BenchmarkTest, IdleConnectionFootprint) {
+    size_t requested = 100000;
+    if (const char* env = std::getenv("CHWELL_BENCH_CONNECTIONS")) {
+        requested = static_cast<size_t>(std::strtoul(env, nullptr, 10));
+    }
+
+    unsigned short port = 19947;
+    std::vector<conn_bench::ConnectionFootprint> results;
+    for (bool low_memory : {false, true}) {
+        conn_bench::ConnectionFootprint fp =
+            conn_bench::measure_idle_connection_footprint(port++, requested, low_memory, 2);
+        std::cout << (low_memory ? "low-memory" : "default   ") << ": connections=" << fp.connections
+                  << "/" << fp.requested << " heap=" << fp.heap_bytes_per_conn
+                  << " B/conn rss=" << fp.rss_bytes_per_conn << " B/conn connect="
+                  << fp.connect_seconds << "s" << std::endl;
+        ASSERT_GT(fp.connections, 0u);
+        results.push_back(fp);
+    }
+    // 低内存模式省掉每连接约 4KB 的读缓冲
+    EXPECT_LT(results[1].heap_bytes_per_conn * 2, results[0].heap_bytes_per_conn);
+}
+
+// 网关链路写合并：对比逐帧写出与合并写出时网关每条转发消息的 CPU 时间
+TEST(BenchmarkTest, GatewayLinkBatching) {
+    const size_t kClients = 64;
+    const size_t kRounds = 100;
+    const size_t kBody = 64;
+
+    unsigned short port = 19967;
+    std::vector<gateway_bench::ForwardCost> costs;
+    for (size_t batch_bytes : {size_t(0), net::MuxBatcher::kDefaultBatchBytes}) {
+        gateway_bench::ForwardCost cost = gateway_bench::measure_forward_cost(
+            port, static_cast<unsigned short>(port + 1), kClients, kRounds, kBody, batch_bytes);
+        port = static_cast<unsigned short>(port + 2);
+        std::cout << (batch_bytes ? "batched  " : "unbatched") << ": messages=" << cost.messages
+                  << " cpu=" << cost.cpu_us_per_msg << "us/msg frames/write="
+                  << cost.frames_per_write << std::endl;
+        ASSERT_EQ(kClients * kRounds, cost.messages);
+        costs.push_back(cost);
+    }
+    // 逐帧写出时每帧一次写；合并后同一轮读到的多个客户端消息共用一次写
+    EXPECT_DOUBLE_EQ(1.0, costs[0].frames_per_write);
+    EXPECT_GT(costs[1].frames_per_write, 2.0);
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "chwell/net/buffer.h"
+#include "chwell/codec/codec.h"
+
+using namespace chwell;
+
+TEST(BufferTest, RetrieveReusesFrontSpaceWithoutGrowing) {
+    net::Buffer buf(64);
+    buf.append(std::string(40, 'a'));
+    buf.retrieve(30);
+    EXPECT_EQ(10u, buf.readable_bytes());
+    EXPECT_EQ(30u + net::Buffer::kCheapPrepend, buf.prependable_bytes());
+
+    // 尾部只剩 24 字节，但前部已消费空间足够：搬移残余数据而不扩容
+    buf.append(std::string(50, 'b'));
+    EXPECT_EQ(64u, buf.capacity());
+    EXPECT_EQ(60u, buf.readable_bytes());
+    EXPECT_EQ(std::string(10, 'a') + std::string(50, 'b'), std::string(buf.view()));
+
+    buf.retrieve_all();
+    EXPECT_TRUE(buf.empty());
+    EXPECT_EQ(net::Buffer::kCheapPrepend, buf.prependable_bytes());
+}
+
+TEST(BufferTest, PrependWritesHeaderInFront) {
+    net::Buffer buf;
+    buf.append("body", 4);
+    const char header[2] = {'\x00', '\x04'};
+    buf.prepend(header, sizeof(header));
+    ASSERT_EQ(6u, buf.readable_bytes());
+    EXPECT_EQ(std::string("\x00\x04" "body", 6), buf.retrieve_as_string(6));
+}
+
+TEST(BufferTest, ReadFdSpillsIntoExtraBuffer) {
+    int fds[2];
+    ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    std::string payload(20000, 'x');
+    for (std::size_t i = 0; i < payload.size(); ++i) {
+        payload[i] = static_cast<char>('a' + i % 26);
+    }
+    ASSERT_EQ(static_cast<ssize_t>(payload.size()),
+              ::write(fds[1], payload.data(), payload.size()));
+
+    // 初始可写空间小于数据量：一次 readv 读完，超出部分经栈上临时区追加
+    net::Buffer buf(1024);
+    int saved_errno = 0;
+    std::size_t total = 0;
+    while (total < payload.size()) {
+        ssize_t n = buf.read_fd(fds[0], &saved_errno);
+        ASSERT_GT(n, 0);
+        total += static_cast<std::size_t>(n);
+    }
+    EXPECT_EQ(payload, std::string(buf.view()));
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+TEST(CodecTest, DecodeStringViewAcrossCalls) {
+    codec::LengthHeaderCodec length_codec;
+    codec::ProtobufCodec proto_codec;
+    codec::Codec* codecs[] = {&length_codec, &proto_codec};
+
+    for (codec::Codec* c : codecs) {
+        std::vector<char> stream = c->encode("first");
+        std::vector<char> second = c->encode(std::string(300, 'z'));
+        stream.insert(stream.end(), second.begin(), second.end());
+
+        // 第一次调用带一条完整帧和半条残帧，第二次补齐
+        std::size_t split = stream.size() - 100;
+        auto m1 = c->decode(std::string_view(stream.data(), split));
+        ASSERT_EQ(1u, m1.size());
+        EXPECT_EQ("first", m1[0]);
+
+        auto m2 = c->decode(std::string_view(stream.data() + split, stream.size() - split));
+        ASSERT_EQ(1u, m2.size());
+        EXPECT_EQ(std::string(300, 'z'), m2[0]);
+
+        EXPECT_TRUE(c->decode(std::vector<char>()).empty());
+    }
+}
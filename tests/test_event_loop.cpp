@@ -0,0 +1,1183 @@
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chwell/core/logger.h"
+#include "chwell/game/game_components.h"
+#include "chwell/metrics/prometheus_metrics.h"
+#include "chwell/net/connection_pool.h"
+#include "chwell/net/connector.h"
+#include "chwell/net/event_loop.h"
+#include "chwell/net/tcp_server.h"
+#include "chwell/net/udp_server.h"
+#include "chwell/service/protocol_router.h"
+#include "chwell/service/service.h"
+
+#include "test_net_helpers.h"
+
+using namespace chwell;
+using test::connect_local;
+using test::wait_until;
+using test::counter_value;
+
+namespace {
+
+constexpr unsigned short REACTOR_PORT_ECHO       = 19920;
+constexpr unsigned short REACTOR_PORT_DISCONNECT = 19921;
+constexpr unsigned short REACTOR_PORT_SERVICE    = 19922;
+constexpr unsigned short REACTOR_PORT_REUSEPORT  = 19923;
+constexpr unsigned short REACTOR_PORT_BACKLOG    = 19924;
+constexpr unsigned short REACTOR_PORT_SLOW_PEER  = 19925;
+constexpr unsigned short REACTOR_PORT_WATERMARK  = 19926;
+constexpr unsigned short REACTOR_PORT_EVICT      = 19927;
+constexpr unsigned short REACTOR_PORT_DROP_NEW   = 19928;
+constexpr unsigned short REACTOR_PORT_PAUSE      = 19929;
+constexpr unsigned short URING_PORT_ECHO         = 19930;
+constexpr unsigned short URING_PORT_PAUSE        = 19931;
+constexpr unsigned short URING_PORT_UDP          = 19932;
+constexpr unsigned short REACTOR_PORT_BROADCAST  = 19933;
+constexpr unsigned short UDP_PORT_BATCH          = 19934;
+constexpr unsigned short UDP_PORT_REUSEPORT      = 19935;
+constexpr unsigned short REACTOR_PORT_IDLE       = 19936;
+constexpr unsigned short REACTOR_PORT_HEARTBEAT  = 19937;
+constexpr unsigned short REACTOR_PORT_CORK       = 19939;
+constexpr unsigned short CONNECT_PORT_LISTEN     = 19957;
+constexpr unsigned short CONNECT_PORT_CLOSED     = 19958;
+constexpr unsigned short CONNECT_PORT_BACKLOG    = 19959;
+constexpr unsigned short POOL_PORT_BACKEND       = 19960;
+constexpr unsigned short REACTOR_PORT_STALL      = 19975;
+
+// 辅助：在 timeout_ms 内读满 expected 字节
+std::string read_exact(int fd, std::size_t expected, int timeout_ms = 2000) {
+    std::string out;
+    char buf[4096];
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (out.size() < expected && std::chrono::steady_clock::now() < deadline) {
+        pollfd pfd{fd, POLLIN, 0};
+        if (poll(&pfd, 1, 50) <= 0) continue;
+        ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n <= 0) break;
+        out.append(buf, static_cast<std::size_t>(n));
+    }
+    return out;
+}
+
+// 辅助：只 listen 不 accept 的本地监听 socket
+int listen_local(unsigned short port, int backlog) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, backlog) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 辅助：接收缓冲调小的客户端，用于模拟慢消费者
+int connect_slow_reader(unsigned short port) {
+    int fd = connect_local(port);
+    if (fd >= 0) {
+        int rcvbuf = 16 * 1024;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    }
+    return fd;
+}
+
+}  // namespace
+
+// ============================================
+// EventLoop 基础测试
+// ============================================
+
+TEST(EventLoopTest, RunInLoopFromOtherThread) {
+    net::EventLoopThreadPool pool(1);
+    pool.start();
+    net::EventLoop* loop = pool.next_loop();
+    ASSERT_NE(nullptr, loop);
+    EXPECT_FALSE(loop->is_in_loop_thread());
+
+    std::atomic<bool> in_loop{false};
+    std::atomic<bool> done{false};
+    loop->run_in_loop([&]() {
+        in_loop = loop->is_in_loop_thread();
+        done = true;
+    });
+
+    EXPECT_TRUE(wait_until([&]() { return done.load(); }));
+    EXPECT_TRUE(in_loop.load());
+    pool.stop();
+}
+
+TEST(EventLoopTest, PoolRoundRobin) {
+    net::EventLoopThreadPool pool(3);
+    pool.start();
+    EXPECT_EQ(3u, pool.size());
+
+    net::EventLoop* a = pool.next_loop();
+    net::EventLoop* b = pool.next_loop();
+    net::EventLoop* c = pool.next_loop();
+    net::EventLoop* d = pool.next_loop();
+    EXPECT_NE(a, b);
+    EXPECT_NE(b, c);
+    EXPECT_EQ(a, d);
+    pool.stop();
+}
+
+// ============================================
+// TcpServer 反应堆模式测试
+// ============================================
+
+// 2 个 I/O 线程同时承载远多于线程数的活跃连接
+TEST(TcpServerReactorTest, ManyConnectionsOnFewThreads) {
+    net::EventLoopThreadPool loops(2);
+    loops.start();
+    net::TcpServer server(loops, REACTOR_PORT_ECHO);
+    server.set_message_callback([](const net::TcpConnectionPtr& conn, std::string_view data) {
+        conn->send(data);
+    });
+    server.start_accept();
+
+    constexpr int N = 64;
+    std::vector<int> fds;
+    for (int i = 0; i < N; ++i) {
+        int fd = connect_local(REACTOR_PORT_ECHO);
+        ASSERT_GE(fd, 0);
+        fds.push_back(fd);
+    }
+    EXPECT_TRUE(wait_until([&]() { return server.connection_count() == N; }));
+
+    // 所有连接同时保持打开，每个都能得到回显
+    for (int i = 0; i < N; ++i) {
+        std::string msg = "ping_" + std::to_string(i);
+        ASSERT_EQ(static_cast<ssize_t>(msg.size()), ::write(fds[i], msg.data(), msg.size()));
+    }
+    for (int i = 0; i < N; ++i) {
+        std::string expected = "ping_" + std::to_string(i);
+        EXPECT_EQ(expected, read_exact(fds[i], expected.size()));
+    }
+
+    for (int fd : fds) ::close(fd);
+    EXPECT_TRUE(wait_until([&]() { return server.connection_count() == 0; }));
+    server.stop();
+    loops.stop();
+}
+
+TEST(TcpServerReactorTest, PeerCloseAndServerCloseTriggerDisconnect) {
+    net::EventLoopThreadPool loops(1);
+    loops.start();
+    net::TcpServer server(loops, REACTOR_PORT_DISCONNECT);
+
+    std::atomic<int> disconnects{0};
+    server.set_disconnect_callback([&](const net::TcpConnectionPtr&) { disconnects++; });
+    server.set_message_callback([](const net::TcpConnectionPtr& conn, std::string_view data) {
+        if (data == "bye") conn->close();
+    });
+    server.start_accept();
+
+    // 客户端主动关闭
+    int fd1 = connect_local(REACTOR_PORT_DISCONNECT);
+    ASSERT_GE(fd1, 0);
+    EXPECT_TRUE(wait_until([&]() { return server.connection_count() == 1; }));
+    ::close(fd1);
+    EXPECT_TRUE(wait_until([&]() { return disconnects.load() == 1; }));
+
+    // 服务端在回调中关闭
+    int fd2 = connect_local(REACTOR_PORT_DISCONNECT);
+    ASSERT_GE(fd2, 0);
+    ASSERT_EQ(3, ::write(fd2, "bye", 3));
+    EXPECT_TRUE(wait_until([&]() { return disconnects.load() == 2; }));
+    EXPECT_EQ("", read_exact(fd2, 1, 200));  // 对端已关闭，读到 EOF
+    ::close(fd2);
+
+    EXPECT_EQ(0u, server.connection_count());
+    server.stop();
+    loops.stop();
+}
+
+// 空闲超时：持续收到数据的连接保留，静默的连接由 loop 时间轮关闭并触发 disconnect 回调
+TEST(TcpServerReactorTest, IdleConnectionsAreReaped) {
+    net::EventLoopThreadPool loops(1);
+    loops.start();
+    net::TcpServer server(loops, REACTOR_PORT_IDLE);
+    net::TcpServerConfig config;
+    config.idle.read_idle_ms = 300;
+    server.set_config(config);
+
+    std::atomic<int> disconnects{0};
+    server.set_disconnect_callback([&](const net::TcpConnectionPtr&) { disconnects++; });
+    server.set_message_callback([](const net::TcpConnectionPtr&, std::string_view) {});
+    server.start_accept();
+    const double timeouts_before = counter_value("chwell_net_idle_timeouts_total");
+
+    int active = connect_local(REACTOR_PORT_IDLE);
+    int silent = connect_local(REACTOR_PORT_IDLE);
+    ASSERT_GE(active, 0);
+    ASSERT_GE(silent, 0);
+    EXPECT_TRUE(wait_until([&]() { return server.connection_count() == 2; }));
+
+    // 活跃连接每 100ms 发一次心跳，持续超过超时时间的两倍
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_EQ(1, ::write(active, "h", 1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    EXPECT_EQ(1, disconnects.load());
+    EXPECT_EQ(1u, server.connection_count());
+    EXPECT_EQ("", read_exact(silent, 1, 200));  // 静默连接已被关闭
+
+    // 活跃连接停止发送后同样被回收（超时 + 至多一个 tick）
+    start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(wait_until([&]() { return disconnects.load() == 2; }));
+    auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    EXPECT_GE(waited, 250);
+    EXPECT_LE(waited, 1000);
+    EXPECT_EQ(0u, server.connection_count());
+    EXPECT_DOUBLE_EQ(timeouts_before + 2, counter_value("chwell_net_idle_timeouts_total"));
+
+    ::close(active);
+    ::close(silent);
+    server.stop();
+    loops.stop();
+}
+
+// HeartbeatComponent 为 Service 启用 HEARTBEAT_TIMEOUT 读空闲超时，显式配置的值优先
+TEST(TcpServerReactorTest, HeartbeatComponentEnablesReadIdleTimeout) {
+    service::Service svc(REACTOR_PORT_HEARTBEAT, 1);
+    svc.add_component<service::ProtocolRouterComponent>();
+    svc.add_component<game::HeartbeatComponent>();
+    EXPECT_EQ(60 * 1000, svc.tcp_server().config().idle.read_idle_ms);
+
+    service::Service custom(REACTOR_PORT_HEARTBEAT + 1, 1);
+    net::TcpServerConfig config;
+    config.idle.read_idle_ms = 5000;
+    custom.tcp_server().set_config(config);
+    custom.add_component<game::HeartbeatComponent>();
+    EXPECT_EQ(5000, custom.tcp_server().config().idle.read_idle_ms);
+}
+
+// 发送合并：tick 内的发送（含 broadcast）只入队，在 tick 边界一次写出；flush() / flush_corked() 立即写出
+TEST(TcpServerReactorTest, CorkedSendsFlushAtTickBoundary) {
+    const int tick = 300;
+    net::EventLoopThreadPool loops(1);
+    loops.start();
+    net::TcpServer server(loops, REACTOR_PORT_CORK);
+    net::TcpServerConfig config;
+    config.cork_tick_ms = tick;
+    server.set_config(config);
+
+    std::mutex mu;
+    net::TcpConnectionPtr server_conn;
+    server.set_connection_callback([&](const net::TcpConnectionPtr& c) {
+        std::lock_guard<std::mutex> lock(mu);
+        server_conn = c;
+    });
+    server.set_message_callback([](const net::TcpConnectionPtr&, std::string_view) {});
+    server.start_accept();
+
+    int fd = connect_local(REACTOR_PORT_CORK);
+    ASSERT_GE(fd, 0);
+    ASSERT_TRUE(wait_until([&]() {
+        std::lock_guard<std::mutex> lock(mu);
+        return server_conn != nullptr;
+    }));
+    net::TcpConnectionPtr conn;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        conn = server_conn;
+    }
+    EXPECT_TRUE(conn->corked());
+    EXPECT_EQ(tick, conn->loop()->cork_tick_ms());
+
+    // tick 边界按单调时钟对齐：从 tick 开头附近发送，保证有足够时间观察暂存状态
+    auto wait_tick_start = [&]() {
+        while (std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count() % tick > 20) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    };
+
+    wait_tick_start();
+    conn->send(std::string_view("a"));
+    conn->send(std::string_view("b"), std::string_view("c"));
+    net::broadcast({conn}, net::SharedFrame(std::string("d")));
+    EXPECT_EQ(4u, conn->output_buffer_bytes());
+    EXPECT_EQ("", read_exact(fd, 1, 150));
+    EXPECT_EQ("abcd", read_exact(fd, 4, tick));
+    EXPECT_EQ(0u, conn->output_buffer_bytes());
+
+    // 延迟敏感的消息显式 flush，不等 tick 边界
+    wait_tick_start();
+    conn->send(std::string_view("e"));
+    conn->flush();
+    EXPECT_EQ("e", read_exact(fd, 1, 100));
+
+    // 业务帧结束时结束整个 loop 的当前 tick
+    wait_tick_start();
+    conn->send(std::string_view("f"));
+    conn->loop()->flush_corked();
+    EXPECT_EQ("f", read_exact(fd, 1, 100));
+
+    // 关闭 cork 时写出暂存数据，之后的发送直接写出
+    wait_tick_start();
+    conn->send(std::string_view("g"));
+    conn->set_cork(false);
+    conn->send(std::string_view("h"));
+    EXPECT_EQ("gh", read_exact(fd, 2, 100));
+
+    ::close(fd);
+    server.stop();
+    loops.stop();
+}
+
+// Service + Component：on_message / on_disconnect 语义保持不变
+TEST(TcpServerReactorTest, ServiceComponentsOnReactor) {
+    struct CountingComponent : public service::Component {
+        std::atomic<int> messages{0};
+        std::atomic<int> disconnects{0};
+        std::string name() const override { return "CountingComponent"; }
+        void on_message(const net::TcpConnectionPtr& conn, std::string_view data) override {
+            messages++;
+            conn->send(data);
+        }
+        void on_disconnect(const net::TcpConnectionPtr&) override { disconnects++; }
+    };
+
+    service::Service svc(REACTOR_PORT_SERVICE, 2);
+    auto* comp = svc.add_component<CountingComponent>();
+    svc.start();
+
+    constexpr int N = 16;  // 连接数远大于 worker_threads
+    std::vector<int> fds;
+    for (int i = 0; i < N; ++i) {
+        int fd = connect_local(REACTOR_PORT_SERVICE);
+        ASSERT_GE(fd, 0);
+        fds.push_back(fd);
+        ASSERT_EQ(2, ::write(fd, "hi", 2));
+    }
+    for (int fd : fds) {
+        EXPECT_EQ("hi", read_exact(fd, 2));
+    }
+    EXPECT_EQ(N, comp->messages.load());
+
+    for (int fd : fds) ::close(fd);
+    EXPECT_TRUE(wait_until([&]() { return comp->disconnects.load() == N; }));
+    svc.stop();
+}
+
+// SO_REUSEPORT 模式：每个 loop 独立监听，连接由接收它的 loop 承载
+TEST(TcpServerReactorTest, ReusePortShardedAcceptors) {
+    net::EventLoopThreadPool loops(2);
+    loops.start();
+    net::TcpServer server(loops, REACTOR_PORT_REUSEPORT);
+    net::TcpServerConfig cfg;
+    cfg.reuse_port = true;
+    cfg.backlog = 512;
+    cfg.accept_batch = 4;
+    server.set_config(cfg);
+
+    std::atomic<int> same_loop{0};
+    server.set_message_callback([&](const net::TcpConnectionPtr& conn, std::string_view data) {
+        if (conn->loop()->is_in_loop_thread()) same_loop++;
+        conn->send(data);
+    });
+    server.start_accept();
+
+    // 每个 loop 各注册了一个监听 fd
+    std::atomic<int> registered{0};
+    for (std::size_t i = 0; i < loops.size(); ++i) {
+        net::EventLoop* loop = loops.get_loop(i);
+        loop->run_in_loop([&, loop]() { registered += static_cast<int>(loop->fd_count()); });
+    }
+    EXPECT_TRUE(wait_until([&]() { return registered.load() == 2; }));
+
+    // 连接数大于 accept_batch，验证分批取尽
+    constexpr int N = 48;
+    std::vector<int> fds;
+    for (int i = 0; i < N; ++i) {
+        int fd = connect_local(REACTOR_PORT_REUSEPORT);
+        ASSERT_GE(fd, 0);
+        fds.push_back(fd);
+    }
+    EXPECT_TRUE(wait_until([&]() { return server.connection_count() == N; }));
+
+    for (int i = 0; i < N; ++i) {
+        std::string msg = "rp_" + std::to_string(i);
+        ASSERT_EQ(static_cast<ssize_t>(msg.size()), ::write(fds[i], msg.data(), msg.size()));
+        EXPECT_EQ(msg, read_exact(fds[i], msg.size()));
+    }
+    EXPECT_EQ(N, same_loop.load());
+
+    for (int fd : fds) ::close(fd);
+    EXPECT_TRUE(wait_until([&]() { return server.connection_count() == 0; }));
+    server.stop();
+
+    // 停止后监听 socket 已关闭
+    EXPECT_LT(connect_local(REACTOR_PORT_REUSEPORT), 0);
+    loops.stop();
+}
+
+// 默认模式下 backlog / accept_batch 同样生效，且构造期不占用端口
+TEST(TcpServerReactorTest, ConfiguredBacklogAndBatchedAccept) {
+    net::EventLoopThreadPool loops(1);
+    loops.start();
+    net::TcpServer server(loops, REACTOR_PORT_BACKLOG);
+    EXPECT_LT(connect_local(REACTOR_PORT_BACKLOG), 0);
+
+    net::TcpServerConfig cfg;
+    cfg.backlog = 256;
+    cfg.accept_batch = 2;
+    server.set_config(cfg);
+    EXPECT_EQ(256, server.config().backlog);
+    server.start_accept();
+
+    constexpr int N = 20;
+    std::vector<int> fds;
+    for (int i = 0; i < N; ++i) {
+        int fd = connect_local(REACTOR_PORT_BACKLOG);
+        ASSERT_GE(fd, 0);
+        fds.push_back(fd);
+    }
+    EXPECT_TRUE(wait_until([&]() { return server.connection_count() == N; }));
+
+    for (int fd : fds) ::close(fd);
+    EXPECT_TRUE(wait_until([&]() { return server.connection_count() == 0; }));
+    server.stop();
+    loops.stop();
+}
+
+// 对端不读时 send 不阻塞调用线程：数据进入输出缓冲，可写后按序写出并清空
+TEST(TcpServerReactorTest, SendToSlowPeerDoesNotBlock) {
+    net::EventLoopThreadPool loops(1);
+    loops.start();
+    net::TcpServer server(loops, REACTOR_PORT_SLOW_PEER);
+
+    std::mutex conn_mutex;
+    net::TcpConnectionPtr server_conn;
+    server.set_connection_callback([&](const net::TcpConnectionPtr& conn) {
+        std::lock_guard<std::mutex> lock(conn_mutex);
+        server_conn = conn;
+    });
+    server.start_accept();
+
+    int fd = connect_local(REACTOR_PORT_SLOW_PEER);
+    ASSERT_GE(fd, 0);
+    int rcvbuf = 16 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    ASSERT_TRUE(wait_until([&]() {
+        std::lock_guard<std::mutex> lock(conn_mutex);
+        return server_conn != nullptr;
+    }));
+
+    // 多个小帧 + 远超内核缓冲的数据，从非 loop 线程发送
+    constexpr std::size_t kChunk = 64 * 1024;
+    constexpr int kChunks = 64;
+    std::string expected;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < kChunks; ++i) {
+        std::string chunk(kChunk, static_cast<char>('a' + i % 26));
+        expected += chunk;
+        server_conn->send(chunk);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    EXPECT_LT(elapsed, std::chrono::seconds(1));
+    EXPECT_GT(server_conn->output_buffer_bytes(), 0u);
+
+    std::string received = read_exact(fd, expected.size(), 10000);
+    EXPECT_EQ(expected.size(), received.size());
+    EXPECT_TRUE(received == expected);
+    EXPECT_TRUE(wait_until([&]() { return server_conn->output_buffer_bytes() == 0; }));
+
+    ::close(fd);
+    EXPECT_TRUE(wait_until([&]() { return server.connection_count() == 0; }));
+    server_conn.reset();
+    server.stop();
+    loops.stop();
+}
+
+// ============================================
+// 输出缓冲背压
+// ============================================
+
+namespace {
+
+// 单 loop 服务器 + 记录最近一个服务端连接
+struct BackpressureServer {
+    net::EventLoopThreadPool loops{1};
+    net::TcpServer server;
+    std::mutex mutex;
+    net::TcpConnectionPtr conn;
+    std::atomic<int> disconnects{0};
+
+    BackpressureServer(unsigned short port, const net::BackpressureConfig& bp)
+        : server(loops, port) {
+        loops.start();
+        net::TcpServerConfig cfg;
+        cfg.backpressure = bp;
+        server.set_config(cfg);
+        server.set_connection_callback([this](const net::TcpConnectionPtr& c) {
+            std::lock_guard<std::mutex> lock(mutex);
+            conn = c;
+        });
+        server.set_disconnect_callback([this](const net::TcpConnectionPtr&) { disconnects++; });
+        server.start_accept();
+    }
+
+    ~BackpressureServer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            conn.reset();
+        }
+        server.stop();
+        loops.stop();
+    }
+
+    net::TcpConnectionPtr wait_conn() {
+        wait_until([this]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return conn != nullptr;
+        });
+        std::lock_guard<std::mutex> lock(mutex);
+        return conn;
+    }
+};
+
+}  // namespace
+
+TEST(TcpConnectionBackpressureTest, HighAndLowWatermarkCallbacks) {
+    net::BackpressureConfig bp;
+    bp.high_watermark = 64 * 1024;
+    bp.low_watermark = 16 * 1024;
+    bp.max_output_bytes = 0;
+    bp.max_stall_ms = 0;
+    BackpressureServer srv(REACTOR_PORT_WATERMARK, bp);
+
+    double high_before = counter_value("chwell_net_high_watermark_total");
+    double low_before = counter_value("chwell_net_low_watermark_total");
+
+    int fd = connect_slow_reader(REACTOR_PORT_WATERMARK);
+    ASSERT_GE(fd, 0);
+    net::TcpConnectionPtr conn = srv.wait_conn();
+    ASSERT_NE(nullptr, conn);
+
+    std::atomic<int> highs{0};
+    std::atomic<int> lows{0};
+    std::atomic<bool> high_in_loop{false};
+    conn->set_high_watermark_callback([&](const net::TcpConnectionPtr& c, std::size_t bytes) {
+        high_in_loop = c->loop()->is_in_loop_thread();
+        EXPECT_GE(bytes, 64u * 1024);
+        highs++;
+    });
+    conn->set_low_watermark_callback([&](const net::TcpConnectionPtr&, std::size_t bytes) {
+        EXPECT_LE(bytes, 16u * 1024);
+        lows++;
+    });
+
+    // 远超内核发送缓冲，保证输出缓冲越过高水位
+    constexpr int kChunks = 256;
+    std::string chunk(32 * 1024, 'w');
+    for (int i = 0; i < kChunks; ++i) conn->send(chunk);
+    EXPECT_TRUE(wait_until([&]() { return highs.load() == 1; }));
+    EXPECT_TRUE(high_in_loop.load());
+    EXPECT_EQ(0, lows.load());
+
+    // 对端读完后回落到低水位
+    EXPECT_EQ(chunk.size() * kChunks, read_exact(fd, chunk.size() * kChunks, 10000).size());
+    EXPECT_TRUE(wait_until([&]() { return lows.load() == 1; }));
+    EXPECT_EQ(1, highs.load());
+    EXPECT_GE(counter_value("chwell_net_high_watermark_total"), high_before + 1);
+    EXPECT_GE(counter_value("chwell_net_low_watermark_total"), low_before + 1);
+    ::close(fd);
+}
+
+TEST(TcpConnectionBackpressureTest, SlowConsumerIsEvictedOverByteBudget) {
+    net::BackpressureConfig bp;
+    bp.max_output_bytes = 256 * 1024;
+    bp.policy = net::SlowConsumerPolicy::kDisconnect;
+    BackpressureServer srv(REACTOR_PORT_EVICT, bp);
+    double evicted_before = counter_value("chwell_net_slow_consumer_evicted_total");
+
+    int fd = connect_slow_reader(REACTOR_PORT_EVICT);
+    ASSERT_GE(fd, 0);
+    net::TcpConnectionPtr conn = srv.wait_conn();
+    ASSERT_NE(nullptr, conn);
+
+    std::string chunk(64 * 1024, 'e');
+    for (int i = 0; i < 128; ++i) conn->send(chunk);
+
+    EXPECT_TRUE(wait_until([&]() { return srv.disconnects.load() == 1; }));
+    EXPECT_EQ(0u, conn->output_buffer_bytes());
+    EXPECT_GE(counter_value("chwell_net_slow_consumer_evicted_total"), evicted_before + 1);
+    ::close(fd);
+}
+
+TEST(TcpConnectionBackpressureTest, StalledPeerIsEvictedWithoutFurtherSends) {
+    net::BackpressureConfig bp;
+    bp.high_watermark = 64 * 1024;
+    bp.low_watermark = 16 * 1024;
+    bp.max_output_bytes = 0;
+    bp.max_stall_ms = 300;
+    BackpressureServer srv(REACTOR_PORT_STALL, bp);
+    double evicted_before = counter_value("chwell_net_slow_consumer_evicted_total");
+
+    int fd = connect_slow_reader(REACTOR_PORT_STALL);
+    ASSERT_GE(fd, 0);
+    net::TcpConnectionPtr conn = srv.wait_conn();
+    ASSERT_NE(nullptr, conn);
+
+    // 越过高水位后不再发送：对端不读，既没有可写事件也没有新的 send，只能由定时器执行时间预算
+    std::string chunk(32 * 1024, 's');
+    for (int i = 0; i < 128; ++i) conn->send(chunk);
+    EXPECT_GT(conn->output_buffer_bytes(), 64u * 1024);
+
+    EXPECT_TRUE(wait_until([&]() { return srv.disconnects.load() == 1; }, 3000));
+    EXPECT_EQ(0u, conn->output_buffer_bytes());
+    EXPECT_GE(counter_value("chwell_net_slow_consumer_evicted_total"), evicted_before + 1);
+    ::close(fd);
+}
+
+TEST(TcpConnectionBackpressureTest, DropNewPolicyKeepsConnectionWithinBudget) {
+    net::BackpressureConfig bp;
+    bp.max_output_bytes = 256 * 1024;
+    bp.max_stall_ms = 0;
+    bp.policy = net::SlowConsumerPolicy::kDropNew;
+    BackpressureServer srv(REACTOR_PORT_DROP_NEW, bp);
+    double dropped_before = counter_value("chwell_net_slow_consumer_dropped_frames_total");
+
+    int fd = connect_slow_reader(REACTOR_PORT_DROP_NEW);
+    ASSERT_GE(fd, 0);
+    net::TcpConnectionPtr conn = srv.wait_conn();
+    ASSERT_NE(nullptr, conn);
+
+    std::string chunk(64 * 1024, 'd');
+    for (int i = 0; i < 128; ++i) conn->send(chunk);
+
+    EXPECT_LE(conn->output_buffer_bytes(), 256u * 1024);
+    EXPECT_GT(counter_value("chwell_net_slow_consumer_dropped_frames_total"), dropped_before);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(0, srv.disconnects.load());
+    EXPECT_EQ(1u, srv.server.connection_count());
+    ::close(fd);
+}
+
+TEST(TcpConnectionBackpressureTest, PauseAndResumeReading) {
+    net::EventLoopThreadPool loops(1);
+    loops.start();
+    net::TcpServer server(loops, REACTOR_PORT_PAUSE);
+    std::atomic<int> received{0};
+    std::mutex conn_mutex;
+    net::TcpConnectionPtr server_conn;
+    server.set_connection_callback([&](const net::TcpConnectionPtr& c) {
+        std::lock_guard<std::mutex> lock(conn_mutex);
+        server_conn = c;
+    });
+    server.set_message_callback([&](const net::TcpConnectionPtr&, std::string_view data) {
+        received += static_cast<int>(data.size());
+    });
+    server.start_accept();
+
+    int fd = connect_local(REACTOR_PORT_PAUSE);
+    ASSERT_GE(fd, 0);
+    ASSERT_TRUE(wait_until([&]() {
+        std::lock_guard<std::mutex> lock(conn_mutex);
+        return server_conn != nullptr;
+    }));
+
+    server_conn->pause_reading();
+    EXPECT_FALSE(server_conn->is_reading());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT_EQ(4, ::write(fd, "abcd", 4));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(0, received.load());
+
+    // 恢复后之前积压在内核缓冲中的数据被读出
+    server_conn->resume_reading();
+    EXPECT_TRUE(wait_until([&]() { return received.load() == 4; }));
+
+    ::close(fd);
+    EXPECT_TRUE(wait_until([&]() { return server.connection_count() == 0; }));
+    server_conn.reset();
+    server.stop();
+    loops.stop();
+}
+
+// ============================================
+// 共享帧广播
+// ============================================
+
+// 跨 2 个 loop 的连接共享同一帧；与前后 send 保持顺序，写出后帧引用全部释放
+TEST(SharedFrameBroadcastTest, BroadcastAcrossLoopsKeepsOrder) {
+    net::EventLoopThreadPool loops(2);
+    loops.start();
+    net::TcpServer server(loops, REACTOR_PORT_BROADCAST);
+    std::mutex conns_mutex;
+    std::vector<net::TcpConnectionPtr> conns;
+    server.set_connection_callback([&](const net::TcpConnectionPtr& c) {
+        std::lock_guard<std::mutex> lock(conns_mutex);
+        conns.push_back(c);
+    });
+    server.start_accept();
+
+    constexpr int N = 8;
+    std::vector<int> fds;
+    for (int i = 0; i < N; ++i) {
+        int fd = connect_local(REACTOR_PORT_BROADCAST);
+        ASSERT_GE(fd, 0);
+        fds.push_back(fd);
+    }
+    ASSERT_TRUE(wait_until([&]() {
+        std::lock_guard<std::mutex> lock(conns_mutex);
+        return conns.size() == static_cast<std::size_t>(N);
+    }));
+
+    std::vector<net::TcpConnectionPtr> group;
+    {
+        std::lock_guard<std::mutex> lock(conns_mutex);
+        group = conns;
+    }
+    EXPECT_NE(group.front()->loop(), group.back()->loop());
+
+    net::SharedFrame frame(std::string("room-frame"));
+    for (const auto& c : group) c->send(std::string_view("[", 1));
+    net::broadcast(group, frame);
+    for (const auto& c : group) c->send(std::string_view("]", 1));
+
+    for (int fd : fds) {
+        EXPECT_EQ("[room-frame]", read_exact(fd, 12));
+    }
+    EXPECT_TRUE(wait_until([&]() { return frame.use_count() == 1; }));
+
+    group.clear();
+    for (int fd : fds) ::close(fd);
+    EXPECT_TRUE(wait_until([&]() { return server.connection_count() == 0; }));
+    {
+        std::lock_guard<std::mutex> lock(conns_mutex);
+        conns.clear();
+    }
+    server.stop();
+    loops.stop();
+}
+
+// ============================================
+// io_uring 后端测试（内核或编译选项不支持时跳过）
+// ============================================
+
+TEST(IoBackendTest, ParseAndFallback) {
+    EXPECT_EQ(net::IoBackend::kIoUring, net::parse_io_backend("io_uring"));
+    EXPECT_EQ(net::IoBackend::kIoUring, net::parse_io_backend("uring"));
+    EXPECT_EQ(net::IoBackend::kEpoll, net::parse_io_backend("epoll", net::IoBackend::kIoUring));
+    EXPECT_EQ(net::IoBackend::kIoUring, net::parse_io_backend("bogus", net::IoBackend::kIoUring));
+    EXPECT_EQ(net::IoBackend::kEpoll, net::parse_io_backend(nullptr));
+
+    // 不可用时自动回退 epoll，loop 依然可用
+    net::EventLoop epoll_loop(net::IoBackend::kEpoll);
+    EXPECT_EQ(net::IoBackend::kEpoll, epoll_loop.backend());
+    EXPECT_FALSE(epoll_loop.supports_recv());
+    net::EventLoop uring_loop(net::IoBackend::kIoUring);
+    EXPECT_EQ(net::io_uring_available() ? net::IoBackend::kIoUring : net::IoBackend::kEpoll,
+              uring_loop.backend());
+}
+
+TEST(IoUringBackendTest, EchoAndPeerClose) {
+    if (!net::io_uring_available()) GTEST_SKIP() << "io_uring not available";
+    net::EventLoopThreadPool loops(2);
+    loops.set_backend(net::IoBackend::kIoUring);
+    loops.start();
+    ASSERT_EQ(net::IoBackend::kIoUring, loops.get_loop(0)->backend());
+
+    net::TcpServer server(loops, URING_PORT_ECHO);
+    server.set_message_callback([](const net::TcpConnectionPtr& conn, std::string_view data) {
+        conn->send(data);
+    });
+    server.start_accept();
+
+    constexpr int N = 32;
+    std::vector<int> fds;
+    for (int i = 0; i < N; ++i) {
+        int fd = connect_local(URING_PORT_ECHO);
+        ASSERT_GE(fd, 0);
+        fds.push_back(fd);
+    }
+    EXPECT_TRUE(wait_until([&]() { return server.connection_count() == N; }));
+
+    // 超过单个接收缓冲（4KB）的数据跨多个完成事件交付，顺序不变
+    std::string big(64 * 1024, '\0');
+    for (std::size_t i = 0; i < big.size(); ++i) big[i] = static_cast<char>('a' + i % 26);
+    ASSERT_EQ(static_cast<ssize_t>(big.size()), ::write(fds[0], big.data(), big.size()));
+    EXPECT_EQ(big, read_exact(fds[0], big.size()));
+
+    for (int i = 1; i < N; ++i) {
+        std::string msg = "uring_" + std::to_string(i);
+        ASSERT_EQ(static_cast<ssize_t>(msg.size()), ::write(fds[i], msg.data(), msg.size()));
+        EXPECT_EQ(msg, read_exact(fds[i], msg.size()));
+    }
+
+    for (int fd : fds) ::close(fd);
+    EXPECT_TRUE(wait_until([&]() { return server.connection_count() == 0; }));
+    server.stop();
+    loops.stop();
+}
+
+TEST(IoUringBackendTest, PauseAndResumeReading) {
+    if (!net::io_uring_available()) GTEST_SKIP() << "io_uring not available";
+    net::EventLoopThreadPool loops(1);
+    loops.set_backend(net::IoBackend::kIoUring);
+    loops.start();
+    net::TcpServer server(loops, URING_PORT_PAUSE);
+    std::atomic<int> received{0};
+    std::mutex conn_mutex;
+    net::TcpConnectionPtr server_conn;
+    server.set_connection_callback([&](const net::TcpConnectionPtr& c) {
+        std::lock_guard<std::mutex> lock(conn_mutex);
+        server_conn = c;
+    });
+    server.set_message_callback([&](const net::TcpConnectionPtr&, std::string_view data) {
+        received += static_cast<int>(data.size());
+    });
+    server.start_accept();
+
+    int fd = connect_local(URING_PORT_PAUSE);
+    ASSERT_GE(fd, 0);
+    ASSERT_TRUE(wait_until([&]() {
+        std::lock_guard<std::mutex> lock(conn_mutex);
+        return server_conn != nullptr;
+    }));
+
+    server_conn->pause_reading();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT_EQ(4, ::write(fd, "abcd", 4));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(0, received.load());
+
+    server_conn->resume_reading();
+    EXPECT_TRUE(wait_until([&]() { return received.load() == 4; }));
+
+    ::close(fd);
+    EXPECT_TRUE(wait_until([&]() { return server.connection_count() == 0; }));
+    server_conn.reset();
+    server.stop();
+    loops.stop();
+}
+
+TEST(IoUringBackendTest, UdpServerReceivesOnLoop) {
+    if (!net::io_uring_available()) GTEST_SKIP() << "io_uring not available";
+    net::IoService io_service;
+    std::thread io_thread([&]() { io_service.run(); });
+
+    net::UdpServer server(io_service, URING_PORT_UDP);
+    server.set_backend(net::IoBackend::kIoUring);
+    std::atomic<int> received{0};
+    server.set_message_callback([&](const std::vector<char>& data, const net::UdpEndpoint& remote) {
+        received += static_cast<int>(data.size());
+        server.send_to(data, remote);
+    });
+    server.start_receive();
+
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(fd, 0);
+    net::UdpEndpoint dest("127.0.0.1", URING_PORT_UDP);
+    for (int i = 0; i < 8; ++i) {
+        ::sendto(fd, "dgram", 5, 0, reinterpret_cast<const sockaddr*>(&dest.addr_),
+                 sizeof(dest.addr_));
+    }
+    EXPECT_TRUE(wait_until([&]() { return received.load() == 40; }));
+    EXPECT_EQ("dgram", read_exact(fd, 5));
+
+    ::close(fd);
+    server.stop();
+    io_service.stop();
+    io_thread.join();
+}
+
+TEST(UdpServerTest, BatchCallbackEchoesWithSendBatch) {
+    net::IoService io_service;
+    net::UdpServerConfig config;
+    config.recv_batch = 8;
+    config.max_datagram_size = 64;
+    net::UdpServer server(io_service, UDP_PORT_BATCH, config);
+    ASSERT_EQ(1u, server.socket_count());
+
+    std::atomic<int> datagrams{0};
+    std::atomic<int> max_batch{0};
+    server.set_batch_callback([&](const std::vector<net::UdpDatagram>& batch) {
+        datagrams += static_cast<int>(batch.size());
+        if (static_cast<int>(batch.size()) > max_batch.load()) {
+            max_batch = static_cast<int>(batch.size());
+        }
+        // 视图直接回送：send_batch 期间 slab 仍有效
+        EXPECT_EQ(batch.size(), server.send_batch(batch));
+    });
+
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(fd, 0);
+    net::UdpEndpoint dest("127.0.0.1", UDP_PORT_BATCH);
+    // 先发后启动接收：数据报积压在 socket 中，由 recvmmsg 成批取走
+    for (int i = 0; i < 20; ++i) {
+        std::string payload = "dgram-" + std::to_string(i % 10);
+        ::sendto(fd, payload.data(), payload.size(), 0,
+                 reinterpret_cast<const sockaddr*>(&dest.addr_), sizeof(dest.addr_));
+    }
+    std::string oversized(200, 'x');
+    ::sendto(fd, oversized.data(), oversized.size(), 0,
+             reinterpret_cast<const sockaddr*>(&dest.addr_), sizeof(dest.addr_));
+    double truncated_before = counter_value("chwell_net_udp_truncated_total");
+    server.start_receive();
+
+    EXPECT_TRUE(wait_until([&]() { return datagrams.load() == 20; }));
+    EXPECT_EQ(8, max_batch.load());
+    EXPECT_TRUE(wait_until([&]() {
+        return counter_value("chwell_net_udp_truncated_total") == truncated_before + 1;
+    }));
+    EXPECT_EQ("dgram-0", read_exact(fd, 7));
+
+    ::close(fd);
+    server.stop();
+}
+
+TEST(UdpServerTest, ReusePortSocketsReceiveOnSeparateThreads) {
+    net::IoService io_service;
+    net::UdpServerConfig config;
+    config.num_sockets = 2;
+    net::UdpServer server(io_service, UDP_PORT_REUSEPORT, config);
+    ASSERT_EQ(2u, server.socket_count());
+
+    std::mutex mu;
+    std::set<std::thread::id> threads;
+    std::atomic<int> received{0};
+    server.set_batch_callback([&](const std::vector<net::UdpDatagram>& batch) {
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            threads.insert(std::this_thread::get_id());
+        }
+        received += static_cast<int>(batch.size());
+    });
+    server.start_receive();
+
+    // 多个源端口：内核按四元组哈希分散到两个 socket
+    const int kClients = 32;
+    std::vector<int> fds;
+    net::UdpEndpoint dest("127.0.0.1", UDP_PORT_REUSEPORT);
+    for (int i = 0; i < kClients; ++i) {
+        int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_GE(fd, 0);
+        ::sendto(fd, "ping", 4, 0, reinterpret_cast<const sockaddr*>(&dest.addr_),
+                 sizeof(dest.addr_));
+        fds.push_back(fd);
+    }
+    EXPECT_TRUE(wait_until([&]() { return received.load() == kClients; }));
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        EXPECT_EQ(2u, threads.size());
+    }
+
+    for (int fd : fds) {
+        ::close(fd);
+    }
+    server.stop();
+}
+
+// ============================================
+// Connector / ConnectionPool 测试
+// ============================================
+
+namespace {
+
+struct ConnectResult {
+    std::atomic<bool> done{false};
+    std::atomic<int> err{-1};
+    std::atomic<bool> in_loop{false};
+    std::atomic<bool> has_socket{false};
+};
+
+net::ConnectorPtr start_connect(net::EventLoop* loop, unsigned short port, int timeout_ms,
+                                ConnectResult& r) {
+    return net::Connector::start(loop, "127.0.0.1", port, timeout_ms,
+                                 [&r, loop](net::TcpSocket socket, int err) {
+        r.in_loop = loop->is_in_loop_thread();
+        r.has_socket = socket.is_open();
+        r.err = err;
+        r.done = true;
+    });
+}
+
+}  // namespace
+
+TEST(ConnectorTest, ConnectRefuseTimeoutAndCancel) {
+    net::EventLoopThreadPool loops(1);
+    loops.start();
+    net::EventLoop* loop = loops.next_loop();
+
+    int listen_fd = listen_local(CONNECT_PORT_LISTEN, 16);
+    ASSERT_GE(listen_fd, 0);
+    ConnectResult ok;
+    start_connect(loop, CONNECT_PORT_LISTEN, 1000, ok);
+    ASSERT_TRUE(wait_until([&]() { return ok.done.load(); }));
+    EXPECT_EQ(0, ok.err.load());
+    EXPECT_TRUE(ok.has_socket.load());
+    EXPECT_TRUE(ok.in_loop.load());
+
+    ConnectResult refused;
+    start_connect(loop, CONNECT_PORT_CLOSED, 1000, refused);
+    ASSERT_TRUE(wait_until([&]() { return refused.done.load(); }));
+    EXPECT_EQ(ECONNREFUSED, refused.err.load());
+    EXPECT_FALSE(refused.has_socket.load());
+
+    // accept 队列已满的监听 socket 丢弃新的 SYN：connect 一直挂起，由 loop 时间轮超时
+    int full_fd = listen_local(CONNECT_PORT_BACKLOG, 0);
+    ASSERT_GE(full_fd, 0);
+    std::vector<int> fillers;
+    for (int i = 0; i < 4; ++i) {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(CONNECT_PORT_BACKLOG);
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        fillers.push_back(fd);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    auto start = std::chrono::steady_clock::now();
+    ConnectResult timed_out;
+    start_connect(loop, CONNECT_PORT_BACKLOG, 300, timed_out);
+    ASSERT_TRUE(wait_until([&]() { return timed_out.done.load(); }));
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(ETIMEDOUT, timed_out.err.load());
+    EXPECT_GE(elapsed, 250);
+    EXPECT_LT(elapsed, 1500);
+
+    ConnectResult cancelled;
+    net::ConnectorPtr c = start_connect(loop, CONNECT_PORT_BACKLOG, 5000, cancelled);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    c->cancel();
+    ASSERT_TRUE(wait_until([&]() { return cancelled.done.load(); }, 500));
+    EXPECT_EQ(ECANCELED, cancelled.err.load());
+
+    for (int fd : fillers) ::close(fd);
+    ::close(full_fd);
+    ::close(listen_fd);
+    loops.stop();
+}
+
+TEST(BackendHealthTest, EjectsWithExponentialBackoffAndSingleProbe) {
+    net::EjectionPolicy policy;
+    policy.eject_after_failures = 2;
+    policy.backoff_initial_ms = 100;
+    policy.backoff_max_ms = 300;
+    net::BackendHealth h(policy);
+
+    EXPECT_TRUE(h.allow(0));
+    h.on_failure(0);
+    EXPECT_FALSE(h.tripped());
+    EXPECT_TRUE(h.allow(0));
+    h.on_failure(0);
+    EXPECT_TRUE(h.tripped());
+    EXPECT_TRUE(h.ejected(50));
+    EXPECT_FALSE(h.allow(99));
+
+    // 退避到期只放行一次试探
+    EXPECT_TRUE(h.allow(100));
+    EXPECT_FALSE(h.allow(101));
+    h.on_failure(110);
+    EXPECT_EQ(310, h.retry_at_ms());  // 200ms
+    EXPECT_TRUE(h.allow(310));
+    h.on_failure(310);
+    EXPECT_EQ(610, h.retry_at_ms());  // 封顶 300ms
+
+    h.on_success();
+    EXPECT_FALSE(h.tripped());
+    EXPECT_TRUE(h.allow(311));
+}
+
+TEST(ConnectionPoolTest, PrewarmsEjectsAndRecovers) {
+    net::EventLoopThreadPool loops(1);
+    loops.start();
+
+    std::mutex accepted_mutex;
+    std::vector<net::TcpConnectionPtr> accepted;
+    auto start_backend = [&]() {
+        std::unique_ptr<net::TcpServer> s(new net::TcpServer(loops, POOL_PORT_BACKEND));
+        s->set_connection_callback([&](const net::TcpConnectionPtr& conn) {
+            std::lock_guard<std::mutex> lock(accepted_mutex);
+            accepted.push_back(conn);
+        });
+        s->start_accept();
+        return s;
+    };
+    std::unique_ptr<net::TcpServer> server = start_backend();
+
+    net::ConnectionPoolConfig config;
+    config.host = "127.0.0.1";
+    config.port = POOL_PORT_BACKEND;
+    config.min_connections = 2;
+    config.max_connections = 3;
+    config.connect_timeout_ms = 500;
+    config.health_check_interval_ms = 100;
+    config.ejection.eject_after_failures = 2;
+    config.ejection.backoff_initial_ms = 100;
+    config.ejection.backoff_max_ms = 200;
+    net::ConnectionPool::Ptr pool = net::ConnectionPool::create(loops.next_loop(), config);
+
+    // init() 不等待建连，预热在后台完成
+    ASSERT_TRUE(pool->init());
+    EXPECT_TRUE(wait_until([&]() { return pool->idle_connections() == 2; }));
+
+    net::PooledConnection a = pool->get_connection_sync(1000);
+    net::PooledConnection b = pool->get_connection_sync(1000);
+    ASSERT_TRUE(a.connection && b.connection);
+    // 空闲连接用尽：第三个由后台建连交付
+    net::PooledConnection c = pool->get_connection_sync(1000);
+    ASSERT_TRUE(c.connection);
+    EXPECT_EQ(3, pool->total_connections());
+    pool->return_connection(a);
+    pool->return_connection(b);
+    pool->return_connection(c);
+    EXPECT_EQ(3, pool->idle_connections());
+
+    // 后端下线：健康检查剔除对端已关闭的空闲连接，补连失败后摘除，获取立即失败而非等待超时
+    {
+        std::lock_guard<std::mutex> lock(accepted_mutex);
+        for (auto& conn : accepted) conn->close();
+    }
+    EXPECT_TRUE(wait_until([&]() { return server->connection_count() == 0; }));
+    server->stop();
+    server.reset();
+    {
+        std::lock_guard<std::mutex> lock(accepted_mutex);
+        accepted.clear();
+    }
+    EXPECT_TRUE(wait_until([&]() { return !pool->healthy(); }));
+    EXPECT_EQ(0, pool->total_connections());
+    auto start = std::chrono::steady_clock::now();
+    net::PooledConnection none = pool->get_connection_sync(2000);
+    EXPECT_FALSE(none.connection);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+
+    // 后端恢复：退避到期的试探成功后重新补齐
+    server = start_backend();
+    EXPECT_TRUE(wait_until([&]() { return pool->healthy() && pool->idle_connections() == 2; }, 3000));
+
+    pool->shutdown();
+    server->stop();
+    loops.stop();
+    accepted.clear();
+}
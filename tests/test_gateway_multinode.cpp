@@ -1,4 +1,15 @@
 #include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <unordered_set>
 #include <unordered_map>
 #include <string>
@@ -11,6 +22,13 @@
 #include "chwell/redis/redis_client.h"
 #include "chwell/loadbalance/consistent_hash.h"
 #include "chwell/core/logger.h"
+#include "chwell/gateway/gateway_forwarder.h"
+#include "chwell/metrics/prometheus_metrics.h"
+#include "chwell/net/event_loop.h"
+#include "chwell/net/mux.h"
+#include "chwell/net/tcp_server.h"
+#include "chwell/protocol/parser.h"
+#include "chwell/service/protocol_router.h"
 
 using namespace chwell;
 
@@ -257,4 +275,524 @@ TEST(ConsistentHashTest, MinimalRehashOnAdd) {
     EXPECT_LT(changed, 60);
 }
 
+// ============================================
+// GatewayForwarder 非阻塞建连测试
+// ============================================
+
+constexpr unsigned short GW_PORT_BACKEND      = 19961;
+constexpr unsigned short GW_PORT_FRONT        = 19962;
+constexpr unsigned short GW_PORT_DEAD_BACKEND = 19963;
+constexpr unsigned short GW_PORT_FRONT_DEAD   = 19964;
+constexpr unsigned short GW_PORT_BACKEND_DISC = 19973;
+constexpr unsigned short GW_PORT_FRONT_DISC   = 19974;
+constexpr unsigned short GW_PORT_MUX_BACKEND  = 19965;
+constexpr unsigned short GW_PORT_MUX_FRONT    = 19966;
+constexpr unsigned short GW_PORT_PASS_BACKEND = 19971;
+constexpr unsigned short GW_PORT_PASS_FRONT   = 19972;
+constexpr unsigned short GW_PORT_BIG_BACKEND     = 19976;
+constexpr unsigned short GW_PORT_BIG_MUX_BACKEND = 19977;
+constexpr unsigned short GW_PORT_BIG_FRONT       = 19978;
+constexpr unsigned short GW_PORT_BIG_MUX_FRONT   = 19979;
+constexpr unsigned short GW_PORT_BIG_LEGACY      = 19980;
+
+int gw_connect(unsigned short port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 在 timeout_ms 内读出 count 条消息
+std::vector<protocol::Message> gw_read_messages(
+    int fd, std::size_t count, int timeout_ms = 2000,
+    protocol::FrameFormat format = protocol::FrameFormat::kLegacy) {
+    protocol::Parser parser(net::Buffer::kInitialSize, format);
+    std::vector<protocol::Message> out;
+    char buf[4096];
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (out.size() < count && std::chrono::steady_clock::now() < deadline) {
+        pollfd pfd{fd, POLLIN, 0};
+        if (poll(&pfd, 1, 50) <= 0) continue;
+        ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n <= 0) break;
+        for (auto& m : parser.feed(std::string_view(buf, static_cast<std::size_t>(n)))) {
+            out.push_back(std::move(m));
+        }
+    }
+    return out;
+}
+
+void gw_write(int fd, const protocol::Message& msg,
+              protocol::FrameFormat format = protocol::FrameFormat::kLegacy) {
+    std::vector<char> data = protocol::serialize(msg, format);
+    ASSERT_EQ(static_cast<ssize_t>(data.size()), ::write(fd, data.data(), data.size()));
+}
+
+// 前端：单个客户端，按帧解析后交给 forwarder
+void gw_route_to(net::TcpServer& front, gateway::GatewayForwarderComponent& forwarder,
+                 protocol::Parser& parser) {
+    front.set_message_callback([&forwarder, &parser](const net::TcpConnectionPtr& conn,
+                                                    std::string_view data) {
+        for (const protocol::Message& msg : parser.feed(data)) {
+            forwarder.forward(conn, msg);
+        }
+    });
+}
+
+TEST(GatewayForwarderTest, QueuesMessagesWhileConnectingAndKeepsOrder) {
+    net::EventLoopThreadPool loops(1);
+    loops.start();
+
+    net::TcpServer backend(loops, GW_PORT_BACKEND);
+    backend.set_message_callback([](const net::TcpConnectionPtr& conn, std::string_view data) {
+        conn->send(data);  // 原样回显
+    });
+    backend.start_accept();
+
+    gateway::GatewayForwarderComponent forwarder("127.0.0.1", GW_PORT_BACKEND);
+    net::TcpServer front(loops, GW_PORT_FRONT);
+    protocol::Parser parser;
+    gw_route_to(front, forwarder, parser);
+    front.start_accept();
+
+    int fd = gw_connect(GW_PORT_FRONT);
+    ASSERT_GE(fd, 0);
+    // 第一条触发建连，其余在建连完成前到达并按序暂存
+    for (int i = 0; i < 5; ++i) {
+        gw_write(fd, protocol::Message(static_cast<std::uint16_t>(100 + i), "m" + std::to_string(i)));
+    }
+    std::vector<protocol::Message> replies = gw_read_messages(fd, 5);
+    ASSERT_EQ(5u, replies.size());
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(100 + i, replies[i].cmd);
+        EXPECT_EQ("m" + std::to_string(i), std::string(replies[i].body.begin(), replies[i].body.end()));
+    }
+
+    ::close(fd);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    front.stop();
+    backend.stop();
+    loops.stop();
+}
+
+TEST(GatewayForwarderTest, ClientDisconnectClosesLiveBackendOnSameLoop) {
+    // 单个 loop：后端连接与客户端同属一个 loop，客户端断开时 close 会就地触发后端的关闭回调
+    net::EventLoopThreadPool loops(1);
+    loops.start();
+
+    net::TcpServer backend(loops, GW_PORT_BACKEND_DISC);
+    backend.set_message_callback([](const net::TcpConnectionPtr& conn, std::string_view data) {
+        conn->send(data);
+    });
+    backend.start_accept();
+
+    gateway::GatewayForwarderComponent forwarder("127.0.0.1", GW_PORT_BACKEND_DISC);
+    net::TcpServer front(loops, GW_PORT_FRONT_DISC);
+    protocol::Parser parser;
+    gw_route_to(front, forwarder, parser);
+    std::atomic<int> disconnects{0};
+    front.set_disconnect_callback([&forwarder, &disconnects](const net::TcpConnectionPtr& conn) {
+        forwarder.on_disconnect(conn);
+        ++disconnects;
+    });
+    front.start_accept();
+
+    int fd = gw_connect(GW_PORT_FRONT_DISC);
+    ASSERT_GE(fd, 0);
+    gw_write(fd, protocol::Message(1, "ping"));
+    ASSERT_EQ(1u, gw_read_messages(fd, 1).size());
+    ::close(fd);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (disconnects.load() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(1, disconnects.load());
+
+    // loop 仍在运转：新客户端照常经网关往返
+    parser.reset();
+    fd = gw_connect(GW_PORT_FRONT_DISC);
+    ASSERT_GE(fd, 0);
+    gw_write(fd, protocol::Message(2, "again"));
+    std::vector<protocol::Message> replies = gw_read_messages(fd, 1);
+    ASSERT_EQ(1u, replies.size());
+    EXPECT_EQ(2, replies[0].cmd);
+
+    ::close(fd);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    front.stop();
+    backend.stop();
+    loops.stop();
+}
+
+TEST(GatewayForwarderTest, DeadBackendIsEjectedAndFailsFast) {
+    net::EventLoopThreadPool loops(1);
+    loops.start();
+
+    gateway::GatewayForwarderComponent forwarder("127.0.0.1", GW_PORT_DEAD_BACKEND);
+    net::EjectionPolicy policy;
+    policy.eject_after_failures = 1;
+    policy.backoff_initial_ms = 10000;
+    forwarder.set_ejection_policy(policy);
+
+    net::TcpServer front(loops, GW_PORT_FRONT_DEAD);
+    protocol::Parser parser;
+    gw_route_to(front, forwarder, parser);
+    front.start_accept();
+
+    int fd = gw_connect(GW_PORT_FRONT_DEAD);
+    ASSERT_GE(fd, 0);
+    gw_write(fd, protocol::Message(7, "hello"));
+    std::vector<protocol::Message> replies = gw_read_messages(fd, 1);
+    ASSERT_EQ(1u, replies.size());
+    EXPECT_EQ(7, replies[0].cmd);
+    EXPECT_TRUE(forwarder.backend_ejected("127.0.0.1", GW_PORT_DEAD_BACKEND));
+
+    // 摘除期间不再建连，立即回复错误
+    auto start = std::chrono::steady_clock::now();
+    gw_write(fd, protocol::Message(8, "again"));
+    replies = gw_read_messages(fd, 1);
+    ASSERT_EQ(1u, replies.size());
+    EXPECT_EQ(8, replies[0].cmd);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+
+    ::close(fd);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    front.stop();
+    loops.stop();
+}
+
+// ============================================
+// 多路复用链路测试
+// ============================================
+
+bool gw_wait_until(const std::function<bool()>& pred, int timeout_ms = 2000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+TEST(MuxDecoderTest, ReassemblesFramesSplitAcrossFeeds) {
+    std::string stream;
+    char head[net::mux::kHeaderSize];
+    net::mux::encode_header(head, 7, net::mux::kData, 5);
+    stream.append(head, sizeof(head)).append("hello");
+    net::mux::encode_header(head, 9, net::mux::kClose, 0);
+    stream.append(head, sizeof(head));
+    net::mux::encode_header(head, 7, net::mux::kData, 3);
+    stream.append(head, sizeof(head)).append("abc");
+
+    // 逐字节喂入与一次喂入结果一致
+    for (std::size_t step : {std::size_t(1), std::size_t(4), stream.size()}) {
+        net::MuxDecoder decoder;
+        std::vector<std::string> frames;
+        for (std::size_t off = 0; off < stream.size(); off += step) {
+            ASSERT_TRUE(decoder.feed(std::string_view(stream).substr(off, step),
+                                     [&](const net::mux::Frame& f) {
+                frames.push_back(std::to_string(f.session) + "/" + std::to_string(f.type) + "/"
+                                 + std::string(f.payload));
+            }));
+        }
+        EXPECT_EQ((std::vector<std::string>{"7/1/hello", "9/2/", "7/1/abc"}), frames);
+        EXPECT_EQ(0u, decoder.buffered_bytes());
+    }
+
+    net::MuxDecoder decoder;
+    net::mux::encode_header(head, 1, 99, 0);
+    EXPECT_FALSE(decoder.feed(std::string_view(head, sizeof(head)), [](const net::mux::Frame&) {}));
+}
+
+TEST(GatewayForwarderTest, MultiplexesClientsOverFixedLinks) {
+    net::EventLoopThreadPool loops(2);
+    loops.start();
+
+    // 逻辑服：按会话回显，收到 "bye" 时主动结束会话
+    net::MuxServer backend(loops, GW_PORT_MUX_BACKEND);
+    backend.set_message_callback([](const net::MuxSessionPtr& session, std::string_view data) {
+        protocol::MessageView msg;
+        ASSERT_EQ(data.size(), protocol::Parser::parse_frame(data, msg));
+        if (msg.body == "bye") {
+            session->close();
+            return;
+        }
+        session->send(data);
+    });
+    backend.start();
+
+    gateway::GatewayForwarderComponent forwarder("127.0.0.1", GW_PORT_MUX_BACKEND);
+    forwarder.set_multiplex_links(2);
+    net::TcpServer front(loops, GW_PORT_MUX_FRONT);
+    std::mutex parsers_mutex;
+    std::unordered_map<const net::TcpConnection*, protocol::Parser> parsers;
+    front.set_message_callback([&](const net::TcpConnectionPtr& conn, std::string_view data) {
+        std::vector<protocol::Message> msgs;
+        {
+            std::lock_guard<std::mutex> lock(parsers_mutex);
+            msgs = parsers[conn.get()].feed(data);
+        }
+        for (const protocol::Message& msg : msgs) {
+            forwarder.forward(conn, msg);
+        }
+    });
+    front.set_disconnect_callback([&](const net::TcpConnectionPtr& conn) {
+        forwarder.on_disconnect(conn);
+    });
+    front.start_accept();
+
+    const int kClients = 8;
+    std::vector<int> fds;
+    for (int i = 0; i < kClients; ++i) {
+        int fd = gw_connect(GW_PORT_MUX_FRONT);
+        ASSERT_GE(fd, 0);
+        fds.push_back(fd);
+    }
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < kClients; ++i) {
+            gw_write(fds[i], protocol::Message(static_cast<std::uint16_t>(i),
+                                               "c" + std::to_string(i) + "r" + std::to_string(round)));
+        }
+    }
+    // 每个客户端只收到自己的回复且按序
+    for (int i = 0; i < kClients; ++i) {
+        std::vector<protocol::Message> replies = gw_read_messages(fds[i], 3);
+        ASSERT_EQ(3u, replies.size());
+        for (int round = 0; round < 3; ++round) {
+            EXPECT_EQ(i, replies[round].cmd);
+            EXPECT_EQ("c" + std::to_string(i) + "r" + std::to_string(round),
+                      std::string(replies[round].body.begin(), replies[round].body.end()));
+        }
+    }
+
+    // 后端连接数与客户端数无关
+    EXPECT_EQ(2u, backend.link_count());
+    EXPECT_EQ(2u, forwarder.backend_socket_count());
+    EXPECT_EQ(static_cast<std::size_t>(kClients), backend.session_count());
+
+    // 客户端断开：链路保留，只结束对应会话
+    for (int i = 0; i < 3; ++i) {
+        ::close(fds[i]);
+    }
+    EXPECT_TRUE(gw_wait_until([&] { return backend.session_count() == kClients - 3u; }));
+    EXPECT_EQ(2u, backend.link_count());
+
+    // 逻辑服结束会话：网关确认后释放，客户端下一条消息建立新会话
+    gw_write(fds[3], protocol::Message(3, "bye"));
+    EXPECT_TRUE(gw_wait_until([&] { return backend.session_count() == kClients - 4u; }));
+    gw_write(fds[3], protocol::Message(3, "again"));
+    std::vector<protocol::Message> replies = gw_read_messages(fds[3], 1);
+    ASSERT_EQ(1u, replies.size());
+    EXPECT_EQ("again", std::string(replies[0].body.begin(), replies[0].body.end()));
+    EXPECT_EQ(2u, backend.link_count());
+
+    for (int i = 3; i < kClients; ++i) {
+        ::close(fds[i]);
+    }
+    EXPECT_TRUE(gw_wait_until([&] { return backend.session_count() == 0; }));
+    front.stop();
+    backend.stop();
+    loops.stop();
+}
+
+TEST(GatewayForwarderTest, PassthroughSplicesLargeBodies) {
+    net::EventLoopThreadPool loops(1);
+    loops.start();
+
+    // 逻辑服：回复 "<body 长度>:<内容是否完好>"
+    net::TcpServer backend(loops, GW_PORT_PASS_BACKEND);
+    std::mutex parsers_mutex;
+    std::unordered_map<const net::TcpConnection*, protocol::Parser> parsers;
+    backend.set_message_callback([&](const net::TcpConnectionPtr& conn, std::string_view data) {
+        std::vector<protocol::Message> msgs;
+        {
+            std::lock_guard<std::mutex> lock(parsers_mutex);
+            msgs = parsers[conn.get()].feed(data);
+        }
+        for (const protocol::Message& msg : msgs) {
+            bool intact = true;
+            for (std::size_t i = 0; i < msg.body.size(); ++i) {
+                intact = intact && msg.body[i] == static_cast<char>('a' + i % 26);
+            }
+            std::string reply = std::to_string(msg.body.size()) + (intact ? ":ok" : ":bad");
+            conn->send(protocol::serialize(protocol::Message(msg.cmd, reply)));
+        }
+    });
+    backend.start_accept();
+
+    // 网关：单次最多读 1 KiB，大帧的 body 留在 socket 里等 splice
+    gateway::GatewayForwarderComponent forwarder("127.0.0.1", GW_PORT_PASS_BACKEND);
+    service::ProtocolRouterComponent router;
+    forwarder.enable_passthrough(router, {7});
+    net::TcpServerConfig config;
+    config.max_read_bytes = 1024;
+    net::TcpServer front(loops, GW_PORT_PASS_FRONT);
+    front.set_config(config);
+    front.set_message_callback([&](const net::TcpConnectionPtr& conn, std::string_view data) {
+        router.on_message(conn, data);
+    });
+    front.set_disconnect_callback([&](const net::TcpConnectionPtr& conn) {
+        router.on_disconnect(conn);
+        forwarder.on_disconnect(conn);
+    });
+    front.start_accept();
+
+    auto counter = [](const char* name) {
+        return metrics::get_prometheus_registry().register_counter(name).get();
+    };
+    const double spliced_before = counter("chwell_net_spliced_bytes_total");
+    const double copied_before = counter("chwell_net_splice_copied_bytes_total");
+
+    int fd = gw_connect(GW_PORT_PASS_FRONT);
+    ASSERT_GE(fd, 0);
+    // 小帧走常规转发，同时建立后端连接
+    std::string small(100, 'x');
+    for (std::size_t i = 0; i < small.size(); ++i) small[i] = static_cast<char>('a' + i % 26);
+    gw_write(fd, protocol::Message(7, small));
+    std::vector<protocol::Message> replies = gw_read_messages(fd, 1);
+    ASSERT_EQ(1u, replies.size());
+    EXPECT_EQ("100:ok", std::string(replies[0].body.begin(), replies[0].body.end()));
+
+    // 大帧：帧头与前缀经用户态，其余 body 由 splice 搬运；其后的小帧照常转发且顺序不变
+    std::string large(60000, 'x');
+    for (std::size_t i = 0; i < large.size(); ++i) large[i] = static_cast<char>('a' + i % 26);
+    gw_write(fd, protocol::Message(7, large));
+    gw_write(fd, protocol::Message(7, small));
+    replies = gw_read_messages(fd, 2);
+    ASSERT_EQ(2u, replies.size());
+    EXPECT_EQ("60000:ok", std::string(replies[0].body.begin(), replies[0].body.end()));
+    EXPECT_EQ("100:ok", std::string(replies[1].body.begin(), replies[1].body.end()));
+
+    const double spliced = counter("chwell_net_spliced_bytes_total") - spliced_before;
+    const double copied = counter("chwell_net_splice_copied_bytes_total") - copied_before;
+    EXPECT_GT(spliced, 0.0);
+    EXPECT_GE(spliced + copied, 60000.0 - 1024.0);
+
+    ::close(fd);
+    front.stop();
+    backend.stop();
+    loops.stop();
+}
+
+
+TEST(GatewayForwarderTest, RelaysBodiesOver64KiBInClientFrameFormat) {
+    net::EventLoopThreadPool loops(2);
+    loops.start();
+    const protocol::FrameFormat kExt = protocol::FrameFormat::kExtended;
+    net::TcpServerConfig extended;
+    extended.frame_format = static_cast<std::uint8_t>(kExt);
+
+    // 逻辑服：普通端口与多路复用端口都用扩展格式，原样回显
+    service::ProtocolRouterComponent backend_router;
+    backend_router.register_handler(9, [](const net::TcpConnectionPtr& conn,
+                                          const protocol::Message& msg) {
+        service::ProtocolRouterComponent::send_message(conn, msg);
+    });
+    backend_router.register_mux_handler(9, [](const net::MuxSessionPtr& session,
+                                              const protocol::MessageView& msg) {
+        service::ProtocolRouterComponent::send_message(session, msg.to_message());
+    });
+    net::TcpServer backend(loops, GW_PORT_BIG_BACKEND);
+    backend.set_config(extended);
+    backend.set_message_callback([&](const net::TcpConnectionPtr& conn, std::string_view data) {
+        backend_router.on_message(conn, data);
+    });
+    backend.set_disconnect_callback([&](const net::TcpConnectionPtr& conn) {
+        backend_router.on_disconnect(conn);
+    });
+    backend.start_accept();
+    net::MuxServer mux_backend(loops, GW_PORT_BIG_MUX_BACKEND);
+    mux_backend.set_frame_format(static_cast<std::uint8_t>(kExt));
+    mux_backend.set_message_callback([&](const net::MuxSessionPtr& session, std::string_view data) {
+        backend_router.on_mux_message(session, data);
+    });
+    mux_backend.start();
+
+    // 网关：扩展格式的前端分别经独立后端连接与多路复用链路转发
+    gateway::GatewayForwarderComponent direct("127.0.0.1", GW_PORT_BIG_BACKEND);
+    gateway::GatewayForwarderComponent muxed("127.0.0.1", GW_PORT_BIG_MUX_BACKEND);
+    muxed.set_multiplex_links(1);
+    service::ProtocolRouterComponent direct_router;
+    service::ProtocolRouterComponent mux_router;
+    direct_router.register_handler(9, [&](const net::TcpConnectionPtr& conn,
+                                          const protocol::Message& msg) {
+        direct.forward(conn, msg);
+    });
+    mux_router.register_handler(9, [&](const net::TcpConnectionPtr& conn,
+                                       const protocol::Message& msg) {
+        muxed.forward(conn, msg);
+    });
+    net::TcpServer front(loops, GW_PORT_BIG_FRONT);
+    net::TcpServer mux_front(loops, GW_PORT_BIG_MUX_FRONT);
+    std::vector<std::pair<net::TcpServer*, service::ProtocolRouterComponent*>> fronts = {
+        {&front, &direct_router}, {&mux_front, &mux_router}};
+    for (auto& f : fronts) {
+        service::ProtocolRouterComponent* router = f.second;
+        f.first->set_config(extended);
+        f.first->set_message_callback([router](const net::TcpConnectionPtr& conn,
+                                               std::string_view data) {
+            router->on_message(conn, data);
+        });
+        f.first->set_disconnect_callback([&, router](const net::TcpConnectionPtr& conn) {
+            router->on_disconnect(conn);
+            direct.on_disconnect(conn);
+            muxed.on_disconnect(conn);
+        });
+        f.first->start_accept();
+    }
+
+    std::string body(200 * 1024, '\0');
+    for (std::size_t i = 0; i < body.size(); ++i) {
+        body[i] = static_cast<char>('a' + i % 26);
+    }
+    for (unsigned short port : {GW_PORT_BIG_FRONT, GW_PORT_BIG_MUX_FRONT}) {
+        int fd = gw_connect(port);
+        ASSERT_GE(fd, 0);
+        gw_write(fd, protocol::Message(9, body), kExt);
+        gw_write(fd, protocol::Message(9, "small"), kExt);
+        std::vector<protocol::Message> replies = gw_read_messages(fd, 2, 3000, kExt);
+        ASSERT_EQ(2u, replies.size()) << "port " << port;
+        EXPECT_EQ(body, std::string(replies[0].body.begin(), replies[0].body.end()));
+        EXPECT_EQ("small", std::string(replies[1].body.begin(), replies[1].body.end()));
+        ::close(fd);
+    }
+
+    // 旧格式的客户端连接放不下超过 64 KiB 的 body：明确回复错误并计数，而不是发出空帧
+    net::TcpServer legacy_front(loops, GW_PORT_BIG_LEGACY);
+    legacy_front.set_message_callback([&](const net::TcpConnectionPtr& conn, std::string_view) {
+        direct.forward(conn, protocol::Message(9, body));
+    });
+    legacy_front.set_disconnect_callback([&](const net::TcpConnectionPtr& conn) {
+        direct.on_disconnect(conn);
+    });
+    legacy_front.start_accept();
+    metrics::Counter& oversized = metrics::get_prometheus_registry().register_counter(
+        "chwell_gateway_oversized_messages_total");
+    const double oversized_before = oversized.get();
+    int fd = gw_connect(GW_PORT_BIG_LEGACY);
+    ASSERT_GE(fd, 0);
+    gw_write(fd, protocol::Message(9, "x"));
+    std::vector<protocol::Message> replies = gw_read_messages(fd, 1);
+    ASSERT_EQ(1u, replies.size());
+    EXPECT_EQ("gateway: backend unavailable",
+              std::string(replies[0].body.begin(), replies[0].body.end()));
+    EXPECT_EQ(1.0, oversized.get() - oversized_before);
+    ::close(fd);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    legacy_front.stop();
+    front.stop();
+    mux_front.stop();
+    mux_backend.stop();
+    backend.stop();
+    loops.stop();
+}
+
 } // namespace
@@ -0,0 +1,257 @@
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chwell/http/http_parser.h"
+#include "chwell/http/http_server.h"
+
+#include "test_net_helpers.h"
+
+using namespace chwell;
+using test::connect_local;
+
+namespace {
+
+constexpr unsigned short HTTP_PORT_KEEPALIVE = 19954;
+
+struct ParsedRequest {
+    std::string method;
+    std::string path;
+    std::string host;
+    std::string body;
+    bool keep_alive{false};
+};
+
+// 把 data 按 step 字节切分后依次喂给解析器（模拟任意 TCP 分段），未消费部分与下一段拼接
+bool parse_all(const std::string& data, std::size_t step, std::vector<ParsedRequest>* out, int* error) {
+    http::HttpRequestParser parser;
+    std::string pending;
+    ParsedRequest current;
+    for (std::size_t pos = 0; pos < data.size(); pos += step) {
+        pending += data.substr(pos, step);
+        std::size_t off = 0;
+        for (;;) {
+            std::size_t consumed = 0;
+            std::string_view chunk;
+            auto ev = parser.next(std::string_view(pending).substr(off), &consumed, &chunk);
+            off += consumed;
+            if (ev == http::HttpRequestParser::Event::kNeedMore) break;
+            if (ev == http::HttpRequestParser::Event::kError) {
+                *error = parser.error_status();
+                return false;
+            }
+            if (ev == http::HttpRequestParser::Event::kHead) {
+                const http::HttpRequestView& head = parser.head();
+                current = ParsedRequest();
+                current.method = std::string(head.method);
+                current.path = std::string(head.path);
+                current.host = std::string(head.header("host"));
+                current.keep_alive = head.keep_alive;
+            } else if (ev == http::HttpRequestParser::Event::kBody) {
+                current.body.append(chunk.data(), chunk.size());
+            } else if (ev == http::HttpRequestParser::Event::kComplete) {
+                out->push_back(current);
+            }
+        }
+        pending.erase(0, off);
+    }
+    return true;
+}
+
+void write_all(int fd, const std::string& data) {
+    std::size_t off = 0;
+    while (off < data.size()) {
+        ssize_t n = ::write(fd, data.data() + off, data.size() - off);
+        if (n <= 0) return;
+        off += static_cast<std::size_t>(n);
+    }
+}
+
+// 读到对端关闭或出现 count 次 needle 为止
+std::string read_until(int fd, const std::string& needle, int count, int timeout_ms = 3000) {
+    std::string out;
+    char buf[4096];
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    auto occurrences = [&]() {
+        int c = 0;
+        for (std::size_t p = out.find(needle); p != std::string::npos; p = out.find(needle, p + 1)) ++c;
+        return c;
+    };
+    while (occurrences() < count && std::chrono::steady_clock::now() < deadline) {
+        pollfd pfd{fd, POLLIN, 0};
+        if (poll(&pfd, 1, 50) <= 0) continue;
+        ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n <= 0) break;
+        out.append(buf, static_cast<std::size_t>(n));
+    }
+    return out;
+}
+
+bool peer_closed(int fd, int timeout_ms = 2000) {
+    pollfd pfd{fd, POLLIN, 0};
+    char c;
+    return poll(&pfd, 1, timeout_ms) > 0 && ::read(fd, &c, 1) == 0;
+}
+
+}  // namespace
+
+// 流水线请求在任意切分下（逐字节 / 小段 / 整块）解析结果一致，chunked 正文去除分块格式
+TEST(HttpParserTest, PipelinedRequestsAcrossArbitrarySplits) {
+    const std::string data =
+        "GET /health HTTP/1.1\r\nHost: a\r\n\r\n"
+        "POST /gm/kick HTTP/1.1\r\nhost: b\r\nContent-Length: 11\r\n\r\nplayer=1001"
+        "\r\n"  // 请求之间允许多余空行
+        "PUT /gm/notice HTTP/1.1\r\nHost: c\r\nTransfer-Encoding: chunked\r\n\r\n"
+        "5;ext=1\r\nhello\r\n7\r\n, world\r\n0\r\nX-Trailer: t\r\n\r\n"
+        "GET /metrics HTTP/1.0\r\nConnection: keep-alive\r\n\r\n"
+        "GET /bye HTTP/1.1\r\nConnection: close\r\n\r\n";
+
+    for (std::size_t step : {std::size_t(1), std::size_t(7), data.size()}) {
+        std::vector<ParsedRequest> reqs;
+        int error = 0;
+        ASSERT_TRUE(parse_all(data, step, &reqs, &error)) << "step " << step << " error " << error;
+        ASSERT_EQ(5u, reqs.size()) << "step " << step;
+        EXPECT_EQ("/health", reqs[0].path);
+        EXPECT_EQ("a", reqs[0].host);
+        EXPECT_EQ("POST", reqs[1].method);
+        EXPECT_EQ("b", reqs[1].host);  // 头部名大小写不敏感
+        EXPECT_EQ("player=1001", reqs[1].body);
+        EXPECT_EQ("hello, world", reqs[2].body);
+        EXPECT_TRUE(reqs[3].keep_alive);   // HTTP/1.0 + keep-alive
+        EXPECT_FALSE(reqs[4].keep_alive);  // Connection: close
+    }
+}
+
+TEST(HttpParserTest, RejectsMalformedAndOversizedRequests) {
+    struct Case {
+        const char* data;
+        int status;
+    };
+    const Case cases[] = {
+        {"GET /\r\n\r\n", 400},
+        {"GET / HTTP/2.0\r\n\r\n", 505},
+        {"GET / HTTP/1.1\r\nBad Header: x\r\n\r\n", 400},
+        {"POST / HTTP/1.1\r\nContent-Length: 3\r\nContent-Length: 4\r\n\r\n", 400},
+        {"POST / HTTP/1.1\r\nContent-Length: 3\r\nTransfer-Encoding: chunked\r\n\r\n", 400},
+        {"POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n", 501},
+        {"POST / HTTP/1.1\r\nContent-Length: 99999999\r\n\r\n", 413},
+        {"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n", 400},
+    };
+    for (const Case& c : cases) {
+        std::vector<ParsedRequest> reqs;
+        int error = 0;
+        EXPECT_FALSE(parse_all(c.data, 1000, &reqs, &error)) << c.data;
+        EXPECT_EQ(c.status, error) << c.data;
+    }
+
+    // 请求头超限（未收到结尾空行前即可判定）
+    std::string huge = "GET / HTTP/1.1\r\nX-Pad: " + std::string(9000, 'a');
+    std::vector<ParsedRequest> reqs;
+    int error = 0;
+    EXPECT_FALSE(parse_all(huge, 512, &reqs, &error));
+    EXPECT_EQ(431, error);
+
+    // chunked 正文累计超限
+    http::HttpRequestParser::Limits limits;
+    limits.max_body_size = 8;
+    http::HttpRequestParser parser(limits);
+    const std::string chunked = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n5\r\nworld\r\n";
+    std::size_t off = 0;
+    http::HttpRequestParser::Event ev;
+    do {
+        std::size_t consumed = 0;
+        std::string_view chunk;
+        ev = parser.next(std::string_view(chunked).substr(off), &consumed, &chunk);
+        off += consumed;
+    } while (ev != http::HttpRequestParser::Event::kError && ev != http::HttpRequestParser::Event::kNeedMore);
+    EXPECT_EQ(http::HttpRequestParser::Event::kError, ev);
+    EXPECT_EQ(413, parser.error_status());
+}
+
+// 反应堆 HttpServer：长连接上的流水线请求按序应答并合并写出，正文跨多次写入，Connection: close 后关闭
+TEST(HttpServerTest, KeepAlivePipeliningAndChunkedBodies) {
+    net::EventLoopThreadPool loops(2);
+    loops.start();
+    http::HttpServer server(loops, HTTP_PORT_KEEPALIVE);
+    std::atomic<int> handled{0};
+    server.set_view_handler([&](const http::HttpRequestView& req, http::HttpResponse& resp) {
+        ++handled;
+        resp.set_header("Content-Type", "text/plain");
+        resp.body = std::string(req.method) + " " + std::string(req.path) + " " + std::to_string(req.body.size());
+    });
+    server.start();
+
+    int fd = connect_local(HTTP_PORT_KEEPALIVE);
+    ASSERT_GE(fd, 0);
+    // 一次写出三个请求
+    write_all(fd,
+              "GET /a HTTP/1.1\r\nHost: x\r\n\r\n"
+              "HEAD /b HTTP/1.1\r\nHost: x\r\n\r\n"
+              "POST /c HTTP/1.1\r\nHost: x\r\nContent-Length: 4\r\n\r\nabcd");
+    std::string resp = read_until(fd, "HTTP/1.1 200 OK", 3);
+    std::size_t a = resp.find("GET /a 0");
+    std::size_t c = resp.find("POST /c 4");
+    ASSERT_NE(std::string::npos, a);
+    ASSERT_NE(std::string::npos, c);
+    EXPECT_LT(a, c);
+    EXPECT_EQ(std::string::npos, resp.find("HEAD /b"));  // HEAD 不带正文
+
+    // 正文分多次到达（含 100-continue 与 chunked），连接保持
+    write_all(fd, "POST /big HTTP/1.1\r\nHost: x\r\nExpect: 100-continue\r\nContent-Length: 10000\r\n\r\n");
+    EXPECT_NE(std::string::npos, read_until(fd, "100 Continue", 1).find("HTTP/1.1 100 Continue"));
+    write_all(fd, std::string(4000, 'x'));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    write_all(fd, std::string(6000, 'y'));
+    EXPECT_NE(std::string::npos, read_until(fd, "POST /big 10000", 1).find("POST /big 10000"));
+
+    write_all(fd, "PUT /chunk HTTP/1.1\r\nHost: x\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc");
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    write_all(fd, "\r\n2\r\nde\r\n0\r\n\r\nGET /last HTTP/1.1\r\nConnection: close\r\n\r\n");
+    resp = read_until(fd, "HTTP/1.1 200 OK", 2);
+    EXPECT_NE(std::string::npos, resp.find("PUT /chunk 5"));
+    EXPECT_NE(std::string::npos, resp.find("Connection: close"));
+    EXPECT_TRUE(peer_closed(fd));
+    ::close(fd);
+    EXPECT_EQ(6, handled.load());
+
+    // 协议错误：回复状态码后关闭
+    fd = connect_local(HTTP_PORT_KEEPALIVE);
+    ASSERT_GE(fd, 0);
+    write_all(fd, "POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n");
+    resp = read_until(fd, "\r\n\r\n", 1);
+    EXPECT_EQ(0u, resp.find("HTTP/1.1 501 Not Implemented"));
+    EXPECT_TRUE(peer_closed(fd));
+    ::close(fd);
+
+    server.stop();
+    loops.stop();
+}
+
+// 兼容旧接口：HttpHandler 拿到拷贝后的 HttpRequest；HTTP/1.0 默认短连接
+TEST(HttpServerTest, LegacyHandlerAndHttp10Close) {
+    net::IoService io_service;
+    http::HttpServer server(io_service, HTTP_PORT_KEEPALIVE + 1);
+    server.set_handler([](const http::HttpRequest& req, http::HttpResponse& resp) {
+        resp.body = req.header("X-Token") + ":" + req.body;
+    });
+    server.start();
+
+    int fd = connect_local(HTTP_PORT_KEEPALIVE + 1);
+    ASSERT_GE(fd, 0);
+    write_all(fd, "POST /login HTTP/1.0\r\nX-Token: t1\r\nContent-Length: 2\r\n\r\nok");
+    std::string resp = read_until(fd, "t1:ok", 1);
+    EXPECT_NE(std::string::npos, resp.find("t1:ok"));
+    EXPECT_TRUE(peer_closed(fd));
+    ::close(fd);
+    server.stop();
+}
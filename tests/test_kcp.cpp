@@ -0,0 +1,298 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chwell/net/kcp.h"
+#include "chwell/net/kcp_server.h"
+#include "chwell/net/connection_adapter.h"
+#include "chwell/metrics/prometheus_metrics.h"
+#include "chwell/service/service.h"
+
+#include "test_net_helpers.h"
+
+using namespace chwell;
+using test::wait_until;
+
+namespace {
+
+// 两个 KcpSession 之间的内存链路（丢包由各自的输出回调决定）
+struct MemoryLink {
+    std::deque<std::string> to_a;
+    std::deque<std::string> to_b;
+    std::size_t sent_by_a{0};
+};
+
+std::string make_message(int i, std::size_t size) {
+    std::string msg = "msg-" + std::to_string(i) + ":";
+    msg.resize(size, static_cast<char>('a' + i % 26));
+    return msg;
+}
+
+void drain(std::deque<std::string>& queue, net::KcpSession& session, std::uint32_t now) {
+    while (!queue.empty()) {
+        EXPECT_EQ(0, session.input(queue.front(), now));
+        queue.pop_front();
+    }
+}
+
+} // namespace
+
+TEST(KcpSessionTest, OrderedDeliveryUnderLossWithSimulatedClock) {
+    MemoryLink link;
+    std::size_t sent_by_b = 0;
+    net::KcpConfig config = net::KcpConfig::fast();
+    config.mtu = 512;
+
+    // 双向每 3 个数据报丢 1 个
+    net::KcpSession a(7, config, [&](std::string_view d) {
+        if (++link.sent_by_a % 3 != 0) link.to_b.emplace_back(d);
+    });
+    net::KcpSession b(7, config, [&](std::string_view d) {
+        if (++sent_by_b % 3 != 0) link.to_a.emplace_back(d);
+    });
+
+    std::vector<std::string> expected;
+    for (int i = 0; i < 100; ++i) {
+        // 每 10 条夹一条跨多个分片的大消息
+        expected.push_back(make_message(i, i % 10 == 0 ? 2000 : 32));
+        ASSERT_EQ(0, a.send(expected.back()));
+    }
+
+    std::vector<std::string> received;
+    std::string msg;
+    for (std::uint32_t now = 0; now < 20000 && received.size() < expected.size(); now += 10) {
+        a.update(now);
+        drain(link.to_b, b, now);
+        b.update(now);
+        drain(link.to_a, a, now);
+        while (b.recv(&msg)) {
+            received.push_back(msg);
+        }
+    }
+
+    ASSERT_EQ(expected.size(), received.size());
+    EXPECT_EQ(expected, received);
+    EXPECT_GT(a.retransmits() + a.fast_retransmits(), 0u);
+    EXPECT_FALSE(a.dead());
+}
+
+TEST(KcpSessionTest, FastRetransmitRecoversBeforeRto) {
+    net::KcpConfig config = net::KcpConfig::fast();
+    std::deque<std::string> to_a;
+    std::deque<std::string> to_b;
+    std::size_t sent_by_a = 0;
+
+    // 只丢 A 发出的第一个数据报（sn = 0 的数据）
+    net::KcpSession a(9, config, [&](std::string_view d) {
+        if (++sent_by_a != 1) to_b.emplace_back(d);
+    });
+    net::KcpSession b(9, config, [&](std::string_view d) { to_a.emplace_back(d); });
+
+    std::vector<std::string> received;
+    std::string msg;
+    // 每毫秒发一条并立即 flush，对端随即回 ACK：sn 0 之后的 ACK 跨越它两次即触发快速重传
+    std::uint32_t now = 0;
+    for (int i = 0; i < 4; ++i, ++now) {
+        ASSERT_EQ(0, a.send("input-" + std::to_string(i)));
+        a.flush(now);
+        drain(to_b, b, now);
+        b.flush(now);
+        drain(to_a, a, now);
+    }
+    a.flush(now);
+    drain(to_b, b, now);
+    while (b.recv(&msg)) {
+        received.push_back(msg);
+    }
+
+    ASSERT_EQ(4u, received.size());
+    EXPECT_EQ("input-0", received[0]);
+    EXPECT_EQ("input-3", received[3]);
+    EXPECT_EQ(1u, a.fast_retransmits());
+    EXPECT_EQ(0u, a.retransmits());
+    // 全程远小于 nodelay 的最小 RTO（30ms）
+    EXPECT_LT(now, 30u);
+}
+
+TEST(KcpSessionTest, RejectsForeignConvAndOversizedMessage) {
+    net::KcpConfig config;
+    config.recv_window = 4;
+    std::vector<std::string> out;
+    net::KcpSession a(1, config, [&](std::string_view d) { out.emplace_back(d); });
+    net::KcpSession b(2, config, [](std::string_view) {});
+
+    ASSERT_EQ(0, a.send("hello"));
+    a.flush(0);
+    ASSERT_EQ(1u, out.size());
+    EXPECT_EQ(1u, net::KcpSession::read_conv(out[0]));
+    EXPECT_EQ(-1, b.input(out[0], 0));
+    EXPECT_EQ(-1, a.send(std::string_view()));
+    // 超过接收窗口的分片数会被拒绝
+    EXPECT_EQ(-2, a.send(std::string(config.mtu * 5, 'x')));
+}
+
+TEST(KcpServerTest, EchoOverLossyLoopbackStaysOrdered) {
+    net::IoService io;
+    net::KcpConfig config = net::KcpConfig::fast();
+    config.interval_ms = 5;
+
+    net::LinkImpairment impairment;
+    impairment.loss_rate = 0.2;
+    impairment.latency_ms = 5;
+    impairment.jitter_ms = 5;
+
+    net::KcpServer server(io, 0, config);
+    std::atomic<int> accepted{0};
+    server.set_connection_callback([&](const net::KcpConnectionPtr&) { ++accepted; });
+    server.set_message_callback([](const net::KcpConnectionPtr& conn, std::string_view data) {
+        conn->send(data);
+    });
+    impairment.seed = 11;
+    server.set_impairment(impairment);
+    server.start();
+
+    net::KcpServer client(io, 0, config);
+    client.set_accept_sessions(false);
+    std::mutex mutex;
+    std::vector<std::string> echoed;
+    client.set_message_callback([&](const net::KcpConnectionPtr&, std::string_view data) {
+        std::lock_guard<std::mutex> lock(mutex);
+        echoed.emplace_back(data);
+    });
+    impairment.seed = 23;
+    client.set_impairment(impairment);
+    client.start();
+
+    net::KcpConnectionPtr conn =
+        client.connect(net::UdpEndpoint("127.0.0.1", server.port()), 0x1234);
+    std::vector<std::string> expected;
+    for (int i = 0; i < 200; ++i) {
+        expected.push_back(make_message(i, i % 50 == 0 ? 3000 : 24));
+        conn->send(expected.back());
+    }
+
+    ASSERT_TRUE(wait_until([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return echoed.size() >= expected.size();
+    }, 10000));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_EQ(expected, echoed);
+    }
+    EXPECT_EQ(1, accepted.load());
+    EXPECT_EQ(1u, server.connection_count());
+    EXPECT_GT(conn->retransmits() + conn->fast_retransmits(), 0u);
+    EXPECT_EQ("kcp", net::make_connection(conn)->type());
+
+    client.stop();
+    server.stop();
+}
+
+TEST(KcpServerTest, IdleSessionIsReapedWithDisconnectCallback) {
+    net::IoService io;
+    net::KcpConfig config = net::KcpConfig::fast();
+    config.idle_timeout_ms = 100;
+
+    net::KcpServer server(io, 0, config);
+    std::atomic<int> disconnected{0};
+    server.set_disconnect_callback([&](const net::KcpConnectionPtr&) { ++disconnected; });
+    server.start();
+
+    net::KcpServer client(io, 0, config);
+    client.set_accept_sessions(false);
+    client.start();
+    net::KcpConnectionPtr conn = client.connect(net::UdpEndpoint("127.0.0.1", server.port()), 42);
+    conn->send("ping");
+    ASSERT_TRUE(wait_until([&]() { return server.connection_count() == 1; }));
+
+    // 客户端停止后服务端收不到任何数据，空闲超时后移除会话
+    client.stop();
+    ASSERT_TRUE(wait_until([&]() { return disconnected.load() == 1; }));
+    EXPECT_EQ(0u, server.connection_count());
+    server.stop();
+}
+
+TEST(KcpServerTest, SessionLimitsDropDatagramsForNewSessions) {
+    net::IoService io;
+    net::KcpConfig config = net::KcpConfig::fast();
+    config.idle_timeout_ms = 150;
+    config.max_sessions = 3;
+    config.max_sessions_per_addr = 2;
+
+    net::KcpServer server(io, 0, config);
+    std::atomic<int> accepted{0};
+    server.set_connection_callback([&](const net::KcpConnectionPtr&) { ++accepted; });
+    server.start();
+    metrics::Counter& rejected =
+        metrics::get_prometheus_registry().register_counter("chwell_net_kcp_sessions_rejected_total");
+    const double rejected_before = rejected.get();
+
+    // 客户端都在 127.0.0.1：每个对端 IP 最多 2 个会话，第 3 个 conv 的数据报被丢弃
+    net::KcpServer client(io, 0, config);
+    client.set_accept_sessions(false);
+    client.start();
+    const net::UdpEndpoint target("127.0.0.1", server.port());
+    for (std::uint32_t conv = 1; conv <= 3; ++conv) {
+        client.connect(target, conv)->send("hello");
+    }
+    ASSERT_TRUE(wait_until([&]() { return rejected.get() > rejected_before; }));
+    EXPECT_EQ(2, accepted.load());
+    EXPECT_EQ(2u, server.connection_count());
+
+    // 空闲回收后计数归还，新的会话可以再建立
+    client.stop();
+    ASSERT_TRUE(wait_until([&]() { return server.connection_count() == 0; }));
+    net::KcpServer client2(io, 0, config);
+    client2.set_accept_sessions(false);
+    client2.start();
+    client2.connect(target, 9)->send("again");
+    ASSERT_TRUE(wait_until([&]() { return accepted.load() == 3; }));
+    EXPECT_EQ(1u, server.connection_count());
+    client2.stop();
+    server.stop();
+}
+
+namespace {
+
+class KcpEchoComponent : public service::Component {
+public:
+    std::string name() const override { return "KcpEchoComponent"; }
+
+    void on_kcp_message(const net::KcpConnectionPtr& conn, std::string_view data) override {
+        conn->send("echo:" + std::string(data));
+    }
+};
+
+} // namespace
+
+TEST(KcpServerTest, ServiceDispatchesKcpMessagesToComponents) {
+    service::Service svc(19950, 1);
+    svc.add_component<KcpEchoComponent>();
+    net::KcpServer* kcp = svc.listen_kcp(0);
+    ASSERT_NE(nullptr, kcp);
+    svc.start();
+
+    net::IoService io;
+    net::KcpServer client(io, 0, net::KcpConfig::fast());
+    client.set_accept_sessions(false);
+    std::atomic<bool> got{false};
+    std::string reply;
+    client.set_message_callback([&](const net::KcpConnectionPtr&, std::string_view data) {
+        reply.assign(data.data(), data.size());
+        got = true;
+    });
+    client.start();
+    client.connect(net::UdpEndpoint("127.0.0.1", kcp->port()), 7)->send("move");
+
+    ASSERT_TRUE(wait_until([&]() { return got.load(); }));
+    EXPECT_EQ("echo:move", reply);
+
+    client.stop();
+    svc.stop();
+}
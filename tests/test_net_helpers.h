@@ -0,0 +1,48 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <thread>
+
+#include "chwell/metrics/prometheus_metrics.h"
+
+namespace chwell {
+namespace test {
+
+// 阻塞连接到本机 127.0.0.1:port，失败返回 -1
+inline int connect_local(unsigned short port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 每 5ms 轮询一次，pred 在 timeout_ms 内成立返回 true
+template <typename Pred>
+bool wait_until(Pred pred, int timeout_ms = 5000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+// 全局 registry 中计数器的当前值（未注册时注册为 0）
+inline double counter_value(const char* name) {
+    return metrics::get_prometheus_registry().register_counter(name).get();
+}
+
+} // namespace test
+} // namespace chwell
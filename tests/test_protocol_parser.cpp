@@ -1,10 +1,33 @@
 #include <gtest/gtest.h>
 
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "chwell/protocol/compression.h"
 #include "chwell/protocol/message.h"
 #include "chwell/protocol/parser.h"
 
 using namespace chwell;
 
+namespace {
+
+// 形似状态快照的载荷：字段名与结构相同，数值各不相同
+std::string make_snapshot(int seed) {
+    std::string s = "{\"room\":\"arena-" + std::to_string(seed % 7) + "\",\"entities\":[";
+    for (int i = 0; i < 6; ++i) {
+        int v = seed * 31 + i * 17;
+        s += "{\"id\":" + std::to_string(1000 + i) + ",\"type\":\"player\",\"pos\":{\"x\":" +
+             std::to_string(v % 500) + ",\"y\":" + std::to_string(v % 300) + "},\"hp\":" +
+             std::to_string(v % 100) + ",\"state\":\"moving\"},";
+    }
+    s += "],\"frame\":" + std::to_string(seed) + "}";
+    return s;
+}
+
+}  // namespace
+
 TEST(ProtocolParserTest, SerializeAndDeserializeRoundtrip) {
     protocol::Message msg_out(100, std::string("hello"));
 
@@ -49,3 +72,244 @@ TEST(ProtocolParserTest, HandlesStickyAndPartialPackets) {
     EXPECT_EQ(1u, m_second[0].cmd);
 }
 
+
+TEST(ProtocolParserTest, FeedFromBufferLeavesPartialFrame) {
+    auto d1 = protocol::serialize(protocol::Message(7, std::string("abc")));
+    auto d2 = protocol::serialize(protocol::Message(8, std::string("defgh")));
+
+    net::Buffer input;
+    input.append(d1.data(), d1.size());
+    input.append(d2.data(), d2.size() - 2);
+
+    protocol::Parser parser;
+    auto messages = parser.feed(input);
+    ASSERT_EQ(1u, messages.size());
+    EXPECT_EQ(7u, messages[0].cmd);
+    EXPECT_EQ(d2.size() - 2, input.readable_bytes());
+
+    input.append(d2.data() + d2.size() - 2, 2);
+    messages = parser.feed(input);
+    ASSERT_EQ(1u, messages.size());
+    EXPECT_EQ(8u, messages[0].cmd);
+    EXPECT_TRUE(input.empty());
+}
+
+TEST(ProtocolParserTest, FeedViewsPointIntoInputAndBufferOnlyPartial) {
+    auto d1 = protocol::serialize(protocol::Message(1, std::string("one")));
+    auto d2 = protocol::serialize(protocol::Message(2, std::string("two!")));
+    std::vector<char> stream(d1.begin(), d1.end());
+    stream.insert(stream.end(), d2.begin(), d2.end());
+
+    protocol::Parser parser;
+    std::vector<std::pair<std::uint16_t, std::string>> got;
+    auto collect = [&](const protocol::MessageView& msg) {
+        got.emplace_back(msg.cmd, std::string(msg.body));
+    };
+
+    // 第一帧完整 + 第二帧缺 3 字节：第一帧视图直接指向输入
+    std::string_view first(stream.data(), stream.size() - 3);
+    const char* body_ptr = nullptr;
+    EXPECT_EQ(1u, parser.feed_views(first, [&](const protocol::MessageView& msg) {
+        body_ptr = msg.body.data();
+        collect(msg);
+    }));
+    EXPECT_EQ(stream.data() + 4, body_ptr);
+
+    EXPECT_EQ(1u, parser.feed_views(std::string_view(stream.data() + stream.size() - 3, 3),
+                                    collect));
+    ASSERT_EQ(2u, got.size());
+    EXPECT_EQ(1u, got[0].first);
+    EXPECT_EQ("one", got[0].second);
+    EXPECT_EQ(2u, got[1].first);
+    EXPECT_EQ("two!", got[1].second);
+}
+
+TEST(ProtocolParserTest, LegacySerializeRefusesOversizedBody) {
+    protocol::Message big(5, std::string(70000, 'x'));
+    EXPECT_TRUE(protocol::serialize(big).empty());
+
+    std::string out;
+    EXPECT_FALSE(protocol::serialize_to(out, 5, std::string(70000, 'x')));
+    EXPECT_TRUE(out.empty());
+}
+
+TEST(ProtocolParserTest, ExtendedFrameCarriesLargeBodyWithVarintLength) {
+    const protocol::FrameFormat ext = protocol::FrameFormat::kExtended;
+    // 长度编码跨越 1 / 2 / 3 字节的边界
+    for (std::size_t len : {0u, 127u, 128u, 16383u, 16384u, 300000u}) {
+        std::string body(len, '\0');
+        for (std::size_t i = 0; i < len; ++i) body[i] = static_cast<char>(i * 31);
+        auto data = protocol::serialize(protocol::Message(0x0207, body), ext);
+        std::size_t header = len < 128 ? 5 : (len < 16384 ? 6 : 7);
+        ASSERT_EQ(header + len, data.size());
+        EXPECT_EQ(static_cast<char>(protocol::kExtendedVersion), data[0]);
+        EXPECT_EQ(0, data[1]);
+
+        protocol::Parser parser(net::Buffer::kInitialSize, ext);
+        auto messages = parser.feed(data);
+        ASSERT_EQ(1u, messages.size());
+        EXPECT_EQ(0x0207u, messages[0].cmd);
+        EXPECT_EQ(body, std::string(messages[0].body.begin(), messages[0].body.end()));
+        EXPECT_TRUE(parser.idle());
+    }
+}
+
+TEST(ProtocolParserTest, ExtendedFragmentsReassembleAcrossPartialFeeds) {
+    const protocol::FrameFormat ext = protocol::FrameFormat::kExtended;
+    std::string body(10000, '\0');
+    for (std::size_t i = 0; i < body.size(); ++i) body[i] = static_cast<char>('a' + i % 26);
+    // 4096 字节一片：3 片，只有最后一片不带 kFlagMore
+    auto fragmented = protocol::serialize(protocol::Message(9, body), ext, 4096);
+    auto tail = protocol::serialize(protocol::Message(10, std::string("next")), ext);
+    ASSERT_EQ(static_cast<char>(protocol::kFlagMore), fragmented[1]);
+    std::vector<char> stream(fragmented.begin(), fragmented.end());
+    stream.insert(stream.end(), tail.begin(), tail.end());
+
+    // 逐字节喂入：残帧补齐、分片拼接与后续普通帧都要正确
+    protocol::Parser parser(0, ext);
+    std::vector<std::pair<std::uint16_t, std::string>> got;
+    for (char c : stream) {
+        parser.feed_views(std::string_view(&c, 1), [&](const protocol::MessageView& msg) {
+            got.emplace_back(msg.cmd, std::string(msg.body));
+        });
+        if (got.empty()) {
+            EXPECT_FALSE(parser.idle());
+        }
+    }
+    ASSERT_EQ(2u, got.size());
+    EXPECT_EQ(9u, got[0].first);
+    EXPECT_EQ(body, got[0].second);
+    EXPECT_EQ(10u, got[1].first);
+    EXPECT_EQ("next", got[1].second);
+    EXPECT_TRUE(parser.idle());
+    EXPECT_FALSE(parser.failed());
+}
+
+TEST(ProtocolParserTest, ExtendedRejectsMalformedFrames) {
+    const protocol::FrameFormat ext = protocol::FrameFormat::kExtended;
+
+    // 旧格式的流连到扩展端口：第一个字节即可判定
+    protocol::Parser legacy_on_ext(net::Buffer::kInitialSize, ext);
+    EXPECT_TRUE(legacy_on_ext.feed(protocol::serialize(protocol::Message(1, std::string("x")))).empty());
+    EXPECT_TRUE(legacy_on_ext.failed());
+
+    // 保留标志位
+    auto data = protocol::serialize(protocol::Message(1, std::string("x")), ext);
+    data[1] = 0x40;
+    protocol::Parser reserved(net::Buffer::kInitialSize, ext);
+    EXPECT_TRUE(reserved.feed(data).empty());
+    EXPECT_TRUE(reserved.failed());
+
+    // 分片中途换了 cmd
+    auto first = protocol::serialize(protocol::Message(1, std::string("abcdef")), ext, 3);
+    auto other = protocol::serialize(protocol::Message(2, std::string("zz")), ext);
+    std::vector<char> mixed(first.begin(), first.begin() + 8);  // 只取第一片
+    mixed.insert(mixed.end(), other.begin(), other.end());
+    protocol::Parser interleaved(net::Buffer::kInitialSize, ext);
+    EXPECT_TRUE(interleaved.feed(mixed).empty());
+    EXPECT_TRUE(interleaved.failed());
+
+    // 拼接后超过消息上限
+    protocol::Parser limited(net::Buffer::kInitialSize, ext);
+    limited.set_max_message_bytes(5);
+    EXPECT_TRUE(limited.feed(first).empty());
+    EXPECT_TRUE(limited.failed());
+}
+
+TEST(ProtocolParserTest, FrameCompressorRoundTripsWithTrainedDictionary) {
+    if (!protocol::frame_compression_available()) {
+        GTEST_SKIP() << "built without zlib";
+    }
+    std::vector<std::string> samples;
+    for (int i = 0; i < 40; ++i) samples.push_back(make_snapshot(i));
+    auto dict = std::make_shared<protocol::FrameDictionary>(protocol::FrameDictionary::train(samples, 2048));
+    ASSERT_FALSE(dict->empty());
+    EXPECT_LE(dict->bytes().size(), 2048u);
+    EXPECT_NE(0u, dict->id());
+
+    protocol::CompressionConfig config;
+    config.min_size = 64;
+    protocol::FrameCompressor plain(config, nullptr);
+    protocol::FrameCompressor with_dict(config, dict);
+    EXPECT_EQ(0u, plain.dictionary_id());
+    EXPECT_EQ(dict->id(), with_dict.dictionary_id());
+
+    // 训练集之外的快照：带字典压缩得更小，且都能还原
+    std::size_t plain_total = 0, dict_total = 0;
+    std::string packed, restored;
+    for (int i = 100; i < 110; ++i) {
+        std::string snapshot = make_snapshot(i);
+        ASSERT_TRUE(plain.compress(snapshot, &packed));
+        plain_total += packed.size();
+        ASSERT_EQ(0, plain.decompress(packed, &restored));
+        EXPECT_EQ(snapshot, restored);
+        // 不带字典的流，带字典的一端也能解
+        ASSERT_EQ(0, with_dict.decompress(packed, &restored));
+        EXPECT_EQ(snapshot, restored);
+
+        ASSERT_TRUE(with_dict.compress(snapshot, &packed));
+        dict_total += packed.size();
+        ASSERT_EQ(0, with_dict.decompress(packed, &restored));
+        EXPECT_EQ(snapshot, restored);
+        // 字典不符：没有字典或字典内容不同都拒绝
+        EXPECT_EQ(-1, plain.decompress(packed, &restored));
+        protocol::FrameCompressor other(config, std::make_shared<protocol::FrameDictionary>(std::string(64, 'z')));
+        EXPECT_EQ(-1, other.decompress(packed, &restored));
+    }
+    EXPECT_LT(dict_total, plain_total);
+    EXPECT_GT(with_dict.raw_bytes(), with_dict.compressed_bytes());
+
+    // 低于阈值或压不小的不压缩；损坏的数据与解压超限被拒绝
+    EXPECT_FALSE(plain.compress(std::string(10, 'a'), &packed));
+    EXPECT_FALSE(plain.compress(std::string("0123456789abcdefghijklmnopqrstuvwxyz!@#$%^&*()_+-=[]{};:,.<>?/|~`ABCDEFGHIJKLMNOPQRSTUVWXYZ"), &packed));
+    ASSERT_TRUE(plain.compress(std::string(4096, 'q'), &packed));
+    std::string truncated = packed.substr(0, packed.size() - 2);
+    EXPECT_EQ(-1, plain.decompress(truncated, &restored));
+    EXPECT_EQ(-1, plain.decompress(packed + "x", &restored));
+    protocol::CompressionConfig small = config;
+    small.max_decompressed_size = 1024;
+    protocol::FrameCompressor bounded(small, nullptr);
+    EXPECT_EQ(-2, bounded.decompress(packed, &restored));
+}
+
+TEST(ProtocolParserTest, CompressedFlagSurvivesFragmentation) {
+    if (!protocol::frame_compression_available()) {
+        GTEST_SKIP() << "built without zlib";
+    }
+    const protocol::FrameFormat ext = protocol::FrameFormat::kExtended;
+    protocol::CompressionConfig config;
+    protocol::FrameCompressor codec(config, nullptr);
+
+    // 压缩后仍超过分片大小：每一片都带 kFlagCompressed，拼接后整体解压
+    std::string body;
+    for (int i = 0; i < 200; ++i) body += make_snapshot(i);
+    std::string wire;
+    codec.encode(wire, 0x0301, body, 1024);
+    codec.encode(wire, 0x0302, "tiny");
+    EXPECT_EQ(static_cast<char>(protocol::kFlagCompressed | protocol::kFlagMore), wire[1]);
+
+    protocol::Parser parser(0, ext);
+    std::vector<std::pair<protocol::MessageView, std::string>> got;
+    parser.feed_views(wire, [&](const protocol::MessageView& msg) {
+        got.emplace_back(msg, std::string(msg.body));
+    });
+    ASSERT_EQ(2u, got.size());
+    EXPECT_EQ(protocol::kFlagCompressed, got[0].first.flags);
+    std::string restored;
+    ASSERT_EQ(0, codec.decompress(got[0].second, &restored));
+    EXPECT_EQ(body, restored);
+    EXPECT_EQ(0, got[1].first.flags);
+    EXPECT_EQ("tiny", got[1].second);
+
+    // 分片中途换了压缩标志：非法；旧格式不带标志位
+    std::string mixed;
+    protocol::serialize_to(mixed, 1, "abcdef", ext, 3, protocol::kFlagCompressed);
+    mixed.resize(8);  // 只取第一片
+    protocol::serialize_to(mixed, 1, "zz", ext);
+    protocol::Parser interleaved(net::Buffer::kInitialSize, ext);
+    EXPECT_TRUE(interleaved.feed(mixed).empty());
+    EXPECT_TRUE(interleaved.failed());
+    std::string legacy;
+    EXPECT_FALSE(protocol::serialize_to(legacy, 1, "abc", protocol::FrameFormat::kLegacy,
+                                        protocol::kMaxFrameBody, protocol::kFlagCompressed));
+}
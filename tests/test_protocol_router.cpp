@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include <cstdint>
 #include <string>
 #include <string_view>
@@ -7,6 +10,7 @@
 
 #include "chwell/net/posix_io.h"
 #include "chwell/net/tcp_connection.h"
+#include "chwell/protocol/compression.h"
 #include "chwell/protocol/message.h"
 #include "chwell/protocol/parser.h"
 #include "chwell/service/protocol_router.h"
@@ -137,3 +141,202 @@ TEST(ProtocolRouterTest, DisconnectCleansParserForConnection) {
     EXPECT_EQ(call_count, 0);
 }
 
+
+// 6. make_frame 与 serialize 字节一致，可直接用于广播
+TEST(ProtocolRouterTest, MakeFrameMatchesSerialize) {
+    protocol::Message msg(0x0102, std::string("broadcast body"));
+    net::SharedFrame frame = service::ProtocolRouterComponent::make_frame(msg);
+    std::vector<char> expected = protocol::serialize(msg);
+
+    ASSERT_EQ(expected.size(), frame.size());
+    EXPECT_EQ(std::string(expected.begin(), expected.end()), std::string(frame.view()));
+    EXPECT_EQ(1, frame.use_count());
+}
+
+// 7. 视图处理器：逐字节投递仍能拼出完整帧；处理器中断开连接（清理 parser）不影响本轮分发
+TEST(ProtocolRouterTest, ViewHandlerSurvivesFragmentsAndDisconnect) {
+    service::ProtocolRouterComponent router;
+
+    std::vector<std::string> bodies;
+    auto conn = make_dummy_conn();
+    router.register_view_handler(0x0004, [&](const net::TcpConnectionPtr& c,
+                                             const protocol::MessageView& msg) {
+        bodies.emplace_back(msg.body);
+        if (msg.body == "bye") {
+            router.on_disconnect(c);
+        }
+    });
+
+    auto frame = make_frame(0x0004, "view body");
+    for (char ch : frame) {
+        router.on_message(conn, std::string_view(&ch, 1));
+    }
+    ASSERT_EQ(1u, bodies.size());
+    EXPECT_EQ("view body", bodies[0]);
+
+    std::vector<char> stream = make_frame(0x0004, "bye");
+    std::vector<char> next = make_frame(0x0004, "after");
+    stream.insert(stream.end(), next.begin(), next.end());
+    router.on_message(conn, as_view(stream));
+    ASSERT_EQ(3u, bodies.size());
+    EXPECT_EQ("bye", bodies[1]);
+    EXPECT_EQ("after", bodies[2]);
+}
+
+// 扩展帧格式的连接：分片拼成整条消息再分发，回复按连接的格式编码，非法帧关闭连接
+TEST(ProtocolRouterTest, ExtendedFormatConnectionReassemblesAndRejects) {
+    const protocol::FrameFormat ext = protocol::FrameFormat::kExtended;
+    service::ProtocolRouterComponent router;
+
+    std::vector<std::string> bodies;
+    router.register_view_handler(0x0207, [&](const net::TcpConnectionPtr&,
+                                             const protocol::MessageView& msg) {
+        bodies.emplace_back(msg.body);
+    });
+
+    auto conn = make_dummy_conn();
+    conn->set_frame_format(static_cast<std::uint8_t>(ext));
+    EXPECT_EQ(ext, service::ProtocolRouterComponent::frame_format(conn));
+
+    // 100 KiB 快照：超过旧帧头上限，分 4 片发出；完整帧走快速路径
+    std::string snapshot(100 * 1024, 's');
+    auto small = protocol::serialize(protocol::Message(0x0207, std::string("tick")), ext);
+    auto big = protocol::serialize(protocol::Message(0x0207, snapshot), ext, 32 * 1024);
+    router.on_message(conn, as_view(small));
+    router.on_message(conn, std::string_view(big.data(), 1000));
+    router.on_message(conn, std::string_view(big.data() + 1000, big.size() - 1000));
+    ASSERT_EQ(2u, bodies.size());
+    EXPECT_EQ("tick", bodies[0]);
+    EXPECT_EQ(snapshot, bodies[1]);
+    EXPECT_FALSE(conn->is_closed());
+
+    // 共享帧按格式编码，与 serialize 一致
+    net::SharedFrame frame = service::ProtocolRouterComponent::make_frame(
+        protocol::Message(0x0207, std::string("tick")), ext);
+    EXPECT_EQ(std::string(small.begin(), small.end()), std::string(frame.data(), frame.size()));
+
+    // 旧格式的帧发到扩展连接：关闭连接
+    router.on_message(conn, as_view(make_frame(0x0207, "legacy")));
+    EXPECT_EQ(2u, bodies.size());
+    EXPECT_TRUE(conn->is_closed());
+}
+
+TEST(ProtocolRouterTest, NegotiatesCompressionPerConnection) {
+    if (!protocol::frame_compression_available()) {
+        GTEST_SKIP() << "built without zlib";
+    }
+    const protocol::FrameFormat ext = protocol::FrameFormat::kExtended;
+    std::vector<std::string> samples;
+    for (int i = 0; i < 20; ++i) {
+        samples.push_back("{\"frame\":" + std::to_string(i) + ",\"players\":[\"alice\",\"bob\"],\"phase\":\"battle\"}");
+    }
+    protocol::CompressionConfig config;
+    config.min_size = 32;
+    config.dictionary = std::make_shared<protocol::FrameDictionary>(protocol::FrameDictionary::train(samples));
+    ASSERT_FALSE(config.dictionary->empty());
+
+    service::ProtocolRouterComponent router;
+    router.enable_compression(config);
+    std::vector<std::string> bodies;
+    router.register_view_handler(0x0207, [&](const net::TcpConnectionPtr&,
+                                             const protocol::MessageView& msg) {
+        bodies.emplace_back(msg.body);
+    });
+
+    // 连接的一端交给 TcpConnection（无 loop 时阻塞写出），另一端读回服务端发出的字节
+    int fds[2];
+    ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    auto conn = std::make_shared<net::TcpConnection>(net::TcpSocket(fds[0]));
+    conn->set_frame_format(static_cast<std::uint8_t>(ext));
+    struct Frame {
+        std::uint16_t cmd;
+        std::uint8_t flags;
+        std::string body;
+    };
+    auto read_frames = [&](int fd) {
+        std::string wire;
+        char buf[65536];
+        ssize_t n;
+        while ((n = ::recv(fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0) wire.append(buf, n);
+        std::vector<Frame> out;
+        protocol::Parser parser(0, ext);
+        parser.feed_views(wire, [&](const protocol::MessageView& msg) {
+            out.push_back(Frame{msg.cmd, msg.flags, std::string(msg.body)});
+        });
+        return out;
+    };
+
+    // 未协商就发来压缩帧：关闭连接
+    protocol::FrameCompressor client(config, config.dictionary);
+    auto rogue = make_dummy_conn();
+    rogue->set_frame_format(static_cast<std::uint8_t>(ext));
+    std::string compressed;
+    client.encode(compressed, 0x0207, samples[0] + samples[1]);
+    ASSERT_EQ(static_cast<char>(protocol::kFlagCompressed), compressed[1]);
+    router.on_message(rogue, compressed);
+    EXPECT_TRUE(bodies.empty());
+    EXPECT_TRUE(rogue->is_closed());
+
+    // 协商：客户端持有同一字典，服务端回送其 id；之后压缩帧被解压后分发
+    std::string offer;
+    protocol::serialize_to(offer, protocol::kCmdCompression,
+                           protocol::encode_compression_offer(protocol::kCompressionDeflate,
+                                                              config.dictionary->id()),
+                           ext);
+    router.on_message(conn, offer);
+    auto replies = read_frames(fds[1]);
+    ASSERT_EQ(1u, replies.size());
+    EXPECT_EQ(protocol::kCmdCompression, replies[0].cmd);
+    EXPECT_EQ(0, replies[0].flags);
+    std::uint8_t algo = 0;
+    std::uint32_t dict_id = 0;
+    ASSERT_TRUE(protocol::decode_compression_offer(replies[0].body, algo, dict_id));
+    EXPECT_EQ(protocol::kCompressionDeflate, algo);
+    EXPECT_EQ(config.dictionary->id(), dict_id);
+    ASSERT_TRUE(service::ProtocolRouterComponent::frame_codec(conn));
+
+    router.on_message(conn, compressed);
+    ASSERT_EQ(1u, bodies.size());
+    EXPECT_EQ(samples[0] + samples[1], bodies[0]);
+
+    // 发送：超过阈值的压缩，小消息原样发送
+    const std::string snapshot = samples[2] + samples[3] + samples[4];
+    service::ProtocolRouterComponent::send_message(conn, protocol::Message(0x0208, snapshot));
+    service::ProtocolRouterComponent::send_message(conn, protocol::Message(0x0209, std::string("ok")));
+    auto sent = read_frames(fds[1]);
+    ASSERT_EQ(2u, sent.size());
+    EXPECT_EQ(protocol::kFlagCompressed, sent[0].flags);
+    std::string restored;
+    ASSERT_EQ(0, client.decompress(sent[0].body, &restored));
+    EXPECT_EQ(snapshot, restored);
+    EXPECT_EQ(0, sent[1].flags);
+    EXPECT_EQ("ok", sent[1].body);
+
+    // 广播：协商了压缩的连接收到压缩帧，未协商的扩展连接收到原文
+    int plain_fds[2];
+    ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, plain_fds));
+    auto plain = std::make_shared<net::TcpConnection>(net::TcpSocket(plain_fds[0]));
+    plain->set_frame_format(static_cast<std::uint8_t>(ext));
+    service::ProtocolRouterComponent::broadcast_message({conn, plain, conn},
+                                                        protocol::Message(0x0208, snapshot));
+    auto to_compressed = read_frames(fds[1]);
+    auto to_plain = read_frames(plain_fds[1]);
+    ASSERT_EQ(2u, to_compressed.size());
+    EXPECT_EQ(protocol::kFlagCompressed, to_compressed[1].flags);
+    EXPECT_EQ(sent[0].body, to_compressed[1].body);
+    ASSERT_EQ(1u, to_plain.size());
+    EXPECT_EQ(0, to_plain[0].flags);
+    EXPECT_EQ(snapshot, to_plain[0].body);
+    ::close(plain_fds[1]);
+
+    // 旧格式的连接不能协商压缩
+    int legacy_fds[2];
+    ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, legacy_fds));
+    auto legacy = std::make_shared<net::TcpConnection>(net::TcpSocket(legacy_fds[0]));
+    router.on_message(legacy, as_view(make_frame(protocol::kCmdCompression,
+        protocol::encode_compression_offer(protocol::kCompressionDeflate, 0))));
+    EXPECT_FALSE(service::ProtocolRouterComponent::frame_codec(legacy));
+    EXPECT_FALSE(legacy->is_closed());
+    ::close(legacy_fds[1]);
+    ::close(fds[1]);
+}
@@ -0,0 +1,323 @@
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chwell/http/http_server.h"
+#include "chwell/http/static_files.h"
+
+#include "test_net_helpers.h"
+
+using namespace chwell;
+using test::connect_local;
+
+namespace {
+
+constexpr unsigned short STATIC_PORT = 19956;
+
+// 测试用资源目录，析构时删除
+struct AssetDir {
+    std::string path;
+    std::vector<std::string> files;
+
+    AssetDir() {
+        path = "/tmp/chwell_static_test_" + std::to_string(::getpid());
+        ::mkdir(path.c_str(), 0755);
+        ::mkdir((path + "/sub").c_str(), 0755);
+    }
+    ~AssetDir() {
+        for (const std::string& f : files) ::unlink(f.c_str());
+        ::rmdir((path + "/sub").c_str());
+        ::rmdir(path.c_str());
+    }
+    void write(const std::string& name, const std::string& data) {
+        std::ofstream(path + "/" + name, std::ios::binary | std::ios::trunc) << data;
+        files.push_back(path + "/" + name);
+    }
+};
+
+std::string repeat_text(std::size_t bytes) {
+    std::string s;
+    while (s.size() < bytes) s += "<div class=\"hud\">chwell static asset line</div>\n";
+    s.resize(bytes);
+    return s;
+}
+
+std::string binary_blob(std::size_t bytes) {
+    std::string s(bytes, '\0');
+    std::uint32_t x = 2463534242u;
+    for (char& c : s) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        c = static_cast<char>(x);
+    }
+    return s;
+}
+
+// 构造请求视图（头部视图指向 storage）
+struct Request {
+    std::string method;
+    std::string path;
+    std::vector<std::pair<std::string, std::string>> storage;
+    http::HttpRequestView view;
+
+    Request(const std::string& m, const std::string& p) : method(m), path(p) {}
+    Request& header(const std::string& name, const std::string& value) {
+        storage.emplace_back(name, value);
+        return *this;
+    }
+    const http::HttpRequestView& get() {
+        view.clear();
+        view.method = method;
+        view.path = path;
+        view.version = "HTTP/1.1";
+        for (const auto& h : storage) view.headers.push_back({h.first, h.second});
+        return view;
+    }
+};
+
+std::string body_of(const http::HttpResponse& resp) {
+    if (!resp.shared_body.empty()) return std::string(resp.shared_body.view());
+    if (!resp.file_body.empty()) {
+        std::string out;
+        net::read_file_region(resp.file_body, static_cast<std::size_t>(resp.file_body.length), &out);
+        return out;
+    }
+    return resp.body;
+}
+
+std::string header_value(const std::string& block, const std::string& name) {
+    std::size_t p = block.find(name + ": ");
+    if (p == std::string::npos) return std::string();
+    p += name.size() + 2;
+    return block.substr(p, block.find("\r\n", p) - p);
+}
+
+std::string read_bytes(int fd, std::size_t want, int timeout_ms = 5000) {
+    std::string out;
+    char buf[65536];
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (out.size() < want && std::chrono::steady_clock::now() < deadline) {
+        pollfd pfd{fd, POLLIN, 0};
+        if (poll(&pfd, 1, 50) <= 0) continue;
+        ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n <= 0) break;
+        out.append(buf, static_cast<std::size_t>(n));
+    }
+    return out;
+}
+
+}  // namespace
+
+TEST(StaticFileTest, ConditionalRangeAndGzip) {
+    AssetDir dir;
+    const std::string html = repeat_text(8000);
+    dir.write("index.html", html);
+    dir.write("sub/app.js", "console.log('hi');");
+    dir.write(".secret", "nope");
+
+    http::StaticFileConfig cfg;
+    cfg.root = dir.path;
+    cfg.url_prefix = "/h5";
+    cfg.revalidate_ms = 0;
+    http::StaticFileHandler files(cfg);
+
+    // 前缀之外不处理；不带结尾 '/' 的前缀重定向
+    http::HttpResponse resp;
+    EXPECT_FALSE(files.handle(Request("GET", "/api/x").get(), resp));
+    ASSERT_TRUE(files.handle(Request("GET", "/h5?v=1").get(), resp));
+    EXPECT_EQ(301, resp.status_code);
+    EXPECT_EQ("/h5/?v=1", resp.headers["Location"]);
+
+    // 目录映射到 index.html，正文为共享帧，响应头预先生成
+    resp = http::HttpResponse();
+    ASSERT_TRUE(files.handle(Request("GET", "/h5/").get(), resp));
+    EXPECT_EQ(200, resp.status_code);
+    EXPECT_EQ(html, body_of(resp));
+    EXPECT_EQ("text/html; charset=utf-8", header_value(resp.header_block, "Content-Type"));
+    const std::string etag = header_value(resp.header_block, "ETag");
+    ASSERT_FALSE(etag.empty());
+    EXPECT_EQ(html.size(), resp.body_size());
+
+    // gzip 变体：只压缩一次，体积更小，ETag 与原始表示不同
+    resp = http::HttpResponse();
+    files.handle(Request("GET", "/h5/index.html").header("Accept-Encoding", "br, gzip;q=0.8").get(), resp);
+    EXPECT_EQ("gzip", header_value(resp.header_block, "Content-Encoding"));
+    ASSERT_GE(resp.shared_body.size(), 2u);
+    EXPECT_LT(resp.shared_body.size(), html.size() / 4);
+    EXPECT_EQ('\x1f', resp.shared_body.data()[0]);
+    EXPECT_EQ('\x8b', resp.shared_body.data()[1]);
+    EXPECT_NE(etag, header_value(resp.header_block, "ETag"));
+    resp = http::HttpResponse();
+    files.handle(Request("GET", "/h5/index.html").header("Accept-Encoding", "gzip;q=0").get(), resp);
+    EXPECT_TRUE(header_value(resp.header_block, "Content-Encoding").empty());
+
+    // 条件请求
+    resp = http::HttpResponse();
+    files.handle(Request("GET", "/h5/index.html").header("If-None-Match", "\"x\", " + etag).get(), resp);
+    EXPECT_EQ(304, resp.status_code);
+    EXPECT_EQ(0u, body_of(resp).size());
+    std::string head;
+    resp.append_to(&head);
+    EXPECT_EQ(std::string::npos, head.find("Content-Length"));
+    const std::string last_modified = header_value(resp.header_block, "Last-Modified");
+    resp = http::HttpResponse();
+    files.handle(Request("HEAD", "/h5/index.html").header("If-Modified-Since", last_modified).get(), resp);
+    EXPECT_EQ(304, resp.status_code);
+
+    // Range
+    resp = http::HttpResponse();
+    files.handle(Request("GET", "/h5/index.html").header("Range", "bytes=10-19").get(), resp);
+    EXPECT_EQ(206, resp.status_code);
+    EXPECT_EQ(html.substr(10, 10), body_of(resp));
+    EXPECT_EQ("bytes 10-19/" + std::to_string(html.size()), header_value(resp.header_block, "Content-Range"));
+    resp = http::HttpResponse();
+    files.handle(Request("GET", "/h5/index.html").header("Range", "bytes=-5").get(), resp);
+    EXPECT_EQ(html.substr(html.size() - 5), body_of(resp));
+    resp = http::HttpResponse();
+    files.handle(Request("GET", "/h5/index.html").header("Range", "bytes=99999-").get(), resp);
+    EXPECT_EQ(416, resp.status_code);
+    resp = http::HttpResponse();
+    files.handle(Request("GET", "/h5/index.html").header("Range", "bytes=0-1").header("If-Range", "\"old\"").get(), resp);
+    EXPECT_EQ(200, resp.status_code);  // If-Range 不匹配：返回完整内容
+
+    // 拒绝目录穿越与隐藏文件；非 GET/HEAD 返回 405；目录不带 '/' 重定向
+    for (const char* bad : {"/h5/../etc/passwd", "/h5/%2e%2e/x", "/h5/.secret", "/h5/missing.png"}) {
+        resp = http::HttpResponse();
+        ASSERT_TRUE(files.handle(Request("GET", bad).get(), resp));
+        EXPECT_EQ(404, resp.status_code) << bad;
+    }
+    resp = http::HttpResponse();
+    files.handle(Request("POST", "/h5/index.html").get(), resp);
+    EXPECT_EQ(405, resp.status_code);
+    resp = http::HttpResponse();
+    files.handle(Request("GET", "/h5/sub").get(), resp);
+    EXPECT_EQ(301, resp.status_code);
+    EXPECT_EQ("/h5/sub/", resp.headers["Location"]);
+    resp = http::HttpResponse();
+    files.handle(Request("GET", "/h5/sub/app.js").get(), resp);
+    EXPECT_EQ("application/javascript; charset=utf-8", header_value(resp.header_block, "Content-Type"));
+
+    // 文件变化后重新加载
+    http::StaticFileHandler::Stats before = files.stats();
+    EXPECT_GE(before.hits, 5u);
+    dir.write("index.html", html + "v2");
+    resp = http::HttpResponse();
+    files.handle(Request("GET", "/h5/index.html").get(), resp);
+    EXPECT_EQ(html + "v2", body_of(resp));
+    EXPECT_NE(etag, header_value(resp.header_block, "ETag"));
+    EXPECT_EQ(before.misses + 1, files.stats().misses);
+}
+
+// 同一文件的并发未命中只加载一次；LRU 按字节上限淘汰
+TEST(StaticFileTest, SingleFlightMissesAndLruBudget) {
+    AssetDir dir;
+    for (int i = 0; i < 8; ++i) {
+        dir.write("f" + std::to_string(i) + ".txt", repeat_text(4096));
+    }
+    http::StaticFileConfig cfg;
+    cfg.root = dir.path;
+    cfg.gzip = false;
+    cfg.cache_max_bytes = 3 * 4096;
+    http::StaticFileHandler files(cfg);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&files]() {
+            http::HttpResponse resp;
+            files.handle(Request("GET", "/f0.txt").get(), resp);
+            EXPECT_EQ(4096u, resp.body_size());
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    EXPECT_EQ(1u, files.stats().misses);
+    EXPECT_EQ(7u, files.stats().hits);
+
+    for (int i = 0; i < 8; ++i) {
+        http::HttpResponse resp;
+        files.handle(Request("GET", "/f" + std::to_string(i) + ".txt").get(), resp);
+    }
+    http::StaticFileHandler::Stats s = files.stats();
+    EXPECT_EQ(3u, s.entries);
+    EXPECT_LE(s.cached_bytes, cfg.cache_max_bytes);
+}
+
+// 经 HttpServer 发送：大文件走 sendfile（含 Range），与流水线中的其他响应保持顺序
+TEST(StaticFileTest, ServerSendsLargeFilesWithSendfile) {
+    AssetDir dir;
+    const std::string blob = binary_blob(3 * 1024 * 1024 + 17);
+    dir.write("bundle.bin", blob);
+    dir.write("small.txt", "small");
+
+    net::EventLoopThreadPool loops(1);
+    loops.start();
+    http::HttpServer server(loops, STATIC_PORT);
+    http::StaticFileConfig cfg;
+    cfg.root = dir.path;
+    cfg.url_prefix = "/static/";
+    cfg.cache_max_file_size = 64 * 1024;
+    http::StaticFileHandlerPtr files = server.mount_static(cfg);
+    server.set_view_handler([](const http::HttpRequestView& req, http::HttpResponse& resp) {
+        resp.body = "dynamic " + std::string(req.path);
+    });
+    server.start();
+
+    int fd = connect_local(STATIC_PORT);
+    ASSERT_GE(fd, 0);
+    const std::string req =
+        "GET /static/bundle.bin HTTP/1.1\r\nHost: x\r\n\r\n"
+        "GET /static/bundle.bin HTTP/1.1\r\nHost: x\r\nRange: bytes=1000-1999\r\n\r\n"
+        "GET /static/small.txt HTTP/1.1\r\nHost: x\r\n\r\n"
+        "GET /api HTTP/1.1\r\nHost: x\r\n\r\n";
+    ASSERT_EQ(static_cast<ssize_t>(req.size()), ::write(fd, req.data(), req.size()));
+
+    // 逐个解析响应
+    std::string data;
+    auto next_response = [&](std::string* headers) {
+        for (;;) {
+            std::size_t end = data.find("\r\n\r\n");
+            if (end != std::string::npos) {
+                *headers = data.substr(0, end + 4);
+                std::size_t len = std::stoul(header_value(*headers, "Content-Length"));
+                while (data.size() < end + 4 + len) {
+                    std::string more = read_bytes(fd, end + 4 + len - data.size());
+                    if (more.empty()) return std::string();
+                    data += more;
+                }
+                std::string body = data.substr(end + 4, len);
+                data.erase(0, end + 4 + len);
+                return body;
+            }
+            std::string more = read_bytes(fd, 1);
+            if (more.empty()) return std::string();
+            data += more;
+        }
+    };
+    std::string headers;
+    std::string body = next_response(&headers);
+    EXPECT_EQ(0u, headers.find("HTTP/1.1 200 OK"));
+    EXPECT_TRUE(body == blob) << "size " << body.size();
+    body = next_response(&headers);
+    EXPECT_EQ(0u, headers.find("HTTP/1.1 206 Partial Content"));
+    EXPECT_EQ(blob.substr(1000, 1000), body);
+    EXPECT_EQ("small", next_response(&headers));
+    EXPECT_EQ("dynamic /api", next_response(&headers));
+    ::close(fd);
+
+    EXPECT_EQ(2u, files->stats().entries);
+    EXPECT_LT(files->stats().cached_bytes, 1024u);  // 大文件只缓存句柄
+    server.stop();
+    loops.stop();
+}
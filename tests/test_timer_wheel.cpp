@@ -1,8 +1,11 @@
 #include <gtest/gtest.h>
 #include <thread>
 #include <chrono>
+#include <memory>
+#include <vector>
 
 #include "chwell/core/timer_wheel.h"
+#include "chwell/net/loop_timer.h"
 
 using namespace chwell;
 using namespace std::chrono_literals;
@@ -140,3 +143,81 @@ TEST(TimerWheelTest, CurrentTimeMs) {
     auto t2 = core::TimerWheel::current_time_ms();
     EXPECT_GE(t2 - t1, 100);
 }
+
+// ============================================
+// net::LoopTimerWheel（EventLoop 内置，手动推进时间）
+// ============================================
+
+// 跨越各层的定时器都在到期 tick 触发：不早于 delay，至多晚一个 tick
+TEST(LoopTimerWheelTest, FiresAcrossLevelsWithinOneTick) {
+    const int tick = 100;
+    net::LoopTimerWheel wheel(tick);
+    const std::int64_t start = 1000000;
+    const std::int64_t delays[] = {0, 1, 99, 100, 250, 25500, 25600, 25700, 60000,
+                                   1638400, 1700000, 104857600};
+    std::vector<std::unique_ptr<net::LoopTimer>> timers;
+    std::vector<std::int64_t> fired(sizeof(delays) / sizeof(delays[0]), -1);
+    std::int64_t now = start;
+    for (std::size_t i = 0; i < fired.size(); ++i) {
+        timers.emplace_back(new net::LoopTimer([&fired, &now, i]() { fired[i] = now; }));
+        wheel.schedule(timers.back().get(), start, delays[i]);
+    }
+    EXPECT_EQ(fired.size(), wheel.size());
+
+    // 按 next_timeout_ms 跳跃推进，检验它不会跳过任何到期时间
+    while (wheel.size() > 0) {
+        int wait = wheel.next_timeout_ms(now);
+        ASSERT_GE(wait, 0);
+        now += wait > 0 ? wait : 1;
+        wheel.advance(now);
+    }
+    for (std::size_t i = 0; i < fired.size(); ++i) {
+        EXPECT_GE(fired[i] - start, delays[i]) << "delay " << delays[i];
+        EXPECT_LT(fired[i] - start, delays[i] + tick) << "delay " << delays[i];
+    }
+}
+
+// 重新调度 / 取消为 O(1) 摘挂；回调内可重新调度自身、取消同一 tick 的其他定时器；析构自动摘除
+TEST(LoopTimerWheelTest, RescheduleCancelAndReentrancy) {
+    net::LoopTimerWheel wheel(10);
+    std::int64_t now = 0;
+    int a_fired = 0;
+    int b_fired = 0;
+    net::LoopTimer b([&]() { ++b_fired; });
+    net::LoopTimer a;
+    a.set_callback([&]() {
+        ++a_fired;
+        wheel.cancel(&b);  // 同一 tick 到期的 b 不再触发
+        if (a_fired < 3) wheel.schedule(&a, now, 50);
+    });
+    wheel.schedule(&a, now, 50);
+    wheel.schedule(&b, now, 50);
+
+    // 反复重置（模拟每次收到数据时刷新截止时间）不会提前触发
+    for (int i = 0; i < 100; ++i) {
+        now += 10;
+        wheel.schedule(&a, now, 50);
+        wheel.advance(now);
+    }
+    EXPECT_EQ(0, a_fired);
+    EXPECT_FALSE(b.pending());
+    EXPECT_EQ(1, b_fired);  // b 未被重置，第 50ms 已触发
+    wheel.schedule(&b, now, 50);  // 与 a 同一 tick 到期，排在 a 之后
+
+    for (int i = 0; i < 30; ++i) {
+        now += 10;
+        wheel.advance(now);
+    }
+    EXPECT_EQ(3, a_fired);
+    EXPECT_EQ(1, b_fired);
+    EXPECT_EQ(0u, wheel.size());
+
+    {
+        net::LoopTimer scoped([]() { FAIL() << "destroyed timer must not fire"; });
+        wheel.schedule(&scoped, now, 10);
+        EXPECT_EQ(1u, wheel.size());
+    }
+    EXPECT_EQ(0u, wheel.size());
+    now += 100;
+    wheel.advance(now);
+}
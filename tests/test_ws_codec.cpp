@@ -0,0 +1,279 @@
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "chwell/net/ws_codec.h"
+#include "chwell/net/ws_server.h"
+
+#include "test_net_helpers.h"
+
+using namespace chwell;
+using test::connect_local;
+
+namespace {
+
+constexpr unsigned short WS_PORT_ECHO = 19951;
+
+const std::uint8_t kMask[4] = {0x37, 0xfa, 0x21, 0x3d};
+
+typedef std::vector<std::pair<net::WsOpcode, std::string>> Frames;
+
+net::WsDecoder::FrameCallback collect(Frames* out) {
+    return [out](net::WsOpcode op, std::string_view payload) {
+        out->emplace_back(op, std::string(payload));
+    };
+}
+
+std::string pattern(std::size_t size) {
+    std::string s(size, '\0');
+    for (std::size_t i = 0; i < size; ++i) {
+        s[i] = static_cast<char>((i * 31 + 7) & 0xff);
+    }
+    return s;
+}
+
+void write_str(int fd, const std::string& data) {
+    ASSERT_EQ(static_cast<ssize_t>(data.size()), ::write(fd, data.data(), data.size()));
+}
+
+// 读取服务端帧直到收到 count 个或超时；*eof 表示对端已关闭
+Frames read_frames(int fd, net::WsDecoder& decoder, std::size_t count, bool* eof = nullptr,
+                   int timeout_ms = 2000) {
+    Frames frames;
+    char buf[4096];
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (frames.size() < count && std::chrono::steady_clock::now() < deadline) {
+        pollfd pfd{fd, POLLIN, 0};
+        if (poll(&pfd, 1, 50) <= 0) continue;
+        ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n <= 0) {
+            if (eof) *eof = true;
+            break;
+        }
+        decoder.feed(std::string_view(buf, static_cast<std::size_t>(n)), collect(&frames));
+    }
+    return frames;
+}
+
+} // namespace
+
+TEST(WsCodecTest, HandshakeAcceptKeyAndIncrementalParse) {
+    // RFC 6455 1.3 示例
+    EXPECT_EQ("s3pPLMBiTxaQ9kYGzzhZRbK+xOo=", net::ws_accept_key("dGhlIHNhbXBsZSBub25jZQ=="));
+
+    std::string request = net::ws_client_handshake("localhost", "/game", "dGhlIHNhbXBsZSBub25jZQ==");
+    net::WsHandshakeRequest req;
+    EXPECT_EQ(0, net::parse_ws_handshake(request.substr(0, request.size() - 3), &req));
+    ASSERT_EQ(static_cast<long>(request.size()), net::parse_ws_handshake(request + "\x81", &req));
+    EXPECT_EQ("/game", req.path);
+    EXPECT_EQ("localhost", req.host);
+    EXPECT_NE(std::string::npos,
+              net::ws_handshake_response(req).find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo="));
+
+    // 非升级请求 / 版本不符
+    EXPECT_EQ(-1, net::parse_ws_handshake("GET / HTTP/1.1\r\nHost: x\r\n\r\n", &req));
+    std::string v8 = request;
+    v8.replace(v8.find("Version: 13"), 11, "Version: 8");
+    EXPECT_EQ(-1, net::parse_ws_handshake(v8, &req));
+    EXPECT_EQ(-1, net::parse_ws_handshake(std::string(9000, 'x'), &req));
+}
+
+TEST(WsCodecTest, MaskCopyMatchesBytewiseAtAnyOffset) {
+    const std::string src = pattern(300);
+    for (std::size_t offset = 0; offset < 4; ++offset) {
+        for (std::size_t len = 0; len <= src.size(); ++len) {
+            std::string expected(len, '\0');
+            for (std::size_t i = 0; i < len; ++i) {
+                expected[i] = static_cast<char>(src[i] ^ kMask[(offset + i) & 3]);
+            }
+            std::string out(len, '\0');
+            net::ws_mask_copy(&out[0], src.data(), len, kMask, offset);
+            ASSERT_EQ(expected, out) << "len=" << len << " offset=" << offset;
+
+            std::string in_place = src.substr(0, len);
+            net::ws_mask_copy(&in_place[0], in_place.data(), len, kMask, offset);
+            ASSERT_EQ(expected, in_place);
+        }
+    }
+}
+
+TEST(WsCodecTest, HeaderLengthEncodings) {
+    char header[net::kWsMaxHeaderSize];
+    EXPECT_EQ(2u, net::ws_encode_header(header, net::WsOpcode::kText, 125));
+    EXPECT_EQ('\x81', header[0]);
+    EXPECT_EQ(125, header[1]);
+    EXPECT_EQ(4u, net::ws_encode_header(header, net::WsOpcode::kBinary, 126));
+    EXPECT_EQ(126, header[1]);
+    EXPECT_EQ(10u, net::ws_encode_header(header, net::WsOpcode::kBinary, 65536, false));
+    EXPECT_EQ('\x02', header[0]);
+    EXPECT_EQ(127, header[1]);
+    EXPECT_EQ(14u, net::ws_encode_header(header, net::WsOpcode::kBinary, 70000, true, kMask));
+    EXPECT_EQ(static_cast<char>(0x80 | 127), header[1]);
+}
+
+TEST(WsCodecTest, DecoderReassemblesFragmentsAcrossArbitrarySplits) {
+    const std::string big = pattern(70000);
+    std::string stream;
+    stream += net::ws_encode_frame(net::WsOpcode::kText, "hel", false, kMask);
+    stream += net::ws_encode_frame(net::WsOpcode::kPing, "p", true, kMask);  // 控制帧插在分片之间
+    stream += net::ws_encode_frame(net::WsOpcode::kContinuation, "lo ", false, kMask);
+    stream += net::ws_encode_frame(net::WsOpcode::kContinuation, "world", true, kMask);
+    stream += net::ws_encode_frame(net::WsOpcode::kBinary, big, true, kMask);
+    stream += net::ws_encode_frame(net::WsOpcode::kBinary, "", true, kMask);
+    stream += net::ws_encode_frame(net::WsOpcode::kClose, net::ws_close_payload(1000, "bye"), true, kMask);
+
+    Frames expected = {{net::WsOpcode::kPing, "p"},
+                       {net::WsOpcode::kText, "hello world"},
+                       {net::WsOpcode::kBinary, big},
+                       {net::WsOpcode::kBinary, ""},
+                       {net::WsOpcode::kClose, net::ws_close_payload(1000, "bye")}};
+
+    // 逐字节喂入
+    {
+        net::WsDecoder decoder;
+        Frames frames;
+        for (char c : stream) {
+            ASSERT_TRUE(decoder.feed(std::string_view(&c, 1), collect(&frames)));
+        }
+        EXPECT_EQ(expected, frames);
+    }
+    // 随机切分
+    std::mt19937 rng(5);
+    for (int round = 0; round < 20; ++round) {
+        net::WsDecoder decoder;
+        Frames frames;
+        std::size_t pos = 0;
+        while (pos < stream.size()) {
+            std::size_t n = std::min<std::size_t>(stream.size() - pos, 1 + rng() % 3000);
+            ASSERT_TRUE(decoder.feed(std::string_view(stream).substr(pos, n), collect(&frames)));
+            pos += n;
+        }
+        EXPECT_EQ(expected, frames);
+    }
+}
+
+TEST(WsCodecTest, DecoderRejectsProtocolViolations) {
+    Frames frames;
+    {
+        net::WsDecoder decoder;  // 服务端要求客户端帧加掩码
+        EXPECT_FALSE(decoder.feed(net::ws_encode_frame(net::WsOpcode::kText, "x"), collect(&frames)));
+        EXPECT_EQ(net::ws_close::kProtocolError, decoder.close_code());
+    }
+    {
+        net::WsDecoder decoder(true, 1024);
+        EXPECT_FALSE(decoder.feed(net::ws_encode_frame(net::WsOpcode::kBinary, pattern(2000), true, kMask),
+                                  collect(&frames)));
+        EXPECT_EQ(net::ws_close::kMessageTooBig, decoder.close_code());
+    }
+    {
+        // 分片累计超过上限
+        net::WsDecoder decoder(true, 1024);
+        EXPECT_TRUE(decoder.feed(net::ws_encode_frame(net::WsOpcode::kBinary, pattern(800), false, kMask),
+                                 collect(&frames)));
+        EXPECT_FALSE(decoder.feed(net::ws_encode_frame(net::WsOpcode::kContinuation, pattern(800), true, kMask),
+                                  collect(&frames)));
+        EXPECT_EQ(net::ws_close::kMessageTooBig, decoder.close_code());
+    }
+    {
+        net::WsDecoder decoder;
+        EXPECT_FALSE(decoder.feed(net::ws_encode_frame(net::WsOpcode::kPing, pattern(126), true, kMask),
+                                  collect(&frames)));
+        EXPECT_EQ(net::ws_close::kProtocolError, decoder.close_code());
+    }
+    {
+        net::WsDecoder decoder;
+        EXPECT_FALSE(decoder.feed(net::ws_encode_frame(net::WsOpcode::kContinuation, "x", true, kMask),
+                                  collect(&frames)));
+    }
+    EXPECT_TRUE(frames.empty());
+}
+
+TEST(WsServerTest, HandshakeEchoPingAndClose) {
+    net::IoService io;
+    net::WsServer server(io, WS_PORT_ECHO);
+    std::atomic<int> opened{0};
+    server.set_connection_callback([&](const net::WsConnectionPtr& conn) {
+        ++opened;
+        conn->send_text("welcome");
+    });
+    server.set_message_callback([](const net::WsConnectionPtr& conn, std::string_view data) {
+        if (conn->message_opcode() == net::WsOpcode::kText) {
+            conn->send_text(data);
+        } else {
+            conn->send_binary(data);
+        }
+    });
+    server.start_accept();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    int fd = connect_local(WS_PORT_ECHO);
+    ASSERT_GE(fd, 0);
+    // 握手请求与第一帧在同一次写入中到达
+    std::string request = net::ws_client_handshake("127.0.0.1", "/", "dGhlIHNhbXBsZSBub25jZQ==");
+    write_str(fd, request + net::ws_encode_frame(net::WsOpcode::kText, "first", true, kMask));
+
+    std::string response;
+    char c;
+    while (response.find("\r\n\r\n") == std::string::npos && ::read(fd, &c, 1) == 1) {
+        response.push_back(c);
+    }
+    ASSERT_EQ(0u, response.find("HTTP/1.1 101"));
+    EXPECT_NE(std::string::npos, response.find("s3pPLMBiTxaQ9kYGzzhZRbK+xOo="));
+
+    net::WsDecoder decoder(false);
+    Frames frames = read_frames(fd, decoder, 2);
+    ASSERT_EQ(2u, frames.size());
+    EXPECT_EQ(std::make_pair(net::WsOpcode::kText, std::string("welcome")), frames[0]);
+    EXPECT_EQ(std::make_pair(net::WsOpcode::kText, std::string("first")), frames[1]);
+    EXPECT_EQ(1, opened.load());
+
+    // 分片的大二进制消息 + ping
+    const std::string big = pattern(100000);
+    write_str(fd, net::ws_encode_frame(net::WsOpcode::kBinary, std::string_view(big).substr(0, 40000), false, kMask) +
+                  net::ws_encode_frame(net::WsOpcode::kPing, "hb", true, kMask) +
+                  net::ws_encode_frame(net::WsOpcode::kContinuation, std::string_view(big).substr(40000), true, kMask));
+    frames = read_frames(fd, decoder, 2);
+    ASSERT_EQ(2u, frames.size());
+    EXPECT_EQ(std::make_pair(net::WsOpcode::kPong, std::string("hb")), frames[0]);
+    EXPECT_EQ(net::WsOpcode::kBinary, frames[1].first);
+    EXPECT_EQ(big, frames[1].second);
+
+    // 关闭握手：服务端回显关闭码后断开
+    write_str(fd, net::ws_encode_frame(net::WsOpcode::kClose, net::ws_close_payload(1001), true, kMask));
+    bool eof = false;
+    frames = read_frames(fd, decoder, 2, &eof);
+    ASSERT_EQ(1u, frames.size());
+    EXPECT_EQ(std::make_pair(net::WsOpcode::kClose, net::ws_close_payload(1001)), frames[0]);
+    EXPECT_TRUE(eof);
+    ::close(fd);
+
+    // 未加掩码的帧：以 1002 关闭
+    fd = connect_local(WS_PORT_ECHO);
+    ASSERT_GE(fd, 0);
+    write_str(fd, request + net::ws_encode_frame(net::WsOpcode::kText, "bad"));
+    net::WsDecoder decoder2(false);
+    response.clear();
+    while (response.find("\r\n\r\n") == std::string::npos && ::read(fd, &c, 1) == 1) {
+        response.push_back(c);
+    }
+    eof = false;
+    frames = read_frames(fd, decoder2, 3, &eof);
+    ASSERT_EQ(2u, frames.size());
+    EXPECT_EQ(std::make_pair(net::WsOpcode::kClose, net::ws_close_payload(net::ws_close::kProtocolError)),
+              frames[1]);
+    EXPECT_TRUE(eof);
+    ::close(fd);
+
+    server.stop();
+}
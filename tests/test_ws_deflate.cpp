@@ -0,0 +1,288 @@
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chwell/net/ws_codec.h"
+#include "chwell/net/ws_deflate.h"
+#include "chwell/net/ws_server.h"
+
+#include "test_net_helpers.h"
+
+using namespace chwell;
+using test::connect_local;
+
+namespace {
+
+constexpr unsigned short WS_PORT_DEFLATE = 19952;
+
+const std::uint8_t kMask[4] = {0x11, 0x22, 0x33, 0x44};
+
+// 典型的房间状态快照：重复字段多、可压缩
+std::string snapshot(int tick, int players) {
+    std::string json = "{\"tick\":" + std::to_string(tick) + ",\"players\":[";
+    for (int i = 0; i < players; ++i) {
+        if (i) json += ",";
+        json += "{\"id\":\"player_" + std::to_string(i) + "\",\"x\":" + std::to_string((tick + i * 7) % 500) +
+                ",\"y\":" + std::to_string((tick * 3 + i) % 500) + ",\"hp\":100,\"state\":\"moving\"}";
+    }
+    return json + "]}";
+}
+
+// 读到响应头结束，返回响应头；其后的字节留在 *rest
+std::string read_response(int fd, std::string* rest) {
+    std::string data;
+    char buf[4096];
+    std::size_t end;
+    while ((end = data.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n <= 0) return std::string();
+        data.append(buf, static_cast<std::size_t>(n));
+    }
+    *rest = data.substr(end + 4);
+    return data.substr(0, end + 4);
+}
+
+struct ClientMessage {
+    net::WsOpcode opcode;
+    bool compressed;
+    std::string wire;  // 线上载荷
+};
+
+// 客户端解帧：记录每条消息是否压缩
+std::vector<ClientMessage> read_messages(int fd, net::WsDecoder& decoder, std::string rest,
+                                         std::size_t count) {
+    std::vector<ClientMessage> out;
+    auto cb = [&](net::WsOpcode op, std::string_view payload) {
+        out.push_back({op, decoder.message_compressed(), std::string(payload)});
+    };
+    decoder.feed(rest, cb);
+    char buf[4096];
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(2000);
+    while (out.size() < count && std::chrono::steady_clock::now() < deadline) {
+        pollfd pfd{fd, POLLIN, 0};
+        if (poll(&pfd, 1, 50) <= 0) continue;
+        ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n <= 0) break;
+        decoder.feed(std::string_view(buf, static_cast<std::size_t>(n)), cb);
+    }
+    return out;
+}
+
+} // namespace
+
+TEST(WsDeflateTest, NegotiationPicksFirstAcceptableOffer) {
+    net::WsDeflateConfig config;
+    net::WsDeflateParams params;
+    EXPECT_FALSE(net::negotiate_ws_deflate("permessage-deflate", config, &params));  // 未启用
+
+    config.enabled = true;
+    if (!net::ws_deflate_available()) {
+        GTEST_SKIP() << "built without zlib";
+    }
+    // 未知参数、8 位窗口、重复参数的提议被跳过，选中第三个
+    ASSERT_TRUE(net::negotiate_ws_deflate(
+        "x-webkit-deflate-frame, permessage-deflate; foo=1, permessage-deflate; server_max_window_bits=8, "
+        "permessage-deflate; client_no_context_takeover; client_no_context_takeover, "
+        "permessage-deflate; server_max_window_bits=10; client_max_window_bits",
+        config, &params));
+    EXPECT_EQ(10, params.server_max_window_bits);
+    EXPECT_FALSE(params.server_no_context_takeover);
+    EXPECT_EQ("permessage-deflate; server_max_window_bits=10", net::format_ws_deflate_response(params));
+
+    ASSERT_TRUE(net::negotiate_ws_deflate(net::format_ws_deflate_offer(true), config, &params));
+    EXPECT_TRUE(params.client_no_context_takeover);
+    EXPECT_EQ(15, params.server_max_window_bits);
+
+    // 共享压缩上下文要求不保留滑动窗口
+    config.shared_context = true;
+    ASSERT_TRUE(net::negotiate_ws_deflate("permessage-deflate", config, &params));
+    EXPECT_EQ("permessage-deflate; server_no_context_takeover", net::format_ws_deflate_response(params));
+    EXPECT_FALSE(net::negotiate_ws_deflate("permessage-deflate; server_max_window_bits", config, &params));
+}
+
+TEST(WsDeflateTest, ContextTakeoverRoundTripAndLimits) {
+    if (!net::ws_deflate_available()) {
+        GTEST_SKIP() << "built without zlib";
+    }
+    net::WsDeflater takeover(3, 15, 8, false);
+    net::WsDeflater independent(3, 15, 8, true);
+    net::WsInflater inflater(15, false);
+    net::WsInflater independent_inflater(15, true);
+
+    std::string first, second, out;
+    std::vector<std::size_t> takeover_sizes, independent_sizes;
+    for (int tick = 0; tick < 5; ++tick) {
+        const std::string msg = snapshot(tick, 20);
+        ASSERT_TRUE(takeover.compress(msg, &first));
+        ASSERT_TRUE(independent.compress(msg, &second));
+        takeover_sizes.push_back(first.size());
+        independent_sizes.push_back(second.size());
+        ASSERT_EQ(0, inflater.decompress(first, &out, 1 << 20));
+        EXPECT_EQ(msg, out);
+        ASSERT_EQ(0, independent_inflater.decompress(second, &out, 1 << 20));
+        EXPECT_EQ(msg, out);
+        EXPECT_LT(second.size(), msg.size() / 3);
+    }
+    // 保留窗口时后续快照可引用上一帧，压缩后明显更小
+    EXPECT_LT(takeover_sizes.back() * 2, independent_sizes.back());
+
+    // 解压上限与损坏数据
+    net::WsInflater limited(15, true);
+    ASSERT_TRUE(independent.compress(std::string(100000, 'a'), &first));
+    EXPECT_EQ(-2, limited.decompress(first, &out, 1000));
+    EXPECT_EQ(-1, limited.decompress("\xff\xff\xff\xff", &out, 1000));
+    EXPECT_EQ(0, limited.decompress(second, &out, 1 << 20));
+}
+
+TEST(WsDeflateTest, PreparedMessageCompressesOnlyAboveThreshold) {
+    if (!net::ws_deflate_available()) {
+        GTEST_SKIP() << "built without zlib";
+    }
+    net::WsDeflateConfig config;
+    config.enabled = true;
+    config.min_size = 512;
+
+    net::WsPreparedMessage small = net::ws_prepare_message(net::WsOpcode::kText, snapshot(1, 1), config);
+    EXPECT_FALSE(small.plain.empty());
+    EXPECT_TRUE(small.deflated.empty());
+
+    const std::string msg = snapshot(1, 30);
+    net::WsPreparedMessage big = net::ws_prepare_message(net::WsOpcode::kText, msg, config);
+    ASSERT_FALSE(big.deflated.empty());
+    EXPECT_LT(big.deflated.size() * 3, big.plain.size());
+    EXPECT_EQ(0x80 | 0x40 | 0x1, static_cast<unsigned char>(big.deflated.data()[0]));
+
+    net::WsDecoder decoder(false);
+    decoder.set_allow_compressed(true);
+    std::string wire;
+    ASSERT_TRUE(decoder.feed(big.deflated.view(), [&](net::WsOpcode, std::string_view p) { wire.assign(p); }));
+    net::WsInflater inflater(15, false);
+    std::string out;
+    ASSERT_EQ(0, inflater.decompress(wire, &out, 1 << 20));
+    EXPECT_EQ(msg, out);
+
+    // 未协商时 RSV1 为协议错误
+    net::WsDecoder strict(false);
+    EXPECT_FALSE(strict.feed(big.deflated.view(), [](net::WsOpcode, std::string_view) {}));
+    EXPECT_EQ(net::ws_close::kProtocolError, strict.close_code());
+}
+
+TEST(WsDeflateTest, ServerNegotiatesCompressesAndBroadcastsOnce) {
+    if (!net::ws_deflate_available()) {
+        GTEST_SKIP() << "built without zlib";
+    }
+    net::IoService io;
+    net::WsServer server(io, WS_PORT_DEFLATE);
+    net::WsDeflateConfig config;
+    config.enabled = true;
+    config.min_size = 64;
+    server.set_deflate(config);
+
+    std::mutex mutex;
+    std::vector<net::WsConnectionPtr> conns;
+    server.set_connection_callback([&](const net::WsConnectionPtr& conn) {
+        std::lock_guard<std::mutex> lock(mutex);
+        conns.push_back(conn);
+    });
+    server.set_message_callback([](const net::WsConnectionPtr& conn, std::string_view data) {
+        conn->send_text(std::string("echo:") + std::string(data));
+    });
+    server.start_accept();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // 客户端 A 协商压缩（双方保留窗口），客户端 B 不协商
+    int a = connect_local(WS_PORT_DEFLATE);
+    int b = connect_local(WS_PORT_DEFLATE);
+    ASSERT_GE(a, 0);
+    ASSERT_GE(b, 0);
+    std::string req_a = net::ws_client_handshake("127.0.0.1", "/", "dGhlIHNhbXBsZSBub25jZQ==",
+                                                 net::format_ws_deflate_offer());
+    std::string req_b = net::ws_client_handshake("127.0.0.1", "/", "dGhlIHNhbXBsZSBub25jZQ==");
+    ASSERT_EQ(static_cast<ssize_t>(req_a.size()), ::write(a, req_a.data(), req_a.size()));
+    std::string rest_a, rest_b;
+    std::string resp_a = read_response(a, &rest_a);
+    EXPECT_NE(std::string::npos, resp_a.find("Sec-WebSocket-Extensions: permessage-deflate\r\n"));
+    ASSERT_EQ(static_cast<ssize_t>(req_b.size()), ::write(b, req_b.data(), req_b.size()));
+    std::string resp_b = read_response(b, &rest_b);
+    EXPECT_EQ(std::string::npos, resp_b.find("Sec-WebSocket-Extensions"));
+
+    // A 发送压缩消息，服务端解压后交给回调，回显同样压缩
+    net::WsDeflater client_deflater(3, 15, 8, false);
+    net::WsInflater client_inflater(15, false);
+    const std::string msg = snapshot(7, 10);
+    std::string compressed;
+    ASSERT_TRUE(client_deflater.compress(msg, &compressed));
+    char header[net::kWsMaxHeaderSize];
+    std::size_t header_len = net::ws_encode_header(header, net::WsOpcode::kText, compressed.size(), true, kMask, true);
+    std::string frame(header, header_len);
+    std::size_t offset = frame.size();
+    frame.resize(offset + compressed.size());
+    net::ws_mask_copy(&frame[offset], compressed.data(), compressed.size(), kMask);
+    ASSERT_EQ(static_cast<ssize_t>(frame.size()), ::write(a, frame.data(), frame.size()));
+
+    net::WsDecoder decoder_a(false);
+    decoder_a.set_allow_compressed(true);
+    std::vector<ClientMessage> got = read_messages(a, decoder_a, rest_a, 1);
+    ASSERT_EQ(1u, got.size());
+    EXPECT_TRUE(got[0].compressed);
+    EXPECT_LT(got[0].wire.size(), msg.size());
+    std::string plain;
+    ASSERT_EQ(0, client_inflater.decompress(got[0].wire, &plain, 1 << 20));
+    EXPECT_EQ("echo:" + msg, plain);
+
+    // 广播：压缩一次，A 收压缩帧、B 收原文帧；之后 A 的常规消息在窗口重置后仍可正确解压
+    ASSERT_TRUE([&]() {
+        for (int i = 0; i < 100; ++i) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (conns.size() == 2) return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    }());
+    const std::string state = snapshot(8, 40);
+    net::WsPreparedMessage prepared = net::ws_prepare_message(net::WsOpcode::kText, state, config);
+    ASSERT_FALSE(prepared.deflated.empty());
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        net::ws_broadcast(conns, prepared);
+        for (const auto& conn : conns) {
+            if (conn->deflate_enabled()) {
+                conn->send_text(snapshot(9, 10));
+            }
+        }
+    }
+
+    got = read_messages(a, decoder_a, std::string(), 2);
+    ASSERT_EQ(2u, got.size());
+    EXPECT_TRUE(got[0].compressed);
+    // A 收到的正是预编码帧的载荷（未重新压缩）
+    ASSERT_LT(got[0].wire.size(), prepared.deflated.size());
+    EXPECT_EQ(prepared.deflated.view().substr(prepared.deflated.size() - got[0].wire.size()), got[0].wire);
+    ASSERT_EQ(0, client_inflater.decompress(got[0].wire, &plain, 1 << 20));
+    EXPECT_EQ(state, plain);
+    ASSERT_EQ(0, client_inflater.decompress(got[1].wire, &plain, 1 << 20));
+    EXPECT_EQ(snapshot(9, 10), plain);
+
+    net::WsDecoder decoder_b(false);
+    got = read_messages(b, decoder_b, rest_b, 1);
+    ASSERT_EQ(1u, got.size());
+    EXPECT_FALSE(got[0].compressed);
+    EXPECT_EQ(state, got[0].wire);
+
+    ::close(a);
+    ::close(b);
+    server.stop();
+}